@@ -257,6 +257,23 @@ static struct bitmap4 pxy_bitmap_readdir = {
 	.bitmap4_len = 1
 };
 
+/* Everything GETATTR asks for, and the handle, so readdir_plus can hand
+ * out objects without a lookup */
+static struct bitmap4 pxy_bitmap_readdir_plus = {
+	.map[0] =
+	    (PXY_ATTR_BIT(FATTR4_TYPE) | PXY_ATTR_BIT(FATTR4_CHANGE) |
+	     PXY_ATTR_BIT(FATTR4_SIZE) | PXY_ATTR_BIT(FATTR4_FSID) |
+	     PXY_ATTR_BIT(FATTR4_FILEHANDLE) | PXY_ATTR_BIT(FATTR4_FILEID)),
+	.map[1] =
+	    (PXY_ATTR_BIT2(FATTR4_MODE) | PXY_ATTR_BIT2(FATTR4_NUMLINKS) |
+	     PXY_ATTR_BIT2(FATTR4_OWNER) | PXY_ATTR_BIT2(FATTR4_OWNER_GROUP) |
+	     PXY_ATTR_BIT2(FATTR4_SPACE_USED) |
+	     PXY_ATTR_BIT2(FATTR4_TIME_ACCESS) |
+	     PXY_ATTR_BIT2(FATTR4_TIME_METADATA) |
+	     PXY_ATTR_BIT2(FATTR4_TIME_MODIFY) | PXY_ATTR_BIT2(FATTR4_RAWDEV)),
+	.bitmap4_len = 2
+};
+
 static struct bitmap4 pxy_bitmap_fsinfo = {
 	.map[0] =
 	    (PXY_ATTR_BIT(FATTR4_FILES_AVAIL) | PXY_ATTR_BIT(FATTR4_FILES_FREE)
@@ -1614,6 +1631,108 @@ static fsal_status_t pxy_readdir(struct fsal_obj_handle *dir_hdl,
 	return fsalstat(ERR_FSAL_NO_ERROR, 0);
 }
 
+/*
+ * One READDIR asking for the handle and attributes of each entry, so
+ * a whole batch of objects costs a single round trip.
+ */
+static fsal_status_t pxy_do_readdir_plus(struct pxy_obj_handle *ph,
+					 nfs_cookie4 *cookie,
+					 fsal_readdir_plus_cb cb,
+					 void *cbarg, bool *eof, bool *more)
+{
+	uint32_t opcnt = 0;
+	int rc;
+	entry4 *e4;
+	nfs_argop4 argoparray[FSAL_READDIR_NB_OP_ALLOC];
+	nfs_resop4 resoparray[FSAL_READDIR_NB_OP_ALLOC];
+	READDIR4resok *rdok;
+	fsal_status_t st = { ERR_FSAL_NO_ERROR, 0 };
+
+	COMPOUNDV4_ARG_ADD_OP_PUTFH(opcnt, argoparray, ph->fh4);
+	rdok = &resoparray[opcnt].nfs_resop4_u.opreaddir.READDIR4res_u.resok4;
+	rdok->reply.entries = NULL;
+	COMPOUNDV4_ARG_ADD_OP_READDIR(opcnt, argoparray, *cookie,
+				      pxy_bitmap_readdir_plus);
+
+	rc = pxy_nfsv4_call(ph->obj.export, op_ctx->creds, opcnt, argoparray,
+			    resoparray);
+	if (rc != NFS4_OK)
+		return nfsstat4_to_fsal(rc);
+
+	for (e4 = rdok->reply.entries; e4; e4 = e4->nextentry) {
+		struct attrlist attr;
+		char name[MAXNAMLEN + 1];
+		char padfilehandle[NFS4_FHSIZE];
+		nfs_fh4 fh4 = { .nfs_fh4_len = 0,
+				.nfs_fh4_val = padfilehandle };
+		struct fsal_obj_handle *obj = NULL;
+		struct pxy_obj_handle *pxy_hdl;
+		fsal_status_t status = { ERR_FSAL_NO_ERROR, 0 };
+
+		/* UTF8 name does not include trailing 0 */
+		if (e4->name.utf8string_len > sizeof(name) - 1) {
+			st = fsalstat(ERR_FSAL_SERVERFAULT, E2BIG);
+			*more = false;
+			break;
+		}
+		memcpy(name, e4->name.utf8string_val, e4->name.utf8string_len);
+		name[e4->name.utf8string_len] = '\0';
+
+		if (nfs4_Fattr_To_FSAL_attr_fh(&attr, &e4->attrs, &fh4) !=
+		    NFS4_OK) {
+			status = fsalstat(ERR_FSAL_FAULT, 0);
+		} else if (fh4.nfs_fh4_len == 0) {
+			/* The server didn't give us the handle */
+			status = pxy_lookup(&ph->obj, name, &obj);
+		} else {
+			pxy_hdl = pxy_alloc_handle(op_ctx->fsal_export, &fh4,
+						   &attr);
+			if (pxy_hdl != NULL)
+				obj = &pxy_hdl->obj;
+			else
+				status = fsalstat(ERR_FSAL_FAULT, 0);
+		}
+
+		*cookie = e4->cookie;
+
+		if (!cb(name, obj, status, cbarg, e4->cookie)) {
+			*more = false;
+			break;
+		}
+	}
+
+	/* Only at the end if every entry was taken */
+	if (*more)
+		*eof = rdok->reply.eof;
+
+	xdr_free((xdrproc_t) xdr_readdirres, resoparray);
+	return st;
+}
+
+static fsal_status_t pxy_readdir_plus(struct fsal_obj_handle *dir_hdl,
+				      fsal_cookie_t *whence, void *cbarg,
+				      fsal_readdir_plus_cb cb, bool *eof)
+{
+	nfs_cookie4 cookie = 0;
+	struct pxy_obj_handle *ph;
+	bool more = true;
+
+	if (whence)
+		cookie = (nfs_cookie4) *whence;
+
+	ph = container_of(dir_hdl, struct pxy_obj_handle, obj);
+
+	do {
+		fsal_status_t st;
+
+		st = pxy_do_readdir_plus(ph, &cookie, cb, cbarg, eof, &more);
+		if (FSAL_IS_ERROR(st))
+			return st;
+	} while (more && *eof == false);
+
+	return fsalstat(ERR_FSAL_NO_ERROR, 0);
+}
+
 static fsal_status_t pxy_rename(struct fsal_obj_handle *olddir_hdl,
 				const char *old_name,
 				struct fsal_obj_handle *newdir_hdl,
@@ -1983,6 +2102,7 @@ void pxy_handle_ops_init(struct fsal_obj_ops *ops)
 	ops->release = pxy_hdl_release;
 	ops->lookup = pxy_lookup;
 	ops->readdir = pxy_readdir;
+	ops->readdir_plus = pxy_readdir_plus;
 	ops->create = pxy_create;
 	ops->mkdir = pxy_mkdir;
 	ops->mknode = pxy_mknod;
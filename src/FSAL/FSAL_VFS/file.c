@@ -38,8 +38,14 @@
 #include "fsal_convert.h"
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#ifdef LINUX
+#include <linux/fs.h>
+#endif
 #include "FSAL/fsal_commonlib.h"
 #include "vfs_methods.h"
+#include "fridgethr.h"
 
 /** vfs_open
  * called with appropriate locks taken at the cache inode level
@@ -195,9 +201,218 @@ fsal_status_t vfs_write(struct fsal_obj_handle *obj_hdl,
 	return fsalstat(fsal_error, retval);
 }
 
+/* Asynchronous I/O
+ *
+ * When the VFS block sets async_io_threads, read2 and write2 hand the
+ * I/O to a fridge of threads and return at once.  Each request
+ * carries its own dup of the descriptor, since cache_inode may close
+ * or reopen the handle's descriptor as soon as read2 or write2
+ * returns.  Without the fridge the I/O is done in line.
+ */
+
+static struct fridgethr *vfs_async_fridge;
+
+struct vfs_async_io {
+	struct fsal_obj_handle *obj_hdl;
+	struct fsal_io_arg *io_arg;
+	fsal_async_cb done_cb;
+	void *caller_arg;
+	struct user_cred creds;	/*< Caller's credentials, for writes */
+	int fd;			/*< Private descriptor, closed when done */
+	bool write;
+};
+
+/**
+ * @brief Perform an asynchronous request and complete it
+ *
+ * @param[in] job The request, freed on return
+ */
+
+static void vfs_async_io_do(struct vfs_async_io *job)
+{
+	struct fsal_io_arg *arg = job->io_arg;
+	fsal_errors_t fsal_error = ERR_FSAL_NO_ERROR;
+	int retval = 0;
+	ssize_t n;
+
+	if (job->write) {
+		fsal_set_credentials(&job->creds);
+		n = pwritev(job->fd, arg->iov, arg->iov_count, arg->offset);
+		if (n >= 0 && arg->fsal_stable && fsync(job->fd) == -1)
+			n = -1;
+		fsal_restore_ganesha_credentials();
+	} else {
+		n = preadv(job->fd, arg->iov, arg->iov_count, arg->offset);
+	}
+
+	if (n == -1) {
+		retval = errno;
+		fsal_error = posix2fsal_error(retval);
+		arg->io_amount = 0;
+	} else {
+		arg->io_amount = n;
+		/* dual eof condition, as in vfs_read */
+		if (!job->write)
+			arg->end_of_file = n == 0 ||
+			    arg->offset + n >=
+			    job->obj_hdl->attributes.filesize;
+	}
+
+	close(job->fd);
+	job->done_cb(job->obj_hdl, fsalstat(fsal_error, retval), arg,
+		     job->caller_arg);
+	gsh_free(job);
+}
+
+static void vfs_async_io_run(struct fridgethr_context *ctx)
+{
+	vfs_async_io_do(ctx->arg);
+}
+
+/**
+ * @brief Start a read2 or write2 request
+ *
+ * @param[in] obj_hdl    File
+ * @param[in] io_arg     Position and buffers
+ * @param[in] done_cb    Completion callback
+ * @param[in] caller_arg Passed to done_cb
+ * @param[in] write      Whether this is a write
+ */
+
+static void vfs_async_io_start(struct fsal_obj_handle *obj_hdl,
+			       struct fsal_io_arg *io_arg,
+			       fsal_async_cb done_cb, void *caller_arg,
+			       bool write)
+{
+	struct vfs_fsal_obj_handle *myself;
+	struct vfs_async_io *job;
+	int retval;
+
+	myself = container_of(obj_hdl, struct vfs_fsal_obj_handle, obj_handle);
+
+	if (obj_hdl->fsal != obj_hdl->fs->fsal) {
+		LogDebug(COMPONENT_FSAL,
+			 "FSAL %s operation for handle belonging to FSAL %s, return EXDEV",
+			 obj_hdl->fsal->name, obj_hdl->fs->fsal->name);
+		retval = EXDEV;
+		done_cb(obj_hdl, fsalstat(posix2fsal_error(retval), retval),
+			io_arg, caller_arg);
+		return;
+	}
+
+	assert(myself->u.file.fd >= 0
+	       && myself->u.file.openflags != FSAL_O_CLOSED);
+
+	job = gsh_malloc(sizeof(*job));
+	if (job == NULL) {
+		done_cb(obj_hdl, fsalstat(ERR_FSAL_NOMEM, ENOMEM),
+			io_arg, caller_arg);
+		return;
+	}
+
+	job->fd = dup(myself->u.file.fd);
+	if (job->fd == -1) {
+		retval = errno;
+		gsh_free(job);
+		done_cb(obj_hdl, fsalstat(posix2fsal_error(retval), retval),
+			io_arg, caller_arg);
+		return;
+	}
+
+	job->obj_hdl = obj_hdl;
+	job->io_arg = io_arg;
+	job->done_cb = done_cb;
+	job->caller_arg = caller_arg;
+	job->write = write;
+	if (write)
+		job->creds = *op_ctx->creds;
+
+	if (vfs_async_fridge == NULL
+	    || fridgethr_submit(vfs_async_fridge, vfs_async_io_run, job) != 0)
+		vfs_async_io_do(job);
+}
+
+/* vfs_read2
+ * read, completing on an async I/O thread when there are any
+ */
+
+void vfs_read2(struct fsal_obj_handle *obj_hdl,
+	       struct fsal_io_arg *read_arg,
+	       fsal_async_cb done_cb,
+	       void *caller_arg)
+{
+	vfs_async_io_start(obj_hdl, read_arg, done_cb, caller_arg, false);
+}
+
+/* vfs_write2
+ * write, completing on an async I/O thread when there are any
+ */
+
+void vfs_write2(struct fsal_obj_handle *obj_hdl,
+		struct fsal_io_arg *write_arg,
+		fsal_async_cb done_cb,
+		void *caller_arg)
+{
+	vfs_async_io_start(obj_hdl, write_arg, done_cb, caller_arg, true);
+}
+
+/**
+ * @brief Start the async I/O threads
+ *
+ * @param[in] threads Most threads doing I/O at once
+ *
+ * @return 0 on success, POSIX errors on failure.
+ */
+
+int vfs_async_init(uint32_t threads)
+{
+	struct fridgethr_params frp;
+	int rc;
+
+	if (vfs_async_fridge != NULL || threads == 0)
+		return 0;
+
+	memset(&frp, 0, sizeof(struct fridgethr_params));
+	frp.thr_max = threads;
+	frp.deferment = fridgethr_defer_queue;
+	rc = fridgethr_init(&vfs_async_fridge, "VFS_Async_IO", &frp);
+	if (rc != 0)
+		LogMajor(COMPONENT_FSAL,
+			 "Unable to initialize VFS async I/O fridge: %d", rc);
+	return rc;
+}
+
+/**
+ * @brief Stop the async I/O threads
+ */
+
+void vfs_async_shutdown(void)
+{
+	int rc;
+
+	if (vfs_async_fridge == NULL)
+		return;
+
+	rc = fridgethr_sync_command(vfs_async_fridge, fridgethr_comm_stop,
+				    120);
+	if (rc == ETIMEDOUT) {
+		LogMajor(COMPONENT_FSAL,
+			 "Shutdown timed out, cancelling threads.");
+		fridgethr_cancel(vfs_async_fridge);
+	} else if (rc != 0) {
+		LogMajor(COMPONENT_FSAL,
+			 "Failed shutting down VFS async I/O threads: %d",
+			 rc);
+	}
+}
+
 /* vfs_commit
  * Commit a file range to storage.
- * for right now, fsync will have to do.
+ * The range is written back and waited on first, but that alone is
+ * not durable: fdatasync still writes back every dirty page of the
+ * whole file, not just the range, before flushing the device cache.
+ * The saving comes from cache_inode merging commits into one call
+ * per file, not from the range.  A len of 0 means to end of file.
  */
 
 fsal_status_t vfs_commit(struct fsal_obj_handle *obj_hdl,	/* sync */
@@ -221,7 +436,15 @@ fsal_status_t vfs_commit(struct fsal_obj_handle *obj_hdl,	/* sync */
 	assert(myself->u.file.fd >= 0
 	       && myself->u.file.openflags != FSAL_O_CLOSED);
 
-	retval = fsync(myself->u.file.fd);
+#ifdef LINUX
+	/* Errors are left for fdatasync to report */
+	(void)sync_file_range(myself->u.file.fd, offset, len,
+			      SYNC_FILE_RANGE_WAIT_BEFORE |
+			      SYNC_FILE_RANGE_WRITE |
+			      SYNC_FILE_RANGE_WAIT_AFTER);
+#endif
+
+	retval = fdatasync(myself->u.file.fd);
 	if (retval == -1) {
 		retval = errno;
 		fsal_error = posix2fsal_error(retval);
@@ -229,6 +452,156 @@ fsal_status_t vfs_commit(struct fsal_obj_handle *obj_hdl,	/* sync */
 	return fsalstat(fsal_error, retval);
 }
 
+/**
+ * @brief Check that both ends of a copy or clone are open VFS files
+ *
+ * @param[in] src_hdl Source handle
+ * @param[in] dst_hdl Destination handle
+ *
+ * @return 0 or EXDEV.
+ */
+
+static int vfs_check_copy_hdls(struct fsal_obj_handle *src_hdl,
+			       struct fsal_obj_handle *dst_hdl)
+{
+	struct vfs_fsal_obj_handle *src, *dst;
+
+	if (src_hdl->fsal != src_hdl->fs->fsal
+	    || dst_hdl->fsal != dst_hdl->fs->fsal
+	    || src_hdl->fsal != dst_hdl->fsal) {
+		LogDebug(COMPONENT_FSAL,
+			 "FSAL %s copy from handle belonging to FSAL %s to FSAL %s, return EXDEV",
+			 src_hdl->fsal->name, src_hdl->fs->fsal->name,
+			 dst_hdl->fs->fsal->name);
+		return EXDEV;
+	}
+
+	src = container_of(src_hdl, struct vfs_fsal_obj_handle, obj_handle);
+	dst = container_of(dst_hdl, struct vfs_fsal_obj_handle, obj_handle);
+
+	assert(src->u.file.fd >= 0
+	       && src->u.file.openflags != FSAL_O_CLOSED);
+	assert(dst->u.file.fd >= 0
+	       && dst->u.file.openflags != FSAL_O_CLOSED);
+
+	return 0;
+}
+
+/* Largest range handed to the kernel in one copy_file_range() */
+#define VFS_COPY_MAX (1024 * 1024 * 1024)
+
+static inline size_t vfs_copy_len(uint64_t remaining)
+{
+	return remaining > VFS_COPY_MAX ? VFS_COPY_MAX : remaining;
+}
+
+/* vfs_copy
+ * Copy a range between files with copy_file_range(), which lets the
+ * kernel and the filesystem below do the work.  Anything it refuses
+ * is left to the caller's read/write loop.
+ */
+
+fsal_status_t vfs_copy(struct fsal_obj_handle *src_hdl,
+		       uint64_t src_offset,
+		       struct fsal_obj_handle *dst_hdl,
+		       uint64_t dst_offset,
+		       uint64_t count,
+		       uint64_t *copied)
+{
+	int retval;
+
+	*copied = 0;
+
+	retval = vfs_check_copy_hdls(src_hdl, dst_hdl);
+	if (retval != 0)
+		return fsalstat(posix2fsal_error(retval), retval);
+
+#ifdef __NR_copy_file_range
+	{
+		struct vfs_fsal_obj_handle *src, *dst;
+		loff_t src_off = src_offset;
+		loff_t dst_off = dst_offset;
+		ssize_t nb_copied;
+
+		src = container_of(src_hdl, struct vfs_fsal_obj_handle,
+				   obj_handle);
+		dst = container_of(dst_hdl, struct vfs_fsal_obj_handle,
+				   obj_handle);
+
+		while (*copied < count) {
+			nb_copied = syscall(__NR_copy_file_range,
+					    src->u.file.fd, &src_off,
+					    dst->u.file.fd, &dst_off,
+					    vfs_copy_len(count - *copied),
+					    0);
+			if (nb_copied == 0)
+				break;	/* end of the source */
+			if (nb_copied > 0) {
+				*copied += nb_copied;
+				continue;
+			}
+			retval = errno;
+			if (retval == EINTR)
+				continue;
+			if (*copied != 0)
+				break;	/* report what was done */
+			if (retval == ENOSYS || retval == EXDEV
+			    || retval == EOPNOTSUPP || retval == EINVAL)
+				return fsalstat(ERR_FSAL_NOTSUPP, retval);
+			return fsalstat(posix2fsal_error(retval), retval);
+		}
+		return fsalstat(ERR_FSAL_NO_ERROR, 0);
+	}
+#else
+	return fsalstat(ERR_FSAL_NOTSUPP, 0);
+#endif
+}
+
+/* vfs_clone
+ * Share a range between files with the FICLONERANGE ioctl, for
+ * filesystems with reflinks.
+ */
+
+fsal_status_t vfs_clone(struct fsal_obj_handle *src_hdl,
+			uint64_t src_offset,
+			struct fsal_obj_handle *dst_hdl,
+			uint64_t dst_offset,
+			uint64_t count)
+{
+	int retval;
+
+	retval = vfs_check_copy_hdls(src_hdl, dst_hdl);
+	if (retval != 0)
+		return fsalstat(posix2fsal_error(retval), retval);
+
+#ifdef FICLONERANGE
+	{
+		struct vfs_fsal_obj_handle *src, *dst;
+		struct file_clone_range range = {
+			.src_offset = src_offset,
+			.src_length = count,
+			.dest_offset = dst_offset,
+		};
+
+		src = container_of(src_hdl, struct vfs_fsal_obj_handle,
+				   obj_handle);
+		dst = container_of(dst_hdl, struct vfs_fsal_obj_handle,
+				   obj_handle);
+		range.src_fd = src->u.file.fd;
+
+		if (ioctl(dst->u.file.fd, FICLONERANGE, &range) == 0)
+			return fsalstat(ERR_FSAL_NO_ERROR, 0);
+
+		retval = errno;
+		if (retval == ENOTTY || retval == EOPNOTSUPP)
+			return fsalstat(ERR_FSAL_NOTSUPP, retval);
+		return fsalstat(posix2fsal_error(retval), retval);
+	}
+#else
+	return fsalstat(ERR_FSAL_NOTSUPP, 0);
+#endif
+}
+
 /* vfs_lock_op
  * lock a region of the file
  * throw an error if the fd is not open.  The old fsal didn't
@@ -85,6 +85,7 @@ static struct vfs_fsal_obj_handle *alloc_handle(int dirfd,
 	hdl->dev = posix2fsal_devt(stat->st_dev);
 	hdl->up_ops = exp_hdl->up_ops;
 	hdl->obj_handle.fs = fs;
+	vfs_path_fd_init_handle(hdl);
 
 	if (hdl->obj_handle.type == REGULAR_FILE) {
 		hdl->u.file.fd = -1;	/* no open on this yet */
@@ -154,54 +155,29 @@ static struct vfs_fsal_obj_handle *alloc_handle(int dirfd,
 /* handle methods
  */
 
-/* lookup
- * deprecated NULL parent && NULL path implies root handle
+/* lookup_at
+ * look up path in parent, open as dirfd
  */
 
-static fsal_status_t lookup(struct fsal_obj_handle *parent,
-			    const char *path, struct fsal_obj_handle **handle)
+static fsal_status_t lookup_at(struct vfs_fsal_obj_handle *parent_hdl,
+			       int dirfd, const char *path,
+			       struct fsal_obj_handle **handle)
 {
-	struct vfs_fsal_obj_handle *parent_hdl, *hdl;
-	fsal_errors_t fsal_error = ERR_FSAL_NO_ERROR;
-	int retval, dirfd;
+	struct fsal_obj_handle *parent = &parent_hdl->obj_handle;
+	struct vfs_fsal_obj_handle *hdl;
+	int retval;
 	struct stat stat;
 	vfs_file_handle_t *fh = NULL;
 	vfs_alloc_handle(fh);
 	fsal_dev_t dev;
-	struct fsal_filesystem *fs;
+	struct fsal_filesystem *fs = parent->fs;
 	bool xfsal = false;
 
-	*handle = NULL;		/* poison it first */
-	parent_hdl =
-	    container_of(parent, struct vfs_fsal_obj_handle, obj_handle);
-	if (!parent->obj_ops.handle_is(parent, DIRECTORY)) {
-		LogCrit(COMPONENT_FSAL,
-			"Parent handle is not a directory. hdl = 0x%p", parent);
-		return fsalstat(ERR_FSAL_NOTDIR, 0);
-	}
-
-	if (parent->fsal != parent->fs->fsal) {
-		LogDebug(COMPONENT_FSAL,
-			 "FSAL %s operation for handle belonging to FSAL %s, return EXDEV",
-			 parent->fsal->name,
-			 parent->fs->fsal != NULL
-				? parent->fs->fsal->name
-				: "(none)");
-		retval = EXDEV;
-		goto hdlerr;
-	}
-
-	fs = parent->fs;
-	dirfd = vfs_fsal_open(parent_hdl, O_PATH | O_NOACCESS, &fsal_error);
-
-	if (dirfd < 0)
-		return fsalstat(fsal_error, -dirfd);
-
 	retval = fstatat(dirfd, path, &stat, AT_SYMLINK_NOFOLLOW);
 
 	if (retval < 0) {
 		retval = errno;
-		goto direrr;
+		goto err;
 	}
 
 	dev = posix2fsal_devt(stat.st_dev);
@@ -216,7 +192,7 @@ static fsal_status_t lookup(struct fsal_obj_handle *parent,
 				 "unknown file system dev=%"PRIu64".%"PRIu64,
 				 path, dev.major, dev.minor);
 			retval = EXDEV;
-			goto direrr;
+			goto err;
 		}
 
 		if (fs->fsal != parent->fsal) {
@@ -261,32 +237,70 @@ static fsal_status_t lookup(struct fsal_obj_handle *parent,
 
 			if (retval < 0) {
 				retval = errno;
-				goto direrr;
+				goto err;
 			}
 
 			retval = 0;
 		} else {
 			/* Some other error */
-			goto direrr;
+			goto err;
 		}
 	}
 
 	/* allocate an obj_handle and fill it up */
 	hdl = alloc_handle(dirfd, fh, fs, &stat, parent_hdl->handle, path,
 			   op_ctx->fsal_export);
-	close(dirfd);
 	if (hdl == NULL) {
 		retval = ENOMEM;
-		goto hdlerr;
+		goto err;
 	}
 	*handle = &hdl->obj_handle;
 	return fsalstat(ERR_FSAL_NO_ERROR, 0);
 
- direrr:
-	close(dirfd);
- hdlerr:
-	fsal_error = posix2fsal_error(retval);
-	return fsalstat(fsal_error, retval);
+ err:
+	return fsalstat(posix2fsal_error(retval), retval);
+}
+
+/* lookup
+ * deprecated NULL parent && NULL path implies root handle
+ */
+
+static fsal_status_t lookup(struct fsal_obj_handle *parent,
+			    const char *path, struct fsal_obj_handle **handle)
+{
+	struct vfs_fsal_obj_handle *parent_hdl;
+	fsal_errors_t fsal_error = ERR_FSAL_NO_ERROR;
+	fsal_status_t status;
+	int dirfd;
+
+	*handle = NULL;		/* poison it first */
+	parent_hdl =
+	    container_of(parent, struct vfs_fsal_obj_handle, obj_handle);
+	if (!parent->obj_ops.handle_is(parent, DIRECTORY)) {
+		LogCrit(COMPONENT_FSAL,
+			"Parent handle is not a directory. hdl = 0x%p", parent);
+		return fsalstat(ERR_FSAL_NOTDIR, 0);
+	}
+
+	if (parent->fsal != parent->fs->fsal) {
+		LogDebug(COMPONENT_FSAL,
+			 "FSAL %s operation for handle belonging to FSAL %s, return EXDEV",
+			 parent->fsal->name,
+			 parent->fs->fsal != NULL
+				? parent->fs->fsal->name
+				: "(none)");
+		return fsalstat(posix2fsal_error(EXDEV), EXDEV);
+	}
+
+	dirfd = vfs_path_fd_get(parent_hdl, &fsal_error);
+
+	if (dirfd < 0)
+		return fsalstat(fsal_error, -dirfd);
+
+	status = lookup_at(parent_hdl, dirfd, path, handle);
+	vfs_path_fd_put(parent_hdl, dirfd);
+
+	return status;
 }
 
 /* make_file_safe
@@ -381,7 +395,7 @@ static fsal_status_t create(struct fsal_obj_handle *dir_hdl,
 	}
 	unix_mode = fsal2unix_mode(attrib->mode)
 	    & ~op_ctx->fsal_export->exp_ops.fs_umask(op_ctx->fsal_export);
-	dir_fd = vfs_fsal_open(myself, flags, &fsal_error);
+	dir_fd = vfs_path_fd_get(myself, &fsal_error);
 	if (dir_fd < 0)
 		return fsalstat(fsal_error, -dir_fd);
 	retval = vfs_stat_by_handle(dir_fd, myself->handle, &stat, flags);
@@ -418,7 +432,7 @@ static fsal_status_t create(struct fsal_obj_handle *dir_hdl,
 		goto fileerr;
 	}
 	*handle = &hdl->obj_handle;
-	close(dir_fd);
+	vfs_path_fd_put(myself, dir_fd);
 	close(fd);
 	return fsalstat(ERR_FSAL_NO_ERROR, 0);
 
@@ -426,7 +440,7 @@ static fsal_status_t create(struct fsal_obj_handle *dir_hdl,
 	close(fd);
 	unlinkat(dir_fd, name, 0);
  direrr:
-	close(dir_fd);
+	vfs_path_fd_put(myself, dir_fd);
  hdlerr:
 	fsal_error = posix2fsal_error(retval);
 	return fsalstat(fsal_error, retval);
@@ -468,7 +482,7 @@ static fsal_status_t makedir(struct fsal_obj_handle *dir_hdl,
 	}
 	unix_mode = fsal2unix_mode(attrib->mode)
 	    & ~op_ctx->fsal_export->exp_ops.fs_umask(op_ctx->fsal_export);
-	dir_fd = vfs_fsal_open(myself, flags, &fsal_error);
+	dir_fd = vfs_path_fd_get(myself, &fsal_error);
 	if (dir_fd < 0)
 		return fsalstat(fsal_error, -dir_fd);
 	retval = vfs_stat_by_handle(dir_fd, myself->handle, &stat, flags);
@@ -507,13 +521,13 @@ static fsal_status_t makedir(struct fsal_obj_handle *dir_hdl,
 	}
 	*handle = &hdl->obj_handle;
 
-	close(dir_fd);
+	vfs_path_fd_put(myself, dir_fd);
 	return fsalstat(ERR_FSAL_NO_ERROR, 0);
 
  fileerr:
 	unlinkat(dir_fd, name, 0);
  direrr:
-	close(dir_fd);
+	vfs_path_fd_put(myself, dir_fd);
  hdlerr:
 	fsal_error = posix2fsal_error(retval);
 	return fsalstat(fsal_error, retval);
@@ -585,7 +599,7 @@ static fsal_status_t makenode(struct fsal_obj_handle *dir_hdl,
 		fsal_error = ERR_FSAL_INVAL;
 		goto errout;
 	}
-	dir_fd = vfs_fsal_open(myself, flags, &fsal_error);
+	dir_fd = vfs_path_fd_get(myself, &fsal_error);
 	if (dir_fd < 0)
 		goto errout;
 	retval = vfs_stat_by_handle(dir_fd, myself->handle, &stat, flags);
@@ -605,7 +619,7 @@ static fsal_status_t makenode(struct fsal_obj_handle *dir_hdl,
 	retval = make_file_safe(myself, op_ctx, dir_fd, name,
 				unix_mode, user, group, &hdl);
 	if (!retval) {
-		close(dir_fd);	/* done with parent */
+		vfs_path_fd_put(myself, dir_fd);	/* done with parent */
 		*handle = &hdl->obj_handle;
 		return fsalstat(ERR_FSAL_NO_ERROR, 0);
 	}
@@ -613,7 +627,7 @@ static fsal_status_t makenode(struct fsal_obj_handle *dir_hdl,
 	unlinkat(dir_fd, name, 0);
 
  direrr:
-	close(dir_fd);		/* done with parent */
+	vfs_path_fd_put(myself, dir_fd);		/* done with parent */
 
  hdlerr:
 	fsal_error = posix2fsal_error(retval);
@@ -661,7 +675,7 @@ static fsal_status_t makesymlink(struct fsal_obj_handle *dir_hdl,
 		retval = EXDEV;
 		goto hdlerr;
 	}
-	dir_fd = vfs_fsal_open(myself, flags, &fsal_error);
+	dir_fd = vfs_path_fd_get(myself, &fsal_error);
 	if (dir_fd < 0)
 		return fsalstat(fsal_error, -dir_fd);
 	flags |= O_NOFOLLOW;	/* BSD needs O_NOFOLLOW for
@@ -703,14 +717,14 @@ static fsal_status_t makesymlink(struct fsal_obj_handle *dir_hdl,
 	}
 	*handle = &hdl->obj_handle;
 
-	close(dir_fd);
+	vfs_path_fd_put(myself, dir_fd);
 	return fsalstat(ERR_FSAL_NO_ERROR, 0);
 
  linkerr:
 	unlinkat(dir_fd, name, 0);
 
  direrr:
-	close(dir_fd);
+	vfs_path_fd_put(myself, dir_fd);
  hdlerr:
 	if (retval == ENOENT)
 		fsal_error = ERR_FSAL_STALE;
@@ -818,7 +832,7 @@ static fsal_status_t linkfile(struct fsal_obj_handle *obj_hdl,
 		fsal_error = posix2fsal_error(retval);
 		goto fileerr;
 	}
-	destdirfd = vfs_fsal_open(destdir, flags, &fsal_error);
+	destdirfd = vfs_path_fd_get(destdir, &fsal_error);
 	if (destdirfd < 0) {
 		retval = destdirfd;
 		goto fileerr;
@@ -830,7 +844,7 @@ static fsal_status_t linkfile(struct fsal_obj_handle *obj_hdl,
 		retval = errno;
 		fsal_error = posix2fsal_error(retval);
 	}
-	close(destdirfd);
+	vfs_path_fd_put(destdir, destdirfd);
 
  fileerr:
 	if (!(obj_hdl->type == REGULAR_FILE && myself->u.file.fd >= 0))
@@ -926,6 +940,108 @@ static fsal_status_t read_dirents(struct fsal_obj_handle *dir_hdl,
 	return fsalstat(fsal_error, retval);
 }
 
+#define PLUS_BUF_SIZE 32768
+/**
+ * read_dirents_plus
+ * read the directory and call through the callback function with a
+ * handle for each entry.  The entries are read in large batches and
+ * looked up relative to the directory opened for reading, rather than
+ * by a lookup of each name.
+ * @param dir_hdl [IN] the directory to read
+ * @param whence [IN] where to start (next)
+ * @param dir_state [IN] pass thru of state to callback
+ * @param cb [IN] callback function
+ * @param eof [OUT] eof marker true == end of dir
+ */
+
+static fsal_status_t read_dirents_plus(struct fsal_obj_handle *dir_hdl,
+				       fsal_cookie_t *whence, void *dir_state,
+				       fsal_readdir_plus_cb cb, bool *eof)
+{
+	struct vfs_fsal_obj_handle *myself;
+	int dirfd;
+	fsal_errors_t fsal_error = ERR_FSAL_NO_ERROR;
+	fsal_status_t status;
+	int retval = 0;
+	off_t seekloc = 0;
+	off_t baseloc = 0;
+	unsigned int bpos;
+	int nread;
+	struct vfs_dirent dentry, *dentryp = &dentry;
+	struct fsal_obj_handle *obj;
+	char *buf;
+
+	if (whence != NULL)
+		seekloc = (off_t) *whence;
+	myself = container_of(dir_hdl, struct vfs_fsal_obj_handle, obj_handle);
+	if (dir_hdl->fsal != dir_hdl->fs->fsal) {
+		LogDebug(COMPONENT_FSAL,
+			 "FSAL %s operation for handle belonging to FSAL %s, return EXDEV",
+			 dir_hdl->fsal->name,
+			 dir_hdl->fs->fsal != NULL
+				? dir_hdl->fs->fsal->name
+				: "(none)");
+		retval = EXDEV;
+		fsal_error = posix2fsal_error(retval);
+		goto out;
+	}
+	buf = gsh_malloc(PLUS_BUF_SIZE);
+	if (buf == NULL) {
+		retval = ENOMEM;
+		fsal_error = posix2fsal_error(retval);
+		goto out;
+	}
+	dirfd = vfs_fsal_open(myself, O_RDONLY | O_DIRECTORY, &fsal_error);
+	if (dirfd < 0) {
+		retval = -dirfd;
+		goto freebuf;
+	}
+	seekloc = lseek(dirfd, seekloc, SEEK_SET);
+	if (seekloc < 0) {
+		retval = errno;
+		fsal_error = posix2fsal_error(retval);
+		goto done;
+	}
+
+	do {
+		baseloc = seekloc;
+		nread = vfs_readents(dirfd, buf, PLUS_BUF_SIZE, &seekloc);
+		if (nread < 0) {
+			retval = errno;
+			fsal_error = posix2fsal_error(retval);
+			goto done;
+		}
+		if (nread == 0)
+			break;
+		for (bpos = 0; bpos < nread;) {
+			if (!to_vfs_dirent(buf, bpos, dentryp, baseloc)
+			    || strcmp(dentryp->vd_name, ".") == 0
+			    || strcmp(dentryp->vd_name, "..") == 0)
+				goto skip;	/* must skip '.' and '..' */
+
+			obj = NULL;
+			status = lookup_at(myself, dirfd, dentryp->vd_name,
+					   &obj);
+
+			/* callback to cache inode */
+			if (!cb(dentryp->vd_name, obj, status, dir_state,
+				(fsal_cookie_t) dentryp->vd_offset)) {
+				goto done;
+			}
+ skip:
+			bpos += dentryp->vd_reclen;
+		}
+	} while (nread > 0);
+
+	*eof = true;
+ done:
+	close(dirfd);
+ freebuf:
+	gsh_free(buf);
+ out:
+	return fsalstat(fsal_error, retval);
+}
+
 static fsal_status_t renamefile(struct fsal_obj_handle *olddir_hdl,
 				const char *old_name,
 				struct fsal_obj_handle *newdir_hdl,
@@ -935,6 +1051,10 @@ static fsal_status_t renamefile(struct fsal_obj_handle *olddir_hdl,
 	int oldfd = -1, newfd = -1;
 	fsal_errors_t fsal_error = ERR_FSAL_NO_ERROR;
 	int retval = 0;
+	vfs_file_handle_t *fh = NULL;
+	bool replaced;
+
+	vfs_alloc_handle(fh);
 
 	olddir =
 	    container_of(olddir_hdl, struct vfs_fsal_obj_handle, obj_handle);
@@ -949,7 +1069,7 @@ static fsal_status_t renamefile(struct fsal_obj_handle *olddir_hdl,
 		fsal_error = posix2fsal_error(retval);
 		goto out;
 	}
-	oldfd = vfs_fsal_open(olddir, O_PATH | O_NOACCESS, &fsal_error);
+	oldfd = vfs_path_fd_get(olddir, &fsal_error);
 	if (oldfd < 0) {
 		retval = -oldfd;
 		goto out;
@@ -967,11 +1087,14 @@ static fsal_status_t renamefile(struct fsal_obj_handle *olddir_hdl,
 		fsal_error = posix2fsal_error(retval);
 		goto out;
 	}
-	newfd = vfs_fsal_open(newdir, O_PATH | O_NOACCESS, &fsal_error);
+	newfd = vfs_path_fd_get(newdir, &fsal_error);
 	if (newfd < 0) {
 		retval = -newfd;
 		goto out;
 	}
+	/* Drop the cached descriptor of any object renamed over */
+	replaced = vfs_path_fd_name_handle(newfd, newdir_hdl->fs, new_name,
+					   fh);
 	/* Become the user because we are creating/removing objects
 	 * in these dirs which messes with quotas and perms.
 	 */
@@ -980,13 +1103,15 @@ static fsal_status_t renamefile(struct fsal_obj_handle *olddir_hdl,
 	if (retval < 0) {
 		retval = errno;
 		fsal_error = posix2fsal_error(retval);
+	} else if (replaced) {
+		vfs_path_fd_forget_fh(fh);
 	}
 	fsal_restore_ganesha_credentials();
  out:
 	if (oldfd >= 0)
-		close(oldfd);
+		vfs_path_fd_put(olddir, oldfd);
 	if (newfd >= 0)
-		close(newfd);
+		vfs_path_fd_put(newdir, newfd);
 	return fsalstat(fsal_error, retval);
 }
 
@@ -1101,6 +1226,40 @@ static struct closefd vfs_fsal_open_and_stat(struct fsal_export *exp,
 	return cfd;
 }
 
+/* vfs_path_fd_stat
+ * stat a directory or a file with no open descriptor through the O_PATH
+ * descriptor cached for it.  Returns false if the caller should open
+ * the object and stat it instead, which is also how errors are left to
+ * be reported.  An object with no link left loses its descriptor so it
+ * does not stay around because of us.
+ */
+
+static bool vfs_path_fd_stat(struct vfs_fsal_obj_handle *myself,
+			     struct stat *stat)
+{
+	fsal_errors_t fsal_error = ERR_FSAL_NO_ERROR;
+	int fd, retval;
+
+	if (myself->obj_handle.type != DIRECTORY &&
+	    (myself->obj_handle.type != REGULAR_FILE ||
+	     myself->u.file.openflags != FSAL_O_CLOSED))
+		return false;
+
+	fd = vfs_path_fd_get(myself, &fsal_error);
+	if (fd < 0)
+		return false;
+
+	retval = vfs_stat_by_handle(fd, myself->handle, stat,
+				    O_PATH | O_NOACCESS);
+	if (retval < 0 || stat->st_nlink == 0) {
+		vfs_path_fd_forget(myself);
+		retval = -1;
+	}
+	vfs_path_fd_put(myself, fd);
+
+	return retval == 0;
+}
+
 static fsal_status_t getattrs(struct fsal_obj_handle *obj_hdl)
 {
 	struct vfs_fsal_obj_handle *myself;
@@ -1122,42 +1281,46 @@ static fsal_status_t getattrs(struct fsal_obj_handle *obj_hdl)
 		goto out;
 	}
 
-	cfd = vfs_fsal_open_and_stat(op_ctx->fsal_export, myself, &stat,
-				     O_RDONLY, &fsal_error);
-	if (cfd.fd >= 0) {
-		st = posix2fsal_attributes(&stat, &obj_hdl->attributes);
+	if (!vfs_path_fd_stat(myself, &stat)) {
+		cfd = vfs_fsal_open_and_stat(op_ctx->fsal_export, myself,
+					     &stat, O_RDONLY, &fsal_error);
+		if (cfd.fd < 0) {
+			LogDebug(COMPONENT_FSAL,
+				 "Failed with %s, fsal_error %s",
+				 strerror(-cfd.fd),
+				 fsal_error ==
+				 ERR_FSAL_STALE ? "ERR_FSAL_STALE" : "other");
+			if (obj_hdl->type == SYMBOLIC_LINK
+			    && cfd.fd == -EPERM) {
+				/* You cannot open_by_handle (XFS on linux) a
+				 * symlink and it throws an EPERM error for it.
+				 * open_by_handle_at does not throw that error
+				 * for symlinks so we play a game here.  Since
+				 * there is not much we can do with symlinks
+				 * anyway, say that we did it but don't
+				 * actually do anything.  In this case, return
+				 * the stat we got at lookup time.  If you
+				 * *really* want to tweek things like owners,
+				 * get a modern linux kernel...
+				 */
+				fsal_error = ERR_FSAL_NO_ERROR;
+				goto out;
+			}
+			retval = -cfd.fd;
+			goto out;
+		}
 		if (cfd.close_fd)
 			close(cfd.fd);
-		if (FSAL_IS_ERROR(st)) {
-			FSAL_CLEAR_MASK(obj_hdl->attributes.mask);
-			FSAL_SET_MASK(obj_hdl->attributes.mask,
-				      ATTR_RDATTR_ERR);
-			fsal_error = st.major;
-			retval = st.minor;
-		} else {
-			obj_hdl->attributes.fsid = obj_hdl->fs->fsid;
-		}
+	}
+
+	st = posix2fsal_attributes(&stat, &obj_hdl->attributes);
+	if (FSAL_IS_ERROR(st)) {
+		FSAL_CLEAR_MASK(obj_hdl->attributes.mask);
+		FSAL_SET_MASK(obj_hdl->attributes.mask, ATTR_RDATTR_ERR);
+		fsal_error = st.major;
+		retval = st.minor;
 	} else {
-		LogDebug(COMPONENT_FSAL, "Failed with %s, fsal_error %s",
-			 strerror(-cfd.fd),
-			 fsal_error ==
-			 ERR_FSAL_STALE ? "ERR_FSAL_STALE" : "other");
-		if (obj_hdl->type == SYMBOLIC_LINK
-		    && cfd.fd == -EPERM) {
-			/* You cannot open_by_handle (XFS on linux) a symlink
-			 * and it throws an EPERM error for it.
-			 * open_by_handle_at does not throw that error for
-			 * symlinks so we play a game here.  Since there is
-			 * not much we can do with symlinks anyway,
-			 * say that we did it but don't actually
-			 * do anything.  In this case, return the stat we got
-			 * at lookup time.  If you *really* want to tweek things
-			 * like owners, get a modern linux kernel...
-			 */
-			fsal_error = ERR_FSAL_NO_ERROR;
-			goto out;
-		}
-		retval = -cfd.fd;
+		obj_hdl->attributes.fsid = obj_hdl->fs->fsid;
 	}
 
  out:
@@ -1363,7 +1526,10 @@ static fsal_status_t file_unlink(struct fsal_obj_handle *dir_hdl,
 	struct stat stat;
 	int fd;
 	int retval = 0;
+	vfs_file_handle_t *fh = NULL;
+	bool cached;
 
+	vfs_alloc_handle(fh);
 	myself = container_of(dir_hdl, struct vfs_fsal_obj_handle, obj_handle);
 	if (dir_hdl->fsal != dir_hdl->fs->fsal) {
 		LogDebug(COMPONENT_FSAL,
@@ -1376,7 +1542,7 @@ static fsal_status_t file_unlink(struct fsal_obj_handle *dir_hdl,
 		fsal_error = posix2fsal_error(retval);
 		goto out;
 	}
-	fd = vfs_fsal_open(myself, O_PATH | O_NOACCESS, &fsal_error);
+	fd = vfs_path_fd_get(myself, &fsal_error);
 	if (fd < 0) {
 		retval = -fd;
 		goto out;
@@ -1392,6 +1558,7 @@ static fsal_status_t file_unlink(struct fsal_obj_handle *dir_hdl,
 			fsal_error = posix2fsal_error(retval);
 		goto errout;
 	}
+	cached = vfs_path_fd_name_handle(fd, dir_hdl->fs, name, fh);
 	retval = unlinkat(fd, name, (S_ISDIR(stat.st_mode)) ? AT_REMOVEDIR : 0);
 	if (retval < 0) {
 		retval = errno;
@@ -1399,10 +1566,13 @@ static fsal_status_t file_unlink(struct fsal_obj_handle *dir_hdl,
 			fsal_error = ERR_FSAL_STALE;
 		else
 			fsal_error = posix2fsal_error(retval);
+	} else if (cached) {
+		/* Do not keep the removed object alive */
+		vfs_path_fd_forget_fh(fh);
 	}
 
  errout:
-	close(fd);
+	vfs_path_fd_put(myself, fd);
  out:
 	return fsalstat(fsal_error, retval);
 }
@@ -1493,6 +1663,7 @@ static void release(struct fsal_obj_handle *obj_hdl)
 		}
 	}
 
+	vfs_path_fd_forget(myself);
 	fsal_obj_handle_fini(obj_hdl);
 
 	if (type == SYMBOLIC_LINK) {
@@ -1513,6 +1684,7 @@ void vfs_handle_ops_init(struct fsal_obj_ops *ops)
 	ops->release = release;
 	ops->lookup = lookup;
 	ops->readdir = read_dirents;
+	ops->readdir_plus = read_dirents_plus;
 	ops->create = create;
 	ops->mkdir = makedir;
 	ops->mknode = makenode;
@@ -1528,7 +1700,11 @@ void vfs_handle_ops_init(struct fsal_obj_ops *ops)
 	ops->status = vfs_status;
 	ops->read = vfs_read;
 	ops->write = vfs_write;
+	ops->read2 = vfs_read2;
+	ops->write2 = vfs_write2;
 	ops->commit = vfs_commit;
+	ops->copy = vfs_copy;
+	ops->clone = vfs_clone;
 	ops->lock_op = vfs_lock_op;
 	ops->close = vfs_close;
 	ops->lru_cleanup = vfs_lru_cleanup;
@@ -81,6 +81,7 @@ static struct fsal_staticfsinfo_t default_posix_info = {
 	.supported_attrs = PANFS_SUPPORTED_ATTRIBUTES,
 	.maxread = FSAL_MAXIOSIZE,
 	.maxwrite = FSAL_MAXIOSIZE,
+	.change_is_ctime = true,
 };
 
 static struct config_item panfs_params[] = {
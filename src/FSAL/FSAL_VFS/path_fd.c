@@ -0,0 +1,372 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/* path_fd.c
+ * Cache of O_PATH descriptors for VFS object handles
+ *
+ * Getting attributes of a directory or of a file nobody has open, or
+ * operating on names in a directory, needs a descriptor for the
+ * object, and open_by_handle_at is the most expensive part of those
+ * operations.  Handles therefore keep the O_PATH descriptor they get
+ * for this, up to a configured number of descriptors overall.  The
+ * descriptors are spread over lanes, each with its own lock and LRU
+ * list, and idle descriptors are closed from the cold end of a lane
+ * to make room for new ones.
+ *
+ * The cache is bounded by its own size and is not counted in
+ * open_fd_count, which the cache_inode LRU uses to decide how many
+ * of its own descriptors to close and could not get back by doing
+ * so.  None are added while cache_inode is short of descriptors or
+ * is no longer caching them, and while it is over its high water
+ * mark descriptors are closed as their last user is done with them
+ * and idle ones are closed from the cold end as lanes are used.
+ *
+ * An O_PATH descriptor keeps an unlinked object alive.  Handles are
+ * put on a lane by the hash of their file handle, so unlink and
+ * rename can find and drop the descriptor of the object they remove
+ * from the name alone; getattr also drops the descriptor of a handle
+ * it finds with no links left.
+ */
+
+#include "config.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include "fsal.h"
+#include "fsal_convert.h"
+#include "cache_inode_lru.h"
+#include "city.h"
+#include "vfs_methods.h"
+
+/** Number of lanes, prime like the cache_inode LRU lanes */
+#define VFS_PATH_FD_LANES 17
+
+static struct vfs_path_fd_lane {
+	pthread_mutex_t mtx;
+	struct glist_head lru;	/*< Most recently used first */
+	uint32_t count;		/*< Descriptors on the list */
+} path_fd_lane[VFS_PATH_FD_LANES];
+
+/** Most descriptors per lane, 0 if the cache is off */
+static uint32_t path_fd_lane_max;
+
+static inline struct vfs_path_fd_lane *
+path_fd_lane_of_fh(vfs_file_handle_t *fh)
+{
+	return &path_fd_lane[CityHash64((char *)fh->handle_data,
+					fh->handle_len) % VFS_PATH_FD_LANES];
+}
+
+static inline struct vfs_path_fd_lane *
+path_fd_lane_of(struct vfs_fsal_obj_handle *hdl)
+{
+	return &path_fd_lane[hdl->path_fd.lane];
+}
+
+/**
+ * @brief Whether cache_inode is short of descriptors
+ */
+
+static inline bool path_fd_fds_short(void)
+{
+	return atomic_fetch_size_t(&open_fd_count) >= lru_state.fds_hiwat;
+}
+
+/**
+ * @brief Close the cached descriptor of a handle
+ *
+ * @param[in] lane Lane of the handle, locked
+ * @param[in] pfd  Cached descriptor with no users
+ */
+
+static void path_fd_drop(struct vfs_path_fd_lane *lane,
+			 struct vfs_path_fd *pfd)
+{
+	glist_del(&pfd->lru);
+	lane->count--;
+	close(pfd->fd);
+	pfd->fd = -1;
+	pfd->doomed = false;
+}
+
+/**
+ * @brief Close the least recently used idle descriptor of a lane
+ *
+ * @param[in] lane The lane, locked
+ *
+ * @return true if a descriptor was closed.
+ */
+
+static bool path_fd_evict(struct vfs_path_fd_lane *lane)
+{
+	struct glist_head *glist;
+	struct vfs_path_fd *pfd;
+
+	for (glist = lane->lru.prev; glist != &lane->lru;
+	     glist = glist->prev) {
+		pfd = glist_entry(glist, struct vfs_path_fd, lru);
+		if (pfd->refs == 0) {
+			path_fd_drop(lane, pfd);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Set up the cached descriptor of a new handle
+ *
+ * @param[in] hdl The handle
+ */
+
+void vfs_path_fd_init_handle(struct vfs_fsal_obj_handle *hdl)
+{
+	glist_init(&hdl->path_fd.lru);
+	hdl->path_fd.lane = path_fd_lane_of_fh(hdl->handle) - path_fd_lane;
+	hdl->path_fd.fd = -1;
+	hdl->path_fd.refs = 0;
+	hdl->path_fd.doomed = false;
+}
+
+/**
+ * @brief Get an O_PATH descriptor for a handle
+ *
+ * The descriptor must be given back with vfs_path_fd_put, never
+ * closed by the caller.
+ *
+ * @param[in]  hdl        The handle
+ * @param[out] fsal_error FSAL error if the object could not be opened
+ *
+ * @return The descriptor, or -errno on failure.
+ */
+
+int vfs_path_fd_get(struct vfs_fsal_obj_handle *hdl,
+		    fsal_errors_t *fsal_error)
+{
+	struct vfs_path_fd_lane *lane = path_fd_lane_of(hdl);
+	struct vfs_path_fd *pfd = &hdl->path_fd;
+	int fd;
+
+	if (path_fd_lane_max == 0)
+		return vfs_fsal_open(hdl, O_PATH | O_NOACCESS, fsal_error);
+
+	PTHREAD_MUTEX_lock(&lane->mtx);
+	if (pfd->fd >= 0 && !pfd->doomed) {
+		pfd->refs++;
+		glist_del(&pfd->lru);
+		glist_add(&lane->lru, &pfd->lru);
+		fd = pfd->fd;
+		PTHREAD_MUTEX_unlock(&lane->mtx);
+		return fd;
+	}
+	if (path_fd_fds_short())
+		(void)path_fd_evict(lane);
+	PTHREAD_MUTEX_unlock(&lane->mtx);
+
+	fd = vfs_fsal_open(hdl, O_PATH | O_NOACCESS, fsal_error);
+	if (fd < 0)
+		return fd;
+
+	if (!cache_inode_lru_caching_fds() ||
+	    atomic_fetch_size_t(&open_fd_count) >= lru_state.fds_lowat)
+		return fd;
+
+	PTHREAD_MUTEX_lock(&lane->mtx);
+	if (pfd->fd >= 0) {
+		if (!pfd->doomed) {
+			/* Someone else cached one in the meantime */
+			pfd->refs++;
+			close(fd);
+			fd = pfd->fd;
+		}
+	} else if (lane->count < path_fd_lane_max || path_fd_evict(lane)) {
+		pfd->fd = fd;
+		pfd->refs = 1;
+		glist_add(&lane->lru, &pfd->lru);
+		lane->count++;
+	}
+	PTHREAD_MUTEX_unlock(&lane->mtx);
+
+	return fd;
+}
+
+/**
+ * @brief Give back a descriptor from vfs_path_fd_get
+ *
+ * @param[in] hdl The handle
+ * @param[in] fd  The descriptor
+ */
+
+void vfs_path_fd_put(struct vfs_fsal_obj_handle *hdl, int fd)
+{
+	struct vfs_path_fd_lane *lane = path_fd_lane_of(hdl);
+	struct vfs_path_fd *pfd = &hdl->path_fd;
+
+	if (path_fd_lane_max != 0) {
+		PTHREAD_MUTEX_lock(&lane->mtx);
+		if (fd == pfd->fd) {
+			if (--pfd->refs == 0 &&
+			    (pfd->doomed || path_fd_fds_short()))
+				path_fd_drop(lane, pfd);
+			PTHREAD_MUTEX_unlock(&lane->mtx);
+			return;
+		}
+		PTHREAD_MUTEX_unlock(&lane->mtx);
+	}
+
+	close(fd);
+}
+
+/**
+ * @brief Stop caching a descriptor
+ *
+ * The descriptor is closed now if it has no users, otherwise when
+ * the last of them gives it back.
+ *
+ * @param[in] lane Lane of the handle, locked
+ * @param[in] pfd  Cached descriptor of the handle
+ */
+
+static void path_fd_forget_locked(struct vfs_path_fd_lane *lane,
+				  struct vfs_path_fd *pfd)
+{
+	if (pfd->fd >= 0) {
+		if (pfd->refs == 0)
+			path_fd_drop(lane, pfd);
+		else
+			pfd->doomed = true;
+	}
+}
+
+/**
+ * @brief Stop caching the descriptor of a handle
+ *
+ * @param[in] hdl The handle
+ */
+
+void vfs_path_fd_forget(struct vfs_fsal_obj_handle *hdl)
+{
+	struct vfs_path_fd_lane *lane = path_fd_lane_of(hdl);
+
+	if (path_fd_lane_max == 0)
+		return;
+
+	PTHREAD_MUTEX_lock(&lane->mtx);
+	path_fd_forget_locked(lane, &hdl->path_fd);
+	PTHREAD_MUTEX_unlock(&lane->mtx);
+}
+
+/**
+ * @brief Get the file handle of a name whose descriptor may be dropped
+ *
+ * Called before a name is unlinked or renamed over, while the object
+ * can still be reached by it.
+ *
+ * @param[in]  dirfd Descriptor of the directory
+ * @param[in]  fs    Filesystem of the directory
+ * @param[in]  name  The name
+ * @param[out] fh    File handle of the object
+ *
+ * @return true if there is a descriptor cache and fh was filled in.
+ */
+
+bool vfs_path_fd_name_handle(int dirfd, struct fsal_filesystem *fs,
+			     const char *name, vfs_file_handle_t *fh)
+{
+	if (path_fd_lane_max == 0)
+		return false;
+
+	return vfs_name_to_handle(dirfd, fs, name, fh) == 0;
+}
+
+/**
+ * @brief Stop caching the descriptor of an object removed from a name
+ *
+ * Every handle for the object is found by its file handle, so the
+ * descriptor no longer keeps the object from being freed once its
+ * last link is gone.
+ *
+ * @param[in] fh File handle from vfs_path_fd_name_handle
+ */
+
+void vfs_path_fd_forget_fh(vfs_file_handle_t *fh)
+{
+	struct vfs_path_fd_lane *lane = path_fd_lane_of_fh(fh);
+	struct glist_head *glist, *glistn;
+	struct vfs_path_fd *pfd;
+	struct vfs_fsal_obj_handle *hdl;
+
+	PTHREAD_MUTEX_lock(&lane->mtx);
+	glist_for_each_safe(glist, glistn, &lane->lru) {
+		pfd = glist_entry(glist, struct vfs_path_fd, lru);
+		hdl = container_of(pfd, struct vfs_fsal_obj_handle, path_fd);
+		if (hdl->handle->handle_len == fh->handle_len &&
+		    memcmp(hdl->handle->handle_data, fh->handle_data,
+			   fh->handle_len) == 0)
+			path_fd_forget_locked(lane, pfd);
+	}
+	PTHREAD_MUTEX_unlock(&lane->mtx);
+}
+
+/**
+ * @brief Set up the descriptor cache
+ *
+ * @param[in] size Most descriptors to cache, 0 to cache none
+ */
+
+void vfs_path_fd_init(uint32_t size)
+{
+	int i;
+
+	for (i = 0; i < VFS_PATH_FD_LANES; i++) {
+		PTHREAD_MUTEX_init(&path_fd_lane[i].mtx, NULL);
+		glist_init(&path_fd_lane[i].lru);
+		path_fd_lane[i].count = 0;
+	}
+
+	path_fd_lane_max = (size + VFS_PATH_FD_LANES - 1) / VFS_PATH_FD_LANES;
+}
+
+/**
+ * @brief Close every idle cached descriptor
+ *
+ * Called when the FSAL is unloaded, after cache_inode released all
+ * its handles.
+ */
+
+void vfs_path_fd_shutdown(void)
+{
+	struct vfs_path_fd_lane *lane;
+	int i;
+
+	if (path_fd_lane_max == 0)
+		return;
+
+	for (i = 0; i < VFS_PATH_FD_LANES; i++) {
+		lane = &path_fd_lane[i];
+		PTHREAD_MUTEX_lock(&lane->mtx);
+		while (path_fd_evict(lane))
+			;
+		PTHREAD_MUTEX_unlock(&lane->mtx);
+	}
+}
@@ -81,6 +81,7 @@ static struct fsal_staticfsinfo_t default_posix_info = {
 	.supported_attrs = VFS_SUPPORTED_ATTRIBUTES,
 	.maxread = FSAL_MAXIOSIZE,
 	.maxwrite = FSAL_MAXIOSIZE,
+	.change_is_ctime = true,
 };
 
 static struct config_item vfs_params[] = {
@@ -100,6 +101,10 @@ static struct config_item vfs_params[] = {
 		       fsal_staticfsinfo_t, auth_exportpath_xdev),
 	CONF_ITEM_MODE("xattr_access_rights", 0400,
 		       fsal_staticfsinfo_t, xattr_access_rights),
+	CONF_ITEM_UI32("async_io_threads", 0, 1024, 0,
+		       fsal_staticfsinfo_t, async_io_threads),
+	CONF_ITEM_UI32("path_fd_cache", 0, 1024 * 1024, 1024,
+		       fsal_staticfsinfo_t, path_fd_cache),
 	CONFIG_EOL
 };
 
@@ -112,6 +117,18 @@ struct config_block vfs_param = {
 	.blk_desc.u.blk.commit = noop_conf_commit
 };
 
+/* Async I/O threads, in file.c
+ */
+
+int vfs_async_init(uint32_t threads);
+void vfs_async_shutdown(void);
+
+/* O_PATH descriptor cache, in path_fd.c
+ */
+
+void vfs_path_fd_init(uint32_t size);
+void vfs_path_fd_shutdown(void);
+
 /* private helper for export object
  */
 
@@ -145,6 +162,9 @@ static fsal_status_t init_config(struct fsal_module *fsal_hdl,
 				      err_type);
 	if (!config_error_is_harmless(err_type))
 		return fsalstat(ERR_FSAL_INVAL, 0);
+	if (vfs_async_init(vfs_me->fs_info.async_io_threads) != 0)
+		vfs_me->fs_info.async_io_threads = 0;
+	vfs_path_fd_init(vfs_me->fs_info.path_fd_cache);
 	display_fsinfo(&vfs_me->fs_info);
 	LogFullDebug(COMPONENT_FSAL,
 		     "Supported attributes constant = 0x%" PRIx64,
@@ -198,6 +218,9 @@ MODULE_FINI void vfs_unload(void)
 {
 	int retval;
 
+	vfs_async_shutdown();
+	vfs_path_fd_shutdown();
+
 	retval = unregister_fsal(&VFS.fsal);
 	if (retval != 0) {
 		fprintf(stderr, "VFS module failed to unregister");
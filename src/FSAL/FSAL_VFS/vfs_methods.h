@@ -101,10 +101,24 @@ fsal_status_t vfs_create_handle(struct fsal_export *exp_hdl,
  * this, we save the args that were used to mknod or lookup the socket.
  */
 
+/*
+ * O_PATH descriptor a handle keeps for getattr and directory
+ * operations, see path_fd.c.  Protected by the lock of its lane.
+ */
+
+struct vfs_path_fd {
+	struct glist_head lru;	/*< On the lane LRU while fd is cached */
+	uint32_t lane;		/*< Lane, from the hash of the file handle */
+	int fd;			/*< Cached descriptor, -1 if none */
+	uint32_t refs;		/*< Operations using fd */
+	bool doomed;		/*< Close fd once refs drops to 0 */
+};
+
 struct vfs_fsal_obj_handle {
 	struct fsal_obj_handle obj_handle;
 	fsal_dev_t dev;
 	vfs_file_handle_t *handle;
+	struct vfs_path_fd path_fd;
 	const struct fsal_up_vector *up_ops;	/*< Upcall operations */
 	union {
 		struct {
@@ -175,6 +189,17 @@ int vfs_fsal_open(struct vfs_fsal_obj_handle *hdl,
 		  int openflags,
 		  fsal_errors_t *fsal_error);
 
+void vfs_path_fd_init_handle(struct vfs_fsal_obj_handle *hdl);
+int vfs_path_fd_get(struct vfs_fsal_obj_handle *hdl,
+		    fsal_errors_t *fsal_error);
+void vfs_path_fd_put(struct vfs_fsal_obj_handle *hdl, int fd);
+void vfs_path_fd_forget(struct vfs_fsal_obj_handle *hdl);
+bool vfs_path_fd_name_handle(int dirfd, struct fsal_filesystem *fs,
+			     const char *name, vfs_file_handle_t *fh);
+void vfs_path_fd_forget_fh(vfs_file_handle_t *fh);
+void vfs_path_fd_init(uint32_t size);
+void vfs_path_fd_shutdown(void);
+
 static inline bool vfs_unopenable_type(object_file_type_t type)
 {
 	if ((type == SOCKET_FILE) || (type == CHARACTER_FILE)
@@ -197,8 +222,29 @@ fsal_status_t vfs_write(struct fsal_obj_handle *obj_hdl,
 			uint64_t offset,
 			size_t buffer_size, void *buffer, size_t *write_amount,
 			bool *fsal_stable);
+void vfs_read2(struct fsal_obj_handle *obj_hdl,
+	       struct fsal_io_arg *read_arg,
+	       fsal_async_cb done_cb,
+	       void *caller_arg);
+void vfs_write2(struct fsal_obj_handle *obj_hdl,
+		struct fsal_io_arg *write_arg,
+		fsal_async_cb done_cb,
+		void *caller_arg);
+int vfs_async_init(uint32_t threads);
+void vfs_async_shutdown(void);
 fsal_status_t vfs_commit(struct fsal_obj_handle *obj_hdl,	/* sync */
 			 off_t offset, size_t len);
+fsal_status_t vfs_copy(struct fsal_obj_handle *src_hdl,
+		       uint64_t src_offset,
+		       struct fsal_obj_handle *dst_hdl,
+		       uint64_t dst_offset,
+		       uint64_t count,
+		       uint64_t *copied);
+fsal_status_t vfs_clone(struct fsal_obj_handle *src_hdl,
+			uint64_t src_offset,
+			struct fsal_obj_handle *dst_hdl,
+			uint64_t dst_offset,
+			uint64_t count);
 fsal_status_t vfs_lock_op(struct fsal_obj_handle *obj_hdl,
 			  void *p_owner,
 			  fsal_lock_op_t lock_op,
@@ -80,6 +80,7 @@ static struct fsal_staticfsinfo_t default_posix_info = {
 	.supported_attrs = XFS_SUPPORTED_ATTRIBUTES,
 	.maxread = FSAL_MAXIOSIZE,
 	.maxwrite = FSAL_MAXIOSIZE,
+	.change_is_ctime = true,
 };
 
 static struct config_item xfs_params[] = {
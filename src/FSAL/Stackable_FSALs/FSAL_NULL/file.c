@@ -97,6 +97,35 @@ fsal_status_t nullfs_commit(struct fsal_obj_handle *obj_hdl,	/* sync */
 	return next_ops.obj_ops.commit(obj_hdl, offset, len);
 }
 
+/* nullfs_copy
+ * Copy a range between files, leaving it to the sub-FSAL.
+ */
+
+fsal_status_t nullfs_copy(struct fsal_obj_handle *src_hdl,
+			  uint64_t src_offset,
+			  struct fsal_obj_handle *dst_hdl,
+			  uint64_t dst_offset,
+			  uint64_t count,
+			  uint64_t *copied)
+{
+	return next_ops.obj_ops.copy(src_hdl, src_offset, dst_hdl,
+				     dst_offset, count, copied);
+}
+
+/* nullfs_clone
+ * Clone a range between files, leaving it to the sub-FSAL.
+ */
+
+fsal_status_t nullfs_clone(struct fsal_obj_handle *src_hdl,
+			   uint64_t src_offset,
+			   struct fsal_obj_handle *dst_hdl,
+			   uint64_t dst_offset,
+			   uint64_t count)
+{
+	return next_ops.obj_ops.clone(src_hdl, src_offset, dst_hdl,
+				      dst_offset, count);
+}
+
 /* nullfs_lock_op
  * lock a region of the file
  * throw an error if the fd is not open.  The old fsal didn't
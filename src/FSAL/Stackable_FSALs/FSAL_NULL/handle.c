@@ -131,6 +131,14 @@ static fsal_status_t read_dirents(struct fsal_obj_handle *dir_hdl,
 					 eof);
 }
 
+static fsal_status_t read_dirents_plus(struct fsal_obj_handle *dir_hdl,
+				       fsal_cookie_t *whence, void *dir_state,
+				       fsal_readdir_plus_cb cb, bool *eof)
+{
+	return next_ops.obj_ops.readdir_plus(dir_hdl, whence, dir_state, cb,
+					      eof);
+}
+
 static fsal_status_t renamefile(struct fsal_obj_handle *olddir_hdl,
 				const char *old_name,
 				struct fsal_obj_handle *newdir_hdl,
@@ -208,6 +216,7 @@ void nullfs_handle_ops_init(struct fsal_obj_ops *ops)
 	ops->release = release;
 	ops->lookup = lookup;
 	ops->readdir = read_dirents;
+	ops->readdir_plus = read_dirents_plus;
 	ops->create = create;
 	ops->mkdir = makedir;
 	ops->mknode = makenode;
@@ -224,6 +233,8 @@ void nullfs_handle_ops_init(struct fsal_obj_ops *ops)
 	ops->read = nullfs_read;
 	ops->write = nullfs_write;
 	ops->commit = nullfs_commit;
+	ops->copy = nullfs_copy;
+	ops->clone = nullfs_clone;
 	ops->lock_op = nullfs_lock_op;
 	ops->close = nullfs_close;
 	ops->lru_cleanup = nullfs_lru_cleanup;
@@ -94,6 +94,17 @@ fsal_status_t nullfs_write(struct fsal_obj_handle *obj_hdl,
 			   size_t *write_amount, bool *fsal_stable);
 fsal_status_t nullfs_commit(struct fsal_obj_handle *obj_hdl,	/* sync */
 			    off_t offset, size_t len);
+fsal_status_t nullfs_copy(struct fsal_obj_handle *src_hdl,
+			  uint64_t src_offset,
+			  struct fsal_obj_handle *dst_hdl,
+			  uint64_t dst_offset,
+			  uint64_t count,
+			  uint64_t *copied);
+fsal_status_t nullfs_clone(struct fsal_obj_handle *src_hdl,
+			   uint64_t src_offset,
+			   struct fsal_obj_handle *dst_hdl,
+			   uint64_t dst_offset,
+			   uint64_t count);
 fsal_status_t nullfs_lock_op(struct fsal_obj_handle *obj_hdl,
 			     void *p_owner,
 			     fsal_lock_op_t lock_op,
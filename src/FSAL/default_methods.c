@@ -581,6 +581,44 @@ static fsal_status_t read_dirents(struct fsal_obj_handle *dir_hdl,
 	return fsalstat(ERR_FSAL_NOTSUPP, 0);
 }
 
+/* read_dirents_plus
+ * default case reads the names and looks each one up
+ */
+
+struct read_dirents_plus_state {
+	struct fsal_obj_handle *dir_hdl;
+	fsal_readdir_plus_cb cb;
+	void *dir_state;
+};
+
+static bool read_dirents_plus_cb(const char *name, void *dir_state,
+				 fsal_cookie_t cookie)
+{
+	struct read_dirents_plus_state *state = dir_state;
+	struct fsal_obj_handle *obj = NULL;
+	fsal_status_t status;
+
+	status = state->dir_hdl->obj_ops.lookup(state->dir_hdl, name, &obj);
+	if (FSAL_IS_ERROR(status))
+		obj = NULL;
+
+	return state->cb(name, obj, status, state->dir_state, cookie);
+}
+
+static fsal_status_t read_dirents_plus(struct fsal_obj_handle *dir_hdl,
+				       fsal_cookie_t *whence, void *dir_state,
+				       fsal_readdir_plus_cb cb, bool *eof)
+{
+	struct read_dirents_plus_state state = {
+		.dir_hdl = dir_hdl,
+		.cb = cb,
+		.dir_state = dir_state
+	};
+
+	return dir_hdl->obj_ops.readdir(dir_hdl, whence, &state,
+					read_dirents_plus_cb, eof);
+}
+
 /* create
  * default case not supported
  */
@@ -777,6 +815,85 @@ static fsal_status_t file_write_plus(struct fsal_obj_handle *obj_hdl,
 	return fsalstat(ERR_FSAL_NOTSUPP, 0);
 }
 
+/* file_read2
+ * default case reads in line through the read method
+ */
+
+static void file_read2(struct fsal_obj_handle *obj_hdl,
+		       struct fsal_io_arg *read_arg,
+		       fsal_async_cb done_cb,
+		       void *caller_arg)
+{
+	fsal_status_t status = { ERR_FSAL_NO_ERROR, 0 };
+	uint64_t offset = read_arg->offset;
+	size_t amount;
+	int i;
+
+	read_arg->io_amount = 0;
+	read_arg->end_of_file = false;
+
+	for (i = 0; i < read_arg->iov_count; i++) {
+		status = obj_hdl->obj_ops.read(obj_hdl, offset,
+					       read_arg->iov[i].iov_len,
+					       read_arg->iov[i].iov_base,
+					       &amount,
+					       &read_arg->end_of_file);
+		if (FSAL_IS_ERROR(status))
+			break;
+
+		read_arg->io_amount += amount;
+		offset += amount;
+
+		if (read_arg->end_of_file
+		    || amount < read_arg->iov[i].iov_len)
+			break;
+	}
+
+	done_cb(obj_hdl, status, read_arg, caller_arg);
+}
+
+/* file_write2
+ * default case writes in line through the write method
+ */
+
+static void file_write2(struct fsal_obj_handle *obj_hdl,
+			struct fsal_io_arg *write_arg,
+			fsal_async_cb done_cb,
+			void *caller_arg)
+{
+	fsal_status_t status = { ERR_FSAL_NO_ERROR, 0 };
+	uint64_t offset = write_arg->offset;
+	bool stable_in = write_arg->fsal_stable;
+	bool stable;
+	size_t amount;
+	int i;
+
+	write_arg->io_amount = 0;
+
+	/* The write is stable only if every piece of it was */
+	for (i = 0; i < write_arg->iov_count; i++) {
+		stable = stable_in;
+		status = obj_hdl->obj_ops.write(obj_hdl, offset,
+						write_arg->iov[i].iov_len,
+						write_arg->iov[i].iov_base,
+						&amount, &stable);
+		if (FSAL_IS_ERROR(status))
+			break;
+
+		write_arg->io_amount += amount;
+		offset += amount;
+		if (!stable)
+			write_arg->fsal_stable = false;
+		else if (i == 0)
+			write_arg->fsal_stable = true;
+
+		if (amount < write_arg->iov[i].iov_len)
+			break;
+	}
+
+	done_cb(obj_hdl, status, write_arg, caller_arg);
+}
+
 /* seek
  * default case not supported
  */
@@ -809,6 +926,34 @@ static fsal_status_t commit(struct fsal_obj_handle *obj_hdl,	/* sync */
 	return fsalstat(ERR_FSAL_NOTSUPP, 0);
 }
 
+/* copy
+ * default case not supported, the caller reads and writes
+ */
+
+static fsal_status_t copy(struct fsal_obj_handle *src_hdl,
+			  uint64_t src_offset,
+			  struct fsal_obj_handle *dst_hdl,
+			  uint64_t dst_offset,
+			  uint64_t count,
+			  uint64_t *copied)
+{
+	*copied = 0;
+	return fsalstat(ERR_FSAL_NOTSUPP, 0);
+}
+
+/* clone
+ * default case not supported
+ */
+
+static fsal_status_t clone(struct fsal_obj_handle *src_hdl,
+			   uint64_t src_offset,
+			   struct fsal_obj_handle *dst_hdl,
+			   uint64_t dst_offset,
+			   uint64_t count)
+{
+	return fsalstat(ERR_FSAL_NOTSUPP, 0);
+}
+
 /* lock_op
  * default case not supported
  */
@@ -1053,6 +1198,7 @@ struct fsal_obj_ops def_handle_ops = {
 	.release = handle_release,
 	.lookup = lookup,
 	.readdir = read_dirents,
+	.readdir_plus = read_dirents_plus,
 	.create = create,
 	.mkdir = makedir,
 	.mknode = makenode,
@@ -1072,9 +1218,13 @@ struct fsal_obj_ops def_handle_ops = {
 	.read_plus = file_read_plus,
 	.write = file_write,
 	.write_plus = file_write_plus,
+	.read2 = file_read2,
+	.write2 = file_write2,
 	.seek = file_seek,
 	.io_advise = file_io_advise,
 	.commit = commit,
+	.copy = copy,
+	.clone = clone,
 	.lock_op = lock_op,
 	.share_op = share_op,
 	.close = file_close,
@@ -104,6 +104,10 @@ bool fsal_supports(struct fsal_staticfsinfo_t *info,
 		return !!info->reopen_method;
 	case fso_grace_method:
 		return !!info->fsal_grace;
+	case fso_async_io:
+		return !!info->async_io_threads;
+	case fso_change_is_ctime:
+		return !!info->change_is_ctime;
 	default:
 		return false;	/* whatever I don't know about,
 				 * you can't do
@@ -44,7 +44,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
-#include <poll.h>
+#include <sys/epoll.h>
 #include <arpa/inet.h>		/* For inet_ntop() */
 #include "hashtable.h"
 #include "log.h"
@@ -58,6 +58,7 @@
 #include "nfs_file_handle.h"
 #include "client_mgr.h"
 #include "server_stats.h"
+#include "gsh_iobuf.h"
 #include "9p.h"
 #include <stdbool.h>
 
@@ -102,250 +103,406 @@ void DispatchWork9P(request_data_t *req)
 }
 
 /**
- * _9p_socket_thread: 9p socket manager.
- *
- * This function is the main loop for the 9p socket manager.
- * One such thread exists per connection.
- *
- * @param Arg the socket number cast as a void * in pthread_create
- *
- * @return NULL
+ * @brief A 9P/TCP connection polled by an event loop
  *
+ * The event loop that owns the connection holds a reference on it
+ * until the client goes away, and every request in flight holds
+ * another.  Whoever drops the last one closes the socket.
  */
-
-void *_9p_socket_thread(void *Arg)
-{
-	long int tcp_sock = (long int)Arg;
-	int rc = -1;
-	struct pollfd fds[1];
-	int fdcount = 1;
-	static char my_name[MAXNAMLEN + 1];
+struct _9p_tcp_conn {
+	struct _9p_conn conn;
+	char hdr[_9P_HDR_SIZE];	/*< Length of the message being read */
 	char strcaller[INET6_ADDRSTRLEN];
-	request_data_t *req = NULL;
-	int tag;
-	unsigned long sequence = 0;
-	unsigned int i = 0;
-	char *_9pmsg = NULL;
-	uint32_t msglen;
+	char *msg;		/*< Message being read, NULL while reading
+				    its length */
+	uint32_t msglen;	/*< Length of msg */
+	uint32_t readlen;	/*< Bytes of hdr or msg read so far */
+};
 
-	struct _9p_conn _9p_conn;
-	socklen_t addrpeerlen;
+/**
+ * @brief An event loop thread and its epoll instance
+ */
+struct _9p_event_loop {
+	int epfd;
+	pthread_t thrid;
+};
 
-	int readlen = 0;
-	int total_readlen = 0;
+/** Messages read from one connection before looking at the others */
+#define _9P_TCP_READ_BUDGET 16
+/** Events taken per epoll_wait */
+#define _9P_TCP_EPOLL_EVENTS 64
 
-	snprintf(my_name, MAXNAMLEN, "9p_sock_mgr#fd=%ld", tcp_sock);
-	SetNameFunction(my_name);
+static struct _9p_event_loop *_9p_event_loops;
+static uint32_t _9p_next_event_loop;
 
-	/* Init the struct _9p_conn structure */
-	memset(&_9p_conn, 0, sizeof(_9p_conn));
-	PTHREAD_MUTEX_init(&_9p_conn.sock_lock, NULL);
-	_9p_conn.trans_type = _9P_TCP;
-	_9p_conn.trans_data.sockfd = tcp_sock;
-	for (i = 0; i < FLUSH_BUCKETS; i++) {
-		PTHREAD_MUTEX_init(&_9p_conn.flush_buckets[i].lock, NULL);
-		glist_init(&_9p_conn.flush_buckets[i].list);
-	}
-	atomic_store_uint32_t(&_9p_conn.refcount, 0);
+/**
+ * @brief Release a reference on a 9P/TCP connection
+ *
+ * Dropping the last reference closes the socket, clunks the fids and
+ * frees the connection.
+ *
+ * @param[in] conn The connection
+ */
+void _9p_tcp_conn_put(struct _9p_conn *conn)
+{
+	struct _9p_tcp_conn *tconn =
+	    container_of(conn, struct _9p_tcp_conn, conn);
+	unsigned int i;
 
-	/* Init the fids pointers array */
-	memset(&_9p_conn.fids, 0, _9P_FID_PER_CONN * sizeof(struct _9p_fid *));
+	if (atomic_dec_uint32_t(&conn->refcount) != 0)
+		return;
 
-	/* Set initial msize.
-	 * Client may request a lower value during TVERSION */
-	_9p_conn.msize = _9p_param._9p_tcp_msize;
+	LogEvent(COMPONENT_9P, "Closing connection on socket %lu",
+		 conn->trans_data.sockfd);
+	close(conn->trans_data.sockfd);
 
-	if (gettimeofday(&_9p_conn.birth, NULL) == -1)
-		LogFatal(COMPONENT_9P, "Cannot get connection's time of birth");
+	/* Free buffer if we encountered an error
+	 * before we could give it to a worker */
+	if (tconn->msg != NULL)
+		gsh_iobuf_put(tconn->msg);
 
-	addrpeerlen = sizeof(_9p_conn.addrpeer);
-	rc = getpeername(tcp_sock, (struct sockaddr *)&_9p_conn.addrpeer,
-			 &addrpeerlen);
-	if (rc == -1) {
-		LogMajor(COMPONENT_9P,
-			 "Cannot get peername to tcp socket for 9p, error %d (%s)",
-			 errno, strerror(errno));
-		/* XXX */
-		strncpy(strcaller, "(unresolved)", INET6_ADDRSTRLEN);
-		strcaller[12] = '\0';
-	} else {
-		switch (_9p_conn.addrpeer.ss_family) {
-		case AF_INET:
-			inet_ntop(_9p_conn.addrpeer.ss_family,
-				  &((struct sockaddr_in *)&_9p_conn.addrpeer)->
-				  sin_addr, strcaller, INET6_ADDRSTRLEN);
-			break;
-		case AF_INET6:
-			inet_ntop(_9p_conn.addrpeer.ss_family,
-				  &((struct sockaddr_in6 *)&_9p_conn.addrpeer)->
-				  sin6_addr, strcaller, INET6_ADDRSTRLEN);
-			break;
-		default:
-			snprintf(strcaller, INET6_ADDRSTRLEN, "BAD ADDRESS");
-			break;
-		}
+	_9p_cleanup_fids(conn);
 
-		LogEvent(COMPONENT_9P, "9p socket #%ld is connected to %s",
-			 tcp_sock, strcaller);
-		printf("9p socket #%ld is connected to %s\n", tcp_sock,
-		       strcaller);
-	}
-	_9p_conn.client = get_gsh_client(&_9p_conn.addrpeer, false);
+	if (conn->client != NULL)
+		put_gsh_client(conn->client);
 
-	/* Set up the structure used by poll */
-	memset((char *)fds, 0, sizeof(struct pollfd));
-	fds[0].fd = tcp_sock;
-	fds[0].events =
-	    POLLIN | POLLPRI | POLLRDBAND | POLLRDNORM | POLLRDHUP | POLLHUP |
-	    POLLERR | POLLNVAL;
+	for (i = 0; i < FLUSH_BUCKETS; i++)
+		PTHREAD_MUTEX_destroy(&conn->flush_buckets[i].lock);
+	PTHREAD_MUTEX_destroy(&conn->sock_lock);
 
-	for (;;) {
-		total_readlen = 0;  /* new message */
-		rc = poll(fds, fdcount, -1);
-		if (rc == -1) {
-			/* timeout = -1 => Wait indefinitely for events */
-			/* Interruption if not an issue */
-			if (errno == EINTR)
-				continue;
+	gsh_free(tconn);
+}
 
-			LogCrit(COMPONENT_9P,
-				"Got error %u (%s) on fd %ld connect to %s while polling on socket",
-				errno, strerror(errno), tcp_sock, strcaller);
-		}
+/**
+ * @brief Hand a complete message to the workers
+ *
+ * @param[in,out] tconn The connection the message was read from
+ */
+static void _9p_tcp_dispatch(struct _9p_tcp_conn *tconn)
+{
+	request_data_t *req;
+	int tag;
 
-		if (fds[0].revents & POLLNVAL) {
-			LogEvent(COMPONENT_9P,
-				 "Client %s on socket %lu produced POLLNVAL",
-				 strcaller, tcp_sock);
-			goto end;
-		}
+	server_stats_transport_done(tconn->conn.client,
+				    tconn->msglen, 1, 0,
+				    0, 0, 0);
 
-		if (fds[0].revents & (POLLERR | POLLHUP | POLLRDHUP)) {
-			LogEvent(COMPONENT_9P,
-				 "Client %s on socket %lu has shut down and closed",
-				 strcaller, tcp_sock);
-			goto end;
-		}
+	req = pool_alloc(request_pool, NULL);
 
-		if (!(fds[0].revents & (POLLIN | POLLRDNORM)))
-			continue;
+	req->rtype = _9P_REQUEST;
+	req->r_u._9p._9pmsg = tconn->msg;
+	req->r_u._9p.pconn = &tconn->conn;
 
-		/* Prepare to read the message */
-		_9pmsg = gsh_malloc(_9p_conn.msize);
-		if (_9pmsg == NULL) {
-			LogCrit(COMPONENT_9P,
-				"Could not allocate 9pmsg buffer for client %s on socket %lu",
-				strcaller, tcp_sock);
-			goto end;
-		}
+	/* Add this request to the request list,
+	 * should it be flushed later. */
+	tag = *(u16 *) (tconn->msg + _9P_HDR_SIZE + _9P_TYPE_SIZE);
+	_9p_AddFlushHook(&req->r_u._9p, tag, tconn->conn.sequence++);
+	LogFullDebug(COMPONENT_9P, "Request tag is %d\n", tag);
 
-		/* An incoming 9P request: the msg has a 4 bytes header
-		   showing the size of the msg including the header */
-		readlen = recv(fds[0].fd, _9pmsg,
-			       _9P_HDR_SIZE, MSG_WAITALL);
-		if (readlen != _9P_HDR_SIZE)
-			goto badmsg;
-
-		msglen = *(uint32_t *) _9pmsg;
-		if (msglen > _9p_conn.msize) {
-			LogCrit(COMPONENT_9P,
-				"Message size too big! got %u, max = %u",
-				msglen, _9p_conn.msize);
-			goto end;
-		}
+	/* Message was OK push it */
+	DispatchWork9P(req);
 
-		LogFullDebug(COMPONENT_9P,
-			     "Received 9P/TCP message of size %u from client %s on socket %lu",
-			     msglen, strcaller, tcp_sock);
+	/* Not our buffer anymore */
+	tconn->msg = NULL;
+	tconn->readlen = 0;
+}
 
-		total_readlen += readlen;
-		while (total_readlen < msglen) {
-			readlen = recv(fds[0].fd,
-				       _9pmsg + total_readlen,
-				       msglen - total_readlen,
-				       0);
+/**
+ * @brief Read whatever a connection has for us
+ *
+ * The socket stays blocking for the workers sending replies, so reads
+ * here are done with MSG_DONTWAIT.  A partial message is kept in the
+ * connection until the rest arrives.
+ *
+ * @param[in,out] tconn The connection
+ *
+ * @return false if the connection must be closed.
+ */
+static bool _9p_tcp_read(struct _9p_tcp_conn *tconn)
+{
+	long int tcp_sock = tconn->conn.trans_data.sockfd;
+	int budget = _9P_TCP_READ_BUDGET;
+	ssize_t readlen;
+	uint32_t msglen;
 
-			if (readlen > 0) {
-				total_readlen += readlen;
+	while (budget > 0) {
+		if (tconn->msg == NULL) {
+			/* An incoming 9P request: the msg has a 4 bytes
+			 * header showing the size of the msg including
+			 * the header */
+			readlen = recv(tcp_sock, tconn->hdr + tconn->readlen,
+				       _9P_HDR_SIZE - tconn->readlen,
+				       MSG_DONTWAIT);
+			if (readlen <= 0)
+				goto check;
+
+			tconn->readlen += readlen;
+			if (tconn->readlen < _9P_HDR_SIZE)
 				continue;
+
+			msglen = *(uint32_t *) tconn->hdr;
+			if (msglen > tconn->conn.msize) {
+				LogCrit(COMPONENT_9P,
+					"Message size too big! got %u, max = %u",
+					msglen, tconn->conn.msize);
+				return false;
+			}
+
+			if (msglen < _9P_STD_HDR_SIZE) {
+				LogEvent(COMPONENT_9P,
+					 "Message too small! for client %s on socket %lu: msglen=%u expected=%u",
+					 tconn->strcaller, tcp_sock, msglen,
+					 _9P_STD_HDR_SIZE);
+				return false;
+			}
+
+			/* Prepare to read the message */
+			tconn->msg = gsh_iobuf_get(msglen);
+			if (tconn->msg == NULL) {
+				LogCrit(COMPONENT_9P,
+					"Could not allocate 9pmsg buffer for client %s on socket %lu",
+					tconn->strcaller, tcp_sock);
+				return false;
 			}
-			if (readlen == 0 ||
-			    (readlen < 0 && errno != EINTR))
-				goto badmsg;
-		}	/* while */
 
-		server_stats_transport_done(_9p_conn.client,
-					    total_readlen, 1, 0,
-					    0, 0, 0);
+			memcpy(tconn->msg, tconn->hdr, _9P_HDR_SIZE);
+			tconn->msglen = msglen;
+
+			LogFullDebug(COMPONENT_9P,
+				     "Received 9P/TCP message of size %u from client %s on socket %lu",
+				     msglen, tconn->strcaller, tcp_sock);
+			continue;
+		}
+
+		readlen = recv(tcp_sock, tconn->msg + tconn->readlen,
+			       tconn->msglen - tconn->readlen, MSG_DONTWAIT);
+		if (readlen <= 0)
+			goto check;
+
+		tconn->readlen += readlen;
+		if (tconn->readlen < tconn->msglen)
+			continue;
 
 		/* Message is good. */
-		req = pool_alloc(request_pool, NULL);
-
-		req->rtype = _9P_REQUEST;
-		req->r_u._9p._9pmsg = _9pmsg;
-		req->r_u._9p.pconn = &_9p_conn;
-
-		/* Add this request to the request list,
-		 * should it be flushed later. */
-		tag = *(u16 *) (_9pmsg + _9P_HDR_SIZE +
-				_9P_TYPE_SIZE);
-		_9p_AddFlushHook(&req->r_u._9p, tag,
-				 sequence++);
-		LogFullDebug(COMPONENT_9P,
-			     "Request tag is %d\n", tag);
-
-		/* Message was OK push it */
-		DispatchWork9P(req);
-
-		/* Not our buffer anymore */
-		_9pmsg = NULL;
+		_9p_tcp_dispatch(tconn);
+		budget--;
 		continue;
 
-badmsg:
-		if (readlen == 0)
+check:
+		if (readlen < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return true;
+
+		if (readlen < 0 && errno == EINTR)
+			continue;
+
+		if (readlen == 0 && tconn->msg == NULL && tconn->readlen == 0)
+			LogEvent(COMPONENT_9P,
+				 "Client %s on socket %lu has shut down and closed",
+				 tconn->strcaller, tcp_sock);
+		else if (readlen == 0)
 			LogEvent(COMPONENT_9P,
 				 "Premature end for Client %s on socket %lu, total read = %u",
-				 strcaller, tcp_sock, total_readlen);
-		else if (readlen < 0) {
+				 tconn->strcaller, tcp_sock, tconn->readlen);
+		else
 			LogEvent(COMPONENT_9P,
 				 "Read error client %s on socket %lu errno=%d, total read = %u",
-				 strcaller, tcp_sock,
-				 errno, total_readlen);
-		} else
-			LogEvent(COMPONENT_9P,
-				 "Header too small! for client %s on socket %lu: readlen=%u expected=%u",
-				 strcaller, tcp_sock, readlen,
-				 _9P_HDR_SIZE);
+				 tconn->strcaller, tcp_sock, errno,
+				 tconn->readlen);
 
 		/* Either way, we close the connection.
 		 * It is not possible to survive
 		 * once we get out of sync in the TCP stream
 		 * with the client
 		 */
-		break; /* bail out */
-	}			/* for( ;; ) */
+		return false;
+	}
 
-end:
-	LogEvent(COMPONENT_9P, "Closing connection on socket %lu", tcp_sock);
-	close(tcp_sock);
+	/* More may be waiting, epoll will tell us again */
+	return true;
+}
 
-	/* Free buffer if we encountered an error
-	 * before we could give it to a worker */
-	if (_9pmsg)
-		gsh_free(_9pmsg);
+/**
+ * @brief Main loop of a 9P/TCP event loop thread
+ *
+ * Reads requests from all the connections on its epoll instance and
+ * queues them for the workers.
+ *
+ * @param[in] arg The event loop
+ *
+ * @return NULL, but never returns.
+ */
+static void *_9p_event_loop_thread(void *arg)
+{
+	struct _9p_event_loop *loop = arg;
+	struct epoll_event events[_9P_TCP_EPOLL_EVENTS];
+	struct _9p_tcp_conn *tconn;
+	char my_name[MAXNAMLEN + 1];
+	bool keep;
+	int nevents, i;
+
+	snprintf(my_name, MAXNAMLEN, "9p_loop#%ld",
+		 (long int)(loop - _9p_event_loops));
+	SetNameFunction(my_name);
+
+	for (;;) {
+		nevents = epoll_wait(loop->epfd, events,
+				     _9P_TCP_EPOLL_EVENTS, -1);
+		if (nevents == -1) {
+			/* Interruption if not an issue */
+			if (errno != EINTR)
+				LogCrit(COMPONENT_9P,
+					"Got error %u (%s) while waiting for 9P/TCP events",
+					errno, strerror(errno));
+			continue;
+		}
+
+		for (i = 0; i < nevents; i++) {
+			tconn = events[i].data.ptr;
+
+			/* Take what was sent before any hang up */
+			if (events[i].events & EPOLLIN)
+				keep = _9p_tcp_read(tconn);
+			else
+				keep = !(events[i].events &
+					 (EPOLLERR | EPOLLHUP | EPOLLRDHUP));
 
-	while (atomic_fetch_uint32_t(&_9p_conn.refcount)) {
-		LogEvent(COMPONENT_9P, "Waiting for workers to release pconn");
-		sleep(1);
+			if (keep)
+				continue;
+
+			(void)epoll_ctl(loop->epfd, EPOLL_CTL_DEL,
+					tconn->conn.trans_data.sockfd, NULL);
+			_9p_tcp_conn_put(&tconn->conn);
+		}
 	}
 
-	_9p_cleanup_fids(&_9p_conn);
+	return NULL;
+}
+
+/**
+ * @brief Start the 9P/TCP event loop threads
+ *
+ * @param[in] attr_thr Thread attributes
+ */
+static void _9p_start_event_loops(pthread_attr_t *attr_thr)
+{
+	struct _9p_event_loop *loop;
+	uint32_t i;
+	int rc;
+
+	_9p_event_loops = gsh_calloc(_9p_param._9p_tcp_event_loops,
+				     sizeof(*_9p_event_loops));
+	if (_9p_event_loops == NULL)
+		LogFatal(COMPONENT_9P_DISPATCH,
+			 "Could not allocate 9P event loops");
 
-	if (_9p_conn.client != NULL)
-		put_gsh_client(_9p_conn.client);
+	for (i = 0; i < _9p_param._9p_tcp_event_loops; i++) {
+		loop = &_9p_event_loops[i];
 
-	pthread_exit(NULL);
-}				/* _9p_socket_thread */
+		loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+		if (loop->epfd == -1)
+			LogFatal(COMPONENT_9P_DISPATCH,
+				 "Could not create 9P epoll instance, error %d (%s)",
+				 errno, strerror(errno));
+
+		rc = pthread_create(&loop->thrid, attr_thr,
+				    _9p_event_loop_thread, loop);
+		if (rc != 0)
+			LogFatal(COMPONENT_THREAD,
+				 "Could not create 9p event loop thread, error = %d (%s)",
+				 rc, strerror(rc));
+	}
+}
+
+/**
+ * @brief Set up a new 9P/TCP connection and give it to an event loop
+ *
+ * @param[in] tcp_sock The accepted socket
+ */
+static void _9p_tcp_conn_add(long int tcp_sock)
+{
+	struct _9p_tcp_conn *tconn;
+	struct _9p_conn *conn;
+	struct _9p_event_loop *loop;
+	struct epoll_event event;
+	socklen_t addrpeerlen;
+	unsigned int i;
+	int rc;
+
+	tconn = gsh_calloc(1, sizeof(*tconn));
+	if (tconn == NULL) {
+		LogCrit(COMPONENT_9P,
+			"Could not allocate 9P connection for socket %ld",
+			tcp_sock);
+		close(tcp_sock);
+		return;
+	}
+
+	/* Init the struct _9p_conn structure, with the event loop's
+	 * reference */
+	conn = &tconn->conn;
+	PTHREAD_MUTEX_init(&conn->sock_lock, NULL);
+	conn->trans_type = _9P_TCP;
+	conn->trans_data.sockfd = tcp_sock;
+	for (i = 0; i < FLUSH_BUCKETS; i++) {
+		PTHREAD_MUTEX_init(&conn->flush_buckets[i].lock, NULL);
+		glist_init(&conn->flush_buckets[i].list);
+	}
+	atomic_store_uint32_t(&conn->refcount, 1);
+
+	/* Set initial msize.
+	 * Client may request a lower value during TVERSION */
+	conn->msize = _9p_param._9p_tcp_msize;
+
+	if (gettimeofday(&conn->birth, NULL) == -1)
+		LogFatal(COMPONENT_9P, "Cannot get connection's time of birth");
+
+	addrpeerlen = sizeof(conn->addrpeer);
+	rc = getpeername(tcp_sock, (struct sockaddr *)&conn->addrpeer,
+			 &addrpeerlen);
+	if (rc == -1) {
+		LogMajor(COMPONENT_9P,
+			 "Cannot get peername to tcp socket for 9p, error %d (%s)",
+			 errno, strerror(errno));
+		strcpy(tconn->strcaller, "(unresolved)");
+	} else {
+		switch (conn->addrpeer.ss_family) {
+		case AF_INET:
+			inet_ntop(conn->addrpeer.ss_family,
+				  &((struct sockaddr_in *)&conn->addrpeer)->
+				  sin_addr, tconn->strcaller, INET6_ADDRSTRLEN);
+			break;
+		case AF_INET6:
+			inet_ntop(conn->addrpeer.ss_family,
+				  &((struct sockaddr_in6 *)&conn->addrpeer)->
+				  sin6_addr, tconn->strcaller,
+				  INET6_ADDRSTRLEN);
+			break;
+		default:
+			snprintf(tconn->strcaller, INET6_ADDRSTRLEN,
+				 "BAD ADDRESS");
+			break;
+		}
+
+		LogEvent(COMPONENT_9P, "9p socket #%ld is connected to %s",
+			 tcp_sock, tconn->strcaller);
+	}
+	conn->client = get_gsh_client(&conn->addrpeer, false);
+
+	/* Spread connections over the event loops */
+	loop = &_9p_event_loops[_9p_next_event_loop++ %
+				_9p_param._9p_tcp_event_loops];
+
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | EPOLLRDHUP;
+	event.data.ptr = tconn;
+
+	if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, tcp_sock, &event) == -1) {
+		LogCrit(COMPONENT_9P,
+			"Could not poll 9P socket %ld, error %d (%s)",
+			tcp_sock, errno, strerror(errno));
+		_9p_tcp_conn_put(conn);
+	}
+}
 
 /**
  * _9p_create_socket_V4 : create the socket and bind for 9P using
@@ -553,12 +710,10 @@ err:
 void *_9p_dispatcher_thread(void *Arg)
 {
 	int _9p_socket;
-	int rc = 0;
 	struct sockaddr_in addr;
 	socklen_t addrlen = sizeof(addr);
 	long int newsock = -1;
 	pthread_attr_t attr_thr;
-	pthread_t tcp_thrid;
 
 	SetNameFunction("_9p_disp");
 
@@ -591,6 +746,8 @@ void *_9p_dispatcher_thread(void *Arg)
 		LogDebug(COMPONENT_9P_DISPATCH,
 			 "can't set pthread's join state");
 
+	_9p_start_event_loops(&attr_thr);
+
 	LogEvent(COMPONENT_9P_DISPATCH, "9P dispatcher started");
 
 	while (true) {
@@ -603,14 +760,7 @@ void *_9p_dispatcher_thread(void *Arg)
 			continue;
 		}
 
-		/* Starting the thread dedicated to signal handling */
-		rc = pthread_create(&tcp_thrid, &attr_thr,
-				    _9p_socket_thread, (void *)newsock);
-		if (rc != 0) {
-			LogFatal(COMPONENT_THREAD,
-				 "Could not create 9p socket manager thread, error = %d (%s)",
-				 errno, strerror(errno));
-		}
+		_9p_tcp_conn_add(newsock);
 	}			/* while */
 
 	close(_9p_socket);
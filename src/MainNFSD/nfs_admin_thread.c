@@ -42,6 +42,8 @@
 #include "delayed_exec.h"
 #include "export_mgr.h"
 #include "fsal.h"
+#include "nsm.h"
+#include "nfs_proto_functions.h"
 #ifdef USE_DBUS
 #include "gsh_dbus.h"
 #endif
@@ -331,6 +333,18 @@ static void do_shutdown(void)
 			 "State asynchronous request system shut down.");
 	}
 
+	if (nfs_param.core_param.enable_NLM) {
+		LogEvent(COMPONENT_MAIN, "Stopping NSM thread");
+		rc = nsm_shutdown();
+		if (rc != 0) {
+			LogMajor(COMPONENT_THREAD,
+				 "Error shutting down NSM thread: %d", rc);
+			disorderly = true;
+		} else {
+			LogEvent(COMPONENT_THREAD, "NSM thread shut down.");
+		}
+	}
+
 	LogEvent(COMPONENT_MAIN, "Stopping request listener threads.");
 	nfs_rpc_dispatch_stop();
 
@@ -364,6 +378,15 @@ static void do_shutdown(void)
 			 "Worker threads successfully shut down.");
 	}
 
+	rc = nfs4_copy_shutdown();
+	if (rc != 0) {
+		LogMajor(COMPONENT_THREAD,
+			 "Error shutting down copy threads: %d", rc);
+		disorderly = true;
+	} else {
+		LogEvent(COMPONENT_THREAD, "Copy threads shut down.");
+	}
+
 	/* finalize RPC package */
 	Clean_RPC(); /* we MUST do this first */
 	(void)svc_shutdown(SVC_SHUTDOWN_FLAG_NONE);
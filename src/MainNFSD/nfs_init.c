@@ -64,6 +64,9 @@
 #include "delayed_exec.h"
 #include "client_mgr.h"
 #include "export_mgr.h"
+#include "server_stats.h"
+#include "gsh_iobuf.h"
+#include "gsh_slab.h"
 #ifdef USE_CAPS
 #include <sys/capability.h>	/* For capget/capset */
 #endif
@@ -133,7 +136,9 @@ void *sigmgr_thread(void *UnusedArg)
 			LogEvent(COMPONENT_MAIN,
 				 "SIGHUP_HANDLER: Received SIGHUP.... initiating export list reload");
 			admin_replace_exports();
+			export_flush_access_cache();
 			reread_log_config();
+			log_reopen_files();
 			svcauth_gss_release_cred();
 		}
 	}
@@ -488,6 +493,15 @@ static void nfs_Start_threads(void)
 	}
 	LogEvent(COMPONENT_THREAD, "General fridge was started successfully");
 
+	/* Starting the threads running asynchronous COPYs */
+	rc = nfs4_copy_init();
+	if (rc != 0) {
+		LogFatal(COMPONENT_THREAD,
+			 "Could not create copy fridge, error = %d (%s)",
+			 rc, strerror(rc));
+	}
+	LogEvent(COMPONENT_THREAD, "Copy fridge was started successfully");
+
 }
 
 /**
@@ -505,6 +519,9 @@ static void nfs_Init(const nfs_start_info_t *p_start_info)
 	char GssError[MAXNAMLEN + 1];
 #endif
 
+	/* Stats shards, before anything can count or report */
+	server_stats_init();
+
 #ifdef USE_DBUS
 	/* DBUS init */
 	gsh_dbus_pkginit();
@@ -539,7 +556,7 @@ static void nfs_Init(const nfs_start_info_t *p_start_info)
 
 	request_pool =
 	    pool_init("Request pool", sizeof(request_data_t),
-		      pool_basic_substrate, NULL,
+		      pool_slab_substrate, NULL,
 		      NULL /* FASTER constructor_request_data_t */ ,
 		      NULL);
 	if (!request_pool)
@@ -548,20 +565,13 @@ static void nfs_Init(const nfs_start_info_t *p_start_info)
 
 	request_data_pool =
 	    pool_init("Request Data Pool", sizeof(nfs_request_data_t),
-		      pool_basic_substrate, NULL,
+		      pool_slab_substrate, NULL,
 		      NULL /* FASTER constructor_nfs_request_data_t */ ,
 		      NULL);
 	if (!request_data_pool)
 		LogFatal(COMPONENT_INIT,
 			"Error while allocating request data pool");
 
-	dupreq_pool =
-	    pool_init("Duplicate Request Pool", sizeof(dupreq_entry_t),
-		      pool_basic_substrate, NULL, NULL, NULL);
-	if (!(dupreq_pool))
-		LogFatal(COMPONENT_INIT,
-			"Error while allocating duplicate request pool");
-
 	/* If rpcsec_gss is used, set the path to the keytab */
 #ifdef _HAVE_GSSAPI
 #ifdef HAVE_KRB5
@@ -640,6 +650,11 @@ static void nfs_Init(const nfs_start_info_t *p_start_info)
 	LogInfo(COMPONENT_INIT,
 		"NFSv4 clientid cache successfully initialized");
 
+	/* Init the READ payload buffer pool */
+	if (gsh_iobuf_init(nfs_param.core_param.read_buffer_cache) != 0)
+		LogFatal(COMPONENT_INIT,
+			 "Error while initializing READ buffer pool");
+
 	/* Init duplicate request cache */
 	dupreq2_pkginit();
 	LogInfo(COMPONENT_INIT,
@@ -673,6 +688,11 @@ static void nfs_Init(const nfs_start_info_t *p_start_info)
 		LogInfo(COMPONENT_INIT,
 			"NLM Owner cache successfully initialized");
 		nlm_init();
+		rc = nsm_init();
+		if (rc != 0) {
+			LogFatal(COMPONENT_INIT,
+				 "Unable to start NSM thread: %d.", rc);
+		}
 	}
 #ifdef _USE_9P
 	/* Init the 9P lock owner cache */
@@ -34,6 +34,7 @@
 #include "nfs_core.h"
 #include "log.h"
 #include "fridgethr.h"
+#include "nfs_dupreq.h"
 
 #define REAPER_DELAY 10
 
@@ -41,183 +42,72 @@ unsigned int reaper_delay = REAPER_DELAY;
 
 static struct fridgethr *reaper_fridge;
 
-static int reap_expired_open_owners(hash_table_t *ht_reap)
-{
-	struct rbt_head *head_rbt;
-	struct hash_data *addr = NULL;
-	uint32_t i;
-	int rc;
-	struct rbt_node *pn;
-	int count = 0;
-	char str[LOG_BUFF_LEN];
-	struct display_buffer dspbuf = {
-			sizeof(str), str, str};
-	state_owner_t *powner;
-	time_t tnow, tclose, texpire;
-	struct gsh_buffdesc buffkey;
-	struct gsh_buffdesc old_value;
-	struct gsh_buffdesc old_key;
-
-	/* For each bucket of the requested hashtable */
-	for (i = 0; i < ht_reap->parameter.index_size; i++) {
-		head_rbt = &ht_reap->partitions[i].rbt;
-
- restart:
-		/* Use the time at the start or restart of a bucket to
-		 * check for validity (don't call time() too many times).
-		 */
-		tnow = time(NULL);
-
-		/* acquire mutex */
-		PTHREAD_RWLOCK_wrlock(&ht_reap->partitions[i].lock);
-
-		/* go through all entries in the red-black-tree */
-		RBT_LOOP(head_rbt, pn) {
-			addr = RBT_OPAQ(pn);
-
-
-			powner = addr->val.addr;
-			count++;
-
-			if (powner->so_type != STATE_OPEN_OWNER_NFSV4) {
-				RBT_INCREMENT(pn);
-				continue;
-			}
-
-			display_owner(&dspbuf, powner);
-
-			/* Cleanup the open owner only if its refcount is zero
-			 * and its last_close_time exceeds the lease_lifetime
-			 */
-			tclose = atomic_fetch_time_t(&powner->so_owner.
-						     so_nfs4_owner.
-						     last_close_time);
-			texpire = tclose + nfs_param.nfsv4_param.lease_lifetime;
-
-			if ((tclose == 0) || (texpire > tnow)) {
-				if (tclose != 0 &&
-					isFullDebug(COMPONENT_STATE)) {
-					LogFullDebug(COMPONENT_STATE,
-							"Did not release CLOSE_PENDING %s, %d seconds left",
-							str,
-							(int) (texpire - tnow));
-				}
-				RBT_INCREMENT(pn);
-				continue;
-			}
-			LogFullDebug(COMPONENT_STATE, "Free {%s}", str);
-			buffkey.addr = powner;
-			buffkey.len = sizeof(*powner);
-
-			atomic_inc_int32_t(&powner->so_refcount);
-			PTHREAD_RWLOCK_unlock(&ht_reap->partitions[i].
-					      lock);
-			rc = HashTable_Del(ht_reap, &buffkey,
-					   &old_key, &old_value);
-
-			if (rc != HASHTABLE_SUCCESS) {
-				LogCrit(COMPONENT_CLIENTID,
-					"Could not remove expired owner %s"
-					" error=%s", str,
-					hash_table_err_to_str(rc));
-			}
-
-			atomic_dec_int32_t(&powner->so_refcount);
-			free_state_owner(powner);
-			goto restart;
-
-		}
-		PTHREAD_RWLOCK_unlock(&ht_reap->partitions[i].lock);
-	}
-
-	return count;
-}
-
-static int reap_hash_table(hash_table_t *ht_reap)
+/**
+ * @brief Expire the clients whose lease timers have fired
+ *
+ * @return The number of lease timers that fired.
+ */
+static int reap_expired_leases(void)
 {
-	struct rbt_head *head_rbt;
-	struct hash_data *addr = NULL;
-	uint32_t i;
-	int rc;
-	struct rbt_node *pn;
 	nfs_client_id_t *pclientid;
 	nfs_client_record_t *precord;
+	time_t tnow = time(NULL);
 	int count = 0;
 
-	/* For each bucket of the requested hashtable */
-	for (i = 0; i < ht_reap->parameter.index_size; i++) {
-		head_rbt = &ht_reap->partitions[i].rbt;
-
- restart:
-		/* acquire mutex */
-		PTHREAD_RWLOCK_wrlock(&ht_reap->partitions[i].lock);
-
-		/* go through all entries in the red-black-tree */
-		RBT_LOOP(head_rbt, pn) {
-			addr = RBT_OPAQ(pn);
-
-			pclientid = addr->val.addr;
-			count++;
-
-			PTHREAD_MUTEX_lock(&pclientid->cid_mutex);
-
-			if (!valid_lease(pclientid)) {
-				char str[LOG_BUFF_LEN];
-				struct display_buffer dspbuf = {
-					sizeof(str), str, str};
-				bool str_valid = false;
+	/* Each client comes with the reference its timer held */
+	while ((pclientid = get_lease_timer_fired(tnow)) != NULL) {
+		char str[LOG_BUFF_LEN];
+		struct display_buffer dspbuf = {sizeof(str), str, str};
+		bool str_valid = false;
 
-				inc_client_id_ref(pclientid);
+		count++;
 
-				/* Take a reference to the client record */
-				precord = pclientid->cid_client_record;
-				inc_client_record_ref(precord);
+		PTHREAD_MUTEX_lock(&pclientid->cid_mutex);
 
-				PTHREAD_MUTEX_unlock(&pclientid->cid_mutex);
-
-				PTHREAD_RWLOCK_unlock(&ht_reap->partitions[i].
-						      lock);
+		if (pclientid->cid_confirmed == EXPIRED_CLIENT_ID) {
+			/* Expired by someone else */
+			PTHREAD_MUTEX_unlock(&pclientid->cid_mutex);
+			dec_client_id_ref(pclientid);
+			continue;
+		}
 
-				if (isDebug(COMPONENT_CLIENTID)) {
-					display_client_id_rec(&dspbuf,
-							      pclientid);
+		if (valid_lease(pclientid)) {
+			/* Renewed since the timer was set */
+			start_lease_timer(pclientid);
+			PTHREAD_MUTEX_unlock(&pclientid->cid_mutex);
+			dec_client_id_ref(pclientid);
+			continue;
+		}
 
-					LogFullDebug(COMPONENT_CLIENTID,
-						     "Expire index %d %s", i,
-						     str);
-					str_valid = true;
-				}
+		/* Take a reference to the client record */
+		precord = pclientid->cid_client_record;
+		inc_client_record_ref(precord);
 
-				/* Take cr_mutex and expire clientid */
-				PTHREAD_MUTEX_lock(&precord->cr_mutex);
+		PTHREAD_MUTEX_unlock(&pclientid->cid_mutex);
 
-				rc = nfs_client_id_expire(pclientid, false);
+		if (isDebug(COMPONENT_CLIENTID)) {
+			display_client_id_rec(&dspbuf, pclientid);
+			LogFullDebug(COMPONENT_CLIENTID, "Expire %s", str);
+			str_valid = true;
+		}
 
-				PTHREAD_MUTEX_unlock(&precord->cr_mutex);
+		/* Take cr_mutex and expire clientid */
+		PTHREAD_MUTEX_lock(&precord->cr_mutex);
 
-				dec_client_id_ref(pclientid);
-				dec_client_record_ref(precord);
+		(void)nfs_client_id_expire(pclientid, false);
 
-				if (isFullDebug(COMPONENT_CLIENTID)) {
-					if (!str_valid)
-						display_printf(&dspbuf,
-							       "clientid %p",
-							       pclientid);
-					LogFullDebug(COMPONENT_CLIENTID,
-						     "Reaper done, expired {%s}",
-						     str);
-				}
+		PTHREAD_MUTEX_unlock(&precord->cr_mutex);
 
-				if (rc)
-					goto restart;
-			} else {
-				PTHREAD_MUTEX_unlock(&pclientid->cid_mutex);
-			}
+		dec_client_id_ref(pclientid);
+		dec_client_record_ref(precord);
 
-			RBT_INCREMENT(pn);
+		if (isFullDebug(COMPONENT_CLIENTID)) {
+			if (!str_valid)
+				display_printf(&dspbuf, "clientid %p",
+					       pclientid);
+			LogFullDebug(COMPONENT_CLIENTID,
+				     "Reaper done, expired {%s}", str);
 		}
-
-		PTHREAD_RWLOCK_unlock(&ht_reap->partitions[i].lock);
 	}
 
 	return count;
@@ -266,11 +156,10 @@ static void reaper_run(struct fridgethr_context *ctx)
 #endif
 	}
 
-	rst->count =
-	    (reap_hash_table(ht_confirmed_client_id) +
-	     reap_hash_table(ht_unconfirmed_client_id));
+	rst->count = reap_expired_leases();
+	rst->count += reap_expired_open_owners();
 
-	rst->count += reap_expired_open_owners(ht_nfs4_owner);
+	dupreq2_free_expired();
 }
 
 int reaper_init(void)
@@ -68,17 +68,22 @@
  * @param reply   the message reply
  */
 
+static bool cbsim_append_client_id(struct gsh_buffdesc *key,
+				   struct gsh_buffdesc *val,
+				   void *arg)
+{
+	DBusMessageIter *sub_iter = arg;
+	nfs_client_id_t *pclientid = val->addr;
+	uint64_t clientid = pclientid->cid_clientid;
+
+	dbus_message_iter_append_basic(sub_iter, DBUS_TYPE_UINT64, &clientid);
+	return true;
+}
+
 static bool nfs_rpc_cbsim_get_v40_client_ids(DBusMessageIter *args,
 					     DBusMessage *reply,
 					     DBusError *error)
 {
-	uint32_t i;
-	hash_table_t *ht = ht_confirmed_client_id;
-	struct rbt_head *head_rbt;
-	struct hash_data *pdata = NULL;
-	struct rbt_node *pn;
-	nfs_client_id_t *pclientid;
-	uint64_t clientid;
 	DBusMessageIter iter, sub_iter;
 	struct timespec ts;
 
@@ -89,25 +94,8 @@ static bool nfs_rpc_cbsim_get_v40_client_ids(DBusMessageIter *args,
 
 	dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
 					 DBUS_TYPE_UINT64_AS_STRING, &sub_iter);
-	/* For each bucket of the hashtable */
-	for (i = 0; i < ht->parameter.index_size; i++) {
-		head_rbt = &(ht->partitions[i].rbt);
-
-		/* acquire mutex */
-		PTHREAD_RWLOCK_wrlock(&(ht->partitions[i].lock));
-
-		/* go through all entries in the red-black-tree */
-		RBT_LOOP(head_rbt, pn) {
-			pdata = RBT_OPAQ(pn);
-			pclientid = pdata->val.addr;
-			clientid = pclientid->cid_clientid;
-			dbus_message_iter_append_basic(&sub_iter,
-						       DBUS_TYPE_UINT64,
-						       &clientid);
-			RBT_INCREMENT(pn);
-		}
-		PTHREAD_RWLOCK_unlock(&(ht->partitions[i].lock));
-	}
+	hashtable_for_each(ht_confirmed_client_id, cbsim_append_client_id,
+			   &sub_iter);
 	dbus_message_iter_close_container(&iter, &sub_iter);
 	return true;
 }
@@ -138,17 +126,28 @@ static struct gsh_dbus_method cbsim_get_client_ids = {
  * @param reply   the message reply
  */
 
+static bool cbsim_append_session_id(struct gsh_buffdesc *key,
+				    struct gsh_buffdesc *val,
+				    void *arg)
+{
+	DBusMessageIter *sub_iter = arg;
+	nfs41_session_t *session_data = val->addr;
+	char session_id[2 * NFS4_SESSIONID_SIZE];	/* guaranteed to fit */
+	char *session_str = session_id;
+
+	/* format */
+	b64_ntop((unsigned char *)session_data->session_id,
+		 NFS4_SESSIONID_SIZE, session_id,
+		 (2 * NFS4_SESSIONID_SIZE));
+	dbus_message_iter_append_basic(sub_iter, DBUS_TYPE_STRING,
+				       &session_str);
+	return true;
+}
+
 static bool nfs_rpc_cbsim_get_session_ids(DBusMessageIter *args,
 					  DBusMessage *reply,
 					  DBusError *error)
 {
-	uint32_t i;
-	hash_table_t *ht = ht_session_id;
-	struct rbt_head *head_rbt;
-	struct hash_data *pdata = NULL;
-	struct rbt_node *pn;
-	char session_id[2 * NFS4_SESSIONID_SIZE];	/* guaranteed to fit */
-	nfs41_session_t *session_data;
 	DBusMessageIter iter, sub_iter;
 	struct timespec ts;
 
@@ -158,29 +157,11 @@ static bool nfs_rpc_cbsim_get_session_ids(DBusMessageIter *args,
 	dbus_append_timestamp(&iter, &ts);
 
 	dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
-					 DBUS_TYPE_UINT64_AS_STRING, &sub_iter);
-	/* For each bucket of the hashtable */
-	for (i = 0; i < ht->parameter.index_size; i++) {
-		head_rbt = &(ht->partitions[i].rbt);
-
-		/* acquire mutex */
-		PTHREAD_RWLOCK_wrlock(&(ht->partitions[i].lock));
-
-		/* go through all entries in the red-black-tree */
-		RBT_LOOP(head_rbt, pn) {
-			pdata = RBT_OPAQ(pn);
-			session_data = pdata->val.addr;
-			/* format */
-			b64_ntop((unsigned char *)session_data->session_id,
-				 NFS4_SESSIONID_SIZE, session_id,
-				 (2 * NFS4_SESSIONID_SIZE));
-			dbus_message_iter_append_basic(&sub_iter,
-						       DBUS_TYPE_STRING,
-						       &session_id);
-			RBT_INCREMENT(pn);
-		}
-		PTHREAD_RWLOCK_unlock(&(ht->partitions[i].lock));
-	}
+					 DBUS_TYPE_STRING_AS_STRING, &sub_iter);
+	/* The session table is open addressed, so it has to be walked
+	 * through the table API rather than its partitions' trees. */
+	hashtable_for_each(ht_session_id, cbsim_append_session_id,
+			   &sub_iter);
 	dbus_message_iter_close_container(&iter, &sub_iter);
 	return true;
 }
@@ -198,7 +179,7 @@ static struct gsh_dbus_method cbsim_get_session_ids = {
 		  .direction = "out"},
 		 {
 		  .name = "sessionids",
-		  .type = "at",
+		  .type = "as",
 		  .direction = "out"},
 		 {NULL, NULL, NULL}
 		 }
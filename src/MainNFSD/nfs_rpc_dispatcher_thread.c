@@ -36,6 +36,8 @@
 #include <sys/file.h>		/* for having FNDELAY */
 #include <sys/select.h>
 #include <poll.h>
+#include <sched.h>
+#include <unistd.h>
 #include <assert.h>
 #include "hashtable.h"
 #include "log.h"
@@ -56,6 +58,8 @@
 #include "nfs_dupreq.h"
 #include "nfs_file_handle.h"
 #include "fridgethr.h"
+#include "client_mgr.h"
+#include "server_stats.h"
 
 /**
  * TI-RPC event channels.  Each channel is a thread servicing an event
@@ -83,9 +87,13 @@ const char *req_q_s[N_REQ_QUEUES] = {
 	"REQ_Q_MOUNT",
 	"REQ_Q_CALL",
 	"REQ_Q_LOW_LATENCY",
-	"REQ_Q_HIGH_LATENCY"
+	"REQ_Q_HIGH_LATENCY",
+	"REQ_Q_BULK"
 };
 
+/** Deficit round robin quantum of each request class */
+static int32_t req_q_weight[N_REQ_QUEUES];
+
 static u_int nfs_rpc_rdvs(SVCXPRT *xprt, SVCXPRT *newxprt, const u_int flags,
 			  void *u_data);
 static bool nfs_rpc_getreq_ng(SVCXPRT *xprt /*, int chan_id */);
@@ -986,6 +994,10 @@ static u_int nfs_rpc_rdvs(SVCXPRT *xprt, SVCXPRT *newxprt, const u_int flags,
  */
 static void nfs_rpc_free_xprt(SVCXPRT *xprt)
 {
+	gsh_xprt_private_t *xu = (gsh_xprt_private_t *) xprt->xp_u1;
+
+	if (xu != NULL && xu->client != NULL)
+		put_gsh_client(xu->client);
 	free_gsh_xprt_private(xprt);
 }
 
@@ -1011,7 +1023,7 @@ uint32_t nfs_rpc_outstanding_reqs_est(void)
 	static uint32_t nreqs;
 	struct req_q_pair *qpair;
 	uint32_t treqs;
-	int ix;
+	uint32_t ix;
 
 	if ((atomic_inc_uint32_t(&ctr) % 10) != 0)
 		return atomic_fetch_uint32_t(&nreqs);
@@ -1022,6 +1034,13 @@ uint32_t nfs_rpc_outstanding_reqs_est(void)
 		treqs += atomic_fetch_uint32_t(&qpair->producer.size);
 		treqs += atomic_fetch_uint32_t(&qpair->consumer.size);
 	}
+	for (ix = 0; ix < nfs_req_st.reqs.n_shards; ++ix) {
+		int lane;
+
+		for (lane = 0; lane < N_REQ_QUEUES; ++lane)
+			treqs += gsh_ring_depth(
+				&nfs_req_st.reqs.shards[ix].lane[lane]);
+	}
 
 	atomic_store_uint32_t(&nreqs, treqs);
 	return treqs;
@@ -1150,8 +1169,11 @@ void nfs_rpc_queue_init(void)
 {
 	struct fridgethr_params reqparams;
 	struct req_q_pair *qpair;
+	struct req_q_shard *shard;
+	uint32_t n_shards, ix;
+	long ncpu;
 	int rc = 0;
-	int ix;
+	int lane;
 
 	memset(&reqparams, 0, sizeof(struct fridgethr_params));
     /**
@@ -1171,16 +1193,61 @@ void nfs_rpc_queue_init(void)
 		LogFatal(COMPONENT_DISPATCH,
 			 "Unable to initialize decoder thread pool: %d", rc);
 
-	/* queues */
+	/* overflow queues */
 	pthread_spin_init(&nfs_req_st.reqs.sp, PTHREAD_PROCESS_PRIVATE);
 	nfs_req_st.reqs.size = 0;
-	for (ix = 0; ix < N_REQ_QUEUES; ++ix) {
-		qpair = &(nfs_req_st.reqs.nfs_request_q.qset[ix]);
-		qpair->s = req_q_s[ix];
+	nfs_req_st.reqs.overflowed = 0;
+	for (lane = 0; lane < N_REQ_QUEUES; ++lane) {
+		qpair = &(nfs_req_st.reqs.nfs_request_q.qset[lane]);
+		qpair->s = req_q_s[lane];
 		nfs_rpc_q_init(&qpair->producer);
 		nfs_rpc_q_init(&qpair->consumer);
 	}
 
+	/* shards */
+	n_shards = nfs_param.core_param.dispatch_queue_shards;
+	if (n_shards == 0) {
+		ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		n_shards = (ncpu > 0) ? ncpu : 1;
+	}
+	if (n_shards > nfs_param.core_param.nb_worker)
+		n_shards = nfs_param.core_param.nb_worker;
+
+	nfs_req_st.reqs.shards =
+	    gsh_malloc_aligned(CACHE_LINE_SIZE,
+			       n_shards * sizeof(struct req_q_shard));
+	if (nfs_req_st.reqs.shards == NULL)
+		LogFatal(COMPONENT_DISPATCH,
+			 "Unable to allocate request queue shards");
+	memset(nfs_req_st.reqs.shards, 0,
+	       n_shards * sizeof(struct req_q_shard));
+
+	for (ix = 0; ix < n_shards; ++ix) {
+		shard = &nfs_req_st.reqs.shards[ix];
+		for (lane = 0; lane < N_REQ_QUEUES; ++lane) {
+			rc = gsh_ring_init(&shard->lane[lane],
+				nfs_param.core_param.dispatch_queue_depth);
+			if (rc != 0)
+				LogFatal(COMPONENT_DISPATCH,
+					 "Unable to allocate request lane: %d",
+					 rc);
+		}
+	}
+	nfs_req_st.reqs.n_shards = n_shards;
+
+	LogInfo(COMPONENT_DISPATCH,
+		"%u request queue shards, %u slots per lane", n_shards,
+		nfs_param.core_param.dispatch_queue_depth);
+
+	/* scheduler weights */
+	req_q_weight[REQ_Q_MOUNT] = nfs_param.core_param.dispatch_weight.mount;
+	req_q_weight[REQ_Q_CALL] = nfs_param.core_param.dispatch_weight.call;
+	req_q_weight[REQ_Q_LOW_LATENCY] =
+		nfs_param.core_param.dispatch_weight.low_latency;
+	req_q_weight[REQ_Q_HIGH_LATENCY] =
+		nfs_param.core_param.dispatch_weight.high_latency;
+	req_q_weight[REQ_Q_BULK] = nfs_param.core_param.dispatch_weight.bulk;
+
 	/* waitq */
 	glist_init(&nfs_req_st.reqs.wait_list);
 	nfs_req_st.reqs.waiters = 0;
@@ -1192,24 +1259,170 @@ void nfs_rpc_queue_init(void)
 	nfs_req_st.stallq.stalled = 0;
 }
 
-static uint32_t enqueued_reqs;
-static uint32_t dequeued_reqs;
-
 uint32_t get_enqueue_count()
 {
-	return enqueued_reqs;
+	struct nfs_req_q_stats stats;
+
+	nfs_rpc_queue_stats(&stats);
+	return stats.enqueued;
 }
 
 uint32_t get_dequeue_count()
 {
-	return dequeued_reqs;
+	struct nfs_req_q_stats stats;
+
+	nfs_rpc_queue_stats(&stats);
+	return stats.dequeued;
+}
+
+/**
+ * @brief Collect request queue statistics
+ *
+ * Sums the per-shard counters.  The result is a snapshot and may be
+ * slightly inconsistent while requests are in flight.
+ *
+ * @param[out] stats Statistics to fill in
+ */
+void nfs_rpc_queue_stats(struct nfs_req_q_stats *stats)
+{
+	struct req_q_shard *shard;
+	struct req_q_pair *qpair;
+	uint32_t ix, lane;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->shards = nfs_req_st.reqs.n_shards;
+
+	for (ix = 0; ix < nfs_req_st.reqs.n_shards; ++ix) {
+		shard = &nfs_req_st.reqs.shards[ix];
+		for (lane = 0; lane < N_REQ_QUEUES; ++lane) {
+			stats->depth[lane] +=
+			    gsh_ring_depth(&shard->lane[lane]);
+			stats->lane[lane].served += atomic_fetch_uint64_t(
+				&shard->lane_stats[lane].served);
+			stats->lane[lane].wait_ns += atomic_fetch_uint64_t(
+				&shard->lane_stats[lane].wait_ns);
+			stats->lane[lane].service_ns += atomic_fetch_uint64_t(
+				&shard->lane_stats[lane].service_ns);
+		}
+		stats->enqueued += atomic_fetch_uint64_t(&shard->enqueued);
+		stats->demoted += atomic_fetch_uint64_t(&shard->demoted);
+		stats->dequeued += atomic_fetch_uint64_t(&shard->dequeued);
+		stats->stolen += atomic_fetch_uint64_t(&shard->stolen);
+	}
+
+	for (lane = 0; lane < N_REQ_QUEUES; ++lane) {
+		qpair = &nfs_req_st.reqs.nfs_request_q.qset[lane];
+		stats->depth[lane] += qpair->producer.size +
+				      qpair->consumer.size;
+	}
+	stats->overflow_depth = atomic_fetch_uint64_t(&nfs_req_st.reqs.size);
+	stats->overflowed = atomic_fetch_uint64_t(&nfs_req_st.reqs.overflowed);
+}
+
+/**
+ * @brief Account for a completed request
+ *
+ * Charges the time the request spent queued and executing to its
+ * class, on the home shard of the worker that ran it.
+ *
+ * @param[in] worker_index Index of the worker that ran the request
+ * @param[in] req          The request
+ * @param[in] dequeued     When the worker took the request off its queue
+ */
+void nfs_rpc_queue_serviced(uint32_t worker_index, request_data_t *req,
+			    struct timespec *dequeued)
+{
+	struct req_q_lane_stats *ls;
+	struct timespec done;
+	nsecs_elapsed_t wait;
+
+	if (unlikely(req->lane >= N_REQ_QUEUES))
+		return;
+
+	now(&done);
+	ls = &nfs_req_st.reqs.shards[worker_index %
+				     nfs_req_st.reqs.n_shards]
+		.lane_stats[req->lane];
+	wait = timespec_diff(&req->time_queued, dequeued);
+	atomic_inc_uint64_t(&ls->served);
+	atomic_add_uint64_t(&ls->wait_ns, wait);
+	atomic_add_uint64_t(&ls->service_ns, timespec_diff(dequeued, &done));
+	server_stats_queue_done(req->lane, wait);
+}
+
+/**
+ * @brief Should this request go to the bulk lane?
+ *
+ * Connections that already have more than their fair share of
+ * requests outstanding get their new work demoted.  UDP requests
+ * all share one transport, so they are never demoted.
+ *
+ * @param[in] req The request
+ *
+ * @return true if the request should be demoted.
+ */
+static inline bool nfs_rpc_q_over_share(request_data_t *req)
+{
+	SVCXPRT *xprt = req->r_u.nfs->xprt;
+	gsh_xprt_private_t *xu = (gsh_xprt_private_t *) xprt->xp_u1;
+	uint32_t share = nfs_param.core_param.dispatch_fair_share;
+
+	if (share == 0 || xu == NULL || svc_get_xprt_type(xprt) == XPRT_UDP)
+		return false;
+
+	return atomic_fetch_uint32_t(&xu->req_cnt) > share;
+}
+
+/**
+ * @brief Choose the shard a new request is pushed onto
+ *
+ * Prefer the shard of the CPU we are running on, so that the worker
+ * most likely to pick the request up shares our caches.
+ *
+ * @return A shard index.
+ */
+static inline uint32_t nfs_rpc_q_pick_shard(void)
+{
+	int cpu = sched_getcpu();
+
+	if (likely(cpu >= 0))
+		return cpu % nfs_req_st.reqs.n_shards;
+
+	return nfs_rpc_q_next_slot() % nfs_req_st.reqs.n_shards;
+}
+
+/**
+ * @brief Are there any requests queued anywhere?
+ *
+ * Used by idle workers to close the race between deciding to sleep
+ * and an enqueue that saw no waiters.
+ *
+ * @return true if some lane or overflow queue is non-empty.
+ */
+static bool nfs_rpc_q_pending(void)
+{
+	struct req_q_shard *shard;
+	uint32_t ix, lane;
+
+	if (atomic_fetch_uint64_t(&nfs_req_st.reqs.size) != 0)
+		return true;
+
+	for (ix = 0; ix < nfs_req_st.reqs.n_shards; ++ix) {
+		shard = &nfs_req_st.reqs.shards[ix];
+		for (lane = 0; lane < N_REQ_QUEUES; ++lane)
+			if (gsh_ring_depth(&shard->lane[lane]) != 0)
+				return true;
+	}
+	return false;
 }
 
 void nfs_rpc_enqueue_req(request_data_t *req)
 {
 	struct req_q_set *nfs_request_q;
 	struct req_q_pair *qpair;
+	struct req_q_shard *shard;
 	struct req_q *q;
+	int lane;
 
 	nfs_request_q = &nfs_req_st.reqs.nfs_request_q;
 
@@ -1220,22 +1433,24 @@ void nfs_rpc_enqueue_req(request_data_t *req)
 			     req->r_u.nfs->req.rq_xid,
 			     req->r_u.nfs->lookahead.flags);
 		if (req->r_u.nfs->lookahead.flags & NFS_LOOKAHEAD_MOUNT) {
-			qpair = &(nfs_request_q->qset[REQ_Q_MOUNT]);
+			lane = REQ_Q_MOUNT;
 			break;
 		}
-		if (NFS_LOOKAHEAD_HIGH_LATENCY(req->r_u.nfs->lookahead))
-			qpair = &(nfs_request_q->qset[REQ_Q_HIGH_LATENCY]);
+		if (nfs_rpc_q_over_share(req))
+			lane = REQ_Q_BULK;
+		else if (NFS_LOOKAHEAD_HIGH_LATENCY(req->r_u.nfs->lookahead))
+			lane = REQ_Q_HIGH_LATENCY;
 		else
-			qpair = &(nfs_request_q->qset[REQ_Q_LOW_LATENCY]);
+			lane = REQ_Q_LOW_LATENCY;
 		break;
 	case NFS_CALL:
-		qpair = &(nfs_request_q->qset[REQ_Q_CALL]);
+		lane = REQ_Q_CALL;
 		break;
 #ifdef _USE_9P
 	case _9P_REQUEST:
 		/* XXX identify high-latency requests and allocate
 		 * to the high-latency queue, as above */
-		qpair = &(nfs_request_q->qset[REQ_Q_LOW_LATENCY]);
+		lane = REQ_Q_LOW_LATENCY;
 		break;
 #endif
 	default:
@@ -1246,22 +1461,42 @@ void nfs_rpc_enqueue_req(request_data_t *req)
 	/* this one is real, timestamp it
 	 */
 	now(&req->time_queued);
-	/* always append to producer queue */
-	q = &qpair->producer;
-	pthread_spin_lock(&q->sp);
-	glist_add_tail(&q->q, &req->req_q);
-	++(q->size);
-	pthread_spin_unlock(&q->sp);
+	req->lane = lane;
 
-	atomic_inc_uint32_t(&enqueued_reqs);
+	shard = &nfs_req_st.reqs.shards[nfs_rpc_q_pick_shard()];
+	if (lane == REQ_Q_BULK)
+		atomic_inc_uint64_t(&shard->demoted);
+	if (likely(gsh_ring_push(&shard->lane[lane], req))) {
+		atomic_inc_uint64_t(&shard->enqueued);
+		LogFullDebug(COMPONENT_DISPATCH,
+			     "enqueued req %p on shard %p lane %s", req,
+			     shard, req_q_s[lane]);
+	} else {
+		/* lane is full, spill to the producer queue */
+		qpair = &(nfs_request_q->qset[lane]);
+		q = &qpair->producer;
+		pthread_spin_lock(&q->sp);
+		glist_add_tail(&q->q, &req->req_q);
+		++(q->size);
+		pthread_spin_unlock(&q->sp);
+		atomic_inc_uint64_t(&nfs_req_st.reqs.size);
+		atomic_inc_uint64_t(&nfs_req_st.reqs.overflowed);
+		atomic_inc_uint64_t(&shard->enqueued);
 
-	LogDebug(COMPONENT_DISPATCH,
-		 "enqueued req, q %p (%s %p:%p) " "size is %d (enq %u deq %u)",
-		 q, qpair->s, &qpair->producer, &qpair->consumer, q->size,
-		 enqueued_reqs, dequeued_reqs);
+		LogDebug(COMPONENT_DISPATCH,
+			 "lane full, overflowed req, q %p (%s %p:%p) size is %d",
+			 q, qpair->s, &qpair->producer, &qpair->consumer,
+			 q->size);
+	}
 
 	/* potentially wakeup some thread */
 
+	/* Pairs with the fence in nfs_rpc_dequeue_req: either we see
+	 * the waiter, or it sees our request when it rechecks. */
+	atomic_thread_fence_seq_cst();
+	if (atomic_fetch_uint32_t(&nfs_req_st.reqs.waiters) == 0)
+		goto out;
+
 	/* global waitq */
 	{
 		wait_q_entry_t *wqe;
@@ -1273,8 +1508,8 @@ void nfs_rpc_enqueue_req(request_data_t *req)
 						wait_q_entry_t, waitq);
 
 			LogFullDebug(COMPONENT_DISPATCH,
-				     "nfs_req_st.reqs.waiters %u signal wqe %p (for q %p)",
-				     nfs_req_st.reqs.waiters, wqe, q);
+				     "nfs_req_st.reqs.waiters %u signal wqe %p",
+				     nfs_req_st.reqs.waiters, wqe);
 
 			/* release 1 waiter */
 			glist_del(&wqe->waitq);
@@ -1353,65 +1588,104 @@ request_data_t *nfs_rpc_consume_req(struct req_q_pair *qpair)
 				     "producer qsize=%u", s, csize, psize);
 	}
  out:
+	if (nfsreq)
+		atomic_dec_uint64_t(&nfs_req_st.reqs.size);
 	return nfsreq;
 }
 
-request_data_t *nfs_rpc_dequeue_req(nfs_worker_data_t *worker)
+/**
+ * @brief Take a request of one class from anywhere
+ *
+ * Our home shard is tried first, then the overflow queue of the
+ * class, then the other shards in turn.
+ *
+ * @param[in] home_ix Index of the worker's home shard
+ * @param[in] lane    Request class
+ *
+ * @return A request or NULL if the class is empty everywhere.
+ */
+static request_data_t *nfs_rpc_lane_pop(uint32_t home_ix, uint32_t lane)
 {
-	request_data_t *nfsreq = NULL;
-	struct req_q_set *nfs_request_q = &nfs_req_st.reqs.nfs_request_q;
-	struct req_q_pair *qpair;
-	uint32_t ix, slot;
-	struct timespec timeout;
-
-	/* XXX: the following stands in for a more robust/flexible
-	 * weighting function */
+	struct req_q_shard *shards = nfs_req_st.reqs.shards;
+	uint32_t n_shards = nfs_req_st.reqs.n_shards;
+	request_data_t *nfsreq;
+	uint32_t ix;
+
+	/* our own shard first */
+	nfsreq = gsh_ring_pop(&shards[home_ix].lane[lane]);
+	if (nfsreq)
+		return nfsreq;
+
+	/* then anything that spilled over */
+	if (atomic_fetch_uint64_t(&nfs_req_st.reqs.size) != 0) {
+		nfsreq = nfs_rpc_consume_req(
+			&nfs_req_st.reqs.nfs_request_q.qset[lane]);
+		if (nfsreq)
+			return nfsreq;
+	}
 
-	/* slot in 1..4 */
- retry_deq:
-	slot = (nfs_rpc_q_next_slot() % 4);
-	for (ix = 0; ix < 4; ++ix) {
-		switch (slot) {
-		case 0:
-			/* MOUNT */
-			qpair = &(nfs_request_q->qset[REQ_Q_MOUNT]);
-			break;
-		case 1:
-			/* NFS_CALL */
-			qpair = &(nfs_request_q->qset[REQ_Q_CALL]);
-			break;
-		case 2:
-			/* LL */
-			qpair = &(nfs_request_q->qset[REQ_Q_LOW_LATENCY]);
-			break;
-		case 3:
-			/* HL */
-			qpair = &(nfs_request_q->qset[REQ_Q_HIGH_LATENCY]);
-			break;
-		default:
-			/* not here */
-			abort();
-			break;
+	/* then steal from our neighbours */
+	for (ix = 1; ix < n_shards; ++ix) {
+		nfsreq = gsh_ring_pop(
+			&shards[(home_ix + ix) % n_shards].lane[lane]);
+		if (nfsreq) {
+			atomic_inc_uint64_t(&shards[home_ix].stolen);
+			return nfsreq;
 		}
+	}
+	return NULL;
+}
 
-		LogFullDebug(COMPONENT_DISPATCH,
-			     "dequeue_req try qpair %s %p:%p", qpair->s,
-			     &qpair->producer, &qpair->consumer);
-
-		/* anything? */
-		nfsreq = nfs_rpc_consume_req(qpair);
-		if (nfsreq) {
-			atomic_inc_uint32_t(&dequeued_reqs);
-			break;
+/**
+ * @brief Pick the next request by deficit round robin
+ *
+ * The scheduling state is private to the worker, so choosing a
+ * request never writes shared memory beyond the queues themselves.
+ * A lane keeps being served until its quantum is used up or it runs
+ * dry; an empty lane loses whatever quantum it had left.
+ *
+ * @param[in,out] worker  Worker doing the dequeue
+ * @param[in]     home_ix Index of the worker's home shard
+ *
+ * @return A request or NULL if all classes are empty.
+ */
+static request_data_t *nfs_rpc_drr_pop(nfs_worker_data_t *worker,
+				       uint32_t home_ix)
+{
+	request_data_t *nfsreq;
+	uint32_t visits;
+
+	for (visits = 0; visits <= N_REQ_QUEUES; ++visits) {
+		if (worker->drr_deficit > 0) {
+			nfsreq = nfs_rpc_lane_pop(home_ix, worker->drr_lane);
+			if (nfsreq) {
+				--(worker->drr_deficit);
+				return nfsreq;
+			}
 		}
+		worker->drr_lane = (worker->drr_lane + 1) % N_REQ_QUEUES;
+		worker->drr_deficit = req_q_weight[worker->drr_lane];
+	}
+	return NULL;
+}
 
-		++slot;
-		slot = slot % 4;
+request_data_t *nfs_rpc_dequeue_req(nfs_worker_data_t *worker)
+{
+	request_data_t *nfsreq = NULL;
+	struct req_q_shard *home;
+	uint32_t home_ix;
+	struct timespec timeout;
 
-	}			/* for */
+	home_ix = worker->worker_index % nfs_req_st.reqs.n_shards;
+	home = &nfs_req_st.reqs.shards[home_ix];
+
+ retry_deq:
+	nfsreq = nfs_rpc_drr_pop(worker, home_ix);
+	if (nfsreq)
+		goto found;
 
 	/* wait */
-	if (!nfsreq) {
+	{
 		wait_q_entry_t *wqe = &worker->wqe;
 		assert(wqe->waiters == 0); /* wqe is not on any wait queue */
 		PTHREAD_MUTEX_lock(&wqe->lwe.mtx);
@@ -1422,6 +1696,34 @@ request_data_t *nfs_rpc_dequeue_req(nfs_worker_data_t *worker)
 		glist_add_tail(&nfs_req_st.reqs.wait_list, &wqe->waitq);
 		++(nfs_req_st.reqs.waiters);
 		pthread_spin_unlock(&nfs_req_st.reqs.sp);
+
+		/* Pairs with the fence in nfs_rpc_enqueue_req */
+		atomic_thread_fence_seq_cst();
+		if (nfs_rpc_q_pending()) {
+			/* Something arrived while we were registering,
+			 * get off the waitq and go get it. */
+			pthread_spin_lock(&nfs_req_st.reqs.sp);
+			if (wqe->waiters) {
+				glist_del(&wqe->waitq);
+				--(nfs_req_st.reqs.waiters);
+				--(wqe->waiters);
+				pthread_spin_unlock(&nfs_req_st.reqs.sp);
+			} else {
+				/* An enqueuer already took us off and is
+				 * waiting for our mutex to hand off.  Let
+				 * it finish, or its SyncDone would land on
+				 * our next registration. */
+				pthread_spin_unlock(&nfs_req_st.reqs.sp);
+				while (!(wqe->flags & Wqe_LFlag_SyncDone))
+					pthread_cond_wait(&wqe->lwe.cv,
+							  &wqe->lwe.mtx);
+			}
+			wqe->flags &= ~(Wqe_LFlag_WaitSync |
+					Wqe_LFlag_SyncDone);
+			PTHREAD_MUTEX_unlock(&wqe->lwe.mtx);
+			goto retry_deq;
+		}
+
 		while (!(wqe->flags & Wqe_LFlag_SyncDone)) {
 			timeout.tv_sec = time(NULL) + 5;
 			timeout.tv_nsec = 0;
@@ -1431,18 +1733,27 @@ request_data_t *nfs_rpc_dequeue_req(nfs_worker_data_t *worker)
 				/* We are returning;
 				 * so take us out of the waitq */
 				pthread_spin_lock(&nfs_req_st.reqs.sp);
-				if (wqe->waitq.next != NULL
-				    || wqe->waitq.prev != NULL) {
+				if (wqe->waiters) {
 					/* Element is still in wqitq,
 					 * remove it */
 					glist_del(&wqe->waitq);
 					--(nfs_req_st.reqs.waiters);
 					--(wqe->waiters);
-					wqe->flags &=
-					    ~(Wqe_LFlag_WaitSync |
-					      Wqe_LFlag_SyncDone);
+					pthread_spin_unlock(
+						&nfs_req_st.reqs.sp);
+				} else {
+					/* Taken off by an enqueuer, wait
+					 * out its handoff as above */
+					pthread_spin_unlock(
+						&nfs_req_st.reqs.sp);
+					while (!(wqe->flags &
+						 Wqe_LFlag_SyncDone))
+						pthread_cond_wait(
+							&wqe->lwe.cv,
+							&wqe->lwe.mtx);
 				}
-				pthread_spin_unlock(&nfs_req_st.reqs.sp);
+				wqe->flags &= ~(Wqe_LFlag_WaitSync |
+						Wqe_LFlag_SyncDone);
 				PTHREAD_MUTEX_unlock(&wqe->lwe.mtx);
 				return NULL;
 			}
@@ -1456,6 +1767,8 @@ request_data_t *nfs_rpc_dequeue_req(nfs_worker_data_t *worker)
 		goto retry_deq;
 	}
 
+ found:
+	atomic_inc_uint64_t(&home->dequeued);
 	return nfsreq;
 }
 
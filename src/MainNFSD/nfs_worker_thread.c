@@ -60,6 +60,7 @@
 #include "export_mgr.h"
 #include "server_stats.h"
 #include "uid2grp.h"
+#include "gsh_iobuf.h"
 
 #ifdef USE_LTTNG
 #include "gsh_lttng/nfs_rpc.h"
@@ -694,14 +695,217 @@ const nfs_function_desc_t *nfs_rpc_get_funcdesc(nfs_request_data_t *reqnfs)
 	return funcdesc;
 }
 
+/**
+ * @brief Find the client a request came from
+ *
+ * A connected transport only ever carries one client, so the first
+ * lookup on it is cached in the transport's private data, which holds
+ * its own reference.  Later requests borrow that reference and never
+ * touch the client table.
+ *
+ * @param[in]  xprt     Transport the request arrived on
+ * @param[in]  addr     Caller's address
+ * @param[out] borrowed Set if the caller does not own a reference
+ *
+ * @return The client or NULL if it could not be found or created.
+ */
+static struct gsh_client *nfs_rpc_get_client(SVCXPRT *xprt, sockaddr_t *addr,
+					     bool *borrowed)
+{
+	gsh_xprt_private_t *xu = (gsh_xprt_private_t *) xprt->xp_u1;
+	struct gsh_client *client;
+	void *expected = NULL;
+
+	*borrowed = false;
+	if (xu == NULL || svc_get_xprt_type(xprt) == XPRT_UDP)
+		return get_gsh_client(addr, false);
+
+	client = atomic_fetch_voidptr((void **)&xu->client);
+	if (client != NULL) {
+		*borrowed = true;
+		return client;
+	}
+
+	client = get_gsh_client(addr, false);
+	if (client == NULL)
+		return NULL;
+
+	/* the xprt gets a reference of its own */
+	inc_gsh_client_refcount(client);
+	if (!atomic_cas_voidptr((void **)&xu->client, &expected, client))
+		put_gsh_client(client);	/* somebody beat us to it */
+	return client;
+}
+
+/**
+ * @brief Bytes an NFS v3 request will move
+ *
+ * @param[in] proc    Procedure number
+ * @param[in] arg_nfs Decoded arguments
+ *
+ * @return The READ or WRITE count.
+ */
+static inline uint64_t nfs3_io_size(rpcproc_t proc, nfs_arg_t *arg_nfs)
+{
+	switch (proc) {
+	case NFSPROC3_READ:
+		return arg_nfs->arg_read3.count;
+	case NFSPROC3_WRITE:
+		return arg_nfs->arg_write3.count;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief Reply to a request its service function has handled
+ *
+ * @param[in] req        NFS request
+ * @param[in] rc         NFS_REQ_OK or NFS_REQ_DROP
+ * @param[in] dpq_status Duplicate request cache status of the request
+ *
+ * @return The duplicate request cache status once the reply is sent.
+ */
+static dupreq_status_t nfs_rpc_reply(request_data_t *req, int rc,
+				     dupreq_status_t dpq_status)
+{
+	nfs_request_data_t *reqnfs = req->r_u.nfs;
+	struct svc_req *svcreq = &reqnfs->req;
+	SVCXPRT *xprt = reqnfs->xprt;
+	nfs_res_t *res_nfs = reqnfs->res_nfs;
+	bool slocked = false;
+	bool reply_cached = false;
+
+/* NFSv4 stats are handled in nfs4_compound()
+ */
+	if (svcreq->rq_prog != nfs_param.core_param.program[P_NFS]
+	    || svcreq->rq_vers != NFS_V4)
+		server_stats_nfs_done(req, rc, false);
+
+	/* If request is dropped, no return to the client */
+	if (rc == NFS_REQ_DROP) {
+		/* The request was dropped */
+		LogDebug(COMPONENT_DISPATCH,
+			 "Drop request rpc_xid=%u, program %u, version %u, function %u",
+			 svcreq->rq_xid, (int)svcreq->rq_prog,
+			 (int)svcreq->rq_vers, (int)svcreq->rq_proc);
+
+		/* If the request is not normally cached, then the entry
+		 * will be removed later.  We only remove a reply that is
+		 * normally cached that has been dropped.
+		 */
+		if (nfs_dupreq_delete(svcreq) != DUPREQ_SUCCESS) {
+			LogCrit(COMPONENT_DISPATCH,
+				"Attempt to delete duplicate request failed on line %d",
+				__LINE__);
+		}
+		return dpq_status;
+	}
+
+	LogFullDebug(COMPONENT_DISPATCH,
+		     "Before svc_sendreply on socket %d", xprt->xp_fd);
+
+	/* With DRC_Encoded, completing the request encodes the
+	 * result into the cache, and that encoding is what gets
+	 * sent.
+	 */
+	if (nfs_param.core_param.drc.encoded
+	    && dpq_status == DUPREQ_SUCCESS) {
+		dpq_status = nfs_dupreq_finish(svcreq, res_nfs);
+		reply_cached = true;
+	}
+
+	DISP_SLOCK(xprt);
+
+	/* encoding the result on xdr output */
+	if (nfs_dupreq_sendreply(xprt, svcreq, reqnfs->funcdesc,
+				 res_nfs) == false) {
+		LogDebug(COMPONENT_DISPATCH,
+			 "NFS DISPATCHER: FAILURE: Error while calling "
+			 "svc_sendreply on a new request. rpcxid=%u "
+			 "socket=%d function:%s client:%s program:%d "
+			 "nfs version:%d proc:%d xid:%u errno: %d",
+			 svcreq->rq_xid, xprt->xp_fd,
+			 reqnfs->funcdesc->funcname,
+			 op_ctx->client != NULL
+				? op_ctx->client->hostaddr_str
+				: "<unknown client>",
+			 (int)svcreq->rq_prog, (int)svcreq->rq_vers,
+			 (int)svcreq->rq_proc, svcreq->rq_xid, errno);
+		if (xprt->xp_type != XPRT_UDP)
+			svc_destroy(xprt);
+		DISP_SUNLOCK(xprt);
+		return dpq_status;
+	}
+
+	LogFullDebug(COMPONENT_DISPATCH,
+		     "After svc_sendreply on socket %d", xprt->xp_fd);
+
+	DISP_SUNLOCK(xprt);
+
+	/* Finish any request not already deleted */
+	if (dpq_status == DUPREQ_SUCCESS && !reply_cached)
+		dpq_status = nfs_dupreq_finish(svcreq, res_nfs);
+
+	return dpq_status;
+}
+
+/**
+ * @brief Free the arguments and duplicate request cache hold of a request
+ *
+ * @param[in] req        NFS request
+ * @param[in] dpq_status Duplicate request cache status of the request
+ */
+static void nfs_rpc_free_args(request_data_t *req,
+			      dupreq_status_t dpq_status)
+{
+	nfs_request_data_t *reqnfs = req->r_u.nfs;
+
+	clean_credentials();
+
+	/* Free the allocated resources once the work is done */
+	/* Free the arguments */
+	if ((reqnfs->req.rq_vers == 2) || (reqnfs->req.rq_vers == 3)
+	    || (reqnfs->req.rq_vers == 4)) {
+		if (!SVC_FREEARGS
+		    (reqnfs->xprt, reqnfs->funcdesc->xdr_decode_func,
+		     (caddr_t) &reqnfs->arg_nfs)) {
+			LogCrit(COMPONENT_DISPATCH,
+				"NFS DISPATCHER: FAILURE: Bad SVC_FREEARGS for %s",
+				reqnfs->funcdesc->funcname);
+		}
+	}
+
+	/* Finalize the request. */
+	if (reqnfs->res_nfs || dpq_status == DUPREQ_EXISTS)
+		nfs_dupreq_rele(&reqnfs->req, reqnfs->funcdesc);
+}
+
+/**
+ * @brief Drop the references a request's context holds
+ *
+ * @param[in] req NFS request
+ */
+static void nfs_rpc_release(request_data_t *req)
+{
+	SetClientIP(NULL);
+	if (op_ctx->client != NULL && !req->r_u.nfs->client_borrowed)
+		put_gsh_client(op_ctx->client);
+	if (op_ctx->export != NULL)
+		put_gsh_export(op_ctx->export);
+	op_ctx = NULL;
+}
+
 /**
  * @brief Main RPC dispatcher routine
  *
  * @param[in,out] req         NFS request
  * @param[in,out] worker_data Worker thread context
  *
+ * @return true if the request was parked by nfs_rpc_async_start, in
+ *         which case it must not be touched again.
  */
-static void nfs_rpc_execute(request_data_t *req,
+static bool nfs_rpc_execute(request_data_t *req,
 			    nfs_worker_data_t *worker_data)
 {
 	nfs_request_data_t *reqnfs = req->r_u.nfs;
@@ -710,10 +914,8 @@ static void nfs_rpc_execute(request_data_t *req,
 	int exportid = -1;
 	struct svc_req *svcreq = &reqnfs->req;
 	SVCXPRT *xprt = reqnfs->xprt;
-	struct export_perms export_perms;
+	struct export_perms *export_perms = &reqnfs->export_perms;
 	int protocol_options = 0;
-	struct user_cred user_credentials;
-	struct req_op_context req_ctx;
 	const char *client_ip = "<unknown client>";
 	dupreq_status_t dpq_status;
 	struct timespec timer_start;
@@ -727,19 +929,20 @@ static void nfs_rpc_execute(request_data_t *req,
 #endif
 
 	/* Initialize permissions to allow nothing */
-	export_perms.options = 0;
-	export_perms.anonymous_uid = (uid_t) ANON_UID;
-	export_perms.anonymous_gid = (gid_t) ANON_GID;
+	export_perms->options = 0;
+	export_perms->anonymous_uid = (uid_t) ANON_UID;
+	export_perms->anonymous_gid = (gid_t) ANON_GID;
 
 	/* set up the request context
 	 */
-	memset(&req_ctx, 0, sizeof(struct req_op_context));
-	op_ctx = &req_ctx;
-	op_ctx->creds = &user_credentials;
-	op_ctx->caller_addr = &worker_data->hostaddr;
+	memset(&reqnfs->req_ctx, 0, sizeof(struct req_op_context));
+	op_ctx = &reqnfs->req_ctx;
+	op_ctx->creds = &reqnfs->user_credentials;
+	op_ctx->caller_addr = &reqnfs->hostaddr;
 	op_ctx->nfs_vers = svcreq->rq_vers;
 	op_ctx->req_type = req->rtype;
-	op_ctx->export_perms = &export_perms;
+	op_ctx->export_perms = export_perms;
+	reqnfs->client_borrowed = false;
 
 	/* Initialized user_credentials */
 	init_credentials();
@@ -769,7 +972,8 @@ static void nfs_rpc_execute(request_data_t *req,
 	}
 
 	port = get_port(op_ctx->caller_addr);
-	op_ctx->client = get_gsh_client(op_ctx->caller_addr, false);
+	op_ctx->client = nfs_rpc_get_client(xprt, op_ctx->caller_addr,
+					    &reqnfs->client_borrowed);
 	if (op_ctx->client == NULL) {
 		LogDebug(COMPONENT_DISPATCH,
 			 "Cannot get client block for Program %d, Version %d, "
@@ -803,6 +1007,7 @@ static void nfs_rpc_execute(request_data_t *req,
 	res_nfs = reqnfs->res_nfs;
 	if (dpq_status == DUPREQ_SUCCESS) {
 		/* A new request, continue processing it. */
+		op_ctx->arena = nfs_res_arena(res_nfs);
 		LogFullDebug(COMPONENT_DISPATCH,
 			     "Current request is not duplicate or "
 			     "not cacheable.");
@@ -820,10 +1025,9 @@ static void nfs_rpc_execute(request_data_t *req,
 				     xprt->xp_fd);
 
 			DISP_SLOCK(xprt);
-			if (svc_sendreply(
-				    xprt, svcreq,
-				    reqnfs->funcdesc->xdr_encode_func,
-			     (caddr_t) res_nfs) == false) {
+			if (nfs_dupreq_sendreply(xprt, svcreq,
+						 reqnfs->funcdesc,
+						 res_nfs) == false) {
 				LogDebug(COMPONENT_DISPATCH,
 					 "NFS DISPATCHER: FAILURE: Error while calling "
 					 "svc_sendreply on a duplicate request. rpcxid=%u "
@@ -1060,7 +1264,7 @@ static void nfs_rpc_execute(request_data_t *req,
 
 		export_check_access();
 
-		if (export_perms.options == 0) {
+		if (export_perms->options == 0) {
 			LogInfoAlt(COMPONENT_DISPATCH, COMPONENT_EXPORT,
 				"Client %s is not allowed to access Export_Id %d %s, vers=%d, proc=%d",
 				client_ip,
@@ -1081,7 +1285,7 @@ static void nfs_rpc_execute(request_data_t *req,
 			goto auth_failure;
 		}
 
-		if ((protocol_options & export_perms.options) == 0) {
+		if ((protocol_options & export_perms->options) == 0) {
 			LogInfoAlt(COMPONENT_DISPATCH, COMPONENT_EXPORT,
 				"%s Version %d not allowed on Export_Id %d %s for client %s",
 				progname, svcreq->rq_vers,
@@ -1095,9 +1299,10 @@ static void nfs_rpc_execute(request_data_t *req,
 
 		/* Check transport type */
 		if (((xprt_type == XPRT_UDP)
-		     && ((export_perms.options & EXPORT_OPTION_UDP) == 0))
+		     && ((export_perms->options & EXPORT_OPTION_UDP) == 0))
 		    || ((xprt_type == XPRT_TCP)
-			&& ((export_perms.options & EXPORT_OPTION_TCP) == 0))) {
+			&& ((export_perms->options & EXPORT_OPTION_TCP)
+			    == 0))) {
 			LogInfoAlt(COMPONENT_DISPATCH, COMPONENT_EXPORT,
 				"%s Version %d over %s not allowed on Export_Id %d %s for client %s",
 				progname, svcreq->rq_vers,
@@ -1128,7 +1333,7 @@ static void nfs_rpc_execute(request_data_t *req,
 		/* Check if client is using a privileged port,
 		 * but only for NFS protocol */
 		if ((svcreq->rq_prog == nfs_param.core_param.program[P_NFS])
-		    && ((export_perms.options & EXPORT_OPTION_PRIVILEGED_PORT)
+		    && ((export_perms->options & EXPORT_OPTION_PRIVILEGED_PORT)
 			!= 0) && (port >= IPPORT_RESERVED)) {
 			LogInfoAlt(COMPONENT_DISPATCH, COMPONENT_EXPORT,
 				"Non-reserved Port %d is not allowed on Export_Id %d %s for client %s",
@@ -1147,7 +1352,7 @@ static void nfs_rpc_execute(request_data_t *req,
 	 */
 	if (op_ctx->export != NULL
 	    && (reqnfs->funcdesc->dispatch_behaviour & MAKES_IO) != 0
-	    && (export_perms.options & EXPORT_OPTION_RW_ACCESS) == 0) {
+	    && (export_perms->options & EXPORT_OPTION_RW_ACCESS) == 0) {
 		/* Request of type MDONLY_RO were rejected at the
 		 * nfs_rpc_dispatcher level.
 		 * This is done by replying EDQUOT
@@ -1177,7 +1382,7 @@ static void nfs_rpc_execute(request_data_t *req,
 		}
 	} else if (op_ctx->export != NULL
 		   && (reqnfs->funcdesc->dispatch_behaviour & MAKES_WRITE) != 0
-		   && (export_perms.
+		   && (export_perms->
 		       options & (EXPORT_OPTION_WRITE_ACCESS |
 				  EXPORT_OPTION_MD_WRITE_ACCESS)) == 0) {
 		if (svcreq->rq_prog == nfs_param.core_param.program[P_NFS])
@@ -1202,7 +1407,7 @@ static void nfs_rpc_execute(request_data_t *req,
 			rc = NFS_REQ_DROP;
 		}
 	} else if (op_ctx->export != NULL
-		   && (export_perms.
+		   && (export_perms->
 		       options & (EXPORT_OPTION_READ_ACCESS |
 				  EXPORT_OPTION_MD_READ_ACCESS)) == 0) {
 		LogInfoAlt(COMPONENT_DISPATCH, COMPONENT_EXPORT,
@@ -1212,6 +1417,21 @@ static void nfs_rpc_execute(request_data_t *req,
 			(int)svcreq->rq_proc);
 		auth_rc = AUTH_TOOWEAK;
 		goto auth_failure;
+	} else if (op_ctx->export != NULL
+		   && (reqnfs->funcdesc->dispatch_behaviour & MAKES_IO) != 0
+		   && !export_throttle_admit(op_ctx->export,
+					     nfs3_io_size(svcreq->rq_proc,
+							  arg_nfs))) {
+		/* Only NFS v3 READ and WRITE get here */
+		LogDebugAlt(COMPONENT_DISPATCH, COMPONENT_EXPORT,
+			    "Export_Id %d is over its rate limit",
+			    op_ctx->export->export_id);
+		if (nfs_param.core_param.drop_delay_errors) {
+			rc = NFS_REQ_DROP;
+		} else {
+			res_nfs->res_getattr3.status = NFS3ERR_JUKEBOX;
+			rc = NFS_REQ_OK;
+		}
 	} else {
 		/* Get user credentials */
 		if (reqnfs->funcdesc->dispatch_behaviour & NEEDS_CRED) {
@@ -1220,7 +1440,7 @@ static void nfs_rpc_execute(request_data_t *req,
 				/* If NEEDS_CRED and not NEEDS_EXPORT,
 				 * don't squash
 				 */
-				export_perms.options = EXPORT_OPTION_ROOT;
+				export_perms->options = EXPORT_OPTION_ROOT;
 			}
 
 			if (nfs_req_creds(svcreq) != NFS4_OK) {
@@ -1269,6 +1489,14 @@ static void nfs_rpc_execute(request_data_t *req,
 							worker_data, svcreq,
 							res_nfs);
 
+		if (rc == NFS_REQ_ASYNC_WAIT) {
+			/* The request now belongs to its I/O completion,
+			 * which may already have finished it. */
+			SetClientIP(NULL);
+			op_ctx = NULL;
+			return true;
+		}
+
 #ifdef USE_LTTNG
 		tracepoint(nfs_rpc, op_end, req);
 #endif
@@ -1276,64 +1504,7 @@ static void nfs_rpc_execute(request_data_t *req,
 	}
 
  req_error:
-
-/* NFSv4 stats are handled in nfs4_compound()
- */
-	if (svcreq->rq_prog != nfs_param.core_param.program[P_NFS]
-	    || svcreq->rq_vers != NFS_V4)
-		server_stats_nfs_done(req, rc, false);
-
-	/* If request is dropped, no return to the client */
-	if (rc == NFS_REQ_DROP) {
-		/* The request was dropped */
-		LogDebug(COMPONENT_DISPATCH,
-			 "Drop request rpc_xid=%u, program %u, version %u, function %u",
-			 svcreq->rq_xid, (int)svcreq->rq_prog,
-			 (int)svcreq->rq_vers, (int)svcreq->rq_proc);
-
-		/* If the request is not normally cached, then the entry
-		 * will be removed later.  We only remove a reply that is
-		 * normally cached that has been dropped.
-		 */
-		if (nfs_dupreq_delete(svcreq) != DUPREQ_SUCCESS) {
-			LogCrit(COMPONENT_DISPATCH,
-				"Attempt to delete duplicate request failed on line %d",
-				__LINE__);
-		}
-		goto freeargs;
-	} else {
-		LogFullDebug(COMPONENT_DISPATCH,
-			     "Before svc_sendreply on socket %d", xprt->xp_fd);
-
-		DISP_SLOCK(xprt);
-
-		/* encoding the result on xdr output */
-		if (svc_sendreply(
-			    xprt, svcreq, reqnfs->funcdesc->xdr_encode_func,
-		     (caddr_t) res_nfs) == false) {
-			LogDebug(COMPONENT_DISPATCH,
-				 "NFS DISPATCHER: FAILURE: Error while calling "
-				 "svc_sendreply on a new request. rpcxid=%u "
-				 "socket=%d function:%s client:%s program:%d "
-				 "nfs version:%d proc:%d xid:%u errno: %d",
-				 svcreq->rq_xid, xprt->xp_fd,
-				 reqnfs->funcdesc->funcname,
-				 client_ip,
-				 (int)svcreq->rq_prog, (int)svcreq->rq_vers,
-				 (int)svcreq->rq_proc, svcreq->rq_xid, errno);
-			if (xprt->xp_type != XPRT_UDP)
-				svc_destroy(xprt);
-			goto freeargs;
-		}
-
-		LogFullDebug(COMPONENT_DISPATCH,
-			     "After svc_sendreply on socket %d", xprt->xp_fd);
-
-	}			/* rc == NFS_REQ_DROP */
-
-	/* Finish any request not already deleted */
-	if (dpq_status == DUPREQ_SUCCESS)
-		dpq_status = nfs_dupreq_finish(svcreq, res_nfs);
+	dpq_status = nfs_rpc_reply(req, rc, dpq_status);
 	goto freeargs;
 
  handle_err:
@@ -1360,40 +1531,87 @@ static void nfs_rpc_execute(request_data_t *req,
 	}
 
  freeargs:
-	clean_credentials();
 	/* XXX no need for xprt slock across SVC_FREEARGS */
 	DISP_SUNLOCK(xprt);
+	nfs_rpc_free_args(req, dpq_status);
 
-	/* Free the allocated resources once the work is done */
-	/* Free the arguments */
-	if ((reqnfs->req.rq_vers == 2) || (reqnfs->req.rq_vers == 3)
-	    || (reqnfs->req.rq_vers == 4)) {
-		if (!SVC_FREEARGS
-		    (xprt, reqnfs->funcdesc->xdr_decode_func,
-		     (caddr_t) arg_nfs)) {
-			LogCrit(COMPONENT_DISPATCH,
-				"NFS DISPATCHER: FAILURE: Bad SVC_FREEARGS for %s",
-				reqnfs->funcdesc->funcname);
-		}
-	}
+out:
+	nfs_rpc_release(req);
 
-	/* Finalize the request. */
-	if (res_nfs)
-		nfs_dupreq_rele(svcreq, reqnfs->funcdesc);
+#ifdef USE_LTTNG
+	tracepoint(nfs_rpc, end, req);
+#endif
 
-out:
-	SetClientIP(NULL);
+	return false;
+}
+
+/**
+ * @brief Park the request being executed
+ *
+ * A service function that starts I/O which will complete on another
+ * thread calls this, then returns NFS_REQ_ASYNC_WAIT without touching
+ * the request, its arguments or its result again.  The worker goes on
+ * to other requests and the I/O completion finishes this one with
+ * nfs_rpc_async_complete.  Everything the request needs, including
+ * op_ctx, lives in its nfs_request_data_t until then.
+ *
+ * UDP requests are never parked, since their transport is shared by
+ * all clients.
+ *
+ * @param[in] worker The worker executing the request
+ *
+ * @return The request, or NULL if it must be completed in line.
+ */
+request_data_t *nfs_rpc_async_start(nfs_worker_data_t *worker)
+{
+	request_data_t *req = worker->cur_req;
+	nfs_request_data_t *reqnfs;
+
+	if (req == NULL || req->rtype != NFS_REQUEST)
+		return NULL;
+
+	reqnfs = req->r_u.nfs;
+	if (svc_get_xprt_type(reqnfs->xprt) == XPRT_UDP)
+		return NULL;
+
+	reqnfs->worker_index = worker->worker_index;
+	reqnfs->dequeued = worker->dequeued;
+	return req;
+}
+
+/**
+ * @brief Finish a parked request
+ *
+ * Sends the reply, releases everything nfs_rpc_execute would have and
+ * frees the request.  May be called from any thread, including the
+ * worker that parked the request before its service function returns.
+ *
+ * @param[in] req The request returned by nfs_rpc_async_start
+ * @param[in] rc  NFS_REQ_OK or NFS_REQ_DROP
+ */
+void nfs_rpc_async_complete(request_data_t *req, int rc)
+{
+	nfs_request_data_t *reqnfs = req->r_u.nfs;
+	dupreq_status_t dpq_status;
+
+	op_ctx = &reqnfs->req_ctx;
 	if (op_ctx->client != NULL)
-		put_gsh_client(op_ctx->client);
-	if (op_ctx->export != NULL)
-		put_gsh_export(op_ctx->export);
-	op_ctx = NULL;
+		SetClientIP(op_ctx->client->hostaddr_str);
+
+	/* Only new requests get as far as the service function */
+	dpq_status = nfs_rpc_reply(req, rc, DUPREQ_SUCCESS);
+	nfs_rpc_free_args(req, dpq_status);
+	nfs_rpc_release(req);
 
 #ifdef USE_LTTNG
 	tracepoint(nfs_rpc, end, req);
 #endif
 
-	return;
+	nfs_rpc_queue_serviced(reqnfs->worker_index, req, &reqnfs->dequeued);
+	gsh_xprt_unref(reqnfs->xprt, XPRT_PRIVATE_FLAG_DECREQ, __func__,
+		       __LINE__);
+	pool_free(request_data_pool, reqnfs);
+	pool_free(request_pool, req);
 }
 
 #ifdef _USE_9P
@@ -1434,8 +1652,11 @@ static void _9p_execute(request_data_t *req, nfs_worker_data_t *worker_data)
  */
 static void _9p_free_reqdata(struct _9p_request_data *req9p)
 {
-	if (req9p->pconn->trans_type == _9P_TCP)
-		gsh_free(req9p->_9pmsg);
+	if (req9p->pconn->trans_type == _9P_TCP) {
+		gsh_iobuf_put(req9p->_9pmsg);
+		_9p_tcp_conn_put(req9p->pconn);
+		return;
+	}
 
 	/* decrease connection refcount */
 	atomic_dec_uint32_t(&req9p->pconn->refcount);
@@ -1498,6 +1719,8 @@ static void worker_run(struct fridgethr_context *ctx)
 	request_data_t *nfsreq;
 	gsh_xprt_private_t *xu = NULL;
 	uint32_t reqcnt;
+	struct timespec dequeued;
+	bool parked;
 
 	/* Worker's loop */
 	while (!fridgethr_you_should_break(ctx)) {
@@ -1506,6 +1729,10 @@ static void worker_run(struct fridgethr_context *ctx)
 		if (!nfsreq)
 			continue;
 
+		parked = false;
+
+		now(&dequeued);
+
 /* need to do a getpeername(2) on the socket fd before we dive into the
  * rpc_execute.  9p is messy but we do have the fd....
  */
@@ -1532,7 +1759,10 @@ static void worker_run(struct fridgethr_context *ctx)
 			LogDebug(COMPONENT_DISPATCH,
 				 "NFS protocol request, nfsreq=%p xprt=%p req_cnt=%d",
 				 nfsreq, nfsreq->r_u.nfs->xprt, reqcnt);
-			nfs_rpc_execute(nfsreq, worker_data);
+			worker_data->cur_req = nfsreq;
+			worker_data->dequeued = dequeued;
+			parked = nfs_rpc_execute(nfsreq, worker_data);
+			worker_data->cur_req = NULL;
 			break;
 
 		case NFS_CALL:
@@ -1547,7 +1777,14 @@ static void worker_run(struct fridgethr_context *ctx)
 #endif
 		}
 
+		/* A parked request is finished by nfs_rpc_async_complete */
+		if (parked)
+			continue;
+
  finalize_req:
+		nfs_rpc_queue_serviced(worker_data->worker_index, nfsreq,
+				       &dequeued);
+
 		/* XXX needed? */
 		LogFullDebug(COMPONENT_DISPATCH,
 			     "Signaling completion of request");
@@ -42,6 +42,7 @@
 #include "nfs_dupreq.h"
 #include "nfs_file_handle.h"
 #include "server_stats.h"
+#include "gsh_iobuf.h"
 
 /* opcode to function array */
 const struct _9p_function_desc _9pfuncdesc[] = {
@@ -123,7 +124,18 @@ void _9p_tcp_process_request(struct _9p_request_data *req9p,
 {
 	u32 outdatalen = 0;
 	int rc = 0;
-	char replydata[_9P_MSG_SIZE];
+	char *replydata;
+
+	/* Sized for the negotiated msize, so RREAD data is read straight
+	 * into the buffer that is sent */
+	replydata = gsh_iobuf_get(req9p->pconn->msize);
+	if (replydata == NULL) {
+		LogMajor(COMPONENT_9P,
+			 "Could not allocate 9P reply buffer on socket #%lu",
+			 req9p->pconn->trans_data.sockfd);
+		_9p_DiscardFlushHook(req9p);
+		return;
+	}
 
 	rc = _9p_process_buffer(req9p, worker_data, replydata, &outdatalen);
 	if (rc != 1) {
@@ -137,6 +149,7 @@ void _9p_tcp_process_request(struct _9p_request_data *req9p,
 				 "Could not send 9P/TCP reply correclty on socket #%lu",
 				 req9p->pconn->trans_data.sockfd);
 	}
+	gsh_iobuf_put(replydata);
 	_9p_DiscardFlushHook(req9p);
 	return;
 }				/* _9p_process_request */
@@ -149,6 +162,7 @@ int _9p_process_buffer(struct _9p_request_data *req9p,
 	u32 msglen;
 	u8 msgtype;
 	int rc = 0;
+	nsecs_elapsed_t start_time;
 
 	msgdata = req9p->_9pmsg;
 
@@ -175,9 +189,11 @@ int _9p_process_buffer(struct _9p_request_data *req9p,
 	*poutlen = req9p->pconn->msize;
 
 	/* Call the 9P service function */
+	start_time = server_stats_clock();
 	rc = _9pfuncdesc[msgtype].service_function(req9p,
 						   (void *)worker_data,
 						   poutlen, replydata);
+	server_stats_9p_done(msgtype, start_time);
 	op_ctx = NULL; /* poison the op context to disgard it */
 	if (rc < 0)
 		LogDebug(COMPONENT_9P, "%s: Error",
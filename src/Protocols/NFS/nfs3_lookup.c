@@ -105,7 +105,8 @@ int nfs3_lookup(nfs_arg_t *arg,
 	if (entry_file && (cache_status == CACHE_INODE_SUCCESS)) {
 		/* Build FH */
 		res->res_lookup3.LOOKUP3res_u.resok.object.data.data_val =
-		    gsh_malloc(sizeof(struct alloc_file_handle_v3));
+		    gsh_arena_alloc(op_ctx->arena,
+				    sizeof(struct alloc_file_handle_v3));
 
 		if (res->res_lookup3.LOOKUP3res_u.resok.object.data.data_val ==
 		    NULL)
@@ -165,8 +166,5 @@ int nfs3_lookup(nfs_arg_t *arg,
  */
 void nfs3_lookup_free(nfs_res_t *res)
 {
-	if (res->res_lookup3.status == NFS3_OK) {
-		gsh_free(res->res_lookup3.LOOKUP3res_u.resok.object.data.
-			 data_val);
-	}
+	/* The handle lives in the request arena */
 }
@@ -44,6 +44,7 @@
 #include "nfs_convert.h"
 #include "server_stats.h"
 #include "export_mgr.h"
+#include "gsh_iobuf.h"
 #include "sal_functions.h"
 
 static void nfs_read_ok(struct svc_req *req,
@@ -52,7 +53,7 @@ static void nfs_read_ok(struct svc_req *req,
 			int eof)
 {
 	if ((read_size == 0) && (data != NULL)) {
-		gsh_free(data);
+		gsh_iobuf_put(data);
 		data = NULL;
 	}
 
@@ -68,6 +69,116 @@ static void nfs_read_ok(struct svc_req *req,
 	res->res_read3.status = NFS3_OK;
 }
 
+/**
+ * @brief State of a parked READ
+ */
+
+struct nfs3_read_async {
+	request_data_t *rpc;	/*< The parked request */
+	struct svc_req *req;
+	nfs_res_t *res;
+	struct fsal_io_arg read_arg;	/*< Followed by its one iovec */
+};
+
+/**
+ * @brief Finish a parked READ
+ *
+ * @param[in] entry        File read
+ * @param[in] cache_status Result of the read
+ * @param[in] read_arg     Position, buffer and amount read
+ * @param[in] caller_arg   The nfs3_read_async
+ */
+
+static void nfs3_read_done(cache_entry_t *entry,
+			   cache_inode_status_t cache_status,
+			   struct fsal_io_arg *read_arg,
+			   void *caller_arg)
+{
+	struct nfs3_read_async *rd = caller_arg;
+	nfs_res_t *res = rd->res;
+	void *data = read_arg->iov[0].iov_base;
+	int rc = NFS_REQ_OK;
+
+	state_share_anonymous_io_done(entry, OPEN4_SHARE_ACCESS_READ);
+
+	if (cache_status == CACHE_INODE_SUCCESS) {
+		nfs_read_ok(rd->req, res, data, read_arg->io_amount, entry,
+			    read_arg->end_of_file);
+	} else {
+		gsh_iobuf_put(data);
+
+		if (nfs_RetryableError(cache_status)) {
+			rc = NFS_REQ_DROP;
+		} else {
+			res->res_read3.status = nfs3_Errno(cache_status);
+			nfs_SetPostOpAttr(entry,
+					  &res->res_read3.READ3res_u.resfail.
+					  file_attributes);
+		}
+	}
+
+	cache_inode_put(entry);
+
+	server_stats_io_done(read_arg->iov[0].iov_len, read_arg->io_amount,
+			     (rc == NFS_REQ_OK) ? true : false,
+			     false);
+
+	nfs_rpc_async_complete(rd->rpc, rc);
+	gsh_free(rd);
+}
+
+/**
+ * @brief Start a READ without holding the worker
+ *
+ * On success the request is parked and the entry reference, the share
+ * reservation and the buffer belong to nfs3_read_done.
+ *
+ * @param[in] entry  File to read
+ * @param[in] worker Worker thread data
+ * @param[in] req    SVC request
+ * @param[in] res    Result to fill in
+ * @param[in] offset Where to read
+ * @param[in] size   How much to read
+ * @param[in] data   Buffer to read into
+ *
+ * @return true if the READ was started, false if it must be done in
+ *         line.
+ */
+
+static bool nfs3_read_async(cache_entry_t *entry,
+			    nfs_worker_data_t *worker,
+			    struct svc_req *req, nfs_res_t *res,
+			    uint64_t offset, size_t size, void *data)
+{
+	struct nfs3_read_async *rd;
+
+	if (!op_ctx->fsal_export->exp_ops.fs_supports(op_ctx->fsal_export,
+						      fso_async_io))
+		return false;
+
+	rd = gsh_malloc(sizeof(*rd) + sizeof(struct iovec));
+	if (rd == NULL)
+		return false;
+
+	rd->rpc = nfs_rpc_async_start(worker);
+	if (rd->rpc == NULL) {
+		gsh_free(rd);
+		return false;
+	}
+
+	rd->req = req;
+	rd->res = res;
+	rd->read_arg.offset = offset;
+	rd->read_arg.fsal_stable = false;
+	rd->read_arg.iov_count = 1;
+	rd->read_arg.iov[0].iov_base = data;
+	rd->read_arg.iov[0].iov_len = size;
+
+	cache_inode_rdwr_async(entry, CACHE_INODE_READ, &rd->read_arg,
+			       nfs3_read_done, rd);
+	return true;
+}
+
 /**
  *
  * @brief The NFSPROC3_READ
@@ -82,6 +193,7 @@ static void nfs_read_ok(struct svc_req *req,
  * @retval NFS_REQ_OK if successful
  * @retval NFS_REQ_DROP if failed but retryable
  * @retval NFS_REQ_FAILED if failed and not retryable
+ * @retval NFS_REQ_ASYNC_WAIT if the READ completes asynchronously
  *
  */
 
@@ -208,7 +320,7 @@ int nfs3_read(nfs_arg_t *arg,
 		rc = NFS_REQ_OK;
 		goto out;
 	} else {
-		data = gsh_malloc(size);
+		data = gsh_iobuf_get(size);
 		if (data == NULL) {
 			rc = NFS_REQ_DROP;
 			goto out;
@@ -222,10 +334,15 @@ int nfs3_read(nfs_arg_t *arg,
 
 		if (res->res_read3.status != NFS3_OK) {
 			rc = NFS_REQ_OK;
-			gsh_free(data);
+			gsh_iobuf_put(data);
 			goto out;
 		}
 
+		/* Nothing may be touched once the READ is started */
+		if (nfs3_read_async(entry, worker, req, res, offset, size,
+				    data))
+			return NFS_REQ_ASYNC_WAIT;
+
 		cache_status = cache_inode_rdwr(entry,
 						CACHE_INODE_READ,
 						offset,
@@ -243,7 +360,7 @@ int nfs3_read(nfs_arg_t *arg,
 			rc = NFS_REQ_OK;
 			goto out;
 		}
-		gsh_free(data);
+		gsh_iobuf_put(data);
 	}
 
 	/* If we are here, there was an error */
@@ -281,6 +398,6 @@ void nfs3_read_free(nfs_res_t *res)
 {
 	if ((res->res_read3.status == NFS3_OK)
 	    && (res->res_read3.READ3res_u.resok.data.data_len != 0)) {
-		gsh_free(res->res_read3.READ3res_u.resok.data.data_val);
+		gsh_iobuf_put(res->res_read3.READ3res_u.resok.data.data_val);
 	}
 }
@@ -53,8 +53,6 @@ cache_inode_status_t nfs3_readdir_callback(void *opaque,
 					   uint64_t mounted_on_fileid,
 					   enum cb_state cb_state);
 
-static void free_entry3s(entry3 *entry3s);
-
 /**
  * @brief Opaque bookkeeping structure for NFSv3 readdir
  *
@@ -231,7 +229,9 @@ int nfs3_readdir(nfs_arg_t *arg,
 		}
 	}
 
-	tracker.entries = gsh_calloc(estimated_num_entries, sizeof(entry3));
+	tracker.entries = gsh_arena_calloc(op_ctx->arena,
+					   estimated_num_entries,
+					   sizeof(entry3));
 
 	if (tracker.entries == NULL) {
 		rc = NFS_REQ_DROP;
@@ -346,13 +346,6 @@ int nfs3_readdir(nfs_arg_t *arg,
 	if (parent_dir_entry)
 		cache_inode_put(parent_dir_entry);
 
-	/* Deallocate memory in the event of an error */
-	if (((res->res_readdir3.status != NFS3_OK) || (rc != NFS_REQ_OK))
-	    && (tracker.entries != NULL)) {
-		free_entry3s(tracker.entries);
-		RES_READDIR3_OK->reply.entries = NULL;
-	}
-
 	return rc;
 }				/* nfs3_readdir */
 
@@ -364,11 +357,7 @@ int nfs3_readdir(nfs_arg_t *arg,
  */
 void nfs3_readdir_free(nfs_res_t *resp)
 {
-	if ((resp->res_readdir3.status == NFS3_OK)
-	    && (resp->res_readdir3.READDIR3res_u.resok.reply.entries != NULL)) {
-		free_entry3s(resp->res_readdir3.READDIR3res_u.resok.reply.
-			     entries);
-	}
+	/* Entries and names live in the request arena */
 }
 
 /**
@@ -376,7 +365,7 @@ void nfs3_readdir_free(nfs_res_t *resp)
  *
  * This function is a callback passed to cache_inode_readdir.  It
  * fills in a pre-allocated array of entry3 structures and allocates
- * space for the name and attributes.  This space must be freed.
+ * space for the name from the request arena.
  *
  * @param opaque [in] Pointer to a struct nfs3_readdir_cb_data that is
  *                    gives the location of the array and other
@@ -416,7 +405,8 @@ cache_inode_status_t nfs3_readdir_callback(void *opaque,
 	}
 
 	e3->fileid = attr->fileid;
-	e3->name = gsh_strdup(cb_parms->name);
+	e3->name = gsh_arena_memdup(op_ctx->arena, cb_parms->name,
+				    namelen + 1);
 	if (e3->name == NULL) {
 		tracker->error = NFS3ERR_SERVERFAULT;
 		cb_parms->in_result = false;
@@ -432,24 +422,3 @@ cache_inode_status_t nfs3_readdir_callback(void *opaque,
 	cb_parms->in_result = true;
 	return CACHE_INODE_SUCCESS;
 }				/* */
-
-/**
- * @brief Clean up memory allocated to serve NFSv3 READDIR
- *
- * This function traverses the list of entries, freeing all names
- * allocated in the callback function, then frees the list itself.
- *
- * @param entry3s [in] Pointer to first entry
- */
-
-static void free_entry3s(entry3 *entry3s)
-{
-	entry3 *entry = NULL;
-
-	for (entry = entry3s; entry != NULL; entry = entry->nextentry)
-		gsh_free(entry->name);
-
-	gsh_free(entry3s);
-
-	return;
-}				/* free_entry3s */
@@ -54,8 +54,6 @@ cache_inode_status_t nfs3_readdirplus_callback(void *opaque,
 					       uint64_t mounted_on_fileid,
 					       enum cb_state cb_state);
 
-static void free_entryplus3s(entryplus3 *entryplus3s);
-
 /**
  * @brief Opaque bookkeeping structure for NFSPROC3_READDIRPLUS
  *
@@ -240,7 +238,9 @@ int nfs3_readdirplus(nfs_arg_t *arg,
 		cache_inode_cookie = 0;
 
 	/* Allocate space for entries */
-	tracker.entries = gsh_calloc(estimated_num_entries, sizeof(entryplus3));
+	tracker.entries = gsh_arena_calloc(op_ctx->arena,
+					   estimated_num_entries,
+					   sizeof(entryplus3));
 
 	if (tracker.entries == NULL) {
 		rc = NFS_REQ_DROP;
@@ -367,10 +367,6 @@ int nfs3_readdirplus(nfs_arg_t *arg,
 	if (dir_entry)
 		cache_inode_put(dir_entry);
 
-	if (((res->res_readdir3.status != NFS3_OK) || (rc != NFS_REQ_OK))
-	    && (tracker.entries != NULL))
-		free_entryplus3s(tracker.entries);
-
 	return rc;
 }				/* nfs3_readdirplus */
 
@@ -384,10 +380,7 @@ int nfs3_readdirplus(nfs_arg_t *arg,
  */
 void nfs3_readdirplus_free(nfs_res_t *resp)
 {
-#define RESREADDIRPLUSREPLY resp->res_readdirplus3.READDIRPLUS3res_u.resok.reply
-	if ((resp->res_readdirplus3.status == NFS3_OK)
-	    && (RESREADDIRPLUSREPLY.entries != NULL))
-		free_entryplus3s(RESREADDIRPLUSREPLY.entries);
+	/* Entries, names and handles live in the request arena */
 }
 
 /**
@@ -395,7 +388,7 @@ void nfs3_readdirplus_free(nfs_res_t *resp)
  *
  * This function is a callback passed to cache_inode_readdir.  It
  * fills in a pre-allocated array of entryplys3 structures and allocates
- * space for the name and attributes.  This space must be freed.
+ * space for the name and handle from the request arena.
  *
  * @param opaque [in] Pointer to a struct nfs3_readdirplus_cb_data that is
  *                    gives the location of the array and other
@@ -437,7 +430,8 @@ cache_inode_status_t nfs3_readdirplus_callback(void *opaque,
 	}
 
 	ep3->fileid = attr->fileid;
-	ep3->name = gsh_strdup(cb_parms->name);
+	ep3->name = gsh_arena_memdup(op_ctx->arena, cb_parms->name,
+				     namelen + 1);
 	if (ep3->name == NULL) {
 		tracker->error = NFS3ERR_SERVERFAULT;
 		cb_parms->in_result = false;
@@ -451,13 +445,12 @@ cache_inode_status_t nfs3_readdirplus_callback(void *opaque,
 	if (cb_parms->attr_allowed) {
 		ep3->name_handle.handle_follows = TRUE;
 		ep3->name_handle.post_op_fh3_u.handle.data.data_val =
-		    gsh_malloc(NFS3_FHSIZE);
+		    gsh_arena_alloc(op_ctx->arena, NFS3_FHSIZE);
 		if (ep3->name_handle.post_op_fh3_u.handle.data.data_val
 		    == NULL) {
 			LogEvent(COMPONENT_NFS_READDIR,
 				 "FAILED to allocate FH");
 			tracker->error = NFS3ERR_SERVERFAULT;
-			gsh_free(ep3->name);
 			cb_parms->in_result = false;
 			return CACHE_INODE_SUCCESS;
 		}
@@ -466,9 +459,6 @@ cache_inode_status_t nfs3_readdirplus_callback(void *opaque,
 					entry->obj_handle,
 					op_ctx->export)) {
 			tracker->error = NFS3ERR_SERVERFAULT;
-			gsh_free(ep3->name);
-			gsh_free(ep3->name_handle.post_op_fh3_u.handle.data.
-				 data_val);
 			cb_parms->in_result = false;
 			return CACHE_INODE_SUCCESS;
 		}
@@ -502,26 +492,3 @@ cache_inode_status_t nfs3_readdirplus_callback(void *opaque,
 
 	return CACHE_INODE_SUCCESS;
 }				/* nfs3_readdirplus_callback */
-
-/**
- * @brief Clean up memory allocated to serve NFSv3 READDIRPLUS
- *
- * This function traverses the list of entries, freeing all names
- * allocated in the callback function, then frees the list itself.
- *
- * @param entryplus3s [in] Pointer to first entry
- */
-
-static void free_entryplus3s(entryplus3 *entryplus3s)
-{
-	entryplus3 *entry = NULL;
-
-	for (entry = entryplus3s; entry != NULL; entry = entry->nextentry) {
-		gsh_free(entry->name);
-		gsh_free(entry->name_handle.post_op_fh3_u.handle.data.data_val);
-	}
-
-	gsh_free(entryplus3s);
-
-	return;
-}				/* free_entryplus3s */
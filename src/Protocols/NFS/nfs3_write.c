@@ -48,6 +48,149 @@
 #include "export_mgr.h"
 #include "sal_functions.h"
 
+/**
+ * @brief Fill in the result of a successful WRITE
+ *
+ * @param[out] res          Result
+ * @param[in]  entry        File written
+ * @param[in]  written_size Bytes written
+ * @param[in]  sync         Whether the data is stable
+ */
+
+static void nfs3_write_ok(nfs_res_t *res, cache_entry_t *entry,
+			  size_t written_size, bool sync)
+{
+	/* Build Weak Cache Coherency data */
+	nfs_SetWccData(NULL, entry,
+		       &res->res_write3.WRITE3res_u.resok.file_wcc);
+
+	/* Set the written size */
+	res->res_write3.WRITE3res_u.resok.count = written_size;
+
+	/* How do we commit data ? */
+	if (sync)
+		res->res_write3.WRITE3res_u.resok.committed = FILE_SYNC;
+	else
+		res->res_write3.WRITE3res_u.resok.committed = UNSTABLE;
+
+	/* Set the write verifier */
+	memcpy(res->res_write3.WRITE3res_u.resok.verf,
+	       NFS3_write_verifier,
+	       sizeof(writeverf3));
+
+	res->res_write3.status = NFS3_OK;
+}
+
+/**
+ * @brief State of a parked WRITE
+ */
+
+struct nfs3_write_async {
+	request_data_t *rpc;	/*< The parked request */
+	nfs_res_t *res;
+	struct fsal_io_arg write_arg;	/*< Followed by its one iovec */
+};
+
+/**
+ * @brief Finish a parked WRITE
+ *
+ * @param[in] entry        File written
+ * @param[in] cache_status Result of the write
+ * @param[in] write_arg    Position, buffer, amount and stability
+ * @param[in] caller_arg   The nfs3_write_async
+ */
+
+static void nfs3_write_done(cache_entry_t *entry,
+			    cache_inode_status_t cache_status,
+			    struct fsal_io_arg *write_arg,
+			    void *caller_arg)
+{
+	struct nfs3_write_async *wr = caller_arg;
+	nfs_res_t *res = wr->res;
+	int rc = NFS_REQ_OK;
+
+	state_share_anonymous_io_done(entry, OPEN4_SHARE_ACCESS_WRITE);
+
+	if (cache_status == CACHE_INODE_SUCCESS) {
+		nfs3_write_ok(res, entry, write_arg->io_amount,
+			      write_arg->fsal_stable);
+	} else {
+		LogFullDebug(COMPONENT_NFSPROTO,
+			     "failed write: cache_status=%s",
+			     cache_inode_err_str(cache_status));
+
+		if (nfs_RetryableError(cache_status)) {
+			rc = NFS_REQ_DROP;
+		} else {
+			res->res_write3.status = nfs3_Errno(cache_status);
+			nfs_SetWccData(NULL, entry,
+				       &res->res_write3.WRITE3res_u.resfail.
+				       file_wcc);
+		}
+	}
+
+	cache_inode_put(entry);
+
+	server_stats_io_done(write_arg->iov[0].iov_len, write_arg->io_amount,
+			     (rc == NFS_REQ_OK) ? true : false,
+			     true);
+
+	nfs_rpc_async_complete(wr->rpc, rc);
+	gsh_free(wr);
+}
+
+/**
+ * @brief Start a WRITE without holding the worker
+ *
+ * On success the request is parked and the entry reference and the
+ * share reservation belong to nfs3_write_done.  The data stays in the
+ * request's arguments, which are only freed once it completes.
+ *
+ * @param[in] entry  File to write
+ * @param[in] worker Worker thread data
+ * @param[in] res    Result to fill in
+ * @param[in] offset Where to write
+ * @param[in] size   How much to write
+ * @param[in] data   Data to write
+ * @param[in] sync   Whether a stable write was requested
+ *
+ * @return true if the WRITE was started, false if it must be done in
+ *         line.
+ */
+
+static bool nfs3_write_async(cache_entry_t *entry,
+			     nfs_worker_data_t *worker,
+			     nfs_res_t *res, uint64_t offset, size_t size,
+			     void *data, bool sync)
+{
+	struct nfs3_write_async *wr;
+
+	if (!op_ctx->fsal_export->exp_ops.fs_supports(op_ctx->fsal_export,
+						      fso_async_io))
+		return false;
+
+	wr = gsh_malloc(sizeof(*wr) + sizeof(struct iovec));
+	if (wr == NULL)
+		return false;
+
+	wr->rpc = nfs_rpc_async_start(worker);
+	if (wr->rpc == NULL) {
+		gsh_free(wr);
+		return false;
+	}
+
+	wr->res = res;
+	wr->write_arg.offset = offset;
+	wr->write_arg.fsal_stable = sync;
+	wr->write_arg.iov_count = 1;
+	wr->write_arg.iov[0].iov_base = data;
+	wr->write_arg.iov[0].iov_len = size;
+
+	cache_inode_rdwr_async(entry, CACHE_INODE_WRITE, &wr->write_arg,
+			       nfs3_write_done, wr);
+	return true;
+}
+
 /**
  *
  * @brief The NFSPROC3_WRITE
@@ -62,6 +205,7 @@
  * @retval NFS_REQ_OK if successful
  * @retval NFS_REQ_DROP if failed but retryable
  * @retval NFS_REQ_FAILED if failed and not retryable
+ * @retval NFS_REQ_ASYNC_WAIT if the WRITE completes asynchronously
  *
  */
 
@@ -230,6 +374,11 @@ int nfs3_write(nfs_arg_t *arg,
 			goto out;
 		}
 
+		/* Nothing may be touched once the WRITE is started */
+		if (nfs3_write_async(entry, worker, res, offset, size, data,
+				     sync))
+			return NFS_REQ_ASYNC_WAIT;
+
 		cache_status =
 		    cache_inode_rdwr(entry, CACHE_INODE_WRITE, offset, size,
 				     &written_size, data, &eof_met, &sync);
@@ -237,29 +386,7 @@ int nfs3_write(nfs_arg_t *arg,
 		state_share_anonymous_io_done(entry, OPEN4_SHARE_ACCESS_WRITE);
 
 		if (cache_status == CACHE_INODE_SUCCESS) {
-			/* Build Weak Cache Coherency data */
-			nfs_SetWccData(NULL, entry,
-				       &res->res_write3.WRITE3res_u.resok.
-				       file_wcc);
-
-			/* Set the written size */
-			res->res_write3.WRITE3res_u.resok.count = written_size;
-
-			/* How do we commit data ? */
-			if (sync)
-				res->res_write3.WRITE3res_u.resok.committed =
-				    FILE_SYNC;
-			else
-				res->res_write3.WRITE3res_u.resok.committed =
-				    UNSTABLE;
-
-			/* Set the write verifier */
-			memcpy(res->res_write3.WRITE3res_u.resok.verf,
-			       NFS3_write_verifier,
-			       sizeof(writeverf3));
-
-			res->res_write3.status = NFS3_OK;
-
+			nfs3_write_ok(res, entry, written_size, sync);
 			rc = NFS_REQ_OK;
 			goto out;
 		}
@@ -361,9 +361,9 @@ static const struct nfs4_op_desc optabv4[] = {
 				.exp_perm_flags = 0},
 	[NFS4_OP_COPY] = {
 				.name = "OP_COPY",
-				.funct = nfs4_op_notsupp,
-				.free_res = nfs4_op_notsupp_Free,
-				.exp_perm_flags = 0},
+				.funct = nfs4_op_copy,
+				.free_res = nfs4_op_copy_Free,
+				.exp_perm_flags = EXPORT_OPTION_RW_ACCESS},
 	[NFS4_OP_COPY_NOTIFY] = {
 				.name = "OP_COPY_NOTIFY",
 				.funct = nfs4_op_notsupp,
@@ -391,13 +391,13 @@ static const struct nfs4_op_desc optabv4[] = {
 				.exp_perm_flags = 0},
 	[NFS4_OP_OFFLOAD_CANCEL] = {
 				.name = "OP_OFFLOAD_CANCEL",
-				.funct = nfs4_op_notsupp,
-				.free_res = nfs4_op_notsupp_Free,
+				.funct = nfs4_op_offload_cancel,
+				.free_res = nfs4_op_offload_cancel_Free,
 				.exp_perm_flags = 0},
 	[NFS4_OP_OFFLOAD_STATUS] = {
 				.name = "OP_OFFLOAD_STATUS",
-				.funct = nfs4_op_notsupp,
-				.free_res = nfs4_op_notsupp_Free,
+				.funct = nfs4_op_offload_status,
+				.free_res = nfs4_op_offload_status_Free,
 				.exp_perm_flags = 0},
 	[NFS4_OP_READ_PLUS] = {
 				.name = "OP_READ_PLUS",
@@ -414,6 +414,11 @@ static const struct nfs4_op_desc optabv4[] = {
 				.funct = nfs4_op_write_plus,
 				.free_res = nfs4_op_write_Free,
 				.exp_perm_flags = 0},
+	[NFS4_OP_CLONE] = {
+				.name = "OP_CLONE",
+				.funct = nfs4_op_clone,
+				.free_res = nfs4_op_clone_Free,
+				.exp_perm_flags = EXPORT_OPTION_RW_ACCESS},
 };
 
 /** Define the last valid NFS v4 op for each minor version.
@@ -422,9 +427,41 @@ static const struct nfs4_op_desc optabv4[] = {
 nfs_opnum4 LastOpcode[] = {
 	NFS4_OP_RELEASE_LOCKOWNER,
 	NFS4_OP_RECLAIM_COMPLETE,
-	NFS4_OP_WRITE_SAME
+	NFS4_OP_CLONE
 };
 
+/**
+ * @brief Estimate the memory a COMPOUND reply holds
+ *
+ * The result array, the arena the results are built in, and READ data,
+ * the only other large buffer a result points to.
+ *
+ * @param[in] res   The reply
+ * @param[in] arena The arena it was built in
+ *
+ * @return Bytes held.
+ */
+
+static size_t compound_res_size(COMPOUND4res *res, struct gsh_arena *arena)
+{
+	size_t size = res->resarray.resarray_len * sizeof(nfs_resop4);
+	unsigned int i;
+
+	if (arena != NULL)
+		size += arena->size;
+
+	for (i = 0; i < res->resarray.resarray_len; i++) {
+		READ4res *read = &res->resarray.resarray_val[i].nfs_resop4_u.
+		    opread;
+
+		if (res->resarray.resarray_val[i].resop == NFS4_OP_READ &&
+		    read->status == NFS4_OK)
+			size += read->READ4res_u.resok4.data.data_len;
+	}
+
+	return size;
+}
+
 /**
  * @brief The NFS PROC4 COMPOUND
  *
@@ -464,6 +501,7 @@ int nfs4_Compound(nfs_arg_t *arg,
 	struct timespec ts;
 	int perm_flags;
 	char *tagname = NULL;
+	bool cached = false;
 
 	if (compound4_minor > 2) {
 		LogCrit(COMPONENT_NFS_V4, "Bad Minor Version %d",
@@ -707,6 +745,21 @@ int nfs4_Compound(nfs_arg_t *arg,
 					i + 1;
 				break;
 			}
+
+			/* Hold off I/O beyond the export's rate limits */
+			if (op_ctx->export != NULL
+			    && (opcode == NFS4_OP_READ
+				|| opcode == NFS4_OP_WRITE)
+			    && !export_throttle_admit(op_ctx->export,
+				opcode == NFS4_OP_READ
+				? argarray[i].nfs_argop4_u.opread.count
+				: argarray[i].nfs_argop4_u.opwrite.data.data_len)) {
+				status = NFS4ERR_DELAY;
+				LogDebugAlt(COMPONENT_NFS_V4, COMPONENT_EXPORT,
+					    "Export_Id %d is over its rate limit",
+					    op_ctx->export->export_id);
+				goto bad_op_state;
+			}
 		}
 
 		status = (optabv4[opcode].funct) (&argarray[i],
@@ -772,25 +825,62 @@ int nfs4_Compound(nfs_arg_t *arg,
 	 */
 	if (data.cached_res != NULL && !data.use_drc) {
 		/* Pointer has been set by nfs4_op_sequence and points to slot
-		 * to cache result in.
+		 * to cache result in, or by nfs4_op_create_session.
 		 */
-		LogFullDebug(COMPONENT_SESSIONS,
-			     "Save result in session replay cache %p sizeof nfs_res_t=%d",
-			     data.cached_res, (int)sizeof(nfs_res_t));
+		nfs41_session_slot_t *slot = NULL;
+		size_t size = compound_res_size(&res->res_compound4,
+						op_ctx->arena);
+
+		if (data.session != NULL &&
+		    data.cached_res ==
+		    &data.session->slots[data.slot].cached_result)
+			slot = &data.session->slots[data.slot];
+
+		if (slot != NULL)
+			PTHREAD_MUTEX_lock(&slot->lock);
+
+		if (slot == NULL || nfs41_Session_Slot_Reserve(size)) {
+			LogFullDebug(COMPONENT_SESSIONS,
+				     "Save result in session replay cache %p size %zu",
+				     data.cached_res, size);
 
-		/* Indicate to nfs4_Compound_Free that this reply is cached. */
-		res->res_compound4_extended.res_cached = true;
+			/* Indicate to nfs4_Compound_Free that this reply is
+			 * cached.
+			 */
+			res->res_compound4_extended.res_cached = true;
 
-		/* If the cache is already in use, free it. */
-		if (data.cached_res->res_cached) {
-			data.cached_res->res_cached = false;
-			nfs4_Compound_Free((nfs_res_t *) data.cached_res);
+			/* If the cache is already in use, free it. */
+			if (data.cached_res->res_cached) {
+				data.cached_res->res_cached = false;
+				nfs4_Compound_Free((nfs_res_t *)
+						   data.cached_res);
+			}
+
+			/* Save the result in the cache, along with the memory
+			 * it points to.
+			 */
+			*data.cached_res = res->res_compound4_extended;
+			gsh_arena_move(&data.cached_res->arena, op_ctx->arena);
+			cached = true;
+		} else {
+			LogDebug(COMPONENT_SESSIONS,
+				 "Session replay cache full, not caching %zu bytes for slot %"
+				 PRIu32, size, data.slot);
 		}
 
-		/* Save the result in the cache. */
-		*data.cached_res = res->res_compound4_extended;
+		if (slot != NULL) {
+			if (cached) {
+				slot->cache_used = true;
+				slot->cache_size = size;
+			}
+			slot->in_progress = false;
+			PTHREAD_MUTEX_unlock(&slot->lock);
+		}
 	}
 
+	if (data.session != NULL)
+		server_stats_slot_done(op_ctx->client, cached);
+
 	/* If we have reserved a lease, update it and release it */
 	if (data.preserved_clientid != NULL) {
 		/* Update and release lease */
@@ -873,6 +963,9 @@ void nfs4_Compound_Free(nfs_res_t *res)
 	if (res->res_compound4.tag.utf8string_val)
 		gsh_free(res->res_compound4.tag.utf8string_val);
 
+	/* Only set for a result leaving a session slot */
+	gsh_arena_release(&res->res_compound4_extended.arena);
+
 	return;
 }
 
@@ -1055,6 +1148,7 @@ void nfs4_Compound_CopyResOne(nfs_resop4 *res_dst, nfs_resop4 *res_src)
 	case NFS4_OP_READ_PLUS:
 	case NFS4_OP_SEEK:
 	case NFS4_OP_WRITE_SAME:
+	case NFS4_OP_CLONE:
 	case NFS4_OP_LAST_ONE:
 		break;
 
@@ -0,0 +1,1037 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * @file    nfs4_op_copy.c
+ * @brief   NFSv4.2 COPY, CLONE, OFFLOAD_STATUS and OFFLOAD_CANCEL
+ *
+ * Only copies within this server are done; a COPY naming source
+ * servers gets NFS4ERR_NOTSUPP, as does COPY_NOTIFY.
+ *
+ * A synchronous COPY moves at most Copy_Chunk_Size bytes and returns
+ * a short count for the client to continue from.  An asynchronous
+ * COPY is given a stateid and run on the copy fridge a chunk at a
+ * time, so it can be watched with OFFLOAD_STATUS and stopped with
+ * OFFLOAD_CANCEL between chunks.  When it finishes the client is
+ * told with CB_OFFLOAD, and OFFLOAD_STATUS reports its final status
+ * until the client has answered that.
+ */
+#include "config.h"
+#include <string.h>
+#include <pthread.h>
+#include <sys/param.h>
+#include "log.h"
+#include "fsal.h"
+#include "nfs_core.h"
+#include "sal_functions.h"
+#include "nfs_proto_functions.h"
+#include "nfs_proto_tools.h"
+#include "nfs_convert.h"
+#include "nfs_file_handle.h"
+#include "cache_inode_lru.h"
+#include "nfs_rpc_callback.h"
+#include "export_mgr.h"
+#include "fridgethr.h"
+#include "abstract_atomic.h"
+
+/**
+ * @brief An asynchronous COPY
+ *
+ * Lives on nfs4_copies from when it is accepted until the client has
+ * answered its CB_OFFLOAD.  A copy that is cancelled, or whose
+ * CB_OFFLOAD could not be sent, stays there once finished until its
+ * stateid is released by OFFLOAD_CANCEL or with its client.  The
+ * flags and status are protected by nfs4_copy_mutex.
+ */
+
+struct nfs4_copy {
+	struct glist_head copy_list;	/*< Link in nfs4_copies */
+	stateid4 stateid;		/*< Returned in wr_callback_id */
+	nfs_client_id_t *client;	/*< Client that asked, referenced */
+	struct gsh_export *export;	/*< Export of both files, referenced */
+	cache_entry_t *src;		/*< Source, referenced */
+	cache_entry_t *dst;		/*< Destination, referenced */
+	uint64_t src_offset;
+	uint64_t dst_offset;
+	uint64_t count;			/*< Bytes to copy */
+	uint64_t copied;		/*< Bytes copied so far, atomic */
+	bool cancelled;			/*< Set by OFFLOAD_CANCEL */
+	bool done;			/*< Finished, status is final */
+	bool cb_pending;		/*< CB_OFFLOAD sent, not answered */
+	nfsstat4 status;		/*< Final status, once done */
+	nfs_fh4 dst_fh;			/*< Destination handle for CB_OFFLOAD */
+	nfs_cb_argop4 arg;		/*< CB_OFFLOAD arguments */
+};
+
+static struct fridgethr *copy_fridge;
+
+/* Asynchronous copies in progress, and whether to stop them */
+static pthread_mutex_t nfs4_copy_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct glist_head nfs4_copies = GLIST_HEAD_INIT(nfs4_copies);
+static uint32_t nfs4_copy_serial;
+static bool nfs4_copy_stopping;
+
+/**
+ * @brief Check a COPY or CLONE stateid for the access it needs
+ *
+ * @param[in]     stateid    The stateid
+ * @param[in]     entry      File it is for
+ * @param[in,out] data       Compound request's data
+ * @param[in]     access     OPEN4_SHARE_ACCESS_READ or _WRITE
+ * @param[in]     tag        Operation name for logging
+ * @param[out]    anonymous  Set to true if the stateid is special and
+ *                           anonymous I/O has been started, which the
+ *                           caller must finish.
+ *
+ * @return NFS4_OK or errors.
+ */
+
+static nfsstat4 copy_check_stateid(stateid4 *stateid, cache_entry_t *entry,
+				   compound_data_t *data, int access,
+				   const char *tag, bool *anonymous)
+{
+	state_t *state_found = NULL;
+	state_t *state_open = NULL;
+	struct state_deleg *sdeleg;
+	cache_inode_status_t cache_status;
+	nfsstat4 status;
+
+	*anonymous = false;
+
+	status = nfs4_Check_Stateid(stateid, entry, &state_found, data,
+				    STATEID_SPECIAL_ANY, 0, false, tag);
+	if (status != NFS4_OK)
+		return status;
+
+	if (state_found == NULL) {
+		/* Special stateid, check to see if any share conflicts */
+		status = nfs4_Errno_state(
+			state_share_anonymous_io_start(entry, access,
+						       SHARE_BYPASS_NONE));
+		if (status != NFS4_OK)
+			return status;
+
+		if (entry->obj_handle->attributes.owner !=
+		    op_ctx->creds->caller_uid) {
+			cache_status = cache_inode_access(
+				entry,
+				access == OPEN4_SHARE_ACCESS_WRITE
+				? FSAL_WRITE_ACCESS : FSAL_READ_ACCESS);
+			if (cache_status != CACHE_INODE_SUCCESS) {
+				state_share_anonymous_io_done(entry, access);
+				return nfs4_Errno(cache_status);
+			}
+		}
+
+		*anonymous = true;
+		return NFS4_OK;
+	}
+
+	switch (state_found->state_type) {
+	case STATE_TYPE_SHARE:
+		state_open = state_found;
+		break;
+
+	case STATE_TYPE_LOCK:
+		state_open = state_found->state_data.lock.openstate;
+		break;
+
+	case STATE_TYPE_DELEG:
+		sdeleg = &state_found->state_data.deleg;
+		if (sdeleg->sd_state != DELEG_GRANTED ||
+		    (access == OPEN4_SHARE_ACCESS_WRITE &&
+		     !(sdeleg->sd_type & OPEN_DELEGATE_WRITE))) {
+			LogDebug(COMPONENT_STATE,
+				 "%s delegation type:%d state:%d", tag,
+				 sdeleg->sd_type, sdeleg->sd_state);
+			status = NFS4ERR_BAD_STATEID;
+		}
+		break;
+
+	default:
+		LogDebug(COMPONENT_NFS_V4_LOCK,
+			 "%s with invalid stateid of type %d", tag,
+			 (int)state_found->state_type);
+		status = NFS4ERR_BAD_STATEID;
+	}
+
+	if (state_open != NULL &&
+	    (state_open->state_data.share.share_access & access) == 0) {
+		LogDebug(COMPONENT_NFS_V4_LOCK,
+			 "%s stateid doesn't have share access %d", tag,
+			 access);
+		status = NFS4ERR_OPENMODE;
+	}
+
+	dec_state_t_ref(state_found);
+
+	return status;
+}
+
+/**
+ * @brief Check the files and stateids of a COPY or CLONE
+ *
+ * The source is the saved filehandle and the destination the current
+ * one.  Both must be regular files in the same export.
+ *
+ * @param[in,out] data           Compound request's data
+ * @param[in]     src_stateid    Stateid for reading the source
+ * @param[in]     dst_stateid    Stateid for writing the destination
+ * @param[in]     tag            Operation name for logging
+ * @param[out]    anonymous_src  Anonymous read of the source started
+ * @param[out]    anonymous_dst  Anonymous write of the destination
+ *                               started
+ *
+ * @return NFS4_OK or errors.
+ */
+
+static nfsstat4 copy_check_files(compound_data_t *data,
+				 stateid4 *src_stateid,
+				 stateid4 *dst_stateid,
+				 const char *tag,
+				 bool *anonymous_src,
+				 bool *anonymous_dst)
+{
+	nfsstat4 status;
+
+	*anonymous_src = false;
+	*anonymous_dst = false;
+
+	status = nfs4_sanity_check_FH(data, REGULAR_FILE, false);
+	if (status != NFS4_OK)
+		return status;
+
+	status = nfs4_sanity_check_saved_FH(data, REGULAR_FILE, false);
+	if (status != NFS4_OK)
+		return status;
+
+	if (data->saved_export != op_ctx->export)
+		return NFS4ERR_XDEV;
+
+	status = copy_check_stateid(src_stateid, data->saved_entry, data,
+				    OPEN4_SHARE_ACCESS_READ, tag,
+				    anonymous_src);
+	if (status != NFS4_OK)
+		return status;
+
+	status = copy_check_stateid(dst_stateid, data->current_entry, data,
+				    OPEN4_SHARE_ACCESS_WRITE, tag,
+				    anonymous_dst);
+	if (status != NFS4_OK && *anonymous_src) {
+		state_share_anonymous_io_done(data->saved_entry,
+					      OPEN4_SHARE_ACCESS_READ);
+		*anonymous_src = false;
+	}
+
+	return status;
+}
+
+/**
+ * @brief Finish the anonymous I/O started by copy_check_files
+ */
+
+static void copy_done_files(compound_data_t *data, bool anonymous_src,
+			    bool anonymous_dst)
+{
+	if (anonymous_src)
+		state_share_anonymous_io_done(data->saved_entry,
+					      OPEN4_SHARE_ACCESS_READ);
+	if (anonymous_dst)
+		state_share_anonymous_io_done(data->current_entry,
+					      OPEN4_SHARE_ACCESS_WRITE);
+}
+
+/**
+ * @brief Check the range of a COPY or CLONE
+ *
+ * A count of 0 means to the end of the source.  The source range
+ * must be within the file, and a file copied onto itself must not
+ * overlap.
+ *
+ * @param[in]     src        Source file
+ * @param[in]     src_offset Position in the source
+ * @param[in]     dst        Destination file
+ * @param[in]     dst_offset Position in the destination
+ * @param[in,out] count      Bytes asked for, and to copy
+ *
+ * @return NFS4_OK or errors.
+ */
+
+static nfsstat4 copy_check_range(cache_entry_t *src, uint64_t src_offset,
+				 cache_entry_t *dst, uint64_t dst_offset,
+				 uint64_t *count)
+{
+	cache_inode_status_t cache_status;
+	uint64_t size;
+
+	cache_status = cache_inode_lock_trust_attrs(src, false);
+	if (cache_status != CACHE_INODE_SUCCESS)
+		return nfs4_Errno(cache_status);
+	size = src->obj_handle->attributes.filesize;
+	PTHREAD_RWLOCK_unlock(&src->attr_lock);
+
+	if (src_offset > size)
+		return NFS4ERR_INVAL;
+	if (*count == 0)
+		*count = size - src_offset;
+	else if (*count > size - src_offset)
+		return NFS4ERR_INVAL;
+
+	if (*count > UINT64_MAX - dst_offset)
+		return NFS4ERR_INVAL;
+
+	if (src == dst && *count != 0 &&
+	    src_offset < dst_offset + *count &&
+	    dst_offset < src_offset + *count)
+		return NFS4ERR_INVAL;
+
+	if (dst_offset + *count > op_ctx->export->MaxOffsetWrite) {
+		LogEvent(COMPONENT_NFS_V4,
+			 "A client tryed to violate max file size %" PRIu64
+			 " for exportid #%hu",
+			 op_ctx->export->MaxOffsetWrite,
+			 op_ctx->export->export_id);
+		return NFS4ERR_DQUOT;
+	}
+
+	return NFS4_OK;
+}
+
+/**
+ * @brief Release everything an asynchronous copy holds
+ *
+ * @param[in] copy The copy, off nfs4_copies
+ */
+
+static void nfs4_copy_free(struct nfs4_copy *copy)
+{
+	if (copy->src != NULL)
+		cache_inode_put(copy->src);
+	if (copy->dst != NULL)
+		cache_inode_put(copy->dst);
+	if (copy->export != NULL)
+		put_gsh_export(copy->export);
+	dec_client_id_ref(copy->client);
+	gsh_free(copy->dst_fh.nfs_fh4_val);
+	gsh_free(copy);
+}
+
+/**
+ * @brief Handle the reply to CB_OFFLOAD
+ *
+ * Whatever the reply, the client has had its chance to hear about
+ * the copy, so its stateid is released.
+ *
+ * @param[in] call  The RPC call being completed
+ * @param[in] hook  The hook itself
+ * @param[in] arg   The copy
+ * @param[in] flags There are no flags.
+ *
+ * @return 0, constantly.
+ */
+
+static int32_t copy_offload_completion(rpc_call_t *call, rpc_call_hook hook,
+				       void *arg, uint32_t flags)
+{
+	struct nfs4_copy *copy = arg;
+
+	LogFullDebug(COMPONENT_NFS_CB, "hook %d status %d copy %p",
+		     hook, call->cbt.v_u.v4.res.status, copy);
+
+	nfs41_complete_single(call, hook, copy, flags);
+
+	PTHREAD_MUTEX_lock(&nfs4_copy_mutex);
+	glist_del(&copy->copy_list);
+	PTHREAD_MUTEX_unlock(&nfs4_copy_mutex);
+
+	nfs4_copy_free(copy);
+	return 0;
+}
+
+/**
+ * @brief Run an asynchronous copy
+ *
+ * Access was checked when the copy was accepted, so it runs with
+ * root credentials, like other background work.
+ *
+ * @param[in] ctx Thread context, whose arg is the copy
+ */
+
+static void nfs4_copy_run(struct fridgethr_context *ctx)
+{
+	struct nfs4_copy *copy = ctx->arg;
+	CB_OFFLOAD4args *cb_offload = &copy->arg.nfs_cb_argop4_u.opcboffload;
+	offload_info4 *info = &cb_offload->coa_offload_info;
+	write_response4 *wr = &info->offload_info4_u.coa_resok4;
+	struct root_op_context root_op_context;
+	cache_inode_status_t status = CACHE_INODE_SUCCESS;
+	struct gsh_buffdesc verf_desc;
+	uint64_t copied = 0;
+	uint64_t chunk, moved;
+	bool sync = false;
+	bool stop;
+
+	init_root_op_context(&root_op_context, copy->export,
+			     copy->export->fsal_export, NFS_V4, 2,
+			     NFS_REQUEST);
+
+	while (copied < copy->count) {
+		PTHREAD_MUTEX_lock(&nfs4_copy_mutex);
+		stop = copy->cancelled || nfs4_copy_stopping;
+		PTHREAD_MUTEX_unlock(&nfs4_copy_mutex);
+		if (stop)
+			break;
+
+		chunk = MIN(copy->count - copied,
+			    nfs_param.nfsv4_param.copy_chunk_size);
+		status = cache_inode_copy(copy->src,
+					  copy->src_offset + copied,
+					  copy->dst,
+					  copy->dst_offset + copied,
+					  chunk, &moved, &sync);
+		if (status != CACHE_INODE_SUCCESS || moved == 0)
+			break;
+
+		copied += moved;
+		atomic_store_uint64_t(&copy->copied, copied);
+	}
+
+	memset(&copy->arg, 0, sizeof(copy->arg));
+	copy->arg.argop = NFS4_OP_CB_OFFLOAD;
+	cb_offload->coa_fh = copy->dst_fh;
+	cb_offload->coa_stateid = copy->stateid;
+
+	if (status == CACHE_INODE_SUCCESS) {
+		info->coa_status = NFS4_OK;
+		wr->wr_count = copied;
+		wr->wr_committed = sync ? FILE_SYNC4 : UNSTABLE4;
+		verf_desc.addr = wr->wr_writeverf;
+		verf_desc.len = sizeof(verifier4);
+		op_ctx->fsal_export->exp_ops.get_write_verifier(&verf_desc);
+	} else {
+		info->coa_status = nfs4_Errno(status);
+		info->offload_info4_u.coa_bytes_copied = copied;
+	}
+
+	release_root_op_context();
+
+	LogDebug(COMPONENT_NFS_V4,
+		 "Copy %p finished with %s after %" PRIu64 " of %" PRIu64
+		 " bytes", copy, nfsstat4_to_str(info->coa_status), copied,
+		 copy->count);
+
+	/* The completion may run before nfs_rpc_v41_single returns, so
+	 * the copy is marked as waiting for it first.
+	 */
+	PTHREAD_MUTEX_lock(&nfs4_copy_mutex);
+	copy->status = info->coa_status;
+	copy->done = true;
+	stop = copy->cancelled || nfs4_copy_stopping;
+	if (stop)
+		glist_del(&copy->copy_list);
+	else
+		copy->cb_pending = true;
+	PTHREAD_MUTEX_unlock(&nfs4_copy_mutex);
+
+	/* The files and export are not needed for the callback */
+	cache_inode_put(copy->src);
+	copy->src = NULL;
+	cache_inode_put(copy->dst);
+	copy->dst = NULL;
+	put_gsh_export(copy->export);
+	copy->export = NULL;
+
+	/* A cancelled copy is not reported */
+	if (stop) {
+		nfs4_copy_free(copy);
+		return;
+	}
+
+	if (nfs_rpc_v41_single(copy->client, &copy->arg, NULL,
+			       copy_offload_completion, copy, NULL) == 0)
+		return;
+
+	/* Leave it for OFFLOAD_STATUS, unless it was cancelled while we
+	 * were trying */
+	PTHREAD_MUTEX_lock(&nfs4_copy_mutex);
+	copy->cb_pending = false;
+	stop = copy->cancelled || nfs4_copy_stopping;
+	if (stop)
+		glist_del(&copy->copy_list);
+	PTHREAD_MUTEX_unlock(&nfs4_copy_mutex);
+
+	if (stop)
+		nfs4_copy_free(copy);
+}
+
+/**
+ * @brief Start an asynchronous copy
+ *
+ * @param[in]  data       Compound request's data
+ * @param[in]  src_offset Position in the source
+ * @param[in]  dst_offset Position in the destination
+ * @param[in]  count      Bytes to copy
+ * @param[out] stateid    The copy's stateid
+ *
+ * @return true if the copy was started, false if it must be done
+ *         synchronously.
+ */
+
+static bool nfs4_copy_start(compound_data_t *data, uint64_t src_offset,
+			    uint64_t dst_offset, uint64_t count,
+			    stateid4 *stateid)
+{
+	struct nfs4_copy *copy;
+	uint32_t serial;
+
+	if (copy_fridge == NULL || data->session == NULL ||
+	    !(data->session->flags & session_bc_up))
+		return false;
+
+	copy = gsh_calloc(1, sizeof(*copy));
+	if (copy == NULL)
+		return false;
+
+	copy->dst_fh.nfs_fh4_val = gsh_malloc(data->currentFH.nfs_fh4_len);
+	if (copy->dst_fh.nfs_fh4_val == NULL) {
+		gsh_free(copy);
+		return false;
+	}
+	copy->dst_fh.nfs_fh4_len = data->currentFH.nfs_fh4_len;
+	memcpy(copy->dst_fh.nfs_fh4_val, data->currentFH.nfs_fh4_val,
+	       data->currentFH.nfs_fh4_len);
+
+	copy->client = data->session->clientid_record;
+	inc_client_id_ref(copy->client);
+
+	if (cache_inode_lru_ref(data->saved_entry, LRU_FLAG_NONE) !=
+	    CACHE_INODE_SUCCESS) {
+		nfs4_copy_free(copy);
+		return false;
+	}
+	copy->src = data->saved_entry;
+
+	if (cache_inode_lru_ref(data->current_entry, LRU_FLAG_NONE) !=
+	    CACHE_INODE_SUCCESS) {
+		nfs4_copy_free(copy);
+		return false;
+	}
+	copy->dst = data->current_entry;
+
+	get_gsh_export_ref(op_ctx->export);
+	copy->export = op_ctx->export;
+
+	copy->src_offset = src_offset;
+	copy->dst_offset = dst_offset;
+	copy->count = count;
+
+	serial = atomic_inc_uint32_t(&nfs4_copy_serial);
+	copy->stateid.seqid = 1;
+	memcpy(copy->stateid.other, &copy->client->cid_clientid,
+	       sizeof(clientid4));
+	memcpy(copy->stateid.other + sizeof(clientid4), &serial,
+	       sizeof(serial));
+
+	/* Submitted under the mutex, so nfs4_copy_shutdown either finds
+	 * the copy on the list once the fridge has stopped, or has
+	 * already stopped us from submitting. */
+	PTHREAD_MUTEX_lock(&nfs4_copy_mutex);
+	if (nfs4_copy_stopping ||
+	    fridgethr_submit(copy_fridge, nfs4_copy_run, copy) != 0) {
+		PTHREAD_MUTEX_unlock(&nfs4_copy_mutex);
+		nfs4_copy_free(copy);
+		return false;
+	}
+	glist_add_tail(&nfs4_copies, &copy->copy_list);
+	*stateid = copy->stateid;
+	PTHREAD_MUTEX_unlock(&nfs4_copy_mutex);
+
+	return true;
+}
+
+/**
+ * @brief Find a client's asynchronous copy
+ *
+ * The caller must hold nfs4_copy_mutex.
+ *
+ * @param[in] data    Compound request's data
+ * @param[in] stateid The copy's stateid
+ *
+ * @return The copy or NULL.
+ */
+
+static struct nfs4_copy *nfs4_copy_find(compound_data_t *data,
+					stateid4 *stateid)
+{
+	struct glist_head *glist;
+	struct nfs4_copy *copy;
+
+	if (data->session == NULL)
+		return NULL;
+
+	glist_for_each(glist, &nfs4_copies) {
+		copy = glist_entry(glist, struct nfs4_copy, copy_list);
+		if (copy->client == data->session->clientid_record &&
+		    memcmp(copy->stateid.other, stateid->other,
+			   sizeof(stateid->other)) == 0)
+			return copy;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief The NFS4_OP_COPY operation
+ *
+ * This functions handles the NFS4_OP_COPY operation in NFSv4.2. This
+ * function can be called only from nfs4_Compound.
+ *
+ * @param[in]     op    Arguments for nfs4_op
+ * @param[in,out] data  Compound request's data
+ * @param[out]    resp  Results for nfs4_op
+ *
+ * @return per RFC7862
+ */
+
+int nfs4_op_copy(struct nfs_argop4 *op, compound_data_t *data,
+		 struct nfs_resop4 *resp)
+{
+	COPY4args * const arg_COPY = &op->nfs_argop4_u.opcopy;
+	COPY4res * const res_COPY = &resp->nfs_resop4_u.opcopy;
+	COPY4resok *resok = &res_COPY->COPY4res_u.cr_resok4;
+	write_response4 *wr = &resok->cr_response;
+	cache_inode_status_t cache_status;
+	struct gsh_buffdesc verf_desc;
+	bool anonymous_src, anonymous_dst;
+	uint64_t count = arg_COPY->ca_count;
+	uint64_t copied = 0;
+	bool sync = false;
+
+	resp->resop = NFS4_OP_COPY;
+	memset(resok, 0, sizeof(*resok));
+
+	if (data->minorversion < 2) {
+		res_COPY->cr_status = NFS4ERR_NOTSUPP;
+		return res_COPY->cr_status;
+	}
+
+	/* Only copies within this server */
+	if (arg_COPY->ca_source_server.ca_source_server_len != 0) {
+		res_COPY->cr_status = NFS4ERR_NOTSUPP;
+		return res_COPY->cr_status;
+	}
+
+	res_COPY->cr_status = copy_check_files(data,
+					       &arg_COPY->ca_src_stateid,
+					       &arg_COPY->ca_dst_stateid,
+					       "COPY",
+					       &anonymous_src,
+					       &anonymous_dst);
+	if (res_COPY->cr_status != NFS4_OK)
+		return res_COPY->cr_status;
+
+	res_COPY->cr_status = copy_check_range(data->saved_entry,
+					       arg_COPY->ca_src_offset,
+					       data->current_entry,
+					       arg_COPY->ca_dst_offset,
+					       &count);
+	if (res_COPY->cr_status != NFS4_OK)
+		goto out;
+
+	resok->cr_requirements.cr_consecutive = true;
+
+	/* Anonymous I/O ends with this request, so it is done here */
+	if (!arg_COPY->ca_synchronous && count != 0 &&
+	    !anonymous_src && !anonymous_dst &&
+	    nfs4_copy_start(data, arg_COPY->ca_src_offset,
+			    arg_COPY->ca_dst_offset, count,
+			    &wr->wr_callback_id)) {
+		wr->wr_ids = 1;
+		wr->wr_committed = UNSTABLE4;
+		resok->cr_requirements.cr_synchronous = false;
+		goto verifier;
+	}
+
+	resok->cr_requirements.cr_synchronous = true;
+
+	count = MIN(count, nfs_param.nfsv4_param.copy_chunk_size);
+	if (count != 0) {
+		cache_status = cache_inode_copy(data->saved_entry,
+						arg_COPY->ca_src_offset,
+						data->current_entry,
+						arg_COPY->ca_dst_offset,
+						count, &copied, &sync);
+		if (cache_status != CACHE_INODE_SUCCESS) {
+			res_COPY->cr_status = nfs4_Errno(cache_status);
+			goto out;
+		}
+	} else {
+		sync = true;
+	}
+
+	wr->wr_count = copied;
+	wr->wr_committed = sync ? FILE_SYNC4 : UNSTABLE4;
+
+ verifier:
+	verf_desc.addr = wr->wr_writeverf;
+	verf_desc.len = sizeof(verifier4);
+	op_ctx->fsal_export->exp_ops.get_write_verifier(&verf_desc);
+
+ out:
+	copy_done_files(data, anonymous_src, anonymous_dst);
+
+	LogDebug(COMPONENT_NFS_V4,
+		 "COPY status %s count %" PRIu64 " copied %" PRIu64 "%s",
+		 nfsstat4_to_str(res_COPY->cr_status), arg_COPY->ca_count,
+		 copied, wr->wr_ids != 0 ? " (async)" : "");
+
+	return res_COPY->cr_status;
+}
+
+/**
+ * @brief Free memory allocated for COPY result
+ *
+ * @param[in,out] resp nfs4_op results
+ */
+
+void nfs4_op_copy_Free(nfs_resop4 *resp)
+{
+	/* Nothing to be done */
+}
+
+/**
+ * @brief The NFS4_OP_OFFLOAD_STATUS operation
+ *
+ * @param[in]     op    Arguments for nfs4_op
+ * @param[in,out] data  Compound request's data
+ * @param[out]    resp  Results for nfs4_op
+ *
+ * @return per RFC7862
+ */
+
+int nfs4_op_offload_status(struct nfs_argop4 *op, compound_data_t *data,
+			   struct nfs_resop4 *resp)
+{
+	OFFLOAD_STATUS4args * const arg_STATUS =
+	    &op->nfs_argop4_u.opoffload_status;
+	OFFLOAD_STATUS4res * const res_STATUS =
+	    &resp->nfs_resop4_u.opoffload_status;
+	OFFLOAD_STATUS4resok *resok =
+	    &res_STATUS->OFFLOAD_STATUS4res_u.osr_resok4;
+	struct nfs4_copy *copy;
+
+	resp->resop = NFS4_OP_OFFLOAD_STATUS;
+
+	if (data->minorversion < 2) {
+		res_STATUS->osr_status = NFS4ERR_NOTSUPP;
+		return res_STATUS->osr_status;
+	}
+
+	res_STATUS->osr_status = nfs4_sanity_check_FH(data, REGULAR_FILE,
+						      false);
+	if (res_STATUS->osr_status != NFS4_OK)
+		return res_STATUS->osr_status;
+
+	PTHREAD_MUTEX_lock(&nfs4_copy_mutex);
+	copy = nfs4_copy_find(data, &arg_STATUS->osa_stateid);
+	if (copy != NULL) {
+		resok->osr_count = atomic_fetch_uint64_t(&copy->copied);
+		if (copy->done) {
+			resok->osr_complete_len = 1;
+			resok->osr_complete = copy->status;
+		} else {
+			resok->osr_complete_len = 0;
+		}
+	} else {
+		res_STATUS->osr_status = NFS4ERR_BAD_STATEID;
+	}
+	PTHREAD_MUTEX_unlock(&nfs4_copy_mutex);
+
+	return res_STATUS->osr_status;
+}
+
+/**
+ * @brief Free memory allocated for OFFLOAD_STATUS result
+ *
+ * @param[in,out] resp nfs4_op results
+ */
+
+void nfs4_op_offload_status_Free(nfs_resop4 *resp)
+{
+	/* Nothing to be done */
+}
+
+/**
+ * @brief The NFS4_OP_OFFLOAD_CANCEL operation
+ *
+ * A running copy stops at the end of the chunk it is on, and no
+ * CB_OFFLOAD is sent for it.  A finished copy that is not waiting on
+ * a CB_OFFLOAD reply has its stateid released.
+ *
+ * @param[in]     op    Arguments for nfs4_op
+ * @param[in,out] data  Compound request's data
+ * @param[out]    resp  Results for nfs4_op
+ *
+ * @return per RFC7862
+ */
+
+int nfs4_op_offload_cancel(struct nfs_argop4 *op, compound_data_t *data,
+			   struct nfs_resop4 *resp)
+{
+	OFFLOAD_CANCEL4args * const arg_CANCEL =
+	    &op->nfs_argop4_u.opoffload_cancel;
+	OFFLOAD_CANCEL4res * const res_CANCEL =
+	    &resp->nfs_resop4_u.opoffload_cancel;
+	struct nfs4_copy *copy;
+	bool release = false;
+
+	resp->resop = NFS4_OP_OFFLOAD_CANCEL;
+
+	if (data->minorversion < 2) {
+		res_CANCEL->ocr_status = NFS4ERR_NOTSUPP;
+		return res_CANCEL->ocr_status;
+	}
+
+	res_CANCEL->ocr_status = nfs4_sanity_check_FH(data, REGULAR_FILE,
+						      false);
+	if (res_CANCEL->ocr_status != NFS4_OK)
+		return res_CANCEL->ocr_status;
+
+	PTHREAD_MUTEX_lock(&nfs4_copy_mutex);
+	copy = nfs4_copy_find(data, &arg_CANCEL->oca_stateid);
+	if (copy != NULL) {
+		copy->cancelled = true;
+		release = copy->done && !copy->cb_pending;
+		if (release)
+			glist_del(&copy->copy_list);
+	} else {
+		res_CANCEL->ocr_status = NFS4ERR_BAD_STATEID;
+	}
+	PTHREAD_MUTEX_unlock(&nfs4_copy_mutex);
+
+	if (release)
+		nfs4_copy_free(copy);
+
+	return res_CANCEL->ocr_status;
+}
+
+/**
+ * @brief Free memory allocated for OFFLOAD_CANCEL result
+ *
+ * @param[in,out] resp nfs4_op results
+ */
+
+void nfs4_op_offload_cancel_Free(nfs_resop4 *resp)
+{
+	/* Nothing to be done */
+}
+
+/**
+ * @brief The NFS4_OP_CLONE operation
+ *
+ * @param[in]     op    Arguments for nfs4_op
+ * @param[in,out] data  Compound request's data
+ * @param[out]    resp  Results for nfs4_op
+ *
+ * @return per RFC7862
+ */
+
+int nfs4_op_clone(struct nfs_argop4 *op, compound_data_t *data,
+		  struct nfs_resop4 *resp)
+{
+	CLONE4args * const arg_CLONE = &op->nfs_argop4_u.opclone;
+	CLONE4res * const res_CLONE = &resp->nfs_resop4_u.opclone;
+	cache_inode_status_t cache_status;
+	bool anonymous_src, anonymous_dst;
+	uint64_t count = arg_CLONE->cl_count;
+
+	resp->resop = NFS4_OP_CLONE;
+
+	if (data->minorversion < 2) {
+		res_CLONE->cl_status = NFS4ERR_NOTSUPP;
+		return res_CLONE->cl_status;
+	}
+
+	res_CLONE->cl_status = copy_check_files(data,
+						&arg_CLONE->cl_src_stateid,
+						&arg_CLONE->cl_dst_stateid,
+						"CLONE",
+						&anonymous_src,
+						&anonymous_dst);
+	if (res_CLONE->cl_status != NFS4_OK)
+		return res_CLONE->cl_status;
+
+	res_CLONE->cl_status = copy_check_range(data->saved_entry,
+						arg_CLONE->cl_src_offset,
+						data->current_entry,
+						arg_CLONE->cl_dst_offset,
+						&count);
+	if (res_CLONE->cl_status != NFS4_OK)
+		goto out;
+
+	/* The FSAL takes 0 as the rest of the source too, which avoids
+	   racing with a source that is growing. */
+	cache_status = cache_inode_clone(data->saved_entry,
+					 arg_CLONE->cl_src_offset,
+					 data->current_entry,
+					 arg_CLONE->cl_dst_offset,
+					 arg_CLONE->cl_count);
+	if (cache_status != CACHE_INODE_SUCCESS)
+		res_CLONE->cl_status = nfs4_Errno(cache_status);
+
+ out:
+	copy_done_files(data, anonymous_src, anonymous_dst);
+
+	LogDebug(COMPONENT_NFS_V4, "CLONE status %s count %" PRIu64,
+		 nfsstat4_to_str(res_CLONE->cl_status), arg_CLONE->cl_count);
+
+	return res_CLONE->cl_status;
+}
+
+/**
+ * @brief Free memory allocated for CLONE result
+ *
+ * @param[in,out] resp nfs4_op results
+ */
+
+void nfs4_op_clone_Free(nfs_resop4 *resp)
+{
+	/* Nothing to be done */
+}
+
+/**
+ * @brief Release the asynchronous copies of an expiring client
+ *
+ * Running copies are cancelled and freed by their thread, finished
+ * ones are freed here, and ones waiting on a CB_OFFLOAD reply are
+ * freed when it comes back.
+ *
+ * @param[in] client The client
+ */
+
+void nfs4_copy_forget_client(nfs_client_id_t *client)
+{
+	struct glist_head *glist, *glistn;
+	struct glist_head released;
+	struct nfs4_copy *copy;
+
+	glist_init(&released);
+
+	PTHREAD_MUTEX_lock(&nfs4_copy_mutex);
+	glist_for_each_safe(glist, glistn, &nfs4_copies) {
+		copy = glist_entry(glist, struct nfs4_copy, copy_list);
+		if (copy->client != client)
+			continue;
+		copy->cancelled = true;
+		if (copy->done && !copy->cb_pending) {
+			glist_del(&copy->copy_list);
+			glist_add_tail(&released, &copy->copy_list);
+		}
+	}
+	PTHREAD_MUTEX_unlock(&nfs4_copy_mutex);
+
+	glist_for_each_safe(glist, glistn, &released) {
+		copy = glist_entry(glist, struct nfs4_copy, copy_list);
+		glist_del(&copy->copy_list);
+		nfs4_copy_free(copy);
+	}
+}
+
+/**
+ * @brief Start the threads for asynchronous COPY
+ *
+ * @return 0 on success, POSIX errors on failure.
+ */
+
+int nfs4_copy_init(void)
+{
+	struct fridgethr_params frp;
+	int rc;
+
+	memset(&frp, 0, sizeof(struct fridgethr_params));
+	frp.thr_max = nfs_param.nfsv4_param.copy_threads;
+	frp.deferment = fridgethr_defer_queue;
+	rc = fridgethr_init(&copy_fridge, "NFS4_Copy", &frp);
+	if (rc != 0)
+		LogMajor(COMPONENT_NFS_V4,
+			 "Unable to initialize copy fridge: %d", rc);
+	return rc;
+}
+
+/**
+ * @brief Stop the threads for asynchronous COPY
+ *
+ * Copies in progress stop at the end of their current chunk and are
+ * not reported.  Copies that never got a thread are freed.
+ *
+ * @return 0 on success, POSIX errors on failure.
+ */
+
+int nfs4_copy_shutdown(void)
+{
+	struct glist_head *glist, *glistn;
+	struct glist_head released;
+	struct nfs4_copy *copy;
+	int rc;
+
+	if (copy_fridge == NULL)
+		return 0;
+
+	PTHREAD_MUTEX_lock(&nfs4_copy_mutex);
+	nfs4_copy_stopping = true;
+	PTHREAD_MUTEX_unlock(&nfs4_copy_mutex);
+
+	rc = fridgethr_sync_command(copy_fridge, fridgethr_comm_stop, 120);
+	if (rc == ETIMEDOUT) {
+		LogMajor(COMPONENT_NFS_V4,
+			 "Shutdown timed out, cancelling threads.");
+		fridgethr_cancel(copy_fridge);
+	} else if (rc != 0) {
+		LogMajor(COMPONENT_NFS_V4,
+			 "Failed shutting down copy threads: %d", rc);
+	}
+
+	/* Nothing runs copies any more, so free the ones still queued or
+	 * cut short, with their files, exports and client references.
+	 * Those waiting on a CB_OFFLOAD reply are freed by its completion.
+	 */
+	glist_init(&released);
+
+	PTHREAD_MUTEX_lock(&nfs4_copy_mutex);
+	glist_for_each_safe(glist, glistn, &nfs4_copies) {
+		copy = glist_entry(glist, struct nfs4_copy, copy_list);
+		if (copy->cb_pending)
+			continue;
+		glist_del(&copy->copy_list);
+		glist_add_tail(&released, &copy->copy_list);
+	}
+	PTHREAD_MUTEX_unlock(&nfs4_copy_mutex);
+
+	glist_for_each_safe(glist, glistn, &released) {
+		copy = glist_entry(glist, struct nfs4_copy, copy_list);
+		glist_del(&copy->copy_list);
+		LogDebug(COMPONENT_NFS_V4, "Dropping copy %p at shutdown",
+			 copy);
+		nfs4_copy_free(copy);
+	}
+
+	return rc;
+}
@@ -41,6 +41,7 @@
 #include "nfs_creds.h"
 #include "client_mgr.h"
 #include "fsal.h"
+#include "server_stats.h"
 
 /**
  *
@@ -85,8 +86,10 @@ int nfs4_op_create_session(struct nfs_argop4 *op, compound_data_t *data,
 	/* Display buffer for clientid4 */
 	struct display_buffer dspbuf_clientid4 = {
 		sizeof(str_clientid4), str_clientid4, str_clientid4};
+	/* Forechannel slots for the session */
+	uint32_t nb_slots;
 	/* Return code from clientid calls */
-	int i, rc = 0;
+	int rc = 0;
 	/* Component for logging */
 	log_components_t component = COMPONENT_CLIENTID;
 	/* Abbreviated alias for arguments */
@@ -320,13 +323,30 @@ int nfs4_op_create_session(struct nfs_argop4 *op, compound_data_t *data,
 	    arg_CREATE_SESSION4->csa_fore_chan_attrs;
 	nfs41_session->back_channel_attrs =
 	    arg_CREATE_SESSION4->csa_back_chan_attrs;
+
+	/* Give the client the slots it asks for, up to our maximum; this
+	 * sets ca_maxrequests.
+	 */
+	nb_slots = MIN(arg_CREATE_SESSION4->csa_fore_chan_attrs.ca_maxrequests,
+		       nfs_param.nfsv4_param.max_session_slots);
+	if (nb_slots == 0)
+		nb_slots = 1;
+
+	if (!nfs41_Session_Alloc_Slots(nfs41_session, nb_slots)) {
+		LogCrit(component, "Could not allocate a session slot table");
+		pool_free(nfs41_session_pool, nfs41_session);
+		dec_client_id_ref(found);
+		res_CREATE_SESSION4->csr_status = NFS4ERR_SERVERFAULT;
+		goto out;
+	}
+
+	server_stats_session_slots(op_ctx->client, nb_slots);
+
 	nfs41_session->xprt = data->req->rq_xprt;
 	nfs41_session->flags = false;
 	nfs41_session->cb_program = 0;
 	PTHREAD_MUTEX_init(&nfs41_session->cb_mutex, NULL);
 	PTHREAD_COND_init(&nfs41_session->cb_cond, NULL);
-	for (i = 0; i < NFS41_NB_SLOTS; i++)
-		PTHREAD_MUTEX_init(&nfs41_session->slots[i].lock, NULL);
 
 	/* Take reference to clientid record on behalf the session. */
 	inc_client_id_ref(found);
@@ -337,8 +357,6 @@ int nfs4_op_create_session(struct nfs_argop4 *op, compound_data_t *data,
 		  &nfs41_session->session_link);
 	PTHREAD_MUTEX_unlock(&found->cid_mutex);
 
-	/* Set ca_maxrequests */
-	nfs41_session->fore_channel_attrs.ca_maxrequests = NFS41_NB_SLOTS;
 	nfs41_Build_sessionid(&clientid, nfs41_session->session_id);
 
 	res_CREATE_SESSION4ok->csr_sequence = arg_CREATE_SESSION4->csa_sequence;
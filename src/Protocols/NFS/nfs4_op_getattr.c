@@ -94,7 +94,8 @@ int nfs4_op_getattr(struct nfs_argop4 *op, compound_data_t *data,
 					obj_attributes,
 					data,
 					&data->currentFH,
-					&arg_GETATTR4->attr_request);
+					&arg_GETATTR4->attr_request,
+					op_ctx->arena);
 
 	if (is_sticky_bit_set(&data->current_entry->obj_handle->attributes)) {
 		if (!(attribute_is_set(&arg_GETATTR4->attr_request,
@@ -114,8 +115,5 @@ int nfs4_op_getattr(struct nfs_argop4 *op, compound_data_t *data,
  */
 void nfs4_op_getattr_Free(nfs_resop4 *res)
 {
-	GETATTR4res *resp = &res->nfs_resop4_u.opgetattr;
-
-	if (resp->status == NFS4_OK)
-		nfs4_Fattr_Free(&resp->GETATTR4res_u.resok4.obj_attributes);
+	/* The attributes live in the request arena */
 }				/* nfs4_op_getattr_Free */
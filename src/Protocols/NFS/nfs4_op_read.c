@@ -47,6 +47,7 @@
 #include "fsal_pnfs.h"
 #include "server_stats.h"
 #include "export_mgr.h"
+#include "gsh_iobuf.h"
 
 /**
  * @brief Read on a pNFS pNFS data server
@@ -86,7 +87,7 @@ static int op_dsread(struct nfs_argop4 *op, compound_data_t *data,
 
 	/* Construct the FSAL file handle */
 
-	buffer = gsh_malloc_aligned(4096, arg_READ4->count);
+	buffer = gsh_iobuf_get(arg_READ4->count);
 	if (buffer == NULL) {
 		LogEvent(COMPONENT_NFS_V4, "FAILED to allocate read buffer");
 		res_READ4->status = NFS4ERR_SERVERFAULT;
@@ -106,7 +107,7 @@ static int op_dsread(struct nfs_argop4 *op, compound_data_t *data,
 				&eof);
 
 	if (nfs_status != NFS4_OK) {
-		gsh_free(buffer);
+		gsh_iobuf_put(buffer);
 		res_READ4->READ4res_u.resok4.data.data_val = NULL;
 	}
 
@@ -162,7 +163,7 @@ static int op_dsread_plus(struct nfs_argop4 *op, compound_data_t *data,
 
 	/* Construct the FSAL file handle */
 
-	buffer = gsh_malloc_aligned(4096, arg_READ4->count);
+	buffer = gsh_iobuf_get(arg_READ4->count);
 	if (buffer == NULL) {
 		LogEvent(COMPONENT_NFS_V4, "FAILED to allocate read buffer");
 		res_RPLUS->rpr_status = NFS4ERR_SERVERFAULT;
@@ -181,7 +182,7 @@ static int op_dsread_plus(struct nfs_argop4 *op, compound_data_t *data,
 
 	res_RPLUS->rpr_status = nfs_status;
 	if (nfs_status != NFS4_OK) {
-		gsh_free(buffer);
+		gsh_iobuf_put(buffer);
 		return res_RPLUS->rpr_status;
 	}
 
@@ -459,7 +460,7 @@ static int nfs4_read(struct nfs_argop4 *op, compound_data_t *data,
 	}
 
 	/* Some work is to be done */
-	bufferdata = gsh_malloc_aligned(4096, size);
+	bufferdata = gsh_iobuf_get(size);
 
 	if (bufferdata == NULL) {
 		LogEvent(COMPONENT_NFS_V4, "FAILED to allocate bufferdata");
@@ -480,7 +481,7 @@ static int nfs4_read(struct nfs_argop4 *op, compound_data_t *data,
 				  bufferdata, &eof_met, &sync, info);
 	if (cache_status != CACHE_INODE_SUCCESS) {
 		res_READ4->status = nfs4_Errno(cache_status);
-		gsh_free(bufferdata);
+		gsh_iobuf_put(bufferdata);
 		res_READ4->READ4res_u.resok4.data.data_val = NULL;
 		goto done;
 	}
@@ -488,7 +489,7 @@ static int nfs4_read(struct nfs_argop4 *op, compound_data_t *data,
 	if (cache_inode_size(entry, &file_size) !=
 	    CACHE_INODE_SUCCESS) {
 		res_READ4->status = nfs4_Errno(cache_status);
-		gsh_free(bufferdata);
+		gsh_iobuf_put(bufferdata);
 		res_READ4->READ4res_u.resok4.data.data_val = NULL;
 		goto done;
 	}
@@ -572,7 +573,7 @@ void nfs4_op_read_Free(nfs_resop4 *res)
 
 	if (resp->status == NFS4_OK)
 		if (resp->READ4res_u.resok4.data.data_val != NULL)
-			gsh_free(resp->READ4res_u.resok4.data.data_val);
+			gsh_iobuf_put(resp->READ4res_u.resok4.data.data_val);
 	return;
 }				/* nfs4_op_read_Free */
 
@@ -631,7 +632,7 @@ void nfs4_op_read_plus_Free(nfs_resop4 *res)
 
 	if (resp->rpr_status == NFS4_OK && conp->what == NFS4_CONTENT_DATA)
 		if (conp->data.d_data.data_val != NULL)
-			gsh_free(conp->data.d_data.data_val);
+			gsh_iobuf_put(conp->data.d_data.data_val);
 
 	return;
 }				/* nfs4_op_read_Free */
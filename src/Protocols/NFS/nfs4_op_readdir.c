@@ -299,17 +299,14 @@ not_junction:
 
 	tracker->mem_left -= (namelen + 1);
 	tracker_entry->name.utf8string_len = namelen;
-	tracker_entry->name.utf8string_val = gsh_malloc(namelen + 1);
+	tracker_entry->name.utf8string_val =
+	    gsh_arena_memdup(op_ctx->arena, cb_parms->name, namelen);
 
 	if (tracker_entry->name.utf8string_val == NULL) {
 		/* Could not allocate name */
 		goto server_fault;
 	}
 
-	memcpy(tracker_entry->name.utf8string_val,
-	       cb_parms->name,
-	       namelen);
-
 	/* If we carried an error from above, now that we have
 	 * the name set up, go ahead and try and put error in
 	 * results.
@@ -370,6 +367,7 @@ not_junction:
 	args.data = data;
 	args.hdl4 = &entryFH;
 	args.mounted_on_fileid = mounted_on_fileid;
+	args.arena = op_ctx->arena;
 
 	if (nfs4_FSALattr_To_Fattr(&args,
 				   tracker->req_attr,
@@ -395,7 +393,7 @@ not_junction:
 		}
 
 		if (nfs4_Fattr_Fill_Error(&tracker_entry->attrs,
-					  rdattr_error) == -1)
+					  rdattr_error, op_ctx->arena) == -1)
 			goto server_fault;
 	}
 
@@ -426,15 +424,9 @@ not_junction:
 
  failure:
 
-	if (tracker_entry->attrs.attr_vals.attrlist4_val != NULL) {
-		gsh_free(tracker_entry->attrs.attr_vals.attrlist4_val);
-		tracker_entry->attrs.attr_vals.attrlist4_val = NULL;
-	}
-
-	if (tracker_entry->name.utf8string_val != NULL) {
-		gsh_free(tracker_entry->name.utf8string_val);
-		tracker_entry->name.utf8string_val = NULL;
-	}
+	/* What was allocated goes with the request arena */
+	tracker_entry->attrs.attr_vals.attrlist4_val = NULL;
+	tracker_entry->name.utf8string_val = NULL;
 
  not_inresult:
 
@@ -445,30 +437,6 @@ not_junction:
 	return CACHE_INODE_SUCCESS;
 }
 
-/**
- * @brief Free a list of entry4s
- *
- * This function frees a list of entry4s and all dependent strctures.
- *
- * @param[in,out] entries The entries to be freed
- */
-
-static void free_entries(entry4 *entries)
-{
-	entry4 *entry = NULL;
-
-	for (entry = entries; entry != NULL; entry = entry->nextentry) {
-		if (entry->attrs.attr_vals.attrlist4_val != NULL)
-			gsh_free(entry->attrs.attr_vals.attrlist4_val);
-
-		if (entry->name.utf8string_val != NULL)
-			gsh_free(entry->name.utf8string_val);
-	}
-	gsh_free(entries);
-
-	return;
-}				/* free_entries */
-
 /**
  * @brief NFS4_OP_READDIR
  *
@@ -592,7 +560,14 @@ int nfs4_op_readdir(struct nfs_argop4 *op, compound_data_t *data,
 
 	/* Prepare to read the entries */
 
-	entries = gsh_calloc(estimated_num_entries, sizeof(entry4));
+	entries = gsh_arena_calloc(op_ctx->arena, estimated_num_entries,
+				   sizeof(entry4));
+
+	if (entries == NULL) {
+		res_READDIR4->status = NFS4ERR_SERVERFAULT;
+		goto out;
+	}
+
 	tracker.entries = entries;
 	tracker.mem_left = maxcount - sizeof(READDIR4resok);
 	tracker.count = 0;
@@ -644,8 +619,6 @@ int nfs4_op_readdir(struct nfs_argop4 *op, compound_data_t *data,
 		 */
 		res_READDIR4->READDIR4res_u.resok4.reply.entries = entries;
 	} else {
-		gsh_free(entries);
-		entries = NULL;
 		res_READDIR4->READDIR4res_u.resok4.reply.entries = NULL;
 	}
 
@@ -667,9 +640,6 @@ int nfs4_op_readdir(struct nfs_argop4 *op, compound_data_t *data,
 	res_READDIR4->status = NFS4_OK;
 
  out:
-	if ((res_READDIR4->status != NFS4_OK) && (entries != NULL))
-		free_entries(entries);
-
 	LogFullDebug(COMPONENT_NFS_READDIR,
 		     "Returning %s",
 		     nfsstat4_to_str(res_READDIR4->status));
@@ -687,7 +657,5 @@ int nfs4_op_readdir(struct nfs_argop4 *op, compound_data_t *data,
  */
 void nfs4_op_readdir_Free(nfs_resop4 *res)
 {
-	READDIR4res *resp = &res->nfs_resop4_u.opreaddir;
-
-	free_entries(resp->READDIR4res_u.resok4.reply.entries);
+	/* Entries, names and attributes live in the request arena */
 }				/* nfs4_op_readdir_Free */
@@ -34,6 +34,7 @@
 #include "sal_functions.h"
 #include "nfs_rpc_callback.h"
 #include "nfs_convert.h"
+#include "server_stats.h"
 
 /**
  * @brief the NFS4_OP_SEQUENCE operation
@@ -54,6 +55,8 @@ int nfs4_op_sequence(struct nfs_argop4 *op, compound_data_t *data,
 	SEQUENCE4res * const res_SEQUENCE4 = &resp->nfs_resop4_u.opsequence;
 
 	nfs41_session_t *session;
+	nfs41_session_slot_t *slot;
+	uint32_t target;
 
 	resp->resop = NFS4_OP_SEQUENCE;
 	res_SEQUENCE4->sr_status = NFS4_OK;
@@ -79,7 +82,8 @@ int nfs4_op_sequence(struct nfs_argop4 *op, compound_data_t *data,
 			res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.sr_slotid =
 			    arg_SEQUENCE4->sa_slotid;
 			res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.
-			    sr_highest_slotid = NFS41_NB_SLOTS - 1;
+			    sr_highest_slotid =
+			    arg_SEQUENCE4->sa_highest_slotid;
 			res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.
 			    sr_target_highest_slotid = arg_SEQUENCE4->sa_slotid;
 			res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.
@@ -136,43 +140,33 @@ int nfs4_op_sequence(struct nfs_argop4 *op, compound_data_t *data,
 	/* By default, no DRC replay */
 	data->use_drc = false;
 
-	PTHREAD_MUTEX_lock(&session->slots[arg_SEQUENCE4->sa_slotid].lock);
-	if (session->slots[arg_SEQUENCE4->sa_slotid].sequence + 1 !=
-	    arg_SEQUENCE4->sa_sequenceid) {
-		if (session->slots[arg_SEQUENCE4->sa_slotid].sequence ==
-		    arg_SEQUENCE4->sa_sequenceid) {
-#if IMPLEMENT_CACHETHIS
-			/** @todo
-			 *
-			 * Ganesha always caches result anyway so ignore
-			 * cachethis
+	slot = &session->slots[arg_SEQUENCE4->sa_slotid];
+
+	PTHREAD_MUTEX_lock(&slot->lock);
+	if (slot->sequence + 1 != arg_SEQUENCE4->sa_sequenceid) {
+		if (slot->sequence == arg_SEQUENCE4->sa_sequenceid) {
+			/* A retry of a request still being served has no
+			 * reply yet, let the client come back for it.
 			 */
-			if (session->slots[arg_SEQUENCE4->sa_slotid]
-			    .cache_used) {
-#endif
-				/* Replay operation through the DRC */
-				data->use_drc = true;
-				data->cached_res =
-				    &session->slots[arg_SEQUENCE4->sa_slotid].
-				    cached_result;
-
-				LogFullDebugAlt(COMPONENT_SESSIONS,
-						COMPONENT_CLIENTID,
-						"Use sesson slot %" PRIu32
-						"=%p for DRC",
-						arg_SEQUENCE4->sa_slotid,
-						data->cached_res);
-
-				PTHREAD_MUTEX_unlock(&session->
-					slots[arg_SEQUENCE4->sa_slotid].lock);
+			if (slot->in_progress) {
+				PTHREAD_MUTEX_unlock(&slot->lock);
 				dec_session_ref(session);
-				res_SEQUENCE4->sr_status = NFS4_OK;
+				res_SEQUENCE4->sr_status = NFS4ERR_DELAY;
+				LogDebugAlt(COMPONENT_SESSIONS,
+					    COMPONENT_CLIENTID,
+					    "SEQUENCE returning status %s",
+					    nfsstat4_to_str(res_SEQUENCE4->
+							    sr_status));
 				return res_SEQUENCE4->sr_status;
-#if IMPLEMENT_CACHETHIS
-			} else {
+			}
+
+			/* The reply may not have been cached, either because
+			 * the client didn't ask or because the slot reply
+			 * cache was full.
+			 */
+			if (!slot->cache_used) {
 				/* Illegal replay */
-				PTHREAD_MUTEX_unlock(&session->
-					slots[arg_SEQUENCE4->sa_slotid].lock);
+				PTHREAD_MUTEX_unlock(&slot->lock);
 				dec_session_ref(session);
 				res_SEQUENCE4->sr_status =
 				    NFS4ERR_RETRY_UNCACHED_REP;
@@ -183,11 +177,25 @@ int nfs4_op_sequence(struct nfs_argop4 *op, compound_data_t *data,
 							    sr_status));
 				return res_SEQUENCE4->sr_status;
 			}
-#endif
+
+			/* Replay operation through the DRC */
+			data->use_drc = true;
+			data->cached_res = &slot->cached_result;
+
+			LogFullDebugAlt(COMPONENT_SESSIONS, COMPONENT_CLIENTID,
+					"Use sesson slot %" PRIu32
+					"=%p for DRC",
+					arg_SEQUENCE4->sa_slotid,
+					data->cached_res);
+
+			PTHREAD_MUTEX_unlock(&slot->lock);
+			dec_session_ref(session);
+			server_stats_slot_replay(op_ctx->client);
+			res_SEQUENCE4->sr_status = NFS4_OK;
+			return res_SEQUENCE4->sr_status;
 		}
 
-		PTHREAD_MUTEX_unlock(&session->
-			slots[arg_SEQUENCE4->sa_slotid].lock);
+		PTHREAD_MUTEX_unlock(&slot->lock);
 		dec_session_ref(session);
 		res_SEQUENCE4->sr_status = NFS4ERR_SEQ_MISORDERED;
 		LogDebugAlt(COMPONENT_SESSIONS, COMPONENT_CLIENTID,
@@ -204,18 +212,26 @@ int nfs4_op_sequence(struct nfs_argop4 *op, compound_data_t *data,
 	data->slot = arg_SEQUENCE4->sa_slotid;
 
 	/* Update the sequence id within the slot */
-	session->slots[arg_SEQUENCE4->sa_slotid].sequence += 1;
+	slot->sequence += 1;
+	slot->in_progress = true;
+
+	/* The client has seen the previous reply, drop it; nfs4_Compound
+	 * caches the new one if there is room.
+	 */
+	nfs41_Session_Slot_Release(slot);
+
+	target = nfs41_Session_Target_Slotid(session);
 
 	memcpy(res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.sr_sessionid,
 	       arg_SEQUENCE4->sa_sessionid, NFS4_SESSIONID_SIZE);
 	res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.sr_sequenceid =
-	    session->slots[arg_SEQUENCE4->sa_slotid].sequence;
+	    slot->sequence;
 	res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.sr_slotid =
 	    arg_SEQUENCE4->sa_slotid;
 	res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.sr_highest_slotid =
-	    NFS41_NB_SLOTS - 1;
+	    session->fore_channel_attrs.ca_maxrequests - 1;
 	res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.sr_target_highest_slotid =
-	    arg_SEQUENCE4->sa_slotid;	/* Maybe not the best choice */
+	    target;
 
 	res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.sr_status_flags = 0;
 
@@ -228,9 +244,7 @@ int nfs4_op_sequence(struct nfs_argop4 *op, compound_data_t *data,
 /* Ganesha always caches result anyway so ignore cachethis */
 	if (arg_SEQUENCE4->sa_cachethis) {
 #endif
-		data->cached_res =
-		    &session->slots[arg_SEQUENCE4->sa_slotid].cached_result;
-		session->slots[arg_SEQUENCE4->sa_slotid].cache_used = true;
+		data->cached_res = &slot->cached_result;
 
 		LogFullDebugAlt(COMPONENT_SESSIONS, COMPONENT_CLIENTID,
 				"Use sesson slot %" PRIu32 "=%p for DRC",
@@ -238,7 +252,6 @@ int nfs4_op_sequence(struct nfs_argop4 *op, compound_data_t *data,
 #if IMPLEMENT_CACHETHIS
 	} else {
 		data->cached_res = NULL;
-		session->slots[arg_SEQUENCE4->sa_slotid].cache_used = false;
 
 		LogFullDebugAlt(COMPONENT_SESSIONS, COMPONENT_CLIENTID,
 				"Don't use sesson slot %" PRIu32
@@ -246,7 +259,15 @@ int nfs4_op_sequence(struct nfs_argop4 *op, compound_data_t *data,
 	}
 #endif
 
-	PTHREAD_MUTEX_unlock(&session->slots[arg_SEQUENCE4->sa_slotid].lock);
+	PTHREAD_MUTEX_unlock(&slot->lock);
+
+	/* Give back the reply cache of slots the client isn't using */
+	if (arg_SEQUENCE4->sa_highest_slotid <
+	    session->fore_channel_attrs.ca_maxrequests - 1)
+		nfs41_Session_Trim_Slots(session,
+					 arg_SEQUENCE4->sa_highest_slotid);
+
+	server_stats_slot_start(op_ctx->client, target);
 
 	/* If we were successful, stash the clientid in the request
 	 * context.
@@ -89,7 +89,8 @@ int nfs4_op_verify(struct nfs_argop4 *op, compound_data_t *data,
 				 &file_attr4,
 				 data,
 				 &data->currentFH,
-				 &arg_VERIFY4->obj_attributes.attrmask);
+				 &arg_VERIFY4->obj_attributes.attrmask,
+				 NULL);
 
 	if (res_VERIFY4->status != NFS4_OK)
 		return res_VERIFY4->status;
@@ -3122,6 +3122,7 @@ struct Fattr_filler_opaque {
 	compound_data_t *data;	/*< Compound data */
 	nfs_fh4 *objFH;		/*< Object file handle */
 	struct bitmap4 *Bitmap;	/*< Bitmap of entries to fill */
+	struct gsh_arena *arena;	/*< Arena for the attributes or NULL */
 };
 
 /**
@@ -3150,6 +3151,7 @@ static cache_inode_status_t Fattr_filler(void *opaque,
 	args.data = f->data;
 	args.hdl4 = f->objFH;
 	args.mounted_on_fileid = mounted_on_fileid;
+	args.arena = f->arena;
 
 	if (nfs4_FSALattr_To_Fattr(&args, f->Bitmap, f->Fattr) != 0)
 		return CACHE_INODE_IO_ERROR;
@@ -3166,24 +3168,27 @@ static cache_inode_status_t Fattr_filler(void *opaque,
  * @param[out] Fattr   NFSv4 Fattr buffer
  *		       Memory for bitmap_val and attr_val is
  *                     dynamically allocated,
- *		       caller is responsible for freeing it.
+ *		       caller is responsible for freeing it
+ *		       unless it comes from an arena.
  * @param[in]  data    NFSv4 compoud request's data.
  * @param[in]  objFH   The NFSv4 filehandle of the object whose
  *                     attributes are requested
  * @param[in]  Bitmap  Bitmap of attributes being requested
+ * @param[in]  arena   Arena to allocate from, NULL for the heap
  *
  * @retval cache status
  */
 
 nfsstat4 cache_entry_To_Fattr(cache_entry_t *entry, fattr4 *Fattr,
 			      compound_data_t *data, nfs_fh4 *objFH,
-			      struct bitmap4 *Bitmap)
+			      struct bitmap4 *Bitmap, struct gsh_arena *arena)
 {
 	struct Fattr_filler_opaque f = {
 		.Fattr = Fattr,
 		.data = data,
 		.objFH = objFH,
-		.Bitmap = Bitmap
+		.Bitmap = Bitmap,
+		.arena = arena
 	};
 
 	/* Permissiomn check only if ACL is asked for.
@@ -3215,7 +3220,8 @@ nfsstat4 cache_entry_To_Fattr(cache_entry_t *entry, fattr4 *Fattr,
 		cache_inode_getattr(entry, &f, Fattr_filler, CB_ORIGINAL));
 }
 
-int nfs4_Fattr_Fill_Error(fattr4 *Fattr, nfsstat4 rdattr_error)
+int nfs4_Fattr_Fill_Error(fattr4 *Fattr, nfsstat4 rdattr_error,
+			  struct gsh_arena *arena)
 {
 	u_int LastOffset;
 	XDR attr_body;
@@ -3224,8 +3230,13 @@ int nfs4_Fattr_Fill_Error(fattr4 *Fattr, nfsstat4 rdattr_error)
 
 	/* basic init */
 	memset(&Fattr->attrmask, 0, sizeof(Fattr->attrmask));
-	Fattr->attr_vals.attrlist4_val =
-	    gsh_malloc(fattr4tab[FATTR4_RDATTR_ERROR].size_fattr4);
+	if (arena != NULL)
+		Fattr->attr_vals.attrlist4_val =
+		    gsh_arena_alloc(arena,
+				    fattr4tab[FATTR4_RDATTR_ERROR].size_fattr4);
+	else
+		Fattr->attr_vals.attrlist4_val =
+		    gsh_malloc(fattr4tab[FATTR4_RDATTR_ERROR].size_fattr4);
 
 	if (Fattr->attr_vals.attrlist4_val == NULL)
 		return -1;
@@ -3254,7 +3265,8 @@ int nfs4_Fattr_Fill_Error(fattr4 *Fattr, nfsstat4 rdattr_error)
 
 		if (LastOffset == 0) {	/* no supported attrs so we can free */
 			assert(Fattr->attrmask.bitmap4_len == 0);
-			gsh_free(Fattr->attr_vals.attrlist4_val);
+			if (arena == NULL)
+				gsh_free(Fattr->attr_vals.attrlist4_val);
 			Fattr->attr_vals.attrlist4_val = NULL;
 		}
 		Fattr->attr_vals.attrlist4_len = LastOffset;
@@ -3266,23 +3278,309 @@ int nfs4_Fattr_Fill_Error(fattr4 *Fattr, nfsstat4 rdattr_error)
 			     fattr4tab[FATTR4_RDATTR_ERROR].name);
 		/* signal fail so if(LastOffset > 0) works right */
 
-		gsh_free(Fattr->attr_vals.attrlist4_val);
+		if (arena == NULL)
+			gsh_free(Fattr->attr_vals.attrlist4_val);
 		Fattr->attr_vals.attrlist4_val = NULL;
 		return -1;
 	}
 }
 
+/*
+ * Attribute encoding plans
+ *
+ * Clients ask for few distinct attribute bitmaps, so the work of
+ * walking a bitmap is done once per bitmap.  A plan lists the
+ * attributes to encode and groups consecutive fixed size ones into
+ * runs: each run is reserved from the stream at once and its
+ * attributes are stored in place, without going through the XDR
+ * functions.  Other attributes go through their fattr4tab encoder.
+ *
+ * Plans are immutable once built, are installed in the cache with a
+ * compare and swap and are never freed, the cache being bounded.
+ * When the cache is full, the plan is built on the stack and used
+ * for the one call.
+ */
+
+#define FATTR4_PLAN_SLOTS 64
+#define FATTR4_PLAN_PROBES 8
+
+struct fattr4_plan_op {
+	uint8_t attr;		/*< Attribute to encode */
+	uint8_t size;		/*< Encoded size if fixed, 0 otherwise */
+	uint16_t run;		/*< Bytes of the fixed run starting here */
+};
+
+struct fattr4_plan {
+	struct bitmap4 bitmap;	/*< Requested attributes, unused words 0 */
+	int max_attr_idx;	/*< Highest attribute for the minor version */
+	uint32_t nops;
+	struct fattr4_plan_op op[FATTR4_SEC_LABEL + 1];
+};
+
+static struct fattr4_plan *fattr4_plans[FATTR4_PLAN_SLOTS];
+
+/**
+ * @brief Encoded size of an attribute, if fixed
+ *
+ * Only attributes encoded by fattr4_put_fixed are reported here.
+ *
+ * @param[in] attr The attribute
+ *
+ * @return The size in bytes or 0 if not encoded in place.
+ */
+
+static uint8_t fattr4_fixed_size(int attr)
+{
+	switch (attr) {
+	case FATTR4_TYPE:
+	case FATTR4_RDATTR_ERROR:
+	case FATTR4_MODE:
+	case FATTR4_NUMLINKS:
+		return 4;
+	case FATTR4_CHANGE:
+	case FATTR4_SIZE:
+	case FATTR4_FILEID:
+	case FATTR4_RAWDEV:
+	case FATTR4_SPACE_USED:
+	case FATTR4_MOUNTED_ON_FILEID:
+		return 8;
+	case FATTR4_TIME_ACCESS:
+	case FATTR4_TIME_METADATA:
+	case FATTR4_TIME_MODIFY:
+		return 12;
+	case FATTR4_FSID:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+static inline void fattr4_put64(int32_t **p, uint64_t val)
+{
+	IXDR_PUT_U_INT32(*p, (uint32_t) (val >> 32));
+	IXDR_PUT_U_INT32(*p, (uint32_t) val);
+}
+
+/**
+ * @brief Store a fixed size attribute in place
+ *
+ * Produces the same bytes as the fattr4tab encoder of the attribute.
+ *
+ * @param[in,out] p    Where to store, advanced past the attribute
+ * @param[in]     attr The attribute
+ * @param[in]     args XDR attribute arguments
+ *
+ * @return false if the attribute can not be encoded.
+ */
+
+static bool fattr4_put_fixed(int32_t **p, int attr,
+			     struct xdr_attrs_args *args)
+{
+	struct attrlist *attrs = args->attrs;
+	struct specdata4 specdata4;
+	uint64_t rawdev;
+
+	switch (attr) {
+	case FATTR4_TYPE:
+		switch (attrs->type) {
+		case REGULAR_FILE:
+		case EXTENDED_ATTR:
+			IXDR_PUT_U_INT32(*p, NF4REG);
+			break;
+		case DIRECTORY:
+			IXDR_PUT_U_INT32(*p, NF4DIR);
+			break;
+		case BLOCK_FILE:
+			IXDR_PUT_U_INT32(*p, NF4BLK);
+			break;
+		case CHARACTER_FILE:
+			IXDR_PUT_U_INT32(*p, NF4CHR);
+			break;
+		case SYMBOLIC_LINK:
+			IXDR_PUT_U_INT32(*p, NF4LNK);
+			break;
+		case SOCKET_FILE:
+			IXDR_PUT_U_INT32(*p, NF4SOCK);
+			break;
+		case FIFO_FILE:
+			IXDR_PUT_U_INT32(*p, NF4FIFO);
+			break;
+		default:
+			return false;
+		}
+		break;
+	case FATTR4_CHANGE:
+		fattr4_put64(p, attrs->change);
+		break;
+	case FATTR4_SIZE:
+		fattr4_put64(p, attrs->filesize);
+		break;
+	case FATTR4_FSID:
+		if (args->data != NULL &&
+		    (op_ctx->export->options_set &
+		     EXPORT_OPTION_FSID_SET) != 0) {
+			fattr4_put64(p, op_ctx->export->filesystem_id.major);
+			fattr4_put64(p, op_ctx->export->filesystem_id.minor);
+		} else {
+			fattr4_put64(p, attrs->fsid.major);
+			fattr4_put64(p, attrs->fsid.minor);
+		}
+		break;
+	case FATTR4_RDATTR_ERROR:
+		IXDR_PUT_U_INT32(*p, args->rdattr_error);
+		break;
+	case FATTR4_FILEID:
+		fattr4_put64(p, attrs->fileid);
+		break;
+	case FATTR4_MODE:
+		IXDR_PUT_U_INT32(*p, fsal2unix_mode(attrs->mode));
+		break;
+	case FATTR4_NUMLINKS:
+		IXDR_PUT_U_INT32(*p, attrs->numlinks);
+		break;
+	case FATTR4_RAWDEV:
+		/* encode_rawdev sends the structure as one 64 bit value */
+		specdata4.specdata1 = attrs->rawdev.major;
+		specdata4.specdata2 = attrs->rawdev.minor;
+		memcpy(&rawdev, &specdata4, sizeof(rawdev));
+		fattr4_put64(p, rawdev);
+		break;
+	case FATTR4_SPACE_USED:
+		fattr4_put64(p, attrs->spaceused);
+		break;
+	case FATTR4_TIME_ACCESS:
+		fattr4_put64(p, attrs->atime.tv_sec);
+		IXDR_PUT_U_INT32(*p, attrs->atime.tv_nsec);
+		break;
+	case FATTR4_TIME_METADATA:
+		fattr4_put64(p, attrs->ctime.tv_sec);
+		IXDR_PUT_U_INT32(*p, attrs->ctime.tv_nsec);
+		break;
+	case FATTR4_TIME_MODIFY:
+		fattr4_put64(p, attrs->mtime.tv_sec);
+		IXDR_PUT_U_INT32(*p, attrs->mtime.tv_nsec);
+		break;
+	case FATTR4_MOUNTED_ON_FILEID:
+		fattr4_put64(p, args->mounted_on_fileid);
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Build the encoding plan of a bitmap
+ *
+ * @param[out] plan         The plan
+ * @param[in]  Bitmap       Requested attributes
+ * @param[in]  max_attr_idx Highest attribute for the minor version
+ */
+
+static void fattr4_plan_build(struct fattr4_plan *plan,
+			      struct bitmap4 *Bitmap, int max_attr_idx)
+{
+	struct fattr4_plan_op *run = NULL;
+	struct fattr4_plan_op *op;
+	int attr;
+
+	memset(&plan->bitmap, 0, sizeof(plan->bitmap));
+	plan->bitmap.bitmap4_len = Bitmap->bitmap4_len;
+	memcpy(plan->bitmap.map, Bitmap->map,
+	       Bitmap->bitmap4_len * sizeof(uint32_t));
+	plan->max_attr_idx = max_attr_idx;
+	plan->nops = 0;
+
+	for (attr = next_attr_from_bitmap(Bitmap, -1);
+	     attr != -1 && attr <= max_attr_idx;
+	     attr = next_attr_from_bitmap(Bitmap, attr)) {
+		op = &plan->op[plan->nops++];
+		op->attr = attr;
+		op->size = fattr4_fixed_size(attr);
+		op->run = 0;
+
+		if (op->size == 0) {
+			run = NULL;
+			continue;
+		}
+		if (run == NULL)
+			run = op;
+		run->run += op->size;
+	}
+}
+
+static inline bool fattr4_plan_match(struct fattr4_plan *plan,
+				     struct bitmap4 *Bitmap, int max_attr_idx)
+{
+	return plan->max_attr_idx == max_attr_idx &&
+	    plan->bitmap.bitmap4_len == Bitmap->bitmap4_len &&
+	    memcmp(plan->bitmap.map, Bitmap->map,
+		   Bitmap->bitmap4_len * sizeof(uint32_t)) == 0;
+}
+
+/**
+ * @brief Find or build the encoding plan of a bitmap
+ *
+ * @param[in] Bitmap       Requested attributes, at most 3 words
+ * @param[in] max_attr_idx Highest attribute for the minor version
+ * @param[in] scratch      Where to build the plan if it can't be cached
+ *
+ * @return The plan.
+ */
+
+static struct fattr4_plan *fattr4_plan_get(struct bitmap4 *Bitmap,
+					   int max_attr_idx,
+					   struct fattr4_plan *scratch)
+{
+	uint32_t hash = max_attr_idx * 0x9e3779b1;
+	struct fattr4_plan *plan;
+	void *expected;
+	uint32_t i;
+
+	for (i = 0; i < Bitmap->bitmap4_len; i++)
+		hash = (hash ^ Bitmap->map[i]) * 0x85ebca6b;
+	hash ^= hash >> 16;
+
+	for (i = 0; i < FATTR4_PLAN_PROBES; i++) {
+		uint32_t slot = (hash + i) % FATTR4_PLAN_SLOTS;
+
+		plan = atomic_fetch_voidptr((void **)&fattr4_plans[slot]);
+		if (plan == NULL) {
+			plan = gsh_malloc(sizeof(*plan));
+			if (plan == NULL)
+				break;
+			fattr4_plan_build(plan, Bitmap, max_attr_idx);
+			expected = NULL;
+			if (atomic_cas_voidptr((void **)&fattr4_plans[slot],
+					       &expected, plan))
+				return plan;
+			/* Lost the slot, look at what won it */
+			gsh_free(plan);
+			plan = expected;
+		}
+		if (fattr4_plan_match(plan, Bitmap, max_attr_idx))
+			return plan;
+	}
+
+	fattr4_plan_build(scratch, Bitmap, max_attr_idx);
+	return scratch;
+}
+
 /**
  * @brief Converts FSAL Attributes to NFSv4 Fattr buffer.
  *
- * Converts FSAL Attributes to NFSv4 Fattr buffer.
+ * Converts FSAL Attributes to NFSv4 Fattr buffer.  The attributes are
+ * encoded on the stack following the plan of the bitmap, then copied
+ * to a buffer of the encoded size, from args->arena if set.
  *
  * @param[in]  args    XDR attribute arguments
  * @param[in]  Bitmap  Bitmap of attributes being requested
  * @param[out] Fattr   NFSv4 Fattr buffer
  *		       Memory for bitmap_val and attr_val is
  *                     dynamically allocated,
- *		       caller is responsible for freeing it.
+ *		       caller is responsible for freeing it
+ *		       unless it comes from an arena.
  *
  * @return -1 if failed, 0 if successful.
  *
@@ -3291,8 +3589,13 @@ int nfs4_Fattr_Fill_Error(fattr4 *Fattr, nfsstat4 rdattr_error)
 int nfs4_FSALattr_To_Fattr(struct xdr_attrs_args *args, struct bitmap4 *Bitmap,
 			   fattr4 *Fattr)
 {
-	int attribute_to_set = 0;
+	uint32_t attr_vals[NFS4_ATTRVALS_BUFFLEN / sizeof(uint32_t)];
+	struct fattr4_plan scratch;
+	struct fattr4_plan *plan;
+	struct fattr4_plan_op *op;
+	int32_t *p = NULL;
 	int max_attr_idx;
+	uint32_t i;
 	u_int LastOffset;
 	fsal_dynamicfsinfo_t dynamicinfo;
 	XDR attr_body;
@@ -3300,74 +3603,86 @@ int nfs4_FSALattr_To_Fattr(struct xdr_attrs_args *args, struct bitmap4 *Bitmap,
 
 	/* basic init */
 	memset(&Fattr->attrmask, 0, sizeof(Fattr->attrmask));
+	Fattr->attr_vals.attrlist4_len = 0;
+	Fattr->attr_vals.attrlist4_val = NULL;
 
 	if (Bitmap->bitmap4_len == 0)
 		return 0;	/* they ask for nothing, they get nothing */
 
-	Fattr->attr_vals.attrlist4_val = gsh_malloc(NFS4_ATTRVALS_BUFFLEN);
-
-	if (Fattr->attr_vals.attrlist4_val == NULL)
-		return -1;
-
 	max_attr_idx = nfs4_max_attr_index(args->data);
 	LogFullDebug(COMPONENT_NFS_V4, "Maximum allowed attr index = %d",
 		 max_attr_idx);
 
-	LastOffset = 0;
+	plan = fattr4_plan_get(Bitmap, max_attr_idx, &scratch);
+
 	memset(&attr_body, 0, sizeof(attr_body));
-	xdrmem_create(&attr_body, Fattr->attr_vals.attrlist4_val,
-		      NFS4_ATTRVALS_BUFFLEN, XDR_ENCODE);
+	xdrmem_create(&attr_body, (char *)attr_vals, sizeof(attr_vals),
+		      XDR_ENCODE);
 
 	if (args->dynamicinfo == NULL)
 		args->dynamicinfo = &dynamicinfo;
 
-	for (attribute_to_set = next_attr_from_bitmap(Bitmap, -1);
-	     attribute_to_set != -1;
-	     attribute_to_set =
-	     next_attr_from_bitmap(Bitmap, attribute_to_set)) {
-		if (attribute_to_set > max_attr_idx)
-			break;	/* skip out of bounds */
+	for (i = 0; i < plan->nops; i++) {
+		op = &plan->op[i];
+
+		/* Reserve a whole run of fixed size attributes, if the
+		 * stream can't give it they go through their encoders.
+		 */
+		if (op->run != 0)
+			p = (int32_t *)xdr_inline(&attr_body, op->run);
+
+		if (op->size != 0 && p != NULL)
+			xdr_res = fattr4_put_fixed(&p, op->attr, args)
+			    ? FATTR_XDR_SUCCESS : FATTR_XDR_FAILED;
+		else
+			xdr_res = fattr4tab[op->attr].encode(&attr_body, args);
 
-		xdr_res = fattr4tab[attribute_to_set].encode(&attr_body, args);
 		if (xdr_res == FATTR_XDR_SUCCESS) {
 			bool res = set_attribute_in_bitmap(&Fattr->attrmask,
-							   attribute_to_set);
+							   op->attr);
 			assert(res);
 			LogFullDebug(COMPONENT_NFS_V4,
 				     "Encoded attr %d, name = %s",
-				     attribute_to_set,
-				     fattr4tab[attribute_to_set].name);
+				     op->attr,
+				     fattr4tab[op->attr].name);
 		} else if (xdr_res == FATTR_XDR_NOOP) {
 			LogFullDebug(COMPONENT_NFS_V4,
 				     "Attr not supported %d name=%s",
-				     attribute_to_set,
-				     fattr4tab[attribute_to_set].name);
+				     op->attr,
+				     fattr4tab[op->attr].name);
 			continue;
 		} else {
 			LogFullDebug(COMPONENT_NFS_V4,
 				     "Encode FAILED for attr %d, name = %s",
-				     attribute_to_set,
-				     fattr4tab[attribute_to_set].name);
-
-			/* signal fail so if(LastOffset > 0) works right */
+				     op->attr,
+				     fattr4tab[op->attr].name);
 			goto err;
 		}
-		/* mark the attribute in the bitmap should be new bitmap btw */
 	}
-	LastOffset = xdr_getpos(&attr_body);	/* dumb but for now */
+	LastOffset = xdr_getpos(&attr_body);
 	xdr_destroy(&attr_body);
 
-	if (LastOffset == 0) {	/* no supported attrs so we can free */
+	if (LastOffset == 0) {	/* no supported attrs */
 		assert(Fattr->attrmask.bitmap4_len == 0);
-		gsh_free(Fattr->attr_vals.attrlist4_val);
-		Fattr->attr_vals.attrlist4_val = NULL;
+		return 0;
 	}
+
+	if (args->arena != NULL) {
+		Fattr->attr_vals.attrlist4_val =
+		    gsh_arena_memdup(args->arena, attr_vals, LastOffset);
+	} else {
+		Fattr->attr_vals.attrlist4_val = gsh_malloc(LastOffset);
+		if (Fattr->attr_vals.attrlist4_val != NULL)
+			memcpy(Fattr->attr_vals.attrlist4_val, attr_vals,
+			       LastOffset);
+	}
+	if (Fattr->attr_vals.attrlist4_val == NULL)
+		return -1;
 	Fattr->attr_vals.attrlist4_len = LastOffset;
 	return 0;
 
  err:
-	gsh_free(Fattr->attr_vals.attrlist4_val);
-	Fattr->attr_vals.attrlist4_val = NULL;
+	xdr_destroy(&attr_body);
 	return -1;
 }
 
@@ -4081,6 +4396,25 @@ int nfs4_Fattr_To_FSAL_attr(struct attrlist *FSAL_attr, fattr4 *Fattr,
 	return Fattr4_To_FSAL_attr(FSAL_attr, Fattr, NULL, NULL, data);
 }
 
+/**
+ * @brief Convert NFSv4 attributes to FSAL attributes and a file handle
+ *
+ * As nfs4_Fattr_To_FSAL_attr, also decoding FATTR4_FILEHANDLE.
+ *
+ * @param[out]    FSAL_attr FSAL attributes
+ * @param[in]     Fattr     NFSv4 attributes
+ * @param[in,out] hdl4      Buffer for the file handle; its length is
+ *                          left alone if there is none
+ *
+ * @return NFS4_OK if successful, NFS4ERR codes if not.
+ */
+int nfs4_Fattr_To_FSAL_attr_fh(struct attrlist *FSAL_attr, fattr4 *Fattr,
+			       nfs_fh4 *hdl4)
+{
+	memset(FSAL_attr, 0, sizeof(struct attrlist));
+	return Fattr4_To_FSAL_attr(FSAL_attr, Fattr, hdl4, NULL, NULL);
+}
+
 /**
  *
  * nfs4_Fattr_To_fsinfo: Decode filesystem info out of NFSv4 attributes.
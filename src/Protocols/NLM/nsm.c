@@ -27,15 +27,54 @@
 #include <sys/utsname.h>
 #include "abstract_atomic.h"
 #include "gsh_rpc.h"
+#include "gsh_list.h"
+#include "fridgethr.h"
 #include "nsm.h"
 #include "sal_data.h"
 
+/**
+ * @file nsm.c
+ * @brief Talking to the local status monitor (rpc.statd)
+ *
+ * Monitoring and unmonitoring a client makes statd write its monitor
+ * files, which can take a while.  Rather than have the worker handling
+ * an NLM request wait on that, nsm_monitor and nsm_unmonitor only
+ * queue a request and return; the NSM thread sends the queue to statd
+ * in batches over a connection it keeps open.  Requests for a client
+ * still in the queue are coalesced, so a client monitored and
+ * unmonitored in quick succession costs statd nothing.
+ *
+ * The connection and nodename are protected by nsm_mutex, the queue by
+ * nsm_queue_mutex.  Neither is held by workers across a call to statd.
+ */
+
+/** Seconds to wait before talking to statd again after a failure */
+#define NSM_RETRY_DELAY 10
+
+/** Seconds the NSM thread sleeps when not woken */
+#define NSM_THREAD_DELAY 1
+
+/**
+ * @brief A queued request to statd
+ */
+
+struct nsm_request {
+	struct glist_head nr_list;	/*< Link in nsm_queue */
+	bool nr_monitor;	/*< SM_MON if true, else SM_UNMON */
+	char nr_name[];		/*< mon_name of the client */
+};
+
 pthread_mutex_t nsm_mutex = PTHREAD_MUTEX_INITIALIZER;
 CLIENT *nsm_clnt;
 AUTH *nsm_auth;
-unsigned long nsm_count;
 char *nodename;
 
+static pthread_mutex_t nsm_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct glist_head nsm_queue = GLIST_HEAD_INIT(nsm_queue);
+static time_t nsm_retry_time;	/*< Only used by the NSM thread */
+static struct fridgethr *nsm_fridge;
+static bool nsm_running;	/*< Protected by nsm_queue_mutex */
+
 bool nsm_connect()
 {
 	struct utsname utsname;
@@ -63,17 +102,18 @@ bool nsm_connect()
 		LogCrit(COMPONENT_NLM, "failed to connect to statd");
 		gsh_free(nodename);
 		nodename = NULL;
+		return false;
 	}
 
 	/* split auth (for authnone, idempotent) */
 	nsm_auth = authnone_create();
 
-	return nsm_clnt != NULL;
+	return true;
 }
 
 void nsm_disconnect()
 {
-	if (nsm_count == 0 && nsm_clnt != NULL) {
+	if (nsm_clnt != NULL) {
 		gsh_clnt_destroy(nsm_clnt);
 		nsm_clnt = NULL;
 		AUTH_DESTROY(nsm_auth);
@@ -83,158 +123,382 @@ void nsm_disconnect()
 	}
 }
 
-bool nsm_monitor(state_nsm_client_t *host)
+/**
+ * @brief Queue a request to statd
+ *
+ * A request already queued for the same client is replaced, since
+ * only the last state asked for matters to statd.
+ *
+ * @param[in] name    mon_name of the client
+ * @param[in] monitor Whether to monitor or unmonitor it
+ *
+ * @return false if the request could not be queued.
+ */
+
+static bool nsm_queue_request(const char *name, bool monitor)
+{
+	struct glist_head *glist;
+	struct nsm_request *req;
+	size_t len = strlen(name) + 1;
+	bool wake;
+
+	PTHREAD_MUTEX_lock(&nsm_queue_mutex);
+
+	glist_for_each(glist, &nsm_queue) {
+		req = glist_entry(glist, struct nsm_request, nr_list);
+		if (strcmp(req->nr_name, name) == 0) {
+			req->nr_monitor = monitor;
+			PTHREAD_MUTEX_unlock(&nsm_queue_mutex);
+			return true;
+		}
+	}
+
+	req = gsh_malloc(sizeof(*req) + len);
+	if (req == NULL) {
+		PTHREAD_MUTEX_unlock(&nsm_queue_mutex);
+		LogCrit(COMPONENT_NLM, "No memory to %smonitor %s",
+			monitor ? "" : "un", name);
+		return false;
+	}
+
+	req->nr_monitor = monitor;
+	memcpy(req->nr_name, name, len);
+	glist_add_tail(&nsm_queue, &req->nr_list);
+	wake = nsm_running;
+
+	PTHREAD_MUTEX_unlock(&nsm_queue_mutex);
+
+	if (wake)
+		fridgethr_wake(nsm_fridge);
+
+	return true;
+}
+
+/**
+ * @brief Send one request to statd
+ *
+ * Called with nsm_mutex held and a connection to statd.
+ *
+ * @param[in] req The request
+ *
+ * @return false if statd could not be reached, true if it answered,
+ *         whether or not it did what was asked.
+ */
+
+static bool nsm_send(struct nsm_request *req)
 {
 	enum clnt_stat ret;
 	struct mon nsm_mon;
 	struct sm_stat_res res;
+	struct sm_stat unmon_res;
 	struct timeval tout = { 25, 0 };
 
-	if (host == NULL)
-		return true;
-
-	PTHREAD_MUTEX_lock(&host->ssc_mutex);
-
-	if (atomic_fetch_int32_t(&host->ssc_monitored)) {
-		PTHREAD_MUTEX_unlock(&host->ssc_mutex);
-		return true;
-	}
-
-	nsm_mon.mon_id.mon_name = host->ssc_nlm_caller_name;
+	memset(&nsm_mon, 0, sizeof(nsm_mon));
+	nsm_mon.mon_id.mon_name = req->nr_name;
+	nsm_mon.mon_id.my_id.my_name = nodename;
 	nsm_mon.mon_id.my_id.my_prog = NLMPROG;
 	nsm_mon.mon_id.my_id.my_vers = NLM4_VERS;
 	nsm_mon.mon_id.my_id.my_proc = NLMPROC4_SM_NOTIFY;
 	/* nothing to put in the private data */
-	LogDebug(COMPONENT_NLM, "Monitor %s", host->ssc_nlm_caller_name);
-
-	PTHREAD_MUTEX_lock(&nsm_mutex);
 
-	/* create a connection to nsm on the localhost */
-	if (!nsm_connect()) {
-		LogCrit(COMPONENT_NLM,
-			"Can not monitor %s clnt_create returned NULL",
-			nsm_mon.mon_id.mon_name);
-		PTHREAD_MUTEX_unlock(&nsm_mutex);
-		PTHREAD_MUTEX_unlock(&host->ssc_mutex);
-		return false;
+	if (req->nr_monitor) {
+		ret = clnt_call(nsm_clnt,
+				nsm_auth,
+				SM_MON,
+				(xdrproc_t) xdr_mon,
+				&nsm_mon,
+				(xdrproc_t) xdr_sm_stat_res,
+				&res,
+				tout);
+	} else {
+		ret = clnt_call(nsm_clnt,
+				nsm_auth,
+				SM_UNMON,
+				(xdrproc_t) xdr_mon_id,
+				&nsm_mon.mon_id,
+				(xdrproc_t) xdr_sm_stat,
+				&unmon_res,
+				tout);
 	}
 
-	/* Set this after we call nsm_connect() */
-	nsm_mon.mon_id.my_id.my_name = nodename;
-
-	ret = clnt_call(nsm_clnt,
-			nsm_auth,
-			SM_MON,
-			(xdrproc_t) xdr_mon,
-			&nsm_mon,
-			(xdrproc_t) xdr_sm_stat_res,
-			&res,
-			tout);
-
 	if (ret != RPC_SUCCESS) {
 		LogCrit(COMPONENT_NLM,
-			"Can not monitor %s SM_MON ret %d %s",
-			nsm_mon.mon_id.mon_name,
+			"Can not %s %s ret %d %s",
+			req->nr_monitor ? "monitor" : "unmonitor",
+			req->nr_name,
 			ret,
 			clnt_sperror(nsm_clnt, ""));
-
-		nsm_disconnect();
-		PTHREAD_MUTEX_unlock(&nsm_mutex);
-		PTHREAD_MUTEX_unlock(&host->ssc_mutex);
 		return false;
 	}
 
-	if (res.res_stat != STAT_SUCC) {
+	if (req->nr_monitor && res.res_stat != STAT_SUCC) {
 		LogCrit(COMPONENT_NLM,
 			"Can not monitor %s SM_MON status %d",
-			nsm_mon.mon_id.mon_name, res.res_stat);
+			req->nr_name, res.res_stat);
+		return true;
+	}
 
-		nsm_disconnect();
-		PTHREAD_MUTEX_unlock(&nsm_mutex);
-		PTHREAD_MUTEX_unlock(&host->ssc_mutex);
+	LogDebug(COMPONENT_NLM,
+		 "%s %s for nodename %s",
+		 req->nr_monitor ? "Monitored" : "Unmonitored",
+		 req->nr_name, nodename);
+
+	return true;
+}
+
+/**
+ * @brief Send the queued requests to statd
+ *
+ * The whole queue is taken at once and sent over one connection.  If
+ * statd can't be reached, what wasn't sent goes back on the queue,
+ * unless a newer request for the same client has been queued, to be
+ * tried again after NSM_RETRY_DELAY.
+ *
+ * @param[in] ctx Fridge context
+ *
+ * @return true if a batch was sent in full.
+ */
+
+static bool nsm_send_queue(struct fridgethr_context *ctx)
+{
+	struct glist_head batch = GLIST_HEAD_INIT(batch);
+	struct glist_head *glist, *glistn, *g;
+	struct nsm_request *req, *newer;
+	bool failed = false;
+
+	PTHREAD_MUTEX_lock(&nsm_queue_mutex);
+	glist_splice_tail(&batch, &nsm_queue);
+	PTHREAD_MUTEX_unlock(&nsm_queue_mutex);
+
+	if (glist_empty(&batch))
 		return false;
-	}
 
-	nsm_count++;
-	atomic_store_int32_t(&host->ssc_monitored, true);
+	PTHREAD_MUTEX_lock(&nsm_mutex);
 
-	LogDebug(COMPONENT_NLM,
-		 "Monitored %s for nodename %s",
-		 nsm_mon.mon_id.mon_name, nodename);
+	if (!nsm_connect())
+		failed = true;
+
+	glist_for_each_safe(glist, glistn, &batch) {
+		req = glist_entry(glist, struct nsm_request, nr_list);
+
+		if (failed || fridgethr_you_should_break(ctx))
+			break;
+
+		if (!nsm_send(req)) {
+			nsm_disconnect();
+			failed = true;
+			break;
+		}
+
+		glist_del(&req->nr_list);
+		gsh_free(req);
+	}
 
 	PTHREAD_MUTEX_unlock(&nsm_mutex);
-	PTHREAD_MUTEX_unlock(&host->ssc_mutex);
-	return true;
+
+	if (glist_empty(&batch))
+		return true;
+
+	if (failed)
+		nsm_retry_time = time(NULL) + NSM_RETRY_DELAY;
+
+	/* Put back what wasn't sent unless it has since been superseded */
+	PTHREAD_MUTEX_lock(&nsm_queue_mutex);
+
+	glist_for_each_safe(glist, glistn, &batch) {
+		req = glist_entry(glist, struct nsm_request, nr_list);
+
+		glist_for_each(g, &nsm_queue) {
+			newer = glist_entry(g, struct nsm_request, nr_list);
+			if (strcmp(newer->nr_name, req->nr_name) == 0)
+				break;
+		}
+
+		if (g != &nsm_queue) {
+			glist_del(&req->nr_list);
+			gsh_free(req);
+		}
+	}
+
+	/* Ahead of anything queued meanwhile */
+	glist_splice_tail(&batch, &nsm_queue);
+	glist_splice_tail(&nsm_queue, &batch);
+
+	PTHREAD_MUTEX_unlock(&nsm_queue_mutex);
+
+	return false;
 }
 
-bool nsm_unmonitor(state_nsm_client_t *host)
+/**
+ * @brief Body of the NSM thread
+ *
+ * Keeps sending until the queue is empty, since requests queued while
+ * a batch is in flight don't wake the thread.
+ *
+ * @param[in] ctx Fridge context
+ */
+
+static void nsm_run(struct fridgethr_context *ctx)
 {
-	enum clnt_stat ret;
-	struct sm_stat res;
-	struct mon_id nsm_mon_id;
-	struct timeval tout = { 25, 0 };
+	SetNameFunction("nsm");
+
+	if (time(NULL) < nsm_retry_time)
+		return;
+
+	while (nsm_send_queue(ctx) && !fridgethr_you_should_break(ctx))
+		;
+}
+
+/**
+ * @brief Start the NSM thread
+ *
+ * @return 0 on success, POSIX errors on failure.
+ */
+
+int nsm_init(void)
+{
+	struct fridgethr_params frp;
+	int rc;
+
+	memset(&frp, 0, sizeof(struct fridgethr_params));
+	frp.thr_max = 1;
+	frp.thr_min = 1;
+	frp.thread_delay = NSM_THREAD_DELAY;
+	frp.flavor = fridgethr_flavor_looper;
+
+	rc = fridgethr_init(&nsm_fridge, "NSM", &frp);
+	if (rc != 0) {
+		LogMajor(COMPONENT_NLM,
+			 "Unable to initialize NSM fridge, error code %d.",
+			 rc);
+		return rc;
+	}
+
+	rc = fridgethr_submit(nsm_fridge, nsm_run, NULL);
+	if (rc != 0) {
+		LogMajor(COMPONENT_NLM,
+			 "Unable to start NSM thread, error code %d.", rc);
+		return rc;
+	}
+
+	PTHREAD_MUTEX_lock(&nsm_queue_mutex);
+	nsm_running = true;
+	PTHREAD_MUTEX_unlock(&nsm_queue_mutex);
+
+	return 0;
+}
+
+/**
+ * @brief Stop the NSM thread
+ *
+ * Requests still queued are dropped; statd is left as it was.
+ *
+ * @return 0 on success, POSIX errors on failure.
+ */
+
+int nsm_shutdown(void)
+{
+	struct glist_head *glist, *glistn;
+	int rc;
+
+	PTHREAD_MUTEX_lock(&nsm_queue_mutex);
+	if (!nsm_running) {
+		PTHREAD_MUTEX_unlock(&nsm_queue_mutex);
+		return 0;
+	}
+	nsm_running = false;
+	PTHREAD_MUTEX_unlock(&nsm_queue_mutex);
+
+	rc = fridgethr_sync_command(nsm_fridge, fridgethr_comm_stop, 120);
+
+	if (rc == ETIMEDOUT) {
+		LogMajor(COMPONENT_NLM,
+			 "Shutdown timed out, cancelling threads.");
+		fridgethr_cancel(nsm_fridge);
+	} else if (rc != 0) {
+		LogMajor(COMPONENT_NLM,
+			 "Failed shutting down NSM thread: %d", rc);
+	}
+
+	PTHREAD_MUTEX_lock(&nsm_queue_mutex);
+	glist_for_each_safe(glist, glistn, &nsm_queue) {
+		glist_del(glist);
+		gsh_free(glist_entry(glist, struct nsm_request, nr_list));
+	}
+	PTHREAD_MUTEX_unlock(&nsm_queue_mutex);
+
+	PTHREAD_MUTEX_lock(&nsm_mutex);
+	nsm_disconnect();
+	PTHREAD_MUTEX_unlock(&nsm_mutex);
+
+	return rc;
+}
+
+/**
+ * @brief Monitor a client
+ *
+ * The client counts as monitored as soon as the request is queued;
+ * statd is told later by the NSM thread.
+ *
+ * @param[in] host The client
+ *
+ * @return false if the request could not be queued.
+ */
 
+bool nsm_monitor(state_nsm_client_t *host)
+{
 	if (host == NULL)
 		return true;
 
 	PTHREAD_MUTEX_lock(&host->ssc_mutex);
 
-	if (!atomic_fetch_int32_t(&host->ssc_monitored)) {
+	if (atomic_fetch_int32_t(&host->ssc_monitored)) {
 		PTHREAD_MUTEX_unlock(&host->ssc_mutex);
 		return true;
 	}
 
-	nsm_mon_id.mon_name = host->ssc_nlm_caller_name;
-	nsm_mon_id.my_id.my_prog = NLMPROG;
-	nsm_mon_id.my_id.my_vers = NLM4_VERS;
-	nsm_mon_id.my_id.my_proc = NLMPROC4_SM_NOTIFY;
-
-	PTHREAD_MUTEX_lock(&nsm_mutex);
+	LogDebug(COMPONENT_NLM, "Monitor %s", host->ssc_nlm_caller_name);
 
-	/* create a connection to nsm on the localhost */
-	if (!nsm_connect()) {
-		LogCrit(COMPONENT_NLM,
-			"Can not unmonitor %s clnt_create returned NULL",
-			nsm_mon_id.mon_name);
-		PTHREAD_MUTEX_unlock(&nsm_mutex);
+	if (!nsm_queue_request(host->ssc_nlm_caller_name, true)) {
 		PTHREAD_MUTEX_unlock(&host->ssc_mutex);
 		return false;
 	}
 
-	/* Set this after we call nsm_connect() */
-	nsm_mon_id.my_id.my_name = nodename;
+	atomic_store_int32_t(&host->ssc_monitored, true);
 
-	ret = clnt_call(nsm_clnt,
-			nsm_auth,
-			SM_UNMON,
-			(xdrproc_t) xdr_mon_id,
-			&nsm_mon_id,
-			(xdrproc_t) xdr_sm_stat,
-			&res,
-			tout);
+	PTHREAD_MUTEX_unlock(&host->ssc_mutex);
+	return true;
+}
 
-	if (ret != RPC_SUCCESS) {
-		LogCrit(COMPONENT_NLM,
-			"Can not unmonitor %s SM_MON ret %d %s",
-			nsm_mon_id.mon_name,
-			ret,
-			clnt_sperror(nsm_clnt, ""));
+/**
+ * @brief Unmonitor a client
+ *
+ * @param[in] host The client
+ *
+ * @return false if the request could not be queued.
+ */
 
-		nsm_disconnect();
-		PTHREAD_MUTEX_unlock(&nsm_mutex);
+bool nsm_unmonitor(state_nsm_client_t *host)
+{
+	if (host == NULL)
+		return true;
+
+	PTHREAD_MUTEX_lock(&host->ssc_mutex);
+
+	if (!atomic_fetch_int32_t(&host->ssc_monitored)) {
 		PTHREAD_MUTEX_unlock(&host->ssc_mutex);
-		return false;
+		return true;
 	}
 
-	atomic_store_int32_t(&host->ssc_monitored, false);
-	nsm_count--;
+	LogDebug(COMPONENT_NLM, "Unmonitor %s", host->ssc_nlm_caller_name);
 
-	LogDebug(COMPONENT_NLM, "Unonitored %s for nodename %s",
-		 nsm_mon_id.mon_name, nodename);
+	if (!nsm_queue_request(host->ssc_nlm_caller_name, false)) {
+		PTHREAD_MUTEX_unlock(&host->ssc_mutex);
+		return false;
+	}
 
-	nsm_disconnect();
+	atomic_store_int32_t(&host->ssc_monitored, false);
 
-	PTHREAD_MUTEX_unlock(&nsm_mutex);
 	PTHREAD_MUTEX_unlock(&host->ssc_mutex);
 	return true;
 }
@@ -277,8 +541,8 @@ void nsm_unmonitor_all(void)
 			"Can not unmonitor all ret %d %s",
 			ret,
 			clnt_sperror(nsm_clnt, ""));
+		nsm_disconnect();
 	}
 
-	nsm_disconnect();
 	PTHREAD_MUTEX_unlock(&nsm_mutex);
 }
@@ -47,6 +47,7 @@
 #include "nfs_dupreq.h"
 #include "city.h"
 #include "abstract_mem.h"
+#include "gsh_slab.h"
 #include "gsh_intrinsic.h"
 #include "wait_queue.h"
 
@@ -76,7 +77,6 @@ struct drc_st {
 	struct rbtree_x tcp_drc_recycle_t;
 	 TAILQ_HEAD(drc_st_tailq, drc) tcp_drc_recycle_q;	/* fifo */
 	int32_t tcp_drc_recycle_qlen;
-	time_t last_expire_check;
 	uint32_t expire_delta;
 };
 
@@ -228,6 +228,8 @@ static inline void init_shared_drc()
 	drc->cachesz = nfs_param.core_param.drc.udp.cachesz;
 	drc->npart = nfs_param.core_param.drc.udp.npart;
 	drc->hiwat = nfs_param.core_param.drc.udp.hiwat;
+	drc->bytes = 0;
+	drc->hiwat_bytes = nfs_param.core_param.drc.udp.hiwat_bytes;
 
 	gsh_mutex_init(&drc->mtx, NULL);
 
@@ -267,13 +269,14 @@ void dupreq2_pkginit(void)
 
 	dupreq_pool = pool_init("Duplicate Request Pool",
 				sizeof(dupreq_entry_t),
-				pool_basic_substrate, NULL, NULL, NULL);
+				pool_slab_substrate, NULL, NULL, NULL);
 	if (unlikely(!(dupreq_pool)))
 		LogFatal(COMPONENT_INIT,
 			 "Error while allocating duplicate request pool");
 
-	nfs_res_pool = pool_init("nfs_res_t pool", sizeof(nfs_res_t),
-				 pool_basic_substrate,
+	nfs_res_pool = pool_init("nfs_res_t pool",
+				 sizeof(struct nfs_res_block),
+				 pool_slab_substrate,
 				 NULL, NULL, NULL);
 	if (unlikely(!(nfs_res_pool)))
 		LogFatal(COMPONENT_INIT,
@@ -301,7 +304,6 @@ void dupreq2_pkginit(void)
 	/* init recycle_q */
 	TAILQ_INIT(&drc_st->tcp_drc_recycle_q);
 	drc_st->tcp_drc_recycle_qlen = 0;
-	drc_st->last_expire_check = time(NULL);
 	drc_st->expire_delta = nfs_param.core_param.drc.tcp.recycle_expire_s;
 
 	/* UDP DRC is global, shared */
@@ -370,7 +372,9 @@ static inline drc_t *alloc_tcp_drc(enum drc_type dtype)
 	drc->maxsize = nfs_param.core_param.drc.tcp.size;
 	drc->cachesz = nfs_param.core_param.drc.tcp.cachesz;
 	drc->npart = nfs_param.core_param.drc.tcp.npart;
-	drc->hiwat = nfs_param.core_param.drc.udp.hiwat;
+	drc->hiwat = nfs_param.core_param.drc.tcp.hiwat;
+	drc->bytes = 0;
+	drc->hiwat_bytes = nfs_param.core_param.drc.tcp.hiwat_bytes;
 
 	PTHREAD_MUTEX_init(&drc->mtx, NULL);
 
@@ -452,9 +456,12 @@ static inline uint32_t nfs_dupreq_unref_drc(drc_t *drc)
 	PTHREAD_MUTEX_unlock(&drc_st->mtx);
 
 /**
- * @brief Check for expired TCP DRCs.
+ * @brief Free expired TCP DRCs.
+ *
+ * The recycle queue is in order of recycle_time, so only its expired
+ * head is visited.  Called periodically from the reaper thread.
  */
-static inline void drc_free_expired(void)
+void dupreq2_free_expired(void)
 {
 	drc_t *drc;
 	time_t now = time(NULL);
@@ -463,8 +470,7 @@ static inline void drc_free_expired(void)
 
 	DRC_ST_LOCK();
 
-	if ((drc_st->tcp_drc_recycle_qlen < 1) ||
-	    (now - drc_st->last_expire_check) < 600) /* 10m */
+	if (drc_st->tcp_drc_recycle_qlen < 1)
 		goto unlock;
 
 	do {
@@ -506,7 +512,6 @@ static inline void drc_free_expired(void)
 			LogFullDebug(COMPONENT_DUPREQ,
 				     "unexpired drc %p in recycle queue "
 				     "expire check (nothing happens)", drc);
-			drc_st->last_expire_check = now;
 			break;
 		}
 
@@ -529,7 +534,6 @@ nfs_dupreq_get_drc(struct svc_req *req)
 	enum drc_type dtype = get_drc_type(req);
 	gsh_xprt_private_t *xu = (gsh_xprt_private_t *) req->rq_xprt->xp_u1;
 	drc_t *drc = NULL;
-	bool drc_check_expired = false;
 
 	switch (dtype) {
 	case DRC_UDP_V234:
@@ -614,10 +618,6 @@ nfs_dupreq_get_drc(struct svc_req *req)
 			/* xprt drc */
 			(void)nfs_dupreq_ref_drc(drc);	/* xu ref */
 
-			/* try to expire unused DRCs somewhat in proportion to
-			 * new connection arrivals */
-			drc_check_expired = true;
-
 			LogFullDebug(COMPONENT_DUPREQ,
 				     "after ref drc %p refcnt==%u ", drc,
 				     drc->refcnt);
@@ -635,9 +635,6 @@ nfs_dupreq_get_drc(struct svc_req *req)
 	(void)nfs_dupreq_ref_drc(drc);
 	PTHREAD_MUTEX_unlock(&drc->mtx);
 
-	if (drc_check_expired)
-		drc_free_expired();
-
 out:
 	return drc;
 }
@@ -805,10 +802,91 @@ static inline void nfs_dupreq_free_dupreq(dupreq_entry_t *dv)
 		func->free_function(dv->res);
 		free_nfs_res(dv->res);
 	}
+	if (dv->reply.buf)
+		gsh_free(dv->reply.buf);
 	PTHREAD_MUTEX_destroy(&dv->mtx);
 	pool_free(dupreq_pool, dv);
 }
 
+/**
+ * @brief Memory charged to a DRC for an entry
+ *
+ * Only what we can see is charged: the entry itself and its encoded
+ * reply.  A decoded result is charged nothing for the heap it points
+ * to, so byte limits are only exact with DRC_Encoded.
+ *
+ * @param[in] dv The duplicate request entry
+ *
+ * @return Size in bytes.
+ */
+static inline uint64_t dupreq_bytes(dupreq_entry_t *dv)
+{
+	return sizeof(dupreq_entry_t) + dv->reply.len;
+}
+
+/**
+ * @brief Replace a result with its encoding
+ *
+ * The reply body is encoded once into a buffer sized for it, and the
+ * decoded result, with everything it points to, is freed.  If the
+ * result can't be encoded it is kept as it is.
+ *
+ * @param[in,out] dv  The duplicate request entry
+ * @param[in]     res The result
+ *
+ * @return true if the result was encoded (and freed).
+ */
+static bool nfs_dupreq_encode(dupreq_entry_t *dv, nfs_res_t *res)
+{
+	const nfs_function_desc_t *func = nfs_dupreq_func(dv);
+	unsigned long len;
+	XDR xdrs;
+	char *buf;
+	bool encoded;
+
+	if (unlikely(!func))
+		return false;
+
+	len = xdr_sizeof(func->xdr_encode_func, res);
+	if (len == 0 || len > UINT32_MAX)
+		return false;
+
+	buf = gsh_malloc(len);
+	if (buf == NULL)
+		return false;
+
+	xdrmem_create(&xdrs, buf, len, XDR_ENCODE);
+	encoded = func->xdr_encode_func(&xdrs, res);
+	XDR_DESTROY(&xdrs);
+	if (!encoded) {
+		LogDebug(COMPONENT_DUPREQ, "encoding dv=%p failed", dv);
+		gsh_free(buf);
+		return false;
+	}
+
+	func->free_function(res);
+	free_nfs_res(res);
+	dv->reply.buf = buf;
+	dv->reply.len = len;
+	return true;
+}
+
+/**
+ * @brief XDR "encoder" for an already encoded reply body
+ *
+ * @param[in] xdrs XDR stream
+ * @param[in] dv   The duplicate request entry holding the reply
+ *
+ * @return true if successful.
+ */
+static bool xdr_dupreq_reply(XDR *xdrs, dupreq_entry_t *dv)
+{
+	if (xdrs->x_op != XDR_ENCODE)
+		return true;
+
+	return XDR_PUTBYTES(xdrs, dv->reply.buf, dv->reply.len);
+}
+
 /**
  * @page DRC_RETIRE DRC request retire heuristic.
  *
@@ -875,6 +953,10 @@ static inline bool drc_should_retire(drc_t *drc)
 	if (unlikely(drc->size > drc->hiwat))
 		return true;
 
+	/* or if it holds more memory than it should */
+	if (unlikely(drc->hiwat_bytes != 0 && drc->bytes > drc->hiwat_bytes))
+		return true;
+
 	return false;
 }
 
@@ -1032,6 +1114,7 @@ dupreq_status_t nfs_dupreq_start(nfs_request_data_t *nfs_req,
 			PTHREAD_MUTEX_lock(&drc->mtx);
 			TAILQ_INSERT_TAIL(&drc->dupreq_q, dk, fifo_q);
 			++(drc->size);
+			drc->bytes += dupreq_bytes(dk);
 			PTHREAD_MUTEX_unlock(&drc->mtx);
 			req->rq_u1 = dk;
 			release_dk = false;
@@ -1053,8 +1136,11 @@ dupreq_status_t nfs_dupreq_start(nfs_request_data_t *nfs_req,
 	nfs_dupreq_put_drc(req->rq_xprt, drc, DRC_FLAG_NONE);	/* dk ref */
 
  out:
+	/* an encoded reply leaves no result to thread through */
 	if (res)
 		nfs_req->res_nfs = req->rq_u2 = res;
+	else
+		nfs_req->res_nfs = NULL;
 
 	return status;
 }
@@ -1101,7 +1187,10 @@ dupreq_status_t nfs_dupreq_finish(struct svc_req *req, nfs_res_t *res_nfs)
 		goto out;
 
 	PTHREAD_MUTEX_lock(&dv->mtx);
-	dv->res = res_nfs;
+	if (nfs_param.core_param.drc.encoded && nfs_dupreq_encode(dv, res_nfs))
+		dv->res = NULL;
+	else
+		dv->res = res_nfs;
 	dv->timestamp = time(NULL);
 	dv->state = DUPREQ_COMPLETE;
 	drc = dv->hin.drc;
@@ -1109,6 +1198,7 @@ dupreq_status_t nfs_dupreq_finish(struct svc_req *req, nfs_res_t *res_nfs)
 
 	/* cond. remove from q head */
 	PTHREAD_MUTEX_lock(&drc->mtx);
+	drc->bytes += dv->reply.len;
 
 	LogFullDebug(COMPONENT_DUPREQ,
 		     "completing dv=%p xid=%u on DRC=%p state=%s, status=%s, "
@@ -1132,6 +1222,7 @@ dupreq_status_t nfs_dupreq_finish(struct svc_req *req, nfs_res_t *res_nfs)
 			/* remove q entry */
 			TAILQ_REMOVE(&drc->dupreq_q, ov, fifo_q);
 			--(drc->size);
+			drc->bytes -= dupreq_bytes(ov);
 
 			/* remove dict entry */
 			t = rbtx_partition_of_scalar(&drc->xt, ov->hk);
@@ -1160,6 +1251,37 @@ dupreq_status_t nfs_dupreq_finish(struct svc_req *req, nfs_res_t *res_nfs)
 	return status;
 }
 
+/**
+ * @brief Send the reply to a request
+ *
+ * A request whose cache entry holds an encoded reply, whether it was
+ * just completed or is being replayed, has those bytes copied out as
+ * they are; anything else has its result encoded as usual.
+ *
+ * The caller must hold the transport's send lock where required.
+ *
+ * @param[in] xprt The transport
+ * @param[in] req  The request
+ * @param[in] func The function descriptor for this request type
+ * @param[in] res  The decoded result, if there is one
+ *
+ * @return The result of svc_sendreply.
+ */
+bool nfs_dupreq_sendreply(SVCXPRT *xprt, struct svc_req *req,
+			  const nfs_function_desc_t *func, nfs_res_t *res)
+{
+	dupreq_entry_t *dv = (dupreq_entry_t *)req->rq_u1;
+
+	/* the reply of a completed entry never changes, and our ref
+	 * keeps the entry from being retired */
+	if (dv != (void *)DUPREQ_NOCACHE && dv != (void *)DUPREQ_BAD_ADDR1
+	    && dv->reply.buf != NULL)
+		return svc_sendreply(xprt, req, (xdrproc_t) xdr_dupreq_reply,
+				     (caddr_t) dv);
+
+	return svc_sendreply(xprt, req, func->xdr_encode_func, (caddr_t) res);
+}
+
 /**
  *
  * @brief Remove an entry (request) from a duplicate request cache.
@@ -1214,6 +1336,7 @@ dupreq_status_t nfs_dupreq_delete(struct svc_req *req)
 	if (TAILQ_IS_ENQUEUED(dv, fifo_q))
 		TAILQ_REMOVE(&drc->dupreq_q, dv, fifo_q);
 	--(drc->size);
+	drc->bytes -= dupreq_bytes(dv);
 
 	/* release dv's ref and unlock */
 	nfs_dupreq_put_drc(req->rq_xprt, drc, DRC_FLAG_LOCKED);
@@ -36,6 +36,7 @@
 
 #include "config.h"
 #include "nfs_core.h"
+#include "nfs_proto_functions.h"
 #include "sal_functions.h"
 
 /**
@@ -55,6 +56,12 @@ hash_table_t *ht_session_id;
 
 uint64_t global_sequence = 0;
 
+/**
+ * @param Bytes taken by the replies cached in session slots
+ */
+
+static uint64_t slot_cache_bytes;
+
 /**
  * @brief Display a session ID
  *
@@ -187,7 +194,7 @@ static hash_parameter_t session_id_param = {
 	.compare_key = compare_session_id,
 	.key_to_str = display_session_id_key,
 	.val_to_str = display_session_id_val,
-	.flags = HT_FLAG_CACHE,
+	.flags = HT_FLAG_OPEN_ADDR,
 };
 
 /**
@@ -237,7 +244,7 @@ int32_t inc_session_ref(nfs41_session_t *session)
 
 int32_t dec_session_ref(nfs41_session_t *session)
 {
-	int i;
+	uint32_t i;
 	int32_t refcnt = atomic_dec_int32_t(&session->refcount);
 
 	if (refcnt == 0) {
@@ -252,8 +259,12 @@ int32_t dec_session_ref(nfs41_session_t *session)
 		dec_client_id_ref(session->clientid_record);
 		/* Destroy this session's mutexes and condition variable */
 
-		for (i = 0; i < NFS41_NB_SLOTS; i++)
+		for (i = 0; i < session->fore_channel_attrs.ca_maxrequests;
+		     i++) {
+			nfs41_Session_Slot_Release(&session->slots[i]);
 			PTHREAD_MUTEX_destroy(&session->slots[i].lock);
+		}
+		gsh_free(session->slots);
 
 		PTHREAD_COND_destroy(&session->cb_cond);
 		PTHREAD_MUTEX_destroy(&session->cb_mutex);
@@ -269,6 +280,138 @@ int32_t dec_session_ref(nfs41_session_t *session)
 	return refcnt;
 }
 
+/**
+ * @brief Allocate a session's forechannel slot table
+ *
+ * @param[in,out] session  The session
+ * @param[in]     nb_slots Slots to allocate, stored in ca_maxrequests
+ *
+ * @return true if the table was allocated.
+ */
+
+bool nfs41_Session_Alloc_Slots(nfs41_session_t *session, uint32_t nb_slots)
+{
+	uint32_t i;
+
+	session->slots = gsh_calloc(nb_slots, sizeof(nfs41_session_slot_t));
+
+	if (session->slots == NULL)
+		return false;
+
+	for (i = 0; i < nb_slots; i++)
+		PTHREAD_MUTEX_init(&session->slots[i].lock, NULL);
+
+	session->fore_channel_attrs.ca_maxrequests = nb_slots;
+	session->target_highest_slotid = nb_slots - 1;
+
+	return true;
+}
+
+/**
+ * @brief Account for a reply about to be cached in a slot
+ *
+ * Replies are only cached while they all fit in
+ * Session_Reply_Cache_Size.  A reply that is not cached can't be
+ * replayed; a retry gets NFS4ERR_RETRY_UNCACHED_REP.
+ *
+ * @param[in] size Bytes the reply takes
+ *
+ * @return true if the reply may be cached.
+ */
+
+bool nfs41_Session_Slot_Reserve(size_t size)
+{
+	if (atomic_add_uint64_t(&slot_cache_bytes, size) >
+	    nfs_param.nfsv4_param.session_reply_cache_size) {
+		atomic_sub_uint64_t(&slot_cache_bytes, size);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Free the reply cached in a slot
+ *
+ * @param[in,out] slot The slot, locked or no longer shared
+ */
+
+void nfs41_Session_Slot_Release(nfs41_session_slot_t *slot)
+{
+	if (!slot->cache_used)
+		return;
+
+	slot->cached_result.res_cached = false;
+	nfs4_Compound_Free((nfs_res_t *) &slot->cached_result);
+	memset(&slot->cached_result, 0, sizeof(slot->cached_result));
+
+	atomic_sub_uint64_t(&slot_cache_bytes, slot->cache_size);
+	slot->cache_used = false;
+	slot->cache_size = 0;
+}
+
+/**
+ * @brief Choose the highest slot a client should use
+ *
+ * The target backs off by one slot per request while the slot reply
+ * cache is nearly full and comes back one slot per request once it is
+ * under half full, so sessions give up slots, and the replies cached
+ * in them, when replies start to go uncached.  Stepping by one keeps
+ * a busy session from collapsing to a single slot within a handful of
+ * requests every time the cache runs close to full.
+ *
+ * @param[in,out] session The session
+ *
+ * @return The sr_target_highest_slotid to send.
+ */
+
+uint32_t nfs41_Session_Target_Slotid(nfs41_session_t *session)
+{
+	uint64_t used = atomic_fetch_uint64_t(&slot_cache_bytes);
+	uint64_t budget = nfs_param.nfsv4_param.session_reply_cache_size;
+	uint32_t highest = session->fore_channel_attrs.ca_maxrequests - 1;
+	uint32_t target = atomic_fetch_uint32_t(
+					&session->target_highest_slotid);
+
+	if (used > budget - budget / 8 && target > 0)
+		target--;
+	else if (used < budget / 2 && target < highest)
+		target++;
+	else
+		return target;
+
+	atomic_store_uint32_t(&session->target_highest_slotid, target);
+
+	return target;
+}
+
+/**
+ * @brief Free replies cached in slots a client has stopped using
+ *
+ * A client has nothing outstanding above its sa_highest_slotid, so the
+ * replies cached there are only worth keeping while memory is easy.
+ * Sequence numbers are kept, so the slots remain usable.
+ *
+ * @param[in,out] session The session
+ * @param[in]     highest The client's sa_highest_slotid
+ */
+
+void nfs41_Session_Trim_Slots(nfs41_session_t *session, slotid4 highest)
+{
+	uint32_t i;
+
+	if (atomic_fetch_uint64_t(&slot_cache_bytes) <=
+	    nfs_param.nfsv4_param.session_reply_cache_size / 2)
+		return;
+
+	for (i = highest + 1; i < session->fore_channel_attrs.ca_maxrequests;
+	     i++) {
+		PTHREAD_MUTEX_lock(&session->slots[i].lock);
+		nfs41_Session_Slot_Release(&session->slots[i]);
+		PTHREAD_MUTEX_unlock(&session->slots[i].lock);
+	}
+}
+
 /**
  * @brief Set a session into the session hashtable.
  *
@@ -50,6 +50,7 @@
 #include "abstract_atomic.h"
 #include "city.h"
 #include "client_mgr.h"
+#include "nfs_proto_functions.h"
 
 /**
  * @brief Hashtable used to cache NFSv4 clientids
@@ -612,6 +613,8 @@ clientid_status_t nfs_client_id_insert(nfs_client_id_t *clientid)
 	/* Take a reference to the unconfirmed clientid for the hash table. */
 	(void)inc_client_id_ref(clientid);
 
+	start_lease_timer(clientid);
+
 	if (isFullDebug(COMPONENT_CLIENTID) &&
 	    isFullDebug(COMPONENT_HASHTABLE)) {
 		LogFullDebug(COMPONENT_CLIENTID,
@@ -658,6 +661,8 @@ int remove_confirmed_client_id(nfs_client_id_t *clientid)
 	/* Set this up so this client id record will be freed. */
 	clientid->cid_confirmed = EXPIRED_CLIENT_ID;
 
+	stop_lease_timer(clientid);
+
 	/* Release hash table reference to the unconfirmed record */
 	(void)dec_client_id_ref(clientid);
 
@@ -701,6 +706,8 @@ int remove_unconfirmed_client_id(nfs_client_id_t *clientid)
 	/* Set this up so this client id record will be freed. */
 	clientid->cid_confirmed = EXPIRED_CLIENT_ID;
 
+	stop_lease_timer(clientid);
+
 	/* Release hash table reference to the unconfirmed record */
 	(void)dec_client_id_ref(clientid);
 
@@ -776,6 +783,8 @@ clientid_status_t nfs_client_id_confirm(nfs_client_id_t *clientid,
 		   freed. */
 		clientid->cid_confirmed = EXPIRED_CLIENT_ID;
 
+		stop_lease_timer(clientid);
+
 		/* Release hash table reference to the unconfirmed
 		   record */
 		(void)dec_client_id_ref(clientid);
@@ -854,6 +863,8 @@ bool nfs_client_id_expire(nfs_client_id_t *clientid, bool make_stale)
 
 		PTHREAD_MUTEX_unlock(&clientid->cid_mutex);
 
+		stop_lease_timer(clientid);
+
 		/* Detach the clientid record from the client record */
 		if (record->cr_confirmed_rec == clientid)
 			record->cr_confirmed_rec = NULL;
@@ -998,6 +1009,9 @@ bool nfs_client_id_expire(nfs_client_id_t *clientid, bool make_stale)
 	/* revoke delegations for this client*/
 	revoke_owner_delegs(&clientid->cid_owner);
 
+	/* release the client's asynchronous copies */
+	nfs4_copy_forget_client(clientid);
+
 	/* Destroy v4 callback channel */
 	if (clientid->cid_minorversion == 0 &&
 	    clientid->cid_cb.v40.cb_chan.clnt)
@@ -1112,6 +1126,7 @@ clientid_status_t nfs_client_id_get(hash_table_t *ht, clientid4 clientid,
 			status = CLIENT_ID_STALE;
 			dec_client_id_ref(pclientid);
 			pclientid->cid_confirmed = EXPIRED_CLIENT_ID;
+			stop_lease_timer(pclientid);
 			rc = HashTable_Del(ht, &buffkey, NULL, NULL);
 			if (rc != HASHTABLE_SUCCESS) {
 				LogWarn(COMPONENT_CLIENTID,
@@ -1243,6 +1258,8 @@ int nfs_Init_client_id(void)
 		return -1;
 	}
 
+	nfs4_init_lease_timers();
+
 	client_id_pool =
 	    pool_init("NFS4 Client ID Pool", sizeof(nfs_client_id_t),
 		      pool_basic_substrate, NULL, NULL, NULL);
@@ -1681,6 +1698,45 @@ static void client_cb(struct fridgethr_context *ctx)
 	gsh_free(cb_arg);
 }
 
+struct foreach_client_arg {
+	bool (*cb)(nfs_client_id_t *cl, void *state);
+	void *state;
+};
+
+/**
+ * @brief Queue the callback for one client if it is a 4.1 client
+ */
+static bool foreach_client_submit(struct gsh_buffdesc *key,
+				  struct gsh_buffdesc *val,
+				  void *arg)
+{
+	struct foreach_client_arg *foreach = arg;
+	nfs_client_id_t *pclientid = val->addr;
+	struct client_callback_arg *cb_arg;
+	int rc;
+
+	if (pclientid->cid_minorversion == 0)
+		return true;
+
+	cb_arg = gsh_malloc(sizeof(struct client_callback_arg));
+	if (cb_arg == NULL) {
+		LogCrit(COMPONENT_CLIENTID, "malloc failed for %p", pclientid);
+		return true;
+	}
+	cb_arg->cb = foreach->cb;
+	cb_arg->state = foreach->state;
+	cb_arg->pclientid = pclientid;
+	inc_client_id_ref(pclientid);
+	rc = fridgethr_submit(state_async_fridge, client_cb, cb_arg);
+	if (rc != 0) {
+		LogCrit(COMPONENT_CLIENTID,
+			"unable to start client cb thread %d", rc);
+		gsh_free(cb_arg);
+		dec_client_id_ref(pclientid);
+	}
+	return true;
+}
+
 /**
  * @brief Walk the client tree and do the callback on each 4.1 nodes
  *
@@ -1692,57 +1748,10 @@ void
 nfs41_foreach_client_callback(bool(*cb) (nfs_client_id_t *cl, void *state),
 			      void *state)
 {
-	uint32_t i;
-	hash_table_t *ht = ht_confirmed_client_id;
-	struct rbt_head *head_rbt;
-	struct hash_data *pdata = NULL;
-	struct rbt_node *pn;
-	nfs_client_id_t *pclientid;
-	struct client_callback_arg *cb_arg;
-	int rc;
+	struct foreach_client_arg foreach = { .cb = cb, .state = state };
 
-	/* For each bucket of the hashtable */
-	for (i = 0; i < ht->parameter.index_size; i++) {
-		head_rbt = &(ht->partitions[i].rbt);
-
-		/* acquire mutex */
-		PTHREAD_RWLOCK_wrlock(&(ht->partitions[i].lock));
-
-		/* go through all entries in the red-black-tree */
-		RBT_LOOP(head_rbt, pn) {
-			pdata = RBT_OPAQ(pn);
-			pclientid = pdata->val.addr;
-			RBT_INCREMENT(pn);
-
-			if (pclientid->cid_minorversion > 0) {
-				cb_arg = gsh_malloc(
-						sizeof(struct
-							client_callback_arg));
-				if (cb_arg == NULL) {
-					LogCrit(COMPONENT_CLIENTID,
-						"malloc failed for %p",
-						pclientid);
-					continue;
-				}
-				cb_arg->cb = cb;
-				cb_arg->state = state;
-				cb_arg->pclientid = pclientid;
-				inc_client_id_ref(pclientid);
-				rc = fridgethr_submit(state_async_fridge,
-						 client_cb,
-						 cb_arg);
-				if (rc != 0) {
-					LogCrit(COMPONENT_CLIENTID,
-						"unable to start client cb thread %d",
-						rc);
-					gsh_free(cb_arg);
-					dec_client_id_ref(pclientid);
-				}
-			}
-		}
-		PTHREAD_RWLOCK_unlock(&(ht->partitions[i].lock));
-	}
-	return;
+	hashtable_for_each(ht_confirmed_client_id, foreach_client_submit,
+			   &foreach);
 }
 
 /** @} */
@@ -40,6 +40,18 @@
 #include "nfs4.h"
 #include "sal_functions.h"
 
+/**
+ * @brief Lease timers of all clients
+ *
+ * A client's timer is set for when its lease would run out if not
+ * renewed, and holds a reference to the client.  Renewing a lease only
+ * touches cid_last_renew; the reaper re-arms a timer that fires for a
+ * lease renewed meanwhile, so each client costs it about one wakeup per
+ * lease period and expiry work is proportional to the clients actually
+ * expiring.
+ */
+static struct gsh_timer_wheel lease_wheel;
+
 /**
  * @brief Return the lifetime of a valid lease
  *
@@ -157,4 +169,71 @@ void update_lease(nfs_client_id_t *clientid)
 	}
 }
 
+/**
+ * @brief Initialize the lease timers
+ */
+void nfs4_init_lease_timers(void)
+{
+	gsh_timer_wheel_init(&lease_wheel);
+}
+
+/**
+ * @brief Arm a client's lease timer
+ *
+ * Takes a reference to the client for the timer, which is set for when
+ * the lease runs out, or a lease period from now while reservations are
+ * held.  The caller must hold cid_mutex or be the only thread with a
+ * pointer to the client.
+ *
+ * @param[in] clientid Client record
+ */
+void start_lease_timer(nfs_client_id_t *clientid)
+{
+	time_t expire;
+
+	if (clientid->cid_lease_reservations != 0)
+		expire = time(NULL);
+	else
+		expire = clientid->cid_last_renew;
+
+	expire += nfs_param.nfsv4_param.lease_lifetime;
+
+	(void)inc_client_id_ref(clientid);
+	gsh_timer_schedule(&lease_wheel, &clientid->cid_lease_timer, expire);
+}
+
+/**
+ * @brief Disarm the lease timer of an expired client
+ *
+ * Releases the timer's reference, so the caller must hold another one.
+ * If this races with the reaper re-arming the timer, the reaper drops
+ * the reference when it next fires.
+ *
+ * @param[in] clientid Client record
+ */
+void stop_lease_timer(nfs_client_id_t *clientid)
+{
+	if (gsh_timer_cancel(&lease_wheel, &clientid->cid_lease_timer))
+		(void)dec_client_id_ref(clientid);
+}
+
+/**
+ * @brief Get a client whose lease timer has fired
+ *
+ * The timer's reference passes to the caller.
+ *
+ * @param[in] now Current time
+ *
+ * @return The client, or NULL if no timer is due.
+ */
+nfs_client_id_t *get_lease_timer_fired(time_t now)
+{
+	struct gsh_timer *timer = gsh_timer_wheel_pop(&lease_wheel, now, NULL);
+
+	if (timer == NULL)
+		return NULL;
+
+	return container_of(timer, nfs_client_id_t, cid_lease_timer);
+}
+
 /** @} */
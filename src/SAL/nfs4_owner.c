@@ -44,6 +44,16 @@
 
 hash_table_t *ht_nfs4_owner;
 
+/**
+ * @brief Timers for reaping cached open owners
+ *
+ * An open owner whose last reference goes away is kept for a lease
+ * period in case the client opens again.  Its so_close_timer is set
+ * for when that period ends; the wheel holds no reference, so the
+ * owner's timer is cancelled under its hash latch before it is freed.
+ */
+static struct gsh_timer_wheel open_owner_wheel;
+
 /**
  * @brief Display an NFSv4 owner key
  *
@@ -359,9 +369,155 @@ int Init_nfs4_owner(void)
 		return -1;
 	}
 
+	gsh_timer_wheel_init(&open_owner_wheel);
+
 	return 0;
 }				/* nfs4_Init_nfs4_owner */
 
+/**
+ * @brief Schedule reaping a cached open owner
+ *
+ * @param[in] owner  The open owner, with no references left
+ * @param[in] tclose When it was cached
+ */
+void start_open_owner_timer(state_owner_t *owner, time_t tclose)
+{
+	gsh_timer_schedule(&open_owner_wheel,
+			   &owner->so_owner.so_nfs4_owner.so_close_timer,
+			   tclose + nfs_param.nfsv4_param.lease_lifetime);
+}
+
+/**
+ * @brief Cancel reaping an open owner about to be freed
+ *
+ * The caller must hold the owner's hash latch.
+ *
+ * @param[in] owner The open owner
+ */
+void stop_open_owner_timer(state_owner_t *owner)
+{
+	(void)gsh_timer_cancel(&open_owner_wheel,
+			       &owner->so_owner.so_nfs4_owner.so_close_timer);
+}
+
+/* Keep a popped open owner alive, called with the wheel locked */
+static void hold_open_owner(struct gsh_timer *timer)
+{
+	state_owner_t *owner = container_of(timer, state_owner_t,
+					    so_owner.so_nfs4_owner.
+					    so_close_timer);
+
+	atomic_inc_int32_t(&owner->so_refcount);
+}
+
+/**
+ * @brief Free one open owner whose timer fired
+ *
+ * @param[in] owner The open owner, with a reference from the wheel
+ * @param[in] tnow  Current time
+ */
+static void reap_open_owner(state_owner_t *owner, time_t tnow)
+{
+	char str[LOG_BUFF_LEN];
+	struct display_buffer dspbuf = {sizeof(str), str, str};
+	struct hash_latch latch;
+	hash_error_t rc;
+	struct gsh_buffdesc buffkey;
+	struct gsh_buffdesc old_value;
+	struct gsh_buffdesc old_key;
+	time_t tclose, texpire;
+
+	tclose = atomic_fetch_time_t(&owner->so_owner.so_nfs4_owner.
+				     last_close_time);
+
+	if (tclose == 0) {
+		/* Opened again since it was cached */
+		dec_state_owner_ref(owner);
+		return;
+	}
+
+	texpire = tclose + nfs_param.nfsv4_param.lease_lifetime;
+
+	if (texpire > tnow) {
+		/* Cached again since the timer was set */
+		start_open_owner_timer(owner, tclose);
+		atomic_dec_int32_t(&owner->so_refcount);
+		return;
+	}
+
+	buffkey.addr = owner;
+	buffkey.len = sizeof(*owner);
+
+	rc = hashtable_getlatch(ht_nfs4_owner, &buffkey, &old_value, true,
+				&latch);
+
+	if (rc != HASHTABLE_SUCCESS) {
+		if (rc == HASHTABLE_ERROR_NO_SUCH_KEY)
+			hashtable_releaselatched(ht_nfs4_owner, &latch);
+
+		display_owner(&dspbuf, owner);
+		LogCrit(COMPONENT_STATE, "Error %s, could not find {%s}",
+			hash_table_err_to_str(rc), str);
+		atomic_dec_int32_t(&owner->so_refcount);
+		return;
+	}
+
+	/* Only ours left and not opened again while we took the latch */
+	if (atomic_fetch_int32_t(&owner->so_refcount) != 1 ||
+	    atomic_fetch_time_t(&owner->so_owner.so_nfs4_owner.
+				last_close_time) == 0) {
+		hashtable_releaselatched(ht_nfs4_owner, &latch);
+		dec_state_owner_ref(owner);
+		return;
+	}
+
+	rc = hashtable_deletelatched(ht_nfs4_owner, &buffkey, &latch,
+				     &old_key, &old_value);
+
+	if (rc != HASHTABLE_SUCCESS) {
+		if (rc == HASHTABLE_ERROR_NO_SUCH_KEY)
+			hashtable_releaselatched(ht_nfs4_owner, &latch);
+
+		display_owner(&dspbuf, owner);
+		LogCrit(COMPONENT_CLIENTID,
+			"Could not remove expired owner %s error=%s", str,
+			hash_table_err_to_str(rc));
+		atomic_dec_int32_t(&owner->so_refcount);
+		return;
+	}
+
+	if (isFullDebug(COMPONENT_STATE)) {
+		display_owner(&dspbuf, owner);
+		LogFullDebug(COMPONENT_STATE, "Free {%s}", str);
+	}
+
+	atomic_dec_int32_t(&owner->so_refcount);
+	free_state_owner(owner);
+}
+
+/**
+ * @brief Free the cached open owners whose lease period has passed
+ *
+ * @return The number of open owner timers that fired.
+ */
+int reap_expired_open_owners(void)
+{
+	struct gsh_timer *timer;
+	time_t tnow = time(NULL);
+	int count = 0;
+
+	while ((timer = gsh_timer_wheel_pop(&open_owner_wheel, tnow,
+					    hold_open_owner)) != NULL) {
+		reap_open_owner(container_of(timer, state_owner_t,
+					     so_owner.so_nfs4_owner.
+					     so_close_timer),
+				tnow);
+		count++;
+	}
+
+	return count;
+}
+
 /**
  * @brief Initialize an NFS4 open owner object
  *
@@ -1288,53 +1288,45 @@ bool ip_str_match(char *release_ip, char *server_ip)
 }
 
 /**
- * @brief Release all NLM state
+ * @brief Submit an NLM release for a client of the released address
  */
-static void nfs_release_nlm_state(char *release_ip)
+static bool nlm_release_client(struct gsh_buffdesc *key,
+			       struct gsh_buffdesc *val,
+			       void *arg)
 {
-	hash_table_t *ht = ht_nlm_client;
-	state_nlm_client_t *nlm_cp;
+	char *release_ip = arg;
+	state_nlm_client_t *nlm_cp = val->addr;
 	state_nsm_client_t *nsm_cp;
-	struct rbt_head *head_rbt;
-	struct rbt_node *pn;
-	struct hash_data *pdata;
 	state_status_t state_status;
 	char serverip[SOCK_NAME_MAX + 1];
-	int i;
 
+	sprint_sockip(&(nlm_cp->slc_server_addr), serverip,
+		      SOCK_NAME_MAX + 1);
+	if (ip_str_match(release_ip, serverip)) {
+		nsm_cp = nlm_cp->slc_nsm_client;
+		inc_nsm_client_ref(nsm_cp);
+		state_status = fridgethr_submit(state_async_fridge,
+						nlm_releasecall, nsm_cp);
+		if (state_status != STATE_SUCCESS) {
+			dec_nsm_client_ref(nsm_cp);
+			LogCrit(COMPONENT_STATE,
+				"failed to submit nlm release thread ");
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Release all NLM state
+ */
+static void nfs_release_nlm_state(char *release_ip)
+{
 	LogDebug(COMPONENT_STATE, "Release all NLM locks");
 
 	cancel_all_nlm_blocked();
 
 	/* walk the client list and call state_nlm_notify */
-	for (i = 0; i < ht->parameter.index_size; i++) {
-		PTHREAD_RWLOCK_wrlock(&ht->partitions[i].lock);
-		head_rbt = &ht->partitions[i].rbt;
-		/* go through all entries in the red-black-tree */
-		RBT_LOOP(head_rbt, pn) {
-			pdata = RBT_OPAQ(pn);
-			nlm_cp = (state_nlm_client_t *) pdata->val.addr;
-			sprint_sockip(&(nlm_cp->slc_server_addr),
-					serverip,
-					SOCK_NAME_MAX + 1);
-			if (ip_str_match(release_ip, serverip)) {
-				nsm_cp = nlm_cp->slc_nsm_client;
-				inc_nsm_client_ref(nsm_cp);
-				state_status = fridgethr_submit(
-						state_async_fridge,
-						nlm_releasecall,
-						nsm_cp);
-				if (state_status != STATE_SUCCESS) {
-					dec_nsm_client_ref(nsm_cp);
-					LogCrit(COMPONENT_STATE,
-						"failed to submit nlm release thread ");
-				}
-			}
-			RBT_INCREMENT(pn);
-		}
-		PTHREAD_RWLOCK_unlock(&ht->partitions[i].lock);
-	}
-	return;
+	hashtable_for_each(ht_nlm_client, nlm_release_client, release_ip);
 }
 
 static int ip_match(char *ip, nfs_client_id_t *cid)
@@ -1357,6 +1349,40 @@ static int ip_match(char *ip, nfs_client_id_t *cid)
 	return 0;		/* no match */
 }
 
+struct release_v4_arg {
+	char *ip;
+	nfs_client_id_t *cp;
+};
+
+/**
+ * @brief Stop at the first confirmed client matching the address
+ *
+ * The client and its record are referenced so they can be expired
+ * once the table lock has been dropped.
+ */
+static bool v4_release_match(struct gsh_buffdesc *key,
+			     struct gsh_buffdesc *val,
+			     void *arg)
+{
+	struct release_v4_arg *release = arg;
+	nfs_client_id_t *cp = val->addr;
+
+	PTHREAD_MUTEX_lock(&cp->cid_mutex);
+	if ((cp->cid_confirmed == CONFIRMED_CLIENT_ID)
+	     && ip_match(release->ip, cp)) {
+		inc_client_id_ref(cp);
+
+		/* Take a reference to the client record */
+		inc_client_record_ref(cp->cid_client_record);
+
+		PTHREAD_MUTEX_unlock(&cp->cid_mutex);
+		release->cp = cp;
+		return false;
+	}
+	PTHREAD_MUTEX_unlock(&cp->cid_mutex);
+	return true;
+}
+
 /*
  * try to find a V4 client that matches the IP we are releasing.
  * only search the confirmed clients, unconfirmed clients won't
@@ -1364,57 +1390,27 @@ static int ip_match(char *ip, nfs_client_id_t *cid)
  */
 static void nfs_release_v4_client(char *ip)
 {
-	hash_table_t *ht = ht_confirmed_client_id;
-	struct rbt_head *head_rbt;
-	struct rbt_node *pn;
-	struct hash_data *pdata;
-	nfs_client_id_t *cp;
+	struct release_v4_arg release = { .ip = ip, .cp = NULL };
 	nfs_client_record_t *recp;
-	int i;
 
 	LogEvent(COMPONENT_STATE, "NFS Server V4 recovery release ip %s", ip);
 
 	/* go through the confirmed clients looking for a match */
-	for (i = 0; i < ht->parameter.index_size; i++) {
+	hashtable_for_each(ht_confirmed_client_id, v4_release_match, &release);
 
-		PTHREAD_RWLOCK_wrlock(&ht->partitions[i].lock);
-		head_rbt = &ht->partitions[i].rbt;
-
-		/* go through all entries in the red-black-tree */
-		RBT_LOOP(head_rbt, pn) {
-			pdata = RBT_OPAQ(pn);
-
-			cp = (nfs_client_id_t *) pdata->val.addr;
-			PTHREAD_MUTEX_lock(&cp->cid_mutex);
-			if ((cp->cid_confirmed == CONFIRMED_CLIENT_ID)
-			     && ip_match(ip, cp)) {
-				inc_client_id_ref(cp);
-
-				/* Take a reference to the client record */
-				recp = cp->cid_client_record;
-				inc_client_record_ref(recp);
-
-				PTHREAD_MUTEX_unlock(&cp->cid_mutex);
-
-				PTHREAD_RWLOCK_unlock(&ht->partitions[i].lock);
+	if (release.cp == NULL)
+		return;
 
-				PTHREAD_MUTEX_lock(&recp->cr_mutex);
+	recp = release.cp->cid_client_record;
 
-				nfs_client_id_expire(cp, true);
+	PTHREAD_MUTEX_lock(&recp->cr_mutex);
 
-				PTHREAD_MUTEX_unlock(&recp->cr_mutex);
+	nfs_client_id_expire(release.cp, true);
 
-				dec_client_id_ref(cp);
-				dec_client_record_ref(recp);
-				return;
+	PTHREAD_MUTEX_unlock(&recp->cr_mutex);
 
-			} else {
-				PTHREAD_MUTEX_unlock(&cp->cid_mutex);
-			}
-			RBT_INCREMENT(pn);
-		}
-		PTHREAD_RWLOCK_unlock(&ht->partitions[i].lock);
-	}
+	dec_client_id_ref(release.cp);
+	dec_client_record_ref(recp);
 }
 
 /** @} */
@@ -51,6 +51,7 @@
 #include "nlm_util.h"
 #include "cache_inode_lru.h"
 #include "export_mgr.h"
+#include "server_stats.h"
 
 /**
  * @page state_lock_entry_locking state_lock_entry_t locking rule
@@ -663,6 +664,55 @@ static void lock_entry_dec_ref(state_lock_entry_t *lock_entry)
 	}
 }
 
+/**
+ * @brief Add an entry to its file's lock list
+ *
+ * Every entry on the lock list is also in the file's lock tree, and
+ * those not yet granted are on its blocked lock list too.
+ *
+ * @param[in,out] entry      File the lock is on
+ * @param[in,out] lock_entry Entry to add
+ */
+static void add_to_locklist(cache_entry_t *entry,
+			    state_lock_entry_t *lock_entry)
+{
+	glist_add_tail(&entry->object.file.lock_list, &lock_entry->sle_list);
+
+	lock_entry->sle_range.start = lock_entry->sle_lock.lock_start;
+	lock_entry->sle_range.last = lock_end(&lock_entry->sle_lock);
+	gsh_itree_insert(&entry->object.file.lock_tree,
+			 &lock_entry->sle_range);
+
+	if (lock_entry->sle_blocked != STATE_NON_BLOCKING)
+		glist_add_tail(&entry->object.file.blocked_lock_list,
+			       &lock_entry->sle_blocked_list);
+}
+
+/**
+ * @brief Take an entry off whatever list holds it and out of the lock tree
+ *
+ * The entry keeps its references and owner.
+ *
+ * @param[in,out] lock_entry Entry to unlink
+ */
+static void unlink_from_locklist(state_lock_entry_t *lock_entry)
+{
+	glist_del(&lock_entry->sle_list);
+	glist_del(&lock_entry->sle_blocked_list);
+
+	if (gsh_itree_linked(&lock_entry->sle_range))
+		gsh_itree_remove(&lock_entry->sle_entry->object.file.lock_tree,
+				 &lock_entry->sle_range);
+}
+
+/**
+ * @brief Map a lock tree node to its lock entry
+ */
+static inline state_lock_entry_t *range_entry(struct gsh_itree_node *node)
+{
+	return container_of(node, state_lock_entry_t, sle_range);
+}
+
 /**
  * @brief Remove an entry from the lock lists
  *
@@ -716,7 +766,7 @@ static void remove_from_locklist(state_lock_entry_t *lock_entry)
 	}
 
 	lock_entry->sle_owner = NULL;
-	glist_del(&lock_entry->sle_list);
+	unlink_from_locklist(lock_entry);
 	lock_entry_dec_ref(lock_entry);
 }
 
@@ -733,12 +783,13 @@ static state_lock_entry_t *get_overlapping_entry(cache_entry_t *entry,
 						 state_owner_t *owner,
 						 fsal_lock_param_t *lock)
 {
-	struct glist_head *glist;
+	struct gsh_itree_node *node;
 	state_lock_entry_t *found_entry = NULL;
-	uint64_t found_entry_end, range_end = lock_end(lock);
+	uint64_t range_end = lock_end(lock);
 
-	glist_for_each(glist, &entry->object.file.lock_list) {
-		found_entry = glist_entry(glist, state_lock_entry_t, sle_list);
+	gsh_itree_for_each(node, &entry->object.file.lock_tree,
+			   lock->lock_start, range_end) {
+		found_entry = range_entry(node);
 
 		LogEntry("Checking", found_entry);
 
@@ -748,33 +799,67 @@ static state_lock_entry_t *get_overlapping_entry(cache_entry_t *entry,
 		    || found_entry->sle_blocked == STATE_CANCELED)
 			continue;
 
-		found_entry_end = lock_end(&found_entry->sle_lock);
-
-		if ((found_entry_end >= lock->lock_start)
-		    && (found_entry->sle_lock.lock_start <= range_end)) {
-			/* lock overlaps see if we can allow:
-			 * allow if neither lock is exclusive or
-			 * the owner is the same
-			 */
-			if ((found_entry->sle_lock.lock_type == FSAL_LOCK_W
-			     || lock->lock_type == FSAL_LOCK_W)
-			    && different_owners(found_entry->sle_owner, owner)
-			    ) {
-				/* found a conflicting lock, return it */
-				return found_entry;
-			}
+		/* lock overlaps see if we can allow:
+		 * allow if neither lock is exclusive or
+		 * the owner is the same
+		 */
+		if ((found_entry->sle_lock.lock_type == FSAL_LOCK_W
+		     || lock->lock_type == FSAL_LOCK_W)
+		    && different_owners(found_entry->sle_owner, owner)) {
+			/* found a conflicting lock, return it */
+			return found_entry;
 		}
 	}
 
 	return NULL;
 }
 
+/**
+ * @brief Find a lock the owner holds on this file via another export
+ *
+ * All of an owner's locks on a file are taken through one export, so
+ * the first one found on the owner's lock list settles it.
+ *
+ * @param[in] entry The file to check
+ * @param[in] owner The lock owner
+ *
+ * @return A lock held via another export or NULL.
+ */
+static state_lock_entry_t *owner_export_conflict(cache_entry_t *entry,
+						 state_owner_t *owner)
+{
+	struct glist_head *glist;
+	state_lock_entry_t *found_entry, *conflict_entry = NULL;
+
+	PTHREAD_MUTEX_lock(&owner->so_mutex);
+
+	glist_for_each(glist, &owner->so_lock_list) {
+		found_entry = glist_entry(glist, state_lock_entry_t,
+					  sle_owner_locks);
+
+		if (found_entry->sle_entry != entry)
+			continue;
+
+		if (found_entry->sle_export != op_ctx->export)
+			conflict_entry = found_entry;
+
+		break;
+	}
+
+	PTHREAD_MUTEX_unlock(&owner->so_mutex);
+
+	return conflict_entry;
+}
+
 /**
  * @brief Add a lock, potentially merging with existing locks
  *
- * We need to iterate over the full lock list and remove
- * any mapping entry. And l_offset = 0 and sle_lock.lock_length = 0 lock_entry
- * implies remove all entries
+ * Only the owner's granted locks touching or overlapping lock_entry can
+ * merge with it, so just those are taken out of the lock tree, merged,
+ * split or shrunk, and whatever is left of them put back.  Merging may
+ * grow lock_entry into more neighbours, so repeat until it stops
+ * growing.  If lock_entry is already on the lock list it is put back
+ * with its final range.
  *
  * @param[in,out] entry      File to operate on
  * @param[in]     lock_entry Lock to add
@@ -786,121 +871,151 @@ static void merge_lock_entry(cache_entry_t *entry,
 	state_lock_entry_t *check_entry_right;
 	uint64_t check_entry_end;
 	uint64_t lock_entry_end;
+	uint64_t merge_start, merge_end;
+	struct gsh_itree_node *node, *noden;
 	struct glist_head *glist;
 	struct glist_head *glistn;
+	struct glist_head keep_list;
+	bool listed = gsh_itree_linked(&lock_entry->sle_range);
 
 	/* lock_entry might be STATE_NON_BLOCKING or STATE_GRANTING */
 
-	glist_for_each_safe(glist, glistn, &entry->object.file.lock_list) {
-		check_entry = glist_entry(glist, state_lock_entry_t, sle_list);
+	glist_init(&keep_list);
 
-		/* Skip entry being merged - it could be in the list */
-		if (check_entry == lock_entry)
-			continue;
+	/* Take lock_entry out while its range changes */
+	if (listed)
+		unlink_from_locklist(lock_entry);
 
-		if (different_owners
-		    (check_entry->sle_owner, lock_entry->sle_owner))
-			continue;
+	do {
+		merge_start = lock_entry->sle_lock.lock_start;
+		merge_end = lock_end(&lock_entry->sle_lock);
 
-		/* Only merge fully granted locks */
-		if (check_entry->sle_blocked != STATE_NON_BLOCKING)
-			continue;
+		/* Look for locks touching lock_entry as well as overlapping */
+		gsh_itree_for_each_safe(node, noden,
+					&entry->object.file.lock_tree,
+					merge_start > 0 ? merge_start - 1 : 0,
+					merge_end < UINT64_MAX
+					? merge_end + 1 : UINT64_MAX) {
+			check_entry = range_entry(node);
 
-		check_entry_end = lock_end(&check_entry->sle_lock);
-		lock_entry_end = lock_end(&lock_entry->sle_lock);
+			if (different_owners
+			    (check_entry->sle_owner, lock_entry->sle_owner))
+				continue;
 
-		if ((check_entry_end + 1) < lock_entry->sle_lock.lock_start)
-			/* nothing to merge */
-			continue;
+			/* Only merge fully granted locks */
+			if (check_entry->sle_blocked != STATE_NON_BLOCKING)
+				continue;
 
-		if ((lock_entry_end + 1) < check_entry->sle_lock.lock_start)
-			/* nothing to merge */
-			continue;
+			/* Whatever is left of it goes back on keep_list */
+			unlink_from_locklist(check_entry);
 
-		/* Need to handle locks of different types differently, may
-		 * split an old lock. If new lock totally overlaps old lock,
-		 * the new lock will replace the old lock so no special work
-		 * to be done.
-		 */
-		if ((check_entry->sle_lock.lock_type !=
-		     lock_entry->sle_lock.lock_type)
-		    && ((lock_entry_end < check_entry_end)
-			|| (check_entry->sle_lock.lock_start <
-			    lock_entry->sle_lock.lock_start))) {
-			if (lock_entry_end < check_entry_end
-			    && check_entry->sle_lock.lock_start <
-			    lock_entry->sle_lock.lock_start) {
-				/* Need to split old lock */
-				check_entry_right =
-				    state_lock_entry_t_dup(check_entry);
-				if (check_entry_right == NULL) {
-					/** @todo FSF: OOPS....
-					 * Leave old lock in place, it may cause
-					 * false conflicts, but should
-					 * eventually be released
+			check_entry_end = lock_end(&check_entry->sle_lock);
+			lock_entry_end = lock_end(&lock_entry->sle_lock);
+
+			/* Need to handle locks of different types differently,
+			 * may split an old lock. If new lock totally overlaps
+			 * old lock, the new lock will replace the old lock so
+			 * no special work to be done.
+			 */
+			if ((check_entry->sle_lock.lock_type !=
+			     lock_entry->sle_lock.lock_type)
+			    && ((lock_entry_end < check_entry_end)
+				|| (check_entry->sle_lock.lock_start <
+				    lock_entry->sle_lock.lock_start))) {
+				glist_add_tail(&keep_list,
+					       &check_entry->sle_list);
+
+				if (lock_entry_end < check_entry_end
+				    && check_entry->sle_lock.lock_start <
+				    lock_entry->sle_lock.lock_start) {
+					/* Need to split old lock */
+					check_entry_right =
+					    state_lock_entry_t_dup(check_entry);
+					if (check_entry_right == NULL) {
+						/** @todo FSF: OOPS....
+						 * Leave old lock in place, it
+						 * may cause false conflicts,
+						 * but should eventually be
+						 * released
+						 */
+						LogMajor(COMPONENT_STATE,
+							 "Memory allocation failure during lock upgrade/downgrade");
+						continue;
+					}
+					glist_add_tail(&keep_list,
+						       &check_entry_right->
+						       sle_list);
+				} else {
+					/* No split, just shrink, make the logic
+					 * below work on original lock
 					 */
-					LogMajor(COMPONENT_STATE,
-						 "Memory allocation failure during lock upgrade/downgrade");
-					continue;
+					check_entry_right = check_entry;
 				}
-				glist_add_tail(&entry->object.file.lock_list,
-					       &(check_entry_right->sle_list));
-			} else {
-				/* No split, just shrink, make the logic below
-				 * work on original lock
-				 */
-				check_entry_right = check_entry;
-			}
-			if (lock_entry_end < check_entry_end) {
-				/* Need to shrink old lock from beginning
-				 * (right lock if split)
-				 */
-				LogEntry("Merge shrinking right",
-					 check_entry_right);
-				check_entry_right->sle_lock.lock_start =
-				    lock_entry_end + 1;
-				check_entry_right->sle_lock.lock_length =
-				    check_entry_end - lock_entry_end;
-				LogEntry("Merge shrunk right",
-					 check_entry_right);
+				if (lock_entry_end < check_entry_end) {
+					/* Need to shrink old lock from
+					 * beginning (right lock if split)
+					 */
+					LogEntry("Merge shrinking right",
+						 check_entry_right);
+					check_entry_right->sle_lock.lock_start =
+					    lock_entry_end + 1;
+					check_entry_right->sle_lock
+					    .lock_length =
+					    check_entry_end - lock_entry_end;
+					LogEntry("Merge shrunk right",
+						 check_entry_right);
+				}
+				if (check_entry->sle_lock.lock_start <
+				    lock_entry->sle_lock.lock_start) {
+					/* Need to shrink old lock from end
+					 * (left lock if split)
+					 */
+					LogEntry("Merge shrinking left",
+						 check_entry);
+					check_entry->sle_lock.lock_length =
+					    lock_entry->sle_lock.lock_start -
+					    check_entry->sle_lock.lock_start;
+					LogEntry("Merge shrunk left",
+						 check_entry);
+				}
+				/* Done splitting/shrinking old lock */
+				continue;
 			}
+
+			/* check_entry touches or overlaps lock_entry, expand
+			 * lock_entry
+			 */
+			if (lock_entry_end < check_entry_end)
+				/* Expand end of lock_entry */
+				lock_entry_end = check_entry_end;
+
 			if (check_entry->sle_lock.lock_start <
-			    lock_entry->sle_lock.lock_start) {
-				/* Need to shrink old lock from end
-				 * (left lock if split)
-				 */
-				LogEntry("Merge shrinking left", check_entry);
-				check_entry->sle_lock.lock_length =
-				    lock_entry->sle_lock.lock_start -
+			    lock_entry->sle_lock.lock_start)
+				/* Expand start of lock_entry */
+				lock_entry->sle_lock.lock_start =
 				    check_entry->sle_lock.lock_start;
-				LogEntry("Merge shrunk left", check_entry);
-			}
-			/* Done splitting/shrinking old lock */
-			continue;
-		}
 
-		/* check_entry touches or overlaps lock_entry, expand
-		 * lock_entry
-		 */
-		if (lock_entry_end < check_entry_end)
-			/* Expand end of lock_entry */
-			lock_entry_end = check_entry_end;
-
-		if (check_entry->sle_lock.lock_start <
-		    lock_entry->sle_lock.lock_start)
-			/* Expand start of lock_entry */
-			lock_entry->sle_lock.lock_start =
-			    check_entry->sle_lock.lock_start;
+			/* Compute new lock length */
+			lock_entry->sle_lock.lock_length = lock_entry_end -
+			    lock_entry->sle_lock.lock_start + 1;
 
-		/* Compute new lock length */
-		lock_entry->sle_lock.lock_length =
-		    lock_entry_end - lock_entry->sle_lock.lock_start + 1;
+			/* Remove merged entry */
+			LogEntry("Merged", lock_entry);
+			LogEntry("Merging removing", check_entry);
+			remove_from_locklist(check_entry);
+		}
+	} while (lock_entry->sle_lock.lock_start < merge_start
+		 || lock_end(&lock_entry->sle_lock) > merge_end);
 
-		/* Remove merged entry */
-		LogEntry("Merged", lock_entry);
-		LogEntry("Merging removing", check_entry);
-		remove_from_locklist(check_entry);
+	/* Put back what is left of the old locks, and lock_entry */
+	glist_for_each_safe(glist, glistn, &keep_list) {
+		check_entry = glist_entry(glist, state_lock_entry_t, sle_list);
+		glist_del(&check_entry->sle_list);
+		add_to_locklist(entry, check_entry);
 	}
+
+	if (listed)
+		add_to_locklist(entry, lock_entry);
 }
 
 /**
@@ -1005,17 +1120,48 @@ static state_status_t subtract_lock_from_entry(cache_entry_t *entry,
 	/* Remove the lock from the list it's
 	 * on and put it on the remove_list
 	 */
-	glist_del(&found_entry->sle_list);
+	unlink_from_locklist(found_entry);
 	glist_add_tail(remove_list, &(found_entry->sle_list));
 
 	*removed = true;
 	return status;
 }
 
+/**
+ * @brief Check whether a lock is left alone by subtract_lock_from_list
+ *
+ * @param[in] found_entry Lock to check
+ * @param[in] owner       Lock owner being unlocked, or NULL for any
+ * @param[in] state       Associated lock state
+ *
+ * @return true if the lock is to be skipped.
+ */
+static bool subtract_skip_entry(state_lock_entry_t *found_entry,
+				state_owner_t *owner,
+				state_t *state)
+{
+	if (owner != NULL
+	    && different_owners(found_entry->sle_owner, owner))
+		return true;
+
+	/* Only care about granted locks */
+	if (found_entry->sle_blocked != STATE_NON_BLOCKING)
+		return true;
+
+	/* Skip locks owned by this NLM state.
+	 * This protects NLM locks from the current iteration of an NLM
+	 * client from being released by SM_NOTIFY.
+	 */
+	return state != NULL && lock_owner_is_nlm(found_entry)
+	    && found_entry->sle_state == state;
+}
+
 /**
  * @brief Subtract a lock from a list of locks
  *
- * This function possibly splits entries in the list.
+ * This function possibly splits entries in the list.  When the list is
+ * the file's lock list only the locks overlapping the range are
+ * visited, through the lock tree.
  *
  * @param[in,out] entry   Cache entry on which to operate
  * @param[in]     owner   Lock owner
@@ -1036,48 +1182,60 @@ static state_status_t subtract_lock_from_list(cache_entry_t *entry,
 	state_lock_entry_t *found_entry;
 	struct glist_head split_lock_list, remove_list;
 	struct glist_head *glist, *glistn;
+	struct gsh_itree_node *node, *noden;
 	state_status_t status = STATE_SUCCESS;
 	bool removed_one = false;
+	bool indexed = list == &entry->object.file.lock_list;
 
 	*removed = false;
 
 	glist_init(&split_lock_list);
 	glist_init(&remove_list);
 
-	glist_for_each_safe(glist, glistn, list) {
-		found_entry = glist_entry(glist, state_lock_entry_t, sle_list);
+	/* We have matched owner. Even though we are taking a reference
+	 * to found_entry, we don't inc the ref count because we want
+	 * to drop the lock entry.
+	 */
+	if (indexed) {
+		gsh_itree_for_each_safe(node, noden,
+					&entry->object.file.lock_tree,
+					lock->lock_start, lock_end(lock)) {
+			found_entry = range_entry(node);
 
-		if (owner != NULL
-		    && different_owners(found_entry->sle_owner, owner))
-			continue;
+			if (subtract_skip_entry(found_entry, owner, state))
+				continue;
 
-		/* Only care about granted locks */
-		if (found_entry->sle_blocked != STATE_NON_BLOCKING)
-			continue;
+			status =
+			    subtract_lock_from_entry(entry, found_entry, lock,
+						     &split_lock_list,
+						     &remove_list,
+						     &removed_one);
+			*removed |= removed_one;
 
-		/* Skip locks owned by this NLM state.
-		 * This protects NLM locks from the current iteration of an NLM
-		 * client from being released by SM_NOTIFY.
-		 */
-		if (state != NULL && lock_owner_is_nlm(found_entry)
-		    && found_entry->sle_state == state)
-			continue;
+			if (status != STATE_SUCCESS)
+				break;
+		}
+	} else {
+		glist_for_each_safe(glist, glistn, list) {
+			found_entry =
+			    glist_entry(glist, state_lock_entry_t, sle_list);
 
-		/* We have matched owner. Even though we are taking a reference
-		 * to found_entry, we don't inc the ref count because we want
-		 * to drop the lock entry.
-		 */
-		status =
-		    subtract_lock_from_entry(entry, found_entry, lock,
-					     &split_lock_list, &remove_list,
-					     &removed_one);
-		*removed |= removed_one;
-
-		if (status != STATE_SUCCESS) {
-			/* We ran out of memory while splitting,
-			 * deal with it outside loop
-			 */
-			break;
+			if (subtract_skip_entry(found_entry, owner, state))
+				continue;
+
+			status =
+			    subtract_lock_from_entry(entry, found_entry, lock,
+						     &split_lock_list,
+						     &remove_list,
+						     &removed_one);
+			*removed |= removed_one;
+
+			if (status != STATE_SUCCESS) {
+				/* We ran out of memory while splitting,
+				 * deal with it outside loop
+				 */
+				break;
+			}
 		}
 	}
 
@@ -1091,14 +1249,27 @@ static state_status_t subtract_lock_from_list(cache_entry_t *entry,
 			found_entry =
 			    glist_entry(glist, state_lock_entry_t, sle_list);
 			glist_del(&found_entry->sle_list);
-			glist_add_tail(list, &(found_entry->sle_list));
+			if (indexed)
+				add_to_locklist(entry, found_entry);
+			else
+				glist_add_tail(list, &(found_entry->sle_list));
 		}
 	} else {
 		/* free the enttries on the remove_list */
 		free_list(&remove_list);
 
 		/* now add the split lock list */
-		glist_add_list_tail(list, &split_lock_list);
+		if (indexed) {
+			glist_for_each_safe(glist, glistn, &split_lock_list) {
+				found_entry = glist_entry(glist,
+							  state_lock_entry_t,
+							  sle_list);
+				glist_del(&found_entry->sle_list);
+				add_to_locklist(entry, found_entry);
+			}
+		} else {
+			glist_add_list_tail(list, &split_lock_list);
+		}
 	}
 
 	LogFullDebug(COMPONENT_STATE,
@@ -1657,6 +1828,7 @@ void grant_blocked_lock_immediate(cache_entry_t *entry,
 
 	/* Mark lock as granted */
 	lock_entry->sle_blocked = STATE_NON_BLOCKING;
+	glist_del(&lock_entry->sle_blocked_list);
 
 	/* Merge any touching or overlapping locks into this one. */
 	LogEntry("Granted immediate, merging locks for", lock_entry);
@@ -1696,6 +1868,7 @@ void state_complete_grant(state_cookie_entry_t *cookie_entry)
 	if (lock_entry->sle_blocked == STATE_GRANTING) {
 		/* Mark lock as granted */
 		lock_entry->sle_blocked = STATE_NON_BLOCKING;
+		glist_del(&lock_entry->sle_blocked_list);
 
 		/* Merge any touching or overlapping locks into this one. */
 		LogEntry("Granted, merging locks for", lock_entry);
@@ -1846,8 +2019,10 @@ static void grant_blocked_locks(cache_entry_t *entry)
 	if (export->exp_ops.fs_supports(export, fso_lock_support_async_block))
 		return;
 
-	glist_for_each_safe(glist, glistn, &entry->object.file.lock_list) {
-		found_entry = glist_entry(glist, state_lock_entry_t, sle_list);
+	glist_for_each_safe(glist, glistn,
+			    &entry->object.file.blocked_lock_list) {
+		found_entry = glist_entry(glist, state_lock_entry_t,
+					  sle_blocked_list);
 
 		if (found_entry->sle_blocked != STATE_NLM_BLOCKING
 		    && found_entry->sle_blocked != STATE_NFSV4_BLOCKING)
@@ -1977,8 +2152,10 @@ void cancel_blocked_locks_range(cache_entry_t *entry,
 	state_lock_entry_t *found_entry = NULL;
 	uint64_t found_entry_end, range_end = lock_end(lock);
 
-	glist_for_each_safe(glist, glistn, &entry->object.file.lock_list) {
-		found_entry = glist_entry(glist, state_lock_entry_t, sle_list);
+	glist_for_each_safe(glist, glistn,
+			    &entry->object.file.blocked_lock_list) {
+		found_entry = glist_entry(glist, state_lock_entry_t,
+					  sle_blocked_list);
 
 		/* Skip locks not owned by owner */
 		if (owner != NULL
@@ -2151,6 +2328,7 @@ state_status_t do_unlock_no_owner(cache_entry_t *entry,
 	fsal_status_t fsal_status;
 	state_status_t status = STATE_SUCCESS, t_status;
 	fsal_lock_param_t *punlock;
+	nsecs_elapsed_t fsal_start;
 
 	unlock_entry = create_state_lock_entry(entry,
 					       op_ctx->export,
@@ -2189,10 +2367,12 @@ state_status_t do_unlock_no_owner(cache_entry_t *entry,
 
 		LogEntry("FSAL Unlock", found_entry);
 
+		fsal_start = server_stats_clock();
 		fsal_status =
 		    entry->obj_handle->obj_ops.lock_op(entry->obj_handle,
 						    NULL, FSAL_OP_UNLOCK,
 						    punlock, NULL);
+		server_stats_fsal_done(FSAL_LAT_LOCK_OP, fsal_start);
 
 		if (fsal_status.major == ERR_FSAL_STALE)
 			cache_inode_kill_entry(entry);
@@ -2247,6 +2427,7 @@ state_status_t do_lock_op(cache_entry_t *entry,
 	state_status_t status = STATE_SUCCESS;
 	fsal_lock_param_t conflicting_lock;
 	struct fsal_export *fsal_export = op_ctx->fsal_export;
+	nsecs_elapsed_t fsal_start;
 
 	lock->lock_sle_type = sle_type;
 
@@ -2293,6 +2474,7 @@ state_status_t do_lock_op(cache_entry_t *entry,
 			if (status == STATE_LOCK_CONFLICT)
 				sleep(1); /* Don't bombard the filesystem. */
 
+			fsal_start = server_stats_clock();
 			fsal_status = entry->obj_handle->obj_ops.lock_op(
 					entry->obj_handle,
 					fsal_export->exp_ops.fs_supports(
@@ -2301,6 +2483,7 @@ state_status_t do_lock_op(cache_entry_t *entry,
 					? owner : NULL, lock_op,
 					lock,
 					&conflicting_lock);
+			server_stats_fsal_done(FSAL_LAT_LOCK_OP, fsal_start);
 
 			status = state_error_convert(fsal_status);
 
@@ -2476,7 +2659,7 @@ state_status_t state_lock(cache_entry_t *entry,
 			  fsal_lock_param_t *conflict)
 {
 	bool allow = true, overlap = false;
-	struct glist_head *glist;
+	struct gsh_itree_node *node;
 	state_lock_entry_t *found_entry;
 	uint64_t found_entry_end;
 	uint64_t range_end = lock_end(lock);
@@ -2536,37 +2719,39 @@ state_status_t state_lock(cache_entry_t *entry,
 
 	PTHREAD_RWLOCK_wrlock(&entry->state_lock);
 
+	/* Need to reject lock request if this lock owner already has
+	 * a lock on this file via a different export.
+	 */
+	found_entry = owner_export_conflict(entry, owner);
+
+	if (found_entry != NULL) {
+		LogEvent(COMPONENT_STATE,
+			 "Lock Owner Export Conflict, Lock held for export %d (%s), request for export %d (%s)",
+			 found_entry->sle_export->export_id,
+			 found_entry->sle_export->fullpath,
+			 op_ctx->export->export_id,
+			 op_ctx->export->fullpath);
+
+		LogEntry("Found lock entry belonging to another export",
+			 found_entry);
+
+		status = STATE_INVALID_ARGUMENT;
+		goto out_unlock;
+	}
+
 	if (blocking != STATE_NON_BLOCKING) {
 		/* First search for a blocked request. Client can ignore the
 		 * blocked request and keep sending us new lock request again
 		 * and again. So if we have a mapping blocked request return
 		 * that
 		 */
-		glist_for_each(glist, &entry->object.file.lock_list) {
-			found_entry =
-			    glist_entry(glist, state_lock_entry_t, sle_list);
+		gsh_itree_for_each(node, &entry->object.file.lock_tree,
+				   lock->lock_start, range_end) {
+			found_entry = range_entry(node);
 
 			if (different_owners(found_entry->sle_owner, owner))
 				continue;
 
-			/* Need to reject lock request if this lock owner
-			 * already has a lock on this file via a different
-			 * export.
-			 */
-			if (found_entry->sle_export != op_ctx->export) {
-				LogEvent(COMPONENT_STATE,
-					 "Lock Owner Export Conflict, Lock held for export %d (%s), request for export %d (%s)",
-					 found_entry->sle_export->export_id,
-					 found_entry->sle_export->fullpath,
-					 op_ctx->export->export_id,
-					 op_ctx->export->fullpath);
-				LogEntry(
-					"Found lock entry belonging to another export",
-					found_entry);
-				status = STATE_INVALID_ARGUMENT;
-				goto out_unlock;
-			}
-
 			if (found_entry->sle_blocked != blocking)
 				continue;
 
@@ -2583,33 +2768,15 @@ state_status_t state_lock(cache_entry_t *entry,
 		}
 	}
 
-	glist_for_each(glist, &entry->object.file.lock_list) {
-		found_entry = glist_entry(glist, state_lock_entry_t, sle_list);
-		/* Need to reject lock request if this lock owner already has
-		 * a lock on this file via a different export.
-		 */
-		if (found_entry->sle_export != op_ctx->export
-		    && !different_owners(found_entry->sle_owner, owner)) {
-			LogEvent(COMPONENT_STATE,
-				 "Lock Owner Export Conflict, Lock held for export %d (%s), request for export %d (%s)",
-				 found_entry->sle_export->export_id,
-				 found_entry->sle_export->fullpath,
-				 op_ctx->export->export_id,
-				 op_ctx->export->fullpath);
-
-			LogEntry("Found lock entry belonging to another export",
-				 found_entry);
-
-			status = STATE_INVALID_ARGUMENT;
-			goto out_unlock;
-		}
-
-		/* Don't skip blocked locks for fairness */
+	/* Only locks overlapping the new one can conflict with it or cover
+	 * it. Don't skip blocked locks for fairness.
+	 */
+	gsh_itree_for_each(node, &entry->object.file.lock_tree,
+			   lock->lock_start, range_end) {
+		found_entry = range_entry(node);
 		found_entry_end = lock_end(&found_entry->sle_lock);
 
-		if (!(lock->lock_reclaim)
-		    && (found_entry_end >= lock->lock_start)
-		    && (found_entry->sle_lock.lock_start <= range_end)) {
+		if (!(lock->lock_reclaim)) {
 			/* lock overlaps see if we can allow:
 			 * allow if neither lock is exclusive or
 			 * the owner is the same
@@ -2789,8 +2956,7 @@ state_status_t state_lock(cache_entry_t *entry,
 			unpin = false;
 		}
 
-		glist_add_tail(&entry->object.file.lock_list,
-			       &found_entry->sle_list);
+		add_to_locklist(entry, found_entry);
 
 		/* A lock downgrade could unblock blocked locks */
 		grant_blocked_locks(entry);
@@ -2814,8 +2980,7 @@ state_status_t state_lock(cache_entry_t *entry,
 			unpin = false;
 		}
 
-		glist_add_tail(&entry->object.file.lock_list,
-			       &found_entry->sle_list);
+		add_to_locklist(entry, found_entry);
 
 		PTHREAD_RWLOCK_unlock(&entry->state_lock);
 		release_state_lock = false;
@@ -3020,8 +3185,9 @@ state_status_t state_cancel(cache_entry_t *entry,
 		goto out_unlock;
 	}
 
-	glist_for_each(glist, &entry->object.file.lock_list) {
-		found_entry = glist_entry(glist, state_lock_entry_t, sle_list);
+	glist_for_each(glist, &entry->object.file.blocked_lock_list) {
+		found_entry = glist_entry(glist, state_lock_entry_t,
+					  sle_blocked_list);
 
 		if (different_owners(found_entry->sle_owner, owner))
 			continue;
@@ -1000,8 +1000,11 @@ void dec_state_owner_ref(state_owner_t *owner)
 	if ((owner->so_type == STATE_OPEN_OWNER_NFSV4) &&
 	    (atomic_fetch_time_t(&owner->so_owner.so_nfs4_owner.
 				 last_close_time) == 0)) {
+		time_t tclose = time(NULL);
+
 		atomic_store_time_t(&owner->so_owner.so_nfs4_owner.
-				    last_close_time, time(NULL));
+				    last_close_time, tclose);
+		start_open_owner_timer(owner, tclose);
 		LogFullDebug(COMPONENT_STATE,
 			     "Cached open owner {%s}",
 			     str);
@@ -1040,6 +1043,12 @@ void dec_state_owner_ref(state_owner_t *owner)
 		return;
 	}
 
+	/* Once cancelled under the latch the reaper can no longer take a
+	 * reference, so the check below is final.
+	 */
+	if (owner->so_type == STATE_OPEN_OWNER_NFSV4)
+		stop_open_owner_timer(owner);
+
 	refcount = atomic_fetch_int32_t(&owner->so_refcount);
 
 	if (refcount > 0) {
@@ -60,6 +60,11 @@ cache_inode_avl_init(cache_entry_t *entry)
 		     0 /* flags */);
 	avltree_init(&entry->object.dir.avl.c, avl_dirent_hk_cmpf,
 		     0 /* flags */);
+	avltree_init(&entry->object.dir.avl.ck, avl_dirent_ck_cmpf,
+		     0 /* flags */);
+	glist_init(&entry->object.dir.chunks);
+	entry->object.dir.first_chunk = NULL;
+	entry->object.dir.chunk_gen = 0;
 }
 
 static inline struct avltree_node *
@@ -102,6 +107,9 @@ avl_dirent_set_deleted(cache_entry_t *entry, cache_inode_dir_entry_t *v)
 	v->flags |= DIR_ENTRY_FLAG_DELETED;
 	cache_inode_key_delete(&v->ckey);
 
+	/* only the chunk holding the name is affected */
+	cache_inode_dirent_unchunk(entry, v);
+
 	/* save cookie in deleted avl */
 	avltree_insert(&v->node_hk, &entry->object.dir.avl.c);
 }
@@ -317,6 +325,28 @@ cache_inode_avl_lookup_k(cache_entry_t *entry, uint64_t k, uint32_t flags)
 	return dirent;
 }
 
+/**
+ * @brief Find a chunked dirent by FSAL cookie
+ *
+ * @param[in] entry Directory
+ * @param[in] ck    FSAL cookie
+ *
+ * @return The dirent or NULL if no chunk holds the cookie.
+ */
+cache_inode_dir_entry_t *
+cache_inode_avl_lookup_ck(cache_entry_t *entry, uint64_t ck)
+{
+	cache_inode_dir_entry_t dirent_key[1];
+	struct avltree_node *node;
+
+	dirent_key->ck = ck;
+	node = avltree_lookup(&dirent_key->node_ck, &entry->object.dir.avl.ck);
+	if (node == NULL)
+		return NULL;
+
+	return avltree_container_of(node, cache_inode_dir_entry_t, node_ck);
+}
+
 cache_inode_dir_entry_t *
 cache_inode_avl_qp_lookup_s(cache_entry_t *entry, const char *name, int maxj)
 {
@@ -49,6 +49,82 @@
 #include <time.h>
 #include <pthread.h>
 #include <assert.h>
+#include <stdlib.h>
+#include <errno.h>
+
+/* Group commit
+ *
+ * All commits from cache_inode go through one group, see
+ * gsh_group_commit.h.  A committing thread holds the content lock of
+ * its file for read, so the file stays open until it is flushed.
+ */
+
+struct cache_inode_commit {
+	struct group_commit_req req;
+	fsal_status_t status;	/*< Result, set by the head */
+};
+
+/**
+ * @brief Flush a range of a file through the FSAL for its commits
+ *
+ * @param[in] reqs  The commits, the head's range covering them all
+ * @param[in] count Number of commits
+ */
+
+static void cache_inode_commit_flush(struct group_commit_req **reqs,
+				     uint32_t count)
+{
+	cache_entry_t *entry = reqs[0]->file;
+	struct fsal_obj_handle *obj_hdl = entry->obj_handle;
+	fsal_status_t fsal_status;
+	nsecs_elapsed_t fsal_start;
+	uint32_t i;
+
+	fsal_start = server_stats_clock();
+	fsal_status = obj_hdl->obj_ops.commit(obj_hdl, reqs[0]->offset,
+					      reqs[0]->end == UINT64_MAX ?
+					      0 :
+					      reqs[0]->end - reqs[0]->offset);
+	server_stats_fsal_done(FSAL_LAT_COMMIT, fsal_start);
+
+	for (i = 0; i < count; i++)
+		container_of(reqs[i], struct cache_inode_commit,
+			     req)->status = fsal_status;
+}
+
+struct group_commit cache_inode_commits =
+	GROUP_COMMIT_INITIALIZER(cache_inode_commit_flush,
+				 server_stats_commit_batch);
+
+/**
+ * @brief Commit a range of a file along with concurrent commits
+ *
+ * Used for COMMIT and for stable writes the FSAL did not make stable
+ * itself.  The caller must hold the content lock for read with the
+ * file open for write, and keep it until this returns.
+ *
+ * @param[in] entry  File whose data should be committed
+ * @param[in] offset Start of region to commit
+ * @param[in] count  Number of bytes to commit, 0 for end of file
+ *
+ * @return Status from the FSAL.
+ */
+
+fsal_status_t cache_inode_group_commit(cache_entry_t *entry, uint64_t offset,
+				       uint64_t count)
+{
+	struct cache_inode_commit me = {
+		.req.file = entry,
+		.req.offset = offset,
+		.req.end = count == 0 ? UINT64_MAX : offset + count,
+	};
+	nsecs_elapsed_t start_time = server_stats_clock();
+
+	group_commit(&cache_inode_commits, &me.req);
+
+	server_stats_commit_done(start_time);
+	return me.status;
+}
 
 /**
  * @brief Commits a write operation to stable storage
@@ -96,8 +172,7 @@ cache_inode_commit(cache_entry_t *entry, uint64_t offset, size_t count)
 		PTHREAD_RWLOCK_rdlock(&entry->content_lock);
 	}
 
-	fsal_status = entry->obj_handle->obj_ops.commit(entry->obj_handle,
-						     offset, count);
+	fsal_status = cache_inode_group_commit(entry, offset, count);
 
 	if (FSAL_IS_ERROR(fsal_status)) {
 		status = cache_inode_error_convert(fsal_status);
@@ -79,6 +79,7 @@ cache_inode_create(cache_entry_t *parent,
 	struct fsal_obj_handle *dir_handle;
 	cache_inode_create_arg_t zero_create_arg;
 	bool needdec = false;
+	nsecs_elapsed_t fsal_start;
 
 	memset(&zero_create_arg, 0, sizeof(zero_create_arg));
 	memset(&object_attributes, 0, sizeof(object_attributes));
@@ -115,17 +116,20 @@ cache_inode_create(cache_entry_t *parent,
 	atomic_inc_uint32_t(&parent->icreate_refcnt);
 	needdec = true;
 
+	fsal_start = server_stats_clock();
 	switch (type) {
 	case REGULAR_FILE:
 		fsal_status =
 		    dir_handle->obj_ops.create(dir_handle, name,
 					    &object_attributes, &object_handle);
+		server_stats_fsal_done(FSAL_LAT_CREATE, fsal_start);
 		break;
 
 	case DIRECTORY:
 		fsal_status =
 		    dir_handle->obj_ops.mkdir(dir_handle, name,
 					   &object_attributes, &object_handle);
+		server_stats_fsal_done(FSAL_LAT_MKDIR, fsal_start);
 		break;
 
 	case SYMBOLIC_LINK:
@@ -134,6 +138,7 @@ cache_inode_create(cache_entry_t *parent,
 					     create_arg->link_content,
 					     &object_attributes,
 					     &object_handle);
+		server_stats_fsal_done(FSAL_LAT_SYMLINK, fsal_start);
 		break;
 
 	case SOCKET_FILE:
@@ -143,6 +148,7 @@ cache_inode_create(cache_entry_t *parent,
 						      NULL, /* dev_t !needed */
 						      &object_attributes,
 						      &object_handle);
+		server_stats_fsal_done(FSAL_LAT_MKNODE, fsal_start);
 		break;
 
 	case BLOCK_FILE:
@@ -151,6 +157,7 @@ cache_inode_create(cache_entry_t *parent,
 		    dir_handle->obj_ops.mknode(dir_handle, name, type,
 					    &create_arg->dev_spec,
 					    &object_attributes, &object_handle);
+		server_stats_fsal_done(FSAL_LAT_MKNODE, fsal_start);
 		break;
 
 	case NO_FILE_TYPE:
@@ -215,6 +222,7 @@ cache_inode_create(cache_entry_t *parent,
 	}
 
 	PTHREAD_RWLOCK_wrlock(&parent->content_lock);
+	cache_inode_expire_dir_chunks(parent);
 	/* Add this entry to the directory (also takes an internal ref) */
 	status = cache_inode_add_cached_dirent(parent, name, *entry, NULL);
 	PTHREAD_RWLOCK_unlock(&parent->content_lock);
@@ -39,6 +39,7 @@
 #include "hashtable.h"
 #include "cache_inode.h"
 #include "cache_inode_hash.h"
+#include "gsh_slab.h"
 
 /**
  *
@@ -56,7 +57,7 @@ cache_inode_init(void)
 	cache_inode_status_t status = CACHE_INODE_SUCCESS;
 
 	cache_inode_entry_pool =
-	    pool_init("Entry Pool", sizeof(cache_entry_t), pool_basic_substrate,
+	    pool_init("Entry Pool", sizeof(cache_entry_t), pool_slab_substrate,
 		      NULL, NULL, NULL);
 	if (!(cache_inode_entry_pool)) {
 		LogCrit(COMPONENT_CACHE_INODE, "Can't init Entry Pool");
@@ -65,6 +66,9 @@ cache_inode_init(void)
 
 	cih_pkginit();
 
+	cache_inode_commits.batch_max = cache_param.commit_batch_max;
+	cache_inode_commits.window = cache_param.commit_window;
+
 	return status;
 }				/* cache_inode_init */
 
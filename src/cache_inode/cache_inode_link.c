@@ -73,6 +73,7 @@ cache_inode_link(cache_entry_t *entry,
 	cache_inode_status_t status = CACHE_INODE_SUCCESS;
 	cache_inode_status_t status_ref_entry = CACHE_INODE_SUCCESS;
 	cache_inode_status_t status_ref_dest_dir = CACHE_INODE_SUCCESS;
+	nsecs_elapsed_t fsal_start;
 
 	/* The file to be hardlinked can't be a DIRECTORY */
 	if (entry->type == DIRECTORY) {
@@ -88,9 +89,11 @@ cache_inode_link(cache_entry_t *entry,
 
 	/* Rather than performing a lookup first, just try to make the
 	   link and return the FSAL's error if it fails. */
+	fsal_start = server_stats_clock();
 	fsal_status =
 	    entry->obj_handle->obj_ops.link(entry->obj_handle,
 					 dest_dir->obj_handle, name);
+	server_stats_fsal_done(FSAL_LAT_LINK, fsal_start);
 	status_ref_entry = cache_inode_refresh_attrs_locked(entry);
 	status_ref_dest_dir =
 	    cache_inode_refresh_attrs_locked(dest_dir);
@@ -111,6 +114,7 @@ cache_inode_link(cache_entry_t *entry,
 	/* Add the new entry in the destination directory */
 	PTHREAD_RWLOCK_wrlock(&dest_dir->content_lock);
 
+	cache_inode_expire_dir_chunks(dest_dir);
 	status = cache_inode_add_cached_dirent(dest_dir, name, entry, NULL);
 
 	PTHREAD_RWLOCK_unlock(&dest_dir->content_lock);
@@ -85,6 +85,7 @@ cache_inode_lookup_impl(cache_entry_t *parent,
 	struct fsal_obj_handle *object_handle = NULL;
 	struct fsal_obj_handle *dir_handle;
 	cache_inode_status_t status = CACHE_INODE_SUCCESS;
+	nsecs_elapsed_t fsal_start;
 
 	if (parent->type != DIRECTORY) {
 		status = CACHE_INODE_NOT_A_DIRECTORY;
@@ -168,8 +169,10 @@ cache_inode_lookup_impl(cache_entry_t *parent,
 	}
 
 	dir_handle = parent->obj_handle;
+	fsal_start = server_stats_clock();
 	fsal_status =
 	    dir_handle->obj_ops.lookup(dir_handle, name, &object_handle);
+	server_stats_fsal_done(FSAL_LAT_LOOKUP, fsal_start);
 	if (FSAL_IS_ERROR(fsal_status)) {
 		if (fsal_status.major == ERR_FSAL_STALE) {
 			LogEvent(COMPONENT_CACHE_INODE,
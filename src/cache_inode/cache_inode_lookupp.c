@@ -80,6 +80,7 @@ cache_inode_lookupp_impl(cache_entry_t *entry,
 			 cache_entry_t **parent)
 {
 	cache_inode_status_t status = CACHE_INODE_SUCCESS;
+	nsecs_elapsed_t fsal_start;
 
 	/* Never even think of calling FSAL_lookup on root/.. */
 
@@ -118,9 +119,11 @@ cache_inode_lookupp_impl(cache_entry_t *entry,
 		PTHREAD_RWLOCK_unlock(&entry->content_lock);
 		PTHREAD_RWLOCK_wrlock(&entry->content_lock);
 
+		fsal_start = server_stats_clock();
 		fsal_status =
 		    entry->obj_handle->obj_ops.lookup(entry->obj_handle,
 						   "..", &parent_handle);
+		server_stats_fsal_done(FSAL_LAT_LOOKUP, fsal_start);
 		if (FSAL_IS_ERROR(fsal_status)) {
 			if (fsal_status.major == ERR_FSAL_STALE) {
 				LogEvent(COMPONENT_CACHE_INODE,
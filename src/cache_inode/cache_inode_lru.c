@@ -123,6 +123,22 @@ struct lru_q_lane {
 	 CACHE_PAD(0);
 };
 
+/**
+ * Directory chunks, charged against the entry high water mark by the
+ * number of dirents they hold.
+ */
+
+static struct {
+	struct glist_head q;	/* LRU is at HEAD, MRU at tail */
+	pthread_mutex_t mtx;
+} chunk_lru = {
+	.q = GLIST_HEAD_INIT(chunk_lru.q),
+	.mtx = PTHREAD_MUTEX_INITIALIZER
+};
+
+/* Chunks examined for reclaim each time one is inserted */
+#define LRU_CHUNK_RECLAIM_SCAN 16
+
 #define QLOCK(qlane) \
 	do { \
 		PTHREAD_MUTEX_lock(&(qlane)->mtx); \
@@ -967,6 +983,7 @@ cache_inode_lru_pkginit(void)
 	   bit fishy, so come back and revisit this. */
 	lru_state.entries_hiwat = cache_param.entries_hwmark;
 	lru_state.entries_used = 0;
+	lru_state.chunk_dirents = 0;
 
 	/* Find out the system-imposed file descriptor limit */
 	if (getrlimit(RLIMIT_NOFILE, &rlim) != 0) {
@@ -1567,4 +1584,114 @@ lru_wake_thread(void)
 	fridgethr_wake(lru_fridge);
 }
 
+/**
+ * @brief Charge a newly populated directory chunk
+ *
+ * Puts the chunk at the MRU end and, while chunked dirents exceed the
+ * entry high water mark, reclaims chunks from the LRU end.  Chunks of
+ * the same directory are skipped, as are directories whose content
+ * lock is busy, since the caller holds its own directory's lock.
+ *
+ * @param[in] chunk The chunk, its directory write locked
+ */
+
+void
+cache_inode_lru_insert_chunk(struct dir_chunk *chunk)
+{
+	struct glist_head *glist, *glistn;
+	struct dir_chunk *victim;
+	cache_entry_t *parent;
+	int scan = 0;
+
+	PTHREAD_MUTEX_lock(&chunk_lru.mtx);
+	glist_add_tail(&chunk_lru.q, &chunk->lru);
+	(void)atomic_add_uint64_t(&lru_state.chunk_dirents,
+				  chunk->num_entries);
+
+	glist_for_each_safe(glist, glistn, &chunk_lru.q) {
+		if (atomic_fetch_uint64_t(&lru_state.chunk_dirents) <=
+		    lru_state.entries_hiwat ||
+		    ++scan > LRU_CHUNK_RECLAIM_SCAN)
+			break;
+		victim = glist_entry(glist, struct dir_chunk, lru);
+		parent = victim->parent;
+		if (parent == chunk->parent ||
+		    pthread_rwlock_trywrlock(&parent->content_lock) != 0)
+			continue;
+		glist_del(&victim->lru);
+		(void)atomic_sub_uint64_t(&lru_state.chunk_dirents,
+					  victim->num_entries);
+		cache_inode_dir_chunk_free(victim, false);
+		/* Unlock before the queue, which keeps a directory being
+		 * cleaned from destroying the lock under us. */
+		PTHREAD_RWLOCK_unlock(&parent->content_lock);
+	}
+	PTHREAD_MUTEX_unlock(&chunk_lru.mtx);
+}
+
+/**
+ * @brief Move a chunk READDIR is reading to the MRU end
+ *
+ * @param[in] chunk The chunk, its directory at least read locked
+ */
+
+void
+cache_inode_lru_bump_chunk(struct dir_chunk *chunk)
+{
+	PTHREAD_MUTEX_lock(&chunk_lru.mtx);
+	if (!glist_null(&chunk->lru)) {
+		glist_del(&chunk->lru);
+		glist_add_tail(&chunk_lru.q, &chunk->lru);
+	}
+	PTHREAD_MUTEX_unlock(&chunk_lru.mtx);
+}
+
+/**
+ * @brief Uncharge and free a chunk
+ *
+ * @param[in] chunk        The chunk, its directory write locked
+ * @param[in] keep_dirents Leave the dirents in the name tree
+ */
+
+void
+cache_inode_lru_remove_chunk(struct dir_chunk *chunk, bool keep_dirents)
+{
+	PTHREAD_MUTEX_lock(&chunk_lru.mtx);
+	if (!glist_null(&chunk->lru)) {
+		glist_del(&chunk->lru);
+		(void)atomic_sub_uint64_t(&lru_state.chunk_dirents,
+					  chunk->num_entries);
+	}
+	cache_inode_dir_chunk_free(chunk, keep_dirents);
+	PTHREAD_MUTEX_unlock(&chunk_lru.mtx);
+}
+
+/**
+ * @brief Free every chunk of a directory, leaving its dirents
+ *
+ * Called with the directory write locked, or while cleaning it, in
+ * which case holding the queue lock keeps reclaim away.
+ *
+ * @param[in] directory The directory
+ */
+
+void
+cache_inode_lru_release_chunks(cache_entry_t *directory)
+{
+	struct glist_head *glist, *glistn;
+	struct dir_chunk *chunk;
+
+	PTHREAD_MUTEX_lock(&chunk_lru.mtx);
+	glist_for_each_safe(glist, glistn, &directory->object.dir.chunks) {
+		chunk = glist_entry(glist, struct dir_chunk, chunks);
+		if (!glist_null(&chunk->lru)) {
+			glist_del(&chunk->lru);
+			(void)atomic_sub_uint64_t(&lru_state.chunk_dirents,
+						  chunk->num_entries);
+		}
+		cache_inode_dir_chunk_free(chunk, true);
+	}
+	PTHREAD_MUTEX_unlock(&chunk_lru.mtx);
+}
+
 /** @} */
@@ -334,6 +334,8 @@ cache_inode_new_entry(struct fsal_obj_handle *new_obj,
 			 "Adding a REGULAR_FILE, entry=%p", nentry);
 
 		/* No shares or locks, yet. */
+		gsh_itree_init(&nentry->object.file.lock_tree);
+		glist_init(&nentry->object.file.blocked_lock_list);
 		glist_init(&nentry->object.file.lock_list);
 		glist_init(&nentry->object.file.nlm_share_list);
 		memset(&nentry->object.file.share_state, 0,
@@ -772,6 +774,8 @@ cache_inode_release_dirents(cache_entry_t *entry,
 
 	switch (which) {
 	case CACHE_INODE_AVL_NAMES:
+		/* chunks only link dirents in the name tree */
+		cache_inode_lru_release_chunks(entry);
 		tree = &entry->object.dir.avl.t;
 		break;
 
@@ -836,7 +840,7 @@ cache_inode_lock_trust_attrs(cache_entry_t *entry,
 			     bool need_wr_lock)
 {
 	cache_inode_status_t cache_status = CACHE_INODE_SUCCESS;
-	time_t oldmtime = 0;
+	struct timespec oldmtime;
 
 	if (need_wr_lock)
 		PTHREAD_RWLOCK_wrlock(&entry->attr_lock);
@@ -856,14 +860,17 @@ cache_inode_lock_trust_attrs(cache_entry_t *entry,
 			goto out;
 	}
 
-	oldmtime = entry->obj_handle->attributes.mtime.tv_sec;
+	oldmtime = entry->obj_handle->attributes.mtime;
 
 	cache_status = cache_inode_refresh_attrs(entry);
 	if (cache_status != CACHE_INODE_SUCCESS)
 		goto unlock;
 
+	/* Compare to the nanosecond, a change within the same second
+	 * must not leave the dirent cache trusted. */
 	if ((entry->type == DIRECTORY)
-	    && (oldmtime < entry->obj_handle->attributes.mtime.tv_sec)) {
+	    && (gsh_time_cmp(&oldmtime,
+			     &entry->obj_handle->attributes.mtime) < 0)) {
 		PTHREAD_RWLOCK_wrlock(&entry->content_lock);
 
 		cache_status = cache_inode_invalidate_all_cached_dirent(entry);
@@ -144,6 +144,7 @@ cache_inode_open(cache_entry_t *entry,
 	cache_inode_status_t status = CACHE_INODE_SUCCESS;
 	struct fsal_export *fsal_export;
 	bool closed;
+	nsecs_elapsed_t fsal_start;
 
 	assert(entry->obj_handle != NULL);
 
@@ -179,11 +180,15 @@ cache_inode_open(cache_entry_t *entry,
 		fsal_export = op_ctx->fsal_export;
 		if (fsal_export->exp_ops.fs_supports(fsal_export,
 						  fso_reopen_method)) {
+			fsal_start = server_stats_clock();
 			fsal_status = obj_hdl->obj_ops.reopen(obj_hdl,
 							   openflags);
+			server_stats_fsal_done(FSAL_LAT_REOPEN, fsal_start);
 			closed = false;
 		} else {
+			fsal_start = server_stats_clock();
 			fsal_status = obj_hdl->obj_ops.close(obj_hdl);
+			server_stats_fsal_done(FSAL_LAT_CLOSE, fsal_start);
 			closed = true;
 		}
 		if (FSAL_IS_ERROR(fsal_status)
@@ -211,7 +216,9 @@ cache_inode_open(cache_entry_t *entry,
 	}
 
 	if ((current_flags == FSAL_O_CLOSED)) {
+		fsal_start = server_stats_clock();
 		fsal_status = obj_hdl->obj_ops.open(obj_hdl, openflags);
+		server_stats_fsal_done(FSAL_LAT_OPEN, fsal_start);
 		if (FSAL_IS_ERROR(fsal_status)) {
 			status = cache_inode_error_convert(fsal_status);
 			LogDebug(COMPONENT_CACHE_INODE,
@@ -266,6 +273,7 @@ cache_inode_close(cache_entry_t *entry, uint32_t flags)
 	/* Error return from the FSAL */
 	fsal_status_t fsal_status;
 	cache_inode_status_t status = CACHE_INODE_SUCCESS;
+	nsecs_elapsed_t fsal_start;
 
 	if (entry->type != REGULAR_FILE) {
 		LogFullDebug(COMPONENT_CACHE_INODE,
@@ -302,8 +310,10 @@ cache_inode_close(cache_entry_t *entry, uint32_t flags)
 	    || (flags & CACHE_INODE_FLAG_REALLYCLOSE)
 	    || (entry->obj_handle->attributes.numlinks == 0)) {
 		LogFullDebug(COMPONENT_CACHE_INODE, "Closing entry %p", entry);
+		fsal_start = server_stats_clock();
 		fsal_status = entry->obj_handle->
 				obj_ops.close(entry->obj_handle);
+		server_stats_fsal_done(FSAL_LAT_CLOSE, fsal_start);
 		if (FSAL_IS_ERROR(fsal_status)
 		    && (fsal_status.major != ERR_FSAL_NOT_OPENED)) {
 			status = cache_inode_error_convert(fsal_status);
@@ -354,6 +364,7 @@ void cache_inode_adjust_openflags(cache_entry_t *entry)
 	struct fsal_obj_handle *obj_hdl;
 	fsal_openflags_t openflags;
 	fsal_status_t fsal_status;
+	nsecs_elapsed_t fsal_start;
 
 	if (entry->type != REGULAR_FILE) {
 		LogFullDebug(COMPONENT_CACHE_INODE,
@@ -391,7 +402,9 @@ void cache_inode_adjust_openflags(cache_entry_t *entry)
 		goto unlock;
 
 	openflags &= ~FSAL_O_WRITE;
+	fsal_start = server_stats_clock();
 	fsal_status = obj_hdl->obj_ops.reopen(obj_hdl, openflags);
+	server_stats_fsal_done(FSAL_LAT_REOPEN, fsal_start);
 	if (FSAL_IS_ERROR(fsal_status)) {
 		LogWarn(COMPONENT_CACHE_INODE,
 			"fsal reopen method returned: %d(%d)",
@@ -53,6 +53,107 @@
 #include <pthread.h>
 #include <assert.h>
 
+/**
+ * @brief Whether a write's effect on attributes can be applied locally
+ *
+ * Only FSALs whose change attribute is ctime in nsecs advertise
+ * fso_change_is_ctime.  For the others, cache_inode_write_attrs would
+ * move change out of step with what the FSAL reports, so their
+ * attributes are reloaded after every write instead.
+ *
+ * @return true if cache_inode_write_attrs may be used.
+ */
+
+static inline bool cache_inode_write_attrs_local(void)
+{
+	return op_ctx->fsal_export->exp_ops.fs_supports(op_ctx->fsal_export,
+							fso_change_is_ctime);
+}
+
+/**
+ * @brief Apply the effect of a successful write to cached attributes
+ *
+ * Used instead of asking the FSAL for attributes after every write
+ * when cache_inode_write_attrs_local allows.  Grow the size to cover
+ * the written range and move mtime and ctime to the current time.
+ * The change attribute is moved to the current time in nsecs, the
+ * way the FSAL would report it, and never backwards.  Untrusted
+ * attributes are left alone; they will be reloaded when next
+ * requested.  The caller must hold the attribute lock for write.
+ *
+ * @param[in,out] entry The file written
+ * @param[in]     end   Offset just past the last byte written
+ */
+
+static void cache_inode_write_attrs(cache_entry_t *entry, uint64_t end)
+{
+	struct attrlist *attrs = &entry->obj_handle->attributes;
+	struct timespec now;
+	uint64_t change;
+
+	if (!cache_inode_is_attrs_valid(entry))
+		return;
+
+	if (end > attrs->filesize)
+		attrs->filesize = end;
+
+	cache_inode_set_time_current(&now);
+	attrs->mtime = now;
+	attrs->ctime = now;
+	attrs->chgtime = now;
+	change = timespec_to_nsecs(&now);
+	attrs->change = change > attrs->change ? change : attrs->change + 1;
+	entry->change_time = attrs->change;
+}
+
+/**
+ * @brief Make sure a file is open for I/O
+ *
+ * The caller holds the content lock for read.  It may be dropped and
+ * retaken for write while the file is opened, but is held for read
+ * again on return.
+ *
+ * @param[in]  entry     File to be read or written
+ * @param[in]  openflags Required open mode
+ * @param[out] opened    Set to true if a closed file was opened
+ *
+ * @return CACHE_INODE_SUCCESS or errors from cache_inode_open.  On
+ *         failure the content lock is held for write.
+ */
+
+static cache_inode_status_t
+cache_inode_rdwr_open(cache_entry_t *entry, fsal_openflags_t openflags,
+		      bool *opened)
+{
+	struct fsal_obj_handle *obj_hdl = entry->obj_handle;
+	fsal_openflags_t loflags;
+	cache_inode_status_t status;
+
+	loflags = obj_hdl->obj_ops.status(obj_hdl);
+	while ((!is_open(entry))
+	       || (loflags && loflags != FSAL_O_RDWR && loflags != openflags)) {
+		PTHREAD_RWLOCK_unlock(&entry->content_lock);
+		PTHREAD_RWLOCK_wrlock(&entry->content_lock);
+		loflags = obj_hdl->obj_ops.status(obj_hdl);
+		if ((!is_open(entry))
+		    || (loflags && loflags != FSAL_O_RDWR
+			&& loflags != openflags)) {
+			status =
+			    cache_inode_open(entry, openflags,
+					     (CACHE_INODE_FLAG_CONTENT_HAVE |
+					      CACHE_INODE_FLAG_CONTENT_HOLD));
+			if (status != CACHE_INODE_SUCCESS)
+				return status;
+			*opened = true;
+		}
+		PTHREAD_RWLOCK_unlock(&entry->content_lock);
+		PTHREAD_RWLOCK_rdlock(&entry->content_lock);
+		loflags = obj_hdl->obj_ops.status(obj_hdl);
+	}
+
+	return CACHE_INODE_SUCCESS;
+}
+
 /**
  * @brief Reads/Writes through the cache layer
  *
@@ -86,13 +187,13 @@ cache_inode_rdwr_plus(cache_entry_t *entry,
 	struct fsal_obj_handle *obj_hdl = entry->obj_handle;
 	/* Required open mode to successfully read or write */
 	fsal_openflags_t openflags = FSAL_O_CLOSED;
-	fsal_openflags_t loflags;
 	/* True if we have taken the content lock on 'entry' */
 	bool content_locked = false;
 	/* True if we have taken the attribute lock on 'entry' */
 	bool attributes_locked = false;
 	/* TRUE if we opened a previously closed FD */
 	bool opened = false;
+	nsecs_elapsed_t fsal_start;
 
 	cache_inode_status_t status = CACHE_INODE_SUCCESS;
 
@@ -132,37 +233,22 @@ cache_inode_rdwr_plus(cache_entry_t *entry,
 	   to open or close a file descriptor. */
 	PTHREAD_RWLOCK_rdlock(&entry->content_lock);
 	content_locked = true;
-	loflags = obj_hdl->obj_ops.status(obj_hdl);
-	while ((!is_open(entry))
-	       || (loflags && loflags != FSAL_O_RDWR && loflags != openflags)) {
-		PTHREAD_RWLOCK_unlock(&entry->content_lock);
-		PTHREAD_RWLOCK_wrlock(&entry->content_lock);
-		loflags = obj_hdl->obj_ops.status(obj_hdl);
-		if ((!is_open(entry))
-		    || (loflags && loflags != FSAL_O_RDWR
-			&& loflags != openflags)) {
-			status =
-			    cache_inode_open(entry, openflags,
-					     (CACHE_INODE_FLAG_CONTENT_HAVE |
-					      CACHE_INODE_FLAG_CONTENT_HOLD));
-			if (status != CACHE_INODE_SUCCESS)
-				goto out;
-			opened = true;
-		}
-		PTHREAD_RWLOCK_unlock(&entry->content_lock);
-		PTHREAD_RWLOCK_rdlock(&entry->content_lock);
-		loflags = obj_hdl->obj_ops.status(obj_hdl);
-	}
+	status = cache_inode_rdwr_open(entry, openflags, &opened);
+	if (status != CACHE_INODE_SUCCESS)
+		goto out;
 
 	/* Call FSAL_read or FSAL_write */
+	fsal_start = server_stats_clock();
 	if (io_direction == CACHE_INODE_READ) {
 		fsal_status =
 		    obj_hdl->obj_ops.read(obj_hdl, offset, io_size,
 				       buffer, bytes_moved, eof);
+		server_stats_fsal_done(FSAL_LAT_READ, fsal_start);
 	} else if (io_direction == CACHE_INODE_READ_PLUS) {
 		fsal_status =
 		    obj_hdl->obj_ops.read_plus(obj_hdl, offset, io_size,
 					    buffer, bytes_moved, eof, info);
+		server_stats_fsal_done(FSAL_LAT_READ, fsal_start);
 	} else {
 		bool fsal_sync = *sync;
 		if (io_direction == CACHE_INODE_WRITE)
@@ -176,14 +262,16 @@ cache_inode_rdwr_plus(cache_entry_t *entry,
 						   io_size, buffer,
 						   bytes_moved, &fsal_sync,
 						   info);
+		server_stats_fsal_done(FSAL_LAT_WRITE, fsal_start);
+
 		/* Alright, the unstable write is complete. Now if it was
 		   supposed to be a stable write we can sync to the hard
 		   drive. */
 
 		if (*sync && !(obj_hdl->obj_ops.status(obj_hdl) & FSAL_O_SYNC)
 		    && !fsal_sync && !FSAL_IS_ERROR(fsal_status)) {
-			fsal_status = obj_hdl->obj_ops.commit(obj_hdl,
-							   offset, io_size);
+			fsal_status = cache_inode_group_commit(entry, offset,
+							       io_size);
 		} else {
 			*sync = fsal_sync;
 		}
@@ -266,12 +354,16 @@ cache_inode_rdwr_plus(cache_entry_t *entry,
 
 	PTHREAD_RWLOCK_wrlock(&entry->attr_lock);
 	attributes_locked = true;
-	if (io_direction == CACHE_INODE_WRITE ||
-	    io_direction == CACHE_INODE_WRITE_PLUS) {
+	if ((io_direction == CACHE_INODE_WRITE ||
+	     io_direction == CACHE_INODE_WRITE_PLUS) &&
+	    !cache_inode_write_attrs_local()) {
 		status = cache_inode_refresh_attrs(entry);
 		if (status != CACHE_INODE_SUCCESS)
 			goto out;
-	} else
+	} else if (io_direction == CACHE_INODE_WRITE ||
+		   io_direction == CACHE_INODE_WRITE_PLUS)
+		cache_inode_write_attrs(entry, offset + *bytes_moved);
+	else
 		cache_inode_set_time_current(&obj_hdl->attributes.atime);
 	PTHREAD_RWLOCK_unlock(&entry->attr_lock);
 	attributes_locked = false;
@@ -305,4 +397,547 @@ cache_inode_rdwr(cache_entry_t *entry,
 				     bytes_moved, buffer, eof, sync, NULL);
 }
 
+/* Buffer used to copy through the server when the FSAL cannot */
+#define CACHE_INODE_COPY_BUFSIZE (1024 * 1024)
+
+/**
+ * @brief Open both ends of a copy or clone
+ *
+ * The content locks are taken for read in address order, and each
+ * file is open before the next lock is taken, so that a thread only
+ * ever waits to upgrade the lock it took last.  A file copied onto
+ * itself is locked once and opened for read and write.
+ *
+ * @param[in]  src        Source file
+ * @param[in]  dst        Destination file
+ * @param[out] src_opened Set to true if the source was opened
+ * @param[out] dst_opened Set to true if the destination was opened
+ *
+ * @return CACHE_INODE_SUCCESS with both content locks held for read,
+ *         or errors from cache_inode_open with neither held.
+ */
+
+static cache_inode_status_t
+cache_inode_copy_open(cache_entry_t *src, cache_entry_t *dst,
+		      bool *src_opened, bool *dst_opened)
+{
+	cache_entry_t *first = src < dst ? src : dst;
+	cache_entry_t *second = src < dst ? dst : src;
+	bool *first_opened = src < dst ? src_opened : dst_opened;
+	bool *second_opened = src < dst ? dst_opened : src_opened;
+	cache_inode_status_t status;
+
+	*src_opened = false;
+	*dst_opened = false;
+
+	if (src == dst) {
+		PTHREAD_RWLOCK_rdlock(&src->content_lock);
+		status = cache_inode_rdwr_open(src, FSAL_O_RDWR, src_opened);
+		if (status != CACHE_INODE_SUCCESS)
+			PTHREAD_RWLOCK_unlock(&src->content_lock);
+		return status;
+	}
+
+	PTHREAD_RWLOCK_rdlock(&first->content_lock);
+	status = cache_inode_rdwr_open(first,
+				       first == src ? FSAL_O_READ
+						    : FSAL_O_WRITE,
+				       first_opened);
+	if (status != CACHE_INODE_SUCCESS) {
+		PTHREAD_RWLOCK_unlock(&first->content_lock);
+		return status;
+	}
+
+	PTHREAD_RWLOCK_rdlock(&second->content_lock);
+	status = cache_inode_rdwr_open(second,
+				       second == src ? FSAL_O_READ
+						     : FSAL_O_WRITE,
+				       second_opened);
+	if (status != CACHE_INODE_SUCCESS) {
+		PTHREAD_RWLOCK_unlock(&second->content_lock);
+		PTHREAD_RWLOCK_unlock(&first->content_lock);
+	}
+
+	return status;
+}
+
+/**
+ * @brief Close a file opened for a copy and drop its content lock
+ *
+ * @param[in] entry  The file
+ * @param[in] opened Whether cache_inode_copy_open opened it
+ */
+
+static void cache_inode_copy_close(cache_entry_t *entry, bool opened)
+{
+	cache_inode_status_t status;
+
+	if (opened) {
+		PTHREAD_RWLOCK_unlock(&entry->content_lock);
+		PTHREAD_RWLOCK_wrlock(&entry->content_lock);
+		status = cache_inode_close(entry,
+					   CACHE_INODE_FLAG_CONTENT_HAVE |
+					   CACHE_INODE_FLAG_CONTENT_HOLD);
+		if (status != CACHE_INODE_SUCCESS)
+			LogEvent(COMPONENT_CACHE_INODE,
+				 "cache_inode_copy: cache_inode_close = %d",
+				 status);
+	}
+	PTHREAD_RWLOCK_unlock(&entry->content_lock);
+}
+
+/**
+ * @brief Undo cache_inode_copy_open
+ *
+ * The locks are dropped in the reverse of the order they were taken.
+ *
+ * @param[in] src        Source file
+ * @param[in] dst        Destination file
+ * @param[in] src_opened Whether the source was opened
+ * @param[in] dst_opened Whether the destination was opened
+ */
+
+static void cache_inode_copy_release(cache_entry_t *src, cache_entry_t *dst,
+				     bool src_opened, bool dst_opened)
+{
+	if (src == dst) {
+		cache_inode_copy_close(src, src_opened);
+	} else if (src < dst) {
+		cache_inode_copy_close(dst, dst_opened);
+		cache_inode_copy_close(src, src_opened);
+	} else {
+		cache_inode_copy_close(src, src_opened);
+		cache_inode_copy_close(dst, dst_opened);
+	}
+}
+
+/**
+ * @brief Copy a range by reading and writing it
+ *
+ * Used when the FSAL cannot copy on its own.  The files are open.
+ *
+ * @param[in]  src_hdl    Source file
+ * @param[in]  src_offset Position in the source
+ * @param[in]  dst_hdl    Destination file
+ * @param[in]  dst_offset Position in the destination
+ * @param[in]  count      Bytes to copy
+ * @param[out] copied     Bytes copied
+ *
+ * @return FSAL status, success if anything was copied.
+ */
+
+static fsal_status_t cache_inode_copy_rw(struct fsal_obj_handle *src_hdl,
+					 uint64_t src_offset,
+					 struct fsal_obj_handle *dst_hdl,
+					 uint64_t dst_offset,
+					 uint64_t count,
+					 uint64_t *copied)
+{
+	fsal_status_t fsal_status = { 0, 0 };
+	size_t bufsize = MIN(count, CACHE_INODE_COPY_BUFSIZE);
+	size_t len, nb_read, nb_written;
+	bool eof = false;
+	bool stable;
+	void *buf;
+
+	*copied = 0;
+
+	buf = gsh_malloc(bufsize);
+	if (buf == NULL)
+		return fsalstat(ERR_FSAL_NOMEM, ENOMEM);
+
+	while (*copied < count && !eof) {
+		len = MIN(count - *copied, bufsize);
+		fsal_status = src_hdl->obj_ops.read(src_hdl,
+						    src_offset + *copied,
+						    len, buf, &nb_read, &eof);
+		if (FSAL_IS_ERROR(fsal_status) || nb_read == 0)
+			break;
+
+		stable = false;
+		fsal_status = dst_hdl->obj_ops.write(dst_hdl,
+						     dst_offset + *copied,
+						     nb_read, buf, &nb_written,
+						     &stable);
+		if (FSAL_IS_ERROR(fsal_status))
+			break;
+
+		*copied += nb_written;
+		if (nb_written < nb_read)
+			break;
+	}
+
+	gsh_free(buf);
+
+	if (FSAL_IS_ERROR(fsal_status) && *copied != 0)
+		return fsalstat(ERR_FSAL_NO_ERROR, 0);
+
+	return fsal_status;
+}
+
+/**
+ * @brief Copy a range of one file into another
+ *
+ * The FSAL's copy method is used if it has one that will take the
+ * range, otherwise the data is read and written through a buffer.
+ * The copy may be short; it stops at the end of the source, or where
+ * the FSAL stopped, and the caller continues from there.  The caller
+ * MUST NOT hold the content or attribute locks of either file, and
+ * is responsible for the files being in the same export.
+ *
+ * @param[in]     src        Source file
+ * @param[in]     src_offset Position in the source
+ * @param[in]     dst        Destination file
+ * @param[in]     dst_offset Position in the destination
+ * @param[in]     count      Bytes to copy
+ * @param[out]    copied     Bytes copied
+ * @param[in,out] sync       In, whether the copy must be stable.  Out,
+ *                           whether it is.
+ *
+ * @return CACHE_INODE_SUCCESS or various errors
+ */
+
+cache_inode_status_t cache_inode_copy(cache_entry_t *src, uint64_t src_offset,
+				      cache_entry_t *dst, uint64_t dst_offset,
+				      uint64_t count, uint64_t *copied,
+				      bool *sync)
+{
+	struct fsal_obj_handle *src_hdl = src->obj_handle;
+	struct fsal_obj_handle *dst_hdl = dst->obj_handle;
+	fsal_status_t fsal_status;
+	cache_inode_status_t status;
+	bool src_opened, dst_opened;
+	nsecs_elapsed_t fsal_start;
+
+	*copied = 0;
+
+	if (src->type != REGULAR_FILE || dst->type != REGULAR_FILE) {
+		return src->type == DIRECTORY || dst->type == DIRECTORY
+		    ? CACHE_INODE_IS_A_DIRECTORY : CACHE_INODE_BAD_TYPE;
+	}
+
+	/* As in cache_inode_rdwr_plus */
+	if (op_ctx->export->export_perms.options & EXPORT_OPTION_COMMIT)
+		*sync = true;
+
+	status = cache_inode_copy_open(src, dst, &src_opened, &dst_opened);
+	if (status != CACHE_INODE_SUCCESS)
+		return status;
+
+	fsal_start = server_stats_clock();
+	fsal_status = src_hdl->obj_ops.copy(src_hdl, src_offset, dst_hdl,
+					    dst_offset, count, copied);
+	if (fsal_status.major == ERR_FSAL_NOTSUPP)
+		fsal_status = cache_inode_copy_rw(src_hdl, src_offset,
+						  dst_hdl, dst_offset,
+						  count, copied);
+	server_stats_fsal_done(FSAL_LAT_COPY, fsal_start);
+
+	if (!FSAL_IS_ERROR(fsal_status) && *sync && *copied != 0) {
+		fsal_status = cache_inode_group_commit(dst, dst_offset,
+						       *copied);
+	}
+
+	LogFullDebug(COMPONENT_CACHE_INODE,
+		     "cache_inode_copy: %d, asked_size=%" PRIu64
+		     ", copied=%" PRIu64,
+		     fsal_status.major, count, *copied);
+
+	cache_inode_copy_release(src, dst, src_opened, dst_opened);
+
+	if (FSAL_IS_ERROR(fsal_status)) {
+		LogDebug(COMPONENT_CACHE_INODE,
+			 "cache_inode_copy: fsal_status.major = %d",
+			 fsal_status.major);
+		*copied = 0;
+		return cache_inode_error_convert(fsal_status);
+	}
+
+	PTHREAD_RWLOCK_wrlock(&dst->attr_lock);
+	if (!cache_inode_write_attrs_local())
+		status = cache_inode_refresh_attrs(dst);
+	else if (*copied != 0)
+		cache_inode_write_attrs(dst, dst_offset + *copied);
+	PTHREAD_RWLOCK_unlock(&dst->attr_lock);
+
+	return status;
+}
+
+/**
+ * @brief Share a range of one file's storage with another
+ *
+ * The whole range is cloned or none of it.  There is no fallback; a
+ * FSAL that cannot clone returns CACHE_INODE_NOT_SUPPORTED and the
+ * client copies instead.  The locking rules are those of
+ * cache_inode_copy.
+ *
+ * @param[in] src        Source file
+ * @param[in] src_offset Position in the source
+ * @param[in] dst        Destination file
+ * @param[in] dst_offset Position in the destination
+ * @param[in] count      Bytes to clone, 0 for the rest of the source
+ *
+ * @return CACHE_INODE_SUCCESS or various errors
+ */
+
+cache_inode_status_t cache_inode_clone(cache_entry_t *src, uint64_t src_offset,
+				       cache_entry_t *dst, uint64_t dst_offset,
+				       uint64_t count)
+{
+	struct fsal_obj_handle *src_hdl = src->obj_handle;
+	struct fsal_obj_handle *dst_hdl = dst->obj_handle;
+	fsal_status_t fsal_status;
+	cache_inode_status_t status;
+	bool src_opened, dst_opened;
+
+	if (src->type != REGULAR_FILE || dst->type != REGULAR_FILE) {
+		return src->type == DIRECTORY || dst->type == DIRECTORY
+		    ? CACHE_INODE_IS_A_DIRECTORY : CACHE_INODE_BAD_TYPE;
+	}
+
+	status = cache_inode_copy_open(src, dst, &src_opened, &dst_opened);
+	if (status != CACHE_INODE_SUCCESS)
+		return status;
+
+	fsal_status = src_hdl->obj_ops.clone(src_hdl, src_offset, dst_hdl,
+					     dst_offset, count);
+
+	cache_inode_copy_release(src, dst, src_opened, dst_opened);
+
+	if (FSAL_IS_ERROR(fsal_status)) {
+		LogDebug(COMPONENT_CACHE_INODE,
+			 "cache_inode_clone: fsal_status.major = %d",
+			 fsal_status.major);
+		return cache_inode_error_convert(fsal_status);
+	}
+
+	/* The size is not known when cloning to the end of the source,
+	   so ask the FSAL. */
+	PTHREAD_RWLOCK_wrlock(&dst->attr_lock);
+	status = cache_inode_refresh_attrs(dst);
+	PTHREAD_RWLOCK_unlock(&dst->attr_lock);
+
+	return status;
+}
+
+/**
+ * @brief State of an asynchronous read or write
+ */
+
+struct cache_inode_io_req {
+	cache_entry_t *entry;
+	cache_inode_io_direction_t io_direction;
+	struct fsal_io_arg *io_arg;
+	cache_inode_io_cb done_cb;
+	void *caller_arg;
+	struct req_op_context *ctx;	/*< Caller's context */
+	fsal_status_t status;	/*< Result from the FSAL */
+	bool sync;		/*< A stable write was requested */
+	uint32_t pending;	/*< Submitter and FSAL still to finish */
+};
+
+/**
+ * @brief Finish an asynchronous read or write
+ *
+ * Runs once both the submitting thread has dropped its locks and the
+ * FSAL has completed the I/O, on whichever thread got there last.
+ * That thread runs with the caller's context until the callback
+ * returns, then gets its own back.
+ *
+ * @param[in] req The request, freed on return
+ */
+
+static void cache_inode_io_complete(struct cache_inode_io_req *req)
+{
+	cache_entry_t *entry = req->entry;
+	struct fsal_io_arg *io_arg = req->io_arg;
+	fsal_status_t fsal_status = req->status;
+	cache_inode_status_t status = CACHE_INODE_SUCCESS;
+	bool write = req->io_direction == CACHE_INODE_WRITE;
+	struct req_op_context *saved_ctx = op_ctx;
+
+	op_ctx = req->ctx;
+
+	LogFullDebug(COMPONENT_FSAL,
+		     "cache_inode_rdwr_async: FSAL IO operation returned "
+		     "%d, effective_size=%zu",
+		     fsal_status.major, io_arg->io_amount);
+
+	if (FSAL_IS_ERROR(fsal_status)) {
+		LogDebug(COMPONENT_CACHE_INODE,
+			 "cache_inode_rdwr_async: fsal_status.major = %d",
+			 fsal_status.major);
+
+		io_arg->io_amount = 0;
+		status = cache_inode_error_convert(fsal_status);
+
+		if (fsal_status.major == ERR_FSAL_STALE)
+			cache_inode_kill_entry(entry);
+
+		goto out;
+	}
+
+	/* The write was supposed to be stable but the FSAL could not
+	   make it so; commit it now. */
+	if (write && req->sync && !io_arg->fsal_stable) {
+		status = cache_inode_commit(entry, io_arg->offset,
+					    io_arg->io_amount);
+		if (status != CACHE_INODE_SUCCESS) {
+			io_arg->io_amount = 0;
+			goto out;
+		}
+		io_arg->fsal_stable = true;
+	}
+
+	PTHREAD_RWLOCK_wrlock(&entry->attr_lock);
+	if (write && !cache_inode_write_attrs_local())
+		status = cache_inode_refresh_attrs(entry);
+	else if (write)
+		cache_inode_write_attrs(entry,
+					io_arg->offset + io_arg->io_amount);
+	else
+		cache_inode_set_time_current(
+			&entry->obj_handle->attributes.atime);
+	PTHREAD_RWLOCK_unlock(&entry->attr_lock);
+
+ out:
+
+	req->done_cb(entry, status, io_arg, req->caller_arg);
+	gsh_free(req);
+
+	op_ctx = saved_ctx;
+}
+
+/**
+ * @brief FSAL completion of an asynchronous read or write
+ *
+ * @param[in] obj_hdl    File
+ * @param[in] ret        Status of the I/O
+ * @param[in] io_arg     I/O arguments and results
+ * @param[in] caller_arg The cache_inode_io_req
+ */
+
+static void cache_inode_io_done(struct fsal_obj_handle *obj_hdl,
+				fsal_status_t ret,
+				struct fsal_io_arg *io_arg,
+				void *caller_arg)
+{
+	struct cache_inode_io_req *req = caller_arg;
+
+	req->status = ret;
+
+	if (atomic_dec_uint32_t(&req->pending) == 0)
+		cache_inode_io_complete(req);
+}
+
+/**
+ * @brief Read or write without waiting for the I/O
+ *
+ * This function starts a CACHE_INODE_READ or CACHE_INODE_WRITE
+ * through the FSAL's read2 or write2 method and returns.  @c done_cb
+ * is called exactly once with the result, either before this
+ * function returns or later from another thread.  It is called with
+ * no locks held and with op_ctx set to the caller's context, which
+ * must therefore remain valid until then.  The caller must also hold
+ * a reference on the entry until then.  The caller MUST NOT hold
+ * either the content or attribute locks when calling this function.
+ *
+ * @param[in]     entry        File to be read or written
+ * @param[in]     io_direction CACHE_INODE_READ or CACHE_INODE_WRITE
+ * @param[in,out] io_arg       Position and buffers.  For writes,
+ *                             fsal_stable requests a stable write.
+ * @param[in]     done_cb      Completion callback
+ * @param[in]     caller_arg   Passed to done_cb
+ */
+
+void cache_inode_rdwr_async(cache_entry_t *entry,
+			    cache_inode_io_direction_t io_direction,
+			    struct fsal_io_arg *io_arg,
+			    cache_inode_io_cb done_cb,
+			    void *caller_arg)
+{
+	struct fsal_obj_handle *obj_hdl = entry->obj_handle;
+	struct cache_inode_io_req *req;
+	fsal_openflags_t openflags;
+	cache_inode_status_t status;
+	bool opened = false;
+
+	assert(io_direction == CACHE_INODE_READ ||
+	       io_direction == CACHE_INODE_WRITE);
+
+	io_arg->io_amount = 0;
+	io_arg->end_of_file = false;
+
+	if (entry->type != REGULAR_FILE) {
+		done_cb(entry,
+			entry->type == DIRECTORY ? CACHE_INODE_IS_A_DIRECTORY
+						 : CACHE_INODE_BAD_TYPE,
+			io_arg, caller_arg);
+		return;
+	}
+
+	req = gsh_malloc(sizeof(*req));
+	if (req == NULL) {
+		done_cb(entry, CACHE_INODE_MALLOC_ERROR, io_arg, caller_arg);
+		return;
+	}
+
+	req->entry = entry;
+	req->io_direction = io_direction;
+	req->io_arg = io_arg;
+	req->done_cb = done_cb;
+	req->caller_arg = caller_arg;
+	req->ctx = op_ctx;
+	req->status = fsalstat(ERR_FSAL_NO_ERROR, 0);
+	req->pending = 2;
+
+	/* As in cache_inode_rdwr_plus */
+	if (io_direction == CACHE_INODE_READ) {
+		openflags = FSAL_O_READ;
+		req->sync = false;
+	} else {
+		if (op_ctx->export->export_perms.options & EXPORT_OPTION_COMMIT)
+			io_arg->fsal_stable = true;
+		req->sync = io_arg->fsal_stable;
+		openflags = FSAL_O_WRITE;
+		if (req->sync)
+			openflags |= FSAL_O_SYNC;
+	}
+
+	PTHREAD_RWLOCK_rdlock(&entry->content_lock);
+	status = cache_inode_rdwr_open(entry, openflags, &opened);
+	if (status != CACHE_INODE_SUCCESS) {
+		PTHREAD_RWLOCK_unlock(&entry->content_lock);
+		gsh_free(req);
+		done_cb(entry, status, io_arg, caller_arg);
+		return;
+	}
+
+	if (io_direction == CACHE_INODE_READ)
+		obj_hdl->obj_ops.read2(obj_hdl, io_arg, cache_inode_io_done,
+				       req);
+	else
+		obj_hdl->obj_ops.write2(obj_hdl, io_arg, cache_inode_io_done,
+					req);
+
+	/* The FSAL holds on to what it needs, so a descriptor opened
+	   just for this I/O can be closed now. */
+	if (opened) {
+		PTHREAD_RWLOCK_unlock(&entry->content_lock);
+		PTHREAD_RWLOCK_wrlock(&entry->content_lock);
+		status = cache_inode_close(entry,
+					   CACHE_INODE_FLAG_CONTENT_HAVE |
+					   CACHE_INODE_FLAG_CONTENT_HOLD);
+		if (status != CACHE_INODE_SUCCESS)
+			LogEvent(COMPONENT_CACHE_INODE,
+				 "cache_inode_rdwr_async: cache_inode_close = %d",
+				 status);
+	}
+
+	PTHREAD_RWLOCK_unlock(&entry->content_lock);
+
+	if (atomic_dec_uint32_t(&req->pending) == 0)
+		cache_inode_io_complete(req);
+}
+
 /** @} */
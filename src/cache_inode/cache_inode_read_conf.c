@@ -81,6 +81,12 @@ static struct config_item cache_inode_params[] = {
 		       cache_inode_parameter, futility_count),
 	CONF_ITEM_BOOL("Retry_Readdir", false,
 		       cache_inode_parameter, retry_readdir),
+	CONF_ITEM_UI32("Dir_Chunk", 0, UINT32_MAX, 128,
+		       cache_inode_parameter, dir_chunk),
+	CONF_ITEM_UI32("Commit_Window", 0, 1000000, 500,
+		       cache_inode_parameter, commit_window),
+	CONF_ITEM_UI32("Commit_Batch_Max", 1, 1024, 64,
+		       cache_inode_parameter, commit_batch_max),
 	CONFIG_EOL
 };
 
@@ -224,6 +224,7 @@ cache_inode_operate_cached_dirent(cache_entry_t *directory,
 					     + newnamesize);
 			memcpy(dirent3->name, newname, newnamesize);
 			dirent3->flags = DIR_ENTRY_FLAG_NONE;
+			dirent3->chunk = NULL;
 			cache_inode_key_dup(&dirent3->ckey, &dirent->ckey);
 			avl_dirent_set_deleted(directory, dirent);
 			code = cache_inode_avl_qp_insert(directory, dirent3);
@@ -290,6 +291,7 @@ cache_inode_add_cached_dirent(cache_entry_t *parent,
 	}
 
 	new_dir_entry->flags = DIR_ENTRY_FLAG_NONE;
+	new_dir_entry->chunk = NULL;
 
 	memcpy(&new_dir_entry->name, name, namesize);
 	cache_inode_key_dup(&new_dir_entry->ckey, &entry->fh_hk.key);
@@ -347,6 +349,110 @@ cache_inode_remove_cached_dirent(cache_entry_t *directory,
 
 }
 
+/**
+ * @brief Take a dirent out of its chunk
+ *
+ * The dirent stays in the name tree.  The caller must hold the
+ * content lock for write.
+ *
+ * @param[in]     directory The directory
+ * @param[in,out] dirent    The dirent
+ */
+
+void
+cache_inode_dirent_unchunk(cache_entry_t *directory,
+			   cache_inode_dir_entry_t *dirent)
+{
+	struct dir_chunk *chunk = dirent->chunk;
+
+	if (chunk == NULL)
+		return;
+
+	glist_del(&dirent->chunk_list);
+	avltree_remove(&dirent->node_ck, &directory->object.dir.avl.ck);
+	chunk->num_entries--;
+	if (!glist_null(&chunk->lru))
+		(void)atomic_dec_uint64_t(&lru_state.chunk_dirents);
+	dirent->chunk = NULL;
+}
+
+/**
+ * @brief Add a dirent to a chunk being populated
+ *
+ * A name already held by another chunk moves to this one, as does a
+ * cookie, since the FSAL is the authority on both.
+ *
+ * @param[in]     directory The directory
+ * @param[in,out] dirent    The dirent
+ * @param[in]     chunk     The chunk
+ * @param[in]     ck        FSAL cookie of the dirent
+ */
+
+static void
+cache_inode_dirent_chunk(cache_entry_t *directory,
+			 cache_inode_dir_entry_t *dirent,
+			 struct dir_chunk *chunk, uint64_t ck)
+{
+	cache_inode_dir_entry_t *other;
+
+	cache_inode_dirent_unchunk(directory, dirent);
+
+	other = cache_inode_avl_lookup_ck(directory, ck);
+	if (other != NULL)
+		cache_inode_dirent_unchunk(directory, other);
+
+	dirent->ck = ck;
+	dirent->chunk = chunk;
+	avltree_insert(&dirent->node_ck, &directory->object.dir.avl.ck);
+	glist_add_tail(&chunk->dirents, &dirent->chunk_list);
+	chunk->num_entries++;
+}
+
+/**
+ * @brief Free a directory chunk
+ *
+ * The chunk must already be off the chunk LRU and the directory write
+ * locked.  Dirents are either kept for lookups or freed, in which case
+ * the name cache is no longer complete.
+ *
+ * @param[in] chunk        The chunk
+ * @param[in] keep_dirents Leave the dirents in the name tree
+ */
+
+void
+cache_inode_dir_chunk_free(struct dir_chunk *chunk, bool keep_dirents)
+{
+	cache_entry_t *directory = chunk->parent;
+	struct glist_head *glist, *glistn;
+	cache_inode_dir_entry_t *dirent;
+
+	glist_for_each_safe(glist, glistn, &chunk->dirents) {
+		dirent = glist_entry(glist, cache_inode_dir_entry_t,
+				     chunk_list);
+		glist_del(&dirent->chunk_list);
+		avltree_remove(&dirent->node_ck, &directory->object.dir.avl.ck);
+		dirent->chunk = NULL;
+		if (keep_dirents)
+			continue;
+		cache_inode_avl_remove(directory, dirent);
+		directory->object.dir.nbactive--;
+		cache_inode_free_dirent(dirent);
+	}
+
+	if (!keep_dirents)
+		atomic_clear_uint32_t_bits(&directory->flags,
+					   CACHE_INODE_DIR_POPULATED);
+
+	if (chunk->prev != NULL)
+		chunk->prev->next = NULL;
+	if (chunk->next != NULL)
+		chunk->next->prev = NULL;
+	if (directory->object.dir.first_chunk == chunk)
+		directory->object.dir.first_chunk = NULL;
+	glist_del(&chunk->chunks);
+	gsh_free(chunk);
+}
+
 /**
  * @brief State to be passed to FSAL readdir callbacks
  */
@@ -355,36 +461,53 @@ struct cache_inode_populate_cb_state {
 	cache_entry_t *directory;
 	cache_inode_status_t *status;
 	uint64_t offset_cookie;
+	struct dir_chunk *chunk;	/*< Chunk being populated, or NULL */
 };
 
 /**
  * @brief Populate a single dir entry
  *
  * This callback serves to populate a single dir entry from the
- * readdir.
+ * readdir_plus, which has already looked the entry up.
  *
- * @param[in]     name      Name of the directory entry
- * @param[in,out] dir_state Callback state
- * @param[in]     cookie    Directory cookie
+ * @param[in]     name        Name of the directory entry
+ * @param[in]     entry_hdl   The entry, NULL if it couldn't be looked up
+ * @param[in]     fsal_status Status of the lookup
+ * @param[in,out] dir_state   Callback state
+ * @param[in]     cookie      Directory cookie
  *
  * @retval true if more entries are requested
  * @retval false if no more should be sent and the last was not processed
  */
 
 static bool
-populate_dirent(const char *name, void *dir_state,
+populate_dirent(const char *name, struct fsal_obj_handle *entry_hdl,
+		fsal_status_t fsal_status, void *dir_state,
 		fsal_cookie_t cookie)
 {
 	struct cache_inode_populate_cb_state *state =
 	    (struct cache_inode_populate_cb_state *)dir_state;
-	struct fsal_obj_handle *entry_hdl;
 	cache_inode_dir_entry_t *new_dir_entry = NULL;
 	cache_entry_t *cache_entry = NULL;
-	fsal_status_t fsal_status = { 0, 0 };
 	struct fsal_obj_handle *dir_hdl = state->directory->obj_handle;
 
-	fsal_status = dir_hdl->obj_ops.lookup(dir_hdl, name, &entry_hdl);
-	if (FSAL_IS_ERROR(fsal_status)) {
+	if (state->chunk != NULL) {
+		/* Leave the rest for the next chunk */
+		if (state->chunk->num_entries >= cache_param.dir_chunk)
+			goto release;
+		/* 0 means the start, and the bias must not wrap */
+		if (cookie == 0 ||
+		    cookie > UINT64_MAX - DIR_CHUNK_COOKIE_BIAS) {
+			LogCrit(COMPONENT_NFS_READDIR,
+				"FSAL cookie %" PRIu64
+				" for %s cannot be handed out, set Dir_Chunk = 0",
+				cookie, name);
+			*state->status = CACHE_INODE_SERVERFAULT;
+			goto release;
+		}
+	}
+
+	if (entry_hdl == NULL) {
 		*state->status = cache_inode_error_convert(fsal_status);
 		if (*state->status == CACHE_INODE_FSAL_XDEV) {
 			LogInfo(COMPONENT_NFS_READDIR,
@@ -421,9 +544,21 @@ populate_dirent(const char *name, void *dir_state,
 				    &state->directory->fh_hk.key);
 	}
 
-	*state->status =
-	    cache_inode_add_cached_dirent(state->directory, name, cache_entry,
-					  &new_dir_entry);
+	if (state->chunk != NULL) {
+		new_dir_entry =
+		    cache_inode_avl_qp_lookup_s(state->directory, name, 1);
+		/* the name may now be a different object */
+		if (new_dir_entry != NULL) {
+			cache_inode_key_delete(&new_dir_entry->ckey);
+			cache_inode_key_dup(&new_dir_entry->ckey,
+					    &cache_entry->fh_hk.key);
+		}
+	}
+
+	if (new_dir_entry == NULL)
+		*state->status =
+		    cache_inode_add_cached_dirent(state->directory, name,
+						  cache_entry, &new_dir_entry);
 	/* return initial ref */
 	cache_inode_put(cache_entry);
 
@@ -435,7 +570,16 @@ populate_dirent(const char *name, void *dir_state,
 		return false;
 	}
 
+	if (state->chunk != NULL && new_dir_entry != NULL)
+		cache_inode_dirent_chunk(state->directory, new_dir_entry,
+					 state->chunk, cookie);
+
 	return true;
+
+ release:
+	if (entry_hdl != NULL)
+		entry_hdl->obj_ops.release(entry_hdl);
+	return false;
 }
 
 /**
@@ -457,6 +601,7 @@ cache_inode_readdir_populate(cache_entry_t *directory)
 	fsal_status_t fsal_status;
 	bool eod = false;
 	cache_inode_status_t status = CACHE_INODE_SUCCESS;
+	nsecs_elapsed_t fsal_start;
 
 	struct cache_inode_populate_cb_state state;
 
@@ -489,13 +634,17 @@ cache_inode_readdir_populate(cache_entry_t *directory)
 	state.directory = directory;
 	state.status = &status;
 	state.offset_cookie = 0;
+	state.chunk = NULL;
 
+	fsal_start = server_stats_clock();
 	fsal_status =
-		directory->obj_handle->obj_ops.readdir(directory->obj_handle,
-						    NULL,
-						    (void *)&state,
-						    populate_dirent,
-						    &eod);
+		directory->obj_handle->obj_ops.readdir_plus(
+						directory->obj_handle,
+						NULL,
+						(void *)&state,
+						populate_dirent,
+						&eod);
+	server_stats_fsal_done(FSAL_LAT_READDIR, fsal_start);
 	if (FSAL_IS_ERROR(fsal_status)) {
 		if (fsal_status.major == ERR_FSAL_STALE) {
 			LogEvent(COMPONENT_NFS_READDIR,
@@ -533,12 +682,436 @@ cache_inode_readdir_populate(cache_entry_t *directory)
 	return status;
 }				/* cache_inode_readdir_populate */
 
+/**
+ * @brief Read one chunk of a directory
+ *
+ * Reads up to Dir_Chunk dirents following FSAL cookie whence and links
+ * the new chunk after prev.  The content lock must be held for write.
+ *
+ * @param[in]  directory Entry for the directory being read
+ * @param[in]  whence    FSAL cookie to read after, 0 for the start
+ * @param[in]  prev      Chunk ending at whence, if known
+ * @param[out] chunk     The chunk read
+ *
+ * @return CACHE_INODE_SUCCESS or errors.
+ */
+
+static cache_inode_status_t
+cache_inode_readdir_chunk_populate(cache_entry_t *directory, uint64_t whence,
+				   struct dir_chunk *prev,
+				   struct dir_chunk **chunk)
+{
+	fsal_status_t fsal_status;
+	fsal_cookie_t fsal_whence = whence;
+	bool eod = false;
+	cache_inode_status_t status = CACHE_INODE_SUCCESS;
+	struct cache_inode_populate_cb_state state;
+	struct dir_chunk *new_chunk, *walk;
+	nsecs_elapsed_t fsal_start;
+
+	new_chunk = gsh_calloc(1, sizeof(struct dir_chunk));
+	if (new_chunk == NULL)
+		return CACHE_INODE_MALLOC_ERROR;
+
+	glist_init(&new_chunk->dirents);
+	new_chunk->parent = directory;
+	new_chunk->whence = whence;
+	new_chunk->gen = directory->object.dir.chunk_gen;
+	glist_add_tail(&directory->object.dir.chunks, &new_chunk->chunks);
+	if (whence == 0)
+		directory->object.dir.first_chunk = new_chunk;
+	if (prev != NULL) {
+		if (prev->next != NULL)
+			prev->next->prev = NULL;
+		prev->next = new_chunk;
+		new_chunk->prev = prev;
+	}
+
+	state.directory = directory;
+	state.status = &status;
+	state.offset_cookie = whence;
+	state.chunk = new_chunk;
+
+	fsal_start = server_stats_clock();
+	fsal_status =
+		directory->obj_handle->obj_ops.readdir_plus(
+						directory->obj_handle,
+						whence != 0 ? &fsal_whence
+							    : NULL,
+						(void *)&state,
+						populate_dirent,
+						&eod);
+	server_stats_fsal_done(FSAL_LAT_READDIR, fsal_start);
+	if (FSAL_IS_ERROR(fsal_status)) {
+		cache_inode_dir_chunk_free(new_chunk, true);
+		if (fsal_status.major == ERR_FSAL_STALE) {
+			LogEvent(COMPONENT_NFS_READDIR,
+				 "FSAL returned STALE from readdir.");
+			cache_inode_kill_entry(directory);
+		}
+
+		status = cache_inode_error_convert(fsal_status);
+		LogDebug(COMPONENT_NFS_READDIR,
+			 "FSAL readdir status=%s",
+			 cache_inode_err_str(status));
+		return status;
+	}
+
+	if (eod) {
+		new_chunk->eod = true;
+		status = CACHE_INODE_SUCCESS;
+	} else if (new_chunk->num_entries >= cache_param.dir_chunk) {
+		/* stopped because the chunk is full */
+		status = CACHE_INODE_SUCCESS;
+	} else if (status == CACHE_INODE_SUCCESS ||
+		   status == CACHE_INODE_ENTRY_EXISTS) {
+		if (cache_param.retry_readdir) {
+			LogInfo(COMPONENT_NFS_READDIR,
+				"Readdir didn't reach eod on dir %p",
+				directory->obj_handle);
+			status = CACHE_INODE_DELAY;
+		} else {
+			/* keep what we got as a partial chunk */
+			status = CACHE_INODE_SUCCESS;
+		}
+	}
+
+	if (status != CACHE_INODE_SUCCESS) {
+		cache_inode_dir_chunk_free(new_chunk, true);
+		return status;
+	}
+
+	cache_inode_lru_insert_chunk(new_chunk);
+
+	/* With an unbroken run of chunks from the start to the end, every
+	 * name is cached and negative lookups can be served. */
+	if (new_chunk->eod) {
+		for (walk = new_chunk; walk->prev != NULL; walk = walk->prev)
+			;
+		if (walk == directory->object.dir.first_chunk)
+			atomic_set_uint32_t_bits(&directory->flags,
+						 CACHE_INODE_DIR_POPULATED);
+	}
+
+	LogFullDebug(COMPONENT_NFS_READDIR,
+		     "Read chunk of %" PRIu32 " dirents after cookie %" PRIu64
+		     " in dir %p%s", new_chunk->num_entries, whence,
+		     directory, new_chunk->eod ? " (eod)" : "");
+
+	*chunk = new_chunk;
+	return CACHE_INODE_SUCCESS;
+}
+
+/**
+ * @brief Hand one cached dirent to the READDIR callback
+ *
+ * Dirents whose object has gone away are skipped and the directory
+ * content is marked untrustworthy.
+ *
+ * @param[in]     directory   The directory being read
+ * @param[in]     dirent      The dirent
+ * @param[in]     cookie      Cookie to return for the dirent
+ * @param[in]     attr_status Result of the attribute permission check
+ * @param[in]     cb          The callback function to receive entries
+ * @param[in,out] cb_parms    Callback parameters
+ * @param[in,out] nbfound     Number of entries returned
+ * @param[in,out] retry_stale Whether an ESTALE may still be retried
+ *
+ * @return CACHE_INODE_SUCCESS if handed out or skipped, else errors.
+ */
+
+static cache_inode_status_t
+cache_inode_readdir_dirent(cache_entry_t *directory,
+			   cache_inode_dir_entry_t *dirent,
+			   uint64_t cookie,
+			   cache_inode_status_t attr_status,
+			   cache_inode_getattr_cb_t cb,
+			   struct cache_inode_readdir_cb_parms *cb_parms,
+			   unsigned int *nbfound,
+			   bool *retry_stale)
+{
+	cache_entry_t *entry = NULL;
+	cache_inode_status_t status = CACHE_INODE_SUCCESS;
+
+ estale_retry:
+	LogFullDebug(COMPONENT_NFS_READDIR,
+		     "Lookup direct %s",
+		     dirent->name);
+
+	entry = cache_inode_get_keyed(&dirent->ckey, CIG_KEYED_FLAG_NONE,
+				      &status);
+	if (!entry) {
+		LogFullDebug(COMPONENT_NFS_READDIR,
+			     "Lookup returned %s",
+			     cache_inode_err_str(status));
+
+		if (*retry_stale && status == CACHE_INODE_ESTALE) {
+			LogDebug(COMPONENT_NFS_READDIR,
+				 "cache_inode_get_keyed returned %s "
+				 "for %s - retrying entry",
+				 cache_inode_err_str(status), dirent->name);
+			*retry_stale = false; /* only one retry per dirent */
+			goto estale_retry;
+		}
+
+		if (status == CACHE_INODE_NOT_FOUND
+		    || status == CACHE_INODE_ESTALE) {
+			/* Directory changed out from under us.
+			   Invalidate it, skip the name, and keep
+			   going. */
+			atomic_clear_uint32_t_bits(&directory->flags,
+						   CACHE_INODE_TRUST_CONTENT);
+			LogDebug(COMPONENT_NFS_READDIR,
+				 "cache_inode_get_keyed returned %s "
+				 "for %s - skipping entry",
+				 cache_inode_err_str(status), dirent->name);
+			return CACHE_INODE_SUCCESS;
+		}
+
+		/* Something is more seriously wrong,
+		   probably an inconsistency. */
+		LogCrit(COMPONENT_NFS_READDIR,
+			"cache_inode_get_keyed returned %s "
+			"for %s - bailing out",
+			cache_inode_err_str(status), dirent->name);
+		return status;
+	}
+
+	LogFullDebug(COMPONENT_NFS_READDIR,
+		     "cache_inode_readdir: dirent=%p name=%s "
+		     "cookie=%" PRIu64 " (probes %d)", dirent,
+		     dirent->name, cookie, dirent->hk.p);
+
+	cb_parms->name = dirent->name;
+	cb_parms->attr_allowed = attr_status == CACHE_INODE_SUCCESS;
+	cb_parms->cookie = cookie;
+
+	status = cache_inode_getattr(entry, cb_parms, cb, CB_ORIGINAL);
+
+	if (status != CACHE_INODE_SUCCESS) {
+		cache_inode_lru_unref(entry, LRU_FLAG_NONE);
+		if (status == CACHE_INODE_ESTALE) {
+			if (*retry_stale) {
+				LogDebug(COMPONENT_NFS_READDIR,
+					 "cache_inode_getattr returned "
+					 "%s for %s - retrying entry",
+					 cache_inode_err_str(status),
+					 dirent->name);
+				*retry_stale = false; /* only one retry
+						       * per dirent */
+				goto estale_retry;
+			}
+
+			/* Directory changed out from under us.
+			   Invalidate it, skip the name, and keep
+			   going. */
+			atomic_clear_uint32_t_bits(&directory->flags,
+						   CACHE_INODE_TRUST_CONTENT);
+
+			LogDebug(COMPONENT_NFS_READDIR,
+				 "cache_inode_lock_trust_attrs "
+				 "returned %s for %s - skipping entry",
+				 cache_inode_err_str(status), dirent->name);
+			return CACHE_INODE_SUCCESS;
+		}
+
+		LogCrit(COMPONENT_NFS_READDIR,
+			"cache_inode_lock_trust_attrs returned %s for "
+			"%s - bailing out",
+			cache_inode_err_str(status), dirent->name);
+
+		return status;
+	}
+
+	(*nbfound)++;
+
+	cache_inode_lru_unref(entry, LRU_FLAG_NONE);
+
+	return CACHE_INODE_SUCCESS;
+}
+
+/**
+ * @brief The dirent after another in its chunk
+ */
+
+static inline cache_inode_dir_entry_t *
+dir_chunk_next(cache_inode_dir_entry_t *dirent)
+{
+	if (dirent->chunk_list.next == &dirent->chunk->dirents)
+		return NULL;
+
+	return glist_entry(dirent->chunk_list.next, cache_inode_dir_entry_t,
+			   chunk_list);
+}
+
+/**
+ * @brief Read a directory a chunk at a time
+ *
+ * Serves READDIR from cached chunks, reading only the chunks that are
+ * missing or expired.  Cookies are those of the FSAL, offset by
+ * DIR_CHUNK_COOKIE_BIAS.  Called with the content lock held for read;
+ * it is upgraded to write when a chunk has to be read, and is held on
+ * return in either mode.
+ *
+ * @param[in]     directory   The directory to be read
+ * @param[in]     cookie      Starting cookie for the readdir operation
+ * @param[out]    nbfound     Number of entries returned.
+ * @param[out]    eod_met     Whether the end of directory was met
+ * @param[in]     attr_status Result of the attribute permission check
+ * @param[in]     cb          The callback function to receive entries
+ * @param[in,out] cb_parms    Callback parameters
+ *
+ * @return CACHE_INODE_SUCCESS or errors.
+ */
+
+static cache_inode_status_t
+cache_inode_readdir_chunked(cache_entry_t *directory,
+			    uint64_t cookie, unsigned int *nbfound,
+			    bool *eod_met,
+			    cache_inode_status_t attr_status,
+			    cache_inode_getattr_cb_t cb,
+			    struct cache_inode_readdir_cb_parms *cb_parms)
+{
+	cache_inode_status_t status = CACHE_INODE_SUCCESS;
+	cache_inode_dir_entry_t *dirent = NULL, *last;
+	struct dir_chunk *chunk, *prev, *bumped = NULL;
+	bool write_locked = false;
+	bool retry_stale = true;
+
+	*nbfound = 0;
+	*eod_met = false;
+
+	/* Cookies 1 and 2 are reserved by the protocols */
+	if (cookie > 0 && cookie < DIR_CHUNK_COOKIE_BIAS) {
+		LogFullDebug(COMPONENT_NFS_READDIR,
+			     "Bad cookie");
+		return CACHE_INODE_BAD_COOKIE;
+	}
+	if (cookie != 0)
+		cookie -= DIR_CHUNK_COOKIE_BIAS;
+
+ again:
+	if (!(directory->flags & CACHE_INODE_TRUST_CONTENT)) {
+		if (!write_locked)
+			goto upgrade;
+		status = cache_inode_invalidate_all_cached_dirent(directory);
+		if (status != CACHE_INODE_SUCCESS)
+			return status;
+	}
+
+	/* Find the chunk and dirent following cookie.  If the cookie is
+	 * not cached, a chunk is read from the FSAL starting after it. */
+	prev = NULL;
+	dirent = NULL;
+	if (cookie == 0) {
+		chunk = directory->object.dir.first_chunk;
+	} else {
+		last = cache_inode_avl_lookup_ck(directory, cookie);
+		chunk = last != NULL ? last->chunk : NULL;
+		if (chunk != NULL &&
+		    chunk->gen == directory->object.dir.chunk_gen) {
+			dirent = dir_chunk_next(last);
+			if (dirent == NULL) {
+				if (chunk->eod) {
+					*eod_met = true;
+					return CACHE_INODE_SUCCESS;
+				}
+				prev = chunk;
+				chunk = chunk->next;
+			}
+		}
+	}
+
+	for (;;) {
+		if (chunk != NULL &&
+		    chunk->gen != directory->object.dir.chunk_gen) {
+			/* Expired by a create, read it again */
+			if (!write_locked)
+				goto upgrade;
+			cache_inode_lru_remove_chunk(chunk, true);
+			chunk = NULL;
+			dirent = NULL;
+		}
+
+		if (chunk == NULL) {
+			if (!write_locked)
+				goto upgrade;
+			status = cache_inode_readdir_chunk_populate(directory,
+								    cookie,
+								    prev,
+								    &chunk);
+			if (status != CACHE_INODE_SUCCESS)
+				break;
+			/* A partial read that got nothing, try later */
+			if (chunk->num_entries == 0 && !chunk->eod)
+				break;
+		}
+
+		if (chunk != bumped) {
+			cache_inode_lru_bump_chunk(chunk);
+			bumped = chunk;
+		}
+
+		if (dirent == NULL)
+			dirent = glist_first_entry(&chunk->dirents,
+						   cache_inode_dir_entry_t,
+						   chunk_list);
+
+		if (dirent == NULL) {
+			/* Ran off the end of the chunk */
+			if (chunk->eod) {
+				*eod_met = true;
+				break;
+			}
+			prev = chunk;
+			chunk = chunk->next;
+			continue;
+		}
+
+		status = cache_inode_readdir_dirent(directory, dirent,
+						    dirent->ck +
+						    DIR_CHUNK_COOKIE_BIAS,
+						    attr_status,
+						    cb, cb_parms, nbfound,
+						    &retry_stale);
+		if (status != CACHE_INODE_SUCCESS)
+			break;
+
+		if (!cb_parms->in_result) {
+			LogDebug(COMPONENT_NFS_READDIR,
+				 "bailing out due to entry not in result");
+			break;
+		}
+
+		cookie = dirent->ck;
+		dirent = dir_chunk_next(dirent);
+		if (dirent == NULL) {
+			if (chunk->eod) {
+				*eod_met = true;
+				break;
+			}
+			prev = chunk;
+			chunk = chunk->next;
+		}
+	}
+
+	return status;
+
+ upgrade:
+	/* Start over from the last cookie handed out */
+	PTHREAD_RWLOCK_unlock(&directory->content_lock);
+	PTHREAD_RWLOCK_wrlock(&directory->content_lock);
+	write_locked = true;
+	goto again;
+}
+
 /**
  * @brief Reads a directory
  *
  * This function iterates over the cached directory entries (possibly
  * after populating the cache) and invokes a supplied callback
- * function for each one.
+ * function for each one.  With Dir_Chunk set, only the chunks the
+ * request reaches are read and the cookies are the FSAL's.
  *
  * The caller must not hold the attribute or content locks on
  * directory.
@@ -642,6 +1215,15 @@ cache_inode_readdir(cache_entry_t *directory,
 
 	PTHREAD_RWLOCK_rdlock(&directory->content_lock);
 	PTHREAD_RWLOCK_unlock(&directory->attr_lock);
+
+	if (cache_param.dir_chunk != 0) {
+		status = cache_inode_readdir_chunked(directory, cookie,
+						     nbfound, eod_met,
+						     attr_status, cb,
+						     &cb_parms);
+		goto unlock_dir;
+	}
+
 	if (!
 	    ((directory->flags & CACHE_INODE_TRUST_CONTENT)
 	     && (directory->flags & CACHE_INODE_DIR_POPULATED))) {
@@ -719,120 +1301,16 @@ cache_inode_readdir(cache_entry_t *directory,
 
 	for (; cb_parms.in_result && dirent_node;
 	     dirent_node = avltree_next(dirent_node)) {
-
-		cache_entry_t *entry = NULL;
-		cache_inode_status_t tmp_status = 0;
-
 		dirent =
 		    avltree_container_of(dirent_node, cache_inode_dir_entry_t,
 					 node_hk);
 
- estale_retry:
-		LogFullDebug(COMPONENT_NFS_READDIR,
-			     "Lookup direct %s",
-			     dirent->name);
-
-		entry =
-		    cache_inode_get_keyed(&dirent->ckey,
-					  CIG_KEYED_FLAG_NONE, &tmp_status);
-		if (!entry) {
-			LogFullDebug(COMPONENT_NFS_READDIR,
-				     "Lookup returned %s",
-				     cache_inode_err_str(tmp_status));
-
-			if (retry_stale
-			    && tmp_status == CACHE_INODE_ESTALE) {
-				LogDebug(COMPONENT_NFS_READDIR,
-					 "cache_inode_get_keyed returned %s "
-					 "for %s - retrying entry",
-					 cache_inode_err_str(tmp_status),
-					 dirent->name);
-				retry_stale = false; /* only one retry per
-						      * dirent */
-				goto estale_retry;
-			}
-
-			if (tmp_status == CACHE_INODE_NOT_FOUND
-			    || tmp_status == CACHE_INODE_ESTALE) {
-				/* Directory changed out from under us.
-				   Invalidate it, skip the name, and keep
-				   going. */
-				atomic_clear_uint32_t_bits(
-					&directory->flags,
-					CACHE_INODE_TRUST_CONTENT);
-				LogDebug(COMPONENT_NFS_READDIR,
-					 "cache_inode_get_keyed returned %s "
-					 "for %s - skipping entry",
-					 cache_inode_err_str(tmp_status),
-					 dirent->name);
-				continue;
-			} else {
-				/* Something is more seriously wrong,
-				   probably an inconsistency. */
-				status = tmp_status;
-				LogCrit(COMPONENT_NFS_READDIR,
-					"cache_inode_get_keyed returned %s "
-					"for %s - bailing out",
-					cache_inode_err_str(status),
-					dirent->name);
-				goto unlock_dir;
-			}
-		}
-
-		LogFullDebug(COMPONENT_NFS_READDIR,
-			     "cache_inode_readdir: dirent=%p name=%s "
-			     "cookie=%" PRIu64 " (probes %d)", dirent,
-			     dirent->name, dirent->hk.k, dirent->hk.p);
-
-		cb_parms.name = dirent->name;
-		cb_parms.attr_allowed = attr_status == CACHE_INODE_SUCCESS;
-		cb_parms.cookie = dirent->hk.k;
-
-		tmp_status =
-		    cache_inode_getattr(entry, &cb_parms, cb, CB_ORIGINAL);
-
-		if (tmp_status != CACHE_INODE_SUCCESS) {
-			cache_inode_lru_unref(entry, LRU_FLAG_NONE);
-			if (tmp_status == CACHE_INODE_ESTALE) {
-				if (retry_stale) {
-					LogDebug(COMPONENT_NFS_READDIR,
-						 "cache_inode_getattr returned "
-						 "%s for %s - retrying entry",
-						 cache_inode_err_str
-						 (tmp_status), dirent->name);
-					retry_stale = false; /* only one retry
-							      * per dirent */
-					goto estale_retry;
-				}
-
-				/* Directory changed out from under us.
-				   Invalidate it, skip the name, and keep
-				   going. */
-				atomic_clear_uint32_t_bits(
-					&directory->flags,
-					CACHE_INODE_TRUST_CONTENT);
-
-				LogDebug(COMPONENT_NFS_READDIR,
-					 "cache_inode_lock_trust_attrs "
-					 "returned %s for %s - skipping entry",
-					 cache_inode_err_str(tmp_status),
-					 dirent->name);
-				continue;
-			}
-
-			status = tmp_status;
-
-			LogCrit(COMPONENT_NFS_READDIR,
-				"cache_inode_lock_trust_attrs returned %s for "
-				"%s - bailing out",
-				cache_inode_err_str(status), dirent->name);
-
+		status = cache_inode_readdir_dirent(directory, dirent,
+						    dirent->hk.k, attr_status,
+						    cb, &cb_parms, nbfound,
+						    &retry_stale);
+		if (status != CACHE_INODE_SUCCESS)
 			goto unlock_dir;
-		}
-
-		(*nbfound)++;
-
-		cache_inode_lru_unref(entry, LRU_FLAG_NONE);
 
 		if (!cb_parms.in_result) {
 			LogDebug(COMPONENT_NFS_READDIR,
@@ -67,6 +67,7 @@ cache_inode_readlink(cache_entry_t *entry,
 	cache_inode_status_t status = CACHE_INODE_SUCCESS;
 	fsal_status_t fsal_status = { ERR_FSAL_NO_ERROR, 0 };
 	bool refresh = false;
+	nsecs_elapsed_t fsal_start;
 
 	if (entry->type != SYMBOLIC_LINK) {
 		status = CACHE_INODE_BAD_TYPE;
@@ -84,9 +85,11 @@ cache_inode_readlink(cache_entry_t *entry,
 		   waiting. */
 		refresh = !(entry->flags & CACHE_INODE_TRUST_CONTENT);
 	}
+	fsal_start = server_stats_clock();
 	fsal_status =
 	    entry->obj_handle->obj_ops.readlink(entry->obj_handle,
 					     link_content, refresh);
+	server_stats_fsal_done(FSAL_LAT_READLINK, fsal_start);
 	if (refresh && !(FSAL_IS_ERROR(fsal_status)))
 		atomic_set_uint32_t_bits(&entry->flags,
 					 CACHE_INODE_TRUST_CONTENT);
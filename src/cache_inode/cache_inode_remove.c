@@ -74,6 +74,7 @@ cache_inode_remove(cache_entry_t *entry, const char *name)
 	fsal_status_t fsal_status = { 0, 0 };
 	cache_inode_status_t status = CACHE_INODE_SUCCESS;
 	cache_inode_status_t status_ref_entry = CACHE_INODE_SUCCESS;
+	nsecs_elapsed_t fsal_start;
 
 	if (entry->type != DIRECTORY) {
 		status = CACHE_INODE_NOT_A_DIRECTORY;
@@ -136,8 +137,10 @@ cache_inode_remove(cache_entry_t *entry, const char *name)
 		}
 	}
 
+	fsal_start = server_stats_clock();
 	fsal_status =
 	    entry->obj_handle->obj_ops.unlink(entry->obj_handle, name);
+	server_stats_fsal_done(FSAL_LAT_UNLINK, fsal_start);
 
 	if (FSAL_IS_ERROR(fsal_status)) {
 		if (fsal_status.major == ERR_FSAL_STALE)
@@ -197,6 +197,7 @@ cache_inode_rename(cache_entry_t *dir_src,
 	cache_inode_status_t status_ref_dir_src = CACHE_INODE_SUCCESS;
 	cache_inode_status_t status_ref_dir_dst = CACHE_INODE_SUCCESS;
 	cache_inode_status_t status_ref_dst = CACHE_INODE_SUCCESS;
+	nsecs_elapsed_t fsal_start;
 
 	if ((dir_src->type != DIRECTORY) || (dir_dest->type != DIRECTORY)) {
 		status = CACHE_INODE_NOT_A_DIRECTORY;
@@ -290,10 +291,12 @@ cache_inode_rename(cache_entry_t *dir_src,
 	 */
 	LogFullDebug(COMPONENT_CACHE_INODE, "about to call FSAL rename");
 
+	fsal_start = server_stats_clock();
 	fsal_status =
 	    dir_src->obj_handle->obj_ops.rename(dir_src->obj_handle,
 					     oldname, dir_dest->obj_handle,
 					     newname);
+	server_stats_fsal_done(FSAL_LAT_RENAME, fsal_start);
 
 	LogFullDebug(COMPONENT_CACHE_INODE, "returned from FSAL rename");
 
@@ -341,6 +344,9 @@ cache_inode_rename(cache_entry_t *dir_src,
 	 */
 	src_dest_lock(dir_src, dir_dest);
 
+	/* newname is a new name in dir_dest */
+	cache_inode_expire_dir_chunks(dir_dest);
+
 	if (lookup_dst) {
 		/* Remove the entry from parent dir_entries avl */
 		status_ref_dir_dst =
@@ -66,6 +66,7 @@ cache_inode_setattr(cache_entry_t *entry,
 	fsal_acl_status_t acl_status = 0;
 	cache_inode_status_t status = CACHE_INODE_SUCCESS;
 	uint64_t before;
+	nsecs_elapsed_t fsal_start;
 
 	/* True if we have taken the content lock on 'entry' */
 	bool content_locked = false;
@@ -107,7 +108,9 @@ cache_inode_setattr(cache_entry_t *entry,
 
 	saved_acl = obj_handle->attributes.acl;
 	before = obj_handle->attributes.change;
+	fsal_start = server_stats_clock();
 	fsal_status = obj_handle->obj_ops.setattrs(obj_handle, attr);
+	server_stats_fsal_done(FSAL_LAT_SETATTRS, fsal_start);
 	if (FSAL_IS_ERROR(fsal_status)) {
 		status = cache_inode_error_convert(fsal_status);
 		if (fsal_status.major == ERR_FSAL_STALE) {
@@ -117,7 +120,9 @@ cache_inode_setattr(cache_entry_t *entry,
 		}
 		goto unlock;
 	}
+	fsal_start = server_stats_clock();
 	fsal_status = obj_handle->obj_ops.getattrs(obj_handle);
+	server_stats_fsal_done(FSAL_LAT_GETATTRS, fsal_start);
 	*attr = obj_handle->attributes;
 	if (FSAL_IS_ERROR(fsal_status)) {
 		status = cache_inode_error_convert(fsal_status);
@@ -39,6 +39,19 @@
  * determines which of the partitions (each containing a tree and each
  * separately locked), and a hash which acts as the key within an
  * individual Red-Black Tree.
+ *
+ * Tables created with HT_FLAG_OPEN_ADDR keep the same partitions and
+ * locks, but store each partition's entries in a linearly probed
+ * array instead of a tree.  Entries live in the array itself, so
+ * inserts allocate nothing, and deletion shifts later entries back
+ * rather than leaving tombstones.  Writers bump a per-partition
+ * sequence count around every change, which lets unlatched lookups
+ * (HashTable_Get) run without taking the partition lock.  Such
+ * lookups only compare against the copy of the key kept in the slot,
+ * since the key's own buffer may be freed as soon as it is removed.
+ * Keys longer than the table's oa_key_len are not copied, and are
+ * looked up under the lock.  Latched lookups, such as those that take
+ * a reference on what they find, always lock.
  */
 
 #include "config.h"
@@ -50,6 +63,7 @@
 #include "log.h"
 #include "abstract_atomic.h"
 #include "common_utils.h"
+#include "gsh_slab.h"
 #include <assert.h>
 
 /**
@@ -271,6 +285,398 @@ compute(struct hash_table *ht, const struct gsh_buffdesc *key,
 	return HASHTABLE_SUCCESS;
 }
 
+/**
+ * @brief Initial number of slots in an open addressed partition
+ */
+#define HASH_OA_MIN_SLOTS 16
+
+/**
+ * @brief Whether a table is open addressed
+ *
+ * @param[in] ht The hash table
+ *
+ * @return true if the table was created with HT_FLAG_OPEN_ADDR.
+ */
+static inline bool
+ht_open_addr(const struct hash_table *ht)
+{
+	return (ht->parameter.flags & HT_FLAG_OPEN_ADDR) != 0;
+}
+
+/**
+ * @brief First slot to probe for a hash
+ *
+ * The partition index is usually derived from the same hash, so the
+ * hash is mixed before its bits are used.
+ *
+ * @param[in] slots The slot array
+ * @param[in] hash  The hash
+ *
+ * @return The slot index.
+ */
+static inline uint32_t
+oa_home(const struct hash_slots *slots, uint64_t hash)
+{
+	return (uint32_t) ((hash * 0x9e3779b97f4a7c15ULL) >> 32) &
+	    slots->mask;
+}
+
+/**
+ * @brief A slot of an open addressed partition
+ *
+ * @param[in] slots The slot array
+ * @param[in] i     Index of the slot
+ *
+ * @return The slot.
+ */
+static inline struct hash_slot *
+oa_slot(const struct hash_slots *slots, uint32_t i)
+{
+	return (struct hash_slot *)(slots->slot_mem +
+				    (size_t) i * slots->stride);
+}
+
+/**
+ * @brief Bytes per slot in a table's slot arrays
+ *
+ * @param[in] ht The hash table
+ *
+ * @return The slot header and room for oa_key_len bytes, rounded up
+ *         to keep slots aligned.
+ */
+static inline uint32_t
+oa_stride(const struct hash_table *ht)
+{
+	return (sizeof(struct hash_slot) + ht->parameter.oa_key_len + 7) &
+	    ~7U;
+}
+
+/**
+ * @brief Allocate an empty slot array
+ *
+ * @param[in] nslots Number of slots, a power of 2
+ * @param[in] stride Bytes per slot
+ *
+ * @return The array or NULL.
+ */
+static struct hash_slots *
+oa_alloc(uint32_t nslots, uint32_t stride)
+{
+	struct hash_slots *slots;
+
+	slots = gsh_calloc(1, sizeof(struct hash_slots) +
+			   (size_t) nslots * stride);
+	if (slots != NULL) {
+		slots->mask = nslots - 1;
+		slots->stride = stride;
+	}
+
+	return slots;
+}
+
+/**
+ * @brief Free a slot array and all the arrays it replaced
+ *
+ * @param[in] slots The array
+ */
+static void
+oa_free(struct hash_slots *slots)
+{
+	struct hash_slots *retired;
+
+	while (slots != NULL) {
+		retired = slots->retired;
+		gsh_free(slots);
+		slots = retired;
+	}
+}
+
+/**
+ * @brief Mark the start of a change to a partition's slots
+ *
+ * @param[in] partition The partition, write locked
+ */
+static inline void
+oa_write_begin(struct hash_partition *partition)
+{
+	atomic_inc_uint32_t(&partition->seq);
+}
+
+/**
+ * @brief Mark the end of a change to a partition's slots
+ *
+ * @param[in] partition The partition, write locked
+ */
+static inline void
+oa_write_end(struct hash_partition *partition)
+{
+	atomic_inc_uint32_t(&partition->seq);
+}
+
+/**
+ * @brief Store a key in a slot, copying it if it is short enough
+ *
+ * @param[in]  ht   The hash table
+ * @param[out] slot The slot, inside a write section
+ * @param[in]  key  The key
+ */
+static inline void
+oa_set_key(struct hash_table *ht, struct hash_slot *slot,
+	   const struct gsh_buffdesc *key)
+{
+	slot->key = *key;
+	if (key->len <= ht->parameter.oa_key_len)
+		memcpy(slot->key_copy, key->addr, key->len);
+}
+
+/**
+ * @brief Locate a key in a locked open addressed partition
+ *
+ * @param[in] ht    The hash table
+ * @param[in] slots The partition's slots
+ * @param[in] key   The key to look up
+ * @param[in] hash  Its red-black hash
+ *
+ * @return The slot holding the key or -1.
+ */
+static int32_t
+oa_locate(struct hash_table *ht, struct hash_slots *slots,
+	  const struct gsh_buffdesc *key, uint64_t hash)
+{
+	uint32_t i = oa_home(slots, hash);
+	struct hash_slot *slot;
+
+	/* The load factor guarantees a free slot ends every probe */
+	for (;;) {
+		slot = oa_slot(slots, i);
+		if (slot->key.addr == NULL)
+			return -1;
+		if (slot->hash == hash &&
+		    ht->parameter.compare_key((struct gsh_buffdesc *)key,
+					      &slot->key) == 0)
+			return i;
+		i = (i + 1) & slots->mask;
+	}
+}
+
+/**
+ * @brief Look up a key without locking its partition
+ *
+ * Each slot's header is copied and used only once the partition's
+ * sequence count shows no writer changed anything since the probe
+ * started.  Otherwise the probe is restarted.  Keys are compared
+ * against the slot's key_copy, never through its key address, and
+ * the comparison only counts if the sequence count is still the
+ * same afterwards.  Slot arrays are not freed while the table lives,
+ * so a torn key_copy is harmless.  A candidate whose key was too
+ * long to copy cannot be checked that way, and the caller has to
+ * look again under the partition lock.
+ *
+ * @param[in]  ht        The hash table
+ * @param[in]  partition The partition to search
+ * @param[in]  key       The key to look up
+ * @param[in]  hash      Its red-black hash
+ * @param[out] val       If non-NULL, the value found
+ *
+ * @retval HASHTABLE_SUCCESS if the key was found.
+ * @retval HASHTABLE_ERROR_NO_SUCH_KEY if it was not.
+ * @retval HASHTABLE_ERROR_INVALID_ARGUMENT if the lock is needed.
+ */
+static hash_error_t
+oa_get_lockless(struct hash_table *ht, struct hash_partition *partition,
+		const struct gsh_buffdesc *key, uint64_t hash,
+		struct gsh_buffdesc *val)
+{
+	struct hash_slots *slots;
+	struct hash_slot *slot;
+	struct hash_slot copy;
+	struct gsh_buffdesc copy_key;
+	uint32_t seq;
+	uint32_t i;
+	int cmp;
+
+ retry:
+	seq = atomic_fetch_uint32_t(&partition->seq);
+	if (seq & 1)
+		goto retry;
+
+	slots = atomic_fetch_voidptr((void **)&partition->slots);
+	i = oa_home(slots, hash);
+
+	for (;;) {
+		slot = oa_slot(slots, i);
+		copy = *slot;
+		atomic_thread_fence_seq_cst();
+		if (atomic_fetch_uint32_t(&partition->seq) != seq)
+			goto retry;
+
+		if (copy.key.addr == NULL)
+			return HASHTABLE_ERROR_NO_SUCH_KEY;
+
+		if (copy.hash == hash) {
+			if (copy.key.len > ht->parameter.oa_key_len)
+				return HASHTABLE_ERROR_INVALID_ARGUMENT;
+			copy_key.addr = slot->key_copy;
+			copy_key.len = copy.key.len;
+			cmp = ht->parameter.compare_key(
+				(struct gsh_buffdesc *)key, &copy_key);
+			atomic_thread_fence_seq_cst();
+			if (atomic_fetch_uint32_t(&partition->seq) != seq)
+				goto retry;
+			if (cmp == 0) {
+				if (val != NULL)
+					*val = copy.val;
+				return HASHTABLE_SUCCESS;
+			}
+		}
+
+		i = (i + 1) & slots->mask;
+	}
+}
+
+/**
+ * @brief Double the slot array of a locked partition
+ *
+ * The old array is left as it is for readers still probing it.
+ *
+ * @param[in] partition The partition, write locked
+ *
+ * @return The new array or NULL if it could not be allocated.
+ */
+static struct hash_slots *
+oa_grow(struct hash_partition *partition)
+{
+	struct hash_slots *old = partition->slots;
+	struct hash_slots *slots;
+	uint32_t i, j;
+
+	slots = oa_alloc((old->mask + 1) * 2, old->stride);
+	if (slots == NULL)
+		return NULL;
+
+	for (i = 0; i <= old->mask; i++) {
+		if (oa_slot(old, i)->key.addr == NULL)
+			continue;
+		j = oa_home(slots, oa_slot(old, i)->hash);
+		while (oa_slot(slots, j)->key.addr != NULL)
+			j = (j + 1) & slots->mask;
+		memcpy(oa_slot(slots, j), oa_slot(old, i), slots->stride);
+	}
+
+	slots->retired = old;
+
+	/* Readers that already hold the old array see the same entries
+	   there, so only publication needs to be ordered. */
+	atomic_store_voidptr((void **)&partition->slots, slots);
+
+	return slots;
+}
+
+/**
+ * @brief Insert or overwrite in a locked open addressed partition
+ *
+ * @param[in,out] ht         The hash table
+ * @param[in]     key        The key
+ * @param[in]     val        The value
+ * @param[in]     latch      Latch from hashtable_getlatch
+ * @param[in]     overwrite  Whether to replace an existing entry
+ * @param[out]    stored_key If non-NULL, the replaced key
+ * @param[out]    stored_val If non-NULL, the replaced value
+ *
+ * @return As hashtable_setlatched.
+ */
+static hash_error_t
+oa_setlatched(struct hash_table *ht, struct gsh_buffdesc *key,
+	      struct gsh_buffdesc *val, struct hash_latch *latch,
+	      int overwrite, struct gsh_buffdesc *stored_key,
+	      struct gsh_buffdesc *stored_val)
+{
+	struct hash_partition *partition = &ht->partitions[latch->index];
+	struct hash_slots *slots = partition->slots;
+	struct hash_slot *slot;
+	uint32_t i;
+
+	if (latch->slot >= 0) {
+		if (!overwrite)
+			return HASHTABLE_ERROR_KEY_ALREADY_EXISTS;
+
+		slot = oa_slot(slots, latch->slot);
+		if (stored_key)
+			*stored_key = slot->key;
+		if (stored_val)
+			*stored_val = slot->val;
+
+		oa_write_begin(partition);
+		oa_set_key(ht, slot, key);
+		slot->val = *val;
+		oa_write_end(partition);
+		return HASHTABLE_OVERWRITTEN;
+	}
+
+	/* Keep the load factor at or below 3/4 */
+	if ((partition->count + 1) * 4 > (size_t) (slots->mask + 1) * 3) {
+		slots = oa_grow(partition);
+		if (slots == NULL)
+			return HASHTABLE_INSERT_MALLOC_ERROR;
+	}
+
+	i = oa_home(slots, latch->rbt_hash);
+	while (oa_slot(slots, i)->key.addr != NULL)
+		i = (i + 1) & slots->mask;
+	slot = oa_slot(slots, i);
+
+	oa_write_begin(partition);
+	slot->hash = latch->rbt_hash;
+	slot->val = *val;
+	oa_set_key(ht, slot, key);
+	oa_write_end(partition);
+
+	++partition->count;
+	return HASHTABLE_SUCCESS;
+}
+
+/**
+ * @brief Remove the entry in a slot of a locked partition
+ *
+ * Later entries of the same probe run are shifted back so no
+ * tombstone is needed.
+ *
+ * @param[in] partition The partition, write locked
+ * @param[in] hole      The slot to empty
+ */
+static void
+oa_delete(struct hash_partition *partition, uint32_t hole)
+{
+	struct hash_slots *slots = partition->slots;
+	uint32_t j = hole;
+	uint32_t home;
+
+	oa_write_begin(partition);
+
+	for (;;) {
+		j = (j + 1) & slots->mask;
+		if (oa_slot(slots, j)->key.addr == NULL)
+			break;
+
+		/* An entry whose home lies cyclically in (hole, j] is
+		   still reachable and stays put. */
+		home = oa_home(slots, oa_slot(slots, j)->hash);
+		if (hole <= j ? (hole < home && home <= j)
+			      : (hole < home || home <= j))
+			continue;
+
+		memcpy(oa_slot(slots, hole), oa_slot(slots, j),
+		       slots->stride);
+		hole = j;
+	}
+
+	memset(oa_slot(slots, hole), 0, slots->stride);
+
+	oa_write_end(partition);
+
+	--partition->count;
+}
+
 /* The following are the hash table primitives implementing the
    actual functionality. */
 
@@ -331,6 +737,8 @@ hashtable_init(struct hash_param *hparam)
 
 	/* We need to save copy of the parameters in the table. */
 	ht->parameter = *hparam;
+	if (ht->parameter.oa_key_len == 0)
+		ht->parameter.oa_key_len = HASH_OA_INLINE_KEY;
 	for (index = 0; index < hparam->index_size; ++index) {
 		partition = (&ht->partitions[index]);
 		RBT_HEAD_INIT(&(partition->rbt));
@@ -341,8 +749,15 @@ hashtable_init(struct hash_param *hparam)
 			goto deconstruct;
 		}
 
-		/* Allocate a cache if requested */
-		if (hparam->flags & HT_FLAG_CACHE) {
+		if (hparam->flags & HT_FLAG_OPEN_ADDR) {
+			partition->slots = oa_alloc(HASH_OA_MIN_SLOTS,
+						    oa_stride(ht));
+			if (partition->slots == NULL) {
+				PTHREAD_RWLOCK_destroy(&partition->lock);
+				goto deconstruct;
+			}
+		} else if (hparam->flags & HT_FLAG_CACHE) {
+			/* Allocate a cache if requested */
 			partition->cache = gsh_calloc(1, cache_page_size(ht));
 			if (!(partition->cache)) {
 				PTHREAD_RWLOCK_destroy(&partition->lock);
@@ -352,26 +767,31 @@ hashtable_init(struct hash_param *hparam)
 		completed++;
 	}
 
+	/* Open addressed tables keep entries in their slots */
+	if (hparam->flags & HT_FLAG_OPEN_ADDR)
+		goto out;
+
 	ht->node_pool =
-	    pool_init(NULL, sizeof(rbt_node_t), pool_basic_substrate, NULL,
-		      NULL, NULL);
+	    pool_init(hparam->ht_name, sizeof(rbt_node_t),
+		      pool_slab_substrate, NULL, NULL, NULL);
 	if (!(ht->node_pool))
 		goto deconstruct;
 
 	ht->data_pool =
-	    pool_init(NULL, sizeof(struct hash_data), pool_basic_substrate,
-		      NULL, NULL, NULL);
+	    pool_init(hparam->ht_name, sizeof(struct hash_data),
+		      pool_slab_substrate, NULL, NULL, NULL);
 	if (!(ht->data_pool))
 		goto deconstruct;
 
+ out:
 	pthread_rwlockattr_destroy(&rwlockattr);
 	return ht;
 
  deconstruct:
 
 	while (completed != 0) {
-		if (hparam->flags & HT_FLAG_CACHE)
-			gsh_free(ht->partitions[completed - 1].cache);
+		gsh_free(ht->partitions[completed - 1].cache);
+		oa_free(ht->partitions[completed - 1].slots);
 
 		PTHREAD_RWLOCK_destroy(&(ht->partitions[completed - 1].lock));
 		completed--;
@@ -417,10 +837,13 @@ hashtable_destroy(struct hash_table *ht,
 			ht->partitions[index].cache = NULL;
 		}
 
+		oa_free(ht->partitions[index].slots);
 		PTHREAD_RWLOCK_destroy(&(ht->partitions[index].lock));
 	}
-	pool_destroy(ht->node_pool);
-	pool_destroy(ht->data_pool);
+	if (ht->node_pool)
+		pool_destroy(ht->node_pool);
+	if (ht->data_pool)
+		pool_destroy(ht->data_pool);
 	gsh_free(ht);
 
  out:
@@ -459,8 +882,10 @@ hashtable_getlatch(struct hash_table *ht,
 	uint32_t index = 0;
 	/* The node found for the key */
 	struct rbt_node *locator = NULL;
-	/* The buffer descritpros for the key and value for the found entry */
-	struct hash_data *data = NULL;
+	/* The slot found for the key, if open addressed */
+	int32_t slot = -1;
+	/* The buffer descriptor for the value of the found entry */
+	struct gsh_buffdesc *found = NULL;
 	/* The hash value to be searched for within the Red-Black tree */
 	uint64_t rbt_hash = 0;
 	/* Stored error return */
@@ -473,20 +898,42 @@ hashtable_getlatch(struct hash_table *ht,
 	if (rc != HASHTABLE_SUCCESS)
 		return rc;
 
+	/* Nothing is held after an unlatched lookup, so an open
+	   addressed table needs no lock for it, unless its keys are
+	   too long to have been copied into their slots. */
+	if (ht_open_addr(ht) && latch == NULL) {
+		rc = oa_get_lockless(ht, &ht->partitions[index], key,
+				     rbt_hash, val);
+		if (rc != HASHTABLE_ERROR_INVALID_ARGUMENT)
+			return rc;
+		rc = HASHTABLE_SUCCESS;
+	}
+
 	/* Acquire mutex */
 	if (may_write)
 		PTHREAD_RWLOCK_wrlock(&(ht->partitions[index].lock));
 	else
 		PTHREAD_RWLOCK_rdlock(&(ht->partitions[index].lock));
 
-	rc = key_locate(ht, key, index, rbt_hash, &locator);
+	if (ht_open_addr(ht)) {
+		struct hash_slots *slots = ht->partitions[index].slots;
+
+		slot = oa_locate(ht, slots, key, rbt_hash);
+		if (slot >= 0)
+			found = &oa_slot(slots, slot)->val;
+		else
+			rc = HASHTABLE_ERROR_NO_SUCH_KEY;
+	} else {
+		rc = key_locate(ht, key, index, rbt_hash, &locator);
+		if (rc == HASHTABLE_SUCCESS)
+			found = &((struct hash_data *)RBT_OPAQ(locator))->val;
+	}
 
 	if (rc == HASHTABLE_SUCCESS) {
 		/* Key was found */
-		data = RBT_OPAQ(locator);
 		if (val) {
-			val->addr = data->val.addr;
-			val->len = data->val.len;
+			val->addr = found->addr;
+			val->len = found->len;
 		}
 
 		if (isDebug(COMPONENT_HASHTABLE)
@@ -494,13 +941,13 @@ hashtable_getlatch(struct hash_table *ht,
 			char dispval[HASHTABLE_DISPLAY_STRLEN];
 
 			if (ht->parameter.val_to_str != NULL)
-				ht->parameter.val_to_str(&data->val, dispval);
+				ht->parameter.val_to_str(found, dispval);
 			else
 				dispval[0] = '\0';
 
 			LogFullDebug(ht->parameter.ht_log_component,
 				     "Get %s returning Value=%p {%s}",
-				     ht->parameter.ht_name, data->val.addr,
+				     ht->parameter.ht_name, found->addr,
 				     dispval);
 		}
 	}
@@ -510,6 +957,7 @@ hashtable_getlatch(struct hash_table *ht,
 		latch->index = index;
 		latch->rbt_hash = rbt_hash;
 		latch->locator = locator;
+		latch->slot = slot;
 	} else {
 		PTHREAD_RWLOCK_unlock(&ht->partitions[index].lock);
 	}
@@ -612,6 +1060,12 @@ hashtable_setlatched(struct hash_table *ht,
 			     latch->index, latch->rbt_hash);
 	}
 
+	if (ht_open_addr(ht)) {
+		rc = oa_setlatched(ht, key, val, latch, overwrite, stored_key,
+				   stored_val);
+		goto out;
+	}
+
 	/* In the case of collision */
 	if (latch->locator) {
 		if (!overwrite) {
@@ -737,6 +1191,30 @@ hashtable_deletelatched(struct hash_table *ht,
 	/* Its partition */
 	struct hash_partition *partition = &ht->partitions[latch->index];
 
+	if (ht_open_addr(ht)) {
+		if (latch->slot >= 0) {
+			struct hash_slot *slot =
+			    oa_slot(partition->slots, latch->slot);
+
+			LogFullDebug(ht->parameter.ht_log_component,
+				     "Delete %s Key=%p Value=%p index=%" PRIu32
+				     " slot=%" PRIi32 " was removed",
+				     ht->parameter.ht_name, slot->key.addr,
+				     slot->val.addr, latch->index,
+				     latch->slot);
+
+			if (stored_key)
+				*stored_key = slot->key;
+
+			if (stored_val)
+				*stored_val = slot->val;
+
+			oa_delete(partition, latch->slot);
+		}
+		hashtable_releaselatched(ht, latch);
+		return HASHTABLE_SUCCESS;
+	}
+
 	if (!latch->locator) {
 		hashtable_releaselatched(ht, latch);
 		return HASHTABLE_SUCCESS;
@@ -807,6 +1285,40 @@ hashtable_deletelatched(struct hash_table *ht,
 	return HASHTABLE_SUCCESS;
 }
 
+/**
+ * @brief Remove and free all entries of a locked open addressed partition
+ *
+ * @param[in,out] partition The partition, write locked
+ * @param[in]     free_func The function with which to free each entry
+ *
+ * @return false if free_func failed.
+ */
+static bool
+oa_delall(struct hash_partition *partition,
+	  int (*free_func)(struct gsh_buffdesc, struct gsh_buffdesc))
+{
+	struct hash_slots *slots = partition->slots;
+	struct hash_slot removed;
+	uint32_t i = 0;
+
+	while (i <= slots->mask) {
+		if (oa_slot(slots, i)->key.addr == NULL) {
+			i++;
+			continue;
+		}
+
+		/* Deleting may shift another entry into slot i, so look
+		   at it again. */
+		removed = *oa_slot(slots, i);
+		oa_delete(partition, i);
+
+		if (free_func(removed.key, removed.val) == 0)
+			return false;
+	}
+
+	return true;
+}
+
 /**
  * @brief Remove and free all (key,val) couples from the hash store
  *
@@ -835,6 +1347,14 @@ hashtable_delall(struct hash_table *ht,
 
 		PTHREAD_RWLOCK_wrlock(&ht->partitions[index].lock);
 
+		if (ht_open_addr(ht)) {
+			if (!oa_delall(&ht->partitions[index], free_func)) {
+				PTHREAD_RWLOCK_unlock(&ht->partitions[index].
+						      lock);
+				return HASHTABLE_ERROR_DELALL_FAIL;
+			}
+		}
+
 		/* Continue until there are no more entries in the red-black
 		   tree */
 		while ((cursor = RBT_LEFTMOST(root)) != NULL) {
@@ -875,6 +1395,62 @@ hashtable_delall(struct hash_table *ht,
 	return HASHTABLE_SUCCESS;
 }
 
+/**
+ * @brief Call a function on every entry in the table
+ *
+ * Each partition is read locked while it is walked, so the callback
+ * must not modify the table.  This works for both the red-black tree
+ * and the open addressed backends and is the only supported way to
+ * iterate a table from outside this file.
+ *
+ * @param[in] ht  The hash table to walk
+ * @param[in] cb  Function called with each key, value and @c arg.
+ *                Returning false stops the walk.
+ * @param[in] arg Argument passed through to @c cb
+ */
+
+void hashtable_for_each(struct hash_table *ht,
+			bool (*cb)(struct gsh_buffdesc *key,
+				   struct gsh_buffdesc *val,
+				   void *arg),
+			void *arg)
+{
+	uint32_t i;
+	uint32_t j;
+	struct rbt_node *it;
+	struct hash_data *data;
+	bool more = true;
+
+	for (i = 0; i < ht->parameter.index_size && more; i++) {
+		struct hash_partition *partition = &ht->partitions[i];
+
+		PTHREAD_RWLOCK_rdlock(&partition->lock);
+
+		if (ht_open_addr(ht)) {
+			struct hash_slots *slots = partition->slots;
+
+			for (j = 0; j <= slots->mask && more; j++) {
+				struct hash_slot *slot = oa_slot(slots, j);
+
+				if (slot->key.addr == NULL)
+					continue;
+
+				more = cb(&slot->key, &slot->val, arg);
+			}
+		} else {
+			RBT_LOOP(&partition->rbt, it) {
+				data = RBT_OPAQ(it);
+				RBT_INCREMENT(it);
+				more = cb(&data->key, &data->val, arg);
+				if (!more)
+					break;
+			}
+		}
+
+		PTHREAD_RWLOCK_unlock(&partition->lock);
+	}
+}
+
 /**
  * @brief Log information about the hashtable
  *
@@ -915,7 +1491,31 @@ hashtable_log(log_components_t component, struct hash_table *ht)
 
 	LogFullDebug(component, "The hash contains %zd entries", nb_entries);
 
-	for (i = 0; i < ht->parameter.index_size; i++) {
+	for (i = 0; i < ht->parameter.index_size && ht_open_addr(ht); i++) {
+		struct hash_slots *slots = ht->partitions[i].slots;
+		uint32_t j;
+
+		LogFullDebug(component,
+			     "The partition in position %" PRIu32
+			     " contains: %zu entries in %" PRIu32 " slots",
+			     i, ht->partitions[i].count, slots->mask + 1);
+
+		for (j = 0; j <= slots->mask; j++) {
+			struct hash_slot *slot = oa_slot(slots, j);
+
+			if (slot->key.addr == NULL)
+				continue;
+
+			ht->parameter.key_to_str(&slot->key, dispkey);
+			ht->parameter.val_to_str(&slot->val, dispval);
+
+			LogFullDebug(component,
+				     "%s => %s; index=%" PRIu32 " slot=%"
+				     PRIu32, dispkey, dispval, i, j);
+		}
+	}
+
+	for (i = 0; i < ht->parameter.index_size && !ht_open_addr(ht); i++) {
 		root = &ht->partitions[i].rbt;
 		LogFullDebug(component,
 			     "The partition in position %" PRIu32
@@ -54,9 +54,6 @@
 
 #define _9P_FID_PER_CONN        1024
 
-/* _9P_MSG_SIZE: maximum message size for 9P/TCP */
-#define _9P_MSG_SIZE 70000
-
 #define _9P_HDR_SIZE  4
 #define _9P_TYPE_SIZE 1
 #define _9P_TAG_SIZE  2
@@ -579,6 +576,11 @@ do {                                                   \
  */
 #define _9P_TCP_MSIZE 65536
 
+/**
+ * @brief Default value for _9p_tcp_event_loops
+ */
+#define _9P_TCP_EVENT_LOOPS 4
+
 /**
  * @brief Default value for _9p_rdma_msize
  */
@@ -618,6 +620,9 @@ struct _9p_param {
 	/** Msize for 9P operation on tcp.  Defaults to _9P_TCP_MSIZE,
 	    settable by _9P_TCP_Msize */
 	uint32_t _9p_tcp_msize;
+	/** Number of threads polling 9P/TCP connections.  Defaults to
+	    _9P_TCP_EVENT_LOOPS, settable by _9P_TCP_Event_Loops */
+	uint32_t _9p_tcp_event_loops;
 	/** Msize for 9P operation on rdma.  Defaults to _9P_RDMA_MSIZE,
 	    settable by _9P_RDMA_Msize */
 	uint32_t _9p_rdma_msize;
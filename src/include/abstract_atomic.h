@@ -66,10 +66,18 @@
  * uint64_t atomic_postclear_uint64_t_bits(uint64_t *var,
  * uint64_t atomic_postset_uint64_t_bits(uint64_t *var,
  *
+ * Compare and swap is provided for uint64_t, uint32_t, and void*:
+ *
+ * bool atomic_cas_uint64_t(uint64_t *var, uint64_t *expected,
+ *                          uint64_t desired)
+ *
+ * and a full barrier, void atomic_thread_fence_seq_cst(void).
+ *
  */
 
 #ifndef _ABSTRACT_ATOMIC_H
 #define _ABSTRACT_ATOMIC_H
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <time.h>
@@ -2470,4 +2478,116 @@ static inline void atomic_store_uint8_t(uint8_t *var, uint8_t val)
 	(void)__sync_lock_test_and_set(var, val);
 }
 #endif
+/*
+ * Compare and swap
+ */
+
+/**
+ * @brief Atomically compare and swap a uint64_t
+ *
+ * If the value pointed to by var equals *expected, replace it with
+ * desired.  Otherwise, store the value found in *expected.
+ *
+ * @param[in,out] var      Pointer to the variable to modify
+ * @param[in,out] expected Value we expect to find (updated on failure)
+ * @param[in]     desired  Value to store
+ *
+ * @return true if the swap happened.
+ */
+
+#ifdef GCC_ATOMIC_FUNCTIONS
+static inline bool atomic_cas_uint64_t(uint64_t *var, uint64_t *expected,
+				       uint64_t desired)
+{
+	return __atomic_compare_exchange_n(var, expected, desired, false,
+					   __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+#elif defined(GCC_SYNC_FUNCTIONS)
+static inline bool atomic_cas_uint64_t(uint64_t *var, uint64_t *expected,
+				       uint64_t desired)
+{
+	uint64_t prev = __sync_val_compare_and_swap(var, *expected, desired);
+
+	if (prev == *expected)
+		return true;
+	*expected = prev;
+	return false;
+}
+#endif
+
+/**
+ * @brief Atomically compare and swap a uint32_t
+ *
+ * @param[in,out] var      Pointer to the variable to modify
+ * @param[in,out] expected Value we expect to find (updated on failure)
+ * @param[in]     desired  Value to store
+ *
+ * @return true if the swap happened.
+ */
+
+#ifdef GCC_ATOMIC_FUNCTIONS
+static inline bool atomic_cas_uint32_t(uint32_t *var, uint32_t *expected,
+				       uint32_t desired)
+{
+	return __atomic_compare_exchange_n(var, expected, desired, false,
+					   __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+#elif defined(GCC_SYNC_FUNCTIONS)
+static inline bool atomic_cas_uint32_t(uint32_t *var, uint32_t *expected,
+				       uint32_t desired)
+{
+	uint32_t prev = __sync_val_compare_and_swap(var, *expected, desired);
+
+	if (prev == *expected)
+		return true;
+	*expected = prev;
+	return false;
+}
+#endif
+
+/**
+ * @brief Atomically compare and swap a void pointer
+ *
+ * @param[in,out] var      Pointer to the variable to modify
+ * @param[in,out] expected Value we expect to find (updated on failure)
+ * @param[in]     desired  Value to store
+ *
+ * @return true if the swap happened.
+ */
+
+#ifdef GCC_ATOMIC_FUNCTIONS
+static inline bool atomic_cas_voidptr(void **var, void **expected,
+				      void *desired)
+{
+	return __atomic_compare_exchange_n(var, expected, desired, false,
+					   __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+#elif defined(GCC_SYNC_FUNCTIONS)
+static inline bool atomic_cas_voidptr(void **var, void **expected,
+				      void *desired)
+{
+	void *prev = __sync_val_compare_and_swap(var, *expected, desired);
+
+	if (prev == *expected)
+		return true;
+	*expected = prev;
+	return false;
+}
+#endif
+
+/**
+ * @brief Full memory barrier
+ */
+
+#ifdef GCC_ATOMIC_FUNCTIONS
+static inline void atomic_thread_fence_seq_cst(void)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+#elif defined(GCC_SYNC_FUNCTIONS)
+static inline void atomic_thread_fence_seq_cst(void)
+{
+	__sync_synchronize();
+}
+#endif
 #endif				/* !_ABSTRACT_ATOMIC_H */
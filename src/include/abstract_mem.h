@@ -255,6 +255,19 @@ typedef void *(*pool_allocator_t)(pool_t *pool);
 
 typedef void (*pool_freer_t)(pool_t *pool, void *object);
 
+/**
+ * @brief Abstract type of pool publisher
+ *
+ * This type represents that of a function called once pool_init has
+ * filled out the pool_t proper.  A substrate that makes its pools
+ * visible to other threads, for instance to report statistics, must
+ * do so here rather than in its initializer.
+ *
+ * @param[in] pool The new pool
+ */
+
+typedef void (*pool_publisher_t)(pool_t *pool);
+
 /**
  * @brief A function vector defining a pool substrate
  *
@@ -267,6 +280,7 @@ struct pool_substrate_vector {
 	pool_destroyer_t destroyer; /*< Destroy an underlying pool */
 	pool_allocator_t allocator; /*< Allocate an object */
 	pool_freer_t freer; /*< Free an object */
+	pool_publisher_t publisher; /*< Publish a new pool, or NULL */
 };
 
 /**
@@ -359,6 +373,8 @@ pool_init(const char *name, size_t object_size,
 			pool->name = gsh_strdup(name);
 		else
 			pool->name = NULL;
+		if (substrate->publisher)
+			substrate->publisher(pool);
 	}
 	return pool;
 }
@@ -66,8 +66,11 @@ typedef struct cache_entry_t cache_entry_t;
 #include "nfs4.h"
 #include "nlm4.h"
 #include "gsh_list.h"
+#include "gsh_interval_tree.h"
 #include "gsh_types.h"
 #include "nfs4_acls.h"
+#include "server_stats.h"
+#include "gsh_group_commit.h"
 
 /**
 ** Forward declarations to resolve circular dependency conflicts
@@ -77,6 +80,7 @@ struct fsal_export;
 struct fsal_obj_handle;
 struct gsh_export;
 struct io_info;
+struct fsal_io_arg;
 
 /**
  * @defgroup config_cache_inode Structure and defaults for Cache_Inode
@@ -143,6 +147,19 @@ struct cache_inode_parameter {
 	    client a partial reply based on what we have.
 	    Defaults to false, settable with Retry_Readdir */
 	bool retry_readdir;
+	/** Number of dirents read from the FSAL into each directory
+	    chunk.  0 reads and caches whole directories before the
+	    first READDIR is answered.  Defaults to 128, settable with
+	    Dir_Chunk. */
+	uint32_t dir_chunk;
+	/** Microseconds a commit waits for others to join its batch
+	    while earlier batches are being flushed.  0 flushes every
+	    batch at once.  Defaults to 500, settable with
+	    Commit_Window. */
+	uint32_t commit_window;
+	/** Most commits flushed as one batch.  Defaults to 64,
+	    settable with Commit_Batch_Max. */
+	uint32_t commit_batch_max;
 };
 
 /** @} */
@@ -329,17 +346,52 @@ cache_inode_key_delete(cache_inode_key_t *key)
 #define DIR_ENTRY_FLAG_NONE     0x0000
 #define DIR_ENTRY_FLAG_DELETED  0x0001
 
+struct dir_chunk;
+
 typedef struct cache_inode_dir_entry__ {
 	struct avltree_node node_hk;	/*< AVL node in tree */
 	struct {
 		uint64_t k;	/*< Integer cookie */
 		uint32_t p;	/*< Number of probes, an efficiency metric */
 	} hk;
+	struct avltree_node node_ck;	/*< AVL node in FSAL cookie tree */
+	struct glist_head chunk_list;	/*< Link in the chunk's dirents */
+	struct dir_chunk *chunk;	/*< Chunk holding this dirent or NULL */
+	uint64_t ck;			/*< FSAL cookie, valid when chunked */
 	cache_inode_key_t ckey;	/*< Key of cache entry */
 	uint32_t flags;		/*< Flags */
 	char name[];		/*< The NUL-terminated filename */
 } cache_inode_dir_entry_t;
 
+/**
+ * @brief A chunk of cached directory entries
+ *
+ * When Dir_Chunk is set, a directory is read from the FSAL a chunk at
+ * a time, each chunk holding the dirents that follow FSAL cookie
+ * whence in the FSAL's order, and READDIR hands out FSAL cookies
+ * plus DIR_CHUNK_COOKIE_BIAS.  Chunks are populated, expired and
+ * reclaimed independently under the directory's content_lock.  Every
+ * chunked dirent is also in the name tree, so lookups do not depend
+ * on chunks.
+ */
+
+/** Added to FSAL cookies so that none collides with cookies 0 to 2,
+    which the protocols reserve.  FSAL_PSEUDO, for one, starts at 2. */
+#define DIR_CHUNK_COOKIE_BIAS 3
+
+struct dir_chunk {
+	struct glist_head dirents;	/*< Dirents in FSAL order */
+	struct glist_head chunks;	/*< Link in the directory's chunks */
+	struct glist_head lru;		/*< Link in the chunk LRU */
+	cache_entry_t *parent;		/*< Directory holding the chunk */
+	struct dir_chunk *prev;		/*< Chunk read just before */
+	struct dir_chunk *next;		/*< Chunk read just after */
+	uint64_t whence;		/*< Cookie the chunk was read after */
+	uint32_t gen;			/*< Directory generation when read */
+	uint32_t num_entries;		/*< Dirents in the chunk */
+	bool eod;			/*< Chunk ends the directory */
+};
+
 /**
  * @brief Deep free a dirent.
  *
@@ -487,6 +539,10 @@ struct cache_entry_t {
 		struct cache_inode_file {
 			/** Pointers for lock list */
 			struct glist_head lock_list;
+			/** Locks on lock_list indexed by range */
+			struct gsh_itree lock_tree;
+			/** Locks on lock_list not yet granted */
+			struct glist_head blocked_lock_list;
 			/** Pointers for NLM share list */
 			struct glist_head nlm_share_list;
 			/** Share reservation state for this file. */
@@ -510,9 +566,18 @@ struct cache_entry_t {
 				struct avltree t;
 				/** Persist cookies */
 				struct avltree c;
+				/** Chunked dirents by FSAL cookie */
+				struct avltree ck;
 				/** Heuristic. Expect 0. */
 				uint32_t collisions;
 			} avl;
+			/** Populated chunks */
+			struct glist_head chunks;
+			/** Chunk read from the start of the directory */
+			struct dir_chunk *first_chunk;
+			/** Bumped when a name is added, expiring every chunk
+			    since we cannot know where the FSAL places it */
+			uint32_t chunk_gen;
 			/** If this is a junction, the export this node points
 			    to. Protected by the attr_lock. */
 			struct gsh_export *junction_export;
@@ -821,8 +886,40 @@ cache_inode_status_t cache_inode_rdwr_plus(cache_entry_t *entry,
 				      bool *eof,
 				      bool *sync, struct io_info *info);
 
+/**
+ * @brief Completion of cache_inode_rdwr_async
+ *
+ * @param[in] entry      File the I/O was done on
+ * @param[in] status     Status of the I/O
+ * @param[in] io_arg     The caller's I/O arguments, with results
+ * @param[in] caller_arg The caller's argument
+ */
+
+typedef void (*cache_inode_io_cb)(cache_entry_t *entry,
+				  cache_inode_status_t status,
+				  struct fsal_io_arg *io_arg,
+				  void *caller_arg);
+
+void cache_inode_rdwr_async(cache_entry_t *entry,
+			    cache_inode_io_direction_t io_direction,
+			    struct fsal_io_arg *io_arg,
+			    cache_inode_io_cb done_cb,
+			    void *caller_arg);
+
 cache_inode_status_t cache_inode_commit(cache_entry_t *entry, uint64_t offset,
 					size_t count);
+fsal_status_t cache_inode_group_commit(cache_entry_t *entry, uint64_t offset,
+				       uint64_t count);
+extern struct group_commit cache_inode_commits;
+
+cache_inode_status_t cache_inode_copy(cache_entry_t *src, uint64_t src_offset,
+				      cache_entry_t *dst, uint64_t dst_offset,
+				      uint64_t count, uint64_t *copied,
+				      bool *sync);
+
+cache_inode_status_t cache_inode_clone(cache_entry_t *src, uint64_t src_offset,
+				       cache_entry_t *dst, uint64_t dst_offset,
+				       uint64_t count);
 
 cache_inode_status_t cache_inode_readdir(cache_entry_t *directory,
 					 uint64_t cookie, unsigned int *nbfound,
@@ -849,6 +946,25 @@ cache_inode_status_t cache_inode_invalidate_all_cached_dirent(
 void cache_inode_release_dirents(cache_entry_t *entry,
 				 cache_inode_avl_which_t which);
 
+void cache_inode_dirent_unchunk(cache_entry_t *directory,
+				cache_inode_dir_entry_t *dirent);
+void cache_inode_dir_chunk_free(struct dir_chunk *chunk, bool keep_dirents);
+
+/**
+ * @brief Expire a directory's chunks after a name is added
+ *
+ * The FSAL cannot tell us which cookie range a new name falls in, so
+ * each chunk is re-read the next time READDIR reaches it.  Names stay
+ * cached for lookups.  The caller must hold the content lock.
+ *
+ * @param[in] directory The directory
+ */
+static inline void
+cache_inode_expire_dir_chunks(cache_entry_t *directory)
+{
+	directory->object.dir.chunk_gen++;
+}
+
 void cache_inode_kill_entry(cache_entry_t *entry);
 
 cache_inode_status_t cache_inode_invalidate(cache_entry_t *entry,
@@ -948,6 +1064,7 @@ cache_inode_refresh_attrs(cache_entry_t *entry)
 {
 	fsal_status_t fsal_status = { ERR_FSAL_NO_ERROR, 0 };
 	cache_inode_status_t cache_status = CACHE_INODE_SUCCESS;
+	nsecs_elapsed_t fsal_start;
 
 	if (entry->obj_handle->attributes.acl) {
 		fsal_acl_status_t acl_status = 0;
@@ -962,8 +1079,10 @@ cache_inode_refresh_attrs(cache_entry_t *entry)
 		entry->obj_handle->attributes.acl = NULL;
 	}
 
+	fsal_start = server_stats_clock();
 	fsal_status =
 	    entry->obj_handle->obj_ops.getattrs(entry->obj_handle);
+	server_stats_fsal_done(FSAL_LAT_GETATTRS, fsal_start);
 	if (FSAL_IS_ERROR(fsal_status)) {
 		cache_inode_kill_entry(entry);
 		cache_status = cache_inode_error_convert(fsal_status);
@@ -73,6 +73,23 @@ static inline int avl_dirent_hk_cmpf(const struct avltree_node *lhs,
 	return 1;
 }
 
+static inline int avl_dirent_ck_cmpf(const struct avltree_node *lhs,
+				     const struct avltree_node *rhs)
+{
+	cache_inode_dir_entry_t *lk, *rk;
+
+	lk = avltree_container_of(lhs, cache_inode_dir_entry_t, node_ck);
+	rk = avltree_container_of(rhs, cache_inode_dir_entry_t, node_ck);
+
+	if (lk->ck < rk->ck)
+		return -1;
+
+	if (lk->ck == rk->ck)
+		return 0;
+
+	return 1;
+}
+
 void avl_dirent_set_deleted(cache_entry_t *entry, cache_inode_dir_entry_t *v);
 void avl_dirent_clear_deleted(cache_entry_t *entry,
 			      cache_inode_dir_entry_t *v);
@@ -87,6 +104,8 @@ cache_inode_dir_entry_t *cache_inode_avl_lookup_k(cache_entry_t *entry,
 cache_inode_dir_entry_t *cache_inode_avl_qp_lookup_s(cache_entry_t *entry,
 						     const char *name,
 						     int maxj);
+cache_inode_dir_entry_t *cache_inode_avl_lookup_ck(cache_entry_t *entry,
+						   uint64_t ck);
 
 static inline void cache_inode_avl_remove(cache_entry_t *entry,
 					  cache_inode_dir_entry_t *v)
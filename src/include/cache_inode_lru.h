@@ -67,6 +67,7 @@
 struct lru_state {
 	uint64_t entries_hiwat;
 	uint64_t entries_used;
+	uint64_t chunk_dirents;	/* dirents held in directory chunks */
 	uint32_t fds_system_imposed;
 	uint32_t fds_hard_limit;
 	uint32_t fds_hiwat;
@@ -151,6 +152,10 @@ void cache_inode_lru_cleanup_try_push(cache_entry_t *entry);
 void cache_inode_lru_unref(cache_entry_t *entry, uint32_t flags);
 void cache_inode_lru_putback(cache_entry_t *entry, uint32_t flags);
 void lru_wake_thread(void);
+void cache_inode_lru_insert_chunk(struct dir_chunk *chunk);
+void cache_inode_lru_bump_chunk(struct dir_chunk *chunk);
+void cache_inode_lru_remove_chunk(struct dir_chunk *chunk, bool keep_dirents);
+void cache_inode_lru_release_chunks(cache_entry_t *directory);
 cache_inode_status_t cache_inode_inc_pin_ref(cache_entry_t *entry);
 void cache_inode_unpinnable(cache_entry_t *entry);
 void cache_inode_dec_pin_ref(cache_entry_t *entry, bool closefile);
@@ -77,6 +77,8 @@ struct gsh_export {
 	cache_entry_t *exp_root_cache_inode;
 	/** Allowed clients */
 	struct glist_head clients;
+	/** Allowed clients compiled for lookup, NULL if not compiled */
+	struct client_access *client_access;
 	/** Entry for the junction of this export.  Protected by lock */
 	cache_entry_t *exp_junction_inode;
 	/** The export this export sits on. Protected by lock */
@@ -105,6 +107,22 @@ struct gsh_export {
 	uint64_t MaxOffsetWrite;
 	/** Maximum Offset allowed for read */
 	uint64_t MaxOffsetRead;
+	/** Maximum operations per second, 0 for no limit.  Settable with
+	    Max_IOPS. */
+	uint64_t MaxIOPS;
+	/** Maximum bytes per second read and written, 0 for no limit.
+	    Settable with Max_Bandwidth. */
+	uint64_t MaxBandwidth;
+	/** Token buckets enforcing the two limits above */
+	struct {
+		int64_t ops;		/*< Operations that may be admitted */
+		int64_t bytes;		/*< Bytes that may be admitted */
+		uint64_t ops_frac;	/*< Refill not yet a whole
+					    operation, in 1/NS_PER_SEC */
+		uint64_t bytes_frac;	/*< Likewise for bytes */
+		struct timespec last;	/*< Last refill */
+		pthread_spinlock_t sp;	/*< Protects the buckets */
+	} throttle;
 	/** Filesystem ID for overriding fsid from FSAL*/
 	fsal_fsid_t filesystem_id;
 	/** References to this export */
@@ -135,6 +153,7 @@ void dbus_export_init(void);
 #endif
 struct gsh_export *alloc_export(void);
 void free_export(struct gsh_export *export);
+bool export_throttle_admit(struct gsh_export *export, uint64_t bytes);
 bool insert_gsh_export(struct gsh_export *export);
 struct gsh_export *get_gsh_export(uint16_t export_id);
 struct gsh_export *get_gsh_export_by_path(char *path, bool exact_match);
@@ -40,6 +40,7 @@
 #ifndef FSAL_API
 #define FSAL_API
 
+#include <sys/uio.h>
 #include "fsal_types.h"
 #include "fsal_pnfs.h"
 #include "config_parsing.h"
@@ -51,6 +52,7 @@
 */
 struct gsh_client;
 struct gsh_export;
+struct gsh_arena;
 struct fsal_up_vector;		/* From fsal_up.h */
 
 /**
@@ -359,6 +361,36 @@ struct io_hints {
 	uint32_t hints;
 };
 
+/**
+ * @brief Arguments and results of a read2 or write2 call
+ *
+ * The caller owns this structure and the buffers it describes until
+ * the completion callback has been called.
+ */
+
+struct fsal_io_arg {
+	uint64_t offset;	/*< Position in the file */
+	size_t io_amount;	/*< Out: bytes read or written */
+	bool end_of_file;	/*< Out, read2: end of file was reached */
+	bool fsal_stable;	/*< In/out, write2: as for write */
+	int iov_count;		/*< Number of buffers in iov */
+	struct iovec iov[];	/*< Buffers to fill or to write out */
+};
+
+/**
+ * @brief Completion of a read2 or write2 call
+ *
+ * @param[in] obj_hdl    File the I/O was done on
+ * @param[in] ret        Status of the I/O
+ * @param[in] io_arg     The argument given to read2 or write2
+ * @param[in] caller_arg The caller's argument to read2 or write2
+ */
+
+typedef void (*fsal_async_cb)(struct fsal_obj_handle *obj_hdl,
+			      fsal_status_t ret,
+			      struct fsal_io_arg *io_arg,
+			      void *caller_arg);
+
 /**
  * @brief request op context
  *
@@ -414,6 +446,7 @@ struct req_op_context {
 	void *fsal_private;		/*< private for FSAL use */
 	struct fsal_module *fsal_module;	/*< current fsal module */
 	struct fsal_pnfs_ds *fsal_pnfs_ds;	/*< current pNFS DS */
+	struct gsh_arena *arena;	/*< Memory freed with the reply */
 	/* add new context members here */
 };
 
@@ -1097,6 +1130,30 @@ typedef uint64_t fsal_cookie_t;
 
 typedef bool(*fsal_readdir_cb) (const char *name, void *dir_state,
 				fsal_cookie_t cookie);
+
+/**
+ * @brief Callback for each entry read by readdir_plus
+ *
+ * The object is the entry, as the lookup method would have returned
+ * it, and belongs to the callback whatever it returns.  If the entry
+ * could not be looked up, obj is NULL and status says why.
+ *
+ * @param[in] name      Name of the entry
+ * @param[in] obj       The entry, or NULL
+ * @param[in] status    Status of the lookup of the entry
+ * @param[in] dir_state Opaque pointer passed to readdir_plus
+ * @param[in] cookie    Cookie of the entry
+ *
+ * @retval true if more entries are required
+ * @retval false if no more entries are required (and the current one
+ *               has not been consumed)
+ */
+
+typedef bool(*fsal_readdir_plus_cb) (const char *name,
+				     struct fsal_obj_handle *obj,
+				     fsal_status_t status,
+				     void *dir_state,
+				     fsal_cookie_t cookie);
 /**
  * @brief FSAL object operations vector
  */
@@ -1168,6 +1225,31 @@ struct fsal_obj_ops {
 				  void *dir_state,
 				  fsal_readdir_cb cb,
 				  bool *eof);
+
+/**
+ * @brief Read a directory along with the objects in it
+ *
+ * This function reads directory entries from the FSAL and supplies
+ * them to a callback together with a handle for each entry, with its
+ * attributes.  It saves a caller that wants every entry from looking
+ * them up one by one; an FSAL should implement it if it can find the
+ * entries more cheaply in bulk.  The default method reads the names
+ * through readdir and looks each one up.
+ *
+ * @param[in]  dir_hdl   Directory to read
+ * @param[in]  whence    Point at which to start reading.  NULL to
+ *                       start at beginning.
+ * @param[in]  dir_state Opaque pointer to be passed to callback
+ * @param[in]  cb        Callback to receive the entries
+ * @param[out] eof       true if the last entry was reached
+ *
+ * @return FSAL status.
+ */
+	 fsal_status_t(*readdir_plus) (struct fsal_obj_handle *dir_hdl,
+				       fsal_cookie_t *whence,
+				       void *dir_state,
+				       fsal_readdir_plus_cb cb,
+				       bool *eof);
 /**@}*/
 
 /**@{*/
@@ -1540,6 +1622,45 @@ struct fsal_obj_ops {
 				size_t *wrote_amount,
 				bool *fsal_stable,
 				struct io_info *info);
+/**
+ * @brief Read data from a file, possibly asynchronously
+ *
+ * This function reads into the buffers described by @c read_arg and
+ * calls @c done_cb with the result, either before returning or later
+ * from another thread.  FSALs that can complete reads in the
+ * background advertise it with fso_async_io; the default method
+ * performs the reads in line through the read method.
+ *
+ * The file must be open when this is called.  The FSAL must keep
+ * whatever it needs to finish the I/O, since the caller may close
+ * or reopen the file as soon as this function returns.  The caller's
+ * op_ctx is valid only until this function returns.
+ *
+ * @param[in]     obj_hdl    File to read
+ * @param[in,out] read_arg   Position, buffers and results
+ * @param[in]     done_cb    Completion callback
+ * @param[in]     caller_arg Passed to done_cb
+ */
+	 void (*read2)(struct fsal_obj_handle *obj_hdl,
+		       struct fsal_io_arg *read_arg,
+		       fsal_async_cb done_cb,
+		       void *caller_arg);
+
+/**
+ * @brief Write data to a file, possibly asynchronously
+ *
+ * The write counterpart of read2, with the same rules.  The default
+ * method writes in line through the write method.
+ *
+ * @param[in]     obj_hdl    File to write
+ * @param[in,out] write_arg  Position, buffers, stability and results
+ * @param[in]     done_cb    Completion callback
+ * @param[in]     caller_arg Passed to done_cb
+ */
+	 void (*write2)(struct fsal_obj_handle *obj_hdl,
+			struct fsal_io_arg *write_arg,
+			fsal_async_cb done_cb,
+			void *caller_arg);
 /**
  * @brief Seek to data or hole
  *
@@ -1578,6 +1699,54 @@ struct fsal_obj_ops {
 	 fsal_status_t(*commit) (struct fsal_obj_handle *obj_hdl,  /* sync */
 				 off_t offset, size_t len);
 
+/**
+ * @brief Copy a range of one file into another
+ *
+ * This function copies data between two files of this FSAL without
+ * it passing through the caller.  Both files must be open, the source
+ * for read and the destination for write.  A short copy is not an
+ * error; it stops at the end of the source or wherever the FSAL
+ * chose to stop, and the caller continues from there.  If the range
+ * cannot be offloaded, return ERR_FSAL_NOTSUPP and the caller copies
+ * it by reading and writing.
+ *
+ * @param[in]  src_hdl    File to copy from
+ * @param[in]  src_offset Position in the source
+ * @param[in]  dst_hdl    File to copy to
+ * @param[in]  dst_offset Position in the destination
+ * @param[in]  count      Bytes to copy
+ * @param[out] copied     Bytes copied
+ *
+ * @return FSAL status.
+ */
+	 fsal_status_t(*copy) (struct fsal_obj_handle *src_hdl,
+			       uint64_t src_offset,
+			       struct fsal_obj_handle *dst_hdl,
+			       uint64_t dst_offset,
+			       uint64_t count,
+			       uint64_t *copied);
+
+/**
+ * @brief Share a range of one file's blocks with another
+ *
+ * This function makes a range of the destination share storage with
+ * the same range of the source, as a reflink does.  Both files must
+ * be open as for copy.  The range is cloned whole or not at all.
+ *
+ * @param[in] src_hdl    File to clone from
+ * @param[in] src_offset Position in the source
+ * @param[in] dst_hdl    File to clone to
+ * @param[in] dst_offset Position in the destination
+ * @param[in] count      Bytes to clone, 0 for the rest of the source
+ *
+ * @return FSAL status.
+ */
+	 fsal_status_t(*clone) (struct fsal_obj_handle *src_hdl,
+				uint64_t src_offset,
+				struct fsal_obj_handle *dst_hdl,
+				uint64_t dst_offset,
+				uint64_t count);
+
 /**
  * @brief Perform a lock operation
  *
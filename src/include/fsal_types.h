@@ -574,7 +574,9 @@ typedef enum enum_fsal_fsinfo_options {
 	fso_pnfs_ds_supported,
 	fso_pnfs_mds_supported,
 	fso_reopen_method,
-	fso_grace_method
+	fso_grace_method,
+	fso_async_io,
+	fso_change_is_ctime
 } fsal_fsinfo_options_t;
 
 /* The largest maxread and maxwrite value */
@@ -626,6 +628,13 @@ typedef struct fsal_staticfsinfo_t {
 	bool reopen_method;	/* fsal supports reopen method */
 	bool fsal_trace;	/*< fsal trace supports */
 	bool fsal_grace;	/*< fsal will handle grace */
+	uint32_t async_io_threads;	/*< Threads serving read2/write2,
+					   0 if they complete in line */
+	uint32_t path_fd_cache;	/*< O_PATH descriptors kept open for
+				   getattr and directory operations */
+	bool change_is_ctime;	/*< The change attribute is ctime in
+				   nsecs, so it can be advanced after a
+				   write without asking the FSAL */
 } fsal_staticfsinfo_t;
 
 /**
@@ -0,0 +1,156 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_arena.h
+ * @brief Bump allocator for memory sharing one lifetime
+ *
+ * Replies such as READDIR point to many small allocations (entries,
+ * names, file handles, attributes) that all live exactly as long as
+ * the reply.  An arena hands them out from large chunks by bumping a
+ * pointer and frees them all at once with gsh_arena_release; nothing
+ * allocated from an arena may be passed to gsh_free.
+ *
+ * An arena filled with zeros is valid and empty, and gets its first
+ * chunk on first use.  An arena is not thread safe.
+ */
+
+#ifndef GSH_ARENA_H
+#define GSH_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "gsh_intrinsic.h"
+
+/** Alignment of every allocation */
+#define GSH_ARENA_ALIGN 8
+
+struct gsh_arena_chunk;
+
+struct gsh_arena {
+	struct gsh_arena_chunk *chunks;	/*< Every chunk, for release */
+	char *next;		/*< Free space in the current chunk */
+	char *end;		/*< End of the current chunk */
+	size_t chunk_size;	/*< Size of the next chunk, 0 for default */
+	size_t size;		/*< Bytes in all the chunks */
+};
+
+void *gsh_arena_alloc_slow(struct gsh_arena *arena, size_t size);
+void gsh_arena_release(struct gsh_arena *arena);
+
+/**
+ * @brief Allocate from an arena
+ *
+ * @param[in] arena The arena
+ * @param[in] size  Bytes needed
+ *
+ * @return The memory, aligned to GSH_ARENA_ALIGN, or NULL.
+ */
+
+static inline void *gsh_arena_alloc(struct gsh_arena *arena, size_t size)
+{
+	void *mem;
+
+	size = (size + GSH_ARENA_ALIGN - 1) & ~(size_t)(GSH_ARENA_ALIGN - 1);
+	/* Never hand out the NULL pointer of an empty arena */
+	if (unlikely(size >= (size_t)(arena->end - arena->next)))
+		return gsh_arena_alloc_slow(arena, size);
+
+	mem = arena->next;
+	arena->next += size;
+	return mem;
+}
+
+/**
+ * @brief Allocate zeroed memory for an array from an arena
+ *
+ * @param[in] arena The arena
+ * @param[in] n     Number of elements
+ * @param[in] size  Size of an element
+ *
+ * @return The memory or NULL.
+ */
+
+static inline void *gsh_arena_calloc(struct gsh_arena *arena, size_t n,
+				     size_t size)
+{
+	void *mem;
+
+	if (size != 0 && n > SIZE_MAX / size)
+		return NULL;
+
+	mem = gsh_arena_alloc(arena, n * size);
+	if (mem != NULL)
+		memset(mem, 0, n * size);
+	return mem;
+}
+
+/**
+ * @brief Copy a buffer into an arena
+ *
+ * @param[in] arena The arena
+ * @param[in] src   The buffer
+ * @param[in] len   Its length
+ *
+ * @return The copy or NULL.
+ */
+
+static inline void *gsh_arena_memdup(struct gsh_arena *arena,
+				     const void *src, size_t len)
+{
+	void *mem = gsh_arena_alloc(arena, len);
+
+	if (mem != NULL)
+		memcpy(mem, src, len);
+	return mem;
+}
+
+/**
+ * @brief Copy a string into an arena
+ *
+ * @param[in] arena The arena
+ * @param[in] src   The string
+ *
+ * @return The copy or NULL.
+ */
+
+static inline char *gsh_arena_strdup(struct gsh_arena *arena,
+				     const char *src)
+{
+	return gsh_arena_memdup(arena, src, strlen(src) + 1);
+}
+
+/**
+ * @brief Hand everything allocated from an arena to another one
+ *
+ * @param[out]    dst Empty arena taking the memory
+ * @param[in,out] src Arena giving it up, left empty
+ */
+
+static inline void gsh_arena_move(struct gsh_arena *dst,
+				  struct gsh_arena *src)
+{
+	*dst = *src;
+	memset(src, 0, sizeof(*src));
+}
+
+#endif				/* GSH_ARENA_H */
@@ -224,11 +224,48 @@ typedef struct nfs_core_param {
 	    specific transport.  Defaults to 512 and settable by
 	    Dispatch_Max_Reqs_Xprt. */
 	uint32_t dispatch_max_reqs_xprt;
+	/** Number of request queue shards.  Decoders push each request
+	    onto the shard of the CPU they run on and each worker
+	    drains one home shard, stealing from the others when it
+	    runs dry.  Defaults to 0, meaning one shard per online CPU
+	    (but never more than Nb_Worker), and settable by
+	    Dispatch_Queue_Shards. */
+	uint32_t dispatch_queue_shards;
+	/** Number of slots in each lock-free request lane of a shard.
+	    Requests that do not fit spill onto a locked overflow
+	    queue.  Defaults to 1024 and settable by
+	    Dispatch_Queue_Depth. */
+	uint32_t dispatch_queue_depth;
+	/** Deficit round robin weights of the request classes: how
+	    many requests of a class a worker serves before moving on
+	    to the next class.  Settable by Dispatch_Weight_Mount,
+	    Dispatch_Weight_Call, Dispatch_Weight_Low_Latency,
+	    Dispatch_Weight_High_Latency and Dispatch_Weight_Bulk. */
+	struct {
+		uint32_t mount;
+		uint32_t call;
+		uint32_t low_latency;
+		uint32_t high_latency;
+		uint32_t bulk;
+	} dispatch_weight;
+	/** Number of outstanding requests a transport may have before
+	    its new requests are demoted to the bulk class.  Defaults
+	    to 64, 0 disables demotion.  Settable by
+	    Dispatch_Fair_Share. */
+	uint32_t dispatch_fair_share;
+	/** Bytes of READ payload buffers kept for reuse instead of
+	    being returned to the allocator.  Defaults to 64 MiB, 0
+	    disables pooling.  Settable by Read_Buffer_Cache. */
+	uint64_t read_buffer_cache;
 	/** Parameters controlling the Duplicate Request Cache.  */
 	struct {
 		/** Whether to disable the DRC entirely.  Defaults to
 		    false, settable by DRC_Disabled. */
 		bool disabled;
+		/** Whether to keep cached replies XDR encoded rather
+		    than decoded.  Defaults to false, settable by
+		    DRC_Encoded. */
+		bool encoded;
 		/* Parameters controlling TCP specific DRC behavior. */
 		struct {
 			/** Number of partitions in the tree for the
@@ -249,6 +286,11 @@ typedef struct nfs_core_param {
 			    we can.  Defaults to DRC_TCP_HIWAT and
 			    settable by DRC_TCP_Hiwat. */
 			uint32_t hiwat;
+			/** Bytes a TCP connection's DRC may hold before
+			    it starts retiring entries, 0 for no limit.
+			    Defaults to 0 and settable by
+			    DRC_TCP_Hiwat_Bytes. */
+			uint64_t hiwat_bytes;
 			/** Number of partitions in the recycle
 			    tree that holds per-connection DRCs so
 			    they can be used on reconnection (or
@@ -288,6 +330,10 @@ typedef struct nfs_core_param {
 			    Defaults to DRC_UDP_HIWAT and settable by
 			    DRC_UDP_Hiwat. */
 			uint32_t hiwat;
+			/** Bytes the UDP DRC may hold before it starts
+			    retiring entries, 0 for no limit.  Defaults
+			    to 0 and settable by DRC_UDP_Hiwat_Bytes. */
+			uint64_t hiwat_bytes;
 			/** Whether to use a checksum to match
 			    requests as well as the XID.  Defaults to
 			    DRC_UDP_CHECKSUM and settable by
@@ -346,6 +392,12 @@ typedef struct nfs_core_param {
 	bool enable_RQUOTA;
 	/** Whether to use fast stats.  Defaults to false. */
 	bool enable_FASTSTATS;
+	/** Number of shards of every block of statistics counters.
+	    Requests count into the shard of the CPU they run on and
+	    DBus readers sum the shards.  Defaults to 0, meaning one
+	    shard per CPU (but never more than Nb_Worker), and
+	    settable by Stats_Shards. */
+	uint32_t stats_shards;
 	/** How long the server will trust information it got by
 	    calling getgroups() when "Manage_Gids = TRUE" is
 	    used in a export entry. */
@@ -390,6 +442,26 @@ typedef struct nfs_core_param {
  */
 #define DELEG_RECALL_RETRY_DELAY_DEFAULT 1
 
+/**
+ * @brief Default value of max_session_slots.
+ */
+#define MAX_SESSION_SLOTS_DEFAULT 64
+
+/**
+ * @brief Default value of session_reply_cache_size (256MB).
+ */
+#define SESSION_REPLY_CACHE_SIZE_DEFAULT 268435456
+
+/**
+ * @brief Default value of copy_chunk_size (64MB).
+ */
+#define COPY_CHUNK_SIZE_DEFAULT 67108864
+
+/**
+ * @brief Default value of copy_threads.
+ */
+#define COPY_THREADS_DEFAULT 4
+
 typedef struct nfs_version4_parameter {
 	/** Whether to disable the NFSv4 grace period.  Defaults to
 	    false and settable with Graceless. */
@@ -425,6 +497,22 @@ typedef struct nfs_version4_parameter {
 	bool pnfs_mds;
 	/** Whether this a pNFS DS server. Defaults to false */
 	bool pnfs_ds;
+	/** Most forechannel slots a session is given, whatever the
+	    client asks for in CREATE_SESSION.  Defaults to
+	    MAX_SESSION_SLOTS_DEFAULT and settable with
+	    Max_Session_Slots. */
+	uint32_t max_session_slots;
+	/** Bytes the replies cached in session slots may take, over all
+	    sessions.  Defaults to SESSION_REPLY_CACHE_SIZE_DEFAULT and
+	    settable with Session_Reply_Cache_Size. */
+	uint64_t session_reply_cache_size;
+	/** Bytes a COPY moves before checking for cancellation, and
+	    the most a synchronous COPY moves in one call.  Defaults to
+	    COPY_CHUNK_SIZE_DEFAULT and settable with Copy_Chunk_Size. */
+	uint64_t copy_chunk_size;
+	/** Threads running asynchronous COPYs.  Defaults to
+	    COPY_THREADS_DEFAULT and settable with Copy_Threads. */
+	uint32_t copy_threads;
 } nfs_version4_parameter_t;
 
 /** @} */
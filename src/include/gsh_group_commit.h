@@ -0,0 +1,96 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_group_commit.h
+ * @brief Merge concurrent commits into one flush per file
+ *
+ * A thread committing data joins the open batch of its group.  The
+ * thread that opened the batch leads it.  If earlier batches are
+ * still being flushed it waits up to the group's window for more
+ * commits to join, or until batch_max have, then closes the batch; a
+ * commit on an otherwise idle group is flushed at once.  The commits
+ * are sorted by file, and the first commit on each file (its head)
+ * flushes the range covering all of them with one call to the
+ * group's flush function, which records the result for each.  Heads
+ * of different files flush in parallel.
+ *
+ * Files are only compared by address; the caller must keep them
+ * valid until group_commit() returns.
+ */
+
+#ifndef GSH_GROUP_COMMIT_H
+#define GSH_GROUP_COMMIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * @brief A commit waiting in a batch
+ *
+ * Callers embed this in a structure holding the result.
+ */
+
+struct group_commit_req {
+	void *file;		/*< File to commit */
+	uint64_t offset;	/*< Start of the range */
+	uint64_t end;		/*< End of the range, UINT64_MAX for EOF */
+	uint32_t first;		/*< Head only, index of the first commit
+				    on the file in the sorted batch */
+	uint32_t members;	/*< Head only, commits on the file */
+	bool done;		/*< Set once flushed */
+};
+
+/**
+ * @brief Flush a file for the commits on it
+ *
+ * @param[in] reqs  The commits, the first being the head with its
+ *                  range widened to cover all of them
+ * @param[in] count Number of commits
+ */
+
+typedef void (*group_commit_flush_t)(struct group_commit_req **reqs,
+				     uint32_t count);
+
+struct group_commit_batch;
+
+struct group_commit {
+	pthread_mutex_t mtx;
+	struct group_commit_batch *open;	/*< Batch taking commits */
+	uint32_t flushing;	/*< Closed batches not yet done */
+	uint32_t batch_max;	/*< Commits that close a batch */
+	uint32_t window;	/*< Microseconds to wait for more commits */
+	group_commit_flush_t flush;
+	/** Told the size of each batch as it is closed, or NULL */
+	void (*batched)(uint32_t commits, uint32_t files);
+};
+
+#define GROUP_COMMIT_INITIALIZER(flush_fn, batched_fn) {	\
+	.mtx = PTHREAD_MUTEX_INITIALIZER,			\
+	.batch_max = 1,						\
+	.flush = (flush_fn),					\
+	.batched = (batched_fn),				\
+}
+
+void group_commit(struct group_commit *gc, struct group_commit_req *req);
+
+#endif				/* GSH_GROUP_COMMIT_H */
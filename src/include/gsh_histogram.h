@@ -0,0 +1,104 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_histogram.h
+ * @brief Log-linear latency histograms
+ *
+ * Latencies are counted in buckets that double in width every
+ * GSH_HISTO_SUB buckets, in the manner of HDR histograms, so any
+ * percentile read back is within 1/GSH_HISTO_SUB of the truth from
+ * about a microsecond up to a minute.  Histograms of the same kind
+ * kept by different threads add up by summing their buckets.
+ *
+ * Recording is a few atomic adds on memory the caller should keep to
+ * itself (a shard); reading and resetting may race with recording
+ * and only lose or misplace the samples in flight.
+ */
+
+#ifndef GSH_HISTOGRAM_H
+#define GSH_HISTOGRAM_H
+
+#include <stdint.h>
+#include "abstract_atomic.h"
+
+/** Buckets per doubling, as a power of two */
+#define GSH_HISTO_SUB_BITS 3
+#define GSH_HISTO_SUB (1 << GSH_HISTO_SUB_BITS)
+/** Values are counted in units of 2^10 nsecs, about a microsecond */
+#define GSH_HISTO_UNIT_SHIFT 10
+/** Largest power of two units counted apart, about a minute */
+#define GSH_HISTO_MAX_EXP 26
+#define GSH_HISTO_BUCKETS \
+	((GSH_HISTO_MAX_EXP - GSH_HISTO_SUB_BITS + 2) * GSH_HISTO_SUB)
+
+struct gsh_histogram {
+	uint64_t count;		/*< Samples recorded */
+	uint64_t sum;		/*< Their total in nsecs */
+	uint64_t bucket[GSH_HISTO_BUCKETS];
+};
+
+/**
+ * @brief Find the bucket of a latency
+ *
+ * @param[in] nsecs The latency
+ *
+ * @return The bucket index.
+ */
+
+static inline uint32_t gsh_histo_bucket(uint64_t nsecs)
+{
+	uint64_t units = nsecs >> GSH_HISTO_UNIT_SHIFT;
+	uint32_t exp;
+
+	if (units < GSH_HISTO_SUB)
+		return units;
+
+	exp = 63 - __builtin_clzll(units);
+	if (exp > GSH_HISTO_MAX_EXP)
+		return GSH_HISTO_BUCKETS - 1;
+
+	return (exp - GSH_HISTO_SUB_BITS + 1) * GSH_HISTO_SUB +
+	       ((units >> (exp - GSH_HISTO_SUB_BITS)) & (GSH_HISTO_SUB - 1));
+}
+
+/**
+ * @brief Count a latency
+ *
+ * @param[in] h     The histogram
+ * @param[in] nsecs The latency
+ */
+
+static inline void gsh_histo_record(struct gsh_histogram *h, uint64_t nsecs)
+{
+	(void)atomic_inc_uint64_t(&h->bucket[gsh_histo_bucket(nsecs)]);
+	(void)atomic_add_uint64_t(&h->sum, nsecs);
+	(void)atomic_inc_uint64_t(&h->count);
+}
+
+void gsh_histo_merge(struct gsh_histogram *sum, struct gsh_histogram *h);
+void gsh_histo_reset(struct gsh_histogram *h);
+uint64_t gsh_histo_bucket_high(uint32_t bucket);
+uint64_t gsh_histo_percentile(const struct gsh_histogram *h,
+			      uint32_t per_10000);
+uint64_t gsh_histo_max(const struct gsh_histogram *h);
+
+#endif				/* GSH_HISTOGRAM_H */
@@ -0,0 +1,125 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_interval_tree.h
+ * @brief Intrusive interval tree
+ *
+ * An AVL tree of closed ranges [start, last] ordered by start, where
+ * every node also keeps the largest last in its subtree.  That lets a
+ * search skip any subtree ending before the range sought, so finding
+ * the k ranges overlapping a range costs O(log n + k).  Ranges may
+ * overlap and share a start.
+ *
+ * Removing a node keeps the order of the others, so a walk over the
+ * overlapping nodes may remove the node it is on if it fetched the
+ * next one first (gsh_itree_for_each_safe).  Inserting during a walk,
+ * or changing a node's range while it is in the tree, is not allowed.
+ *
+ * The tree does no locking.
+ */
+
+#ifndef GSH_INTERVAL_TREE_H
+#define GSH_INTERVAL_TREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct gsh_itree_node {
+	struct gsh_itree_node *left;
+	struct gsh_itree_node *right;
+	struct gsh_itree_node *parent;
+	uint64_t start;		/*< First value in the range */
+	uint64_t last;		/*< Last value in the range, inclusive */
+	uint64_t max_last;	/*< Largest last in this subtree */
+	int32_t height;		/*< Height of this subtree, 0 if not in a
+				    tree */
+};
+
+struct gsh_itree {
+	struct gsh_itree_node *root;
+};
+
+/**
+ * @brief Initialize an empty tree
+ *
+ * @param[out] tree The tree
+ */
+
+static inline void gsh_itree_init(struct gsh_itree *tree)
+{
+	tree->root = NULL;
+}
+
+/**
+ * @brief Test whether a tree is empty
+ *
+ * @param[in] tree The tree
+ */
+
+static inline bool gsh_itree_empty(const struct gsh_itree *tree)
+{
+	return tree->root == NULL;
+}
+
+/**
+ * @brief Test whether a node is in a tree
+ *
+ * Only meaningful for nodes zeroed before first use.
+ *
+ * @param[in] node The node
+ */
+
+static inline bool gsh_itree_linked(const struct gsh_itree_node *node)
+{
+	return node->height != 0;
+}
+
+void gsh_itree_insert(struct gsh_itree *tree, struct gsh_itree_node *node);
+void gsh_itree_remove(struct gsh_itree *tree, struct gsh_itree_node *node);
+struct gsh_itree_node *gsh_itree_first(struct gsh_itree *tree,
+				       uint64_t start, uint64_t last);
+struct gsh_itree_node *gsh_itree_next(struct gsh_itree_node *node,
+				      uint64_t start, uint64_t last);
+
+/**
+ * @brief Walk the nodes overlapping [start, last] in order of start
+ */
+
+#define gsh_itree_for_each(node, tree, start, last)			\
+	for (node = gsh_itree_first(tree, start, last);			\
+	     node != NULL;						\
+	     node = gsh_itree_next(node, start, last))
+
+/**
+ * @brief Walk the nodes overlapping [start, last], allowing removal
+ *	  of the current node
+ */
+
+#define gsh_itree_for_each_safe(node, noden, tree, start, last)		\
+	for (node = gsh_itree_first(tree, start, last),			\
+	     noden = node ? gsh_itree_next(node, start, last) : NULL;	\
+	     node != NULL;						\
+	     node = noden,						\
+	     noden = node ? gsh_itree_next(node, start, last) : NULL)
+
+#endif				/* GSH_INTERVAL_TREE_H */
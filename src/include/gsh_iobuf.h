@@ -0,0 +1,63 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_iobuf.h
+ * @brief Size-classed pool of I/O payload buffers
+ *
+ * READ replies need a page-aligned buffer the size of the request for
+ * as long as it takes to encode and send the reply.  Rather than
+ * going to the allocator for every request, buffers are kept in
+ * power-of-two size classes from 4 KiB to 4 MiB and recycled through
+ * lock-free rings, up to a configured number of cached bytes.
+ * Larger requests are served straight from the allocator.
+ *
+ * A buffer obtained from gsh_iobuf_get must be released with
+ * gsh_iobuf_put, never with gsh_free.
+ */
+
+#ifndef GSH_IOBUF_H
+#define GSH_IOBUF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Smallest size class, also the alignment of every buffer */
+#define GSH_IOBUF_MIN_SHIFT 12
+/** Largest size class kept in the pool */
+#define GSH_IOBUF_MAX_SHIFT 22
+
+/**
+ * @brief Pool counters, for monitoring and benchmarks
+ */
+
+struct gsh_iobuf_stats {
+	uint64_t hits;		/*< Buffers handed out from the pool */
+	uint64_t misses;	/*< Buffers that had to be allocated */
+	uint64_t cached;	/*< Bytes currently held by the pool */
+};
+
+int gsh_iobuf_init(uint64_t cache_bytes);
+void *gsh_iobuf_get(size_t size);
+void gsh_iobuf_put(void *buf);
+void gsh_iobuf_get_stats(struct gsh_iobuf_stats *stats);
+
+#endif				/* GSH_IOBUF_H */
@@ -0,0 +1,195 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_ring.h
+ * @brief Bounded multi-producer, multi-consumer ring of pointers
+ *
+ * A fixed size array of cells, each carrying a sequence number that
+ * tells producers and consumers whose turn it is to use the cell.
+ * Producers and consumers claim positions with a single compare and
+ * swap on their own (padded) cursor, so neither side ever takes a
+ * lock and the two sides never write the same cache line unless the
+ * ring is nearly empty or nearly full.
+ *
+ * The ring never blocks: gsh_ring_push fails when the ring is full and
+ * gsh_ring_pop fails when it is empty.  Callers decide what to do
+ * about that.
+ */
+
+#ifndef GSH_RING_H
+#define GSH_RING_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "abstract_atomic.h"
+#include "abstract_mem.h"
+#include "gsh_intrinsic.h"
+
+struct gsh_ring_cell {
+	uint64_t seq;
+	void *data;
+};
+
+struct gsh_ring {
+	struct gsh_ring_cell *cells;
+	uint64_t mask;
+	 CACHE_PAD(0);
+	uint64_t enqueue_pos;	/*< Next position to be filled */
+	 CACHE_PAD(1);
+	uint64_t dequeue_pos;	/*< Next position to be drained */
+	 CACHE_PAD(2);
+};
+
+/**
+ * @brief Initialize a ring
+ *
+ * @param[in,out] ring The ring
+ * @param[in]     size Number of cells, rounded up to a power of 2
+ *
+ * @retval 0 on success.
+ * @retval ENOMEM if the cells could not be allocated.
+ */
+static inline int gsh_ring_init(struct gsh_ring *ring, uint32_t size)
+{
+	uint64_t n = 2;
+	uint64_t ix;
+
+	while (n < size)
+		n <<= 1;
+
+	ring->cells = gsh_malloc_aligned(CACHE_LINE_SIZE,
+					 n * sizeof(struct gsh_ring_cell));
+	if (ring->cells == NULL)
+		return ENOMEM;
+
+	for (ix = 0; ix < n; ++ix) {
+		ring->cells[ix].seq = ix;
+		ring->cells[ix].data = NULL;
+	}
+	ring->mask = n - 1;
+	ring->enqueue_pos = 0;
+	ring->dequeue_pos = 0;
+	return 0;
+}
+
+/**
+ * @brief Release the cells of a ring
+ *
+ * The ring must be empty and no longer in use.
+ *
+ * @param[in,out] ring The ring
+ */
+static inline void gsh_ring_destroy(struct gsh_ring *ring)
+{
+	gsh_free(ring->cells);
+	ring->cells = NULL;
+}
+
+/**
+ * @brief Add a pointer to a ring
+ *
+ * @param[in,out] ring The ring
+ * @param[in]     data Pointer to add (may not be NULL)
+ *
+ * @return true if the pointer was added, false if the ring was full.
+ */
+static inline bool gsh_ring_push(struct gsh_ring *ring, void *data)
+{
+	struct gsh_ring_cell *cell;
+	uint64_t pos = atomic_fetch_uint64_t(&ring->enqueue_pos);
+	int64_t dif;
+
+	for (;;) {
+		cell = &ring->cells[pos & ring->mask];
+		dif = (int64_t) atomic_fetch_uint64_t(&cell->seq) -
+		      (int64_t) pos;
+		if (dif == 0) {
+			if (atomic_cas_uint64_t(&ring->enqueue_pos, &pos,
+						pos + 1))
+				break;
+			/* pos was reloaded by the failed CAS */
+		} else if (dif < 0) {
+			return false;	/* full */
+		} else {
+			pos = atomic_fetch_uint64_t(&ring->enqueue_pos);
+		}
+	}
+
+	cell->data = data;
+	atomic_store_uint64_t(&cell->seq, pos + 1);
+	return true;
+}
+
+/**
+ * @brief Remove a pointer from a ring
+ *
+ * @param[in,out] ring The ring
+ *
+ * @return The oldest pointer in the ring or NULL if it was empty.
+ */
+static inline void *gsh_ring_pop(struct gsh_ring *ring)
+{
+	struct gsh_ring_cell *cell;
+	uint64_t pos = atomic_fetch_uint64_t(&ring->dequeue_pos);
+	int64_t dif;
+	void *data;
+
+	for (;;) {
+		cell = &ring->cells[pos & ring->mask];
+		dif = (int64_t) atomic_fetch_uint64_t(&cell->seq) -
+		      (int64_t) (pos + 1);
+		if (dif == 0) {
+			if (atomic_cas_uint64_t(&ring->dequeue_pos, &pos,
+						pos + 1))
+				break;
+		} else if (dif < 0) {
+			return NULL;	/* empty */
+		} else {
+			pos = atomic_fetch_uint64_t(&ring->dequeue_pos);
+		}
+	}
+
+	data = cell->data;
+	atomic_store_uint64_t(&cell->seq, pos + ring->mask + 1);
+	return data;
+}
+
+/**
+ * @brief Approximate number of pointers in a ring
+ *
+ * The value is only a snapshot; it is intended for statistics and
+ * heuristics, never for correctness.
+ *
+ * @param[in] ring The ring
+ *
+ * @return Number of filled cells.
+ */
+static inline uint64_t gsh_ring_depth(struct gsh_ring *ring)
+{
+	uint64_t deq = atomic_fetch_uint64_t(&ring->dequeue_pos);
+	uint64_t enq = atomic_fetch_uint64_t(&ring->enqueue_pos);
+
+	return (enq > deq) ? enq - deq : 0;
+}
+
+#endif				/* GSH_RING_H */
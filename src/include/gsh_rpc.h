@@ -145,11 +145,13 @@ const char *str_gc_proc(rpc_gss_proc_t);
 #define XPRT_PRIVATE_FLAG_STALLED 0x0010	/* ie, -on stallq- */
 
 struct drc;
+struct gsh_client;
 typedef struct gsh_xprt_private {
 	SVCXPRT *xprt;
 	uint32_t flags;
 	uint32_t req_cnt; /*< outstanding requests counter */
 	struct drc *drc; /*< TCP DRC */
+	struct gsh_client *client; /*< Client of a connected xprt, ref'd */
 	struct glist_head stallq;
 } gsh_xprt_private_t;
 
@@ -162,6 +164,7 @@ static inline gsh_xprt_private_t *alloc_gsh_xprt_private(SVCXPRT *xprt,
 	xu->flags = XPRT_PRIVATE_FLAG_NONE;
 	xu->req_cnt = 0;
 	xu->drc = NULL;
+	xu->client = NULL;
 
 	return xu;
 }
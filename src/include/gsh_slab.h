@@ -0,0 +1,88 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_slab.h
+ * @brief Slab pool substrate with per-thread magazines
+ *
+ * Pass pool_slab_substrate to pool_init() instead of
+ * pool_basic_substrate to have a pool's objects carved from slabs.
+ * Each thread keeps two magazines of objects per pool, so most
+ * pool_alloc() and pool_free() calls take no lock.  A thread whose
+ * magazines run empty or full trades them with the pool's depot,
+ * which is how objects freed on one thread get back to another.
+ *
+ * Slabs and the depot's full magazines are kept per NUMA node, and a
+ * thread only takes from those of the node it is running on.
+ *
+ * As with the basic substrate, objects come back zeroed unless the
+ * pool has a constructor, or the substrate parameters give an init
+ * function.  In that last case objects are initialized once, as their
+ * slab is carved, and keep whatever state they were freed with.
+ */
+
+#ifndef GSH_SLAB_H
+#define GSH_SLAB_H
+
+#include <stdint.h>
+#include "abstract_mem.h"
+
+/**
+ * @brief Parameters for a slab pool
+ *
+ * Passed as the substrate_params of pool_init(); NULL takes all the
+ * defaults.
+ */
+
+struct pool_slab_params {
+	uint32_t magazine_size;	/*< Objects per magazine, 0 for default */
+	uint32_t depot_size;	/*< Full magazines the depot keeps per
+				    node before emptying one back into
+				    its slabs, 0 for default */
+	void (*init)(void *object);	/*< Called on each object as its
+					    slab is carved, or NULL */
+	void (*fini)(void *object);	/*< Called on each object as its
+					    slab is released, or NULL */
+};
+
+/**
+ * @brief Statistics for a slab pool
+ *
+ * Objects still in a thread's magazines are counted as live until
+ * that thread next visits the depot, or exits.
+ */
+
+struct pool_slab_stats {
+	uint64_t object_size;	/*< Size of the objects */
+	uint64_t slabs;		/*< Slabs held */
+	uint64_t bytes;		/*< Bytes held in slabs */
+	uint64_t live;		/*< Objects allocated and not freed */
+	uint64_t cached;	/*< Objects free in the depot and slabs */
+	uint64_t hits;		/*< Allocs and frees served by a magazine */
+	uint64_t misses;	/*< Allocs and frees that went to the depot */
+};
+
+extern const struct pool_substrate_vector pool_slab_substrate[];
+
+void pool_slab_stats(pool_t *pool, struct pool_slab_stats *stats);
+void pool_slab_foreach(void (*cb)(pool_t *pool, void *arg), void *arg);
+
+#endif				/* GSH_SLAB_H */
@@ -0,0 +1,85 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_timer_wheel.h
+ * @brief Timer wheel for expiring state on a deadline
+ *
+ * Timers are intrusive and have one second resolution.  The wheel has
+ * a slot per second for the next GSH_TIMER_WHEEL_SLOTS seconds; a
+ * timer due further out waits in the last slot and is moved on when
+ * that slot comes round.  Scheduling and cancelling are O(1), and
+ * collecting what is due costs the number of timers due plus the
+ * seconds elapsed.
+ *
+ * The wheel has its own mutex, taken inside any lock protecting the
+ * objects the timers are embedded in.  It holds no references; see
+ * gsh_timer_wheel_pop() for how an owner keeps a popped object alive.
+ */
+
+#ifndef GSH_TIMER_WHEEL_H
+#define GSH_TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "gsh_list.h"
+
+#define GSH_TIMER_WHEEL_SLOTS 256
+
+struct gsh_timer {
+	struct glist_head t_list;	/*< Link in a wheel slot */
+	time_t t_expire;		/*< When due, 0 if not scheduled */
+};
+
+struct gsh_timer_wheel {
+	pthread_mutex_t tw_mutex;	/*< Protects everything below and
+					    every timer on the wheel */
+	time_t tw_cursor;		/*< Second being expired */
+	uint32_t tw_count;		/*< Timers scheduled */
+	struct glist_head tw_overdue;	/*< Timers scheduled for a second
+					    already expired */
+	struct glist_head tw_slots[GSH_TIMER_WHEEL_SLOTS];
+};
+
+/**
+ * @brief Test whether a timer is scheduled
+ *
+ * The answer only holds while the wheel's mutex is held.
+ *
+ * @param[in] timer The timer, zeroed before first use
+ */
+
+static inline bool gsh_timer_scheduled(const struct gsh_timer *timer)
+{
+	return timer->t_expire != 0;
+}
+
+void gsh_timer_wheel_init(struct gsh_timer_wheel *tw);
+void gsh_timer_schedule(struct gsh_timer_wheel *tw, struct gsh_timer *timer,
+			time_t expire);
+bool gsh_timer_cancel(struct gsh_timer_wheel *tw, struct gsh_timer *timer);
+struct gsh_timer *gsh_timer_wheel_pop(struct gsh_timer_wheel *tw,
+				      time_t now,
+				      void (*hold)(struct gsh_timer *));
+
+#endif				/* GSH_TIMER_WHEEL_H */
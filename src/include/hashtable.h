@@ -77,6 +77,10 @@ typedef int (*val_display_function_t)(struct gsh_buffdesc *, char *);
 #define HT_FLAG_NONE 0x0000	/*< Null hash table flags */
 #define HT_FLAG_CACHE 0x0001	/*< Indicates that caching should be
 				   enabled */
+#define HT_FLAG_OPEN_ADDR 0x0002	/*< Store entries in open addressed
+					   arrays rather than red-black
+					   trees.  HT_FLAG_CACHE is
+					   ignored. */
 
 /**
  * @brief Hash parameters
@@ -116,6 +120,10 @@ struct hash_param {
 					       to a string. */
 	val_display_function_t val_to_str; /*< Function to convert a
 					       value to a string. */
+	uint32_t oa_key_len; /*< Longest key copied into its slot, so
+				 it can be looked up without the lock,
+				 when open addressed.  0 means
+				 HASH_OA_INLINE_KEY. */
 	char *ht_name; /*< Name of this hash table. */
 	log_components_t ht_log_component; /*< Log component to use for this
 					       hash table */
@@ -137,6 +145,43 @@ typedef struct hash_stat {
 				       the rbt used. */
 } hash_stat_t;
 
+/** Keys up to this long are copied into their slot, unless the
+    table's oa_key_len says otherwise */
+#define HASH_OA_INLINE_KEY 16
+
+/**
+ * @brief One slot of an open addressed partition
+ *
+ * Slots hold the entry itself, so inserting needs no allocation.  A
+ * slot is free when its key address is NULL.  Short keys are also
+ * copied into the slot, so a lockless lookup never reads a key
+ * buffer that a concurrent delete may already have freed.
+ */
+
+struct hash_slot {
+	uint64_t hash; /*< The red-black hash, used as the probe hash */
+	struct gsh_buffdesc key; /*< The lookup key */
+	struct gsh_buffdesc val; /*< The stored value */
+	uint8_t key_copy[]; /*< The key's bytes, if no longer than the
+				table's oa_key_len */
+};
+
+/**
+ * @brief The slot array of an open addressed partition
+ *
+ * When a partition grows its old array is kept, unchanged, on the
+ * retired list of the new one until the table is destroyed, since a
+ * lockless reader may still be probing it.  Arrays only ever double,
+ * so this at most doubles the memory used.
+ */
+
+struct hash_slots {
+	uint32_t mask; /*< Number of slots - 1, a power of 2 - 1 */
+	uint32_t stride; /*< Bytes from one slot to the next */
+	struct hash_slots *retired; /*< Smaller arrays this one replaced */
+	char slot_mem[]; /*< The slots */
+};
+
 /**
  * @brief Represents an individual partition
  *
@@ -149,6 +194,9 @@ struct hash_partition {
 	struct rbt_head rbt; /*< The red-black tree */
 	pthread_rwlock_t lock; /*< Lock for this partition */
 	struct rbt_node **cache; /*< Expected entry cache */
+	uint32_t seq; /*< Open addressing write sequence, odd while a
+			  writer is changing slots. */
+	struct hash_slots *slots; /*< Open addressed entries */
 };
 
 /**
@@ -178,6 +226,7 @@ struct hash_latch {
 	uint32_t index;	/*< Saved partition index */
 	uint64_t rbt_hash; /*< Saved red-black hash */
 	struct rbt_node *locator; /*< Saved location in the tree */
+	int32_t slot; /*< Saved slot when open addressed, -1 if none */
 };
 
 typedef enum hash_set_how {
@@ -227,6 +276,11 @@ hash_error_t hashtable_deletelatched(struct hash_table *,
 hash_error_t hashtable_delall(struct hash_table *,
 			      int (*)(struct gsh_buffdesc,
 				      struct gsh_buffdesc));
+void hashtable_for_each(struct hash_table *,
+			bool (*)(struct gsh_buffdesc *,
+				 struct gsh_buffdesc *,
+				 void *),
+			void *);
 
 void hashtable_log(log_components_t, struct hash_table *);
 
@@ -118,6 +118,7 @@ typedef struct request_data {
 	struct timespec time_queued;	/*< The time at which a request was
 					 *  added to the worker thread queue.
 					 */
+	uint32_t lane;		/*< Request queue class it was queued on */
 } request_data_t;
 
 extern pool_t *request_pool;
@@ -141,6 +142,10 @@ extern ushort g_nodeid;
  */
 request_data_t *nfs_rpc_get_nfsreq(uint32_t flags);
 void nfs_rpc_enqueue_req(request_data_t *req);
+void nfs_rpc_queue_serviced(uint32_t worker_index, request_data_t *req,
+			    struct timespec *dequeued);
+request_data_t *nfs_rpc_async_start(nfs_worker_data_t *worker);
+void nfs_rpc_async_complete(request_data_t *req, int rc);
 
 uint32_t get_enqueue_count();
 uint32_t get_dequeue_count();
@@ -155,6 +160,7 @@ void *sigmgr_thread(void *UnusedArg);
 
 #ifdef _USE_9P
 void *_9p_dispatcher_thread(void *arg);
+void _9p_tcp_conn_put(struct _9p_conn *conn);
 void _9p_tcp_process_request(struct _9p_request_data *req9p,
 			     nfs_worker_data_t *worker_data);
 int _9p_process_buffer(struct _9p_request_data *req9p,
@@ -38,6 +38,8 @@
 #include "nfs23.h"
 #include "nfs4.h"
 #include "nfs_core.h"
+#include "gsh_arena.h"
+#include "gsh_list.h"
 #include <misc/rbtree_x.h>
 #include <misc/queue.h>
 
@@ -66,6 +68,8 @@ typedef struct drc {
 	uint32_t size;
 	uint32_t maxsize;
 	uint32_t hiwat;
+	uint64_t bytes; /* memory held by cached entries */
+	uint64_t hiwat_bytes; /* 0 for no byte limit */
 	uint32_t flags;
 	uint32_t refcnt; /* call path refs */
 	uint32_t retwnd;
@@ -105,6 +109,10 @@ struct dupreq_entry {
 	dupreq_state_t state;
 	uint32_t refcnt;
 	nfs_res_t *res;
+	struct {
+		char *buf;	/* encoded reply body, if res was encoded */
+		uint32_t len;
+	} reply;
 	time_t timestamp;
 };
 
@@ -112,17 +120,40 @@ typedef struct dupreq_entry dupreq_entry_t;
 
 extern pool_t *nfs_res_pool;
 
+/**
+ * @brief A result and the arena holding what it points to
+ *
+ * Service functions allocate the parts of their result through the
+ * arena (op_ctx->arena), and they are freed along with the result,
+ * once the reply is sent or the DRC entry holding it is retired.
+ */
+
+struct nfs_res_block {
+	nfs_res_t res;
+	struct gsh_arena arena;
+};
+
 static inline nfs_res_t *alloc_nfs_res(void)
 {
 	/* XXX can pool/ctor zero mem? */
-	nfs_res_t *res = pool_alloc(nfs_res_pool, NULL);
-	memset(res, 0, sizeof(nfs_res_t));
-	return res;
+	struct nfs_res_block *blk = pool_alloc(nfs_res_pool, NULL);
+
+	memset(blk, 0, sizeof(*blk));
+	return &blk->res;
+}
+
+static inline struct gsh_arena *nfs_res_arena(nfs_res_t *res)
+{
+	return &container_of(res, struct nfs_res_block, res)->arena;
 }
 
 static inline void free_nfs_res(nfs_res_t *res)
 {
-	pool_free(nfs_res_pool, res);
+	struct nfs_res_block *blk =
+	    container_of(res, struct nfs_res_block, res);
+
+	gsh_arena_release(&blk->arena);
+	pool_free(nfs_res_pool, blk);
 }
 
 typedef enum dupreq_status {
@@ -135,6 +166,7 @@ typedef enum dupreq_status {
 
 void dupreq2_pkginit(void);
 void dupreq2_pkgshutdown(void);
+void dupreq2_free_expired(void);
 
 drc_t *drc_get_tcp_drc(struct svc_req *);
 void drc_release_tcp_drc(drc_t *);
@@ -142,6 +174,8 @@ void drc_release_tcp_drc(drc_t *);
 dupreq_status_t nfs_dupreq_start(nfs_request_data_t *,
 				 struct svc_req *);
 dupreq_status_t nfs_dupreq_finish(struct svc_req *, nfs_res_t *);
+bool nfs_dupreq_sendreply(SVCXPRT *, struct svc_req *,
+			  const nfs_function_desc_t *, nfs_res_t *);
 dupreq_status_t nfs_dupreq_delete(struct svc_req *);
 void nfs_dupreq_rele(struct svc_req *, const nfs_function_desc_t *);
 
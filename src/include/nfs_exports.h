@@ -198,6 +198,7 @@ typedef struct exportlist_client_entry__ {
 
 /* Export list related functions */
 void export_check_access(void);
+void export_flush_access_cache(void);
 
 bool export_check_security(struct svc_req *req);
 
@@ -38,6 +38,7 @@
 
 #include "cache_inode_lru.h"
 #include "fsal_api.h"
+#include "gsh_arena.h"
 #include "rquota.h"
 #include "wait_queue.h"
 
@@ -105,6 +106,8 @@ typedef union nfs_arg__ {
 struct COMPOUND4res_extended {
 	COMPOUND4res res_compound4;
 	bool res_cached;
+	struct gsh_arena arena;	/*< Arena of a result kept in a session
+				   slot, empty otherwise */
 };
 
 typedef union nfs_res__ {
@@ -163,9 +166,13 @@ typedef union nfs_res__ {
 typedef struct nfs_worker_data {
 	unsigned int worker_index;	/*< Index for log messages */
 	wait_q_entry_t wqe;	/*< Queue for coordinating with decoder */
+	uint32_t drr_lane;	/*< Lane the scheduler is serving */
+	int32_t drr_deficit;	/*< Requests left in drr_lane's quantum */
 
 	sockaddr_t hostaddr;	/*< Client address */
 	struct fridgethr_context *ctx;	/*< Link back to thread context */
+	struct request_data *cur_req;	/*< NFS request being executed */
+	struct timespec dequeued;	/*< When cur_req was dequeued */
 } nfs_worker_data_t;
 
 /* flags related to the behaviour of the requests
@@ -210,6 +217,17 @@ typedef struct nfs_request_data {
 	nfs_arg_t arg_nfs;
 	nfs_res_t *res_nfs;
 	const nfs_function_desc_t *funcdesc;
+	/* Execution state, kept with the request rather than on the
+	   worker's stack so the request can be parked while its I/O
+	   completes. */
+	struct req_op_context req_ctx;
+	struct user_cred user_credentials;
+	struct export_perms export_perms;
+	sockaddr_t hostaddr;	/*< Client address */
+	bool client_borrowed;	/*< op_ctx->client belongs to the xprt */
+	uint32_t worker_index;	/*< Worker that parked the request, by
+				    index since it may exit first */
+	struct timespec dequeued;	/*< When that worker dequeued it */
 } nfs_request_data_t;
 
 enum rpc_chan_type {
@@ -396,12 +396,37 @@ int nfs4_op_layoutstats(struct nfs_argop4 *, compound_data_t *,
 
 void nfs4_op_layoutstats_Free(nfs_resop4 *resp);
 
+int nfs4_op_copy(struct nfs_argop4 *, compound_data_t *,
+		 struct nfs_resop4 *);
+
+void nfs4_op_copy_Free(nfs_resop4 *resp);
+
+int nfs4_op_offload_status(struct nfs_argop4 *, compound_data_t *,
+			   struct nfs_resop4 *);
+
+void nfs4_op_offload_status_Free(nfs_resop4 *resp);
+
+int nfs4_op_offload_cancel(struct nfs_argop4 *, compound_data_t *,
+			   struct nfs_resop4 *);
+
+void nfs4_op_offload_cancel_Free(nfs_resop4 *resp);
+
+int nfs4_op_clone(struct nfs_argop4 *, compound_data_t *,
+		  struct nfs_resop4 *);
+
+void nfs4_op_clone_Free(nfs_resop4 *resp);
+
+int nfs4_copy_init(void);
+int nfs4_copy_shutdown(void);
+void nfs4_copy_forget_client(nfs_client_id_t *client);
+
 /* @}
  * -- End of NFS protocols functions. --
  */
 
 #define NFS_REQ_OK   0
 #define NFS_REQ_DROP 1
+#define NFS_REQ_ASYNC_WAIT 2	/* Parked, see nfs_rpc_async_start */
 
 /* Free functions */
 void mnt1_Mnt_Free(nfs_res_t *);
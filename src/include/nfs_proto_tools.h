@@ -79,6 +79,8 @@ struct xdr_attrs_args {
 	compound_data_t *data;
 	bool statfscalled;
 	fsal_dynamicfsinfo_t *dynamicinfo;
+	struct gsh_arena *arena;	/*< Where to put the encoded attributes,
+					   NULL for the heap */
 };
 
 typedef struct fattr4_dent {
@@ -257,7 +259,7 @@ nfsstat4 nfs4_utf8string2dynamic(const utf8string *input, utf8_scantype_t scan,
 
 nfsstat4 cache_entry_To_Fattr(cache_entry_t *, fattr4 *,
 			      compound_data_t *, nfs_fh4 *,
-			      struct bitmap4 *);
+			      struct bitmap4 *, struct gsh_arena *);
 
 bool nfs4_Fattr_Check_Access(fattr4 *, int);
 bool nfs4_Fattr_Check_Access_Bitmap(struct bitmap4 *, int);
@@ -276,9 +278,11 @@ bool nfs3_Sattr_To_FSALattr(struct attrlist *, sattr3 *);
 
 int nfs4_Fattr_To_FSAL_attr(struct attrlist *, fattr4 *, compound_data_t *);
 
+int nfs4_Fattr_To_FSAL_attr_fh(struct attrlist *, fattr4 *, nfs_fh4 *);
+
 int nfs4_Fattr_To_fsinfo(fsal_dynamicfsinfo_t *, fattr4 *);
 
-int nfs4_Fattr_Fill_Error(fattr4 *, nfsstat4);
+int nfs4_Fattr_Fill_Error(fattr4 *, nfsstat4, struct gsh_arena *);
 
 int nfs4_FSALattr_To_Fattr(struct xdr_attrs_args *, struct bitmap4 *,
 			   fattr4 *);
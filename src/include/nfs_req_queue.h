@@ -30,20 +30,30 @@
  * This module defines an infrastructure for classification and
  * dispatch of incoming protocol requests using a forward queueing
  * model, with priority and isolation partitions.
+ *
+ * Requests are spread over a set of shards.  Each shard holds one
+ * bounded lock-free ring per request class (lane).  Decoders push
+ * onto the shard of the CPU they are running on; workers drain their
+ * home shard and steal from the others when it is empty.  A request
+ * that does not fit in its ring spills onto the spinlocked overflow
+ * queue pair of its class, so enqueue never fails.
+ *
+ * Workers choose between classes with deficit round robin: each lane
+ * gets a configurable weight (quantum) of requests per round, and an
+ * empty lane forfeits its remaining quantum.  A connection that
+ * already has more than Dispatch_Fair_Share requests outstanding has
+ * its new LL and HL requests demoted to the bulk lane, so one client
+ * streaming READs cannot crowd out everyone else.
  */
 
 #ifndef NFS_REQ_QUEUE_H
 #define NFS_REQ_QUEUE_H
 
 #include "gsh_list.h"
+#include "gsh_intrinsic.h"
+#include "gsh_ring.h"
 #include "wait_queue.h"
 
-/* XXX moving to gsh_intrinsic.h */
-#ifndef CACHE_LINE_SIZE
-#define CACHE_LINE_SIZE 64	/* XXX arch-specific define */
-#endif
-#define CACHE_PAD(_n) char __pad ## _n [CACHE_LINE_SIZE]
-
 struct req_q {
 	pthread_spinlock_t sp;
 	struct glist_head q;	/* LIFO */
@@ -65,7 +75,8 @@ struct req_q_pair {
 #define REQ_Q_CALL 1
 #define REQ_Q_LOW_LATENCY 2	/*< GETATTR, RENEW, etc */
 #define REQ_Q_HIGH_LATENCY 3	/*< READ, WRITE, COMMIT, etc */
-#define N_REQ_QUEUES 4
+#define REQ_Q_BULK 4		/*< from transports over their fair share */
+#define N_REQ_QUEUES 5
 
 extern const char *req_q_s[N_REQ_QUEUES];	/* for debug prints */
 
@@ -73,11 +84,37 @@ struct req_q_set {
 	struct req_q_pair qset[N_REQ_QUEUES];
 };
 
+/**
+ * @brief One shard of lock-free request lanes
+ *
+ * The counters are only ever summed for statistics, so they are
+ * updated without regard to ordering.
+ */
+struct req_q_lane_stats {
+	uint64_t served;	/*< Requests completed */
+	uint64_t wait_ns;	/*< Total time spent queued */
+	uint64_t service_ns;	/*< Total time spent executing */
+};
+
+struct req_q_shard {
+	struct gsh_ring lane[N_REQ_QUEUES];
+	uint64_t enqueued;	/*< Requests pushed onto this shard */
+	uint64_t demoted;	/*< ...of which sent to the bulk lane */
+	 CACHE_PAD(0);
+	uint64_t dequeued;	/*< Requests run by this shard's workers */
+	uint64_t stolen;	/*< ...of which taken from other shards */
+	struct req_q_lane_stats lane_stats[N_REQ_QUEUES];
+	 CACHE_PAD(1);
+};
+
 struct nfs_req_st {
 	struct {
 		uint32_t ctr;
-		struct req_q_set nfs_request_q;
-		uint64_t size;
+		struct req_q_shard *shards;
+		uint32_t n_shards;
+		struct req_q_set nfs_request_q;	/*< overflow */
+		uint64_t size;	/*< requests on the overflow queues */
+		uint64_t overflowed;	/*< total requests that overflowed */
 		pthread_spinlock_t sp;
 		struct glist_head wait_list;
 		uint32_t waiters;
@@ -111,6 +148,23 @@ static inline uint32_t nfs_rpc_q_next_slot(void)
 	return ix;
 }
 
+/**
+ * @brief Snapshot of request queue statistics
+ */
+struct nfs_req_q_stats {
+	uint64_t depth[N_REQ_QUEUES];	/*< queued, by class */
+	struct req_q_lane_stats lane[N_REQ_QUEUES];	/*< by class */
+	uint64_t overflow_depth;	/*< queued on the overflow lists */
+	uint64_t enqueued;
+	uint64_t dequeued;
+	uint64_t stolen;
+	uint64_t overflowed;
+	uint64_t demoted;
+	uint32_t shards;
+};
+
+void nfs_rpc_queue_stats(struct nfs_req_q_stats *stats);
+
 static inline void nfs_rpc_queue_awaken(void *arg)
 {
 	struct nfs_req_st *st = arg;
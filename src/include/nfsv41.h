@@ -2554,88 +2554,82 @@ extern "C" {
 		offset4         sr_offset;
 	} seek_res4;
 
-	typedef struct OFFLOAD_STATUS4resok {
-		length4         osr_bytes_copied;
-		count4          osr_count_complete;
-		nfsstat4        osr_complete;
-	} OFFLOAD_STATUS4resok;
+	typedef struct {
+		netloc_type4        nl_type;
+		union {
+			utf8str_cis nl_name;
+			utf8str_cis nl_url;
+			netaddr4    nl_addr;
+		} netloc4_u;
+	} netloc4;
+
+	typedef struct {
+		bool_t          cr_consecutive;
+		bool_t          cr_synchronous;
+	} copy_requirements4;
 
 	struct COPY_NOTIFY4args {
-		stateid4 cna_stateid;
-		netloc_type4        cna_type;
-		union {
-			utf8str_cis cna_name;
-			utf8str_cis cna_url;
-			netaddr4    cna_addr;
-		};
+		stateid4        cna_src_stateid;
+		netloc4         cna_destination_server;
 	};
 	typedef struct COPY_NOTIFY4args COPY_NOTIFY4args;
 
+	/* Inter-server copy is not supported, so only errors are sent */
 	struct COPY_NOTIFY4res {
-		nfstime4 cnr_time;
-		netloc_type4        cna_type;
-		union {
-			utf8str_cis cnr_name;
-			utf8str_cis cnr_url;
-			netaddr4    cnr_addr;
-		};
+		nfsstat4        cnr_status;
 	};
 	typedef struct COPY_NOTIFY4res COPY_NOTIFY4res;
 
-	struct OFFLOAD_REVOKE4args {
-		netloc_type4        ora_type;
-		union {
-			utf8str_cis ora_name;
-			utf8str_cis ora_url;
-			netaddr4    ora_addr;
-		};
-	};
-	typedef struct OFFLOAD_REVOKE4args OFFLOAD_REVOKE4args;
-
-	struct OFFLOAD_REVOKE4res {
-		netloc_type4        orr_type;
-	};
-	typedef struct OFFLOAD_REVOKE4res OFFLOAD_REVOKE4res;
-
 	struct COPY4args {
 		stateid4        ca_src_stateid;
 		stateid4        ca_dst_stateid;
 		offset4         ca_src_offset;
 		offset4         ca_dst_offset;
 		length4         ca_count;
-		netloc_type4        ca_type;
-		union {
-			utf8str_cis ca_name;
-			utf8str_cis ca_url;
-			netaddr4    ca_addr;
-		};
+		bool_t          ca_consecutive;
+		bool_t          ca_synchronous;
+		struct {
+			u_int ca_source_server_len;
+			netloc4 *ca_source_server_val;
+		} ca_source_server;
 	};
 	typedef struct COPY4args COPY4args;
 
+	typedef struct {
+		write_response4    cr_response;
+		copy_requirements4 cr_requirements;
+	} COPY4resok;
+
 	struct COPY4res {
 		nfsstat4 cr_status;
 		union {
-			write_response4 cr_resok4;
-			length4         cr_bytes_copied;
+			COPY4resok         cr_resok4;
+			copy_requirements4 cr_requirements;
 		} COPY4res_u;
 	};
 	typedef struct COPY4res COPY4res;
 
-	struct OFFLOAD_ABORT4args {
-		stateid4        oaa_stateid;
+	struct OFFLOAD_CANCEL4args {
+		stateid4        oca_stateid;
 	};
-	typedef struct OFFLOAD_ABORT4args OFFLOAD_ABORT4args;
+	typedef struct OFFLOAD_CANCEL4args OFFLOAD_CANCEL4args;
 
-	struct OFFLOAD_ABORT4res {
-		stateid4        oar_stateid;
+	struct OFFLOAD_CANCEL4res {
+		nfsstat4        ocr_status;
 	};
-	typedef struct OFFLOAD_ABORT4res OFFLOAD_ABORT4res;
+	typedef struct OFFLOAD_CANCEL4res OFFLOAD_CANCEL4res;
 
 	struct OFFLOAD_STATUS4args {
 		stateid4        osa_stateid;
 	};
 	typedef struct OFFLOAD_STATUS4args OFFLOAD_STATUS4args;
 
+	typedef struct OFFLOAD_STATUS4resok {
+		length4         osr_count;
+		count4          osr_complete_len;	/*< 0 or 1 */
+		nfsstat4        osr_complete;
+	} OFFLOAD_STATUS4resok;
+
 	struct OFFLOAD_STATUS4res {
 		nfsstat4 osr_status;
 		union {
@@ -2644,6 +2638,20 @@ extern "C" {
 	};
 	typedef struct OFFLOAD_STATUS4res OFFLOAD_STATUS4res;
 
+	struct CLONE4args {
+		stateid4        cl_src_stateid;
+		stateid4        cl_dst_stateid;
+		offset4         cl_src_offset;
+		offset4         cl_dst_offset;
+		length4         cl_count;
+	};
+	typedef struct CLONE4args CLONE4args;
+
+	struct CLONE4res {
+		nfsstat4        cl_status;
+	};
+	typedef struct CLONE4res CLONE4res;
+
 	struct WRITE_SAME4args {
 		stateid4        wp_stateid;
 		stable_how4     wp_stable;
@@ -2818,7 +2826,8 @@ extern "C" {
 		NFS4_OP_READ_PLUS = 68,
 		NFS4_OP_SEEK = 69,
 		NFS4_OP_WRITE_SAME = 70,
-		NFS4_OP_LAST_ONE = 71,
+		NFS4_OP_CLONE = 71,
+		NFS4_OP_LAST_ONE = 72,
 
 		NFS4_OP_ILLEGAL = 10044,
 	};
@@ -2919,11 +2928,11 @@ extern "C" {
 			RECLAIM_COMPLETE4args opreclaim_complete;
 
 			/* NFSv4.2 */
-			COPY_NOTIFY4args opoffload_notify;
-			OFFLOAD_REVOKE4args opcopy_revoke;
+			COPY_NOTIFY4args opcopy_notify;
 			COPY4args opcopy;
-			OFFLOAD_ABORT4args opoffload_abort;
+			OFFLOAD_CANCEL4args opoffload_cancel;
 			OFFLOAD_STATUS4args opoffload_status;
+			CLONE4args opclone;
 			WRITE_SAME4args opwrite_plus;
 			ALLOCATE4args opallocate;
 			DEALLOCATE4args opdeallocate;
@@ -2997,11 +3006,11 @@ extern "C" {
 			RECLAIM_COMPLETE4res opreclaim_complete;
 
 			/* NFSv4.2 */
-			COPY_NOTIFY4res opoffload_notify;
-			OFFLOAD_REVOKE4res opcopy_revoke;
+			COPY_NOTIFY4res opcopy_notify;
 			COPY4res opcopy;
-			OFFLOAD_ABORT4res opoffload_abort;
+			OFFLOAD_CANCEL4res opoffload_cancel;
 			OFFLOAD_STATUS4res opoffload_status;
+			CLONE4res opclone;
 			WRITE_SAME4res opwrite_plus;
 			ALLOCATE4res opallocate;
 			DEALLOCATE4res opdeallocate;
@@ -3348,6 +3357,27 @@ extern "C" {
 	};
 	typedef struct CB_NOTIFY_DEVICEID4res CB_NOTIFY_DEVICEID4res;
 
+	/* NFSv4.2 */
+	typedef struct {
+		nfsstat4 coa_status;
+		union {
+			write_response4 coa_resok4;
+			length4 coa_bytes_copied;
+		} offload_info4_u;
+	} offload_info4;
+
+	struct CB_OFFLOAD4args {
+		nfs_fh4 coa_fh;
+		stateid4 coa_stateid;
+		offload_info4 coa_offload_info;
+	};
+	typedef struct CB_OFFLOAD4args CB_OFFLOAD4args;
+
+	struct CB_OFFLOAD4res {
+		nfsstat4 cor_status;
+	};
+	typedef struct CB_OFFLOAD4res CB_OFFLOAD4res;
+
 /* Callback operations new to NFSv4.1 */
 
 	enum nfs_cb_opnum4 {
@@ -3363,6 +3393,7 @@ extern "C" {
 		NFS4_OP_CB_WANTS_CANCELLED = 12,
 		NFS4_OP_CB_NOTIFY_LOCK = 13,
 		NFS4_OP_CB_NOTIFY_DEVICEID = 14,
+		NFS4_OP_CB_OFFLOAD = 15,
 		NFS4_OP_CB_ILLEGAL = 10044,
 	};
 	typedef enum nfs_cb_opnum4 nfs_cb_opnum4;
@@ -3382,6 +3413,7 @@ extern "C" {
 			CB_WANTS_CANCELLED4args opcbwants_cancelled;
 			CB_NOTIFY_LOCK4args opcbnotify_lock;
 			CB_NOTIFY_DEVICEID4args opcbnotify_deviceid;
+			CB_OFFLOAD4args opcboffload;
 		} nfs_cb_argop4_u;
 	};
 	typedef struct nfs_cb_argop4 nfs_cb_argop4;
@@ -3401,6 +3433,7 @@ extern "C" {
 			CB_WANTS_CANCELLED4res opcbwants_cancelled;
 			CB_NOTIFY_LOCK4res opcbnotify_lock;
 			CB_NOTIFY_DEVICEID4res opcbnotify_deviceid;
+			CB_OFFLOAD4res opcboffload;
 			CB_ILLEGAL4res opcbillegal;
 		} nfs_cb_resop4_u;
 	};
@@ -7524,8 +7557,8 @@ extern "C" {
 		return true;
 	}
 
-	static inline bool xdr_WRITE_SAME4resok(XDR * xdrs,
-						write_response4 *objp)
+	static inline bool xdr_write_response4(XDR * xdrs,
+					       write_response4 *objp)
 	{
 		if (!xdr_count4(xdrs, &objp->wr_ids))
 			return false;
@@ -7611,7 +7644,7 @@ extern "C" {
 			return false;
 		switch (objp->wpr_status) {
 		case NFS4_OK:
-			if (!xdr_WRITE_SAME4resok(xdrs,
+			if (!xdr_write_response4(xdrs,
 					&objp->wpr_resok4))
 				return false;
 			break;
@@ -7804,6 +7837,201 @@ extern "C" {
 		return true;
 	}
 
+	static inline bool xdr_netloc4(XDR * xdrs, netloc4 *objp)
+	{
+		if (!inline_xdr_enum(xdrs, (enum_t *)&objp->nl_type))
+			return false;
+		switch (objp->nl_type) {
+		case NL4_NAME:
+			return xdr_utf8str_cis(xdrs, &objp->netloc4_u.nl_name);
+		case NL4_URL:
+			return xdr_utf8str_cis(xdrs, &objp->netloc4_u.nl_url);
+		case NL4_NETADDR:
+			return xdr_netaddr4(xdrs, &objp->netloc4_u.nl_addr);
+		default:
+			return false;
+		}
+	}
+
+	static inline bool xdr_copy_requirements4(XDR * xdrs,
+						  copy_requirements4 *objp)
+	{
+		if (!inline_xdr_bool(xdrs, &objp->cr_consecutive))
+			return false;
+		if (!inline_xdr_bool(xdrs, &objp->cr_synchronous))
+			return false;
+		return true;
+	}
+
+	static inline bool xdr_COPY_NOTIFY4args(XDR * xdrs,
+						COPY_NOTIFY4args *objp)
+	{
+		if (!xdr_stateid4(xdrs, &objp->cna_src_stateid))
+			return false;
+		if (!xdr_netloc4(xdrs, &objp->cna_destination_server))
+			return false;
+		return true;
+	}
+
+	static inline bool xdr_COPY_NOTIFY4res(XDR * xdrs,
+					       COPY_NOTIFY4res *objp)
+	{
+		if (!xdr_nfsstat4(xdrs, &objp->cnr_status))
+			return false;
+		return true;
+	}
+
+	/* Only inter-server copies name source servers, and they are
+	 * refused with NFS4ERR_NOTSUPP whatever the list holds.  So when
+	 * decoding, only the first entry is kept and any others are
+	 * decoded and dropped, rather than allocating for a list of any
+	 * length the client cares to send. */
+	static inline bool xdr_COPY4_source_server(XDR * xdrs,
+						   COPY4args *objp)
+	{
+		netloc4 **val = &objp->ca_source_server.ca_source_server_val;
+		u_int *len = &objp->ca_source_server.ca_source_server_len;
+		netloc4 skip;
+		u_int count;
+
+		if (xdrs->x_op != XDR_DECODE)
+			return xdr_array(xdrs, (char **)val, len, 1,
+					 sizeof(netloc4),
+					 (xdrproc_t) xdr_netloc4);
+
+		if (!inline_xdr_u_int(xdrs, &count))
+			return false;
+		*len = 0;
+		if (count == 0)
+			return true;
+		if (!xdr_reference(xdrs, (char **)val, sizeof(netloc4),
+				   (xdrproc_t) xdr_netloc4))
+			return false;
+		*len = 1;
+		while (--count > 0) {
+			memset(&skip, 0, sizeof(skip));
+			if (!xdr_netloc4(xdrs, &skip)) {
+				xdr_free((xdrproc_t) xdr_netloc4, &skip);
+				return false;
+			}
+			xdr_free((xdrproc_t) xdr_netloc4, &skip);
+		}
+		return true;
+	}
+
+	static inline bool xdr_COPY4args(XDR * xdrs, COPY4args *objp)
+	{
+		if (!xdr_stateid4(xdrs, &objp->ca_src_stateid))
+			return false;
+		if (!xdr_stateid4(xdrs, &objp->ca_dst_stateid))
+			return false;
+		if (!xdr_offset4(xdrs, &objp->ca_src_offset))
+			return false;
+		if (!xdr_offset4(xdrs, &objp->ca_dst_offset))
+			return false;
+		if (!xdr_length4(xdrs, &objp->ca_count))
+			return false;
+		if (!inline_xdr_bool(xdrs, &objp->ca_consecutive))
+			return false;
+		if (!inline_xdr_bool(xdrs, &objp->ca_synchronous))
+			return false;
+		if (!xdr_COPY4_source_server(xdrs, objp))
+			return false;
+		return true;
+	}
+
+	static inline bool xdr_COPY4res(XDR * xdrs, COPY4res *objp)
+	{
+		if (!xdr_nfsstat4(xdrs, &objp->cr_status))
+			return false;
+		switch (objp->cr_status) {
+		case NFS4_OK:
+			if (!xdr_write_response4(xdrs,
+				&objp->COPY4res_u.cr_resok4.cr_response))
+				return false;
+			if (!xdr_copy_requirements4(xdrs,
+				&objp->COPY4res_u.cr_resok4.cr_requirements))
+				return false;
+			break;
+		case NFS4ERR_OFFLOAD_NO_REQS:
+			if (!xdr_copy_requirements4(xdrs,
+				&objp->COPY4res_u.cr_requirements))
+				return false;
+			break;
+		default:
+			break;
+		}
+		return true;
+	}
+
+	static inline bool xdr_OFFLOAD_CANCEL4args(XDR * xdrs,
+						   OFFLOAD_CANCEL4args *objp)
+	{
+		if (!xdr_stateid4(xdrs, &objp->oca_stateid))
+			return false;
+		return true;
+	}
+
+	static inline bool xdr_OFFLOAD_CANCEL4res(XDR * xdrs,
+						  OFFLOAD_CANCEL4res *objp)
+	{
+		if (!xdr_nfsstat4(xdrs, &objp->ocr_status))
+			return false;
+		return true;
+	}
+
+	static inline bool xdr_OFFLOAD_STATUS4args(XDR * xdrs,
+						   OFFLOAD_STATUS4args *objp)
+	{
+		if (!xdr_stateid4(xdrs, &objp->osa_stateid))
+			return false;
+		return true;
+	}
+
+	static inline bool xdr_OFFLOAD_STATUS4res(XDR * xdrs,
+						  OFFLOAD_STATUS4res *objp)
+	{
+		OFFLOAD_STATUS4resok *resok;
+
+		if (!xdr_nfsstat4(xdrs, &objp->osr_status))
+			return false;
+		if (objp->osr_status != NFS4_OK)
+			return true;
+		resok = &objp->OFFLOAD_STATUS4res_u.osr_resok4;
+		if (!xdr_length4(xdrs, &resok->osr_count))
+			return false;
+		if (!xdr_count4(xdrs, &resok->osr_complete_len))
+			return false;
+		if (resok->osr_complete_len > 1)
+			return false;
+		if (resok->osr_complete_len == 1)
+			if (!xdr_nfsstat4(xdrs, &resok->osr_complete))
+				return false;
+		return true;
+	}
+
+	static inline bool xdr_CLONE4args(XDR * xdrs, CLONE4args *objp)
+	{
+		if (!xdr_stateid4(xdrs, &objp->cl_src_stateid))
+			return false;
+		if (!xdr_stateid4(xdrs, &objp->cl_dst_stateid))
+			return false;
+		if (!xdr_offset4(xdrs, &objp->cl_src_offset))
+			return false;
+		if (!xdr_offset4(xdrs, &objp->cl_dst_offset))
+			return false;
+		if (!xdr_length4(xdrs, &objp->cl_count))
+			return false;
+		return true;
+	}
+
+	static inline bool xdr_CLONE4res(XDR * xdrs, CLONE4res *objp)
+	{
+		if (!xdr_nfsstat4(xdrs, &objp->cl_status))
+			return false;
+		return true;
+	}
+
 /* new operations for NFSv4.1 */
 
 	static inline bool xdr_nfs_opnum4(XDR * xdrs, nfs_opnum4 *objp)
@@ -8149,9 +8377,29 @@ extern "C" {
 			break;
 
 		case NFS4_OP_COPY:
+			if (!xdr_COPY4args(xdrs,
+					&objp->nfs_argop4_u.opcopy))
+				return false;
+			break;
 		case NFS4_OP_COPY_NOTIFY:
+			if (!xdr_COPY_NOTIFY4args(xdrs,
+					&objp->nfs_argop4_u.opcopy_notify))
+				return false;
+			break;
 		case NFS4_OP_OFFLOAD_CANCEL:
+			if (!xdr_OFFLOAD_CANCEL4args(xdrs,
+					&objp->nfs_argop4_u.opoffload_cancel))
+				return false;
+			break;
 		case NFS4_OP_OFFLOAD_STATUS:
+			if (!xdr_OFFLOAD_STATUS4args(xdrs,
+					&objp->nfs_argop4_u.opoffload_status))
+				return false;
+			break;
+		case NFS4_OP_CLONE:
+			if (!xdr_CLONE4args(xdrs,
+					&objp->nfs_argop4_u.opclone))
+				return false;
 			break;
 
 		case NFS4_OP_ILLEGAL:
@@ -8476,9 +8724,30 @@ extern "C" {
 			break;
 
 		case NFS4_OP_COPY:
+			if (!xdr_COPY4res(xdrs,
+					&objp->nfs_resop4_u.opcopy))
+				return false;
+			break;
 		case NFS4_OP_COPY_NOTIFY:
+			if (!xdr_COPY_NOTIFY4res(xdrs,
+					&objp->nfs_resop4_u.opcopy_notify))
+				return false;
+			break;
 		case NFS4_OP_OFFLOAD_CANCEL:
+			if (!xdr_OFFLOAD_CANCEL4res(xdrs,
+					&objp->nfs_resop4_u.opoffload_cancel))
+				return false;
+			break;
 		case NFS4_OP_OFFLOAD_STATUS:
+			if (!xdr_OFFLOAD_STATUS4res(xdrs,
+					&objp->nfs_resop4_u.opoffload_status))
+				return false;
+			break;
+		case NFS4_OP_CLONE:
+			if (!xdr_CLONE4res(xdrs,
+					&objp->nfs_resop4_u.opclone))
+				return false;
+			break;
 
 		case NFS4_OP_ILLEGAL:
 			if (!xdr_ILLEGAL4res
@@ -9052,6 +9321,31 @@ extern "C" {
 		return true;
 	}
 
+	static inline bool xdr_CB_OFFLOAD4args(XDR * xdrs,
+					       CB_OFFLOAD4args *objp)
+	{
+		offload_info4 *info = &objp->coa_offload_info;
+
+		if (!xdr_nfs_fh4(xdrs, &objp->coa_fh))
+			return false;
+		if (!xdr_stateid4(xdrs, &objp->coa_stateid))
+			return false;
+		if (!xdr_nfsstat4(xdrs, &info->coa_status))
+			return false;
+		if (info->coa_status == NFS4_OK)
+			return xdr_write_response4(xdrs,
+					&info->offload_info4_u.coa_resok4);
+		return xdr_length4(xdrs,
+				   &info->offload_info4_u.coa_bytes_copied);
+	}
+
+	static inline bool xdr_CB_OFFLOAD4res(XDR * xdrs, CB_OFFLOAD4res *objp)
+	{
+		if (!xdr_nfsstat4(xdrs, &objp->cor_status))
+			return false;
+		return true;
+	}
+
 /* Callback operations new to NFSv4.1 */
 
 	static inline bool xdr_nfs_cb_opnum4(XDR * xdrs, nfs_cb_opnum4 *objp)
@@ -9127,6 +9421,11 @@ extern "C" {
 			    (xdrs, &objp->nfs_cb_argop4_u.opcbnotify_deviceid))
 				return false;
 			break;
+		case NFS4_OP_CB_OFFLOAD:
+			if (!xdr_CB_OFFLOAD4args
+			    (xdrs, &objp->nfs_cb_argop4_u.opcboffload))
+				return false;
+			break;
 		case NFS4_OP_CB_ILLEGAL:
 			break;
 		default:
@@ -9201,6 +9500,11 @@ extern "C" {
 			    (xdrs, &objp->nfs_cb_resop4_u.opcbnotify_deviceid))
 				return false;
 			break;
+		case NFS4_OP_CB_OFFLOAD:
+			if (!xdr_CB_OFFLOAD4res
+			    (xdrs, &objp->nfs_cb_resop4_u.opcboffload))
+				return false;
+			break;
 		case NFS4_OP_CB_ILLEGAL:
 			if (!xdr_CB_ILLEGAL4res
 			    (xdrs, &objp->nfs_cb_resop4_u.opcbillegal))
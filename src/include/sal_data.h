@@ -49,6 +49,7 @@
 #include "hashtable.h"
 #include "fsal_pnfs.h"
 #include "config_parsing.h"
+#include "gsh_timer_wheel.h"
 
 #ifdef _USE_9P
 /* define u32 and related types independent of SAL and 9P */
@@ -116,10 +117,10 @@ extern pool_t *nfs41_session_pool;
 extern hash_table_t *ht_session_id;
 
 /**
- * @brief Number of forechannel slots in a session
+ * @brief Number of backchannel slots we'll use
  *
- * This is also the maximum number of backchannel slots we'll use,
- * even if the client offers more.
+ * Even if the client offers more.  The forechannel slot table is sized
+ * in CREATE_SESSION, see Max_Session_Slots.
  */
 #define NFS41_NB_SLOTS 3
 
@@ -134,6 +135,8 @@ typedef struct nfs41_session_slot__ {
 							   cached RPC result in
 							   a session's slot */
 	unsigned int cache_used;	/*< If we cached the result */
+	size_t cache_size;	/*< Bytes the cached result takes */
+	bool in_progress;	/*< A request on the slot has not replied */
 } nfs41_session_slot_t;
 
 /**
@@ -172,7 +175,11 @@ struct nfs41_session {
 	SVCXPRT *xprt;		/*< Referenced pointer to transport */
 
 	channel_attrs4 fore_channel_attrs;	/*< Fore-channel attributes */
-	nfs41_session_slot_t slots[NFS41_NB_SLOTS];	/*< Slot table */
+	nfs41_session_slot_t *slots;	/*< Slot table, ca_maxrequests
+					   long */
+	uint32_t target_highest_slotid;	/*< Highest slot we want the client
+					   to use, follows the pressure on
+					   the slot reply cache */
 
 	channel_attrs4 back_channel_attrs;	/*< Back-channel attributes */
 	nfs41_cb_session_slot_t cb_slots[NFS41_NB_SLOTS];	/*< Callback
@@ -555,6 +562,8 @@ struct state_nfs4_owner_t {
 	struct glist_head so_perclient;  /*< open owner entry to be
 					   linked to client */
 	time_t last_close_time; /* time last CLOSE op performed */
+	struct gsh_timer so_close_timer; /*< Reaps the owner a lease after
+					     last_close_time */
 };
 
 /**
@@ -633,6 +642,8 @@ struct nfs_client_id_t {
 	verifier4 cid_verifier;	/*< Known verifier */
 	verifier4 cid_incoming_verifier; /*< Most recently supplied verifier */
 	time_t cid_last_renew;	/*< Time of last renewal */
+	struct gsh_timer cid_lease_timer; /*< Fires when the lease may have
+					      expired, holds a reference */
 	nfs_clientid_confirm_state_t cid_confirmed; /*< Confirm/expire state */
 	nfs_client_cred_t cid_credential;	/*< Client credential */
 	int cid_allow_reclaim;	/*< Whether this client can still
@@ -789,6 +800,9 @@ struct state_block_data_t {
 
 struct state_lock_entry_t {
 	struct glist_head sle_list;	/*< Locks on this file */
+	struct gsh_itree_node sle_range; /*< Link in the file's lock tree */
+	struct glist_head sle_blocked_list; /*< Link on the file's blocked
+					       lock list */
 	struct glist_head sle_owner_locks; /*< Link on the owner lock list */
 	struct glist_head sle_locks;	/*< Locks on this state/client */
 #ifdef DEBUG_SAL
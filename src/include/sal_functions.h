@@ -313,6 +313,11 @@ int nfs41_Session_Get_Pointer(char sessionid[NFS4_SESSIONID_SIZE],
 
 int nfs41_Session_Del(char sessionid[NFS4_SESSIONID_SIZE]);
 void nfs41_Build_sessionid(clientid4 *clientid, char *sessionid);
+bool nfs41_Session_Alloc_Slots(nfs41_session_t *session, uint32_t nb_slots);
+bool nfs41_Session_Slot_Reserve(size_t size);
+void nfs41_Session_Slot_Release(nfs41_session_slot_t *slot);
+uint32_t nfs41_Session_Target_Slotid(nfs41_session_t *session);
+void nfs41_Session_Trim_Slots(nfs41_session_t *session, slotid4 highest);
 void nfs41_Session_PrintAll(void);
 
 /******************************************************************************
@@ -386,6 +391,10 @@ uint64_t state_id_rbt_hash_func(hash_parameter_t *hparam,
 int reserve_lease(nfs_client_id_t *clientid);
 void update_lease(nfs_client_id_t *clientid);
 bool valid_lease(nfs_client_id_t *clientid);
+void nfs4_init_lease_timers(void);
+void start_lease_timer(nfs_client_id_t *clientid);
+void stop_lease_timer(nfs_client_id_t *clientid);
+nfs_client_id_t *get_lease_timer_fired(time_t now);
 
 /******************************************************************************
  *
@@ -445,6 +454,9 @@ state_owner_t *create_nfs4_owner(state_nfs4_owner_name_t *name,
 				 care_t care);
 
 int Init_nfs4_owner(void);
+void start_open_owner_timer(state_owner_t *owner, time_t tclose);
+void stop_open_owner_timer(state_owner_t *owner);
+int reap_expired_open_owners(void);
 
 void Process_nfs4_conflict(/* NFS v4 Lock4denied structure to fill in */
 			   LOCK4denied * denied,
@@ -40,8 +40,15 @@
 #define SERVER_STATS_H
 
 #include <sys/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "gsh_types.h"
 
-void server_stats_nfs_done(request_data_t *reqdata, int rc, bool dup);
+struct gsh_client;
+struct request_data;
+
+void server_stats_init(void);
+void server_stats_nfs_done(struct request_data *reqdata, int rc, bool dup);
 
 void server_stats_io_done(size_t requested,
 			  size_t transferred, bool success, bool is_write);
@@ -53,6 +60,42 @@ void server_stats_transport_done(struct gsh_client *client,
 				uint64_t rx_err, uint64_t tx_bytes,
 				uint64_t tx_pkt, uint64_t tx_err);
 
+/* For latency histograms */
+
+/**
+ * @brief FSAL methods timed into latency histograms
+ */
+enum fsal_lat_op {
+	FSAL_LAT_LOOKUP,
+	FSAL_LAT_READDIR,
+	FSAL_LAT_GETATTRS,
+	FSAL_LAT_SETATTRS,
+	FSAL_LAT_CREATE,
+	FSAL_LAT_MKDIR,
+	FSAL_LAT_MKNODE,
+	FSAL_LAT_SYMLINK,
+	FSAL_LAT_READLINK,
+	FSAL_LAT_LINK,
+	FSAL_LAT_RENAME,
+	FSAL_LAT_UNLINK,
+	FSAL_LAT_OPEN,
+	FSAL_LAT_REOPEN,
+	FSAL_LAT_CLOSE,
+	FSAL_LAT_READ,
+	FSAL_LAT_WRITE,
+	FSAL_LAT_COMMIT,
+	FSAL_LAT_LOCK_OP,
+	FSAL_LAT_COPY,
+	FSAL_LAT_OPS
+};
+
+nsecs_elapsed_t server_stats_clock(void);
+void server_stats_fsal_done(enum fsal_lat_op op, nsecs_elapsed_t start_time);
+void server_stats_9p_done(uint8_t msgtype, nsecs_elapsed_t start_time);
+void server_stats_queue_done(uint32_t lane, nsecs_elapsed_t queue_wait);
+void server_stats_commit_done(nsecs_elapsed_t start_time);
+void server_stats_commit_batch(uint32_t commits, uint32_t files);
+
 /* For delegations */
 void inc_grants(struct gsh_client *client);
 void dec_grants(struct gsh_client *client);
@@ -60,5 +103,11 @@ void inc_revokes(struct gsh_client *client);
 void inc_recalls(struct gsh_client *client);
 void inc_failed_recalls(struct gsh_client *client);
 
+/* For NFSv4.1 session slots */
+void server_stats_session_slots(struct gsh_client *client, uint32_t nb_slots);
+void server_stats_slot_start(struct gsh_client *client, uint32_t target);
+void server_stats_slot_done(struct gsh_client *client, bool cached);
+void server_stats_slot_replay(struct gsh_client *client);
+
 #endif				/* !SERVER_STATS_H */
 /** @} */
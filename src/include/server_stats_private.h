@@ -59,6 +59,7 @@ struct nfsv40_stats;
 struct nfsv41_stats;
 struct nfsv42_stats;
 struct deleg_stats;
+struct slot_stats;
 struct _9p_stats;
 
 struct gsh_stats {
@@ -71,6 +72,7 @@ struct gsh_stats {
 	struct nfsv41_stats *nfsv42;
 	struct deleg_stats *deleg;
 	struct _9p_stats *_9p;
+	struct slot_stats *slots;
 };
 
 /**
@@ -210,6 +212,15 @@ struct export_stats {
 	.direction = "out"	       \
 }
 
+/* slots of the latest session, target highest slot, busy slots,
+ * most busy slots, requests, replays, replies not cached */
+#define SLOTS_REPLY		       \
+{				       \
+	.name = "session_slot_stats",  \
+	.type = "(uuuuttt)",	       \
+	.direction = "out"	       \
+}
+
 #define NFS_ALL_IO_REPLY_ARRAY_TYPE "(qs(tttttt)(tttttt))"
 #define NFS_ALL_IO_REPLY			\
 {						\
@@ -219,6 +230,32 @@ struct export_stats {
 	.direction = "out"			\
 }						\
 
+#define LATENCY_REPLY_ARRAY_TYPE "(sttttttt)"
+#define LATENCY_REPLY				\
+{						\
+	.name = "latencies",			\
+	.type = DBUS_TYPE_ARRAY_AS_STRING	\
+		LATENCY_REPLY_ARRAY_TYPE,	\
+	.direction = "out"			\
+}
+
+#define COMMIT_REPLY				\
+{						\
+	.name = "commits",			\
+	.type = DBUS_TYPE_ARRAY_AS_STRING	\
+		LATENCY_REPLY_ARRAY_TYPE,	\
+	.direction = "out"			\
+}
+
+#define POOL_REPLY_ARRAY_TYPE "(sttttttt)"
+#define POOL_REPLY				\
+{						\
+	.name = "pools",			\
+	.type = DBUS_TYPE_ARRAY_AS_STRING	\
+		POOL_REPLY_ARRAY_TYPE,		\
+	.direction = "out"			\
+}
+
 void server_stats_summary(DBusMessageIter *iter, struct gsh_stats *st);
 void server_dbus_v3_iostats(struct nfsv3_stats *v3p, DBusMessageIter *iter);
 void server_dbus_v40_iostats(struct nfsv40_stats *v40p, DBusMessageIter *iter);
@@ -227,6 +264,7 @@ void server_dbus_v41_layouts(struct nfsv41_stats *v41p, DBusMessageIter *iter);
 void server_dbus_v42_iostats(struct nfsv41_stats *v42p, DBusMessageIter *iter);
 void server_dbus_v42_layouts(struct nfsv41_stats *v42p, DBusMessageIter *iter);
 void server_dbus_delegations(struct deleg_stats *ds, DBusMessageIter *iter);
+void server_dbus_session_slots(struct slot_stats *ss, DBusMessageIter *iter);
 void server_dbus_all_iostats(struct export_stats *export_statistics,
 			     DBusMessageIter *iter);
 void server_dbus_total_ops(struct export_stats *export_st,
@@ -234,6 +272,10 @@ void server_dbus_total_ops(struct export_stats *export_st,
 void global_dbus_total_ops(DBusMessageIter *iter);
 void server_dbus_fast_ops(DBusMessageIter *iter);
 void cache_inode_dbus_show(DBusMessageIter *iter);
+void req_queue_dbus_show(DBusMessageIter *iter);
+void server_dbus_latencies(DBusMessageIter *iter);
+void server_dbus_pools(DBusMessageIter *iter);
+void server_dbus_commits(DBusMessageIter *iter);
 
 void server_dbus_9p_iostats(struct _9p_stats *_9pp, DBusMessageIter *iter);
 void server_dbus_9p_transstats(struct _9p_stats *_9pp, DBusMessageIter *iter);
@@ -242,8 +284,7 @@ void server_dbus_9p_rdmastats(struct _9p_stats *_9pp, DBusMessageIter *iter);
 #endif				/* USE_DBUS */
 
 void server_stats_free(struct gsh_stats *statsp);
-
-void server_stats_init(void);
+void server_stats_latency_reset(void);
 
 #endif				/* !SERVER_STATS_PRIVATE_H */
 /** @} */
@@ -43,12 +43,15 @@
 #include <libgen.h>
 #include <execinfo.h>
 #include <sys/resource.h>
+#include <sys/uio.h>
+#include <inttypes.h>
 
 #include "log.h"
 #include "gsh_list.h"
 #include "rpc/rpc.h"
 #include "common_utils.h"
 #include "abstract_mem.h"
+#include "abstract_atomic.h"
 
 #ifdef USE_DBUS
 #include "gsh_dbus.h"
@@ -224,6 +227,8 @@ static int log_to_stream(log_header_t headers, void *private,
 			 struct display_buffer *buffer, char *compstr,
 			 char *message);
 
+static struct log_file *log_file_get(const char *path);
+
 static struct glist_head facility_list;
 static struct glist_head active_facility_list;
 
@@ -747,9 +752,10 @@ int create_log_facility(char *name,
 	facility->lf_max_level = max_level;
 	facility->lf_headers = header;
 	if (log_func == log_to_file && private != NULL) {
-		facility->lf_private = gsh_strdup(private);
+		facility->lf_private = log_file_get(private);
 		if (facility->lf_private == NULL) {
 			PTHREAD_RWLOCK_unlock(&log_rwlock);
+			gsh_free(facility->lf_name);
 			gsh_free(facility);
 
 			return -ENOMEM;
@@ -803,9 +809,6 @@ void release_log_facility(char *name)
 		glist_del(&facility->lf_active);
 	glist_del(&facility->lf_list);
 	PTHREAD_RWLOCK_unlock(&log_rwlock);
-	if (facility->lf_func == log_to_file &&
-	    facility->lf_private != NULL)
-		gsh_free(facility->lf_private);
 	gsh_free(facility->lf_name);
 	gsh_free(facility);
 	return;
@@ -993,7 +996,8 @@ int set_log_destination(char *name, char *dest)
 		return -ENOENT;
 	}
 	if (facility->lf_func == log_to_file) {
-		char *logfile, *dir;
+		struct log_file *logfile;
+		char *dir;
 
 		dir = alloca(strlen(dest) + 1);
 		strcpy(dir, dest);
@@ -1006,7 +1010,7 @@ int set_log_destination(char *name, char *dest)
 				dest, strerror(errno));
 			return -errno;
 		}
-		logfile = gsh_strdup(dest);
+		logfile = log_file_get(dest);
 		if (logfile == NULL) {
 			PTHREAD_RWLOCK_unlock(&log_rwlock);
 			LogCrit(COMPONENT_LOG,
@@ -1014,8 +1018,6 @@ int set_log_destination(char *name, char *dest)
 				dest, facility->lf_name);
 			return -ENOMEM;
 		}
-		if (facility->lf_private != NULL)
-			gsh_free(facility->lf_private);
 		facility->lf_private = logfile;
 	} else if (facility->lf_func == log_to_stream) {
 		FILE *out;
@@ -1190,26 +1192,164 @@ static int log_to_syslog(log_header_t headers, void *private,
 	return 0;
 }
 
-static int log_to_file(log_header_t headers, void *private,
-		       log_levels_t level,
-		       struct display_buffer *buffer, char *compstr,
-		       char *message)
+/**
+ * @brief Asynchronous file logging
+ *
+ * Threads that log to a file facility append formatted lines to a
+ * private single producer ring and return without touching the file.
+ * A single writer thread drains the rings, coalescing consecutive
+ * records for the same file into one writev().  Log files stay open
+ * and their durability is chosen by the LOG block: none, a periodic
+ * fsync, or O_SYNC.  When a ring is full the message is dropped and
+ * counted rather than blocking the caller; the writer reports the
+ * count in the log.  Ordering is preserved within a thread, messages
+ * from different threads are interleaved per batch.
+ */
+
+enum log_durability {
+	LOG_DURABILITY_NONE,
+	LOG_DURABILITY_PERIODIC,
+	LOG_DURABILITY_SYNC
+};
+
+/* How long the writer sleeps when nobody kicks it */
+#define LOG_WRITER_LATENCY_MS 100
+
+/* iovecs gathered for one writev */
+#define LOG_WRITER_IOV 64
+
+/**
+ * @brief An open log file
+ *
+ * Shared by every facility logging to the same path.  These are never
+ * freed so records still queued for a file stay valid after its
+ * facility goes away.  The fd and dirty flag belong to the writer.
+ */
+
+struct log_file {
+	struct glist_head lf_list;	/*< List of log files */
+	int fd;				/*< Open descriptor or -1 */
+	bool dirty;			/*< Written since last fsync */
+	char path[];			/*< Path of the file */
+};
+
+static struct glist_head log_files = GLIST_HEAD_INIT(log_files);
+static pthread_mutex_t log_files_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Record header in a log ring
+ *
+ * Records are padded to 16 bytes.  A NULL file marks the unused tail
+ * of the ring before it wraps.
+ */
+
+struct log_rec {
+	uint32_t len;
+	uint32_t pad;
+	struct log_file *lf;
+};
+
+#define LOG_REC_ALIGN 16
+#define LOG_REC_SIZE(len) \
+	((sizeof(struct log_rec) + (len) + LOG_REC_ALIGN - 1) & \
+	 ~(LOG_REC_ALIGN - 1))
+
+/**
+ * @brief Per-thread log ring
+ *
+ * head is only written by the owning thread, tail only by the writer.
+ */
+
+struct log_ring {
+	struct glist_head lr_list;	/*< List of rings */
+	uint64_t head;			/*< Producer position */
+	uint64_t dropped;		/*< Messages lost to a full ring */
+	int32_t dead;			/*< Owning thread has exited */
+	uint32_t size;			/*< Power of two */
+	 CACHE_PAD(0);
+	uint64_t tail;			/*< Writer position */
+	 CACHE_PAD(1);
+	char buf[];
+};
+
+static struct log_writer {
+	pthread_t thread;		/*< The writer */
+	pthread_mutex_t mtx;		/*< Protects the wait */
+	pthread_cond_t cv;		/*< Kicks the writer */
+	pthread_mutex_t ring_mtx;	/*< Protects rings */
+	struct glist_head rings;	/*< Registered rings */
+	bool started;			/*< Thread exists */
+	int32_t running;		/*< Producers may queue */
+	int32_t reopen;			/*< Close and reopen log files */
+	uint32_t durability;		/*< enum log_durability */
+	uint32_t fsync_interval;	/*< Seconds between fsyncs */
+	uint32_t ring_size;		/*< Size of new rings */
+	uint64_t dropped_retired;	/*< Drops from freed rings */
+	uint64_t dropped_reported;	/*< Drops already logged */
+} log_writer = {
+	.mtx = PTHREAD_MUTEX_INITIALIZER,
+	.cv = PTHREAD_COND_INITIALIZER,
+	.ring_mtx = PTHREAD_MUTEX_INITIALIZER,
+	.rings = GLIST_HEAD_INIT(log_writer.rings),
+	.durability = LOG_DURABILITY_PERIODIC,
+	.fsync_interval = 1,
+	.ring_size = 65536,
+};
+
+static __thread struct log_ring *log_ring_self;
+static __thread bool log_ring_exited;	/*< Ring handed to the writer */
+static pthread_key_t log_ring_key;
+static pthread_once_t log_writer_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Find or create the log file for a path
+ *
+ * @param[in] path Path of the log file
+ *
+ * @return The log file or NULL if out of memory.
+ */
+
+static struct log_file *log_file_get(const char *path)
 {
-	int fd, my_status, len, rc = 0;
-	char *path = private;
+	struct glist_head *glist;
+	struct log_file *lf;
+	size_t len = strlen(path) + 1;
 
-	len = display_buffer_len(buffer);
+	pthread_mutex_lock(&log_files_mtx);
+	glist_for_each(glist, &log_files) {
+		lf = glist_entry(glist, struct log_file, lf_list);
+		if (strcmp(lf->path, path) == 0)
+			goto out;
+	}
+	lf = gsh_malloc(sizeof(*lf) + len);
+	if (lf != NULL) {
+		lf->fd = -1;
+		lf->dirty = false;
+		memcpy(lf->path, path, len);
+		glist_add_tail(&log_files, &lf->lf_list);
+	}
+ out:
+	pthread_mutex_unlock(&log_files_mtx);
+	return lf;
+}
 
-	/* Add newline to end of buffer */
-	buffer->b_start[len] = '\n';
-	buffer->b_start[len + 1] = '\0';
+/**
+ * @brief Synchronously append one line to a log file
+ *
+ * Used before the writer is started, when it is disabled, and for a
+ * fatal message that does not fit in the ring.
+ */
+
+static int log_file_write_sync(struct log_file *lf, char *buf, int len)
+{
+	int fd, my_status, rc = 0;
 
-	fd = open(path, O_WRONLY | O_SYNC | O_APPEND | O_CREAT, log_mask);
+	fd = open(lf->path, O_WRONLY | O_SYNC | O_APPEND | O_CREAT, log_mask);
 
 	if (fd != -1) {
-		rc = write(fd, buffer->b_start, len + 1);
+		rc = write(fd, buf, len);
 
-		if (rc < (len + 1)) {
+		if (rc < len) {
 			if (rc >= 0)
 				my_status = ENOSPC;
 			else
@@ -1223,7 +1363,7 @@ static int log_to_file(log_header_t headers, void *private,
 		rc = close(fd);
 
 		if (rc == 0)
-			goto out;
+			return 0;
 	}
 
 	my_status = errno;
@@ -1232,8 +1372,426 @@ static int log_to_file(log_header_t headers, void *private,
 
 	fprintf(stderr,
 		"Error: couldn't complete write to the log file %s"
-		"status=%d (%s) message was:\n%s", path, my_status,
-		strerror(my_status), buffer->b_start);
+		"status=%d (%s) message was:\n%s", lf->path, my_status,
+		strerror(my_status), buf);
+
+	return rc;
+}
+
+/**
+ * @brief Write a batch of records to a log file from the writer
+ *
+ * Opens the file on first use and restarts after short writes.  On
+ * error the batch is reported on stderr and discarded.
+ */
+
+static void log_file_writev(struct log_file *lf, struct iovec *iov, int cnt)
+{
+	ssize_t rc;
+	int flags = O_WRONLY | O_APPEND | O_CREAT;
+
+	if (lf->fd < 0) {
+		if (log_writer.durability == LOG_DURABILITY_SYNC)
+			flags |= O_SYNC;
+		lf->fd = open(lf->path, flags, log_mask);
+		if (lf->fd < 0)
+			goto error;
+	}
+
+	while (cnt > 0) {
+		rc = writev(lf->fd, iov, cnt);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			goto error;
+		}
+		lf->dirty = true;
+		while (cnt > 0 && (size_t)rc >= iov->iov_len) {
+			rc -= iov->iov_len;
+			iov++;
+			cnt--;
+		}
+		if (cnt > 0) {
+			iov->iov_base = (char *)iov->iov_base + rc;
+			iov->iov_len -= rc;
+		}
+	}
+	return;
+
+ error:
+	fprintf(stderr,
+		"Error: couldn't complete write to the log file %s"
+		"status=%d (%s), %d messages lost\n", lf->path, errno,
+		strerror(errno), cnt);
+}
+
+/**
+ * @brief Create the calling thread's log ring
+ */
+
+static struct log_ring *log_ring_register(void)
+{
+	struct log_ring *ring;
+	uint32_t size = atomic_fetch_uint32_t(&log_writer.ring_size);
+
+	ring = gsh_malloc(sizeof(*ring) + size);
+	if (ring == NULL)
+		return NULL;
+	memset(ring, 0, sizeof(*ring));
+	ring->size = size;
+	(void)pthread_setspecific(log_ring_key, ring);
+
+	pthread_mutex_lock(&log_writer.ring_mtx);
+	glist_add_tail(&log_writer.rings, &ring->lr_list);
+	pthread_mutex_unlock(&log_writer.ring_mtx);
+
+	log_ring_self = ring;
+	return ring;
+}
+
+/**
+ * @brief Thread exit destructor, the writer frees the drained ring
+ *
+ * Anything the thread logs after this, from another destructor say,
+ * is written synchronously rather than through the freed ring.
+ */
+
+static void log_ring_exit(void *arg)
+{
+	struct log_ring *ring = arg;
+
+	log_ring_self = NULL;
+	log_ring_exited = true;
+	atomic_store_int32_t(&ring->dead, 1);
+}
+
+/**
+ * @brief Queue a line for the writer
+ *
+ * @param[in] lf  Log file
+ * @param[in] buf Line including its newline
+ * @param[in] len Length of the line
+ *
+ * @retval true if queued.
+ * @retval false if the ring is full or could not be created.
+ */
+
+static bool log_ring_push(struct log_file *lf, const char *buf, size_t len)
+{
+	struct log_ring *ring = log_ring_self;
+	struct log_rec *rec;
+	uint64_t head, tail, need, contig, off;
+
+	if (ring == NULL) {
+		ring = log_ring_register();
+		if (ring == NULL)
+			return false;
+	}
+
+	need = LOG_REC_SIZE(len);
+	if (need > ring->size / 2)
+		return false;
+
+	head = ring->head;
+	tail = atomic_fetch_uint64_t(&ring->tail);
+	off = head & (ring->size - 1);
+	contig = ring->size - off;
+
+	if (head - tail + (need <= contig ? need : contig + need) > ring->size)
+		return false;
+
+	if (need > contig) {
+		rec = (struct log_rec *)(ring->buf + off);
+		rec->len = 0;
+		rec->lf = NULL;
+		head += contig;
+		off = 0;
+	}
+
+	rec = (struct log_rec *)(ring->buf + off);
+	rec->len = len;
+	rec->lf = lf;
+	memcpy(rec + 1, buf, len);
+	head += need;
+	atomic_store_uint64_t(&ring->head, head);
+
+	if (head - tail > ring->size / 2)
+		pthread_cond_signal(&log_writer.cv);
+
+	return true;
+}
+
+/**
+ * @brief Count a message dropped by the calling thread
+ */
+
+static void log_ring_drop(void)
+{
+	if (log_ring_self != NULL)
+		atomic_inc_uint64_t(&log_ring_self->dropped);
+}
+
+/**
+ * @brief Drain all rings into their files
+ *
+ * Called only by the writer thread.
+ */
+
+static void log_writer_drain(void)
+{
+	struct iovec iov[LOG_WRITER_IOV];
+	struct glist_head *glist, *glistn;
+	struct log_ring *ring;
+	struct log_rec *rec;
+	struct log_file *cur;
+	uint64_t head, tail, off, dropped;
+	int32_t dead;
+	int cnt;
+	char note[128];
+
+	pthread_mutex_lock(&log_writer.ring_mtx);
+	dropped = log_writer.dropped_retired;
+	glist_for_each_safe(glist, glistn, &log_writer.rings) {
+		ring = glist_entry(glist, struct log_ring, lr_list);
+		dead = atomic_fetch_int32_t(&ring->dead);
+		head = atomic_fetch_uint64_t(&ring->head);
+		tail = ring->tail;
+		cur = NULL;
+		cnt = 0;
+
+		while (tail != head) {
+			off = tail & (ring->size - 1);
+			rec = (struct log_rec *)(ring->buf + off);
+			if (rec->lf == NULL) {
+				tail += ring->size - off;
+				continue;
+			}
+			if (cnt == LOG_WRITER_IOV ||
+			    (cnt > 0 && rec->lf != cur)) {
+				log_file_writev(cur, iov, cnt);
+				atomic_store_uint64_t(&ring->tail, tail);
+				cnt = 0;
+			}
+			cur = rec->lf;
+			iov[cnt].iov_base = rec + 1;
+			iov[cnt].iov_len = rec->len;
+			cnt++;
+			tail += LOG_REC_SIZE(rec->len);
+		}
+		if (cnt > 0)
+			log_file_writev(cur, iov, cnt);
+		atomic_store_uint64_t(&ring->tail, tail);
+
+		dropped += atomic_fetch_uint64_t(&ring->dropped);
+		if (dead) {
+			log_writer.dropped_retired +=
+				atomic_fetch_uint64_t(&ring->dropped);
+			glist_del(&ring->lr_list);
+			gsh_free(ring);
+		}
+	}
+	pthread_mutex_unlock(&log_writer.ring_mtx);
+
+	if (dropped == log_writer.dropped_reported)
+		return;
+
+	iov[0].iov_base = note;
+	iov[0].iov_len = snprintf(note, sizeof(note),
+				  "%s: %" PRIu64
+				  " log messages dropped, log buffer full\n",
+				  program_name,
+				  dropped - log_writer.dropped_reported);
+	log_writer.dropped_reported = dropped;
+
+	pthread_mutex_lock(&log_files_mtx);
+	glist_for_each(glist, &log_files) {
+		cur = glist_entry(glist, struct log_file, lf_list);
+		if (cur->fd >= 0) {
+			struct iovec one = iov[0];
+
+			log_file_writev(cur, &one, 1);
+		}
+	}
+	pthread_mutex_unlock(&log_files_mtx);
+}
+
+/**
+ * @brief Flush or close the writer's log files
+ *
+ * @param[in] close_fd Close the files so they are reopened on next write
+ */
+
+static void log_writer_sync_files(bool close_fd)
+{
+	struct glist_head *glist;
+	struct log_file *lf;
+
+	pthread_mutex_lock(&log_files_mtx);
+	glist_for_each(glist, &log_files) {
+		lf = glist_entry(glist, struct log_file, lf_list);
+		if (lf->fd < 0)
+			continue;
+		if (lf->dirty &&
+		    log_writer.durability == LOG_DURABILITY_PERIODIC)
+			(void)fsync(lf->fd);
+		lf->dirty = false;
+		if (close_fd) {
+			(void)close(lf->fd);
+			lf->fd = -1;
+		}
+	}
+	pthread_mutex_unlock(&log_files_mtx);
+}
+
+static void *log_writer_thread(void *arg)
+{
+	struct timespec ts;
+	time_t last_sync = time(NULL), now;
+	int32_t running;
+
+	SetNameFunction("log_writer");
+
+	do {
+		running = atomic_fetch_int32_t(&log_writer.running);
+
+		if (atomic_fetch_int32_t(&log_writer.reopen)) {
+			atomic_store_int32_t(&log_writer.reopen, 0);
+			log_writer_sync_files(true);
+		}
+
+		log_writer_drain();
+
+		now = time(NULL);
+		if (now - last_sync >= log_writer.fsync_interval) {
+			log_writer_sync_files(false);
+			last_sync = now;
+		}
+
+		if (!running)
+			break;
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += LOG_WRITER_LATENCY_MS * 1000000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		pthread_mutex_lock(&log_writer.mtx);
+		(void)pthread_cond_timedwait(&log_writer.cv, &log_writer.mtx,
+					     &ts);
+		pthread_mutex_unlock(&log_writer.mtx);
+	} while (true);
+
+	log_writer_sync_files(true);
+	return NULL;
+}
+
+/**
+ * @brief Stop the writer after a final drain
+ */
+
+static void log_writer_join(void)
+{
+	if (!log_writer.started)
+		return;
+	atomic_store_int32_t(&log_writer.running, 0);
+	pthread_cond_signal(&log_writer.cv);
+	(void)pthread_join(log_writer.thread, NULL);
+	log_writer.started = false;
+}
+
+static void log_writer_once_init(void)
+{
+	(void)pthread_key_create(&log_ring_key, log_ring_exit);
+	(void)atexit(log_writer_join);
+}
+
+/**
+ * @brief Apply the LOG block's file writer settings
+ *
+ * Starts or stops the writer.  A new buffer size applies to threads
+ * that have not logged yet.
+ */
+
+static void log_writer_configure(bool async, uint32_t durability,
+				 uint32_t fsync_interval,
+				 uint32_t buffer_size)
+{
+	uint32_t size = 1;
+	int rc;
+
+	while (size < buffer_size)
+		size <<= 1;
+	atomic_store_uint32_t(&log_writer.ring_size, size);
+	log_writer.fsync_interval = fsync_interval;
+	if (log_writer.durability != durability) {
+		log_writer.durability = durability;
+		atomic_store_int32_t(&log_writer.reopen, 1);
+	}
+
+	if (async && !log_writer.started) {
+		(void)pthread_once(&log_writer_once, log_writer_once_init);
+		atomic_store_int32_t(&log_writer.running, 1);
+		rc = pthread_create(&log_writer.thread, NULL,
+				    log_writer_thread, NULL);
+		if (rc != 0) {
+			atomic_store_int32_t(&log_writer.running, 0);
+			LogCrit(COMPONENT_LOG,
+				"Could not start log writer, logging synchronously: %s",
+				strerror(rc));
+			return;
+		}
+		log_writer.started = true;
+		LogEvent(COMPONENT_LOG, "Started asynchronous log writer");
+	} else if (!async && log_writer.started) {
+		/* Holding the lock out of every facility guarantees no
+		 * thread queues after the writer's final drain.
+		 */
+		PTHREAD_RWLOCK_wrlock(&log_rwlock);
+		atomic_store_int32_t(&log_writer.running, 0);
+		PTHREAD_RWLOCK_unlock(&log_rwlock);
+		log_writer_join();
+		LogEvent(COMPONENT_LOG, "Stopped asynchronous log writer");
+	}
+}
+
+/**
+ * @brief Reopen log files, after they have been rotated
+ */
+
+void log_reopen_files(void)
+{
+	atomic_store_int32_t(&log_writer.reopen, 1);
+	pthread_cond_signal(&log_writer.cv);
+}
+
+static int log_to_file(log_header_t headers, void *private,
+		       log_levels_t level,
+		       struct display_buffer *buffer, char *compstr,
+		       char *message)
+{
+	struct log_file *lf = private;
+	int len, rc = 0;
+
+	len = display_buffer_len(buffer);
+
+	/* Add newline to end of buffer */
+	buffer->b_start[len] = '\n';
+	buffer->b_start[len + 1] = '\0';
+
+	/* A fatal message that does not fit is written in line, the
+	 * writer flushes everything queued before it at exit.
+	 */
+	if (atomic_fetch_int32_t(&log_writer.running) && !log_ring_exited) {
+		if (log_ring_push(lf, buffer->b_start, len + 1))
+			goto out;
+		if (level != NIV_FATAL) {
+			log_ring_drop();
+			goto out;
+		}
+	}
+
+	rc = log_file_write_sync(lf, buffer->b_start, len + 1);
 
  out:
 
@@ -1848,6 +2406,10 @@ struct logger_config {
 	struct glist_head facility_list;
 	struct logfields *logfields;
 	log_levels_t *comp_log_level;
+	bool async;
+	uint32_t durability;
+	uint32_t fsync_interval;
+	uint32_t buffer_size;
 };
 
 /**
@@ -2465,6 +3027,9 @@ static int log_conf_commit(void *node, void *link_mem, void *self_struct,
 				gsh_free(component_log_level);
 			component_log_level = logger->comp_log_level;
 		}
+		log_writer_configure(logger->async, logger->durability,
+				     logger->fsync_interval,
+				     logger->buffer_size);
 	} else {
 		if (logger->logfields != NULL) {
 			struct logfields *lf = logger->logfields;
@@ -2483,9 +3048,25 @@ static int log_conf_commit(void *node, void *link_mem, void *self_struct,
 	return errcnt;
 }
 
+static struct config_item_list durability_options[] = {
+	CONFIG_LIST_TOK("none", LOG_DURABILITY_NONE),
+	CONFIG_LIST_TOK("periodic", LOG_DURABILITY_PERIODIC),
+	CONFIG_LIST_TOK("sync", LOG_DURABILITY_SYNC),
+	CONFIG_LIST_EOL
+};
+
 static struct config_item logging_params[] = {
 	CONF_ITEM_TOKEN("Default_log_level", NB_LOG_LEVEL, log_levels,
 			 logger_config, default_level),
+	CONF_ITEM_BOOL("Async", true,
+		       logger_config, async),
+	CONF_ITEM_TOKEN("Durability", LOG_DURABILITY_PERIODIC,
+			durability_options,
+			logger_config, durability),
+	CONF_ITEM_UI32("Fsync_Interval", 1, 3600, 1,
+		       logger_config, fsync_interval),
+	CONF_ITEM_UI32("Buffer_Size", 16384, 16777216, 65536,
+		       logger_config, buffer_size),
 	CONF_ITEM_BLOCK("Facility", facility_params,
 			facility_init, facility_commit,
 			logger_config, facility_list),
@@ -44,6 +44,25 @@ class RetrieveExportStats():
         stats_op = self.exportmgrobj.get_dbus_method("ShowCacheInode",
                                  self.dbus_exportstats_name)
         return InodeStats(stats_op())
+    # latency percentiles per protocol op, request queue and FSAL call
+    def latency_stats(self):
+        stats_op = self.exportmgrobj.get_dbus_method("GetLatencies",
+                                 self.dbus_exportstats_name)
+        return LatencyStats(stats_op())
+    # slab pool usage and magazine hit rates
+    def pool_stats(self):
+        stats_op = self.exportmgrobj.get_dbus_method("GetPools",
+                                 self.dbus_exportstats_name)
+        return PoolStats(stats_op())
+    # group commit latency and batch sizes
+    def commit_stats(self):
+        stats_op = self.exportmgrobj.get_dbus_method("GetCommitStats",
+                                 self.dbus_exportstats_name)
+        return CommitStats(stats_op())
+    def reset_latency_stats(self):
+        stats_op = self.exportmgrobj.get_dbus_method("ResetLatencies",
+                                 self.dbus_exportstats_name)
+        return stats_op()[1]
     # list of all exports
     def export_stats(self):
         stats_op = self.exportmgrobj.get_dbus_method("ShowExports",
@@ -114,6 +133,11 @@ class RetrieveClientStats():
         stats_op = self.clientmgrobj.get_dbus_method("GetDelegations",
                           self.dbus_clientstats_name)
         return DelegStats(stats_op(ip))
+    # NFSv4.1 session slot stats related to a single client ip
+    def slot_stats(self, ip):
+        stats_op = self.clientmgrobj.get_dbus_method("GetSessionSlots",
+                          self.dbus_clientstats_name)
+        return SlotStats(stats_op(ip))
     def list_clients(self):
         stats_op = self.clientmgrobj.get_dbus_method("ShowClients",
                           self.dbus_clientmgr_name)
@@ -156,6 +180,31 @@ class DelegStats():
                      "\nCurrent Recalls: " + str(self.curr_recall) +
                      "\nCurrent Failed Recalls: " + str(self.fail_recall) +
                      "\nCurrent Number of Revokes: " + str(self.num_revokes) )
+class SlotStats():
+    def __init__(self, stats):
+        self.status = stats[1]
+        if stats[1] == "OK":
+            self.timestamp = (stats[2][0], stats[2][1])
+            self.slots = stats[3][0]
+            self.target = stats[3][1]
+            self.busy = stats[3][2]
+            self.max_busy = stats[3][3]
+            self.requests = stats[3][4]
+            self.replays = stats[3][5]
+            self.uncached = stats[3][6]
+    def __str__(self):
+        if self.status != "OK":
+            return ("GANESHA RESPONSE STATUS: " + self.status)
+        else:
+            return ( "GANESHA RESPONSE STATUS: " + self.status +
+                     "\nTimestamp: " + time.ctime(self.timestamp[0]) + str(self.timestamp[1]) + " nsecs" +
+                     "\nSlots in Latest Session: " + str(self.slots) +
+                     "\nTarget Highest Slot: " + str(self.target) +
+                     "\nBusy Slots: " + str(self.busy) +
+                     "\nMost Busy Slots: " + str(self.max_busy) +
+                     "\nRequests: " + str(self.requests) +
+                     "\nReplays: " + str(self.replays) +
+                     "\nReplies Not Cached: " + str(self.uncached) )
 
 class Export():
     def __init__(self, export):
@@ -236,6 +285,66 @@ class InodeStats():
                  "\nInode Cache Adds: " + str(self.cache_add) +
                  "\nInode Cache Mapping: " + str(self.cache_mapping) )
 
+class LatencyStats():
+    def __init__(self, stats):
+        self.stats = stats
+    def __str__(self):
+        if self.stats[1] != "OK":
+            return "No NFS activity, GANESHA RESPONSE STATUS: " + self.stats[1]
+        output = ("Timestamp: " + time.ctime(self.stats[2][0]) + str(self.stats[2][1]) + " nsecs" +
+                  "\nLatencies in usecs:\n" +
+                  "%s %10s %10s %10s %10s %10s %10s %10s\n" %
+                  ("Operation".ljust(24), "Count", "Mean", "p50", "p90",
+                   "p99", "p99.9", "Max"))
+        for op in self.stats[3]:
+            output += "%s %10d" % (str(op[0]).ljust(24), op[1])
+            for nsecs in op[2:]:
+                output += " %10.1f" % (nsecs / 1000.0)
+            output += "\n"
+        return output
+
+class PoolStats():
+    def __init__(self, stats):
+        self.stats = stats
+    def __str__(self):
+        if self.stats[1] != "OK":
+            return "No NFS activity, GANESHA RESPONSE STATUS: " + self.stats[1]
+        output = ("Timestamp: " + time.ctime(self.stats[2][0]) + str(self.stats[2][1]) + " nsecs\n" +
+                  "%s %8s %8s %12s %10s %10s %8s\n" %
+                  ("Pool".ljust(24), "Size", "Slabs", "Bytes", "Live",
+                   "Cached", "Hit %"))
+        for pool in self.stats[3]:
+            total = pool[6] + pool[7]
+            if total == 0:
+                hit = 0.0
+            else:
+                hit = 100.0 * pool[6] / total
+            output += ("%s %8d %8d %12d %10d %10d %8.1f\n" %
+                       (str(pool[0]).ljust(24), pool[1], pool[2], pool[3],
+                        pool[4], pool[5], hit))
+        return output
+
+class CommitStats():
+    def __init__(self, stats):
+        self.stats = stats
+    def __str__(self):
+        if self.stats[1] != "OK":
+            return "No NFS activity, GANESHA RESPONSE STATUS: " + self.stats[1]
+        output = ("Timestamp: " + time.ctime(self.stats[2][0]) + str(self.stats[2][1]) + " nsecs" +
+                  "\nLatency in usecs, batch sizes in commits and files:\n" +
+                  "%s %10s %10s %10s %10s %10s %10s %10s\n" %
+                  ("".ljust(12), "Count", "Mean", "p50", "p90",
+                   "p99", "p99.9", "Max"))
+        for histo in self.stats[3]:
+            output += "%s %10d" % (str(histo[0]).ljust(12), histo[1])
+            for val in histo[2:]:
+                if histo[0] == "latency":
+                    output += " %10.1f" % (val / 1000.0)
+                else:
+                    output += " %10d" % val
+            output += "\n"
+        return output
+
 class FastStats():
     def __init__(self, stats):
         self.stats = stats
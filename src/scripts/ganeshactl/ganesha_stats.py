@@ -15,8 +15,10 @@ import Ganesha.glib_dbus_stats
 def usage():
     message = "Command gives global stats by default.\n"
     message += "%s [list_clients | deleg <ip address> | " % (sys.argv[0])
+    message += "slots <ip address> | "
     message += "inode | iov3 [export id] | iov4 [export id] | export |"
-    message += " total [export id] | fast | pnfs [export id] ]"
+    message += " total [export id] | fast | pnfs [export id] |"
+    message += " latency | reset_latency | pools | commits ]"
     sys.exit(message)
 
 if len(sys.argv) < 2:
@@ -25,13 +27,14 @@ else:
     command = sys.argv[1]
 
 # check arguments
-commands = ('help', 'list_clients', 'deleg', 'global', 'inode', 'iov3', 'iov4',
-           'export', 'total', 'fast', 'pnfs')
+commands = ('help', 'list_clients', 'deleg', 'slots', 'global', 'inode',
+           'iov3', 'iov4', 'export', 'total', 'fast', 'pnfs', 'latency', 'reset_latency',
+           'pools', 'commits')
 if command not in commands:
     print "Option \"%s\" is not correct." % (command)
     usage()
 # requires an IP address
-elif command in ('deleg'):
+elif command in ('deleg', 'slots'):
     if not len(sys.argv) == 3:
         print "Option \"%s\" must be followed by an ip address." % (command)
         usage()
@@ -62,6 +65,8 @@ elif command == "list_clients":
     print cl_interface.list_clients()
 elif command == "deleg":
     print cl_interface.deleg_stats(command_arg)
+elif command == "slots":
+    print cl_interface.slot_stats(command_arg)
 elif command == "iov3":
     print exp_interface.v3io_stats(command_arg)
 elif command == "iov4":
@@ -70,3 +75,11 @@ elif command == "total":
     print exp_interface.total_stats(command_arg)
 elif command == "pnfs":
     print exp_interface.pnfs_stats(command_arg)
+elif command == "latency":
+    print exp_interface.latency_stats()
+elif command == "reset_latency":
+    print exp_interface.reset_latency_stats()
+elif command == "pools":
+    print exp_interface.pool_stats()
+elif command == "commits":
+    print exp_interface.commit_stats()
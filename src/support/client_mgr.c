@@ -44,6 +44,7 @@
 #include <sys/types.h>
 #include <sys/param.h>
 #include <pthread.h>
+#include <sched.h>
 #include <assert.h>
 #include <arpa/inet.h>
 #include "gsh_list.h"
@@ -63,32 +64,182 @@
 #include "server_stats.h"
 #include "sal_functions.h"
 
-/* Clients are stored in an AVL tree
+/* Clients are stored in a partitioned table of AVL trees.  Each
+ * partition has its own lock and a direct mapped cache of recently
+ * used clients in front of its tree.
+ *
+ * The cache is read without taking any lock.  A reader publishes the
+ * node it is about to dereference in its hazard pointer and then
+ * checks that the cache slot still holds it; remove_gsh_client clears
+ * the slot and waits until no hazard pointer refers to the node before
+ * it lets go of it.  A cache hit therefore writes nothing but the
+ * reader's own hazard pointer and the client's refcount.
  */
 
-struct client_by_ip {
-	struct avltree t;
+#define CLIENT_NPART 17		/* make prime */
+#define CLIENT_CACHESZ 2039	/* make prime */
+
+struct client_partition {
 	pthread_rwlock_t lock;
+	struct avltree t;
 	struct avltree_node **cache;
+	 CACHE_PAD(0);
+};
+
+struct client_by_ip {
+	struct client_partition *partition;
+	uint32_t npart;
 	uint32_t cache_sz;
 };
 
 static struct client_by_ip client_by_ip;
 
+/**
+ * @brief A thread's hazard pointer
+ *
+ * Hazard pointers are never freed; when a thread exits its hazard
+ * pointer is marked unused and handed to the next thread that needs
+ * one.
+ */
+
+struct client_hazard {
+	void *node;		/*< Cache node being dereferenced */
+	struct client_hazard *next;
+	uint32_t in_use;
+	 CACHE_PAD(0);
+};
+
+static struct client_hazard *client_hazards;
+static pthread_key_t client_hazard_key;
+static __thread struct client_hazard *client_hazard;
+
+/**
+ * @brief Release a thread's hazard pointer at thread exit
+ *
+ * @param[in] arg The hazard pointer
+ */
+
+static void client_hazard_release(void *arg)
+{
+	struct client_hazard *hz = arg;
+
+	atomic_store_voidptr(&hz->node, NULL);
+	atomic_store_uint32_t(&hz->in_use, 0);
+}
+
+/**
+ * @brief Get the calling thread's hazard pointer
+ *
+ * @return The hazard pointer or NULL if one could not be allocated.
+ */
+
+static struct client_hazard *client_hazard_get(void)
+{
+	struct client_hazard *hz = client_hazard;
+	uint32_t unused;
+	void *head;
+
+	if (likely(hz != NULL))
+		return hz;
+
+	/* reuse one left by an exited thread */
+	for (hz = atomic_fetch_voidptr((void **)&client_hazards); hz != NULL;
+	     hz = hz->next) {
+		unused = 0;
+		if (atomic_cas_uint32_t(&hz->in_use, &unused, 1))
+			goto out;
+	}
+
+	hz = gsh_calloc(1, sizeof(struct client_hazard));
+	if (hz == NULL)
+		return NULL;
+	hz->in_use = 1;
+	head = atomic_fetch_voidptr((void **)&client_hazards);
+	do {
+		hz->next = head;
+	} while (!atomic_cas_voidptr((void **)&client_hazards, &head, hz));
+
+ out:
+	client_hazard = hz;
+	(void) pthread_setspecific(client_hazard_key, hz);
+	return hz;
+}
+
+/**
+ * @brief Wait until no thread is dereferencing a cache node
+ *
+ * The node must already have been removed from the cache.
+ *
+ * @param[in] node The node
+ */
+
+static void client_hazard_wait(void *node)
+{
+	struct client_hazard *hz;
+
+	/* Pairs with the fence in client_cache_lookup */
+	atomic_thread_fence_seq_cst();
+	for (hz = atomic_fetch_voidptr((void **)&client_hazards); hz != NULL;
+	     hz = hz->next) {
+		while (atomic_fetch_voidptr(&hz->node) == node)
+			sched_yield();
+	}
+}
+
+/**
+ * @brief Hash a client address
+ *
+ * Folds the whole address so that IPv6 clients sharing a prefix do
+ * not all land in the same partition and cache slot.
+ *
+ * @param[in] addr     The address
+ * @param[in] addr_len Its length, 4 or 16
+ *
+ * @return The hash.
+ */
+
+static inline uint32_t client_addr_hash(const uint8_t *addr, int addr_len)
+{
+	uint32_t h = 0;
+	uint32_t w;
+	int ix;
+
+	for (ix = 0; ix < addr_len; ix += sizeof(w)) {
+		memcpy(&w, addr + ix, sizeof(w));
+		h = (h ^ w) * 0x9e3779b1;
+	}
+	return h ^ (h >> 16);
+}
+
+/**
+ * @brief Find the partition for an address hash
+ *
+ * @param[in] h Address hash
+ *
+ * @return The partition.
+ */
+
+static inline struct client_partition *client_partition_of(uint32_t h)
+{
+	return &client_by_ip.partition[h % client_by_ip.npart];
+}
+
 /**
  * @brief Compute cache slot for an entry
  *
  * This function computes a hash slot, taking an address modulo the
  * number of cache slotes (which should be prime).
  *
- * @param wt [in] The table
- * @param ptr [in] Entry address
+ * @param[in] cp Partition
+ * @param[in] h  Address hash
  *
- * @return The computed offset.
+ * @return The cache slot.
  */
-static inline uint32_t eip_cache_offsetof(struct client_by_ip *eid, uint32_t k)
+static inline void **client_cache_slot(struct client_partition *cp,
+				       uint32_t h)
 {
-	return k % eid->cache_sz;
+	return (void **)&cp->cache[(h / client_by_ip.npart) %
+				   client_by_ip.cache_sz];
 }
 
 /**
@@ -112,6 +263,70 @@ static int client_ip_cmpf(const struct avltree_node *lhs,
 		return memcmp(lk->addr.addr, rk->addr.addr, lk->addr.len);
 }
 
+/**
+ * @brief Look a client up in a partition's cache without locking
+ *
+ * @param[in] v          Key prototype
+ * @param[in] cache_slot Cache slot for the key
+ *
+ * @return pointer to ref'd client or NULL on a miss.
+ */
+
+static struct gsh_client *client_cache_lookup(struct gsh_client *v,
+					      void **cache_slot)
+{
+	struct client_hazard *hz = client_hazard_get();
+	struct avltree_node *node;
+	struct gsh_client *cl = NULL;
+
+	if (unlikely(hz == NULL))
+		return NULL;
+
+	do {
+		node = atomic_fetch_voidptr(cache_slot);
+		if (node == NULL)
+			return NULL;
+		atomic_store_voidptr(&hz->node, node);
+		/* Pairs with the fence in client_hazard_wait */
+		atomic_thread_fence_seq_cst();
+	} while (atomic_fetch_voidptr(cache_slot) != node);
+
+	if (client_ip_cmpf(&v->node_k, node) == 0) {
+		/* got it in 1 */
+		cl = avltree_container_of(node, struct gsh_client, node_k);
+		inc_gsh_client_refcount(cl);
+	}
+	atomic_store_voidptr(&hz->node, NULL);
+	return cl;
+}
+
+/**
+ * @brief Extract the address bytes from a sockaddr
+ *
+ * @param[in]  client_ipaddr The sockaddr struct with the v4/v6 address
+ * @param[out] v             Key prototype to fill in
+ */
+
+static void client_key(sockaddr_t *client_ipaddr, struct gsh_client *v)
+{
+	switch (client_ipaddr->ss_family) {
+	case AF_INET:
+		v->addr.addr =
+		    (uint8_t *) &((struct sockaddr_in *)client_ipaddr)->
+		    sin_addr;
+		v->addr.len = 4;
+		break;
+	case AF_INET6:
+		v->addr.addr =
+		    (uint8_t *) &((struct sockaddr_in6 *)client_ipaddr)->
+		    sin6_addr;
+		v->addr.len = 16;
+		break;
+	default:
+		assert(0);
+	}
+}
+
 /**
  * @brief Lookup the client manager struct for this client IP
  *
@@ -128,96 +343,68 @@ static int client_ip_cmpf(const struct avltree_node *lhs,
 struct gsh_client *get_gsh_client(sockaddr_t *client_ipaddr, bool lookup_only)
 {
 	struct avltree_node *node = NULL;
+	struct client_partition *cp;
 	struct gsh_client *cl;
 	struct server_stats *server_st;
 	struct gsh_client v;
 	char hoststr[SOCK_NAME_MAX];
-	uint8_t *addr = NULL;
-	uint32_t ipaddr;
-	int addr_len = 0;
+	uint32_t h;
 	void **cache_slot;
 
-	switch (client_ipaddr->ss_family) {
-	case AF_INET:
-		addr =
-		    (uint8_t *) &((struct sockaddr_in *)client_ipaddr)->
-		    sin_addr;
-		addr_len = 4;
-		memcpy(&ipaddr,
-		       (uint8_t *) &((struct sockaddr_in *)client_ipaddr)->
-		       sin_addr, sizeof(ipaddr));
-		break;
-	case AF_INET6:
-		addr =
-		    (uint8_t *) &((struct sockaddr_in6 *)client_ipaddr)->
-		    sin6_addr;
-		addr_len = 16;
-		memcpy(&ipaddr,
-		       (uint8_t *) &((struct sockaddr_in6 *)client_ipaddr)->
-		       sin6_addr, sizeof(ipaddr));
-		break;
-	default:
-		assert(0);
-	}
-	v.addr.addr = addr;
-	v.addr.len = addr_len;
-
-	PTHREAD_RWLOCK_rdlock(&client_by_ip.lock);
+	client_key(client_ipaddr, &v);
+	h = client_addr_hash(v.addr.addr, v.addr.len);
+	cp = client_partition_of(h);
+	cache_slot = client_cache_slot(cp, h);
 
 	/* check cache */
-	cache_slot = (void **)
-	    &(client_by_ip.cache[eip_cache_offsetof(&client_by_ip, ipaddr)]);
-	node = (struct avltree_node *)atomic_fetch_voidptr(cache_slot);
-	if (node) {
-		if (client_ip_cmpf(&v.node_k, node) == 0) {
-			/* got it in 1 */
-			LogDebug(COMPONENT_HASHTABLE_CACHE,
-				 "client_mgr cache hit slot %d",
-				 eip_cache_offsetof(&client_by_ip, ipaddr));
-			cl = avltree_container_of(node, struct gsh_client,
-						  node_k);
-			goto out;
-		}
+	cl = client_cache_lookup(&v, cache_slot);
+	if (cl) {
+		LogFullDebug(COMPONENT_HASHTABLE_CACHE,
+			     "client_mgr cache hit %s", cl->hostaddr_str);
+		return cl;
 	}
 
 	/* fall back to AVL */
-	node = avltree_lookup(&v.node_k, &client_by_ip.t);
+	PTHREAD_RWLOCK_rdlock(&cp->lock);
+	node = avltree_lookup(&v.node_k, &cp->t);
 	if (node) {
 		cl = avltree_container_of(node, struct gsh_client, node_k);
 		/* update cache */
 		atomic_store_voidptr(cache_slot, node);
 		goto out;
 	} else if (lookup_only) {
-		PTHREAD_RWLOCK_unlock(&client_by_ip.lock);
+		PTHREAD_RWLOCK_unlock(&cp->lock);
 		return NULL;
 	}
-	PTHREAD_RWLOCK_unlock(&client_by_ip.lock);
+	PTHREAD_RWLOCK_unlock(&cp->lock);
 
-	server_st = gsh_calloc(1, (sizeof(struct server_stats) + addr_len));
+	server_st = gsh_calloc(1, (sizeof(struct server_stats) + v.addr.len));
 
 	if (server_st == NULL)
 		return NULL;
 
 	cl = &server_st->client;
-	memcpy(cl->addrbuf, addr, addr_len);
+	memcpy(cl->addrbuf, v.addr.addr, v.addr.len);
 	cl->addr.addr = cl->addrbuf;
-	cl->addr.len = addr_len;
+	cl->addr.len = v.addr.len;
 	cl->refcnt = 0;		/* we will hold a ref starting out... */
 	sprint_sockip(client_ipaddr, hoststr, SOCK_NAME_MAX);
 	cl->hostaddr_str = gsh_strdup(hoststr);
+	PTHREAD_RWLOCK_init(&cl->lock, NULL);
 
-	PTHREAD_RWLOCK_wrlock(&client_by_ip.lock);
-	node = avltree_insert(&cl->node_k, &client_by_ip.t);
+	PTHREAD_RWLOCK_wrlock(&cp->lock);
+	node = avltree_insert(&cl->node_k, &cp->t);
 	if (node) {
-		gsh_free(server_st);	/* somebody beat us to it */
+		/* somebody beat us to it */
+		PTHREAD_RWLOCK_destroy(&cl->lock);
+		gsh_free(cl->hostaddr_str);
+		gsh_free(server_st);
 		cl = avltree_container_of(node, struct gsh_client, node_k);
-	} else {
-		PTHREAD_RWLOCK_init(&cl->lock, NULL);
 	}
 
  out:
 	inc_gsh_client_refcount(cl);
-	PTHREAD_RWLOCK_unlock(&client_by_ip.lock);
+	PTHREAD_RWLOCK_unlock(&cp->lock);
 	return cl;
 }
 
@@ -248,66 +435,51 @@ void put_gsh_client(struct gsh_client *client)
 int remove_gsh_client(sockaddr_t *client_ipaddr)
 {
 	struct avltree_node *node = NULL;
-	struct avltree_node *cnode = NULL;
+	struct client_partition *cp;
 	struct gsh_client *cl = NULL;
 	struct server_stats *server_st;
 	struct gsh_client v;
-	uint8_t *addr = NULL;
-	uint32_t ipaddr;
-	int addr_len = 0;
+	void *cnode;
+	uint32_t h;
 	int removed = 0;
 	void **cache_slot;
 
-	switch (client_ipaddr->ss_family) {
-	case AF_INET:
-		addr =
-		    (uint8_t *) &((struct sockaddr_in *)client_ipaddr)->
-		    sin_addr;
-		addr_len = 4;
-		memcpy(&ipaddr,
-		       (uint8_t *) &((struct sockaddr_in *)client_ipaddr)->
-		       sin_addr, sizeof(ipaddr));
-		break;
-	case AF_INET6:
-		addr =
-		    (uint8_t *) &((struct sockaddr_in6 *)client_ipaddr)->
-		    sin6_addr;
-		addr_len = 16;
-		memcpy(&ipaddr,
-		       (uint8_t *) &((struct sockaddr_in6 *)client_ipaddr)->
-		       sin6_addr, sizeof(ipaddr));
-		break;
-	default:
-		assert(0);
-	}
-	v.addr.addr = addr;
-	v.addr.len = addr_len;
+	client_key(client_ipaddr, &v);
+	h = client_addr_hash(v.addr.addr, v.addr.len);
+	cp = client_partition_of(h);
+	cache_slot = client_cache_slot(cp, h);
 
-	PTHREAD_RWLOCK_wrlock(&client_by_ip.lock);
-	node = avltree_lookup(&v.node_k, &client_by_ip.t);
+	PTHREAD_RWLOCK_wrlock(&cp->lock);
+	node = avltree_lookup(&v.node_k, &cp->t);
 	if (node) {
 		cl = avltree_container_of(node, struct gsh_client, node_k);
 		if (atomic_fetch_int64_t(&cl->refcnt) > 0) {
 			removed = EBUSY;
 			goto out;
 		}
-		cache_slot = (void **)
-		    &(client_by_ip.
-		      cache[eip_cache_offsetof(&client_by_ip, ipaddr)]);
-		cnode = (struct avltree_node *)atomic_fetch_voidptr(cache_slot);
-		if (node == cnode)
-			atomic_store_voidptr(cache_slot, NULL);
-		avltree_remove(node, &client_by_ip.t);
+		/* Take it out of the cache, then wait out any lock-free
+		 * reader that found it there before checking again.  New
+		 * readers have to come through the tree, which we hold.
+		 */
+		cnode = node;
+		(void) atomic_cas_voidptr(cache_slot, &cnode, NULL);
+		client_hazard_wait(node);
+		if (atomic_fetch_int64_t(&cl->refcnt) > 0) {
+			removed = EBUSY;
+			goto out;
+		}
+		avltree_remove(node, &cp->t);
 	} else {
 		removed = ENOENT;
 	}
  out:
-	PTHREAD_RWLOCK_unlock(&client_by_ip.lock);
+	PTHREAD_RWLOCK_unlock(&cp->lock);
 	if (removed == 0) {
 		server_st = container_of(cl, struct server_stats, client);
 		server_stats_free(&server_st->st);
 		if (cl->hostaddr_str != NULL)
 			gsh_free(cl->hostaddr_str);
+		PTHREAD_RWLOCK_destroy(&cl->lock);
 		gsh_free(server_st);
 	}
 	return removed;
@@ -316,6 +488,8 @@ int remove_gsh_client(sockaddr_t *client_ipaddr)
 /**
  * @ Walk the tree and do the callback on each node
  *
+ * Clients are visited partition by partition.
+ *
  * @param cb    [IN] Callback function
  * @param state [IN] param block to pass
  */
@@ -324,19 +498,26 @@ int foreach_gsh_client(bool(*cb) (struct gsh_client *cl, void *state),
 		       void *state)
 {
 	struct avltree_node *client_node;
+	struct client_partition *cp;
 	struct gsh_client *cl;
+	uint32_t ix;
 	int cnt = 0;
 
-	PTHREAD_RWLOCK_rdlock(&client_by_ip.lock);
-	for (client_node = avltree_first(&client_by_ip.t); client_node != NULL;
-	     client_node = avltree_next(client_node)) {
-		cl = avltree_container_of(client_node, struct gsh_client,
-					  node_k);
-		if (!cb(cl, state))
-			break;
-		cnt++;
+	for (ix = 0; ix < client_by_ip.npart; ++ix) {
+		cp = &client_by_ip.partition[ix];
+		PTHREAD_RWLOCK_rdlock(&cp->lock);
+		for (client_node = avltree_first(&cp->t); client_node != NULL;
+		     client_node = avltree_next(client_node)) {
+			cl = avltree_container_of(client_node,
+						  struct gsh_client, node_k);
+			if (!cb(cl, state)) {
+				PTHREAD_RWLOCK_unlock(&cp->lock);
+				return cnt;
+			}
+			cnt++;
+		}
+		PTHREAD_RWLOCK_unlock(&cp->lock);
 	}
-	PTHREAD_RWLOCK_unlock(&client_by_ip.lock);
 	return cnt;
 }
 
@@ -796,6 +977,52 @@ static struct gsh_dbus_method cltmgr_show_delegations = {
 		 END_ARG_LIST}
 };
 
+/**
+ * DBUS method to report NFSv4.1 session slot statistics
+ */
+static bool get_stats_session_slots(DBusMessageIter *args,
+				    DBusMessage *reply,
+				    DBusError *error)
+{
+	char *errormsg = "OK";
+	struct gsh_client *client = NULL;
+	struct server_stats *server_st = NULL;
+	bool success = true;
+	DBusMessageIter iter;
+
+	dbus_message_iter_init_append(reply, &iter);
+	client = lookup_client(args, &errormsg);
+	if (client == NULL) {
+		success = false;
+		errormsg = "Client IP address not found";
+	} else {
+		server_st = container_of(client, struct server_stats, client);
+		if (server_st->st.slots == NULL) {
+			success = false;
+			errormsg = "Client does not have any NFSv4.1 sessions";
+		}
+	}
+
+	dbus_status_reply(&iter, success, errormsg);
+	if (success)
+		server_dbus_session_slots(server_st->st.slots, &iter);
+
+	if (client != NULL)
+		put_gsh_client(client);
+
+	return true;
+}
+
+static struct gsh_dbus_method cltmgr_show_session_slots = {
+	.name = "GetSessionSlots",
+	.method = get_stats_session_slots,
+	.args = {IPADDR_ARG,
+		 STATUS_REPLY,
+		 TIMESTAMP_REPLY,
+		 SLOTS_REPLY,
+		 END_ARG_LIST}
+};
+
 /**
  * DBUS method to report 9p I/O statistics
  *
@@ -897,6 +1124,7 @@ static struct gsh_dbus_method *cltmgr_stats_methods[] = {
 	&cltmgr_show_v41_io,
 	&cltmgr_show_v41_layouts,
 	&cltmgr_show_delegations,
+	&cltmgr_show_session_slots,
 	&cltmgr_show_9p_io,
 	&cltmgr_show_9p_trans,
 	NULL
@@ -932,6 +1160,8 @@ void dbus_client_init(void)
 void client_pkginit(void)
 {
 	pthread_rwlockattr_t rwlock_attr;
+	struct client_partition *cp;
+	uint32_t ix;
 
 	pthread_rwlockattr_init(&rwlock_attr);
 #ifdef GLIBC
@@ -939,11 +1169,18 @@ void client_pkginit(void)
 		&rwlock_attr,
 		PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
 #endif
-	PTHREAD_RWLOCK_init(&client_by_ip.lock, &rwlock_attr);
-	avltree_init(&client_by_ip.t, client_ip_cmpf, 0);
-	client_by_ip.cache_sz = 32767;
-	client_by_ip.cache =
-	    gsh_calloc(client_by_ip.cache_sz, sizeof(struct avltree_node *));
+	(void) pthread_key_create(&client_hazard_key, client_hazard_release);
+	client_by_ip.npart = CLIENT_NPART;
+	client_by_ip.cache_sz = CLIENT_CACHESZ;
+	client_by_ip.partition =
+	    gsh_calloc(client_by_ip.npart, sizeof(struct client_partition));
+	for (ix = 0; ix < client_by_ip.npart; ++ix) {
+		cp = &client_by_ip.partition[ix];
+		PTHREAD_RWLOCK_init(&cp->lock, &rwlock_attr);
+		avltree_init(&cp->t, client_ip_cmpf, 0);
+		cp->cache = gsh_calloc(client_by_ip.cache_sz,
+				       sizeof(struct avltree_node *));
+	}
 }
 
 /** @} */
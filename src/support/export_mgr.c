@@ -231,6 +231,7 @@ struct gsh_export *alloc_export(void)
 	glist_init(&export->clients);
 
 	PTHREAD_RWLOCK_init(&export->lock, NULL);
+	pthread_spin_init(&export->throttle.sp, PTHREAD_PROCESS_PRIVATE);
 
 	return export;
 }
@@ -252,8 +253,90 @@ void free_export(struct gsh_export *export)
 	free_export_resources(export);
 	export_st = container_of(export, struct export_stats, export);
 	server_stats_free(&export_st->st);
-	gsh_free(export_st);
+	pthread_spin_destroy(&export->throttle.sp);
 	PTHREAD_RWLOCK_destroy(&export->lock);
+	gsh_free(export_st);
+}
+
+/**
+ * @brief Refill a token bucket
+ *
+ * Refills too small to make a whole token are carried over, so calls
+ * coming faster than the rate still add up to it.  The rate is split
+ * to keep the products within 64 bits.
+ *
+ * @param[in,out] tokens  Tokens in the bucket
+ * @param[in,out] frac    Carried refill, in 1/NS_PER_SEC of a token
+ * @param[in]     rate    Tokens per second, also the bucket's size
+ * @param[in]     elapsed Time since the last refill, at most a second
+ */
+
+static void throttle_refill(int64_t *tokens, uint64_t *frac, uint64_t rate,
+			    nsecs_elapsed_t elapsed)
+{
+	uint64_t credit = (rate % NS_PER_SEC) * elapsed + *frac;
+
+	*tokens += (rate / NS_PER_SEC) * elapsed + credit / NS_PER_SEC;
+	*frac = credit % NS_PER_SEC;
+	if (*tokens >= (int64_t) rate) {
+		*tokens = rate;
+		*frac = 0;
+	}
+}
+
+/**
+ * @brief Admit a request against the export's rate limits
+ *
+ * Each limit is a token bucket holding at most one second's worth of
+ * tokens.  A request is admitted as long as the buckets are not
+ * empty; its full size is then charged, so a large request may leave
+ * the byte bucket in debt and hold off the requests behind it.
+ *
+ * @param[in] export The export
+ * @param[in] bytes  Bytes the request will read or write
+ *
+ * @return true if the request may proceed, false if it should be
+ *         retried later.
+ */
+
+bool export_throttle_admit(struct gsh_export *export, uint64_t bytes)
+{
+	struct timespec ts;
+	nsecs_elapsed_t elapsed;
+	bool admit = true;
+
+	if (export->MaxIOPS == 0 && export->MaxBandwidth == 0)
+		return true;
+
+	now(&ts);
+	pthread_spin_lock(&export->throttle.sp);
+
+	elapsed = timespec_diff(&export->throttle.last, &ts);
+	if (elapsed > NS_PER_SEC)
+		elapsed = NS_PER_SEC;
+	export->throttle.last = ts;
+
+	if (export->MaxIOPS != 0) {
+		throttle_refill(&export->throttle.ops,
+				&export->throttle.ops_frac, export->MaxIOPS,
+				elapsed);
+		if (export->throttle.ops < 1)
+			admit = false;
+	}
+	if (export->MaxBandwidth != 0) {
+		throttle_refill(&export->throttle.bytes,
+				&export->throttle.bytes_frac,
+				export->MaxBandwidth, elapsed);
+		if (export->throttle.bytes <= 0)
+			admit = false;
+	}
+	if (admit) {
+		export->throttle.ops -= 1;
+		export->throttle.bytes -= bytes;
+	}
+
+	pthread_spin_unlock(&export->throttle.sp);
+	return admit;
 }
 
 
@@ -1495,6 +1578,86 @@ static bool show_cache_inode_stats(DBusMessageIter *args,
 	return true;
 }
 
+static bool show_req_queue_stats(DBusMessageIter *args,
+				 DBusMessage *reply,
+				 DBusError *error)
+{
+	bool success = true;
+	char *errormsg = "OK";
+	DBusMessageIter iter;
+
+	dbus_message_iter_init_append(reply, &iter);
+	dbus_status_reply(&iter, success, errormsg);
+
+	req_queue_dbus_show(&iter);
+
+	return true;
+}
+
+static bool show_latencies(DBusMessageIter *args,
+			   DBusMessage *reply,
+			   DBusError *error)
+{
+	bool success = true;
+	char *errormsg = "OK";
+	DBusMessageIter iter;
+
+	dbus_message_iter_init_append(reply, &iter);
+	dbus_status_reply(&iter, success, errormsg);
+
+	server_dbus_latencies(&iter);
+
+	return true;
+}
+
+static bool show_pools(DBusMessageIter *args,
+		       DBusMessage *reply,
+		       DBusError *error)
+{
+	bool success = true;
+	char *errormsg = "OK";
+	DBusMessageIter iter;
+
+	dbus_message_iter_init_append(reply, &iter);
+	dbus_status_reply(&iter, success, errormsg);
+
+	server_dbus_pools(&iter);
+
+	return true;
+}
+
+static bool show_commits(DBusMessageIter *args,
+			 DBusMessage *reply,
+			 DBusError *error)
+{
+	bool success = true;
+	char *errormsg = "OK";
+	DBusMessageIter iter;
+
+	dbus_message_iter_init_append(reply, &iter);
+	dbus_status_reply(&iter, success, errormsg);
+
+	server_dbus_commits(&iter);
+
+	return true;
+}
+
+static bool reset_latencies(DBusMessageIter *args,
+			    DBusMessage *reply,
+			    DBusError *error)
+{
+	bool success = true;
+	char *errormsg = "OK";
+	DBusMessageIter iter;
+
+	server_stats_latency_reset();
+
+	dbus_message_iter_init_append(reply, &iter);
+	dbus_status_reply(&iter, success, errormsg);
+
+	return true;
+}
+
 static struct gsh_dbus_method export_show_v41_layouts = {
 	.name = "GetNFSv41Layouts",
 	.method = get_nfsv41_export_layouts,
@@ -1586,6 +1749,49 @@ static struct gsh_dbus_method cache_inode_show = {
 		 END_ARG_LIST}
 };
 
+static struct gsh_dbus_method req_queue_show = {
+	.name = "ShowRequestQueues",
+	.method = show_req_queue_stats,
+	.args = {STATUS_REPLY,
+		 TIMESTAMP_REPLY,
+		 TOTAL_OPS_REPLY,
+		 END_ARG_LIST}
+};
+
+static struct gsh_dbus_method global_show_latencies = {
+	.name = "GetLatencies",
+	.method = show_latencies,
+	.args = {STATUS_REPLY,
+		 TIMESTAMP_REPLY,
+		 LATENCY_REPLY,
+		 END_ARG_LIST}
+};
+
+static struct gsh_dbus_method global_reset_latencies = {
+	.name = "ResetLatencies",
+	.method = reset_latencies,
+	.args = {STATUS_REPLY,
+		 END_ARG_LIST}
+};
+
+static struct gsh_dbus_method global_show_pools = {
+	.name = "GetPools",
+	.method = show_pools,
+	.args = {STATUS_REPLY,
+		 TIMESTAMP_REPLY,
+		 POOL_REPLY,
+		 END_ARG_LIST}
+};
+
+static struct gsh_dbus_method global_show_commits = {
+	.name = "GetCommitStats",
+	.method = show_commits,
+	.args = {STATUS_REPLY,
+		 TIMESTAMP_REPLY,
+		 COMMIT_REPLY,
+		 END_ARG_LIST}
+};
+
 /**
  * @brief Report all IO stats of all exports in one call
  *
@@ -1650,6 +1856,11 @@ static struct gsh_dbus_method *export_stats_methods[] = {
 	&global_show_total_ops,
 	&global_show_fast_ops,
 	&cache_inode_show,
+	&req_queue_show,
+	&global_show_latencies,
+	&global_reset_latencies,
+	&global_show_pools,
+	&global_show_commits,
 	&export_show_all_io,
 	NULL
 };
@@ -70,6 +70,8 @@ struct global_export_perms export_opt = {
 };
 
 static void FreeClientList(struct glist_head *clients);
+static void client_access_compile(struct gsh_export *export);
+static void client_access_free(struct gsh_export *export);
 
 static void StrExportOptions(struct export_perms *p_perms, char *buffer)
 {
@@ -789,6 +791,8 @@ static int export_commit(void *node, void *link_mem, void *self_struct,
 		goto err_out;  /* have errors. don't init or load a fsal */
 	}
 
+	client_access_compile(export);
+
 	/* now probe the fsal and init it */
 	/* pass along the block that is/was the FS_Specific */
 	if (!insert_gsh_export(export)) {
@@ -1191,6 +1195,10 @@ static struct config_item export_params[] = {
 		       gsh_export, MaxOffsetWrite),
 	CONF_ITEM_UI64("MaxOffsetRead", 512, UINT64_MAX, UINT64_MAX,
 		       gsh_export, MaxOffsetRead),
+	CONF_ITEM_UI64("Max_IOPS", 0, UINT32_MAX, 0,
+		       gsh_export, MaxIOPS),
+	CONF_ITEM_UI64("Max_Bandwidth", 0, UINT64_MAX / NS_PER_SEC, 0,
+		       gsh_export, MaxBandwidth),
 	CONF_ITEM_BOOLBIT_SET("UseCookieVerifier",
 		true, EXPORT_OPTION_USE_COOKIE_VERIFIER,
 		gsh_export, options, options_set),
@@ -1472,6 +1480,7 @@ static void FreeClientList(struct glist_head *clients)
 
 void free_export_resources(struct gsh_export *export)
 {
+	client_access_free(export);
 	FreeClientList(&export->clients);
 	if (export->fsal_export != NULL) {
 		struct fsal_module *fsal = export->fsal_export->fsal;
@@ -1848,6 +1857,120 @@ static char *client_types[] = {
 	[BAD_CLIENT] = "BAD_CLIENT"
 	 };
 
+/**
+ * @brief Names of a caller, worked out on demand while matching
+ *
+ * Netgroup and wildcard entries need the printed address or the
+ * host name of the caller.  Both are only produced once per match,
+ * however many such entries the client list holds.
+ */
+
+struct client_name {
+	int ipvalid;		/*< -1 need to print, 0 invalid, 1 ok */
+	int namevalid;		/*< -1 need to resolve, 0 failed, 1 ok */
+	char ipstring[SOCK_NAME_MAX + 1];
+	char hostname[MAXHOSTNAMELEN + 1];
+};
+
+#define CLIENT_NAME_INITIALIZER { .ipvalid = -1, .namevalid = -1 }
+
+/**
+ * @brief Get the host name of the caller from the IP/name cache
+ *
+ * @param[in]     hostaddr Caller address
+ * @param[in,out] name     Names found so far
+ *
+ * @return true if the host name is known.
+ */
+
+static bool client_hostname(sockaddr_t *hostaddr, struct client_name *name)
+{
+	int rc;
+
+	if (name->namevalid >= 0)
+		return name->namevalid;
+
+	/* Try to get the entry from the IP/name cache */
+	rc = nfs_ip_name_get(hostaddr, name->hostname,
+			     sizeof(name->hostname));
+
+	/* IPaddr was not cached, add it to the cache */
+	if (rc == IP_NAME_NOT_FOUND)
+		rc = nfs_ip_name_add(hostaddr, name->hostname,
+				     sizeof(name->hostname));
+
+/** @todo this change from 1.5 is not IPv6 useful.
+ * come back to this and use the string from client mgr inside req_ctx...
+ */
+	name->namevalid = rc == IP_NAME_SUCCESS;
+	return name->namevalid;
+}
+
+/**
+ * @brief Match an IPv4 caller against one client entry
+ *
+ * @param[in]     client   Entry to check
+ * @param[in]     hostaddr Caller address
+ * @param[in]     addr     Caller IPv4 address, network order
+ * @param[in,out] name     Names of the caller found so far
+ *
+ * @return true if the entry matches the caller.
+ */
+
+static bool client_match_entry(exportlist_client_entry_t *client,
+			       sockaddr_t *hostaddr, in_addr_t addr,
+			       struct client_name *name)
+{
+	switch (client->type) {
+	case HOSTIF_CLIENT:
+		return client->client.hostif.clientaddr == addr;
+
+	case NETWORK_CLIENT:
+		return (client->client.network.netmask & ntohl(addr)) ==
+			client->client.network.netaddr;
+
+	case NETGROUP_CLIENT:
+		/* Major failure, name could not be resolved */
+		if (!client_hostname(hostaddr, name))
+			return false;
+
+		return innetgr(client->client.netgroup.netgroupname,
+			       name->hostname, NULL, NULL) == 1;
+
+	case WILDCARDHOST_CLIENT:
+		/* Now checking for IP wildcards */
+		if (name->ipvalid < 0)
+			name->ipvalid = sprint_sockip(hostaddr,
+						      name->ipstring,
+						      sizeof(name->ipstring));
+
+		if (name->ipvalid &&
+		    fnmatch(client->client.wildcard.wildcard, name->ipstring,
+			    FNM_PATHNAME) == 0)
+			return true;
+
+		if (!client_hostname(hostaddr, name))
+			return false;
+
+		return fnmatch(client->client.wildcard.wildcard,
+			       name->hostname, FNM_PATHNAME) == 0;
+
+	case GSSPRINCIPAL_CLIENT:
+	  /** @todo BUGAZOMEU a completer lors de l'integration de RPCSEC_GSS */
+		LogCrit(COMPONENT_EXPORT,
+			"Unsupported type GSS_PRINCIPAL_CLIENT");
+		return false;
+
+	case MATCH_ANY_CLIENT:
+		return true;
+
+	case HOSTIF_CLIENT_V6:
+	case BAD_CLIENT:
+	default:
+		return false;
+	}
+}
+
 /**
  * @brief Match a specific option in the client export list
  *
@@ -1863,10 +1986,7 @@ static exportlist_client_entry_t *client_match(sockaddr_t *hostaddr,
 {
 	struct glist_head *glist;
 	in_addr_t addr = get_in_addr(hostaddr);
-	int rc;
-	int ipvalid = -1;	/* -1 need to print, 0 - invalid, 1 - ok */
-	char hostname[MAXHOSTNAMELEN + 1];
-	char ipstring[SOCK_NAME_MAX + 1];
+	struct client_name name = CLIENT_NAME_INITIALIZER;
 
 	glist_for_each(glist, &export->clients) {
 		exportlist_client_entry_t *client;
@@ -1880,112 +2000,8 @@ static exportlist_client_entry_t *client_match(sockaddr_t *hostaddr,
 			    client->client_perms.options);
 		LogClientListEntry(COMPONENT_EXPORT, client);
 
-		switch (client->type) {
-		case HOSTIF_CLIENT:
-			if (client->client.hostif.clientaddr == addr)
-				return client;
-			break;
-
-		case NETWORK_CLIENT:
-			if ((client->client.network.netmask & ntohl(addr)) ==
-			    client->client.network.netaddr)
-				return client;
-			break;
-
-		case NETGROUP_CLIENT:
-			/* Try to get the entry from th IP/name cache */
-			rc = nfs_ip_name_get(hostaddr, hostname,
-					     sizeof(hostname));
-
-			if (rc != IP_NAME_SUCCESS) {
-				if (rc == IP_NAME_NOT_FOUND) {
-					/* IPaddr was not cached, add it to the
-					 * cache
-					 */
-					if (nfs_ip_name_add(hostaddr,
-							    hostname,
-							    sizeof(hostname))
-					    != IP_NAME_SUCCESS) {
-						/* Major failure, name not
-						 * be resolved
-						 */
-						break;
-					}
-				}
-			}
-
-			/* At this point 'hostname' should contain the
-			 * name that was found
-			 */
-			if (innetgr(client->client.netgroup.netgroupname,
-				    hostname, NULL, NULL) == 1) {
-				return client;
-			}
-			break;
-
-		case WILDCARDHOST_CLIENT:
-			/* Now checking for IP wildcards */
-			if (ipvalid < 0)
-				ipvalid = sprint_sockip(hostaddr,
-							ipstring,
-							sizeof(ipstring));
-
-			if (ipvalid &&
-			    (fnmatch(client->client.wildcard.wildcard,
-				     ipstring,
-				     FNM_PATHNAME) == 0)) {
-				return client;
-			}
-
-			/* Try to get the entry from th IP/name cache */
-			rc = nfs_ip_name_get(hostaddr, hostname,
-					     sizeof(hostname));
-
-			if (rc != IP_NAME_SUCCESS) {
-				if (rc == IP_NAME_NOT_FOUND) {
-					/* IPaddr was not cached, add it to
-					 * the cache
-					 */
-					if (nfs_ip_name_add(hostaddr,
-							    hostname,
-							    sizeof(hostname))
-					    != IP_NAME_SUCCESS) {
-						/* Major failure, name could
-						 * not be resolved
-						 */
-/** @todo this change from 1.5 is not IPv6 useful.
- * come back to this and use the string from client mgr inside req_ctx...
- */
-						break;
-					}
-				}
-			}
-			/* At this point 'hostname' should contain the
-			 * name that was found
-			 */
-			if (fnmatch
-			    (client->client.wildcard.wildcard, hostname,
-			     FNM_PATHNAME) == 0) {
-				return client;
-			}
-			break;
-
-		case GSSPRINCIPAL_CLIENT:
-	  /** @todo BUGAZOMEU a completer lors de l'integration de RPCSEC_GSS */
-			LogCrit(COMPONENT_EXPORT,
-				"Unsupported type GSS_PRINCIPAL_CLIENT");
-			break;
-
-		case HOSTIF_CLIENT_V6:
-			break;
-
-		case MATCH_ANY_CLIENT:
+		if (client_match_entry(client, hostaddr, addr, &name))
 			return client;
-
-		case BAD_CLIENT:
-		default:
-			continue;
-		}
 	}
 
 	/* no export found for this option */
@@ -2063,6 +2079,359 @@ static exportlist_client_entry_t *client_match_any(sockaddr_t *hostaddr,
 	}
 }
 
+/**
+ * @brief Compiled client lists
+ *
+ * Walking the client list of an export for every request gets
+ * expensive with long lists holding netgroups and wildcards, so each
+ * export compiles its list when it is committed.  IPv4 host and
+ * network entries go into a binary radix tree keyed on the address
+ * in host order, every other entry that can match an IPv4 caller is
+ * kept in an array in list order.  The position of each entry in the
+ * list is recorded with it and a lookup returns the matching entry
+ * with the lowest position, so the first match semantics of the
+ * Client blocks are unchanged.
+ *
+ * The outcome of a lookup is then memoized per caller address in a
+ * direct mapped cache of the export.  Slots are read without locks
+ * and validated with a sequence counter, a writer that finds the
+ * slot busy simply does not fill it.  Bumping client_access_gen
+ * invalidates every slot of every export; the compiled lists
+ * themselves live as long as the export, since an export's clients
+ * never change once it is committed.
+ */
+
+#define CLIENT_ACCESS_SHIFT 9
+#define CLIENT_ACCESS_SLOTS (1 << CLIENT_ACCESS_SHIFT)
+
+struct client_node {
+	struct client_node *child[2];
+	exportlist_client_entry_t *client; /*< First entry for this prefix */
+	uint32_t index;		/*< Its position in the client list */
+};
+
+struct client_slow {
+	exportlist_client_entry_t *client;
+	uint32_t index;		/*< Position in the client list */
+};
+
+struct client_slot {
+	uint32_t seq;		/*< Odd while the slot is being written */
+	uint32_t gen;		/*< client_access_gen when filled, 0 if never */
+	sa_family_t family;
+	uint8_t addr[16];
+	exportlist_client_entry_t *client; /*< Match, NULL for none */
+};
+
+struct client_access {
+	struct client_node *root;	/*< IPv4 host and network entries */
+	struct client_slow *slow;	/*< Other entries, in list order */
+	uint32_t nslow;
+	struct client_slot slot[CLIENT_ACCESS_SLOTS];
+};
+
+/** Generation of memoized lookups, never 0 */
+static uint32_t client_access_gen = 1;
+
+/**
+ * @brief Free a radix (sub)tree
+ *
+ * @param[in] node Root of the tree, may be NULL
+ */
+
+static void client_node_free(struct client_node *node)
+{
+	if (node == NULL)
+		return;
+
+	client_node_free(node->child[0]);
+	client_node_free(node->child[1]);
+	gsh_free(node);
+}
+
+/**
+ * @brief Release the compiled client list of an export
+ *
+ * @param[in] export The export
+ */
+
+static void client_access_free(struct gsh_export *export)
+{
+	struct client_access *access = export->client_access;
+
+	if (access == NULL)
+		return;
+
+	client_node_free(access->root);
+	gsh_free(access->slow);
+	gsh_free(access);
+	export->client_access = NULL;
+}
+
+/**
+ * @brief Add a prefix to the radix tree
+ *
+ * An entry already present for the same prefix comes earlier in the
+ * list and is kept.
+ *
+ * @param[in] access Compiled list
+ * @param[in] prefix Prefix, host order
+ * @param[in] len    Prefix length in bits
+ * @param[in] client Entry to add
+ * @param[in] index  Position of the entry in the client list
+ *
+ * @return true on success, false if out of memory.
+ */
+
+static bool client_node_insert(struct client_access *access, uint32_t prefix,
+			       int len, exportlist_client_entry_t *client,
+			       uint32_t index)
+{
+	struct client_node **np = &access->root;
+	int bit;
+
+	for (bit = 0;; bit++) {
+		if (*np == NULL) {
+			*np = gsh_calloc(1, sizeof(struct client_node));
+			if (*np == NULL)
+				return false;
+		}
+		if (bit == len)
+			break;
+		np = &(*np)->child[(prefix >> (31 - bit)) & 1];
+	}
+
+	if ((*np)->client == NULL) {
+		(*np)->client = client;
+		(*np)->index = index;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Compile the client list of an export
+ *
+ * Called once the client list is complete and before the export is
+ * made visible.  If the list cannot be compiled the export keeps
+ * matching callers by walking it.
+ *
+ * @param[in] export The export
+ */
+
+static void client_access_compile(struct gsh_export *export)
+{
+	struct client_access *access;
+	struct glist_head *glist;
+	exportlist_client_entry_t *client;
+	uint32_t netmask;
+	uint32_t index = 0;
+	bool ok = true;
+
+	access = gsh_calloc(1, sizeof(struct client_access));
+	if (access == NULL)
+		goto nomem;
+	export->client_access = access;
+
+	access->slow = gsh_calloc(glist_length(&export->clients) + 1,
+				  sizeof(struct client_slow));
+	if (access->slow == NULL)
+		goto nomem;
+
+	glist_for_each(glist, &export->clients) {
+		client = glist_entry(glist, exportlist_client_entry_t,
+				     cle_list);
+
+		switch (client->type) {
+		case HOSTIF_CLIENT:
+			ok = client_node_insert(access,
+					ntohl(client->client.hostif.clientaddr),
+					32, client, index);
+			break;
+
+		case NETWORK_CLIENT:
+			netmask = client->client.network.netmask;
+			if (((~netmask + 1) & ~netmask) == 0) {
+				/* A network entry whose address has bits
+				 * outside of the mask can never match.
+				 */
+				if ((client->client.network.netaddr &
+				     ~netmask) == 0)
+					ok = client_node_insert(access,
+					    client->client.network.netaddr,
+					    __builtin_popcount(netmask),
+					    client, index);
+				break;
+			}
+			/* Non contiguous mask, match it by hand,
+			 * fall through.
+			 */
+		case NETGROUP_CLIENT:
+		case WILDCARDHOST_CLIENT:
+		case MATCH_ANY_CLIENT:
+			access->slow[access->nslow].client = client;
+			access->slow[access->nslow].index = index;
+			access->nslow++;
+			break;
+
+		default:
+			/* Never matches an IPv4 caller */
+			break;
+		}
+
+		if (!ok)
+			goto nomem;
+		index++;
+	}
+
+	LogDebug(COMPONENT_EXPORT,
+		 "Export %d client list compiled, %u of %u entries matched one by one",
+		 export->export_id, access->nslow, index);
+	return;
+
+nomem:
+	LogWarn(COMPONENT_EXPORT,
+		"Could not compile client list of export %d, out of memory",
+		export->export_id);
+	client_access_free(export);
+}
+
+/**
+ * @brief Match an IPv4 caller against a compiled client list
+ *
+ * @param[in]  hostaddr  Caller address
+ * @param[in]  access    Compiled list
+ * @param[out] cacheable false if the result depended on a failed
+ *                       name resolution and should not be memoized
+ *
+ * @return The first matching entry or NULL.
+ */
+
+static exportlist_client_entry_t *
+client_access_match(sockaddr_t *hostaddr, struct client_access *access,
+		    bool *cacheable)
+{
+	in_addr_t addr = get_in_addr(hostaddr);
+	uint32_t key = ntohl(addr);
+	struct client_node *node = access->root;
+	struct client_name name = CLIENT_NAME_INITIALIZER;
+	exportlist_client_entry_t *best = NULL;
+	uint32_t best_index = UINT32_MAX;
+	uint32_t i;
+	int bit = 0;
+
+	while (node != NULL) {
+		if (node->client != NULL && node->index < best_index) {
+			best = node->client;
+			best_index = node->index;
+		}
+		if (bit == 32)
+			break;
+		node = node->child[(key >> (31 - bit)) & 1];
+		bit++;
+	}
+
+	for (i = 0; i < access->nslow && access->slow[i].index < best_index;
+	     i++) {
+		if (client_match_entry(access->slow[i].client, hostaddr, addr,
+				       &name)) {
+			best = access->slow[i].client;
+			break;
+		}
+	}
+
+	*cacheable = name.namevalid != 0;
+	return best;
+}
+
+/**
+ * @brief Find the client entry of an export matching a caller
+ *
+ * @param[in] hostaddr Caller address, IPv4 mapped addresses converted
+ * @param[in] export   The export
+ *
+ * @return The first matching entry or NULL.
+ */
+
+static exportlist_client_entry_t *client_lookup(sockaddr_t *hostaddr,
+						struct gsh_export *export)
+{
+	struct client_access *access = export->client_access;
+	exportlist_client_entry_t *client;
+	struct client_slot *slot;
+	struct client_slot copy;
+	uint8_t addr[16];
+	uint32_t gen, seq, hash;
+	bool cacheable = true;
+	int i;
+
+	if (access == NULL)
+		return client_match_any(hostaddr, export);
+
+	memset(addr, 0, sizeof(addr));
+	if (hostaddr->ss_family == AF_INET6)
+		memcpy(addr, &((struct sockaddr_in6 *)hostaddr)->sin6_addr,
+		       16);
+	else
+		memcpy(addr, &((struct sockaddr_in *)hostaddr)->sin_addr, 4);
+
+	hash = 0;
+	for (i = 0; i < 16; i += 4)
+		hash ^= *(uint32_t *)(addr + i);
+	hash = (hash * 2654435761U) >> (32 - CLIENT_ACCESS_SHIFT);
+
+	gen = atomic_fetch_uint32_t(&client_access_gen);
+	slot = &access->slot[hash];
+
+	seq = atomic_fetch_uint32_t(&slot->seq);
+	if ((seq & 1) == 0) {
+		copy = *slot;
+		atomic_thread_fence_seq_cst();
+		if (atomic_fetch_uint32_t(&slot->seq) == seq &&
+		    copy.gen == gen && copy.family == hostaddr->ss_family &&
+		    memcmp(copy.addr, addr, sizeof(addr)) == 0)
+			return copy.client;
+	}
+
+	if (hostaddr->ss_family == AF_INET6)
+		client = client_matchv6(
+			&((struct sockaddr_in6 *)hostaddr)->sin6_addr, export);
+	else
+		client = client_access_match(hostaddr, access, &cacheable);
+
+	if (!cacheable)
+		return client;
+
+	seq = atomic_fetch_uint32_t(&slot->seq);
+	if ((seq & 1) == 0 && atomic_cas_uint32_t(&slot->seq, &seq, seq + 1)) {
+		slot->gen = gen;
+		slot->family = hostaddr->ss_family;
+		memcpy(slot->addr, addr, sizeof(addr));
+		slot->client = client;
+		atomic_store_uint32_t(&slot->seq, seq + 2);
+	}
+
+	return client;
+}
+
+/**
+ * @brief Forget every memoized client lookup
+ *
+ * Called when what a lookup depends on outside of the export itself,
+ * such as netgroups or host names, may have changed.
+ */
+
+void export_flush_access_cache(void)
+{
+	uint32_t gen = atomic_inc_uint32_t(&client_access_gen);
+
+	/* 0 marks slots that were never filled */
+	if (gen == 0)
+		atomic_inc_uint32_t(&client_access_gen);
+
+	LogEvent(COMPONENT_EXPORT, "Client access cache flushed");
+}
+
 /**
  * @brief Checks if request security flavor is suffcient for the requested
  *        export
@@ -2244,7 +2613,7 @@ void export_check_access(void)
 	}
 
 	/* Does the client match anyone on the client list? */
-	client = client_match_any(hostaddr, op_ctx->export);
+	client = client_lookup(hostaddr, op_ctx->export);
 	if (client != NULL) {
 		/* Take client options */
 		op_ctx->export_perms->options = client->client_perms.options &
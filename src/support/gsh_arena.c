@@ -0,0 +1,123 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_arena.c
+ * @brief Bump allocator for memory sharing one lifetime
+ *
+ * Chunks start small, since most replies need little, and double up
+ * to a limit as an arena fills.  A request too large to fit a chunk
+ * comfortably gets a chunk of its own, leaving the current chunk in
+ * place for the small allocations that follow.  Like gsh_iobuf.c,
+ * this depends on nothing but the memory header so benchmarks can
+ * link it on its own.
+ */
+
+#include "config.h"
+
+#include "abstract_mem.h"
+#include "gsh_arena.h"
+
+/** Size of the first chunk of an arena */
+#define GSH_ARENA_CHUNK_MIN 4096
+/** Largest chunk an arena grows to */
+#define GSH_ARENA_CHUNK_MAX 65536
+
+struct gsh_arena_chunk {
+	struct gsh_arena_chunk *next;
+	/* Keep the data following the header aligned */
+	char data[] __attribute__ ((aligned(GSH_ARENA_ALIGN)));
+};
+
+/**
+ * @brief Allocate from a new chunk
+ *
+ * Called by gsh_arena_alloc when the current chunk can't hold the
+ * request.
+ *
+ * @param[in] arena The arena
+ * @param[in] size  Bytes needed, a multiple of GSH_ARENA_ALIGN
+ *
+ * @return The memory or NULL.
+ */
+
+void *gsh_arena_alloc_slow(struct gsh_arena *arena, size_t size)
+{
+	struct gsh_arena_chunk *chunk;
+	size_t chunk_size = arena->chunk_size;
+
+	if (chunk_size == 0)
+		chunk_size = GSH_ARENA_CHUNK_MIN;
+
+	if (size > (chunk_size - sizeof(*chunk)) / 4) {
+		/* A chunk of its own, behind the current one */
+		chunk = gsh_malloc(sizeof(*chunk) + size);
+		if (chunk == NULL)
+			return NULL;
+
+		arena->size += sizeof(*chunk) + size;
+
+		if (arena->chunks != NULL) {
+			chunk->next = arena->chunks->next;
+			arena->chunks->next = chunk;
+		} else {
+			chunk->next = NULL;
+			arena->chunks = chunk;
+		}
+		return chunk->data;
+	}
+
+	chunk = gsh_malloc(chunk_size);
+	if (chunk == NULL)
+		return NULL;
+
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+	arena->size += chunk_size;
+	arena->next = chunk->data + size;
+	arena->end = (char *)chunk + chunk_size;
+
+	if (chunk_size < GSH_ARENA_CHUNK_MAX)
+		chunk_size *= 2;
+	arena->chunk_size = chunk_size;
+
+	return chunk->data;
+}
+
+/**
+ * @brief Free everything allocated from an arena
+ *
+ * The arena is left empty and may be used again.
+ *
+ * @param[in,out] arena The arena
+ */
+
+void gsh_arena_release(struct gsh_arena *arena)
+{
+	struct gsh_arena_chunk *chunk, *next;
+
+	for (chunk = arena->chunks; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		gsh_free(chunk);
+	}
+
+	memset(arena, 0, sizeof(*arena));
+}
@@ -0,0 +1,203 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_group_commit.c
+ * @brief Merge concurrent commits into one flush per file
+ *
+ * A batch is freed by the last of its commits to return, so the
+ * leader may go on to flush its own file while others still wait on
+ * the batch's condition variable.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "log.h"
+#include "common_utils.h"
+#include "abstract_mem.h"
+#include "gsh_group_commit.h"
+
+struct group_commit_batch {
+	pthread_cond_t cv;	/*< Signalled when full, started or done */
+	uint32_t size;		/*< Room for this many commits */
+	uint32_t count;		/*< Commits joined */
+	uint32_t refs;		/*< Commits not yet returned */
+	bool started;		/*< Sorted, heads may flush */
+	struct group_commit_req *reqs[];
+};
+
+/**
+ * @brief Order commits by file, then offset
+ */
+
+static int group_commit_cmp(const void *a, const void *b)
+{
+	const struct group_commit_req *ra =
+	    *(struct group_commit_req * const *)a;
+	const struct group_commit_req *rb =
+	    *(struct group_commit_req * const *)b;
+
+	if (ra->file != rb->file)
+		return (uintptr_t) ra->file < (uintptr_t) rb->file ? -1 : 1;
+	if (ra->offset != rb->offset)
+		return ra->offset < rb->offset ? -1 : 1;
+	return 0;
+}
+
+/**
+ * @brief Sort a closed batch and elect a head for each file
+ *
+ * Each head's range is widened to cover the commits on its file.
+ * Nothing else touches the batch until it is started.
+ *
+ * @param[in]     gc    The group
+ * @param[in,out] batch The batch
+ */
+
+static void group_commit_sort(struct group_commit *gc,
+			      struct group_commit_batch *batch)
+{
+	struct group_commit_req *head, *r;
+	uint32_t i, files = 0;
+
+	qsort(batch->reqs, batch->count, sizeof(batch->reqs[0]),
+	      group_commit_cmp);
+
+	for (i = 0; i < batch->count; i += head->members) {
+		head = batch->reqs[i];
+		head->first = i;
+		head->members = 1;
+		files++;
+		while (i + head->members < batch->count) {
+			r = batch->reqs[i + head->members];
+			if (r->file != head->file)
+				break;
+			if (r->end > head->end)
+				head->end = r->end;
+			head->members++;
+		}
+	}
+
+	if (gc->batched != NULL)
+		gc->batched(batch->count, files);
+}
+
+/**
+ * @brief Commit a range of a file along with concurrent commits
+ *
+ * Returns once the group's flush function has recorded the result of
+ * this commit, whichever thread called it.
+ *
+ * @param[in]     gc  The group
+ * @param[in,out] req The commit, with file, offset and end set
+ */
+
+void group_commit(struct group_commit *gc, struct group_commit_req *req)
+{
+	struct group_commit_batch *batch;
+	struct timespec deadline;
+	bool leader = false;
+	uint32_t i;
+
+	req->members = 0;
+	req->done = false;
+
+	PTHREAD_MUTEX_lock(&gc->mtx);
+
+	batch = gc->open;
+	if (batch == NULL) {
+		batch = gsh_malloc(sizeof(*batch) +
+				   gc->batch_max * sizeof(batch->reqs[0]));
+		if (batch == NULL) {
+			/* Flush on our own */
+			PTHREAD_MUTEX_unlock(&gc->mtx);
+			gc->flush(&req, 1);
+			req->done = true;
+			return;
+		}
+		PTHREAD_COND_init(&batch->cv, NULL);
+		batch->size = gc->batch_max;
+		batch->count = 0;
+		batch->refs = 0;
+		batch->started = false;
+		gc->open = batch;
+		leader = true;
+	}
+
+	batch->reqs[batch->count++] = req;
+	batch->refs++;
+	if (batch->count == batch->size) {
+		gc->open = NULL;
+		if (!leader)
+			pthread_cond_broadcast(&batch->cv);
+	}
+
+	if (leader) {
+		if (gc->open == batch && gc->flushing != 0 &&
+		    gc->window != 0) {
+			now(&deadline);
+			timespec_add_nsecs(gc->window * NS_PER_USEC,
+					   &deadline);
+			while (gc->open == batch &&
+			       pthread_cond_timedwait(&batch->cv, &gc->mtx,
+						      &deadline) != ETIMEDOUT)
+				;
+		}
+		if (gc->open == batch)
+			gc->open = NULL;
+		gc->flushing++;
+		PTHREAD_MUTEX_unlock(&gc->mtx);
+
+		group_commit_sort(gc, batch);
+
+		PTHREAD_MUTEX_lock(&gc->mtx);
+		batch->started = true;
+		pthread_cond_broadcast(&batch->cv);
+	} else {
+		while (!batch->started)
+			pthread_cond_wait(&batch->cv, &gc->mtx);
+	}
+
+	if (req->members != 0) {
+		PTHREAD_MUTEX_unlock(&gc->mtx);
+		gc->flush(&batch->reqs[req->first], req->members);
+		PTHREAD_MUTEX_lock(&gc->mtx);
+
+		for (i = req->first; i < req->first + req->members; i++)
+			batch->reqs[i]->done = true;
+		if (req->members > 1)
+			pthread_cond_broadcast(&batch->cv);
+	} else {
+		while (!req->done)
+			pthread_cond_wait(&batch->cv, &gc->mtx);
+	}
+
+	if (--batch->refs == 0) {
+		gc->flushing--;
+		PTHREAD_COND_destroy(&batch->cv);
+		gsh_free(batch);
+	}
+
+	PTHREAD_MUTEX_unlock(&gc->mtx);
+}
@@ -0,0 +1,147 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_histogram.c
+ * @brief Log-linear latency histograms
+ *
+ * Reading back a histogram: summing the shards of one, and turning
+ * buckets into percentiles.  Percentiles are reported as the upper
+ * bound of the bucket they fall in, so they never understate a
+ * latency.
+ */
+
+#include "config.h"
+
+#include "gsh_histogram.h"
+
+/**
+ * @brief Add a histogram into a sum
+ *
+ * @param[in,out] sum The sum
+ * @param[in]     h   The histogram, possibly being recorded into
+ */
+
+void gsh_histo_merge(struct gsh_histogram *sum, struct gsh_histogram *h)
+{
+	uint32_t i;
+
+	sum->count += atomic_fetch_uint64_t(&h->count);
+	sum->sum += atomic_fetch_uint64_t(&h->sum);
+	for (i = 0; i < GSH_HISTO_BUCKETS; i++)
+		sum->bucket[i] += atomic_fetch_uint64_t(&h->bucket[i]);
+}
+
+/**
+ * @brief Empty a histogram
+ *
+ * @param[in] h The histogram, possibly being recorded into
+ */
+
+void gsh_histo_reset(struct gsh_histogram *h)
+{
+	uint32_t i;
+
+	for (i = 0; i < GSH_HISTO_BUCKETS; i++)
+		atomic_store_uint64_t(&h->bucket[i], 0);
+	atomic_store_uint64_t(&h->sum, 0);
+	atomic_store_uint64_t(&h->count, 0);
+}
+
+/**
+ * @brief Largest latency counted in a bucket
+ *
+ * @param[in] bucket The bucket index
+ *
+ * @return The latency in nsecs.
+ */
+
+uint64_t gsh_histo_bucket_high(uint32_t bucket)
+{
+	uint32_t exp;
+	uint64_t units;
+
+	if (bucket < GSH_HISTO_SUB) {
+		units = bucket + 1;
+	} else {
+		exp = bucket / GSH_HISTO_SUB + GSH_HISTO_SUB_BITS - 1;
+		units = (uint64_t)(GSH_HISTO_SUB + bucket % GSH_HISTO_SUB + 1)
+			<< (exp - GSH_HISTO_SUB_BITS);
+	}
+
+	return (units << GSH_HISTO_UNIT_SHIFT) - 1;
+}
+
+/**
+ * @brief Latency below which a share of the samples fall
+ *
+ * @param[in] h         The histogram, not being recorded into
+ * @param[in] per_10000 The share, e.g. 9990 for the 99.9th percentile
+ *
+ * @return The latency in nsecs, 0 if the histogram is empty.
+ */
+
+uint64_t gsh_histo_percentile(const struct gsh_histogram *h,
+			      uint32_t per_10000)
+{
+	uint64_t total = 0, rank, seen = 0;
+	uint32_t i;
+
+	/* count and buckets may disagree a little if read while
+	 * recording, so rank against the buckets themselves
+	 */
+	for (i = 0; i < GSH_HISTO_BUCKETS; i++)
+		total += h->bucket[i];
+	if (total == 0)
+		return 0;
+
+	rank = (total * per_10000 + 9999) / 10000;
+	if (rank == 0)
+		rank = 1;
+
+	for (i = 0; i < GSH_HISTO_BUCKETS; i++) {
+		seen += h->bucket[i];
+		if (seen >= rank)
+			break;
+	}
+
+	return gsh_histo_bucket_high(i);
+}
+
+/**
+ * @brief Largest latency counted
+ *
+ * @param[in] h The histogram, not being recorded into
+ *
+ * @return The upper bound of the highest bucket used, 0 if empty.
+ */
+
+uint64_t gsh_histo_max(const struct gsh_histogram *h)
+{
+	uint32_t i = GSH_HISTO_BUCKETS;
+
+	while (i > 0) {
+		if (h->bucket[--i] != 0)
+			return gsh_histo_bucket_high(i);
+	}
+
+	return 0;
+}
@@ -0,0 +1,280 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_interval_tree.c
+ * @brief Intrusive interval tree
+ *
+ * After any change the path from the changed node to the root is
+ * walked once, recomputing heights and max_last and rotating where a
+ * node's subtrees differ in height by two.  Like gsh_arena.c this
+ * depends on nothing else so tests can link it on its own.
+ */
+
+#include "config.h"
+
+#include "gsh_interval_tree.h"
+
+static inline int32_t height(const struct gsh_itree_node *node)
+{
+	return node != NULL ? node->height : 0;
+}
+
+/* Recompute height and max_last from the children */
+static void update(struct gsh_itree_node *node)
+{
+	int32_t hl = height(node->left), hr = height(node->right);
+
+	node->height = (hl > hr ? hl : hr) + 1;
+	node->max_last = node->last;
+	if (node->left != NULL && node->left->max_last > node->max_last)
+		node->max_last = node->left->max_last;
+	if (node->right != NULL && node->right->max_last > node->max_last)
+		node->max_last = node->right->max_last;
+}
+
+/* Point whatever pointed to old at new instead */
+static void replace_child(struct gsh_itree *tree,
+			  struct gsh_itree_node *parent,
+			  struct gsh_itree_node *old,
+			  struct gsh_itree_node *new)
+{
+	if (parent == NULL)
+		tree->root = new;
+	else if (parent->left == old)
+		parent->left = new;
+	else
+		parent->right = new;
+}
+
+static struct gsh_itree_node *rotate_left(struct gsh_itree *tree,
+					  struct gsh_itree_node *x)
+{
+	struct gsh_itree_node *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	y->parent = x->parent;
+	replace_child(tree, x->parent, x, y);
+	y->left = x;
+	x->parent = y;
+	update(x);
+	update(y);
+	return y;
+}
+
+static struct gsh_itree_node *rotate_right(struct gsh_itree *tree,
+					   struct gsh_itree_node *x)
+{
+	struct gsh_itree_node *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	y->parent = x->parent;
+	replace_child(tree, x->parent, x, y);
+	y->right = x;
+	x->parent = y;
+	update(x);
+	update(y);
+	return y;
+}
+
+/* Restore balance and augmentation from node up to the root */
+static void rebalance(struct gsh_itree *tree, struct gsh_itree_node *node)
+{
+	int32_t balance;
+
+	while (node != NULL) {
+		update(node);
+		balance = height(node->left) - height(node->right);
+
+		if (balance > 1) {
+			if (height(node->left->left) <
+			    height(node->left->right))
+				rotate_left(tree, node->left);
+			node = rotate_right(tree, node);
+		} else if (balance < -1) {
+			if (height(node->right->right) <
+			    height(node->right->left))
+				rotate_right(tree, node->right);
+			node = rotate_left(tree, node);
+		}
+
+		node = node->parent;
+	}
+}
+
+/**
+ * @brief Add a node to a tree
+ *
+ * @param[in,out] tree The tree
+ * @param[in,out] node The node, with start and last set
+ */
+
+void gsh_itree_insert(struct gsh_itree *tree, struct gsh_itree_node *node)
+{
+	struct gsh_itree_node *parent = NULL, **link = &tree->root;
+
+	while (*link != NULL) {
+		parent = *link;
+		link = node->start < parent->start
+			? &parent->left : &parent->right;
+	}
+
+	node->left = NULL;
+	node->right = NULL;
+	node->parent = parent;
+	node->height = 1;
+	node->max_last = node->last;
+	*link = node;
+
+	rebalance(tree, parent);
+}
+
+/**
+ * @brief Take a node out of its tree
+ *
+ * A node with two children is replaced by its successor, moved rather
+ * than copied, so other nodes keep their place in the order.
+ *
+ * @param[in,out] tree The tree
+ * @param[in,out] node The node, which must be in the tree
+ */
+
+void gsh_itree_remove(struct gsh_itree *tree, struct gsh_itree_node *node)
+{
+	struct gsh_itree_node *child, *succ, *fix;
+
+	if (node->left != NULL && node->right != NULL) {
+		succ = node->right;
+		while (succ->left != NULL)
+			succ = succ->left;
+
+		if (succ->parent != node) {
+			fix = succ->parent;
+			fix->left = succ->right;
+			if (succ->right != NULL)
+				succ->right->parent = fix;
+			succ->right = node->right;
+			node->right->parent = succ;
+		} else {
+			fix = succ;
+		}
+
+		succ->left = node->left;
+		node->left->parent = succ;
+		succ->parent = node->parent;
+		replace_child(tree, node->parent, node, succ);
+	} else {
+		child = node->left != NULL ? node->left : node->right;
+		fix = node->parent;
+		if (child != NULL)
+			child->parent = fix;
+		replace_child(tree, fix, node, child);
+	}
+
+	node->left = NULL;
+	node->right = NULL;
+	node->parent = NULL;
+	node->height = 0;
+
+	rebalance(tree, fix);
+}
+
+/* Leftmost node under node overlapping [start, last] */
+static struct gsh_itree_node *subtree_first(struct gsh_itree_node *node,
+					    uint64_t start, uint64_t last)
+{
+	while (true) {
+		/* If anything on the left reaches start, either the first
+		 * overlap is there or everything from it on starts after
+		 * last.
+		 */
+		if (node->left != NULL && node->left->max_last >= start) {
+			node = node->left;
+			continue;
+		}
+
+		if (node->start > last)
+			return NULL;
+		if (node->last >= start)
+			return node;
+
+		node = node->right;
+		if (node == NULL || node->max_last < start)
+			return NULL;
+	}
+}
+
+/**
+ * @brief Find the first node overlapping a range
+ *
+ * @param[in] tree  The tree
+ * @param[in] start First value of the range
+ * @param[in] last  Last value of the range, inclusive
+ *
+ * @return The overlapping node with the lowest start, or NULL.
+ */
+
+struct gsh_itree_node *gsh_itree_first(struct gsh_itree *tree,
+				       uint64_t start, uint64_t last)
+{
+	if (tree->root == NULL || tree->root->max_last < start)
+		return NULL;
+
+	return subtree_first(tree->root, start, last);
+}
+
+/**
+ * @brief Find the next node overlapping a range
+ *
+ * @param[in] node  A node overlapping the range
+ * @param[in] start First value of the range
+ * @param[in] last  Last value of the range, inclusive
+ *
+ * @return The next overlapping node in order of start, or NULL.
+ */
+
+struct gsh_itree_node *gsh_itree_next(struct gsh_itree_node *node,
+				      uint64_t start, uint64_t last)
+{
+	struct gsh_itree_node *prev;
+
+	while (true) {
+		if (node->right != NULL && node->right->max_last >= start)
+			return subtree_first(node->right, start, last);
+
+		/* Climb until we come up from a left child */
+		do {
+			prev = node;
+			node = node->parent;
+			if (node == NULL)
+				return NULL;
+		} while (node->right == prev);
+
+		if (node->start > last)
+			return NULL;
+		if (node->last >= start)
+			return node;
+	}
+}
@@ -0,0 +1,227 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_iobuf.c
+ * @brief Size-classed pool of I/O payload buffers
+ *
+ * Every buffer is preceded by one page holding its header, so the
+ * payload keeps the page alignment callers doing direct I/O expect
+ * and gsh_iobuf_put can find the size class from the pointer alone.
+ * This file deliberately depends on nothing but the memory, atomic
+ * and ring headers so benchmarks can link it on its own.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <assert.h>
+#include "abstract_atomic.h"
+#include "abstract_mem.h"
+#include "gsh_ring.h"
+#include "gsh_iobuf.h"
+
+#define GSH_IOBUF_PAGE (1UL << GSH_IOBUF_MIN_SHIFT)
+#define GSH_IOBUF_NCLASS (GSH_IOBUF_MAX_SHIFT - GSH_IOBUF_MIN_SHIFT + 1)
+/** Upper bound on buffers cached per class */
+#define GSH_IOBUF_RING_MAX 4096
+#define GSH_IOBUF_MAGIC 0x696f6266
+
+struct gsh_iobuf_hdr {
+	uint64_t size;		/*< Usable bytes after the header page */
+	uint32_t cls;		/*< Size class, GSH_IOBUF_NCLASS if none */
+	uint32_t magic;
+};
+
+static struct {
+	bool enabled;
+	uint64_t limit;		/*< Most bytes the rings may hold */
+	uint64_t cached;	/*< Bytes the rings hold now */
+	uint64_t hits;
+	uint64_t misses;
+	struct gsh_ring ring[GSH_IOBUF_NCLASS];
+} iobuf_pool;
+
+static inline struct gsh_iobuf_hdr *iobuf_hdr(void *buf)
+{
+	return (struct gsh_iobuf_hdr *)((char *)buf -
+					sizeof(struct gsh_iobuf_hdr));
+}
+
+static inline void *iobuf_base(void *buf)
+{
+	return (char *)buf - GSH_IOBUF_PAGE;
+}
+
+/**
+ * @brief Size class able to hold a request
+ *
+ * @param[in] size Requested size
+ *
+ * @return The class index, or GSH_IOBUF_NCLASS if too large to pool.
+ */
+
+static uint32_t iobuf_class(size_t size)
+{
+	uint32_t cls = 0;
+
+	if (size > (1UL << GSH_IOBUF_MAX_SHIFT))
+		return GSH_IOBUF_NCLASS;
+
+	while ((1UL << (cls + GSH_IOBUF_MIN_SHIFT)) < size)
+		cls++;
+
+	return cls;
+}
+
+/**
+ * @brief Set up the pool
+ *
+ * Must be called once, before any buffer is obtained and while no
+ * other thread uses the pool.  Until then, and when @c cache_bytes is
+ * 0, gsh_iobuf_get and gsh_iobuf_put go straight to the allocator.
+ *
+ * @param[in] cache_bytes Most payload bytes kept for reuse
+ *
+ * @retval 0 on success.
+ * @retval ENOMEM if the rings could not be allocated.
+ */
+
+int gsh_iobuf_init(uint64_t cache_bytes)
+{
+	uint32_t cls;
+	uint64_t n;
+	int rc;
+
+	assert(!iobuf_pool.enabled);
+
+	if (cache_bytes == 0)
+		return 0;
+
+	for (cls = 0; cls < GSH_IOBUF_NCLASS; cls++) {
+		n = cache_bytes >> (cls + GSH_IOBUF_MIN_SHIFT);
+		if (n == 0)
+			n = 1;
+		else if (n > GSH_IOBUF_RING_MAX)
+			n = GSH_IOBUF_RING_MAX;
+
+		rc = gsh_ring_init(&iobuf_pool.ring[cls], n);
+		if (rc != 0) {
+			while (cls-- > 0)
+				gsh_ring_destroy(&iobuf_pool.ring[cls]);
+			return rc;
+		}
+	}
+
+	iobuf_pool.limit = cache_bytes;
+	iobuf_pool.enabled = true;
+	return 0;
+}
+
+/**
+ * @brief Get a page-aligned buffer of at least @c size bytes
+ *
+ * @param[in] size Bytes needed
+ *
+ * @return The buffer or NULL if memory is exhausted.
+ */
+
+void *gsh_iobuf_get(size_t size)
+{
+	uint32_t cls = iobuf_class(size);
+	struct gsh_iobuf_hdr *hdr;
+	uint64_t bytes;
+	void *base;
+	void *buf;
+
+	if (cls < GSH_IOBUF_NCLASS) {
+		bytes = 1UL << (cls + GSH_IOBUF_MIN_SHIFT);
+		if (iobuf_pool.enabled) {
+			buf = gsh_ring_pop(&iobuf_pool.ring[cls]);
+			if (buf != NULL) {
+				atomic_sub_uint64_t(&iobuf_pool.cached, bytes);
+				atomic_inc_uint64_t(&iobuf_pool.hits);
+				return buf;
+			}
+		}
+	} else {
+		bytes = size;
+	}
+
+	atomic_inc_uint64_t(&iobuf_pool.misses);
+
+	base = gsh_malloc_aligned(GSH_IOBUF_PAGE, GSH_IOBUF_PAGE + bytes);
+	if (base == NULL)
+		return NULL;
+
+	buf = (char *)base + GSH_IOBUF_PAGE;
+	hdr = iobuf_hdr(buf);
+	hdr->size = bytes;
+	hdr->cls = cls;
+	hdr->magic = GSH_IOBUF_MAGIC;
+
+	return buf;
+}
+
+/**
+ * @brief Return a buffer obtained from gsh_iobuf_get
+ *
+ * The buffer is kept for reuse if the pool has room for it and
+ * released otherwise.
+ *
+ * @param[in] buf The buffer (may be NULL)
+ */
+
+void gsh_iobuf_put(void *buf)
+{
+	struct gsh_iobuf_hdr *hdr;
+
+	if (buf == NULL)
+		return;
+
+	hdr = iobuf_hdr(buf);
+	assert(hdr->magic == GSH_IOBUF_MAGIC);
+
+	if (iobuf_pool.enabled && hdr->cls < GSH_IOBUF_NCLASS) {
+		if (atomic_add_uint64_t(&iobuf_pool.cached, hdr->size) <=
+		    iobuf_pool.limit &&
+		    gsh_ring_push(&iobuf_pool.ring[hdr->cls], buf))
+			return;
+
+		atomic_sub_uint64_t(&iobuf_pool.cached, hdr->size);
+	}
+
+	gsh_free(iobuf_base(buf));
+}
+
+/**
+ * @brief Read the pool counters
+ *
+ * @param[out] stats Current counters
+ */
+
+void gsh_iobuf_get_stats(struct gsh_iobuf_stats *stats)
+{
+	stats->hits = atomic_fetch_uint64_t(&iobuf_pool.hits);
+	stats->misses = atomic_fetch_uint64_t(&iobuf_pool.misses);
+	stats->cached = atomic_fetch_uint64_t(&iobuf_pool.cached);
+}
@@ -0,0 +1,796 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_slab.c
+ * @brief Slab pool substrate with per-thread magazines
+ *
+ * A slab is a block aligned to its own size, so the slab of an object
+ * is found by masking its address.  The slab header keeps a stack of
+ * the indices of its free objects rather than threading a list
+ * through them, which would clobber objects kept initialized.
+ *
+ * Each thread has a slot per pool, up to SLAB_MAX_POOLS pools, holding
+ * a loaded and a previous magazine.  The previous one is always full
+ * or empty, so a thread only goes to the depot after at least a
+ * magazine's worth of allocations or frees.  Pools past the limit,
+ * or on a thread that could not get a slot, go to the depot for every
+ * object.
+ *
+ * A slot is tied to its pool by serial number.  A destroyed pool's
+ * slabs are freed outright, and a later pool given the same slot
+ * throws away whatever the thread still had cached from it.
+ *
+ * Lock order is slab_pools.mtx, then a pool's sp_mutex.
+ */
+
+#include "config.h"
+
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "log.h"
+#include "common_utils.h"
+#include "gsh_list.h"
+#include "gsh_slab.h"
+
+#define SLAB_MAX_NODES 8
+#define SLAB_MAX_POOLS 128
+#define SLAB_MIN_BYTES 65536
+#define SLAB_MIN_OBJECTS 8
+#define SLAB_ALIGN 16
+#define SLAB_MAGAZINE_DEFAULT 32
+#define SLAB_DEPOT_DEFAULT 16
+
+struct slab_magazine {
+	struct glist_head m_list;	/*< Link in the depot */
+	uint32_t m_count;		/*< Objects held */
+	void *m_objs[];
+};
+
+struct slab {
+	struct glist_head s_all;	/*< Link in the pool's slabs */
+	struct glist_head s_partial;	/*< Link in the node's partial slabs,
+					    while any object is free */
+	uint32_t s_node;		/*< Node the slab was carved on */
+	uint32_t s_free;		/*< Objects on s_stack */
+	char *s_base;			/*< First object */
+	uint16_t s_stack[];		/*< Indices of free objects */
+};
+
+struct slab_node {
+	struct glist_head n_partial;	/*< Slabs with free objects */
+	struct glist_head n_full;	/*< Full magazines, newest first */
+	uint32_t n_nfull;
+};
+
+struct slab_pool {
+	pthread_mutex_t sp_mutex;	/*< Protects everything below but the
+					    constant geometry */
+	pool_t *sp_pool;		/*< The pool this is part of */
+	struct glist_head sp_list;	/*< Link in slab_pools.list */
+	int sp_index;			/*< Thread slot, -1 for none */
+	uint64_t sp_serial;		/*< Unique among all pools created */
+	size_t sp_size;			/*< Object stride */
+	size_t sp_slab_bytes;		/*< Size and alignment of slabs */
+	uint32_t sp_per_slab;		/*< Objects per slab */
+	uint32_t sp_mag_size;
+	uint32_t sp_depot_size;
+	void (*sp_init)(void *object);
+	void (*sp_fini)(void *object);
+	struct glist_head sp_slabs;	/*< All slabs */
+	struct glist_head sp_empty;	/*< Empty magazines */
+	uint32_t sp_nempty;
+	uint64_t sp_nslabs;
+	uint64_t sp_cached;		/*< Objects free in depot and slabs */
+	uint64_t sp_allocs;
+	uint64_t sp_frees;
+	uint64_t sp_hits;
+	uint64_t sp_misses;
+	struct slab_node sp_nodes[SLAB_MAX_NODES];
+};
+
+struct slab_slot {
+	uint64_t ss_serial;		/*< Pool the magazines are for,
+					    0 for none */
+	struct slab_magazine *ss_loaded;
+	struct slab_magazine *ss_previous;
+	uint64_t ss_allocs;		/*< Counts not yet added to the pool */
+	uint64_t ss_frees;
+	uint64_t ss_hits;
+};
+
+struct slab_tcache {
+	struct slab_slot slots[SLAB_MAX_POOLS];
+};
+
+static struct {
+	pthread_mutex_t mtx;	/*< Protects everything below */
+	struct glist_head list;	/*< All slab pools */
+	struct slab_pool *index[SLAB_MAX_POOLS]; /*< Pool owning each slot */
+	uint64_t serial;	/*< Last serial handed out */
+} slab_pools = {
+	.mtx = PTHREAD_MUTEX_INITIALIZER,
+	.list = GLIST_HEAD_INIT(slab_pools.list),
+};
+
+static __thread struct slab_tcache *slab_tcache;
+static pthread_key_t slab_tcache_key;
+static pthread_once_t slab_once = PTHREAD_ONCE_INIT;
+
+static inline struct slab_pool *slab_pool(pool_t *pool)
+{
+	return (struct slab_pool *)pool->substrate_data;
+}
+
+/* Node of the CPU we are on, from getcpu(2) so as not to need libnuma */
+static inline uint32_t slab_node_id(void)
+{
+#ifdef SYS_getcpu
+	unsigned int cpu, node;
+
+	if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+		return node % SLAB_MAX_NODES;
+#endif
+	return 0;
+}
+
+static inline size_t slab_header(uint32_t per_slab)
+{
+	size_t len = offsetof(struct slab, s_stack) +
+		     per_slab * sizeof(uint16_t);
+
+	return (len + 63) & ~(size_t)63;
+}
+
+/* Pick the smallest slab size that holds SLAB_MIN_OBJECTS */
+static void slab_geometry(struct slab_pool *sp)
+{
+	size_t bytes = SLAB_MIN_BYTES;
+	size_t n;
+
+	for (;;) {
+		n = (bytes - offsetof(struct slab, s_stack)) /
+		    (sp->sp_size + sizeof(uint16_t));
+		if (n > UINT16_MAX)
+			n = UINT16_MAX;
+		while (n > 0 && slab_header(n) + n * sp->sp_size > bytes)
+			n--;
+		if (n >= SLAB_MIN_OBJECTS)
+			break;
+		bytes <<= 1;
+	}
+
+	sp->sp_slab_bytes = bytes;
+	sp->sp_per_slab = n;
+}
+
+/**
+ * @brief Carve a new slab, pool locked
+ *
+ * @param[in] sp   The pool
+ * @param[in] node Node the slab is for
+ *
+ * @return The slab, on the node's partial list, or NULL.
+ */
+
+static struct slab *slab_create(struct slab_pool *sp, uint32_t node)
+{
+	struct slab *slab;
+	uint32_t i;
+
+	slab = gsh_malloc_aligned(sp->sp_slab_bytes, sp->sp_slab_bytes);
+	if (slab == NULL)
+		return NULL;
+
+	slab->s_node = node;
+	slab->s_free = sp->sp_per_slab;
+	slab->s_base = (char *)slab + slab_header(sp->sp_per_slab);
+
+	/* Hand out the lowest addresses first */
+	for (i = 0; i < sp->sp_per_slab; i++) {
+		slab->s_stack[i] = sp->sp_per_slab - 1 - i;
+		if (sp->sp_init != NULL)
+			sp->sp_init(slab->s_base + i * sp->sp_size);
+	}
+
+	glist_add_tail(&sp->sp_slabs, &slab->s_all);
+	glist_add(&sp->sp_nodes[node].n_partial, &slab->s_partial);
+	sp->sp_nslabs++;
+	sp->sp_cached += sp->sp_per_slab;
+
+	return slab;
+}
+
+/* Give a slab back, pool locked */
+static void slab_release(struct slab_pool *sp, struct slab *slab)
+{
+	uint32_t i;
+
+	glist_del(&slab->s_partial);
+	glist_del(&slab->s_all);
+
+	if (sp->sp_fini != NULL)
+		for (i = 0; i < sp->sp_per_slab; i++)
+			sp->sp_fini(slab->s_base + i * sp->sp_size);
+
+	sp->sp_nslabs--;
+	sp->sp_cached -= slab->s_free;
+	gsh_free(slab);
+}
+
+/* Take an object from a slab of the node, pool locked */
+static void *slab_get(struct slab_pool *sp, uint32_t node)
+{
+	struct slab *slab;
+	void *object;
+
+	slab = glist_first_entry(&sp->sp_nodes[node].n_partial, struct slab,
+				 s_partial);
+	if (slab == NULL) {
+		slab = slab_create(sp, node);
+		if (slab == NULL)
+			return NULL;
+	}
+
+	object = slab->s_base + slab->s_stack[--slab->s_free] * sp->sp_size;
+	if (slab->s_free == 0)
+		glist_del(&slab->s_partial);
+	sp->sp_cached--;
+
+	return object;
+}
+
+/* Return an object to its slab, pool locked */
+static void slab_put(struct slab_pool *sp, void *object)
+{
+	struct slab *slab;
+	struct glist_head *partial;
+
+	slab = (struct slab *)((uintptr_t)object &
+			       ~(uintptr_t)(sp->sp_slab_bytes - 1));
+	partial = &sp->sp_nodes[slab->s_node].n_partial;
+
+	slab->s_stack[slab->s_free++] =
+	    ((char *)object - slab->s_base) / sp->sp_size;
+	sp->sp_cached++;
+
+	/* Fullest slabs first, so the emptier ones can drain */
+	if (slab->s_free == 1)
+		glist_add(partial, &slab->s_partial);
+
+	/* Keep one free slab per node against churn */
+	if (slab->s_free == sp->sp_per_slab &&
+	    (partial->next != &slab->s_partial ||
+	     partial->prev != &slab->s_partial))
+		slab_release(sp, slab);
+}
+
+static void magazine_drain(struct slab_pool *sp, struct slab_magazine *mag)
+{
+	while (mag->m_count != 0)
+		slab_put(sp, mag->m_objs[--mag->m_count]);
+}
+
+static struct slab_magazine *magazine_new(struct slab_pool *sp)
+{
+	struct slab_magazine *mag;
+
+	mag = gsh_malloc(sizeof(*mag) + sp->sp_mag_size * sizeof(void *));
+	if (mag != NULL)
+		mag->m_count = 0;
+
+	return mag;
+}
+
+/* Depot operations, pool locked */
+
+static struct slab_magazine *depot_get_empty(struct slab_pool *sp)
+{
+	struct slab_magazine *mag;
+
+	mag = glist_first_entry(&sp->sp_empty, struct slab_magazine, m_list);
+	if (mag == NULL)
+		return magazine_new(sp);
+
+	glist_del(&mag->m_list);
+	sp->sp_nempty--;
+
+	return mag;
+}
+
+static void depot_put_empty(struct slab_pool *sp, struct slab_magazine *mag)
+{
+	if (sp->sp_nempty >= sp->sp_depot_size) {
+		gsh_free(mag);
+		return;
+	}
+
+	glist_add(&sp->sp_empty, &mag->m_list);
+	sp->sp_nempty++;
+}
+
+static struct slab_magazine *depot_get_full(struct slab_pool *sp,
+					    uint32_t node)
+{
+	struct slab_node *sn = &sp->sp_nodes[node];
+	struct slab_magazine *mag;
+
+	mag = glist_first_entry(&sn->n_full, struct slab_magazine, m_list);
+	if (mag == NULL)
+		return NULL;
+
+	glist_del(&mag->m_list);
+	sn->n_nfull--;
+	sp->sp_cached -= mag->m_count;
+
+	return mag;
+}
+
+static void depot_put_full(struct slab_pool *sp, uint32_t node,
+			   struct slab_magazine *mag)
+{
+	struct slab_node *sn = &sp->sp_nodes[node];
+
+	glist_add(&sn->n_full, &mag->m_list);
+	sn->n_nfull++;
+	sp->sp_cached += mag->m_count;
+
+	if (sn->n_nfull <= sp->sp_depot_size)
+		return;
+
+	/* Over the limit, empty the oldest back into its slabs */
+	mag = glist_entry(sn->n_full.prev, struct slab_magazine, m_list);
+	glist_del(&mag->m_list);
+	sn->n_nfull--;
+	sp->sp_cached -= mag->m_count;
+	magazine_drain(sp, mag);
+	depot_put_empty(sp, mag);
+}
+
+/* Add a slot's counts to its pool, pool locked */
+static void slab_fold(struct slab_pool *sp, struct slab_slot *slot)
+{
+	sp->sp_allocs += slot->ss_allocs;
+	sp->sp_frees += slot->ss_frees;
+	sp->sp_hits += slot->ss_hits;
+	slot->ss_allocs = 0;
+	slot->ss_frees = 0;
+	slot->ss_hits = 0;
+}
+
+/**
+ * @brief Flush a thread's magazines back to their pools as it exits
+ *
+ * @param[in] arg The thread's cache
+ */
+
+static void slab_tcache_exit(void *arg)
+{
+	struct slab_tcache *tc = arg;
+	struct slab_slot *slot;
+	struct slab_pool *sp;
+	int i;
+
+	PTHREAD_MUTEX_lock(&slab_pools.mtx);
+
+	for (i = 0; i < SLAB_MAX_POOLS; i++) {
+		slot = &tc->slots[i];
+		if (slot->ss_serial == 0)
+			continue;
+
+		sp = slab_pools.index[i];
+		if (sp != NULL && sp->sp_serial == slot->ss_serial) {
+			PTHREAD_MUTEX_lock(&sp->sp_mutex);
+			magazine_drain(sp, slot->ss_loaded);
+			magazine_drain(sp, slot->ss_previous);
+			slab_fold(sp, slot);
+			PTHREAD_MUTEX_unlock(&sp->sp_mutex);
+		}
+
+		gsh_free(slot->ss_loaded);
+		gsh_free(slot->ss_previous);
+	}
+
+	PTHREAD_MUTEX_unlock(&slab_pools.mtx);
+
+	gsh_free(tc);
+	slab_tcache = NULL;
+}
+
+static void slab_once_init(void)
+{
+	(void)pthread_key_create(&slab_tcache_key, slab_tcache_exit);
+}
+
+/* Give a slot new magazines for the pool now owning it */
+static bool slab_slot_load(struct slab_pool *sp, struct slab_slot *slot)
+{
+	/* Anything left belonged to a destroyed pool, whose slabs are
+	 * gone, so the magazines are just dropped */
+	gsh_free(slot->ss_loaded);
+	gsh_free(slot->ss_previous);
+	memset(slot, 0, sizeof(*slot));
+
+	slot->ss_loaded = magazine_new(sp);
+	slot->ss_previous = magazine_new(sp);
+
+	if (slot->ss_loaded == NULL || slot->ss_previous == NULL) {
+		gsh_free(slot->ss_loaded);
+		gsh_free(slot->ss_previous);
+		slot->ss_loaded = NULL;
+		slot->ss_previous = NULL;
+		return false;
+	}
+
+	slot->ss_serial = sp->sp_serial;
+	return true;
+}
+
+/* This thread's slot for the pool, or NULL to go to the depot */
+static inline struct slab_slot *slab_slot(struct slab_pool *sp)
+{
+	struct slab_tcache *tc = slab_tcache;
+	struct slab_slot *slot;
+
+	if (sp->sp_index < 0)
+		return NULL;
+
+	if (unlikely(tc == NULL)) {
+		tc = gsh_calloc(1, sizeof(*tc));
+		if (tc == NULL)
+			return NULL;
+		slab_tcache = tc;
+		(void)pthread_setspecific(slab_tcache_key, tc);
+	}
+
+	slot = &tc->slots[sp->sp_index];
+	if (likely(slot->ss_serial == sp->sp_serial))
+		return slot;
+
+	return slab_slot_load(sp, slot) ? slot : NULL;
+}
+
+/**
+ * @brief Initialize a slab pool
+ *
+ * @param[in] size  Size of the objects
+ * @param[in] param struct pool_slab_params, or NULL for the defaults
+ *
+ * @return The pool or NULL.
+ */
+
+static pool_t *pool_slab_initializer(size_t size, void *param)
+{
+	struct pool_slab_params *params = param;
+	struct slab_pool *sp;
+	pool_t *pool;
+	int i;
+
+	(void)pthread_once(&slab_once, slab_once_init);
+
+	pool = gsh_calloc(1, sizeof(pool_t) + sizeof(struct slab_pool));
+	if (pool == NULL)
+		return NULL;
+
+	sp = slab_pool(pool);
+	sp->sp_pool = pool;
+	PTHREAD_MUTEX_init(&sp->sp_mutex, NULL);
+
+	sp->sp_size = (size + SLAB_ALIGN - 1) & ~(size_t)(SLAB_ALIGN - 1);
+	if (sp->sp_size == 0)
+		sp->sp_size = SLAB_ALIGN;
+	slab_geometry(sp);
+
+	sp->sp_mag_size = SLAB_MAGAZINE_DEFAULT;
+	sp->sp_depot_size = SLAB_DEPOT_DEFAULT;
+	if (params != NULL) {
+		if (params->magazine_size != 0)
+			sp->sp_mag_size = params->magazine_size;
+		if (params->depot_size != 0)
+			sp->sp_depot_size = params->depot_size;
+		sp->sp_init = params->init;
+		sp->sp_fini = params->fini;
+	}
+
+	glist_init(&sp->sp_slabs);
+	glist_init(&sp->sp_empty);
+	glist_init(&sp->sp_list);
+	for (i = 0; i < SLAB_MAX_NODES; i++) {
+		glist_init(&sp->sp_nodes[i].n_partial);
+		glist_init(&sp->sp_nodes[i].n_full);
+	}
+	sp->sp_index = -1;
+
+	return pool;
+}
+
+/**
+ * @brief Make a slab pool visible to pool_slab_foreach
+ *
+ * Called by pool_init once the name and object size are set, so no
+ * one walking the pools sees a half-built one.  The pool also gets its
+ * thread magazine slot here.
+ *
+ * @param[in] pool The new pool
+ */
+
+static void pool_slab_publish(pool_t *pool)
+{
+	struct slab_pool *sp = slab_pool(pool);
+	int i;
+
+	PTHREAD_MUTEX_lock(&slab_pools.mtx);
+
+	sp->sp_serial = ++slab_pools.serial;
+	for (i = 0; i < SLAB_MAX_POOLS; i++) {
+		if (slab_pools.index[i] == NULL) {
+			slab_pools.index[i] = sp;
+			sp->sp_index = i;
+			break;
+		}
+	}
+	glist_add_tail(&slab_pools.list, &sp->sp_list);
+
+	PTHREAD_MUTEX_unlock(&slab_pools.mtx);
+
+	if (sp->sp_index < 0)
+		LogInfo(COMPONENT_INIT,
+			"Out of thread magazine slots, slab pool %s will lock for every object",
+			pool->name != NULL ? pool->name : "(unnamed)");
+}
+
+/**
+ * @brief Destroy a slab pool
+ *
+ * Every object must have been freed, and no other thread may use the
+ * pool any more.  Objects still in other threads' magazines are
+ * released with their slabs.
+ *
+ * @param[in] pool The pool
+ */
+
+static void pool_slab_destroy(pool_t *pool)
+{
+	struct slab_pool *sp = slab_pool(pool);
+	struct glist_head *glist, *glistn;
+	struct slab_magazine *mag;
+	int i;
+
+	PTHREAD_MUTEX_lock(&slab_pools.mtx);
+	glist_del(&sp->sp_list);
+	if (sp->sp_index >= 0)
+		slab_pools.index[sp->sp_index] = NULL;
+	PTHREAD_MUTEX_unlock(&slab_pools.mtx);
+
+	glist_for_each_safe(glist, glistn, &sp->sp_slabs)
+		slab_release(sp, glist_entry(glist, struct slab, s_all));
+
+	for (i = 0; i < SLAB_MAX_NODES; i++) {
+		glist_for_each_safe(glist, glistn, &sp->sp_nodes[i].n_full) {
+			mag = glist_entry(glist, struct slab_magazine, m_list);
+			glist_del(&mag->m_list);
+			gsh_free(mag);
+		}
+	}
+
+	glist_for_each_safe(glist, glistn, &sp->sp_empty) {
+		mag = glist_entry(glist, struct slab_magazine, m_list);
+		glist_del(&mag->m_list);
+		gsh_free(mag);
+	}
+
+	PTHREAD_MUTEX_destroy(&sp->sp_mutex);
+	gsh_free(pool->name);
+	gsh_free(pool);
+}
+
+/**
+ * @brief Allocate an object from a slab pool
+ *
+ * @param[in] pool The pool
+ *
+ * @return The object or NULL.
+ */
+
+static void *pool_slab_alloc(pool_t *pool)
+{
+	struct slab_pool *sp = slab_pool(pool);
+	struct slab_slot *slot = slab_slot(sp);
+	struct slab_magazine *mag;
+	void *object = NULL;
+	uint32_t node;
+
+	if (likely(slot != NULL)) {
+		mag = slot->ss_loaded;
+		if (mag->m_count == 0 && slot->ss_previous->m_count != 0) {
+			slot->ss_loaded = slot->ss_previous;
+			slot->ss_previous = mag;
+			mag = slot->ss_loaded;
+		}
+		if (likely(mag->m_count != 0)) {
+			object = mag->m_objs[--mag->m_count];
+			slot->ss_allocs++;
+			slot->ss_hits++;
+			goto out;
+		}
+	}
+
+	node = slab_node_id();
+
+	PTHREAD_MUTEX_lock(&sp->sp_mutex);
+
+	if (slot != NULL) {
+		/* Both magazines empty, trade one for a full one, or
+		 * failing that fill it from the slabs */
+		mag = depot_get_full(sp, node);
+		if (mag != NULL) {
+			depot_put_empty(sp, slot->ss_previous);
+			slot->ss_previous = slot->ss_loaded;
+			slot->ss_loaded = mag;
+		} else {
+			mag = slot->ss_loaded;
+			while (mag->m_count < sp->sp_mag_size) {
+				object = slab_get(sp, node);
+				if (object == NULL)
+					break;
+				mag->m_objs[mag->m_count++] = object;
+			}
+		}
+		object = mag->m_count != 0 ? mag->m_objs[--mag->m_count]
+					   : NULL;
+		slab_fold(sp, slot);
+	} else {
+		object = slab_get(sp, node);
+	}
+
+	if (object != NULL) {
+		sp->sp_allocs++;
+		sp->sp_misses++;
+	}
+
+	PTHREAD_MUTEX_unlock(&sp->sp_mutex);
+
+	if (object == NULL)
+		return NULL;
+
+ out:
+	if (sp->sp_init == NULL && pool->constructor == NULL)
+		memset(object, 0, pool->object_size);
+
+	return object;
+}
+
+/**
+ * @brief Free an object to a slab pool
+ *
+ * @param[in] pool   The pool
+ * @param[in] object The object
+ */
+
+static void pool_slab_free(pool_t *pool, void *object)
+{
+	struct slab_pool *sp = slab_pool(pool);
+	struct slab_slot *slot = slab_slot(sp);
+	struct slab_magazine *mag;
+	uint32_t node;
+
+	if (likely(slot != NULL)) {
+		mag = slot->ss_loaded;
+		if (mag->m_count == sp->sp_mag_size &&
+		    slot->ss_previous->m_count == 0) {
+			slot->ss_loaded = slot->ss_previous;
+			slot->ss_previous = mag;
+			mag = slot->ss_loaded;
+		}
+		if (likely(mag->m_count < sp->sp_mag_size)) {
+			mag->m_objs[mag->m_count++] = object;
+			slot->ss_frees++;
+			slot->ss_hits++;
+			return;
+		}
+	}
+
+	node = slab_node_id();
+
+	PTHREAD_MUTEX_lock(&sp->sp_mutex);
+
+	if (slot != NULL) {
+		/* Both magazines full, trade one for an empty one */
+		mag = depot_get_empty(sp);
+		if (mag != NULL) {
+			depot_put_full(sp, node, slot->ss_previous);
+			slot->ss_previous = slot->ss_loaded;
+			slot->ss_loaded = mag;
+			mag->m_objs[mag->m_count++] = object;
+			object = NULL;
+		}
+		slab_fold(sp, slot);
+	}
+
+	if (object != NULL)
+		slab_put(sp, object);
+
+	sp->sp_frees++;
+	sp->sp_misses++;
+
+	PTHREAD_MUTEX_unlock(&sp->sp_mutex);
+}
+
+const struct pool_substrate_vector pool_slab_substrate[] = {
+	{
+		.initializer = pool_slab_initializer,
+		.destroyer = pool_slab_destroy,
+		.allocator = pool_slab_alloc,
+		.freer = pool_slab_free,
+		.publisher = pool_slab_publish
+	}
+};
+
+/**
+ * @brief Get the statistics of a slab pool
+ *
+ * @param[in]  pool  The pool, which must use pool_slab_substrate
+ * @param[out] stats The statistics
+ */
+
+void pool_slab_stats(pool_t *pool, struct pool_slab_stats *stats)
+{
+	struct slab_pool *sp = slab_pool(pool);
+
+	PTHREAD_MUTEX_lock(&sp->sp_mutex);
+
+	stats->object_size = pool->object_size;
+	stats->slabs = sp->sp_nslabs;
+	stats->bytes = sp->sp_nslabs * sp->sp_slab_bytes;
+	/* Another thread's frees may be counted before its allocs */
+	stats->live = sp->sp_allocs > sp->sp_frees
+			? sp->sp_allocs - sp->sp_frees : 0;
+	stats->cached = sp->sp_cached;
+	stats->hits = sp->sp_hits;
+	stats->misses = sp->sp_misses;
+
+	PTHREAD_MUTEX_unlock(&sp->sp_mutex);
+}
+
+/**
+ * @brief Call a function on every slab pool
+ *
+ * No pool can be created or destroyed meanwhile.
+ *
+ * @param[in] cb  The function
+ * @param[in] arg Passed to it
+ */
+
+void pool_slab_foreach(void (*cb)(pool_t *pool, void *arg), void *arg)
+{
+	struct glist_head *glist;
+	struct slab_pool *sp;
+
+	PTHREAD_MUTEX_lock(&slab_pools.mtx);
+
+	glist_for_each(glist, &slab_pools.list) {
+		sp = glist_entry(glist, struct slab_pool, sp_list);
+		cb(sp->sp_pool, arg);
+	}
+
+	PTHREAD_MUTEX_unlock(&slab_pools.mtx);
+}
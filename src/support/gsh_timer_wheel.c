@@ -0,0 +1,195 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file gsh_timer_wheel.c
+ * @brief Timer wheel for expiring state on a deadline
+ *
+ * Every timer sits in the slot of a second between tw_cursor and
+ * tw_cursor + GSH_TIMER_WHEEL_SLOTS - 1: its deadline, or the last
+ * second if it is further out.  So the slot at the cursor holds
+ * everything due then, plus timers parked there until a later turn,
+ * and the cursor only moves past a slot once it is empty.  A timer
+ * scheduled for a second the cursor has passed goes on the overdue
+ * list instead.
+ */
+
+#include "config.h"
+
+#include "log.h"
+#include "common_utils.h"
+#include "gsh_timer_wheel.h"
+
+/**
+ * @brief Initialize an empty timer wheel
+ *
+ * @param[out] tw The wheel
+ */
+
+void gsh_timer_wheel_init(struct gsh_timer_wheel *tw)
+{
+	int i;
+
+	PTHREAD_MUTEX_init(&tw->tw_mutex, NULL);
+	tw->tw_cursor = time(NULL);
+	tw->tw_count = 0;
+	glist_init(&tw->tw_overdue);
+
+	for (i = 0; i < GSH_TIMER_WHEEL_SLOTS; i++)
+		glist_init(&tw->tw_slots[i]);
+}
+
+/* Put a timer in its slot, wheel locked */
+static void timer_place(struct gsh_timer_wheel *tw, struct gsh_timer *timer)
+{
+	time_t when = timer->t_expire;
+
+	if (when < tw->tw_cursor) {
+		glist_add_tail(&tw->tw_overdue, &timer->t_list);
+		return;
+	}
+
+	if (when - tw->tw_cursor >= GSH_TIMER_WHEEL_SLOTS)
+		when = tw->tw_cursor + GSH_TIMER_WHEEL_SLOTS - 1;
+
+	glist_add_tail(&tw->tw_slots[when % GSH_TIMER_WHEEL_SLOTS],
+		       &timer->t_list);
+}
+
+/**
+ * @brief Schedule a timer, or move it if already scheduled
+ *
+ * @param[in,out] tw     The wheel
+ * @param[in,out] timer  The timer
+ * @param[in]     expire When it is due, in seconds since the epoch
+ */
+
+void gsh_timer_schedule(struct gsh_timer_wheel *tw, struct gsh_timer *timer,
+			time_t expire)
+{
+	PTHREAD_MUTEX_lock(&tw->tw_mutex);
+
+	if (gsh_timer_scheduled(timer))
+		glist_del(&timer->t_list);
+	else
+		tw->tw_count++;
+
+	timer->t_expire = expire;
+	timer_place(tw, timer);
+
+	PTHREAD_MUTEX_unlock(&tw->tw_mutex);
+}
+
+/**
+ * @brief Cancel a timer
+ *
+ * @param[in,out] tw    The wheel
+ * @param[in,out] timer The timer
+ *
+ * @return true if the timer was scheduled.
+ */
+
+bool gsh_timer_cancel(struct gsh_timer_wheel *tw, struct gsh_timer *timer)
+{
+	bool scheduled;
+
+	PTHREAD_MUTEX_lock(&tw->tw_mutex);
+
+	scheduled = gsh_timer_scheduled(timer);
+
+	if (scheduled) {
+		glist_del(&timer->t_list);
+		timer->t_expire = 0;
+		tw->tw_count--;
+	}
+
+	PTHREAD_MUTEX_unlock(&tw->tw_mutex);
+
+	return scheduled;
+}
+
+/**
+ * @brief Take a timer that is due off the wheel
+ *
+ * The timer is no longer scheduled when returned.  If the wheel holds
+ * no reference on the object the timer is in, whoever frees that object
+ * must first cancel the timer, and hold must take a reference; it is
+ * called with the wheel locked, so before any such cancel can return.
+ *
+ * @param[in,out] tw   The wheel
+ * @param[in]     now  Current time
+ * @param[in]     hold Function to keep the timer's object alive, or NULL
+ *
+ * @return A timer due at or before now, or NULL if there are none.
+ */
+
+struct gsh_timer *gsh_timer_wheel_pop(struct gsh_timer_wheel *tw,
+				      time_t now,
+				      void (*hold)(struct gsh_timer *))
+{
+	struct gsh_timer *timer = NULL;
+	struct glist_head *slot, *glist, *glistn;
+
+	PTHREAD_MUTEX_lock(&tw->tw_mutex);
+
+	timer = glist_first_entry(&tw->tw_overdue, struct gsh_timer, t_list);
+
+	if (timer != NULL) {
+		glist_del(&timer->t_list);
+		goto found;
+	}
+
+	while (tw->tw_count != 0 && tw->tw_cursor <= now) {
+		slot = &tw->tw_slots[tw->tw_cursor % GSH_TIMER_WHEEL_SLOTS];
+
+		glist_for_each_safe(glist, glistn, slot) {
+			timer = glist_entry(glist, struct gsh_timer, t_list);
+			glist_del(&timer->t_list);
+
+			if (timer->t_expire <= now)
+				goto found;
+
+			/* Parked for a later turn, move it on */
+			timer_place(tw, timer);
+		}
+
+		timer = NULL;
+		tw->tw_cursor++;
+	}
+
+	/* Nothing scheduled, or only later, keep the cursor current */
+	if (tw->tw_count == 0 && tw->tw_cursor <= now)
+		tw->tw_cursor = now + 1;
+
+	goto out;
+
+ found:
+	timer->t_expire = 0;
+	tw->tw_count--;
+
+	if (hold != NULL)
+		hold(timer);
+
+ out:
+	PTHREAD_MUTEX_unlock(&tw->tw_mutex);
+
+	return timer;
+}
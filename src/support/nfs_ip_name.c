@@ -341,7 +341,9 @@ static struct ip_name_cache ip_name_cache = {
 	.hash_param.compare_key = compare_ip_name,
 	.hash_param.key_to_str = display_ip_name_key,
 	.hash_param.val_to_str = display_ip_name_val,
-	.hash_param.flags = HT_FLAG_NONE,
+	.hash_param.flags = HT_FLAG_OPEN_ADDR,
+	/* Copy whole addresses so lookups need no lock */
+	.hash_param.oa_key_len = sizeof(sockaddr_t),
 };
 
 /**
@@ -98,8 +98,28 @@ static struct config_item core_params[] = {
 		       nfs_core_param, dispatch_max_reqs),
 	CONF_ITEM_UI32("Dispatch_Max_Reqs_Xprt", 1, 2048, 512,
 		       nfs_core_param, dispatch_max_reqs_xprt),
+	CONF_ITEM_UI32("Dispatch_Queue_Shards", 0, 1024, 0,
+		       nfs_core_param, dispatch_queue_shards),
+	CONF_ITEM_UI32("Dispatch_Queue_Depth", 16, 65536, 1024,
+		       nfs_core_param, dispatch_queue_depth),
+	CONF_ITEM_UI32("Dispatch_Weight_Mount", 1, 1024, 1,
+		       nfs_core_param, dispatch_weight.mount),
+	CONF_ITEM_UI32("Dispatch_Weight_Call", 1, 1024, 2,
+		       nfs_core_param, dispatch_weight.call),
+	CONF_ITEM_UI32("Dispatch_Weight_Low_Latency", 1, 1024, 8,
+		       nfs_core_param, dispatch_weight.low_latency),
+	CONF_ITEM_UI32("Dispatch_Weight_High_Latency", 1, 1024, 4,
+		       nfs_core_param, dispatch_weight.high_latency),
+	CONF_ITEM_UI32("Dispatch_Weight_Bulk", 1, 1024, 1,
+		       nfs_core_param, dispatch_weight.bulk),
+	CONF_ITEM_UI32("Dispatch_Fair_Share", 0, 2048, 64,
+		       nfs_core_param, dispatch_fair_share),
+	CONF_ITEM_UI64("Read_Buffer_Cache", 0, UINT64_MAX, 64 * 1024 * 1024,
+		       nfs_core_param, read_buffer_cache),
 	CONF_ITEM_BOOL("DRC_Disabled", false,
 		       nfs_core_param, drc.disabled),
+	CONF_ITEM_BOOL("DRC_Encoded", false,
+		       nfs_core_param, drc.encoded),
 	CONF_ITEM_UI32("DRC_TCP_Npart", 1, 20, DRC_TCP_NPART,
 		       nfs_core_param, drc.tcp.npart),
 	CONF_ITEM_UI32("DRC_TCP_Size", 1, 32767, DRC_TCP_SIZE,
@@ -108,6 +128,8 @@ static struct config_item core_params[] = {
 		       nfs_core_param, drc.tcp.cachesz),
 	CONF_ITEM_UI32("DRC_TCP_Hiwat", 1, 256, DRC_TCP_HIWAT,
 		       nfs_core_param, drc.tcp.hiwat),
+	CONF_ITEM_UI64("DRC_TCP_Hiwat_Bytes", 0, UINT64_MAX, 0,
+		       nfs_core_param, drc.tcp.hiwat_bytes),
 	CONF_ITEM_UI32("DRC_TCP_Recycle_Npart", 1, 20, DRC_TCP_RECYCLE_NPART,
 		       nfs_core_param, drc.tcp.recycle_npart),
 	CONF_ITEM_UI32("DRC_TCP_Recycle_Expire_S", 0, 60*60, 600,
@@ -122,6 +144,8 @@ static struct config_item core_params[] = {
 		       nfs_core_param, drc.udp.cachesz),
 	CONF_ITEM_UI32("DRC_UDP_Hiwat", 1, 32768, DRC_UDP_HIWAT,
 		       nfs_core_param, drc.udp.hiwat),
+	CONF_ITEM_UI64("DRC_UDP_Hiwat_Bytes", 0, UINT64_MAX, 0,
+		       nfs_core_param, drc.udp.hiwat_bytes),
 	CONF_ITEM_BOOL("DRC_UDP_Checksum", DRC_UDP_CHECKSUM,
 		       nfs_core_param, drc.udp.checksum),
 	CONF_ITEM_UI32("RPC_Debug_Flags", 0, UINT32_MAX, TIRPC_DEBUG_FLAGS,
@@ -156,6 +180,8 @@ static struct config_item core_params[] = {
 		       nfs_core_param, enable_RQUOTA),
 	CONF_ITEM_BOOL("Enable_Fast_Stats", false,
 		       nfs_core_param, enable_FASTSTATS),
+	CONF_ITEM_UI32("Stats_Shards", 0, 1024, 0,
+		       nfs_core_param, stats_shards),
 	CONF_ITEM_I64("Manage_Gids_Expiration", 0, 7*24*60*60, 30*60,
 			nfs_core_param, manage_gids_expiration),
 	CONF_ITEM_PATH("Plugins_Dir", 1, MAXPATHLEN, FSAL_MODULE_LOC,
@@ -237,6 +263,17 @@ static struct config_item version4_params[] = {
 		       nfs_version4_parameter, pnfs_mds),
 	CONF_ITEM_BOOL("PNFS_DS", true,
 		       nfs_version4_parameter, pnfs_ds),
+	CONF_ITEM_UI32("Max_Session_Slots", 1, 1024,
+		       MAX_SESSION_SLOTS_DEFAULT,
+		       nfs_version4_parameter, max_session_slots),
+	CONF_ITEM_UI64("Session_Reply_Cache_Size", 1048576, UINT64_MAX,
+		       SESSION_REPLY_CACHE_SIZE_DEFAULT,
+		       nfs_version4_parameter, session_reply_cache_size),
+	CONF_ITEM_UI64("Copy_Chunk_Size", 1048576, UINT64_MAX,
+		       COPY_CHUNK_SIZE_DEFAULT,
+		       nfs_version4_parameter, copy_chunk_size),
+	CONF_ITEM_UI32("Copy_Threads", 1, 64, COPY_THREADS_DEFAULT,
+		       nfs_version4_parameter, copy_threads),
 	CONFIG_EOL
 };
 
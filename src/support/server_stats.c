@@ -41,6 +41,7 @@
 
 #include <time.h>
 #include <unistd.h>
+#include <sched.h>
 #include <sys/types.h>
 #include <stdint.h>
 #include <sys/param.h>
@@ -60,6 +61,12 @@
 #include "server_stats.h"
 #include <abstract_atomic.h>
 #include "nfs_proto_functions.h"
+#include "nfs_req_queue.h"
+#include "gsh_histogram.h"
+#include "gsh_slab.h"
+#ifdef _USE_9P
+#include "9p.h"
+#endif
 
 #define NFS_V3_NB_COMMAND (NFSPROC3_COMMIT + 1)
 #define NFS_V4_NB_COMMAND 2
@@ -69,7 +76,7 @@
 #define RQUOTA_NB_COMMAND (RQUOTAPROC_SETACTIVEQUOTA + 1)
 #define NFS_V40_NB_OPERATION (NFS4_OP_RELEASE_LOCKOWNER + 1)
 #define NFS_V41_NB_OPERATION (NFS4_OP_RECLAIM_COMPLETE + 1)
-#define NFS_V42_NB_OPERATION (NFS4_OP_WRITE_SAME + 1)
+#define NFS_V42_NB_OPERATION (NFS4_OP_CLONE + 1)
 #define _9P_NB_COMMAND 33
 
 struct op_name {
@@ -213,6 +220,7 @@ static const struct op_name optabv4[] = {
 	[NFS4_OP_READ_PLUS] = {.name = "READ_PLUS",},
 	[NFS4_OP_SEEK] = {.name = "SEEK",},
 	[NFS4_OP_WRITE_SAME] = {.name = "WRITE_SAME",},
+	[NFS4_OP_CLONE] = {.name = "CLONE",},
 };
 
 /* Classify protocol ops for stats purposes
@@ -331,21 +339,21 @@ struct nfsv3_stats {
 	struct proto_op cmds;	/* non-I/O ops = cmds - (read+write) */
 	struct xfer_op read;
 	struct xfer_op write;
-};
+} __attribute__ ((aligned(CACHE_LINE_SIZE)));
 
 /* Mount statistics counters
  */
 struct mnt_stats {
 	struct proto_op v1_ops;
 	struct proto_op v3_ops;
-};
+} __attribute__ ((aligned(CACHE_LINE_SIZE)));
 
 /* lock manager counters
  */
 
 struct nlmv4_stats {
 	struct proto_op ops;
-};
+} __attribute__ ((aligned(CACHE_LINE_SIZE)));
 
 /* Quota counters
  */
@@ -353,7 +361,7 @@ struct nlmv4_stats {
 struct rquota_stats {
 	struct proto_op ops;
 	struct proto_op ext_ops;
-};
+} __attribute__ ((aligned(CACHE_LINE_SIZE)));
 
 /* NFSv4 statistics counters
  */
@@ -363,7 +371,7 @@ struct nfsv40_stats {
 	uint64_t ops_per_compound;	/* avg = total / ops_per */
 	struct xfer_op read;
 	struct xfer_op write;
-};
+} __attribute__ ((aligned(CACHE_LINE_SIZE)));
 
 struct nfsv41_stats {
 	struct proto_op compounds;
@@ -375,7 +383,7 @@ struct nfsv41_stats {
 	struct layout_op layout_commit;
 	struct layout_op layout_return;
 	struct layout_op recall;
-};
+} __attribute__ ((aligned(CACHE_LINE_SIZE)));
 
 struct _9p_stats {
 	struct proto_op cmds;	/* non-I/O ops */
@@ -389,7 +397,7 @@ struct _9p_stats {
 		uint64_t tx_pkt;
 		uint64_t tx_err;
 	} trans;
-};
+} __attribute__ ((aligned(CACHE_LINE_SIZE)));
 
 struct global_stats {
 	struct nfsv3_stats nfsv3;
@@ -404,7 +412,7 @@ struct global_stats {
 	struct nlm_ops lm;
 	struct mnt_ops mn;
 	struct qta_ops qt;
-};
+} __attribute__ ((aligned(CACHE_LINE_SIZE)));
 
 struct deleg_stats {
 	uint32_t curr_deleg_grants; /* current num of delegations owned by
@@ -415,7 +423,59 @@ struct deleg_stats {
 	uint32_t num_revokes;	    /* Num revokes for the client */
 };
 
-static struct global_stats global_st;
+struct slot_stats {
+	uint32_t slots;		/* forechannel slots of the latest session */
+	uint32_t target;	/* latest sr_target_highest_slotid sent */
+	uint32_t busy;		/* slots with a request in progress */
+	uint32_t max_busy;	/* most slots ever busy at once */
+	uint64_t requests;	/* requests started on a slot */
+	uint64_t replays;	/* replies replayed from a slot */
+	uint64_t uncached;	/* replies not cached, the cache was full */
+};
+
+/* Stats shards
+ *
+ * Every block of counters below (the protocol structs a gsh_stats
+ * points to and the global stats) is an array of shards, one per CPU
+ * up to Stats_Shards.  A request updates the shard of the CPU it runs
+ * on, so workers on different CPUs never write the same cachelines.
+ * The updates stay atomic because a thread may migrate between
+ * choosing a shard and writing to it, but they no longer contend.
+ * DBus readers sum the shards when asked.
+ */
+
+static uint32_t stats_shards = 1;
+static struct global_stats global_st_boot;
+static struct global_stats *global_st = &global_st_boot;
+
+/* Latency histograms
+ *
+ * One histogram per protocol op, request queue and FSAL method, in
+ * every stats shard.  Most ops are never used, so a histogram is only
+ * allocated the first time its shard records into it.
+ */
+
+#define LAT_NFSV3	0
+#define LAT_NFSV4	(LAT_NFSV3 + NFSPROC3_COMMIT + 1)
+#define LAT_NLM		(LAT_NFSV4 + NFS4_OP_LAST_ONE)
+#define LAT_MNT		(LAT_NLM + NLMPROC4_FREE_ALL + 1)
+#define LAT_RQUOTA	(LAT_MNT + MOUNTPROC3_EXPORT + 1)
+#define LAT_9P		(LAT_RQUOTA + RQUOTAPROC_SETACTIVEQUOTA + 1)
+#define LAT_QUEUE	(LAT_9P + 128)	/* 9P message types are < 128 */
+#define LAT_FSAL	(LAT_QUEUE + N_REQ_QUEUES)
+#define LAT_SLOTS	(LAT_FSAL + FSAL_LAT_OPS)
+
+static struct gsh_histogram **lat_histo;	/*< [shard][slot] */
+
+/* Group commit histograms
+ *
+ * Not sharded: each is updated once per commit or per batch, beside
+ * a flush that costs far more than the cacheline.
+ */
+
+static struct gsh_histogram commit_lat;		/*< Commit latencies */
+static struct gsh_histogram commit_size;	/*< Commits per batch */
+static struct gsh_histogram commit_files;	/*< Files per batch */
 struct cache_stats cache_st;
 struct cache_stats *cache_stp = &cache_st;
 
@@ -423,18 +483,66 @@ struct cache_stats *cache_stp = &cache_st;
  */
 #include "server_stats_private.h"
 
+/**
+ * @brief Choose the shard of the calling thread
+ *
+ * @return A shard index.
+ */
+
+static inline uint32_t stats_shard(void)
+{
+	int cpu = sched_getcpu();
+
+	if (likely(cpu >= 0))
+		return cpu % stats_shards;
+	return 0;
+}
+
+/**
+ * @brief Allocate zeroed shards of a stats struct
+ *
+ * @param size [IN] size of one shard, a multiple of the cacheline
+ *
+ * @return the first shard, NULL on OOM
+ */
+
+static void *stats_alloc(size_t size)
+{
+	void *sp = gsh_malloc_aligned(CACHE_LINE_SIZE, size * stats_shards);
+
+	if (sp != NULL)
+		memset(sp, 0, size * stats_shards);
+	return sp;
+}
+
+/**
+ * @brief Allocate a zeroed struct for a single shard
+ *
+ * @param size [IN] size of the struct
+ *
+ * @return the struct, NULL on OOM
+ */
+
+static void *stats_alloc_one(size_t size)
+{
+	void *sp = gsh_malloc_aligned(CACHE_LINE_SIZE, size);
+
+	if (sp != NULL)
+		memset(sp, 0, size);
+	return sp;
+}
+
 /**
  * @brief Get stats struct helpers
  *
  * These functions dereference the protocol specific struct
- * silently calloc the struct on first use.
+ * silently allocating its shards on first use.
  *
  * @param stats [IN] the stats structure to dereference in
  * @param lock  [IN] the lock in the stats owning struct
  *
- * @return pointer to proto struct, NULL on OOM
- *
- * @TODO make them inlines for release
+ * @return pointer to the caller's shard of the proto struct,
+ *         NULL on OOM
  */
 
 static struct nfsv3_stats *get_v3(struct gsh_stats *stats,
@@ -444,10 +552,12 @@ static struct nfsv3_stats *get_v3(struct gsh_stats *stats,
 		PTHREAD_RWLOCK_wrlock(lock);
 		if (stats->nfsv3 == NULL)
 			stats->nfsv3 =
-			    gsh_calloc(sizeof(struct nfsv3_stats), 1);
+			    stats_alloc(sizeof(struct nfsv3_stats));
 		PTHREAD_RWLOCK_unlock(lock);
+		if (stats->nfsv3 == NULL)
+			return NULL;
 	}
-	return stats->nfsv3;
+	return &stats->nfsv3[stats_shard()];
 }
 
 static struct mnt_stats *get_mnt(struct gsh_stats *stats,
@@ -456,10 +566,13 @@ static struct mnt_stats *get_mnt(struct gsh_stats *stats,
 	if (unlikely(stats->mnt == NULL)) {
 		PTHREAD_RWLOCK_wrlock(lock);
 		if (stats->mnt == NULL)
-			stats->mnt = gsh_calloc(sizeof(struct mnt_stats), 1);
+			stats->mnt =
+			    stats_alloc(sizeof(struct mnt_stats));
 		PTHREAD_RWLOCK_unlock(lock);
+		if (stats->mnt == NULL)
+			return NULL;
 	}
-	return stats->mnt;
+	return &stats->mnt[stats_shard()];
 }
 
 static struct nlmv4_stats *get_nlm4(struct gsh_stats *stats,
@@ -468,10 +581,13 @@ static struct nlmv4_stats *get_nlm4(struct gsh_stats *stats,
 	if (unlikely(stats->nlm4 == NULL)) {
 		PTHREAD_RWLOCK_wrlock(lock);
 		if (stats->nlm4 == NULL)
-			stats->nlm4 = gsh_calloc(sizeof(struct nlmv4_stats), 1);
+			stats->nlm4 =
+			    stats_alloc(sizeof(struct nlmv4_stats));
 		PTHREAD_RWLOCK_unlock(lock);
+		if (stats->nlm4 == NULL)
+			return NULL;
 	}
-	return stats->nlm4;
+	return &stats->nlm4[stats_shard()];
 }
 
 static struct rquota_stats *get_rquota(struct gsh_stats *stats,
@@ -481,10 +597,12 @@ static struct rquota_stats *get_rquota(struct gsh_stats *stats,
 		PTHREAD_RWLOCK_wrlock(lock);
 		if (stats->rquota == NULL)
 			stats->rquota =
-			    gsh_calloc(sizeof(struct rquota_stats), 1);
+			    stats_alloc(sizeof(struct rquota_stats));
 		PTHREAD_RWLOCK_unlock(lock);
+		if (stats->rquota == NULL)
+			return NULL;
 	}
-	return stats->rquota;
+	return &stats->rquota[stats_shard()];
 }
 
 static struct nfsv40_stats *get_v40(struct gsh_stats *stats,
@@ -494,10 +612,12 @@ static struct nfsv40_stats *get_v40(struct gsh_stats *stats,
 		PTHREAD_RWLOCK_wrlock(lock);
 		if (stats->nfsv40 == NULL)
 			stats->nfsv40 =
-			    gsh_calloc(sizeof(struct nfsv40_stats), 1);
+			    stats_alloc(sizeof(struct nfsv40_stats));
 		PTHREAD_RWLOCK_unlock(lock);
+		if (stats->nfsv40 == NULL)
+			return NULL;
 	}
-	return stats->nfsv40;
+	return &stats->nfsv40[stats_shard()];
 }
 
 static struct nfsv41_stats *get_v41(struct gsh_stats *stats,
@@ -507,10 +627,12 @@ static struct nfsv41_stats *get_v41(struct gsh_stats *stats,
 		PTHREAD_RWLOCK_wrlock(lock);
 		if (stats->nfsv41 == NULL)
 			stats->nfsv41 =
-			    gsh_calloc(sizeof(struct nfsv41_stats), 1);
+			    stats_alloc(sizeof(struct nfsv41_stats));
 		PTHREAD_RWLOCK_unlock(lock);
+		if (stats->nfsv41 == NULL)
+			return NULL;
 	}
-	return stats->nfsv41;
+	return &stats->nfsv41[stats_shard()];
 }
 
 static struct nfsv41_stats *get_v42(struct gsh_stats *stats,
@@ -520,10 +642,12 @@ static struct nfsv41_stats *get_v42(struct gsh_stats *stats,
 		PTHREAD_RWLOCK_wrlock(lock);
 		if (stats->nfsv42 == NULL)
 			stats->nfsv42 =
-			    gsh_calloc(sizeof(struct nfsv41_stats), 1);
+			    stats_alloc(sizeof(struct nfsv41_stats));
 		PTHREAD_RWLOCK_unlock(lock);
+		if (stats->nfsv42 == NULL)
+			return NULL;
 	}
-	return stats->nfsv42;
+	return &stats->nfsv42[stats_shard()];
 }
 
 #ifdef _USE_9P
@@ -532,10 +656,13 @@ static struct _9p_stats *get_9p(struct gsh_stats *stats, pthread_rwlock_t *lock)
 	if (unlikely(stats->_9p == NULL)) {
 		PTHREAD_RWLOCK_wrlock(lock);
 		if (stats->_9p == NULL)
-			stats->_9p = gsh_calloc(sizeof(struct _9p_stats), 1);
+			stats->_9p =
+			    stats_alloc(sizeof(struct _9p_stats));
 		PTHREAD_RWLOCK_unlock(lock);
+		if (stats->_9p == NULL)
+			return NULL;
 	}
-	return stats->_9p;
+	return &stats->_9p[stats_shard()];
 }
 #endif
 
@@ -860,6 +987,7 @@ static void record_stats(struct gsh_stats *gsh_st, pthread_rwlock_t *lock,
 {
 	struct svc_req *req = &reqdata->r_u.nfs->req;
 	uint32_t proto_op = req->rq_proc;
+	struct global_stats *gs = &global_st[stats_shard()];
 
 	if (req->rq_prog == nfs_param.core_param.program[P_NFS]) {
 		if (proto_op == 0)
@@ -871,7 +999,7 @@ static void record_stats(struct gsh_stats *gsh_st, pthread_rwlock_t *lock,
 				return;
 			/* record stuff */
 			if (global)
-				record_op(&global_st.nfsv3.cmds, request_time,
+				record_op(&gs->nfsv3.cmds, request_time,
 					  qwait_time, success, dup);
 			switch (nfsv3_optype[proto_op]) {
 			case READ_OP:
@@ -894,10 +1022,10 @@ static void record_stats(struct gsh_stats *gsh_st, pthread_rwlock_t *lock,
 		struct mnt_stats *sp = get_mnt(gsh_st, lock);
 
 		if (global && req->rq_vers == MOUNT_V1)
-			record_op(&global_st.mnt.v1_ops, request_time,
+			record_op(&gs->mnt.v1_ops, request_time,
 				  qwait_time, success, dup);
 		else if (global)
-			record_op(&global_st.mnt.v3_ops, request_time,
+			record_op(&gs->mnt.v3_ops, request_time,
 				  qwait_time, success, dup);
 
 		if (sp == NULL)
@@ -913,7 +1041,7 @@ static void record_stats(struct gsh_stats *gsh_st, pthread_rwlock_t *lock,
 		struct nlmv4_stats *sp = get_nlm4(gsh_st, lock);
 
 		if (global)
-			record_op(&global_st.nlm4.ops, request_time,
+			record_op(&gs->nlm4.ops, request_time,
 				  qwait_time, success, dup);
 		if (sp == NULL)
 			return;
@@ -923,7 +1051,7 @@ static void record_stats(struct gsh_stats *gsh_st, pthread_rwlock_t *lock,
 		struct rquota_stats *sp = get_rquota(gsh_st, lock);
 
 		if (global)
-			record_op(&global_st.rquota.ops, request_time,
+			record_op(&gs->rquota.ops, request_time,
 				  qwait_time, success, dup);
 		if (sp == NULL)
 			return;
@@ -982,6 +1110,159 @@ void server_stats_transport_done(struct gsh_client *client,
 }
 #endif
 
+/**
+ * @brief Count a latency into the caller's shard of a histogram
+ *
+ * @param slot  [IN] which histogram
+ * @param nsecs [IN] the latency
+ */
+
+static void record_histo(uint32_t slot, nsecs_elapsed_t nsecs)
+{
+	struct gsh_histogram **hp, *h, *expected = NULL;
+
+	if (unlikely(lat_histo == NULL))
+		return;
+
+	hp = &lat_histo[stats_shard() * LAT_SLOTS + slot];
+	h = atomic_fetch_voidptr((void **)hp);
+	if (unlikely(h == NULL)) {
+		h = stats_alloc_one(sizeof(*h));
+		if (h == NULL)
+			return;
+		if (!atomic_cas_voidptr((void **)hp, (void **)&expected, h)) {
+			/* Someone else on this shard beat us to it */
+			gsh_free(h);
+			h = expected;
+		}
+	}
+	gsh_histo_record(h, nsecs);
+}
+
+/**
+ * @brief Start timing something for a latency histogram
+ *
+ * @return the time since boot, or 0 if we are not keeping full stats
+ */
+
+nsecs_elapsed_t server_stats_clock(void)
+{
+	struct timespec ts;
+
+	if (nfs_param.core_param.enable_FASTSTATS)
+		return 0;
+
+	now(&ts);
+	return timespec_diff(&ServerBootTime, &ts);
+}
+
+/**
+ * @brief Record the latency of an FSAL method call
+ *
+ * @param op         [IN] the method
+ * @param start_time [IN] from server_stats_clock before the call
+ */
+
+void server_stats_fsal_done(enum fsal_lat_op op, nsecs_elapsed_t start_time)
+{
+	if (start_time == 0)
+		return;
+	record_histo(LAT_FSAL + op, server_stats_clock() - start_time);
+}
+
+/**
+ * @brief Record the latency of a 9P request
+ *
+ * Called from _9p_process_buffer once the request is served.
+ *
+ * @param msgtype    [IN] the 9P message type
+ * @param start_time [IN] from server_stats_clock before the request
+ */
+
+void server_stats_9p_done(uint8_t msgtype, nsecs_elapsed_t start_time)
+{
+	if (start_time == 0 || msgtype >= LAT_QUEUE - LAT_9P)
+		return;
+	record_histo(LAT_9P + msgtype, server_stats_clock() - start_time);
+}
+
+/**
+ * @brief Record how long a request waited in its queue
+ *
+ * @param lane       [IN] the request queue
+ * @param queue_wait [IN] time from enqueue to dequeue
+ */
+
+void server_stats_queue_done(uint32_t lane, nsecs_elapsed_t queue_wait)
+{
+	if (nfs_param.core_param.enable_FASTSTATS || lane >= N_REQ_QUEUES)
+		return;
+	record_histo(LAT_QUEUE + lane, queue_wait);
+}
+
+/**
+ * @brief Record the latency of a group commit
+ *
+ * From the commit joining its batch to its file being flushed.
+ *
+ * @param start_time [IN] from server_stats_clock before joining
+ */
+
+void server_stats_commit_done(nsecs_elapsed_t start_time)
+{
+	if (start_time == 0)
+		return;
+	gsh_histo_record(&commit_lat, server_stats_clock() - start_time);
+}
+
+/**
+ * @brief Record the size of a group commit batch
+ *
+ * Sizes are counted as if they were latencies in histogram units, so
+ * batches smaller than GSH_HISTO_SUB get a bucket for each size.
+ *
+ * @param commits [IN] commits in the batch
+ * @param files   [IN] files flushed for them
+ */
+
+void server_stats_commit_batch(uint32_t commits, uint32_t files)
+{
+	if (nfs_param.core_param.enable_FASTSTATS)
+		return;
+	gsh_histo_record(&commit_size,
+			 (uint64_t) commits << GSH_HISTO_UNIT_SHIFT);
+	gsh_histo_record(&commit_files,
+			 (uint64_t) files << GSH_HISTO_UNIT_SHIFT);
+}
+
+/**
+ * @brief Find the histogram of a (non NFSv4) request
+ *
+ * @param req [IN] the request
+ *
+ * @return the histogram slot, LAT_SLOTS if there is none
+ */
+
+static uint32_t lat_slot(struct svc_req *req)
+{
+	uint32_t proto_op = req->rq_proc;
+
+	if (req->rq_prog == nfs_param.core_param.program[P_NFS]) {
+		if (req->rq_vers == NFS_V3 && proto_op <= NFSPROC3_COMMIT)
+			return LAT_NFSV3 + proto_op;
+	} else if (req->rq_prog == nfs_param.core_param.program[P_NLM]) {
+		if (proto_op <= NLMPROC4_FREE_ALL)
+			return LAT_NLM + proto_op;
+	} else if (req->rq_prog == nfs_param.core_param.program[P_MNT]) {
+		if (proto_op <= MOUNTPROC3_EXPORT)
+			return LAT_MNT + proto_op;
+	} else if (req->rq_prog == nfs_param.core_param.program[P_RQUOTA]) {
+		if (proto_op <= RQUOTAPROC_SETACTIVEQUOTA)
+			return LAT_RQUOTA + proto_op;
+	}
+	return LAT_SLOTS;
+}
+
 /**
  * @brief record NFS op finished
  *
@@ -995,21 +1276,28 @@ void server_stats_nfs_done(request_data_t *reqdata, int rc, bool dup)
 	nsecs_elapsed_t stop_time;
 	struct svc_req *req = &reqdata->r_u.nfs->req;
 	uint32_t proto_op = req->rq_proc;
+	struct global_stats *gs = &global_st[stats_shard()];
 
 	if (req->rq_prog == NFS_PROGRAM && op_ctx->nfs_vers == NFS_V3)
-			global_st.v3.op[proto_op]++;
+			gs->v3.op[proto_op]++;
 	else if (req->rq_prog == nfs_param.core_param.program[P_NLM])
-		global_st.lm.op[proto_op]++;
+		gs->lm.op[proto_op]++;
 	else if (req->rq_prog == nfs_param.core_param.program[P_MNT])
-		global_st.mn.op[proto_op]++;
+		gs->mn.op[proto_op]++;
 	else if (req->rq_prog == nfs_param.core_param.program[P_RQUOTA])
-		global_st.qt.op[proto_op]++;
+		gs->qt.op[proto_op]++;
 
 	if (nfs_param.core_param.enable_FASTSTATS)
 		return;
 
 	now(&current_time);
 	stop_time = timespec_diff(&ServerBootTime, &current_time);
+	if (!dup) {
+		uint32_t slot = lat_slot(req);
+
+		if (slot < LAT_SLOTS)
+			record_histo(slot, stop_time - op_ctx->start_time);
+	}
 	if (client != NULL) {
 		struct server_stats *server_st;
 		server_st = container_of(client, struct server_stats, client);
@@ -1045,9 +1333,10 @@ void server_stats_nfsv4_op_done(int proto_op,
 	struct gsh_client *client = op_ctx->client;
 	struct timespec current_time;
 	nsecs_elapsed_t stop_time;
+	struct global_stats *gs = &global_st[stats_shard()];
 
 	if (op_ctx->nfs_vers == NFS_V4)
-		global_st.v4.op[proto_op]++;
+		gs->v4.op[proto_op]++;
 
 	if (nfs_param.core_param.enable_FASTSTATS)
 		return;
@@ -1055,6 +1344,9 @@ void server_stats_nfsv4_op_done(int proto_op,
 	now(&current_time);
 	stop_time = timespec_diff(&ServerBootTime, &current_time);
 
+	if (proto_op < NFS4_OP_LAST_ONE)
+		record_histo(LAT_NFSV4 + proto_op, stop_time - start_time);
+
 	if (client != NULL) {
 		struct server_stats *server_st;
 		server_st = container_of(client, struct server_stats, client);
@@ -1065,13 +1357,13 @@ void server_stats_nfsv4_op_done(int proto_op,
 	}
 
 	if (op_ctx->nfs_minorvers == 0)
-		record_op(&global_st.nfsv40.compounds, stop_time - start_time,
+		record_op(&gs->nfsv40.compounds, stop_time - start_time,
 			  op_ctx->queue_wait, status == NFS4_OK, false);
 	else if (op_ctx->nfs_minorvers == 1)
-		record_op(&global_st.nfsv41.compounds, stop_time - start_time,
+		record_op(&gs->nfsv41.compounds, stop_time - start_time,
 			  op_ctx->queue_wait, status == NFS4_OK, false);
 	else if (op_ctx->nfs_minorvers == 2)
-		record_op(&global_st.nfsv42.compounds, stop_time - start_time,
+		record_op(&gs->nfsv42.compounds, stop_time - start_time,
 			  op_ctx->queue_wait, status == NFS4_OK, false);
 
 	if (op_ctx->export != NULL) {
@@ -1217,11 +1509,255 @@ void inc_failed_recalls(struct gsh_client *client)
 	}
 }
 
+/**
+ * @brief Allocate a client's session slot stats on first use
+ */
+static struct slot_stats *get_slot_stats(struct gsh_client *client)
+{
+	struct server_stats *server_st;
+
+	server_st = container_of(client, struct server_stats, client);
+
+	if (unlikely(server_st->st.slots == NULL)) {
+		PTHREAD_RWLOCK_wrlock(&client->lock);
+		if (server_st->st.slots == NULL)
+			server_st->st.slots = gsh_calloc(
+					sizeof(struct slot_stats), 1);
+		PTHREAD_RWLOCK_unlock(&client->lock);
+	}
+
+	return server_st->st.slots;
+}
+
+/**
+ * @brief Record the slot table size of a new session
+ *
+ * @param[in] client   The client creating the session
+ * @param[in] nb_slots Forechannel slots it was given
+ */
+
+void server_stats_session_slots(struct gsh_client *client, uint32_t nb_slots)
+{
+	struct slot_stats *ss;
+
+	if (client == NULL)
+		return;
+
+	ss = get_slot_stats(client);
+	if (ss != NULL)
+		atomic_store_uint32_t(&ss->slots, nb_slots);
+}
+
+/**
+ * @brief Record a request starting on a session slot
+ *
+ * @param[in] client The client
+ * @param[in] target The sr_target_highest_slotid sent back
+ */
+
+void server_stats_slot_start(struct gsh_client *client, uint32_t target)
+{
+	struct slot_stats *ss;
+	uint32_t busy;
+
+	if (client == NULL)
+		return;
+
+	ss = get_slot_stats(client);
+	if (ss == NULL)
+		return;
+
+	atomic_store_uint32_t(&ss->target, target);
+	atomic_inc_uint64_t(&ss->requests);
+	busy = atomic_inc_uint32_t(&ss->busy);
+
+	/* A lost race only loses a high water mark */
+	if (busy > atomic_fetch_uint32_t(&ss->max_busy))
+		atomic_store_uint32_t(&ss->max_busy, busy);
+}
+
+/**
+ * @brief Record a request on a session slot completing
+ *
+ * @param[in] client The client
+ * @param[in] cached Whether the reply was kept for replay
+ */
+
+void server_stats_slot_done(struct gsh_client *client, bool cached)
+{
+	struct slot_stats *ss;
+
+	if (client == NULL)
+		return;
+
+	ss = get_slot_stats(client);
+	if (ss == NULL)
+		return;
+
+	atomic_dec_uint32_t(&ss->busy);
+	if (!cached)
+		atomic_inc_uint64_t(&ss->uncached);
+}
+
+/**
+ * @brief Record a reply replayed from a session slot
+ *
+ * @param[in] client The client
+ */
+
+void server_stats_slot_replay(struct gsh_client *client)
+{
+	struct slot_stats *ss;
+
+	if (client == NULL)
+		return;
+
+	ss = get_slot_stats(client);
+	if (ss != NULL)
+		atomic_inc_uint64_t(&ss->replays);
+}
+
 #ifdef USE_DBUS
 
 /* Functions for marshalling statistics to DBUS
  */
 
+/**
+ * @brief Sum stats shards helpers
+ *
+ * DBus replies are built from the sum of every shard of a stats
+ * struct.  Writers keep going while we read, so the sum is only as
+ * consistent as the atomic reads of each counter, which is what the
+ * unsharded counters gave us too.
+ */
+
+static void sum_latency(struct op_latency *sum, struct op_latency *lp)
+{
+	uint64_t min = atomic_fetch_uint64_t(&lp->min);
+	uint64_t max = atomic_fetch_uint64_t(&lp->max);
+
+	sum->latency += atomic_fetch_uint64_t(&lp->latency);
+	if (min != 0 && (sum->min == 0 || sum->min > min))
+		sum->min = min;
+	if (sum->max < max)
+		sum->max = max;
+}
+
+static void sum_proto_op(struct proto_op *sum, struct proto_op *op)
+{
+	sum->total += atomic_fetch_uint64_t(&op->total);
+	sum->errors += atomic_fetch_uint64_t(&op->errors);
+	sum->dups += atomic_fetch_uint64_t(&op->dups);
+	sum_latency(&sum->latency, &op->latency);
+	sum_latency(&sum->dup_latency, &op->dup_latency);
+	sum_latency(&sum->queue_latency, &op->queue_latency);
+}
+
+static void sum_xfer_op(struct xfer_op *sum, struct xfer_op *iop)
+{
+	sum_proto_op(&sum->cmd, &iop->cmd);
+	sum->requested += atomic_fetch_uint64_t(&iop->requested);
+	sum->transferred += atomic_fetch_uint64_t(&iop->transferred);
+}
+
+static void sum_layout_op(struct layout_op *sum, struct layout_op *lp)
+{
+	sum->total += atomic_fetch_uint64_t(&lp->total);
+	sum->errors += atomic_fetch_uint64_t(&lp->errors);
+	sum->delays += atomic_fetch_uint64_t(&lp->delays);
+}
+
+static void sum_ops(uint64_t *sum, uint64_t *op, int nops)
+{
+	int i;
+
+	for (i = 0; i < nops; i++)
+		sum[i] += atomic_fetch_uint64_t(&op[i]);
+}
+
+static void sum_v3(struct nfsv3_stats *sum, struct nfsv3_stats *sp)
+{
+	sum_proto_op(&sum->cmds, &sp->cmds);
+	sum_xfer_op(&sum->read, &sp->read);
+	sum_xfer_op(&sum->write, &sp->write);
+}
+
+static void sum_mnt(struct mnt_stats *sum, struct mnt_stats *sp)
+{
+	sum_proto_op(&sum->v1_ops, &sp->v1_ops);
+	sum_proto_op(&sum->v3_ops, &sp->v3_ops);
+}
+
+static void sum_v40(struct nfsv40_stats *sum, struct nfsv40_stats *sp)
+{
+	sum_proto_op(&sum->compounds, &sp->compounds);
+	sum->ops_per_compound += atomic_fetch_uint64_t(&sp->ops_per_compound);
+	sum_xfer_op(&sum->read, &sp->read);
+	sum_xfer_op(&sum->write, &sp->write);
+}
+
+static void sum_v41(struct nfsv41_stats *sum, struct nfsv41_stats *sp)
+{
+	sum_proto_op(&sum->compounds, &sp->compounds);
+	sum->ops_per_compound += atomic_fetch_uint64_t(&sp->ops_per_compound);
+	sum_xfer_op(&sum->read, &sp->read);
+	sum_xfer_op(&sum->write, &sp->write);
+	sum_layout_op(&sum->getdevinfo, &sp->getdevinfo);
+	sum_layout_op(&sum->layout_get, &sp->layout_get);
+	sum_layout_op(&sum->layout_commit, &sp->layout_commit);
+	sum_layout_op(&sum->layout_return, &sp->layout_return);
+	sum_layout_op(&sum->recall, &sp->recall);
+}
+
+static void sum_9p(struct _9p_stats *sum, struct _9p_stats *sp)
+{
+	sum_proto_op(&sum->cmds, &sp->cmds);
+	sum_xfer_op(&sum->read, &sp->read);
+	sum_xfer_op(&sum->write, &sp->write);
+	sum->trans.rx_bytes += atomic_fetch_uint64_t(&sp->trans.rx_bytes);
+	sum->trans.rx_pkt += atomic_fetch_uint64_t(&sp->trans.rx_pkt);
+	sum->trans.rx_err += atomic_fetch_uint64_t(&sp->trans.rx_err);
+	sum->trans.tx_bytes += atomic_fetch_uint64_t(&sp->trans.tx_bytes);
+	sum->trans.tx_pkt += atomic_fetch_uint64_t(&sp->trans.tx_pkt);
+	sum->trans.tx_err += atomic_fetch_uint64_t(&sp->trans.tx_err);
+}
+
+static void sum_global(struct global_stats *sum)
+{
+	struct global_stats *gs;
+	uint32_t i;
+
+	memset(sum, 0, sizeof(*sum));
+	for (i = 0; i < stats_shards; i++) {
+		gs = &global_st[i];
+		sum_v3(&sum->nfsv3, &gs->nfsv3);
+		sum_mnt(&sum->mnt, &gs->mnt);
+		sum_proto_op(&sum->nlm4.ops, &gs->nlm4.ops);
+		sum_proto_op(&sum->rquota.ops, &gs->rquota.ops);
+		sum_proto_op(&sum->rquota.ext_ops, &gs->rquota.ext_ops);
+		sum_v40(&sum->nfsv40, &gs->nfsv40);
+		sum_v41(&sum->nfsv41, &gs->nfsv41);
+		sum_v41(&sum->nfsv42, &gs->nfsv42);
+		sum_ops(sum->v3.op, gs->v3.op, NFSPROC3_COMMIT + 1);
+		sum_ops(sum->v4.op, gs->v4.op, NFS4_OP_LAST_ONE);
+		sum_ops(sum->lm.op, gs->lm.op, NLMPROC4_FREE_ALL + 1);
+		sum_ops(sum->mn.op, gs->mn.op, MOUNTPROC3_EXPORT + 1);
+		sum_ops(sum->qt.op, gs->qt.op, RQUOTAPROC_SETACTIVEQUOTA + 1);
+	}
+}
+
+/* Sum the shards of a protocol struct into a struct on our stack,
+ * so the reply functions below can report it like a single block.
+ */
+#define SUM_SHARDS(sum, shards, sum_fn)				\
+	do {							\
+		uint32_t _i;					\
+								\
+		memset((sum), 0, sizeof(*(sum)));		\
+		for (_i = 0; _i < stats_shards; _i++)		\
+			sum_fn((sum), &(shards)[_i]);		\
+	} while (0)
+
 /**
  * @brief Report Stats availability as members of a struct
  *
@@ -1336,6 +1872,9 @@ static void server_dbus_transportstats(struct transport_stats *tstats,
 void server_dbus_total(struct export_stats *export_st, DBusMessageIter *iter)
 {
 	DBusMessageIter struct_iter;
+	struct nfsv3_stats v3;
+	struct nfsv40_stats v40;
+	struct nfsv41_stats v41;
 	uint64_t total = 0;
 	char *version;
 
@@ -1348,44 +1887,54 @@ void server_dbus_total(struct export_stats *export_st, DBusMessageIter *iter)
 	if (export_st->st.nfsv3 == NULL)
 		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
 				&total);
-	else
+	else {
+		SUM_SHARDS(&v3, export_st->st.nfsv3, sum_v3);
 		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-				&export_st->st.nfsv3->cmds.total);
+				&v3.cmds.total);
+	}
 	version = "NFSv40";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	if (export_st->st.nfsv40 == NULL)
 		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
 				&total);
-	else
+	else {
+		SUM_SHARDS(&v40, export_st->st.nfsv40, sum_v40);
 		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-				&export_st->st.nfsv40->compounds.total);
+				&v40.compounds.total);
+	}
 	version = "NFSv41";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	if (export_st->st.nfsv41 == NULL)
 		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
 				&total);
-	else
+	else {
+		SUM_SHARDS(&v41, export_st->st.nfsv41, sum_v41);
 		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-				&export_st->st.nfsv41->compounds.total);
+				&v41.compounds.total);
+	}
 	version = "NFSv42";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	if (export_st->st.nfsv42 == NULL)
 		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
 				&total);
-	else
+	else {
+		SUM_SHARDS(&v41, export_st->st.nfsv42, sum_v41);
 		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-				&export_st->st.nfsv42->compounds.total);
+				&v41.compounds.total);
+	}
 	dbus_message_iter_close_container(iter, &struct_iter);
 }
 
 void global_dbus_total(DBusMessageIter *iter)
 {
 	DBusMessageIter struct_iter;
+	struct global_stats sum;
 	char *version;
 
+	sum_global(&sum);
 	dbus_message_iter_open_container(iter, DBUS_TYPE_STRUCT, NULL,
 					 &struct_iter);
 
@@ -1393,52 +1942,54 @@ void global_dbus_total(DBusMessageIter *iter)
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-					&global_st.nfsv3.cmds.total);
+					&sum.nfsv3.cmds.total);
 	version = "NFSv40";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-					&global_st.nfsv40.compounds.total);
+					&sum.nfsv40.compounds.total);
 	version = "NFSv41";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-					&global_st.nfsv41.compounds.total);
+					&sum.nfsv41.compounds.total);
 	version = "NFSv42";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-					&global_st.nfsv42.compounds.total);
+					&sum.nfsv42.compounds.total);
 	version = "NLM4";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-					&global_st.nlm4.ops.total);
+					&sum.nlm4.ops.total);
 	version = "MNTv1";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-					&global_st.mnt.v1_ops.total);
+					&sum.mnt.v1_ops.total);
 	version = "MNTv3";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-					&global_st.mnt.v3_ops.total);
+					&sum.mnt.v3_ops.total);
 	version = "RQUOTA";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
-					&global_st.rquota.ops.total);
+					&sum.rquota.ops.total);
 	dbus_message_iter_close_container(iter, &struct_iter);
 }
 
 void global_dbus_fast(DBusMessageIter *iter)
 {
 	DBusMessageIter struct_iter;
+	struct global_stats sum;
 	char *version;
 	char *op;
 	int i;
 
+	sum_global(&sum);
 	dbus_message_iter_open_container(iter, DBUS_TYPE_STRUCT, NULL,
 					 &struct_iter);
 
@@ -1446,60 +1997,60 @@ void global_dbus_fast(DBusMessageIter *iter)
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	for (i = 0; i < NFSPROC3_COMMIT; i++) {
-		if (global_st.v3.op[i] > 0) {
+		if (sum.v3.op[i] > 0) {
 			op = optabv3[i].name;
 			dbus_message_iter_append_basic(&struct_iter,
 					DBUS_TYPE_STRING, &op);
 			dbus_message_iter_append_basic(&struct_iter,
-					DBUS_TYPE_UINT64, &global_st.v3.op[i]);
+					DBUS_TYPE_UINT64, &sum.v3.op[i]);
 		}
 	}
 	version = "\nNFSv4:";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	for (i = 0; i < NFS4_OP_LAST_ONE; i++) {
-		if (global_st.v4.op[i] > 0) {
+		if (sum.v4.op[i] > 0) {
 			op = optabv4[i].name;
 			dbus_message_iter_append_basic(&struct_iter,
 					DBUS_TYPE_STRING, &op);
 			dbus_message_iter_append_basic(&struct_iter,
-					DBUS_TYPE_UINT64, &global_st.v4.op[i]);
+					DBUS_TYPE_UINT64, &sum.v4.op[i]);
 		}
 	}
 	version = "\nNLM:";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	for (i = 0; i < NLM4_FAILED; i++) {
-		if (global_st.lm.op[i] > 0) {
+		if (sum.lm.op[i] > 0) {
 			op = optnlm[i].name;
 			dbus_message_iter_append_basic(&struct_iter,
 					DBUS_TYPE_STRING, &op);
 			dbus_message_iter_append_basic(&struct_iter,
-					DBUS_TYPE_UINT64, &global_st.lm.op[i]);
+					DBUS_TYPE_UINT64, &sum.lm.op[i]);
 		}
 	}
 	version = "\nMNT:";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	for (i = 0; i < MOUNTPROC3_EXPORT; i++) {
-		if (global_st.mn.op[i] > 0) {
+		if (sum.mn.op[i] > 0) {
 			op = optmnt[i].name;
 			dbus_message_iter_append_basic(&struct_iter,
 					DBUS_TYPE_STRING, &op);
 			dbus_message_iter_append_basic(&struct_iter,
-					DBUS_TYPE_UINT64, &global_st.mn.op[i]);
+					DBUS_TYPE_UINT64, &sum.mn.op[i]);
 		}
 	}
 	version = "\nQUOTA:";
 	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
 				       &version);
 	for (i = 0; i < RQUOTAPROC_SETACTIVEQUOTA; i++) {
-		if (global_st.qt.op[i] > 0) {
+		if (sum.qt.op[i] > 0) {
 			op = optqta[i].name;
 			dbus_message_iter_append_basic(&struct_iter,
 					DBUS_TYPE_STRING, &op);
 			dbus_message_iter_append_basic(&struct_iter,
-					DBUS_TYPE_UINT64, &global_st.qt.op[i]);
+					DBUS_TYPE_UINT64, &sum.qt.op[i]);
 		}
 	}
 	dbus_message_iter_close_container(iter, &struct_iter);
@@ -1508,41 +2059,49 @@ void global_dbus_fast(DBusMessageIter *iter)
 void server_dbus_v3_iostats(struct nfsv3_stats *v3p, DBusMessageIter *iter)
 {
 	struct timespec timestamp;
+	struct nfsv3_stats sum;
 
+	SUM_SHARDS(&sum, v3p, sum_v3);
 	now(&timestamp);
 	dbus_append_timestamp(iter, &timestamp);
-	server_dbus_iostats(&v3p->read, iter);
-	server_dbus_iostats(&v3p->write, iter);
+	server_dbus_iostats(&sum.read, iter);
+	server_dbus_iostats(&sum.write, iter);
 }
 
 void server_dbus_v40_iostats(struct nfsv40_stats *v40p, DBusMessageIter *iter)
 {
 	struct timespec timestamp;
+	struct nfsv40_stats sum;
 
+	SUM_SHARDS(&sum, v40p, sum_v40);
 	now(&timestamp);
 	dbus_append_timestamp(iter, &timestamp);
-	server_dbus_iostats(&v40p->read, iter);
-	server_dbus_iostats(&v40p->write, iter);
+	server_dbus_iostats(&sum.read, iter);
+	server_dbus_iostats(&sum.write, iter);
 }
 
 void server_dbus_v41_iostats(struct nfsv41_stats *v41p, DBusMessageIter *iter)
 {
 	struct timespec timestamp;
+	struct nfsv41_stats sum;
 
+	SUM_SHARDS(&sum, v41p, sum_v41);
 	now(&timestamp);
 	dbus_append_timestamp(iter, &timestamp);
-	server_dbus_iostats(&v41p->read, iter);
-	server_dbus_iostats(&v41p->write, iter);
+	server_dbus_iostats(&sum.read, iter);
+	server_dbus_iostats(&sum.write, iter);
 }
 
 void server_dbus_v42_iostats(struct nfsv41_stats *v42p, DBusMessageIter *iter)
 {
 	struct timespec timestamp;
+	struct nfsv41_stats sum;
 
+	SUM_SHARDS(&sum, v42p, sum_v41);
 	now(&timestamp);
 	dbus_append_timestamp(iter, &timestamp);
-	server_dbus_iostats(&v42p->read, iter);
-	server_dbus_iostats(&v42p->write, iter);
+	server_dbus_iostats(&sum.read, iter);
+	server_dbus_iostats(&sum.write, iter);
 }
 
 void server_dbus_fill_io(DBusMessageIter *array_iter, uint16_t *export_id,
@@ -1586,36 +2145,36 @@ void server_dbus_fill_io(DBusMessageIter *array_iter, uint16_t *export_id,
 void server_dbus_all_iostats(struct export_stats *export_statistics,
 			     DBusMessageIter *array_iter)
 {
+	struct nfsv3_stats v3;
+	struct nfsv40_stats v40;
+	struct nfsv41_stats v41;
+
 	if (export_statistics->st.nfsv3 != NULL) {
+		SUM_SHARDS(&v3, export_statistics->st.nfsv3, sum_v3);
 		server_dbus_fill_io(array_iter,
 				    &(export_statistics->export.export_id),
-				    "NFSv3",
-				    &(export_statistics->st.nfsv3->read),
-				    &(export_statistics->st.nfsv3->write));
+				    "NFSv3", &v3.read, &v3.write);
 	}
 
 	if (export_statistics->st.nfsv40 != NULL) {
+		SUM_SHARDS(&v40, export_statistics->st.nfsv40, sum_v40);
 		server_dbus_fill_io(array_iter,
 				    &(export_statistics->export.export_id),
-				    "NFSv40",
-				    &(export_statistics->st.nfsv40->read),
-				    &(export_statistics->st.nfsv40->write));
+				    "NFSv40", &v40.read, &v40.write);
 	}
 
 	if (export_statistics->st.nfsv41 != NULL) {
+		SUM_SHARDS(&v41, export_statistics->st.nfsv41, sum_v41);
 		server_dbus_fill_io(array_iter,
 				    &(export_statistics->export.export_id),
-				    "NFSv41",
-				    &(export_statistics->st.nfsv41->read),
-				    &(export_statistics->st.nfsv41->write));
+				    "NFSv41", &v41.read, &v41.write);
 	}
 
 	if (export_statistics->st.nfsv42 != NULL) {
+		SUM_SHARDS(&v41, export_statistics->st.nfsv42, sum_v41);
 		server_dbus_fill_io(array_iter,
 				    &(export_statistics->export.export_id),
-				    "NFSv42",
-				    &(export_statistics->st.nfsv42->read),
-				    &(export_statistics->st.nfsv42->write));
+				    "NFSv42", &v41.read, &v41.write);
 	}
 }
 
@@ -1686,23 +2245,383 @@ void cache_inode_dbus_show(DBusMessageIter *iter)
 	dbus_message_iter_close_container(iter, &struct_iter);
 }
 
+/**
+ * @brief Report request queue depths and work stealing counters
+ *
+ * @param iter [IN] iterator to stuff struct into
+ */
+
+void req_queue_dbus_show(DBusMessageIter *iter)
+{
+	struct timespec timestamp;
+	struct nfs_req_q_stats stats;
+	DBusMessageIter struct_iter;
+	uint64_t shards;
+	char names[N_REQ_QUEUES][3][32];
+	char *type;
+	int lane;
+
+	now(&timestamp);
+	dbus_append_timestamp(iter, &timestamp);
+
+	nfs_rpc_queue_stats(&stats);
+	shards = stats.shards;
+
+	dbus_message_iter_open_container(iter, DBUS_TYPE_STRUCT, NULL,
+					 &struct_iter);
+	type = "shards";
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &type);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+					&shards);
+	for (lane = 0; lane < N_REQ_QUEUES; ++lane) {
+		type = (char *)req_q_s[lane];
+		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
+					       &type);
+		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+					       &stats.depth[lane]);
+	}
+	type = "overflow_depth";
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &type);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+					&stats.overflow_depth);
+	type = "enqueued";
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &type);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+					&stats.enqueued);
+	type = "dequeued";
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &type);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+					&stats.dequeued);
+	type = "stolen";
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &type);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+					&stats.stolen);
+	type = "overflowed";
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &type);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+					&stats.overflowed);
+	type = "demoted";
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &type);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+					&stats.demoted);
+
+	/* per class service, averages in nsecs */
+	for (lane = 0; lane < N_REQ_QUEUES; ++lane) {
+		struct req_q_lane_stats *ls = &stats.lane[lane];
+		uint64_t avg_wait = 0, avg_service = 0;
+
+		if (ls->served != 0) {
+			avg_wait = ls->wait_ns / ls->served;
+			avg_service = ls->service_ns / ls->served;
+		}
+		snprintf(names[lane][0], sizeof(names[lane][0]), "%s_served",
+			 req_q_s[lane]);
+		snprintf(names[lane][1], sizeof(names[lane][1]), "%s_wait",
+			 req_q_s[lane]);
+		snprintf(names[lane][2], sizeof(names[lane][2]), "%s_service",
+			 req_q_s[lane]);
+		type = names[lane][0];
+		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
+					       &type);
+		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+					       &ls->served);
+		type = names[lane][1];
+		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
+					       &type);
+		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+					       &avg_wait);
+		type = names[lane][2];
+		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING,
+					       &type);
+		dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+					       &avg_service);
+	}
+
+	dbus_message_iter_close_container(iter, &struct_iter);
+}
+
+/**
+ * @brief Name the op a latency histogram is kept for
+ *
+ * @param slot [IN] the histogram slot
+ * @param buf  [OUT] buffer for the name
+ * @param len  [IN] its size
+ */
+
+static void lat_slot_name(uint32_t slot, char *buf, size_t len)
+{
+	const char *proto, *op = NULL;
+	uint32_t ix;
+
+	if (slot >= LAT_FSAL) {
+		static const char * const fsal_ops[FSAL_LAT_OPS] = {
+			[FSAL_LAT_LOOKUP] = "lookup",
+			[FSAL_LAT_READDIR] = "readdir",
+			[FSAL_LAT_GETATTRS] = "getattrs",
+			[FSAL_LAT_SETATTRS] = "setattrs",
+			[FSAL_LAT_CREATE] = "create",
+			[FSAL_LAT_MKDIR] = "mkdir",
+			[FSAL_LAT_MKNODE] = "mknode",
+			[FSAL_LAT_SYMLINK] = "symlink",
+			[FSAL_LAT_READLINK] = "readlink",
+			[FSAL_LAT_LINK] = "link",
+			[FSAL_LAT_RENAME] = "rename",
+			[FSAL_LAT_UNLINK] = "unlink",
+			[FSAL_LAT_OPEN] = "open",
+			[FSAL_LAT_REOPEN] = "reopen",
+			[FSAL_LAT_CLOSE] = "close",
+			[FSAL_LAT_READ] = "read",
+			[FSAL_LAT_WRITE] = "write",
+			[FSAL_LAT_COMMIT] = "commit",
+			[FSAL_LAT_LOCK_OP] = "lock_op",
+			[FSAL_LAT_COPY] = "copy",
+		};
+
+		proto = "FSAL";
+		ix = slot - LAT_FSAL;
+		op = fsal_ops[ix];
+	} else if (slot >= LAT_QUEUE) {
+		proto = "QUEUE";
+		ix = slot - LAT_QUEUE;
+		op = req_q_s[ix];
+	} else if (slot >= LAT_9P) {
+		proto = "9P";
+		ix = slot - LAT_9P;
+#ifdef _USE_9P
+		if (ix <= _9P_TWSTAT)
+			op = _9pfuncdesc[ix].funcname;
+#endif
+	} else if (slot >= LAT_RQUOTA) {
+		proto = "RQUOTA";
+		ix = slot - LAT_RQUOTA;
+		op = optqta[ix].name;
+	} else if (slot >= LAT_MNT) {
+		proto = "MNT";
+		ix = slot - LAT_MNT;
+		op = optmnt[ix].name;
+	} else if (slot >= LAT_NLM) {
+		proto = "NLM";
+		ix = slot - LAT_NLM;
+		op = optnlm[ix].name;
+	} else if (slot >= LAT_NFSV4) {
+		proto = "NFSv4";
+		ix = slot - LAT_NFSV4;
+		op = optabv4[ix].name;
+	} else {
+		proto = "NFSv3";
+		ix = slot - LAT_NFSV3;
+		op = optabv3[ix].name;
+	}
+
+	if (op != NULL)
+		snprintf(buf, len, "%s:%s", proto, op);
+	else
+		snprintf(buf, len, "%s:%u", proto, ix);
+}
+
+/**
+ * @brief Append a histogram to a latency array
+ *
+ * @param array_iter [IN] iterator of the array
+ * @param name       [IN] what the histogram counts
+ * @param h          [IN] the histogram
+ * @param shift      [IN] right shift taking values back to their units
+ */
+
+static void dbus_append_histo(DBusMessageIter *array_iter, char *name,
+			      struct gsh_histogram *h, uint32_t shift)
+{
+	DBusMessageIter struct_iter;
+	uint64_t val;
+
+	dbus_message_iter_open_container(array_iter, DBUS_TYPE_STRUCT,
+					 NULL, &struct_iter);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &name);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+				       &h->count);
+	val = h->count != 0 ? (h->sum / h->count) >> shift : 0;
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &val);
+	val = gsh_histo_percentile(h, 5000) >> shift;
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &val);
+	val = gsh_histo_percentile(h, 9000) >> shift;
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &val);
+	val = gsh_histo_percentile(h, 9900) >> shift;
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &val);
+	val = gsh_histo_percentile(h, 9990) >> shift;
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &val);
+	val = gsh_histo_max(h) >> shift;
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &val);
+	dbus_message_iter_close_container(array_iter, &struct_iter);
+}
+
+/**
+ * @brief Report latency histograms
+ *
+ * One struct for each op that saw any requests since the last reset:
+ *
+ * struct latency {
+ *	char *op;		"NFSv4:OPEN", "QUEUE:LOW_LATENCY", ...
+ *	uint64_t count;
+ *	uint64_t mean;		all latencies in nsecs
+ *	uint64_t p50;
+ *	uint64_t p90;
+ *	uint64_t p99;
+ *	uint64_t p999;
+ *	uint64_t max;
+ * }
+ *
+ * Percentiles are the upper bound of the histogram bucket they fall
+ * in, within 1/8 of the latency itself.
+ *
+ * @param iter [IN] iterator to stuff the array into
+ */
+
+void server_dbus_latencies(DBusMessageIter *iter)
+{
+	struct timespec timestamp;
+	DBusMessageIter array_iter;
+	struct gsh_histogram *sum, *h;
+	uint32_t slot, i;
+	char name[64];
+
+	now(&timestamp);
+	dbus_append_timestamp(iter, &timestamp);
+	dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY,
+					 LATENCY_REPLY_ARRAY_TYPE,
+					 &array_iter);
+
+	sum = gsh_malloc(sizeof(*sum));
+	for (slot = 0; sum != NULL && lat_histo != NULL && slot < LAT_SLOTS;
+	     slot++) {
+		memset(sum, 0, sizeof(*sum));
+		for (i = 0; i < stats_shards; i++) {
+			h = atomic_fetch_voidptr(
+				(void **)&lat_histo[i * LAT_SLOTS + slot]);
+			if (h != NULL)
+				gsh_histo_merge(sum, h);
+		}
+		if (sum->count == 0)
+			continue;
+
+		lat_slot_name(slot, name, sizeof(name));
+		dbus_append_histo(&array_iter, name, sum, 0);
+	}
+	gsh_free(sum);
+
+	dbus_message_iter_close_container(iter, &array_iter);
+}
+
+/**
+ * @brief Report group commit histograms
+ *
+ * Three structs shaped as in server_dbus_latencies: "latency" in
+ * nsecs, from a commit joining its batch to its file being flushed,
+ * and "commits" and "files" flushed per batch.  Sizes are bucketed
+ * like latencies, so their percentiles are within 1/8 above 8.
+ *
+ * @param iter [IN] iterator to stuff the array into
+ */
+
+void server_dbus_commits(DBusMessageIter *iter)
+{
+	struct timespec timestamp;
+	DBusMessageIter array_iter;
+
+	now(&timestamp);
+	dbus_append_timestamp(iter, &timestamp);
+	dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY,
+					 LATENCY_REPLY_ARRAY_TYPE,
+					 &array_iter);
+	dbus_append_histo(&array_iter, "latency", &commit_lat, 0);
+	dbus_append_histo(&array_iter, "commits", &commit_size,
+			  GSH_HISTO_UNIT_SHIFT);
+	dbus_append_histo(&array_iter, "files", &commit_files,
+			  GSH_HISTO_UNIT_SHIFT);
+	dbus_message_iter_close_container(iter, &array_iter);
+}
+
+static void dbus_pool_stats(pool_t *pool, void *arg)
+{
+	DBusMessageIter *array_iter = arg;
+	DBusMessageIter struct_iter;
+	struct pool_slab_stats stats;
+	char *name = pool->name != NULL ? pool->name : "";
+
+	pool_slab_stats(pool, &stats);
+
+	dbus_message_iter_open_container(array_iter, DBUS_TYPE_STRUCT, NULL,
+					 &struct_iter);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &name);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+				       &stats.object_size);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+				       &stats.slabs);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+				       &stats.bytes);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+				       &stats.live);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+				       &stats.cached);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+				       &stats.hits);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64,
+				       &stats.misses);
+	dbus_message_iter_close_container(array_iter, &struct_iter);
+}
+
+/**
+ * @brief Report the statistics of every slab pool
+ *
+ * An array of:
+ * struct pool {
+ *	char *name;		Empty for unnamed pools
+ *	uint64_t object_size;
+ *	uint64_t slabs;
+ *	uint64_t bytes;		Held in slabs
+ *	uint64_t live;		Objects allocated and not freed
+ *	uint64_t cached;	Free objects in the depot and slabs
+ *	uint64_t hits;		Allocs and frees served by a magazine
+ *	uint64_t misses;	Allocs and frees that took the depot lock
+ * }
+ *
+ * @param iter [IN] iterator to stuff the array into
+ */
+
+void server_dbus_pools(DBusMessageIter *iter)
+{
+	struct timespec timestamp;
+	DBusMessageIter array_iter;
+
+	now(&timestamp);
+	dbus_append_timestamp(iter, &timestamp);
+	dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY,
+					 POOL_REPLY_ARRAY_TYPE,
+					 &array_iter);
+	pool_slab_foreach(dbus_pool_stats, &array_iter);
+	dbus_message_iter_close_container(iter, &array_iter);
+}
+
 void server_dbus_9p_iostats(struct _9p_stats *_9pp, DBusMessageIter *iter)
 {
 	struct timespec timestamp;
+	struct _9p_stats sum;
 
+	SUM_SHARDS(&sum, _9pp, sum_9p);
 	now(&timestamp);
 	dbus_append_timestamp(iter, &timestamp);
-	server_dbus_iostats(&_9pp->read, iter);
-	server_dbus_iostats(&_9pp->write, iter);
+	server_dbus_iostats(&sum.read, iter);
+	server_dbus_iostats(&sum.write, iter);
 }
 
 void server_dbus_9p_transstats(struct _9p_stats *_9pp, DBusMessageIter *iter)
 {
 	struct timespec timestamp;
+	struct _9p_stats sum;
 
+	SUM_SHARDS(&sum, _9pp, sum_9p);
 	now(&timestamp);
 	dbus_append_timestamp(iter, &timestamp);
-	server_dbus_transportstats(&_9pp->trans, iter);
+	server_dbus_transportstats(&sum.trans, iter);
 }
 
 /**
@@ -1736,27 +2655,31 @@ static void server_dbus_layouts(struct layout_op *lop, DBusMessageIter *iter)
 void server_dbus_v41_layouts(struct nfsv41_stats *v41p, DBusMessageIter *iter)
 {
 	struct timespec timestamp;
+	struct nfsv41_stats sum;
 
+	SUM_SHARDS(&sum, v41p, sum_v41);
 	now(&timestamp);
 	dbus_append_timestamp(iter, &timestamp);
-	server_dbus_layouts(&v41p->getdevinfo, iter);
-	server_dbus_layouts(&v41p->layout_get, iter);
-	server_dbus_layouts(&v41p->layout_commit, iter);
-	server_dbus_layouts(&v41p->layout_return, iter);
-	server_dbus_layouts(&v41p->recall, iter);
+	server_dbus_layouts(&sum.getdevinfo, iter);
+	server_dbus_layouts(&sum.layout_get, iter);
+	server_dbus_layouts(&sum.layout_commit, iter);
+	server_dbus_layouts(&sum.layout_return, iter);
+	server_dbus_layouts(&sum.recall, iter);
 }
 
 void server_dbus_v42_layouts(struct nfsv41_stats *v42p, DBusMessageIter *iter)
 {
 	struct timespec timestamp;
+	struct nfsv41_stats sum;
 
+	SUM_SHARDS(&sum, v42p, sum_v41);
 	now(&timestamp);
 	dbus_append_timestamp(iter, &timestamp);
-	server_dbus_layouts(&v42p->getdevinfo, iter);
-	server_dbus_layouts(&v42p->layout_get, iter);
-	server_dbus_layouts(&v42p->layout_commit, iter);
-	server_dbus_layouts(&v42p->layout_return, iter);
-	server_dbus_layouts(&v42p->recall, iter);
+	server_dbus_layouts(&sum.getdevinfo, iter);
+	server_dbus_layouts(&sum.layout_get, iter);
+	server_dbus_layouts(&sum.layout_commit, iter);
+	server_dbus_layouts(&sum.layout_return, iter);
+	server_dbus_layouts(&sum.recall, iter);
 }
 
 /**
@@ -1785,8 +2708,103 @@ void server_dbus_delegations(struct deleg_stats *ds, DBusMessageIter *iter)
 	dbus_message_iter_close_container(iter, &struct_iter);
 }
 
+/**
+ * @brief Report NFSv4.1 session slot statistics as a struct
+ *
+ * @param ss    [IN] the client's slot stats
+ * @param iter  [IN] interator in reply stream to fill
+ */
+void server_dbus_session_slots(struct slot_stats *ss, DBusMessageIter *iter)
+{
+	struct timespec timestamp;
+	DBusMessageIter struct_iter;
+	uint32_t val32;
+	uint64_t val64;
+
+	now(&timestamp);
+	dbus_append_timestamp(iter, &timestamp);
+	dbus_message_iter_open_container(iter, DBUS_TYPE_STRUCT, NULL,
+					 &struct_iter);
+	val32 = atomic_fetch_uint32_t(&ss->slots);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT32, &val32);
+	val32 = atomic_fetch_uint32_t(&ss->target);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT32, &val32);
+	val32 = atomic_fetch_uint32_t(&ss->busy);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT32, &val32);
+	val32 = atomic_fetch_uint32_t(&ss->max_busy);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT32, &val32);
+	val64 = atomic_fetch_uint64_t(&ss->requests);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &val64);
+	val64 = atomic_fetch_uint64_t(&ss->replays);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &val64);
+	val64 = atomic_fetch_uint64_t(&ss->uncached);
+	dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &val64);
+	dbus_message_iter_close_container(iter, &struct_iter);
+}
+
 #endif				/* USE_DBUS */
 
+/**
+ * @brief Set up the stats shards
+ *
+ * Called once the core configuration is loaded, before any request
+ * is served.
+ */
+
+void server_stats_init(void)
+{
+	struct global_stats *gs;
+	uint32_t n_shards;
+	long ncpu;
+
+	n_shards = nfs_param.core_param.stats_shards;
+	if (n_shards == 0) {
+		ncpu = sysconf(_SC_NPROCESSORS_CONF);
+		n_shards = (ncpu > 0) ? ncpu : 1;
+	}
+	if (n_shards > nfs_param.core_param.nb_worker)
+		n_shards = nfs_param.core_param.nb_worker;
+
+	stats_shards = n_shards;
+	gs = stats_alloc(sizeof(struct global_stats));
+	if (gs == NULL)
+		LogFatal(COMPONENT_INIT, "Unable to allocate stats shards");
+	global_st = gs;
+
+	lat_histo = gsh_calloc(n_shards * LAT_SLOTS, sizeof(*lat_histo));
+	if (lat_histo == NULL)
+		LogFatal(COMPONENT_INIT,
+			 "Unable to allocate latency histograms");
+
+	LogInfo(COMPONENT_INIT, "%u stats shards", n_shards);
+}
+
+/**
+ * @brief Empty every latency histogram
+ *
+ * Lets a monitor read the latencies of each interval on its own.
+ * Requests finishing while we reset may be partly counted.
+ */
+
+void server_stats_latency_reset(void)
+{
+	struct gsh_histogram *h;
+	uint32_t i;
+
+	gsh_histo_reset(&commit_lat);
+	gsh_histo_reset(&commit_size);
+	gsh_histo_reset(&commit_files);
+
+	if (lat_histo == NULL)
+		return;
+
+	for (i = 0; i < stats_shards * LAT_SLOTS; i++) {
+		h = atomic_fetch_voidptr((void **)&lat_histo[i]);
+		if (h != NULL)
+			gsh_histo_reset(h);
+	}
+}
+
 /**
  * @brief Free statistics storage
  *
@@ -1830,6 +2848,10 @@ void server_stats_free(struct gsh_stats *statsp)
 		gsh_free(statsp->_9p);
 		statsp->_9p = NULL;
 	}
+	if (statsp->slots != NULL) {
+		gsh_free(statsp->slots);
+		statsp->slots = NULL;
+	}
 }
 
 /** @} */
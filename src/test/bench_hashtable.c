@@ -0,0 +1,212 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ * ---------------------------------------
+ */
+
+/*
+ * Hash table backend benchmark.
+ *
+ * Fills a table with 64 bit keys, then has every thread run a mix of
+ * lookups over all keys and deletes followed by re-inserts over a
+ * slice of keys of its own, the way SAL tables see lookups of
+ * existing state mixed with state coming and going.  Each mix is run
+ * against the red-black tree backend and the open addressed one,
+ * reporting millions of operations per second.
+ *
+ * usage: bench_hashtable [threads [keys [ops per thread]]]
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "hashtable.h"
+
+#define INDEX_SIZE 17
+
+static int nthreads = 4;
+static uint32_t nkeys = 100000;
+static uint64_t per_thread = 2000000;
+static uint64_t *keys;
+static hash_table_t *ht;
+static int read_pct;
+
+static double now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static uint64_t mix(uint64_t x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+static int hash_both(struct hash_param *param, struct gsh_buffdesc *key,
+		     uint32_t *index, uint64_t *rbt_hash)
+{
+	uint64_t h = mix(*(uint64_t *)key->addr);
+
+	*index = h % param->index_size;
+	*rbt_hash = h;
+	return 1;
+}
+
+static int compare(struct gsh_buffdesc *a, struct gsh_buffdesc *b)
+{
+	return *(uint64_t *)a->addr != *(uint64_t *)b->addr;
+}
+
+static int free_entry(struct gsh_buffdesc key, struct gsh_buffdesc val)
+{
+	return 1;
+}
+
+static void make_key(struct gsh_buffdesc *buf, uint32_t i)
+{
+	buf->addr = &keys[i];
+	buf->len = sizeof(uint64_t);
+}
+
+static void *worker(void *arg)
+{
+	uintptr_t id = (uintptr_t) arg;
+	uint32_t slice = nkeys / nthreads;
+	uint32_t base = id * slice;
+	uint64_t seed = mix(id + 1);
+	struct gsh_buffdesc key, val;
+	uint64_t n;
+	uint32_t i;
+	hash_error_t rc;
+
+	for (n = 0; n < per_thread; n++) {
+		seed = mix(seed);
+		if ((int)(seed % 100) < read_pct) {
+			i = (seed >> 8) % nkeys;
+			make_key(&key, i);
+			rc = HashTable_Get(ht, &key, &val);
+			/* Only another thread's slice may be missing a key
+			   for a moment, and a key found is always its own
+			   value. */
+			if ((rc == HASHTABLE_SUCCESS && val.addr != &keys[i])
+			    || (rc != HASHTABLE_SUCCESS &&
+				(i >= slice * nthreads || i / slice == id))) {
+				fprintf(stderr, "bad lookup of key %" PRIu32
+					"\n", i);
+				exit(1);
+			}
+		} else {
+			i = base + (seed >> 8) % slice;
+			make_key(&key, i);
+			val = key;
+			if (HashTable_Del(ht, &key, NULL, NULL) !=
+			    HASHTABLE_SUCCESS ||
+			    HashTable_Set(ht, &key, &val) !=
+			    HASHTABLE_SUCCESS) {
+				fprintf(stderr, "update failed\n");
+				exit(1);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static void run(const char *name, uint32_t flags)
+{
+	struct hash_param param;
+	struct gsh_buffdesc key, val;
+	pthread_t thr[nthreads];
+	double t0, secs;
+	uintptr_t i;
+
+	memset(&param, 0, sizeof(param));
+	param.flags = flags;
+	param.index_size = INDEX_SIZE;
+	param.hash_func_both = hash_both;
+	param.compare_key = compare;
+	param.ht_name = "bench";
+	param.ht_log_component = COMPONENT_HASHTABLE;
+
+	ht = hashtable_init(&param);
+	if (ht == NULL) {
+		fprintf(stderr, "hashtable_init failed\n");
+		exit(1);
+	}
+
+	for (i = 0; i < nkeys; i++) {
+		make_key(&key, i);
+		val = key;
+		if (HashTable_Set(ht, &key, &val) != HASHTABLE_SUCCESS) {
+			fprintf(stderr, "fill failed\n");
+			exit(1);
+		}
+	}
+
+	t0 = now();
+	for (i = 0; i < nthreads; i++)
+		pthread_create(&thr[i], NULL, worker, (void *)i);
+	for (i = 0; i < nthreads; i++)
+		pthread_join(thr[i], NULL);
+	secs = now() - t0;
+
+	printf("%3d%% reads %-8s %8.2f Mops/s\n", read_pct, name,
+	       per_thread * nthreads / secs / 1e6);
+
+	hashtable_destroy(ht, free_entry);
+}
+
+int main(int argc, char **argv)
+{
+	static const int mixes[] = { 100, 90, 50 };
+	uint32_t i;
+
+	if (argc > 1)
+		nthreads = atoi(argv[1]);
+	if (argc > 2)
+		nkeys = strtoul(argv[2], NULL, 0);
+	if (argc > 3)
+		per_thread = strtoull(argv[3], NULL, 0);
+
+	keys = calloc(nkeys, sizeof(uint64_t));
+	if (keys == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (i = 0; i < nkeys; i++)
+		keys[i] = i;
+
+	printf("%d threads, %" PRIu32 " keys, %" PRIu64 " ops each\n",
+	       nthreads, nkeys, per_thread);
+
+	for (i = 0; i < sizeof(mixes) / sizeof(mixes[0]); i++) {
+		read_pct = mixes[i];
+		run("rbtree", HT_FLAG_NONE);
+		run("open", HT_FLAG_OPEN_ADDR);
+	}
+
+	free(keys);
+	return 0;
+}
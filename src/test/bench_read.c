@@ -0,0 +1,190 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ * ---------------------------------------
+ */
+
+/*
+ * READ path buffer benchmark.
+ *
+ * Each thread reads a file in rsize chunks the way nfs3_read and
+ * nfs4_op_read do: get a payload buffer, pread into it, copy it into
+ * a send buffer as the reply encoder would, release the payload
+ * buffer.  The run is repeated with a fresh allocation per READ and
+ * with the gsh_iobuf pool, reporting throughput and CPU seconds per
+ * GiB for each.
+ *
+ * usage: bench_read [file [rsize [threads [GiB per thread]]]]
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "abstract_mem.h"
+#include "gsh_iobuf.h"
+
+#define FILE_SIZE (256UL * 1024 * 1024)
+
+static const char *path = "/tmp/bench_read.dat";
+static size_t rsize = 1024 * 1024;
+static int nthreads = 4;
+static uint64_t per_thread = 4UL * 1024 * 1024 * 1024;
+static int fd;
+static int use_pool;
+
+static double now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static double cpu_time(void)
+{
+	struct rusage ru;
+
+	getrusage(RUSAGE_SELF, &ru);
+	return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+	       ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+static void *reader(void *arg)
+{
+	uint64_t off = ((uintptr_t) arg * rsize * 64) % FILE_SIZE;
+	char *sendbuf = gsh_malloc(rsize);
+	uint64_t done = 0;
+	ssize_t n;
+	void *buf;
+
+	while (done < per_thread) {
+		if (use_pool)
+			buf = gsh_iobuf_get(rsize);
+		else
+			buf = gsh_malloc_aligned(4096, rsize);
+		if (buf == NULL || sendbuf == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+
+		n = pread(fd, buf, rsize, off);
+		if (n <= 0) {
+			perror("pread");
+			exit(1);
+		}
+		memcpy(sendbuf, buf, n);
+
+		if (use_pool)
+			gsh_iobuf_put(buf);
+		else
+			gsh_free(buf);
+
+		done += n;
+		off += n;
+		if (off >= FILE_SIZE)
+			off = 0;
+	}
+
+	gsh_free(sendbuf);
+	return NULL;
+}
+
+static void run(const char *name)
+{
+	pthread_t thr[nthreads];
+	double t0, c0, secs, cpu;
+	double gib = (double)per_thread * nthreads / (1UL << 30);
+	uintptr_t i;
+
+	t0 = now();
+	c0 = cpu_time();
+
+	for (i = 0; i < nthreads; i++)
+		pthread_create(&thr[i], NULL, reader, (void *)i);
+	for (i = 0; i < nthreads; i++)
+		pthread_join(thr[i], NULL);
+
+	secs = now() - t0;
+	cpu = cpu_time() - c0;
+
+	printf("%-8s %8.2f GiB/s %8.3f cpu-s/GiB\n", name, gib / secs,
+	       cpu / gib);
+}
+
+static void make_file(void)
+{
+	char *chunk;
+	uint64_t off;
+
+	fd = open(path, O_RDWR | O_CREAT, 0600);
+	if (fd < 0) {
+		perror(path);
+		exit(1);
+	}
+
+	if (lseek(fd, 0, SEEK_END) >= FILE_SIZE)
+		return;
+
+	chunk = gsh_malloc(1024 * 1024);
+	memset(chunk, 0xa5, 1024 * 1024);
+	for (off = 0; off < FILE_SIZE; off += 1024 * 1024)
+		if (pwrite(fd, chunk, 1024 * 1024, off) != 1024 * 1024) {
+			perror("pwrite");
+			exit(1);
+		}
+	gsh_free(chunk);
+}
+
+int main(int argc, char **argv)
+{
+	struct gsh_iobuf_stats st;
+
+	if (argc > 1)
+		path = argv[1];
+	if (argc > 2)
+		rsize = strtoul(argv[2], NULL, 0);
+	if (argc > 3)
+		nthreads = atoi(argv[3]);
+	if (argc > 4)
+		per_thread = strtoull(argv[4], NULL, 0) << 30;
+
+	make_file();
+
+	printf("rsize %zu, %d threads, %.1f GiB each, file %s\n",
+	       rsize, nthreads, (double)per_thread / (1UL << 30), path);
+
+	/* warm the page cache */
+	use_pool = 0;
+	run("warmup");
+
+	run("malloc");
+
+	gsh_iobuf_init(64 * 1024 * 1024);
+	use_pool = 1;
+	run("pool");
+
+	gsh_iobuf_get_stats(&st);
+	printf("pool hits %" PRIu64 " misses %" PRIu64 "\n",
+	       st.hits, st.misses);
+
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,335 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file fake_statd.c
+ * @brief Stand-in for rpc.statd when testing NLM
+ *
+ * Answers SM_MON, SM_UNMON and SM_UNMON_ALL over TCP with success,
+ * optionally after a delay standing in for statd syncing its monitor
+ * files, and counts what it was asked.  Calls are served one at a time
+ * like statd does.  Stop the real statd before registering this one.
+ *
+ * The RPC messages are encoded by hand so this needs nothing but the
+ * rpcbind registration from the RPC library.
+ *
+ * usage: fake_statd [-p port] [-d msecs] [-n] [-v]
+ *   -p  TCP port to listen on, default any
+ *   -d  delay every call by msecs
+ *   -n  don't register with rpcbind, just print the port
+ *   -v  print every call
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <rpc/rpc.h>
+#include <rpc/pmap_clnt.h>
+
+#define SM_PROG 100024
+#define SM_VERS 1
+#define SM_MON 2
+#define SM_UNMON 3
+#define SM_UNMON_ALL 4
+
+#define CALL 0
+#define REPLY 1
+#define MSG_ACCEPTED 0
+#define SUCCESS 0
+#define PROG_UNAVAIL 1
+#define PROC_UNAVAIL 3
+
+#define LAST_FRAG 0x80000000U
+#define MAX_RECORD 65536
+
+static pthread_mutex_t statd_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int delay_ms;
+static bool verbose;
+static uint64_t calls[SM_UNMON_ALL + 1];
+static uint64_t others;
+static int32_t state = 1;
+
+static volatile sig_atomic_t done;
+
+static void stop(int sig)
+{
+	done = 1;
+}
+
+/**
+ * @brief Read a whole RPC record
+ *
+ * @return Its length, or -1 at end of stream or on error.
+ */
+
+static ssize_t read_record(int fd, char *buf, size_t size)
+{
+	uint32_t mark;
+	size_t len = 0, frag;
+	ssize_t n;
+	size_t got;
+
+	do {
+		for (got = 0; got < sizeof(mark); got += n) {
+			n = read(fd, (char *)&mark + got, sizeof(mark) - got);
+			if (n <= 0)
+				return -1;
+		}
+		mark = ntohl(mark);
+		frag = mark & ~LAST_FRAG;
+		if (len + frag > size)
+			return -1;
+		for (got = 0; got < frag; got += n) {
+			n = read(fd, buf + len + got, frag - got);
+			if (n <= 0)
+				return -1;
+		}
+		len += frag;
+	} while (!(mark & LAST_FRAG));
+
+	return len;
+}
+
+static bool get_u32(const char *buf, size_t len, size_t *pos, uint32_t *val)
+{
+	if (*pos + 4 > len)
+		return false;
+	memcpy(val, buf + *pos, 4);
+	*val = ntohl(*val);
+	*pos += 4;
+	return true;
+}
+
+/* Skip opaque data, credentials, or a string */
+static bool skip_opaque(const char *buf, size_t len, size_t *pos)
+{
+	uint32_t n;
+
+	if (!get_u32(buf, len, pos, &n) || n > len)
+		return false;
+	*pos += (n + 3) & ~3U;
+	return *pos <= len;
+}
+
+static void put_u32(char *buf, size_t *pos, uint32_t val)
+{
+	val = htonl(val);
+	memcpy(buf + *pos, &val, 4);
+	*pos += 4;
+}
+
+/**
+ * @brief Answer one call
+ *
+ * @return Length of the reply record, 0 to send nothing.
+ */
+
+static size_t serve(const char *call, size_t len, char *reply)
+{
+	size_t pos = 0, out = 4;
+	uint32_t xid, type, rpcvers, prog, vers, proc, flavor, n;
+	char name[1025] = "";
+
+	if (!get_u32(call, len, &pos, &xid) ||
+	    !get_u32(call, len, &pos, &type) || type != CALL ||
+	    !get_u32(call, len, &pos, &rpcvers) ||
+	    !get_u32(call, len, &pos, &prog) ||
+	    !get_u32(call, len, &pos, &vers) ||
+	    !get_u32(call, len, &pos, &proc) ||
+	    !get_u32(call, len, &pos, &flavor) ||
+	    !skip_opaque(call, len, &pos) ||
+	    !get_u32(call, len, &pos, &flavor) ||
+	    !skip_opaque(call, len, &pos))
+		return 0;
+
+	put_u32(reply, &out, xid);
+	put_u32(reply, &out, REPLY);
+	put_u32(reply, &out, MSG_ACCEPTED);
+	put_u32(reply, &out, 0);	/* AUTH_NONE verifier */
+	put_u32(reply, &out, 0);
+
+	if (prog != SM_PROG || vers != SM_VERS) {
+		put_u32(reply, &out, PROG_UNAVAIL);
+		goto out;
+	}
+
+	if (proc == SM_MON || proc == SM_UNMON) {
+		/* mon_name comes first in both */
+		if (get_u32(call, len, &pos, &n) && n < sizeof(name) &&
+		    pos + n <= len) {
+			memcpy(name, call + pos, n);
+			name[n] = '\0';
+		}
+	} else if (proc != SM_UNMON_ALL && proc != 0) {
+		put_u32(reply, &out, PROC_UNAVAIL);
+		goto out;
+	}
+
+	pthread_mutex_lock(&statd_mutex);
+	if (proc == 0) {
+		others++;
+	} else {
+		calls[proc]++;
+		if (delay_ms != 0) {
+			struct timespec ts = { delay_ms / 1000,
+					       (delay_ms % 1000) * 1000000 };
+
+			nanosleep(&ts, NULL);
+		}
+	}
+	pthread_mutex_unlock(&statd_mutex);
+
+	if (verbose)
+		printf("proc %u %s\n", proc, name);
+
+	put_u32(reply, &out, SUCCESS);
+	if (proc == SM_MON)
+		put_u32(reply, &out, 0);	/* STAT_SUCC */
+	if (proc != 0)
+		put_u32(reply, &out, state);
+
+ out:
+	pos = 0;
+	put_u32(reply, &pos, LAST_FRAG | (out - 4));
+	return out;
+}
+
+static void *connection(void *arg)
+{
+	int fd = (intptr_t) arg;
+	char *call = malloc(MAX_RECORD);
+	char reply[64];
+	ssize_t len;
+	size_t out;
+
+	while (call != NULL &&
+	       (len = read_record(fd, call, MAX_RECORD)) >= 0) {
+		out = serve(call, len, reply);
+		if (out != 0 && write(fd, reply, out) != (ssize_t) out)
+			break;
+	}
+
+	free(call);
+	close(fd);
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	struct sockaddr_in addr;
+	socklen_t addrlen = sizeof(addr);
+	struct sigaction sa;
+	bool registered = true;
+	int port = 0;
+	int c, fd, conn;
+	pthread_t thr;
+
+	while ((c = getopt(argc, argv, "p:d:nv")) != EOF) {
+		switch (c) {
+		case 'p':
+			port = atoi(optarg);
+			break;
+		case 'd':
+			delay_ms = atoi(optarg);
+			break;
+		case 'n':
+			registered = false;
+			break;
+		case 'v':
+			verbose = true;
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-p port] [-d msecs] [-n] [-v]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	c = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &c, sizeof(c));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+	    listen(fd, 16) != 0 ||
+	    getsockname(fd, (struct sockaddr *)&addr, &addrlen) != 0) {
+		perror("listen");
+		return 1;
+	}
+	port = ntohs(addr.sin_port);
+
+	if (registered) {
+		pmap_unset(SM_PROG, SM_VERS);
+		if (!pmap_set(SM_PROG, SM_VERS, IPPROTO_TCP, port)) {
+			fprintf(stderr, "Could not register with rpcbind\n");
+			return 1;
+		}
+	}
+	printf("listening on port %d\n", port);
+	fflush(stdout);
+
+	/* Let accept be interrupted so the counts get printed */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = stop;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	while (!done) {
+		conn = accept(fd, NULL, NULL);
+		if (conn < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("accept");
+			break;
+		}
+		if (pthread_create(&thr, NULL, connection,
+				   (void *)(intptr_t) conn) != 0) {
+			close(conn);
+			continue;
+		}
+		pthread_detach(thr);
+	}
+
+	if (registered)
+		pmap_unset(SM_PROG, SM_VERS);
+
+	pthread_mutex_lock(&statd_mutex);
+	printf("SM_MON %" PRIu64 " SM_UNMON %" PRIu64
+	       " SM_UNMON_ALL %" PRIu64 " NULL %" PRIu64 "\n",
+	       calls[SM_MON], calls[SM_UNMON], calls[SM_UNMON_ALL], others);
+	pthread_mutex_unlock(&statd_mutex);
+
+	return 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ * ---------------------------------------
+ */
+
+/*
+ * Group commit test.
+ *
+ * A commit on a file whose flush blocks keeps the group busy, so the
+ * next batch's leader waits for more commits.  NCOMMITS threads then
+ * commit on NFILES files with batch_max set to NCOMMITS, and the
+ * batch must close as soon as the last joins, long before the window
+ * ends.  Each file must be flushed once, over the range covering its
+ * commits, and the error given for one file must reach every commit
+ * on it and no other.  A lone commit must then wait out the window,
+ * and one on an idle group must not wait at all.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "abstract_atomic.h"
+#include "gsh_list.h"
+#include "gsh_group_commit.h"
+
+#define NFILES 4
+#define NCOMMITS 32
+#define RANGE 4096
+#define WINDOW_USEC 5000000
+#define SHORT_WINDOW_USEC 200000
+#define BAD_FILE 1
+#define BAD_ERROR 5
+
+struct test_commit {
+	struct group_commit_req req;
+	int error;
+};
+
+static char files[NFILES];
+static char blocker_file;
+static struct test_commit commits[NCOMMITS];
+
+static pthread_mutex_t gate_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gate_cv = PTHREAD_COND_INITIALIZER;
+static bool blocker_flushing;
+static bool blocker_release;
+
+static uint32_t flushes[NFILES];
+static uint32_t flush_members[NFILES];
+static uint64_t flush_offset[NFILES];
+static uint64_t flush_end[NFILES];
+static uint32_t batches;
+static uint32_t batch_commits[4];
+static uint32_t batch_files[4];
+
+static void test_flush(struct group_commit_req **reqs, uint32_t count)
+{
+	int error = 0;
+	uint32_t i;
+
+	if (reqs[0]->file == &blocker_file) {
+		pthread_mutex_lock(&gate_mtx);
+		blocker_flushing = true;
+		pthread_cond_broadcast(&gate_cv);
+		while (!blocker_release)
+			pthread_cond_wait(&gate_cv, &gate_mtx);
+		pthread_mutex_unlock(&gate_mtx);
+	} else if (reqs[0]->file >= (void *)files &&
+		   reqs[0]->file < (void *)(files + NFILES)) {
+		i = (char *)reqs[0]->file - files;
+		atomic_inc_uint32_t(&flushes[i]);
+		flush_members[i] = count;
+		flush_offset[i] = reqs[0]->offset;
+		flush_end[i] = reqs[0]->end;
+		if (i == BAD_FILE)
+			error = BAD_ERROR;
+	}
+
+	for (i = 0; i < count; i++)
+		container_of(reqs[i], struct test_commit, req)->error = error;
+}
+
+static void test_batched(uint32_t commits, uint32_t files)
+{
+	uint32_t n = atomic_postinc_uint32_t(&batches);
+
+	if (n < 4) {
+		batch_commits[n] = commits;
+		batch_files[n] = files;
+	}
+}
+
+static struct group_commit gc =
+	GROUP_COMMIT_INITIALIZER(test_flush, test_batched);
+
+static double elapsed(struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) +
+	    (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void *blocker(void *arg)
+{
+	struct test_commit me = {
+		.req.file = &blocker_file,
+		.req.end = UINT64_MAX,
+	};
+
+	group_commit(&gc, &me.req);
+	return NULL;
+}
+
+static void *committer(void *arg)
+{
+	uintptr_t id = (uintptr_t) arg;
+	struct test_commit *me = &commits[id];
+
+	me->req.file = &files[id % NFILES];
+	me->req.offset = id * RANGE;
+	me->req.end = id * RANGE + RANGE;
+	me->error = -1;
+
+	group_commit(&gc, &me->req);
+	return NULL;
+}
+
+static void fail(const char *what)
+{
+	printf("FAIL: %s\n", what);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t block_thread, threads[NCOMMITS];
+	struct test_commit lone = {
+		.req.file = &files[0],
+		.req.end = RANGE,
+	};
+	struct timespec start;
+	uintptr_t id;
+	uint32_t i;
+	double secs;
+
+	gc.batch_max = NCOMMITS;
+	gc.window = WINDOW_USEC;
+
+	/* Keep the group busy flushing */
+	pthread_create(&block_thread, NULL, blocker, NULL);
+	pthread_mutex_lock(&gate_mtx);
+	while (!blocker_flushing)
+		pthread_cond_wait(&gate_cv, &gate_mtx);
+	pthread_mutex_unlock(&gate_mtx);
+
+	/* A full batch closes without waiting out the window */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (id = 0; id < NCOMMITS; id++)
+		pthread_create(&threads[id], NULL, committer, (void *)id);
+	for (id = 0; id < NCOMMITS; id++)
+		pthread_join(threads[id], NULL);
+	secs = elapsed(&start);
+
+	if (secs >= WINDOW_USEC / 2e6)
+		fail("full batch waited for the window");
+	if (batches != 2 || batch_commits[1] != NCOMMITS ||
+	    batch_files[1] != NFILES)
+		fail("commits not batched together");
+
+	for (i = 0; i < NFILES; i++) {
+		if (flushes[i] != 1)
+			fail("file not flushed exactly once");
+		if (flush_members[i] != NCOMMITS / NFILES)
+			fail("head did not flush for all commits on its file");
+		if (flush_offset[i] != i * RANGE ||
+		    flush_end[i] != (NCOMMITS - NFILES + i) * RANGE + RANGE)
+			fail("head range does not cover its file's commits");
+	}
+
+	for (id = 0; id < NCOMMITS; id++) {
+		if (commits[id].error !=
+		    (id % NFILES == BAD_FILE ? BAD_ERROR : 0))
+			fail("error not given to exactly its file's commits");
+	}
+
+	printf("full batch: %d commits on %d files in %.3fs\n",
+	       NCOMMITS, NFILES, secs);
+
+	/* A lone commit waits for company while the group is busy */
+	gc.window = SHORT_WINDOW_USEC;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	group_commit(&gc, &lone.req);
+	secs = elapsed(&start);
+	if (secs < SHORT_WINDOW_USEC / 1e6 * 0.9)
+		fail("lone commit did not wait for the window");
+	if (lone.error != 0)
+		fail("lone commit got an error");
+	printf("lone commit: waited %.3fs\n", secs);
+
+	/* An idle group flushes at once */
+	pthread_mutex_lock(&gate_mtx);
+	blocker_release = true;
+	pthread_cond_broadcast(&gate_cv);
+	pthread_mutex_unlock(&gate_mtx);
+	pthread_join(block_thread, NULL);
+
+	gc.window = WINDOW_USEC;
+	lone.error = -1;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	group_commit(&gc, &lone.req);
+	secs = elapsed(&start);
+	if (secs >= WINDOW_USEC / 2e6 || lone.error != 0)
+		fail("commit on an idle group waited");
+	printf("idle commit: %.6fs\n", secs);
+
+	printf("PASS\n");
+	return 0;
+}
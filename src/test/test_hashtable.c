@@ -0,0 +1,391 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ * ---------------------------------------
+ */
+
+/*
+ * Open addressed hash table test.
+ *
+ * Grows a single partition from its smallest size while readers look
+ * up keys that were there all along, which must always be found, and
+ * keys that never were, which must never be.  Then has threads delete
+ * and reinsert keys of their own, each insert with a freshly allocated
+ * key buffer that is scribbled on and freed after the delete, while
+ * they look up their own keys (found exactly when inserted) and each
+ * other's (found with the right value, or not at all).  Last, holds a
+ * partition's lock and checks that a lookup of a key no longer than
+ * oa_key_len does not wait for it, while a longer one does, and that
+ * such a lookup never reads the key buffer given when inserting.
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "abstract_atomic.h"
+#include "hashtable.h"
+
+#define NSTABLE 64
+#define NGROW 200000
+#define NREADERS 3
+#define NTHREADS 4
+#define PER_THREAD 256
+#define ROUNDS 200
+#define ADDR_LEN 128
+
+static uint64_t stable[NSTABLE];
+static uint64_t grown[NGROW];
+static uint32_t growing;
+static uint64_t vals[NTHREADS * PER_THREAD];
+static hash_table_t *ht;
+
+static uint64_t mix(uint64_t x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+static int hash_both(struct hash_param *param, struct gsh_buffdesc *key,
+		     uint32_t *index, uint64_t *rbt_hash)
+{
+	const unsigned char *p = key->addr;
+	uint64_t h = key->len;
+	size_t i;
+
+	for (i = 0; i < key->len; i++)
+		h = mix(h ^ p[i]);
+
+	*index = h % param->index_size;
+	*rbt_hash = h;
+	return 1;
+}
+
+static int compare(struct gsh_buffdesc *a, struct gsh_buffdesc *b)
+{
+	return a->len != b->len || memcmp(a->addr, b->addr, a->len) != 0;
+}
+
+static int free_entry(struct gsh_buffdesc key, struct gsh_buffdesc val)
+{
+	return 1;
+}
+
+static hash_table_t *make_table(uint32_t index_size, uint32_t oa_key_len)
+{
+	struct hash_param param;
+	hash_table_t *table;
+
+	memset(&param, 0, sizeof(param));
+	param.flags = HT_FLAG_OPEN_ADDR;
+	param.index_size = index_size;
+	param.hash_func_both = hash_both;
+	param.compare_key = compare;
+	param.oa_key_len = oa_key_len;
+	param.ht_name = "test";
+	param.ht_log_component = COMPONENT_HASHTABLE;
+
+	table = hashtable_init(&param);
+	if (table == NULL) {
+		printf("hashtable_init failed\n");
+		exit(1);
+	}
+	return table;
+}
+
+static void fail(const char *what, uint64_t key)
+{
+	printf("FAIL: %s, key %llu\n", what, (unsigned long long)key);
+	exit(1);
+}
+
+static void *grow_reader(void *arg)
+{
+	uint64_t seed = mix((uintptr_t) arg + 1);
+	struct gsh_buffdesc key, val;
+	uint64_t missing;
+	uint32_t i;
+
+	while (atomic_fetch_uint32_t(&growing)) {
+		seed = mix(seed);
+		i = seed % NSTABLE;
+		key.addr = &stable[i];
+		key.len = sizeof(uint64_t);
+		if (HashTable_Get(ht, &key, &val) != HASHTABLE_SUCCESS ||
+		    val.addr != &stable[i])
+			fail("stable key lost while growing", stable[i]);
+
+		/* Never inserted */
+		missing = 1ULL << 62 | (seed >> 8);
+		key.addr = &missing;
+		if (HashTable_Get(ht, &key, &val) !=
+		    HASHTABLE_ERROR_NO_SUCH_KEY)
+			fail("found a key never inserted", missing);
+	}
+	return NULL;
+}
+
+void grow_test(void)
+{
+	pthread_t readers[NREADERS];
+	struct gsh_buffdesc key, val;
+	uintptr_t id;
+	uint32_t i;
+
+	/* One partition, so every insert grows the same array */
+	ht = make_table(1, 0);
+
+	for (i = 0; i < NSTABLE; i++) {
+		stable[i] = 1ULL << 61 | i;
+		key.addr = &stable[i];
+		key.len = sizeof(uint64_t);
+		val = key;
+		if (HashTable_Set(ht, &key, &val) != HASHTABLE_SUCCESS)
+			fail("insert failed", stable[i]);
+	}
+
+	growing = 1;
+	for (id = 0; id < NREADERS; id++)
+		pthread_create(&readers[id], NULL, grow_reader, (void *)id);
+
+	for (i = 0; i < NGROW; i++) {
+		grown[i] = i;
+		key.addr = &grown[i];
+		key.len = sizeof(uint64_t);
+		val = key;
+		if (HashTable_Set(ht, &key, &val) != HASHTABLE_SUCCESS)
+			fail("insert failed", grown[i]);
+	}
+
+	atomic_store_uint32_t(&growing, 0);
+	for (id = 0; id < NREADERS; id++)
+		pthread_join(readers[id], NULL);
+
+	for (i = 0; i < NGROW; i++) {
+		key.addr = &grown[i];
+		key.len = sizeof(uint64_t);
+		if (HashTable_Get(ht, &key, &val) != HASHTABLE_SUCCESS ||
+		    val.addr != &grown[i])
+			fail("grown key lost", grown[i]);
+	}
+
+	printf("grow: %d keys in %" PRIu32 " slots\n", NSTABLE + NGROW,
+	       ht->partitions[0].slots->mask + 1);
+	hashtable_destroy(ht, free_entry);
+}
+
+static void *churner(void *arg)
+{
+	uintptr_t id = (uintptr_t) arg;
+	uint64_t *mine[PER_THREAD];
+	uint64_t seed = mix(id + 1);
+	struct gsh_buffdesc key, val, stored_key;
+	uint64_t k;
+	uint32_t round, i, j;
+
+	for (i = 0; i < PER_THREAD; i++)
+		mine[i] = NULL;
+
+	for (round = 0; round < ROUNDS; round++) {
+		for (i = 0; i < PER_THREAD; i++) {
+			k = id * PER_THREAD + i;
+
+			/* Reinsert with a new key buffer */
+			mine[i] = malloc(sizeof(uint64_t));
+			*mine[i] = k;
+			key.addr = mine[i];
+			key.len = sizeof(uint64_t);
+			val.addr = &vals[k];
+			val.len = sizeof(uint64_t);
+			if (HashTable_Set(ht, &key, &val) != HASHTABLE_SUCCESS)
+				fail("reinsert failed", k);
+
+			key.addr = &k;
+			if (HashTable_Get(ht, &key, &val) != HASHTABLE_SUCCESS
+			    || val.addr != &vals[k])
+				fail("own key not found after insert", k);
+
+			/* Someone else's key, found right or not at all */
+			seed = mix(seed);
+			j = seed % (NTHREADS * PER_THREAD);
+			k = j;
+			if (HashTable_Get(ht, &key, &val) == HASHTABLE_SUCCESS
+			    && val.addr != &vals[j])
+				fail("key found with the wrong value", k);
+		}
+
+		for (i = 0; i < PER_THREAD; i++) {
+			k = id * PER_THREAD + i;
+			key.addr = &k;
+			key.len = sizeof(uint64_t);
+			if (HashTable_Del(ht, &key, &stored_key, NULL) !=
+			    HASHTABLE_SUCCESS || stored_key.addr != mine[i])
+				fail("delete failed", k);
+
+			/* The table kept its own copy to compare against */
+			memset(mine[i], 0xff, sizeof(uint64_t));
+			free(mine[i]);
+			mine[i] = NULL;
+
+			if (HashTable_Get(ht, &key, &val) !=
+			    HASHTABLE_ERROR_NO_SUCH_KEY)
+				fail("own key found after delete", k);
+		}
+	}
+	return NULL;
+}
+
+void churn_test(void)
+{
+	pthread_t threads[NTHREADS];
+	uintptr_t id;
+
+	/* Few partitions, so the threads' keys share them */
+	ht = make_table(3, 0);
+
+	for (id = 0; id < NTHREADS; id++)
+		pthread_create(&threads[id], NULL, churner, (void *)id);
+	for (id = 0; id < NTHREADS; id++)
+		pthread_join(threads[id], NULL);
+
+	printf("churn: %d threads, %d keys each, %d rounds\n", NTHREADS,
+	       PER_THREAD, ROUNDS);
+	hashtable_destroy(ht, free_entry);
+}
+
+struct lookup {
+	struct gsh_buffdesc key;
+	uint32_t done;
+	hash_error_t rc;
+};
+
+static void *looker(void *arg)
+{
+	struct lookup *lookup = arg;
+	struct gsh_buffdesc val;
+
+	lookup->rc = HashTable_Get(ht, &lookup->key, &val);
+	atomic_store_uint32_t(&lookup->done, 1);
+	return NULL;
+}
+
+static bool waits_for_lock(struct gsh_buffdesc *key)
+{
+	struct lookup lookup = { .key = *key };
+	pthread_t thread;
+	bool waited;
+	int i;
+
+	pthread_rwlock_wrlock(&ht->partitions[0].lock);
+	pthread_create(&thread, NULL, looker, &lookup);
+	for (i = 0; i < 100 && !atomic_fetch_uint32_t(&lookup.done); i++)
+		usleep(2000);
+	waited = !atomic_fetch_uint32_t(&lookup.done);
+	pthread_rwlock_unlock(&ht->partitions[0].lock);
+	pthread_join(thread, NULL);
+
+	if (lookup.rc != HASHTABLE_SUCCESS)
+		fail("locked lookup failed", key->len);
+	return waited;
+}
+
+void lock_test(void)
+{
+	static unsigned char addr[ADDR_LEN + 1];
+	static uint64_t small = 42;
+	struct gsh_buffdesc key, val;
+
+	/* Keys as long as an IP name cache address are copied */
+	ht = make_table(1, ADDR_LEN);
+
+	memset(addr, 'a', sizeof(addr));
+	key.addr = addr;
+	key.len = ADDR_LEN;
+	val = key;
+	if (HashTable_Set(ht, &key, &val) != HASHTABLE_SUCCESS)
+		fail("insert failed", key.len);
+	if (waits_for_lock(&key))
+		fail("lookup of a copied key took the lock", key.len);
+
+	key.len = ADDR_LEN + 1;
+	if (HashTable_Set(ht, &key, &val) != HASHTABLE_SUCCESS)
+		fail("insert failed", key.len);
+	if (!waits_for_lock(&key))
+		fail("lookup of an uncopied key skipped the lock", key.len);
+
+	hashtable_destroy(ht, free_entry);
+
+	/* The default copies 16 bytes */
+	ht = make_table(1, 0);
+	key.addr = &small;
+	key.len = sizeof(small);
+	val = key;
+	if (HashTable_Set(ht, &key, &val) != HASHTABLE_SUCCESS)
+		fail("insert failed", key.len);
+	if (waits_for_lock(&key))
+		fail("lookup of a short key took the lock", key.len);
+
+	key.addr = addr;
+	key.len = HASH_OA_INLINE_KEY + 1;
+	if (HashTable_Set(ht, &key, &val) != HASHTABLE_SUCCESS)
+		fail("insert failed", key.len);
+	if (!waits_for_lock(&key))
+		fail("lookup of a long key skipped the lock", key.len);
+
+	printf("lock: lookups of copied keys do not wait for the lock\n");
+	hashtable_destroy(ht, free_entry);
+}
+
+void copy_test(void)
+{
+	static uint64_t stored, wanted;
+	struct gsh_buffdesc key, val;
+
+	/* A lockless lookup must only look at the slot's copy of the
+	 * key, since the stored buffer may be freed by a delete at any
+	 * moment.  Scribbling on the buffer shows whether it is read. */
+	ht = make_table(1, 0);
+
+	stored = wanted = 7;
+	key.addr = &stored;
+	key.len = sizeof(stored);
+	val = key;
+	if (HashTable_Set(ht, &key, &val) != HASHTABLE_SUCCESS)
+		fail("insert failed", stored);
+
+	stored = ~0ULL;
+	key.addr = &wanted;
+	if (HashTable_Get(ht, &key, &val) != HASHTABLE_SUCCESS)
+		fail("lookup read the stored key buffer", wanted);
+
+	printf("copy: lookups compare against the slot's copy\n");
+	hashtable_destroy(ht, free_entry);
+}
+
+int main(int argc, char **argv)
+{
+	grow_test();
+	churn_test();
+	lock_test();
+	copy_test();
+	printf("PASS\n");
+	return 0;
+}
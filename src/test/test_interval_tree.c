@@ -0,0 +1,227 @@
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @file test_interval_tree.c
+ * @brief Check the interval tree against a brute force search
+ *
+ * usage: test_interval_tree [rounds] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include "gsh_interval_tree.h"
+
+#define NODES 512
+#define SPACE 4096
+
+struct range {
+	struct gsh_itree_node node;
+	bool in_tree;
+	bool seen;
+};
+
+static struct range ranges[NODES];
+static struct gsh_itree tree;
+static int errors;
+
+#define CHECK(cond, ...)				\
+	do {						\
+		if (!(cond)) {				\
+			printf(__VA_ARGS__);		\
+			printf("\n");			\
+			errors++;			\
+		}					\
+	} while (0)
+
+/* Check order, parents, heights, balance and max_last; return height */
+static int check_subtree(struct gsh_itree_node *node,
+			 struct gsh_itree_node *parent, int *count)
+{
+	int hl, hr;
+	uint64_t max;
+
+	if (node == NULL)
+		return 0;
+
+	(*count)++;
+	CHECK(node->parent == parent, "bad parent at %" PRIu64, node->start);
+	if (node->left != NULL)
+		CHECK(node->left->start <= node->start,
+		      "bad order at %" PRIu64, node->start);
+	if (node->right != NULL)
+		CHECK(node->right->start >= node->start,
+		      "bad order at %" PRIu64, node->start);
+
+	hl = check_subtree(node->left, node, count);
+	hr = check_subtree(node->right, node, count);
+
+	CHECK(node->height == (hl > hr ? hl : hr) + 1,
+	      "bad height at %" PRIu64, node->start);
+	CHECK(hl - hr <= 1 && hr - hl <= 1,
+	      "unbalanced at %" PRIu64, node->start);
+
+	max = node->last;
+	if (node->left != NULL && node->left->max_last > max)
+		max = node->left->max_last;
+	if (node->right != NULL && node->right->max_last > max)
+		max = node->right->max_last;
+	CHECK(node->max_last == max, "bad max_last at %" PRIu64, node->start);
+
+	return node->height;
+}
+
+static void check_tree(void)
+{
+	int count = 0, expected = 0, i;
+
+	check_subtree(tree.root, NULL, &count);
+
+	for (i = 0; i < NODES; i++)
+		if (ranges[i].in_tree)
+			expected++;
+
+	CHECK(count == expected, "tree has %d nodes, expected %d",
+	      count, expected);
+}
+
+static bool overlaps(struct range *r, uint64_t start, uint64_t last)
+{
+	return r->node.start <= last && r->node.last >= start;
+}
+
+/* Find every overlap once, in order, optionally removing some */
+static void check_query(uint64_t start, uint64_t last, bool remove)
+{
+	struct gsh_itree_node *node, *next;
+	struct range *r;
+	uint64_t prev = 0;
+	int i;
+
+	for (i = 0; i < NODES; i++)
+		ranges[i].seen = false;
+
+	gsh_itree_for_each_safe(node, next, &tree, start, last) {
+		r = (struct range *)((char *)node -
+				     offsetof(struct range, node));
+		CHECK(overlaps(r, start, last),
+		      "[%" PRIu64 ", %" PRIu64 "] doesn't overlap [%"
+		      PRIu64 ", %" PRIu64 "]",
+		      node->start, node->last, start, last);
+		CHECK(!r->seen, "[%" PRIu64 ", %" PRIu64 "] seen twice",
+		      node->start, node->last);
+		CHECK(node->start >= prev, "out of order at %" PRIu64,
+		      node->start);
+		prev = node->start;
+		r->seen = true;
+
+		if (remove && (random() & 1)) {
+			gsh_itree_remove(&tree, node);
+			CHECK(!gsh_itree_linked(node), "still linked");
+			r->in_tree = false;
+		}
+	}
+
+	for (i = 0; i < NODES; i++) {
+		r = &ranges[i];
+		if (r->in_tree && !r->seen)
+			CHECK(!overlaps(r, start, last),
+			      "missed [%" PRIu64 ", %" PRIu64 "] in [%"
+			      PRIu64 ", %" PRIu64 "]",
+			      r->node.start, r->node.last, start, last);
+	}
+}
+
+static uint64_t pick(void)
+{
+	/* Sometimes hit the ends of the range space */
+	switch (random() % 16) {
+	case 0:
+		return 0;
+	case 1:
+		return UINT64_MAX;
+	default:
+		return random() % SPACE;
+	}
+}
+
+static void random_range(uint64_t *start, uint64_t *last)
+{
+	uint64_t a = pick(), b;
+
+	b = random() % 4 == 0 ? a : pick();
+	*start = a < b ? a : b;
+	*last = a < b ? b : a;
+}
+
+int main(int argc, char **argv)
+{
+	int rounds = argc > 1 ? atoi(argv[1]) : 200000;
+	unsigned int seed = argc > 2 ? atoi(argv[2]) : 1;
+	uint64_t start, last;
+	struct range *r;
+	int i;
+
+	srandom(seed);
+	gsh_itree_init(&tree);
+
+	for (i = 0; i < rounds && errors == 0; i++) {
+		r = &ranges[random() % NODES];
+
+		switch (random() % 4) {
+		case 0:
+		case 1:
+			if (r->in_tree) {
+				gsh_itree_remove(&tree, &r->node);
+				r->in_tree = false;
+			} else {
+				random_range(&r->node.start, &r->node.last);
+				gsh_itree_insert(&tree, &r->node);
+				r->in_tree = true;
+			}
+			break;
+		case 2:
+			random_range(&start, &last);
+			check_query(start, last, false);
+			break;
+		case 3:
+			random_range(&start, &last);
+			check_query(start, last, random() % 8 == 0);
+			break;
+		}
+
+		if (i % 64 == 0)
+			check_tree();
+	}
+
+	check_tree();
+
+	if (errors != 0) {
+		printf("FAILED after %d rounds with seed %u\n", i, seed);
+		return 1;
+	}
+
+	printf("OK, %d rounds\n", rounds);
+	return 0;
+}
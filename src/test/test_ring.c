@@ -0,0 +1,118 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ * ---------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "gsh_ring.h"
+
+#define NPRODUCERS 4
+#define NCONSUMERS 4
+#define PER_PRODUCER 100000
+
+static struct gsh_ring ring;
+static uint64_t consumed;
+static uint64_t checksum;
+
+static void *producer(void *arg)
+{
+	uintptr_t base = (uintptr_t) arg * PER_PRODUCER;
+	uintptr_t ix;
+
+	for (ix = 1; ix <= PER_PRODUCER; ++ix)
+		while (!gsh_ring_push(&ring, (void *)(base + ix)))
+			;
+	return NULL;
+}
+
+static void *consumer(void *arg)
+{
+	uint64_t sum = 0;
+	void *data;
+
+	while (atomic_fetch_uint64_t(&consumed) <
+	       (uint64_t) NPRODUCERS * PER_PRODUCER) {
+		data = gsh_ring_pop(&ring);
+		if (data == NULL)
+			continue;
+		sum += (uintptr_t) data;
+		atomic_inc_uint64_t(&consumed);
+	}
+	atomic_add_uint64_t(&checksum, sum);
+	return NULL;
+}
+
+void basic_test(void)
+{
+	uintptr_t ix;
+
+	gsh_ring_init(&ring, 5);	/* rounded up to 8 */
+
+	for (ix = 1; ix <= 8; ++ix)
+		if (!gsh_ring_push(&ring, (void *)ix)) {
+			printf("push %lu failed\n", (unsigned long)ix);
+			exit(1);
+		}
+	if (gsh_ring_push(&ring, (void *)ix)) {
+		printf("push into full ring succeeded\n");
+		exit(1);
+	}
+	printf("depth %lu\n", (unsigned long)gsh_ring_depth(&ring));
+	for (ix = 1; ix <= 8; ++ix)
+		if (gsh_ring_pop(&ring) != (void *)ix) {
+			printf("pop %lu out of order\n", (unsigned long)ix);
+			exit(1);
+		}
+	if (gsh_ring_pop(&ring) != NULL) {
+		printf("pop from empty ring succeeded\n");
+		exit(1);
+	}
+	gsh_ring_destroy(&ring);
+}
+
+void threaded_test(void)
+{
+	pthread_t thr[NPRODUCERS + NCONSUMERS];
+	uint64_t expect = 0;
+	uintptr_t ix;
+
+	gsh_ring_init(&ring, 1024);
+
+	for (ix = 0; ix < NCONSUMERS; ++ix)
+		pthread_create(&thr[NPRODUCERS + ix], NULL, consumer, NULL);
+	for (ix = 0; ix < NPRODUCERS; ++ix)
+		pthread_create(&thr[ix], NULL, producer, (void *)ix);
+	for (ix = 0; ix < NPRODUCERS + NCONSUMERS; ++ix)
+		pthread_join(thr[ix], NULL);
+
+	for (ix = 1; ix <= (uintptr_t) NPRODUCERS * PER_PRODUCER; ++ix)
+		expect += ix;
+
+	printf("consumed %lu checksum %s\n", (unsigned long)consumed,
+	       checksum == expect ? "ok" : "BAD");
+	if (checksum != expect)
+		exit(1);
+	gsh_ring_destroy(&ring);
+}
+
+int main(int argc, char *argv[])
+{
+	basic_test();
+	threaded_test();
+	return 0;
+}
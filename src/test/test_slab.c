@@ -0,0 +1,200 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ * ---------------------------------------
+ */
+
+/*
+ * Slab pool substrate test.
+ *
+ * Creates pools on several threads while another walks them with
+ * pool_slab_foreach, which must never see a pool without its name or
+ * object size.  Then has threads allocate objects, checking they come
+ * back zeroed and distinct, and hand them to the next thread to free,
+ * so objects travel between threads' magazines through the depot.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "abstract_atomic.h"
+#include "gsh_slab.h"
+
+#define NCREATORS 4
+#define PER_CREATOR 16
+#define ROUNDS 200
+#define NAME_LEN 65536
+#define NTHREADS 4
+#define PER_THREAD 10000
+#define OBJECT_SIZE 72
+
+static pool_t *pools[NCREATORS][PER_CREATOR];
+static uint32_t creating;
+static uint64_t half_built;
+static uint64_t walked;
+static pthread_barrier_t start;
+
+static pool_t *pool;
+static void *handoff[NTHREADS][PER_THREAD];
+static pthread_barrier_t barrier;
+
+static void check_pool(pool_t *p, void *arg)
+{
+	struct pool_slab_stats stats;
+
+	pool_slab_stats(p, &stats);
+	if (p->name == NULL || p->object_size == 0 || stats.object_size == 0)
+		atomic_inc_uint64_t(&half_built);
+	atomic_inc_uint64_t(&walked);
+}
+
+static void *walker(void *arg)
+{
+	pthread_barrier_wait(&start);
+	while (atomic_fetch_uint32_t(&creating) != 0)
+		pool_slab_foreach(check_pool, NULL);
+	return NULL;
+}
+
+static void *creator(void *arg)
+{
+	uintptr_t id = (uintptr_t) arg;
+	char *name = malloc(NAME_LEN);
+	int round, i;
+
+	/* A long name keeps pool_init busy copying it, widening the
+	 * window a walker would see an unnamed pool in */
+	memset(name, 'a' + id, NAME_LEN - 1);
+	name[NAME_LEN - 1] = '\0';
+
+	pthread_barrier_wait(&start);
+
+	for (round = 0; round < ROUNDS; round++) {
+		for (i = 0; i < PER_CREATOR; i++) {
+			pools[id][i] = pool_init(name, OBJECT_SIZE + i,
+						 pool_slab_substrate, NULL,
+						 NULL, NULL);
+			if (pools[id][i] == NULL) {
+				printf("pool_init failed\n");
+				exit(1);
+			}
+		}
+		/* Let the walker at them however few CPUs there are */
+		sched_yield();
+		for (i = 0; i < PER_CREATOR; i++)
+			pool_destroy(pools[id][i]);
+	}
+	free(name);
+	atomic_dec_uint32_t(&creating);
+	return NULL;
+}
+
+void publish_test(void)
+{
+	pthread_t threads[NCREATORS + 1];
+	uintptr_t id;
+	int i;
+
+	creating = NCREATORS;
+	pthread_barrier_init(&start, NULL, NCREATORS + 1);
+	pthread_create(&threads[NCREATORS], NULL, walker, NULL);
+	for (id = 0; id < NCREATORS; id++)
+		pthread_create(&threads[id], NULL, creator, (void *)id);
+	for (i = 0; i <= NCREATORS; i++)
+		pthread_join(threads[i], NULL);
+
+	pthread_barrier_destroy(&start);
+
+	if (half_built != 0) {
+		printf("saw %lu half built pools out of %lu\n",
+		       (unsigned long)half_built, (unsigned long)walked);
+		exit(1);
+	}
+
+	printf("publish: walked %lu pools, none half built\n",
+	       (unsigned long)walked);
+}
+
+static void *worker(void *arg)
+{
+	uintptr_t id = (uintptr_t) arg;
+	uintptr_t next = (id + 1) % NTHREADS;
+	static const char zero[OBJECT_SIZE];
+	char *object;
+	int i;
+
+	for (i = 0; i < PER_THREAD; i++) {
+		object = pool_alloc(pool, NULL);
+		if (object == NULL || memcmp(object, zero, OBJECT_SIZE) != 0) {
+			printf("object %p not zeroed\n", object);
+			exit(1);
+		}
+		memset(object, id + 1, OBJECT_SIZE);
+		handoff[id][i] = object;
+	}
+
+	pthread_barrier_wait(&barrier);
+
+	/* Free the next thread's objects, checking nobody else got them */
+	for (i = 0; i < PER_THREAD; i++) {
+		object = handoff[next][i];
+		if (object[0] != (char)(next + 1) ||
+		    object[OBJECT_SIZE - 1] != (char)(next + 1)) {
+			printf("object %p handed out twice\n", object);
+			exit(1);
+		}
+		pool_free(pool, object);
+	}
+	return NULL;
+}
+
+void alloc_test(void)
+{
+	pthread_t threads[NTHREADS];
+	struct pool_slab_stats stats;
+	uintptr_t id;
+
+	pool = pool_init("test objects", OBJECT_SIZE, pool_slab_substrate,
+			 NULL, NULL, NULL);
+	pthread_barrier_init(&barrier, NULL, NTHREADS);
+
+	for (id = 0; id < NTHREADS; id++)
+		pthread_create(&threads[id], NULL, worker, (void *)id);
+	for (id = 0; id < NTHREADS; id++)
+		pthread_join(threads[id], NULL);
+
+	/* Exiting threads folded their counts back into the pool */
+	pool_slab_stats(pool, &stats);
+	if (stats.live != 0) {
+		printf("%lu objects still live\n", (unsigned long)stats.live);
+		exit(1);
+	}
+	printf("alloc: %lu slabs, %lu hits, %lu misses\n",
+	       (unsigned long)stats.slabs, (unsigned long)stats.hits,
+	       (unsigned long)stats.misses);
+
+	pthread_barrier_destroy(&barrier);
+	pool_destroy(pool);
+}
+
+int main(int argc, char **argv)
+{
+	publish_test();
+	alloc_test();
+	printf("PASS\n");
+	return 0;
+}